@@ -37,7 +37,8 @@
 #define ARM64_WORKAROUND_CAVIUM_27456		11
 #define ARM64_HAS_VIRT_HOST_EXTN		12
 #define ARM64_HAS_32BIT_EL0			13
-#define ARM64_NCAPS				14
+#define ARM64_HAS_NT_LARGE_COPY			14
+#define ARM64_NCAPS				15
 
 #ifndef __ASSEMBLY__
 
@@ -110,7 +110,7 @@ static inline u64 __raw_readq_no_log(const volatile void __iomem *addr)
 	int _ret; \
 	volatile void __iomem *_a = (a); \
 	void *_addr = (void __force *)(_a); \
-	_ret = uncached_logk(LOGK_WRITEL, _addr); \
+	_ret = uncached_logk_mmio(LOGK_WRITEL, _addr); \
 	ETB_WAYPOINT; \
 	__raw_write##_t##_no_log((v), _a); \
 	if (_ret) \
@@ -127,7 +127,7 @@ static inline u64 __raw_readq_no_log(const volatile void __iomem *addr)
 	const volatile void __iomem *_a = (const volatile void __iomem *)(a); \
 	void *_addr = (void __force *)(_a); \
 	int _ret; \
-	_ret = uncached_logk(LOGK_READL, _addr); \
+	_ret = uncached_logk_mmio(LOGK_READL, _addr); \
 	ETB_WAYPOINT; \
 	__a = __raw_read##_l##_no_log(_a); \
 	if (_ret) \
@@ -650,6 +650,16 @@ static bool has_no_hw_prefetch(const struct arm64_cpu_capabilities *entry)
 	return MIDR_IS_CPU_MODEL_RANGE(midr, MIDR_THUNDERX, rv_min, rv_max);
 }
 
+static bool has_nt_large_copy(const struct arm64_cpu_capabilities *entry)
+{
+	u32 midr = read_cpuid_id();
+	u32 rv_max = MIDR_VARIANT_MASK | MIDR_REVISION_MASK;
+
+	/* Kryo 2xx gold and silver */
+	return MIDR_IS_CPU_MODEL_RANGE(midr, MIDR_KRYO2XX_GOLD, 0, rv_max) ||
+	       MIDR_IS_CPU_MODEL_RANGE(midr, MIDR_KRYO2XX_SILVER, 0, rv_max);
+}
+
 static bool runs_at_el2(const struct arm64_cpu_capabilities *entry)
 {
 	return is_kernel_in_hyp_mode();
@@ -690,6 +700,11 @@ static const struct arm64_cpu_capabilities arm64_features[] = {
 		.capability = ARM64_HAS_NO_HW_PREFETCH,
 		.matches = has_no_hw_prefetch,
 	},
+	{
+		.desc = "Non-temporal stores for large memcpy",
+		.capability = ARM64_HAS_NT_LARGE_COPY,
+		.matches = has_nt_large_copy,
+	},
 #ifdef CONFIG_ARM64_UAO
 	{
 		.desc = "User Access Override",
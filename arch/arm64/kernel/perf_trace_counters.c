@@ -12,6 +12,9 @@
 #include <linux/uaccess.h>
 #include <linux/debugfs.h>
 #include <linux/cpu.h>
+#include <linux/cred.h>
+#include <linux/seq_file.h>
+#include <linux/slab.h>
 #include <linux/tracepoint.h>
 #include <trace/events/sched.h>
 #define CREATE_TRACE_POINTS
@@ -25,6 +28,27 @@ DEFINE_PER_CPU(u32[NUM_L1_CTRS], previous_l1_cnts);
 DEFINE_PER_CPU(u32, old_pid);
 DEFINE_PER_CPU(u32, hotplug_flag);
 
+/*
+ * Per-uid totals of the cycle counter and of whatever events perf has
+ * programmed into the L1 counters, charged to the outgoing task at each
+ * switch. Each cpu only updates its own table, so no locking is needed on
+ * the switch path; readers merge the tables and accept torn snapshots.
+ */
+#define TRACECTR_UID_SLOTS	64
+
+struct tracectr_uid_stat {
+	uid_t uid;
+	u32 used;
+	u64 cycles;
+	u64 cnts[NUM_L1_CTRS];
+};
+
+static DEFINE_PER_CPU(struct tracectr_uid_stat[TRACECTR_UID_SLOTS],
+		      uid_stats);
+static DEFINE_PER_CPU(u32, uid_stats_dropped);
+static DEFINE_PER_CPU(u32, uid_prev_ccnt);
+static DEFINE_PER_CPU(u32[NUM_L1_CTRS], uid_prev_cnts);
+
 static int tracectr_cpu_hotplug_notifier(struct notifier_block *self,
 					 unsigned long action, void *hcpu)
 {
@@ -60,6 +84,58 @@ static void setup_prev_cnts(u32 cpu, u32 cnten_val)
 	}
 }
 
+static struct tracectr_uid_stat *tracectr_uid_slot(u32 cpu, uid_t uid)
+{
+	struct tracectr_uid_stat *stats = per_cpu(uid_stats, cpu);
+	int i, slot;
+
+	for (i = 0; i < TRACECTR_UID_SLOTS; i++) {
+		slot = (uid + i) % TRACECTR_UID_SLOTS;
+		if (!stats[slot].used) {
+			stats[slot].uid = uid;
+			stats[slot].used = 1;
+			return &stats[slot];
+		}
+		if (stats[slot].uid == uid)
+			return &stats[slot];
+	}
+
+	return NULL;
+}
+
+static void tracectr_account_uid(u32 cpu, struct task_struct *prev,
+				 u32 cnten_val, bool reset)
+{
+	struct tracectr_uid_stat *stat = NULL;
+	u32 val;
+	int i;
+
+	if (!reset) {
+		stat = tracectr_uid_slot(cpu,
+				from_kuid(&init_user_ns, task_uid(prev)));
+		if (!stat)
+			per_cpu(uid_stats_dropped, cpu)++;
+	}
+
+	if (cnten_val & CC) {
+		asm volatile("mrs %0, pmccntr_el0" : "=r" (val));
+		if (stat)
+			stat->cycles += val - per_cpu(uid_prev_ccnt, cpu);
+		per_cpu(uid_prev_ccnt, cpu) = val;
+	}
+
+	for (i = 0; i < NUM_L1_CTRS; i++) {
+		if (!(cnten_val & (1 << i)))
+			continue;
+		asm volatile("msr pmselr_el0, %0" : : "r" (i));
+		isb();
+		asm volatile("mrs %0, pmxevcntr_el0" : "=r" (val));
+		if (stat)
+			stat->cnts[i] += val - per_cpu(uid_prev_cnts[i], cpu);
+		per_cpu(uid_prev_cnts[i], cpu) = val;
+	}
+}
+
 void tracectr_notifier(void *ignore, bool preempt,
 			struct task_struct *prev, struct task_struct *next)
 {
@@ -79,9 +155,11 @@ void tracectr_notifier(void *ignore, bool preempt,
 		if (per_cpu(hotplug_flag, cpu) == 1) {
 			per_cpu(hotplug_flag, cpu) = 0;
 			setup_prev_cnts(cpu, cnten_val);
+			tracectr_account_uid(cpu, prev, cnten_val, true);
 		} else {
 			trace_sched_switch_with_ctrs(per_cpu(old_pid, cpu),
 						     current_pid);
+			tracectr_account_uid(cpu, prev, cnten_val, false);
 		}
 
 		/* Enable all the counters that were disabled */
@@ -150,6 +228,78 @@ static const struct file_operations fops_perftp = {
 	.llseek =	default_llseek,
 };
 
+static int tracectr_uid_stats_show(struct seq_file *m, void *unused)
+{
+	struct tracectr_uid_stat *merged, *stat;
+	int nr = 0, cpu, i, j, k;
+	u32 dropped = 0;
+
+	merged = kcalloc(TRACECTR_UID_SLOTS * num_possible_cpus(),
+			 sizeof(*merged), GFP_KERNEL);
+	if (!merged)
+		return -ENOMEM;
+
+	for_each_possible_cpu(cpu) {
+		dropped += per_cpu(uid_stats_dropped, cpu);
+		for (i = 0; i < TRACECTR_UID_SLOTS; i++) {
+			stat = &per_cpu(uid_stats, cpu)[i];
+			if (!stat->used)
+				continue;
+			for (j = 0; j < nr; j++)
+				if (merged[j].uid == stat->uid)
+					break;
+			if (j == nr) {
+				merged[nr].uid = stat->uid;
+				nr++;
+			}
+			merged[j].cycles += stat->cycles;
+			for (k = 0; k < NUM_L1_CTRS; k++)
+				merged[j].cnts[k] += stat->cnts[k];
+		}
+	}
+
+	seq_puts(m, "uid cycles ctr0 ctr1 ctr2 ctr3 ctr4 ctr5\n");
+	for (j = 0; j < nr; j++) {
+		seq_printf(m, "%u %llu", merged[j].uid, merged[j].cycles);
+		for (i = 0; i < NUM_L1_CTRS; i++)
+			seq_printf(m, " %llu", merged[j].cnts[i]);
+		seq_putc(m, '\n');
+	}
+	if (dropped)
+		seq_printf(m, "dropped %u\n", dropped);
+
+	kfree(merged);
+	return 0;
+}
+
+static int tracectr_uid_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, tracectr_uid_stats_show, NULL);
+}
+
+static ssize_t tracectr_uid_stats_write(struct file *file,
+		const char __user *user_buf, size_t count, loff_t *ppos)
+{
+	int cpu;
+
+	/* any write clears the totals */
+	for_each_possible_cpu(cpu) {
+		memset(per_cpu(uid_stats, cpu), 0,
+		       sizeof(per_cpu(uid_stats, cpu)));
+		per_cpu(uid_stats_dropped, cpu) = 0;
+	}
+
+	return count;
+}
+
+static const struct file_operations fops_uid_stats = {
+	.open =		tracectr_uid_stats_open,
+	.read =		seq_read,
+	.write =	tracectr_uid_stats_write,
+	.llseek =	seq_lseek,
+	.release =	single_release,
+};
+
 int __init init_tracecounters(void)
 {
 	struct dentry *dir;
@@ -166,6 +316,7 @@ int __init init_tracecounters(void)
 		debugfs_remove(dir);
 		return -ENOMEM;
 	}
+	debugfs_create_file("uid_stats", 0660, dir, NULL, &fops_uid_stats);
 	for_each_possible_cpu(cpu)
 		per_cpu(old_pid, cpu) = -1;
 	register_cpu_notifier(&tracectr_cpu_hotplug_notifier_block);
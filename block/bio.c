@@ -1787,6 +1787,7 @@ void bio_endio(struct bio *bio)
 		} else {
 			if (bio->bi_end_io) {
 				blk_update_perf_stats(bio);
+				iotop_bio_done(bio);
 				bio->bi_end_io(bio);
 			}
 			bio = NULL;
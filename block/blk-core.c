@@ -2638,6 +2638,8 @@ blk_qc_t submit_bio(int rw, struct bio *bio)
 	}
 
 	set_submit_info(bio, count);
+	if (count)
+		iotop_bio_submit(bio);
 	return generic_make_request(bio);
 }
 EXPORT_SYMBOL(submit_bio);
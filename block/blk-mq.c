@@ -249,7 +249,10 @@ struct request *blk_mq_alloc_request(struct request_queue *q, int rw, gfp_t gfp,
 
 	rq = __blk_mq_alloc_request(&alloc_data, rw);
 	if (!rq && (gfp & __GFP_DIRECT_RECLAIM)) {
-		__blk_mq_run_hw_queue(hctx);
+		if (hctx->flags & BLK_MQ_F_BLOCKING)
+			blk_mq_run_hw_queue(hctx, true);
+		else
+			__blk_mq_run_hw_queue(hctx);
 		blk_mq_put_ctx(ctx);
 
 		ctx = blk_mq_get_ctx(q);
@@ -864,7 +867,11 @@ void blk_mq_run_hw_queue(struct blk_mq_hw_ctx *hctx, bool async)
 	    !blk_mq_hw_queue_mapped(hctx)))
 		return;
 
-	if (!async) {
+	/*
+	 * ->queue_rq() of a BLK_MQ_F_BLOCKING queue may sleep, so never run
+	 * it from here with preemption disabled.
+	 */
+	if (!async && !(hctx->flags & BLK_MQ_F_BLOCKING)) {
 		int cpu = get_cpu();
 		if (cpumask_test_cpu(cpu, hctx->cpumask)) {
 			__blk_mq_run_hw_queue(hctx);
@@ -1182,7 +1189,10 @@ static struct request *blk_mq_map_request(struct request_queue *q,
 			hctx);
 	rq = __blk_mq_alloc_request(&alloc_data, rw);
 	if (unlikely(!rq)) {
-		__blk_mq_run_hw_queue(hctx);
+		if (hctx->flags & BLK_MQ_F_BLOCKING)
+			blk_mq_run_hw_queue(hctx, true);
+		else
+			__blk_mq_run_hw_queue(hctx);
 		blk_mq_put_ctx(ctx);
 		trace_block_sleeprq(q, bio, rw);
 
@@ -1395,6 +1405,21 @@ static blk_qc_t blk_sq_make_request(struct request_queue *q, struct bio *bio)
 		return cookie;
 	}
 
+	/*
+	 * A blocking driver cannot be run from under the software queue
+	 * context, so issue SYNC requests to it directly once the context
+	 * is dropped instead of bouncing them through kblockd.
+	 */
+	if (is_sync && (data.hctx->flags & BLK_MQ_F_BLOCKING)) {
+		blk_mq_bio_to_request(rq, bio);
+		blk_mq_put_ctx(data.ctx);
+
+		if (test_bit(BLK_MQ_S_STOPPED, &data.hctx->state) ||
+		    blk_mq_direct_issue_request(rq, &cookie) != 0)
+			blk_mq_insert_request(rq, false, true, true);
+		return cookie;
+	}
+
 	if (!blk_mq_merge_queue_io(data.hctx, data.ctx, rq, bio)) {
 		/*
 		 * For a SYNC request, send it to the hardware immediately. For
@@ -17,6 +17,7 @@
 #include <linux/module.h>
 #include <linux/init.h>
 #include <linux/slab.h>
+#include <linux/sched.h>
 #include <linux/state_notifier.h>
 
 #define MAPLE_IOSCHED_PATCHLEVEL	(8)
@@ -31,21 +32,30 @@ static const int async_write_expire = 450;	/* ditto for write async, these limit
 static const int fifo_batch = 16;		/* # of sequential requests treated as one by the above parameters. */
 static const int writes_starved = 4;		/* max times reads can starve a write */
 static const int sleep_latency_multiple = 10;	/* multple for expire time when device is asleep */
+static const int fg_reads = 1;			/* separate fifo for sync reads of foreground tasks */
+static const int fg_starved = 8;		/* max times foreground reads can starve other requests */
+
+/* Requests sitting in the foreground read fifo */
+#define RQ_MAPLE_FG(rq)		((rq)->elv.priv[0])
 
 /* Elevator data */
 struct maple_data {
 	/* Request queues */
 	struct list_head fifo_list[2][2];
+	struct list_head fg_list;
 
 	/* Attributes */
 	unsigned int batched;
 	unsigned int starved;
+	unsigned int fg_starved;
 
 	/* Settings */
 	int fifo_expire[2][2];
 	int fifo_batch;
 	int writes_starved;
   int sleep_latency_multiple;
+	int fg_reads;
+	int fg_starved_max;
 };
 
 static inline struct maple_data *
@@ -53,6 +63,23 @@ maple_get_data(struct request_queue *q) {
 	return q->elevator->elevator_data;
 }
 
+static inline struct list_head *
+maple_rq_list(struct maple_data *mdata, struct request *rq)
+{
+	if (RQ_MAPLE_FG(rq))
+		return &mdata->fg_list;
+	return &mdata->fifo_list[rq_is_sync(rq)][rq_data_dir(rq)];
+}
+
+static inline bool
+maple_others_pending(struct maple_data *mdata)
+{
+	return !list_empty(&mdata->fifo_list[SYNC][READ]) ||
+		!list_empty(&mdata->fifo_list[SYNC][WRITE]) ||
+		!list_empty(&mdata->fifo_list[ASYNC][READ]) ||
+		!list_empty(&mdata->fifo_list[ASYNC][WRITE]);
+}
+
 static void
 maple_merged_requests(struct request_queue *q, struct request *rq,
 		    struct request *next)
@@ -65,6 +92,7 @@ maple_merged_requests(struct request_queue *q, struct request *rq,
 		if (time_before(next->fifo_time, rq->fifo_time)) {
 			list_move(&rq->queuelist, &next->queuelist);
 			rq->fifo_time = next->fifo_time;
+			RQ_MAPLE_FG(rq) = RQ_MAPLE_FG(next);
 		}
 	}
 
@@ -78,6 +106,17 @@ maple_add_request(struct request_queue *q, struct request *rq)
 	struct maple_data *mdata = maple_get_data(q);
 	const int sync = rq_is_sync(rq);
 	const int dir = rq_data_dir(rq);
+	struct list_head *list;
+
+	/*
+	 * Sync reads of top-app and foreground tasks, typically app
+	 * launches, get their own fifo so they don't queue behind
+	 * background reads and writeback. Requests are added from the
+	 * submitting task, flushed plugs included.
+	 */
+	RQ_MAPLE_FG(rq) = (void *)(unsigned long)(mdata->fg_reads &&
+			sync && dir == READ && schedtune_task_foreground(current));
+	list = maple_rq_list(mdata, rq);
 
 	/*
 	 * Add request to the proper fifo list and set its
@@ -88,17 +127,16 @@ maple_add_request(struct request_queue *q, struct request *rq)
    	unsigned int fifo_expire_suspended = mdata->fifo_expire[sync][dir] * sleep_latency_multiple;
    	if (!state_suspended && mdata->fifo_expire[sync][dir]) {
         rq->fifo_time = jiffies + mdata->fifo_expire[sync][dir];
-   		list_add_tail(&rq->queuelist, &mdata->fifo_list[sync][dir]);
+   		list_add_tail(&rq->queuelist, list);
    	} else if (state_suspended && fifo_expire_suspended) {
         rq->fifo_time = jiffies + fifo_expire_suspended;
-   		list_add_tail(&rq->queuelist, &mdata->fifo_list[sync][dir]);
+   		list_add_tail(&rq->queuelist, list);
    	}
 }
 
 static struct request *
-maple_expired_request(struct maple_data *mdata, int sync, int data_dir)
+maple_expired_list_request(struct list_head *list)
 {
-	struct list_head *list = &mdata->fifo_list[sync][data_dir];
 	struct request *rq;
 
 	if (list_empty(list))
@@ -114,9 +152,16 @@ maple_expired_request(struct maple_data *mdata, int sync, int data_dir)
 	return NULL;
 }
 
+static inline struct request *
+maple_expired_request(struct maple_data *mdata, int sync, int data_dir)
+{
+	return maple_expired_list_request(&mdata->fifo_list[sync][data_dir]);
+}
+
 static struct request *
 maple_choose_expired_request(struct maple_data *mdata)
 {
+	struct request *rq_fg_read = maple_expired_list_request(&mdata->fg_list);
 	struct request *rq_sync_read = maple_expired_request(mdata, SYNC, READ);
 	struct request *rq_sync_write = maple_expired_request(mdata, SYNC, WRITE);
 	struct request *rq_async_read = maple_expired_request(mdata, ASYNC, READ);
@@ -125,6 +170,9 @@ maple_choose_expired_request(struct maple_data *mdata)
 	/* Reset (non-expired-)batch-counter */
 	mdata->batched = 0;
 
+	if (rq_fg_read)
+		return rq_fg_read;
+
 	/*
 	 * Check expired requests.
 	 * Asynchronous requests have priority over synchronous.
@@ -177,6 +225,10 @@ maple_choose_request(struct maple_data *mdata, int data_dir)
 	if (!list_empty(&sync[!data_dir]))
 		return rq_entry_fifo(sync[!data_dir].next);
 
+	/* Only foreground reads are left */
+	if (!list_empty(&mdata->fg_list))
+		return rq_entry_fifo(mdata->fg_list.next);
+
 	return NULL;
 }
 
@@ -190,6 +242,11 @@ maple_dispatch_request(struct maple_data *mdata, struct request *rq)
 	rq_fifo_clear(rq);
 	elv_dispatch_add_tail(rq->q, rq);
 
+	if (!RQ_MAPLE_FG(rq))
+		mdata->fg_starved = 0;
+	else if (maple_others_pending(mdata))
+		mdata->fg_starved++;
+
 	if (rq_data_dir(rq)) {
 		mdata->starved = 0;
 	} else {
@@ -213,6 +270,17 @@ maple_dispatch_requests(struct request_queue *q, int force)
 	if (mdata->batched >= mdata->fifo_batch)
 		rq = maple_choose_expired_request(mdata);
 
+	/*
+	 * Foreground reads go first, but only fg_starved of them in a row
+	 * while other requests wait, so background writes keep moving.
+	 */
+	if (!rq && !list_empty(&mdata->fg_list) &&
+			(mdata->fg_starved < mdata->fg_starved_max ||
+			 !maple_others_pending(mdata))) {
+		mdata->batched++;
+		rq = rq_entry_fifo(mdata->fg_list.next);
+	}
+
 	/* Retrieve request */
 	if (!rq) {
 		/* Treat writes fairly while suspended, otherwise allow them to be starved */
@@ -236,10 +304,8 @@ static struct request *
 maple_former_request(struct request_queue *q, struct request *rq)
 {
 	struct maple_data *mdata = maple_get_data(q);
-	const int sync = rq_is_sync(rq);
-	const int data_dir = rq_data_dir(rq);
 
-	if (rq->queuelist.prev == &mdata->fifo_list[sync][data_dir])
+	if (rq->queuelist.prev == maple_rq_list(mdata, rq))
 		return NULL;
 
 	/* Return former request */
@@ -250,10 +316,8 @@ static struct request *
 maple_latter_request(struct request_queue *q, struct request *rq)
 {
 	struct maple_data *mdata = maple_get_data(q);
-	const int sync = rq_is_sync(rq);
-	const int data_dir = rq_data_dir(rq);
 
-	if (rq->queuelist.next == &mdata->fifo_list[sync][data_dir])
+	if (rq->queuelist.next == maple_rq_list(mdata, rq))
 		return NULL;
 
 	/* Return latter request */
@@ -282,9 +346,12 @@ static int maple_init_queue(struct request_queue *q, struct elevator_type *e)
 	INIT_LIST_HEAD(&mdata->fifo_list[SYNC][WRITE]);
 	INIT_LIST_HEAD(&mdata->fifo_list[ASYNC][READ]);
 	INIT_LIST_HEAD(&mdata->fifo_list[ASYNC][WRITE]);
+	INIT_LIST_HEAD(&mdata->fg_list);
 
 	/* Initialize data */
 	mdata->batched = 0;
+	mdata->starved = 0;
+	mdata->fg_starved = 0;
 	mdata->fifo_expire[SYNC][READ] = sync_read_expire;
 	mdata->fifo_expire[SYNC][WRITE] = sync_write_expire;
 	mdata->fifo_expire[ASYNC][READ] = async_read_expire;
@@ -292,6 +359,8 @@ static int maple_init_queue(struct request_queue *q, struct elevator_type *e)
 	mdata->fifo_batch = fifo_batch;
 	mdata->writes_starved = writes_starved;
 	mdata->sleep_latency_multiple = sleep_latency_multiple;
+	mdata->fg_reads = fg_reads;
+	mdata->fg_starved_max = fg_starved;
 
 	spin_lock_irq(q->queue_lock);
 	q->elevator = eq;
@@ -343,6 +412,8 @@ SHOW_FUNCTION(maple_async_write_expire_show, mdata->fifo_expire[ASYNC][WRITE], 1
 SHOW_FUNCTION(maple_fifo_batch_show, mdata->fifo_batch, 0);
 SHOW_FUNCTION(maple_writes_starved_show, mdata->writes_starved, 0);
 SHOW_FUNCTION(maple_sleep_latency_multiple_show, mdata->sleep_latency_multiple, 0);
+SHOW_FUNCTION(maple_fg_reads_show, mdata->fg_reads, 0);
+SHOW_FUNCTION(maple_fg_starved_show, mdata->fg_starved_max, 0);
 #undef SHOW_FUNCTION
 
 #define STORE_FUNCTION(__FUNC, __PTR, MIN, MAX, __CONV)			\
@@ -368,6 +439,8 @@ STORE_FUNCTION(maple_async_write_expire_store, &mdata->fifo_expire[ASYNC][WRITE]
 STORE_FUNCTION(maple_fifo_batch_store, &mdata->fifo_batch, 1, INT_MAX, 0);
 STORE_FUNCTION(maple_writes_starved_store, &mdata->writes_starved, 1, INT_MAX, 0);
 STORE_FUNCTION(maple_sleep_latency_multiple_store, &mdata->sleep_latency_multiple, 1, INT_MAX, 0);
+STORE_FUNCTION(maple_fg_reads_store, &mdata->fg_reads, 0, 1, 0);
+STORE_FUNCTION(maple_fg_starved_store, &mdata->fg_starved_max, 1, INT_MAX, 0);
 #undef STORE_FUNCTION
 
 #define DD_ATTR(name) \
@@ -382,6 +455,8 @@ static struct elv_fs_entry maple_attrs[] = {
 	DD_ATTR(fifo_batch),
 	DD_ATTR(writes_starved),
   DD_ATTR(sleep_latency_multiple),
+	DD_ATTR(fg_reads),
+	DD_ATTR(fg_starved),
 	__ATTR_NULL
 };
 
@@ -147,6 +147,11 @@ module_param_named(debug_mask, binder_debug_mask, uint, S_IWUSR | S_IRUGO);
 static char *binder_devices_param = CONFIG_ANDROID_BINDER_DEVICES;
 module_param_named(devices, binder_devices_param, charp, S_IRUGO);
 
+/* transactions taking longer than this go to slow_transaction_log, 0=off */
+static uint32_t binder_slow_transaction_ms = 100;
+module_param_named(slow_transaction_ms, binder_slow_transaction_ms, uint,
+		   S_IWUSR | S_IRUGO);
+
 static DECLARE_WAIT_QUEUE_HEAD(binder_user_error_wait);
 static int binder_stop_on_user_error;
 
@@ -243,6 +248,31 @@ struct binder_transaction_log {
 static struct binder_transaction_log binder_transaction_log;
 static struct binder_transaction_log binder_transaction_log_failed;
 
+/*
+ * Transactions slower than binder_slow_transaction_ms. queue_us is the
+ * time from BC_TRANSACTION until a server thread picked it up, exec_us
+ * the time from then until BC_REPLY (0 for one-way transactions, which
+ * are logged at pickup and have no known sender).
+ */
+struct binder_slow_transaction_entry {
+	int debug_id;
+	int from_proc;
+	int from_thread;
+	int to_proc;
+	int to_thread;
+	unsigned int code;
+	unsigned int flags;
+	u32 queue_us;
+	u32 exec_us;
+	const char *context_name;
+};
+struct binder_slow_transaction_log {
+	atomic_t cur;
+	bool full;
+	struct binder_slow_transaction_entry entry[32];
+};
+static struct binder_slow_transaction_log binder_slow_transaction_log;
+
 static struct binder_transaction_log_entry *binder_transaction_log_add(
 	struct binder_transaction_log *log)
 {
@@ -649,6 +679,9 @@ struct binder_transaction {
 	struct binder_priority	saved_priority;
 	bool    set_priority_called;
 	kuid_t	sender_euid;
+	/* only set while binder_slow_transaction_ms is enabled */
+	ktime_t start_time;
+	ktime_t pickup_time;
 	/**
 	 * @lock:  protects @from, @to_proc, and @to_thread
 	 *
@@ -658,6 +691,40 @@ struct binder_transaction {
 	spinlock_t lock;
 };
 
+static void binder_slow_transaction_check(struct binder_transaction *t,
+					  int from_proc, int from_thread,
+					  int to_proc, int to_thread,
+					  const char *context_name, ktime_t now)
+{
+	struct binder_slow_transaction_log *log = &binder_slow_transaction_log;
+	struct binder_slow_transaction_entry *e;
+	unsigned int cur;
+	s64 queue_us, exec_us;
+
+	if (!ktime_to_ns(t->start_time) || !ktime_to_ns(t->pickup_time))
+		return;
+	if (ktime_ms_delta(now, t->start_time) < binder_slow_transaction_ms)
+		return;
+
+	queue_us = ktime_us_delta(t->pickup_time, t->start_time);
+	exec_us = ktime_us_delta(now, t->pickup_time);
+
+	cur = atomic_inc_return(&log->cur);
+	if (cur >= ARRAY_SIZE(log->entry))
+		log->full = 1;
+	e = &log->entry[cur % ARRAY_SIZE(log->entry)];
+	e->debug_id = t->debug_id;
+	e->from_proc = from_proc;
+	e->from_thread = from_thread;
+	e->to_proc = to_proc;
+	e->to_thread = to_thread;
+	e->code = t->code;
+	e->flags = t->flags;
+	e->queue_us = queue_us;
+	e->exec_us = exec_us;
+	e->context_name = context_name;
+}
+
 /**
  * binder_proc_lock() - Acquire outer lock for given binder_proc
  * @proc:         struct binder_proc to acquire
@@ -1207,7 +1274,7 @@ static void binder_transaction_priority(struct task_struct *task,
 	t->saved_priority.sched_policy = task->policy;
 	t->saved_priority.prio = task->normal_prio;
 
-	if (!inherit_rt && is_rt_policy(desired_prio.sched_policy)) {
+	if (!inherit_rt && is_rt_policy(t->priority.sched_policy)) {
 		desired_prio.prio = NICE_TO_PRIO(0);
 		desired_prio.sched_policy = SCHED_NORMAL;
 	} else {
@@ -2683,6 +2750,46 @@ static int binder_fixup_parent(struct binder_transaction *t,
 	return 0;
 }
 
+/**
+ * binder_enqueue_proc_transaction_ilocked() - queue a transaction to proc->todo
+ * @proc:	process to queue the transaction to
+ * @t:		transaction to queue
+ *
+ * Transactions from real-time callers are queued after any other real-time
+ * transactions already waiting, but ahead of everything else, so that they
+ * are picked up by the next free thread instead of waiting behind bulk
+ * work. Everything else is appended as usual.
+ */
+static void binder_enqueue_proc_transaction_ilocked(struct binder_proc *proc,
+						     struct binder_transaction *t)
+{
+	struct list_head *pos = &proc->todo;
+	struct binder_work *w;
+
+	assert_spin_locked(&proc->inner_lock);
+
+	if (!is_rt_policy(t->priority.sched_policy) ||
+	    (t->flags & TF_ONE_WAY)) {
+		binder_enqueue_work_ilocked(&t->work, &proc->todo);
+		return;
+	}
+
+	list_for_each_entry(w, &proc->todo, entry) {
+		struct binder_transaction *queued;
+
+		if (w->type != BINDER_WORK_TRANSACTION)
+			break;
+		queued = container_of(w, struct binder_transaction, work);
+		if (!is_rt_policy(queued->priority.sched_policy) ||
+		    (queued->flags & TF_ONE_WAY))
+			break;
+		pos = &w->entry;
+	}
+
+	BUG_ON(t->work.entry.next && !list_empty(&t->work.entry));
+	list_add(&t->work.entry, pos);
+}
+
 /**
  * binder_proc_transaction() - sends a transaction to a process and wakes it up
  * @t:		transaction to send
@@ -2746,7 +2853,10 @@ static bool binder_proc_transaction(struct binder_transaction *t,
 		BUG_ON(target_list != &node->async_todo);
 	}
 
-	binder_enqueue_work_ilocked(&t->work, target_list);
+	if (target_list == &proc->todo)
+		binder_enqueue_proc_transaction_ilocked(proc, t);
+	else
+		binder_enqueue_work_ilocked(&t->work, target_list);
 
 	if (wakeup)
 		binder_wakeup_thread_ilocked(proc, thread, !oneway /* sync */);
@@ -2998,6 +3108,8 @@ static void binder_transaction(struct binder_proc *proc,
 	binder_stats_created(BINDER_STAT_TRANSACTION_COMPLETE);
 
 	t->debug_id = t_debug_id;
+	if (binder_slow_transaction_ms)
+		t->start_time = ktime_get();
 
 	if (reply)
 		binder_debug(BINDER_DEBUG_TRANSACTION,
@@ -3264,6 +3376,10 @@ static void binder_transaction(struct binder_proc *proc,
 		binder_inner_proc_unlock(target_proc);
 		wake_up_interruptible_sync(&target_thread->wait);
 		binder_restore_priority(current, in_reply_to->saved_priority);
+		binder_slow_transaction_check(in_reply_to, target_proc->pid,
+					      target_thread->pid, proc->pid,
+					      thread->pid, context->name,
+					      ktime_get());
 		binder_free_transaction(in_reply_to);
 	} else if (!(t->flags & TF_ONE_WAY)) {
 		BUG_ON(t->buffer->async_transaction != 0);
@@ -4225,6 +4341,14 @@ retry:
 		if (t_from)
 			binder_thread_dec_tmpref(t_from);
 		t->buffer->allow_user_free = 1;
+		if (cmd == BR_TRANSACTION && ktime_to_ns(t->start_time)) {
+			t->pickup_time = ktime_get();
+			if (t->flags & TF_ONE_WAY)
+				binder_slow_transaction_check(t, 0, 0,
+						proc->pid, thread->pid,
+						proc->context->name,
+						t->pickup_time);
+		}
 		if (cmd == BR_TRANSACTION && !(t->flags & TF_ONE_WAY)) {
 			binder_inner_proc_lock(thread->proc);
 			t->to_parent = thread->transaction_stack;
@@ -4670,6 +4794,18 @@ static long binder_ioctl(struct file *filp, unsigned int cmd, unsigned long arg)
 		binder_inner_proc_unlock(proc);
 		break;
 	}
+	case BINDER_SET_PREALLOC_SIZE: {
+		__u32 size;
+
+		if (copy_from_user(&size, ubuf, sizeof(size))) {
+			ret = -EINVAL;
+			goto err;
+		}
+		ret = binder_alloc_set_prealloc(&proc->alloc, size);
+		if (ret)
+			goto err;
+		break;
+	}
 	case BINDER_SET_CONTEXT_MGR:
 		ret = binder_ioctl_set_ctx_mgr(filp);
 		if (ret)
@@ -5612,6 +5748,31 @@ static int binder_transaction_log_show(struct seq_file *m, void *unused)
 	return 0;
 }
 
+static int binder_slow_transaction_log_show(struct seq_file *m, void *unused)
+{
+	struct binder_slow_transaction_log *log = &binder_slow_transaction_log;
+	struct binder_slow_transaction_entry *e;
+	unsigned int count = atomic_read(&log->cur) + 1;
+	unsigned int cur;
+	int i;
+
+	cur = count < ARRAY_SIZE(log->entry) && !log->full ?
+		0 : count % ARRAY_SIZE(log->entry);
+	if (count > ARRAY_SIZE(log->entry) || log->full)
+		count = ARRAY_SIZE(log->entry);
+	for (i = 0; i < count; i++) {
+		e = &log->entry[cur++ % ARRAY_SIZE(log->entry)];
+		seq_printf(m,
+			   "%d: %s from %d:%d to %d:%d context %s code %u flags %x queue %uus exec %uus\n",
+			   e->debug_id,
+			   (e->flags & TF_ONE_WAY) ? "async" : "call ",
+			   e->from_proc, e->from_thread, e->to_proc,
+			   e->to_thread, e->context_name, e->code, e->flags,
+			   e->queue_us, e->exec_us);
+	}
+	return 0;
+}
+
 static const struct file_operations binder_fops = {
 	.owner = THIS_MODULE,
 	.poll = binder_poll,
@@ -5627,6 +5788,7 @@ BINDER_DEBUG_ENTRY(state);
 BINDER_DEBUG_ENTRY(stats);
 BINDER_DEBUG_ENTRY(transactions);
 BINDER_DEBUG_ENTRY(transaction_log);
+BINDER_DEBUG_ENTRY(slow_transaction_log);
 
 static int __init init_binder_device(const char *name)
 {
@@ -5665,6 +5827,12 @@ static int __init binder_init(void)
 
 	atomic_set(&binder_transaction_log.cur, ~0U);
 	atomic_set(&binder_transaction_log_failed.cur, ~0U);
+	atomic_set(&binder_slow_transaction_log.cur, ~0U);
+
+	ret = binder_alloc_shrinker_init();
+	if (ret)
+		return ret;
+
 	binder_deferred_workqueue = create_singlethread_workqueue("binder");
 	if (!binder_deferred_workqueue)
 		return -ENOMEM;
@@ -5700,6 +5868,11 @@ static int __init binder_init(void)
 				    binder_debugfs_dir_entry_root,
 				    &binder_transaction_log_failed,
 				    &binder_transaction_log_fops);
+		debugfs_create_file("slow_transaction_log",
+				    S_IRUGO,
+				    binder_debugfs_dir_entry_root,
+				    NULL,
+				    &binder_slow_transaction_log_fops);
 	}
 
 	/*
@@ -31,9 +31,15 @@
 #include "binder_trace.h"
 
 #define BINDER_MIN_ALLOC (1 * PAGE_SIZE)
+#define BINDER_PREALLOC_MAX (256 * 1024)
 
 static DEFINE_MUTEX(binder_alloc_mmap_lock);
 
+/* procs whose min_alloc prefix was grown beyond BINDER_MIN_ALLOC */
+static LIST_HEAD(binder_prealloc_list);
+static DEFINE_MUTEX(binder_prealloc_lock);
+static atomic_long_t binder_prealloc_pages = ATOMIC_LONG_INIT(0);
+
 enum {
 	BINDER_DEBUG_OPEN_CLOSE             = 1U << 1,
 	BINDER_DEBUG_BUFFER_ALLOC           = 1U << 2,
@@ -289,11 +295,11 @@ static int binder_update_page_range(struct binder_alloc *alloc, int allocate,
 				    struct vm_area_struct *vma)
 {
 	/*
-	 * For regular updates, move up start if needed since MIN_ALLOC pages
-	 * are always mapped
+	 * For regular updates, move up start if needed since the min_alloc
+	 * prefix is always mapped
 	 */
-	if (start - alloc->buffer < BINDER_MIN_ALLOC)
-		start = alloc->buffer + BINDER_MIN_ALLOC;
+	if (start - alloc->buffer < alloc->min_alloc)
+		start = alloc->buffer + alloc->min_alloc;
 
 	return __binder_update_page_range(alloc, allocate, start, end, vma);
 }
@@ -687,6 +693,7 @@ int binder_alloc_mmap_handler(struct binder_alloc *alloc,
 		failure_string = "alloc small buf";
 		goto err_alloc_small_buf_failed;
 	}
+	alloc->min_alloc = BINDER_MIN_ALLOC;
 	buffer->data = alloc->buffer;
 	list_add(&buffer->entry, &alloc->buffers);
 	buffer->free = 1;
@@ -715,6 +722,70 @@ err_already_mapped:
 	return ret;
 }
 
+/**
+ * binder_alloc_set_prealloc() - keep a prefix of the buffer space populated
+ * @alloc:	binder_alloc for this proc
+ * @size:	bytes at the start of the mapped space to keep backed by pages
+ *
+ * Pages of the prefix are allocated right away and are not released when
+ * the buffers using them are freed, so transactions that fit in it don't
+ * allocate and map pages under alloc->mutex. The prefix is capped at
+ * BINDER_PREALLOC_MAX and at the size of the mapping, and the binder
+ * shrinker drops it back to BINDER_MIN_ALLOC under memory pressure.
+ *
+ * Return:
+ *      0 = success
+ *      -ESRCH = address space not mapped
+ *      -EINVAL = @size is below the current prefix
+ *      -ENOMEM = failed to populate the prefix, it is left partially grown
+ */
+int binder_alloc_set_prealloc(struct binder_alloc *alloc, size_t size)
+{
+	void *page_addr;
+	int ret = 0;
+
+	mutex_lock(&alloc->mutex);
+	if (!alloc->vma) {
+		ret = -ESRCH;
+		goto out;
+	}
+
+	size = min_t(size_t, PAGE_ALIGN(size), BINDER_PREALLOC_MAX);
+	size = min_t(size_t, size, alloc->buffer_size);
+	if (size < alloc->min_alloc) {
+		ret = -EINVAL;
+		goto out;
+	}
+
+	while (alloc->min_alloc < size) {
+		page_addr = alloc->buffer + alloc->min_alloc;
+
+		/* pages of allocated buffers just become part of the prefix */
+		if (!alloc->pages[alloc->min_alloc / PAGE_SIZE]) {
+			ret = __binder_update_page_range(alloc, 1, page_addr,
+						page_addr + PAGE_SIZE, NULL);
+			if (ret)
+				break;
+		}
+		alloc->min_alloc += PAGE_SIZE;
+		atomic_long_inc(&binder_prealloc_pages);
+	}
+
+	if (alloc->min_alloc > BINDER_MIN_ALLOC) {
+		mutex_lock(&binder_prealloc_lock);
+		if (list_empty(&alloc->prealloc_entry))
+			list_add_tail(&alloc->prealloc_entry,
+				      &binder_prealloc_list);
+		mutex_unlock(&binder_prealloc_lock);
+	}
+
+	binder_alloc_debug(BINDER_DEBUG_BUFFER_ALLOC,
+		     "%d: prealloc %zd of %zd bytes\n",
+		      alloc->pid, alloc->min_alloc, size);
+out:
+	mutex_unlock(&alloc->mutex);
+	return ret;
+}
 
 void binder_alloc_deferred_release(struct binder_alloc *alloc)
 {
@@ -724,8 +795,16 @@ void binder_alloc_deferred_release(struct binder_alloc *alloc)
 
 	BUG_ON(alloc->vma);
 
+	mutex_lock(&binder_prealloc_lock);
+	list_del_init(&alloc->prealloc_entry);
+	mutex_unlock(&binder_prealloc_lock);
+
 	buffers = 0;
 	mutex_lock(&alloc->mutex);
+	if (alloc->min_alloc > BINDER_MIN_ALLOC)
+		atomic_long_sub((alloc->min_alloc - BINDER_MIN_ALLOC) /
+				PAGE_SIZE, &binder_prealloc_pages);
+	alloc->min_alloc = BINDER_MIN_ALLOC;
 	while ((n = rb_first(&alloc->allocated_buffers))) {
 		buffer = rb_entry(n, struct binder_buffer, rb_node);
 
@@ -850,5 +929,111 @@ void binder_alloc_init(struct binder_alloc *alloc)
 	alloc->pid = current->group_leader->pid;
 	mutex_init(&alloc->mutex);
 	INIT_LIST_HEAD(&alloc->buffers);
+	INIT_LIST_HEAD(&alloc->prealloc_entry);
+}
+
+/*
+ * Drop the prefix of @alloc back to BINDER_MIN_ALLOC. Only pages that lie
+ * entirely inside a free buffer are released, which are exactly the pages
+ * binder_free_buf_locked() would have released without the prefix; pages
+ * still backing allocated buffers go away when those buffers are freed.
+ * Called with alloc->mutex and the mmap_sem of the proc's mm held.
+ */
+static unsigned long binder_alloc_shrink_prealloc(struct binder_alloc *alloc,
+						  struct vm_area_struct *vma)
+{
+	void *prefix_start = alloc->buffer + BINDER_MIN_ALLOC;
+	void *prefix_end = alloc->buffer + alloc->min_alloc;
+	unsigned long freed = 0;
+	struct binder_buffer *buffer;
+	struct rb_node *n;
+	void *start, *end;
+
+	for (n = rb_first(&alloc->free_buffers); n; n = rb_next(n)) {
+		buffer = rb_entry(n, struct binder_buffer, rb_node);
+		start = (void *)PAGE_ALIGN((uintptr_t)buffer->data);
+		end = (void *)(((uintptr_t)buffer->data +
+				binder_alloc_buffer_size(alloc, buffer)) &
+			       PAGE_MASK);
+		start = max(start, prefix_start);
+		end = min(end, prefix_end);
+		if (end <= start)
+			continue;
+		__binder_update_page_range(alloc, 0, start, end, vma);
+		freed += (end - start) / PAGE_SIZE;
+	}
+
+	atomic_long_sub((alloc->min_alloc - BINDER_MIN_ALLOC) / PAGE_SIZE,
+			&binder_prealloc_pages);
+	alloc->min_alloc = BINDER_MIN_ALLOC;
+
+	binder_alloc_debug(BINDER_DEBUG_BUFFER_ALLOC,
+		     "%d: prealloc shrunk, %lu pages freed\n",
+		      alloc->pid, freed);
+	return freed;
+}
+
+static unsigned long
+binder_shrink_count(struct shrinker *shrink, struct shrink_control *sc)
+{
+	return atomic_long_read(&binder_prealloc_pages);
+}
+
+static unsigned long
+binder_shrink_scan(struct shrinker *shrink, struct shrink_control *sc)
+{
+	struct binder_alloc *alloc, *tmp;
+	struct vm_area_struct *vma;
+	struct mm_struct *mm;
+	unsigned long freed = 0;
+
+	if (!mutex_trylock(&binder_prealloc_lock))
+		return SHRINK_STOP;
+
+	list_for_each_entry_safe(alloc, tmp, &binder_prealloc_list,
+				 prealloc_entry) {
+		if (freed >= sc->nr_to_scan)
+			break;
+		if (!mutex_trylock(&alloc->mutex))
+			continue;
+
+		mm = get_task_mm(alloc->tsk);
+		if (!mm)
+			goto next;
+		/* reclaim may be running under this mm's mmap_sem */
+		if (!down_write_trylock(&mm->mmap_sem))
+			goto next_mm;
+
+		vma = alloc->vma;
+		if (vma && mm == alloc->vma_vm_mm) {
+			freed += binder_alloc_shrink_prealloc(alloc, vma);
+			list_del_init(&alloc->prealloc_entry);
+		}
+
+		up_write(&mm->mmap_sem);
+next_mm:
+		mmput_async(mm);
+next:
+		mutex_unlock(&alloc->mutex);
+	}
+	mutex_unlock(&binder_prealloc_lock);
+
+	return freed ? freed : SHRINK_STOP;
+}
+
+static struct shrinker binder_shrinker = {
+	.count_objects = binder_shrink_count,
+	.scan_objects = binder_shrink_scan,
+	.seeks = DEFAULT_SEEKS,
+};
+
+/**
+ * binder_alloc_shrinker_init() - register the prealloc shrinker
+ *
+ * Return: 0 on success, negative errno from register_shrinker() otherwise
+ */
+int binder_alloc_shrinker_init(void)
+{
+	return register_shrinker(&binder_shrinker);
 }
 
@@ -78,6 +78,10 @@ struct binder_buffer {
  *                      page of mmap'd space
  * @buffer_size:        size of address space specified via mmap
  * @pid:                pid for associated binder_proc (invariant after init)
+ * @min_alloc:          size of the prefix of the address space that is
+ *                      always backed by pages
+ * @prealloc_entry:     entry in the list of procs the binder shrinker may
+ *                      shrink min_alloc for
  *
  * Bookkeeping structure for per-proc address space management for binder
  * buffers. It is normally initialized during binder_init() and binder_mmap()
@@ -99,6 +103,8 @@ struct binder_alloc {
 	size_t buffer_size;
 	uint32_t buffer_free;
 	int pid;
+	size_t min_alloc;
+	struct list_head prealloc_entry;
 };
 
 #ifdef CONFIG_ANDROID_BINDER_IPC_SELFTEST
@@ -121,6 +127,8 @@ extern void binder_alloc_free_buf(struct binder_alloc *alloc,
 extern int binder_alloc_mmap_handler(struct binder_alloc *alloc,
 				     struct vm_area_struct *vma);
 extern void binder_alloc_deferred_release(struct binder_alloc *alloc);
+extern int binder_alloc_set_prealloc(struct binder_alloc *alloc, size_t size);
+extern int binder_alloc_shrinker_init(void);
 extern int binder_alloc_get_allocated_count(struct binder_alloc *alloc);
 extern void binder_alloc_print_allocated(struct seq_file *m,
 					 struct binder_alloc *alloc);
@@ -63,6 +63,8 @@ struct driver_private {
  *	binding of drivers which were unable to get all the resources needed by
  *	the device; typically because it depends on another driver getting
  *	probed first.
+ * @deferred_count - number of times a probe of this device returned
+ *	-EPROBE_DEFER.
  * @device - pointer back to the struct device that this structure is
  * associated with.
  *
@@ -74,6 +76,7 @@ struct device_private {
 	struct klist_node knode_driver;
 	struct klist_node knode_bus;
 	struct list_head deferred_probe;
+	unsigned int deferred_count;
 	struct device *device;
 };
 #define to_device_private_parent(obj)	\
@@ -18,6 +18,7 @@
  */
 
 #include <linux/device.h>
+#include <linux/debugfs.h>
 #include <linux/delay.h>
 #include <linux/module.h>
 #include <linux/kthread.h>
@@ -25,6 +26,7 @@
 #include <linux/async.h>
 #include <linux/pm_runtime.h>
 #include <linux/pinctrl/devinfo.h>
+#include <linux/seq_file.h>
 
 #include "base.h"
 #include "power/power.h"
@@ -53,6 +55,7 @@ static LIST_HEAD(deferred_probe_pending_list);
 static LIST_HEAD(deferred_probe_active_list);
 static struct workqueue_struct *deferred_wq;
 static atomic_t deferred_trigger_count = ATOMIC_INIT(0);
+static atomic_t deferred_probe_total = ATOMIC_INIT(0);
 
 /*
  * deferred_probe_work_func() - Retry probing devices in the active list.
@@ -215,6 +218,52 @@ static int deferred_probe_enable_fn(void)
 }
 late_initcall(deferred_probe_enable_fn);
 
+static void deferred_probe_show_list(struct seq_file *s,
+				     struct list_head *list)
+{
+	struct device_private *p;
+
+	list_for_each_entry(p, list, deferred_probe)
+		seq_printf(s, "%-32s %u\n", dev_name(p->device),
+			   p->deferred_count);
+}
+
+/*
+ * deferred_probe_show() - List the devices still waiting on a deferred probe
+ * along with how many times each one has been retried.
+ */
+static int deferred_probe_show(struct seq_file *s, void *unused)
+{
+	seq_printf(s, "total deferrals: %d\n",
+		   atomic_read(&deferred_probe_total));
+
+	mutex_lock(&deferred_probe_mutex);
+	deferred_probe_show_list(s, &deferred_probe_active_list);
+	deferred_probe_show_list(s, &deferred_probe_pending_list);
+	mutex_unlock(&deferred_probe_mutex);
+	return 0;
+}
+
+static int deferred_probe_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, deferred_probe_show, NULL);
+}
+
+static const struct file_operations deferred_probe_fops = {
+	.open = deferred_probe_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+static int __init deferred_probe_debugfs_init(void)
+{
+	debugfs_create_file("deferred_probe", S_IRUSR, NULL, NULL,
+			    &deferred_probe_fops);
+	return 0;
+}
+late_initcall(deferred_probe_debugfs_init);
+
 static void driver_bound(struct device *dev)
 {
 	if (klist_node_attached(&dev->p->knode_driver)) {
@@ -225,6 +274,9 @@ static void driver_bound(struct device *dev)
 
 	pr_debug("driver: '%s': %s: bound to device '%s'\n", dev->driver->name,
 		 __func__, dev_name(dev));
+	if (dev->p->deferred_count)
+		dev_dbg(dev, "bound to %s after %u deferred probes\n",
+			dev->driver->name, dev->p->deferred_count);
 
 	klist_add_tail(&dev->p->knode_driver, &dev->driver->p->klist_devices);
 
@@ -362,6 +414,8 @@ probe_failed:
 	case -EPROBE_DEFER:
 		/* Driver requested deferred probing */
 		dev_dbg(dev, "Driver %s requests probe deferral\n", drv->name);
+		dev->p->deferred_count++;
+		atomic_inc(&deferred_probe_total);
 		driver_deferred_probe_add(dev);
 		/* Did a trigger occur while probing? Need to re-trigger if yes */
 		if (local_trigger_count != atomic_read(&deferred_trigger_count))
@@ -245,7 +245,9 @@ static int __init rmem_cma_setup(struct reserved_mem *rmem)
 	phys_addr_t align = PAGE_SIZE << max(MAX_ORDER - 1, pageblock_order);
 	phys_addr_t mask = align - 1;
 	unsigned long node = rmem->fdt_node;
+	const __be32 *prop;
 	struct cma *cma;
+	int len;
 	int err;
 
 	if (!of_get_flat_dt_prop(node, "reusable", NULL) ||
@@ -268,6 +270,10 @@ static int __init rmem_cma_setup(struct reserved_mem *rmem)
 	if (of_get_flat_dt_prop(node, "linux,cma-default", NULL))
 		dma_contiguous_set_default(cma);
 
+	prop = of_get_flat_dt_prop(node, "linux,cma-ready-size", &len);
+	if (prop && len == sizeof(*prop))
+		cma_set_ready_pages(cma, be32_to_cpup(prop) >> PAGE_SHIFT);
+
 	rmem->ops = &rmem_cma_ops;
 	rmem->priv = cma;
 
@@ -40,10 +40,31 @@ static const char * const backends[] = {
 	NULL
 };
 
+#ifdef CONFIG_ZRAM_ZSTD_PARAMS
+static bool zcomp_use_zstd(struct zcomp_strm *zstrm)
+{
+	return zstrm->zstd_strm;
+}
+#else
+static bool zcomp_use_zstd(struct zcomp_strm *zstrm) { return false; }
+static inline void zcomp_zstd_strm_free(struct zcomp_strm *zstrm) {}
+static inline int zcomp_zstd_compress(struct zcomp_strm *zstrm,
+		const void *src, unsigned int *dst_len)
+{
+	return -EINVAL;
+}
+static inline int zcomp_zstd_decompress(struct zcomp_strm *zstrm,
+		const void *src, unsigned int src_len, void *dst)
+{
+	return -EINVAL;
+}
+#endif
+
 static void zcomp_strm_free(struct zcomp_strm *zstrm)
 {
 	if (!IS_ERR_OR_NULL(zstrm->tfm))
 		crypto_free_comp(zstrm->tfm);
+	zcomp_zstd_strm_free(zstrm);
 	free_pages((unsigned long)zstrm->buffer, 1);
 	kfree(zstrm);
 }
@@ -54,17 +75,26 @@ static void zcomp_strm_free(struct zcomp_strm *zstrm)
  */
 static struct zcomp_strm *zcomp_strm_alloc(struct zcomp *comp)
 {
-	struct zcomp_strm *zstrm = kmalloc(sizeof(*zstrm), GFP_KERNEL);
+	struct zcomp_strm *zstrm = kzalloc(sizeof(*zstrm), GFP_KERNEL);
 	if (!zstrm)
 		return NULL;
 
+#ifdef CONFIG_ZRAM_ZSTD_PARAMS
+	if (comp->zstd) {
+		if (zcomp_zstd_strm_init(zstrm, comp->zstd)) {
+			kfree(zstrm);
+			return NULL;
+		}
+	} else
+#endif
 	zstrm->tfm = crypto_alloc_comp(comp->name, 0, 0);
 	/*
 	 * allocate 2 pages. 1 for compressed data, plus 1 extra for the
 	 * case when compressed size is larger than the original one
 	 */
 	zstrm->buffer = (void *)__get_free_pages(GFP_KERNEL | __GFP_ZERO, 1);
-	if (IS_ERR_OR_NULL(zstrm->tfm) || !zstrm->buffer) {
+	if ((!zcomp_use_zstd(zstrm) && IS_ERR_OR_NULL(zstrm->tfm)) ||
+			!zstrm->buffer) {
 		zcomp_strm_free(zstrm);
 		zstrm = NULL;
 	}
@@ -91,6 +121,16 @@ bool zcomp_available_algorithm(const char *comp)
 	return crypto_has_comp(comp, 0, 0) == 1;
 }
 
+/* a level of 0 always means the backend default */
+bool zcomp_level_valid(int level)
+{
+#ifdef CONFIG_ZRAM_ZSTD_PARAMS
+	return zcomp_zstd_level_valid(level);
+#else
+	return level == 0;
+#endif
+}
+
 /* show available compressors */
 ssize_t zcomp_available_show(const char *comp, char *buf)
 {
@@ -150,6 +190,9 @@ int zcomp_compress(struct zcomp_strm *zstrm,
 	 */
 	*dst_len = PAGE_SIZE * 2;
 
+	if (zcomp_use_zstd(zstrm))
+		return zcomp_zstd_compress(zstrm, src, dst_len);
+
 	return crypto_comp_compress(zstrm->tfm,
 			src, PAGE_SIZE,
 			zstrm->buffer, dst_len);
@@ -160,6 +203,9 @@ int zcomp_decompress(struct zcomp_strm *zstrm,
 {
 	unsigned int dst_len = PAGE_SIZE;
 
+	if (zcomp_use_zstd(zstrm))
+		return zcomp_zstd_decompress(zstrm, src, src_len, dst);
+
 	return crypto_comp_decompress(zstrm->tfm,
 			src, src_len,
 			dst, &dst_len);
@@ -242,6 +288,9 @@ void zcomp_destroy(struct zcomp *comp)
 	cpu_notifier_register_done();
 
 	free_percpu(comp->stream);
+#ifdef CONFIG_ZRAM_ZSTD_PARAMS
+	zcomp_zstd_destroy(comp->zstd);
+#endif
 	kfree(comp);
 }
 
@@ -251,9 +300,11 @@ void zcomp_destroy(struct zcomp *comp)
  * backend pointer or ERR_PTR if things went bad. ERR_PTR(-EINVAL)
  * if requested algorithm is not supported, ERR_PTR(-ENOMEM) in
  * case of allocation error, or any other error potentially
- * returned by zcomp_init().
+ * returned by zcomp_init(). @params may be NULL; backends that have
+ * no use for it ignore it.
  */
-struct zcomp *zcomp_create(const char *compress)
+struct zcomp *zcomp_create(const char *compress,
+		const struct zcomp_params *params)
 {
 	struct zcomp *comp;
 	int error;
@@ -266,8 +317,21 @@ struct zcomp *zcomp_create(const char *compress)
 		return ERR_PTR(-ENOMEM);
 
 	comp->name = compress;
+#ifdef CONFIG_ZRAM_ZSTD_PARAMS
+	if (sysfs_streq(compress, "zstd")) {
+		comp->zstd = zcomp_zstd_create(params);
+		if (IS_ERR(comp->zstd)) {
+			error = PTR_ERR(comp->zstd);
+			kfree(comp);
+			return ERR_PTR(error);
+		}
+	}
+#endif
 	error = zcomp_init(comp);
 	if (error) {
+#ifdef CONFIG_ZRAM_ZSTD_PARAMS
+		zcomp_zstd_destroy(comp->zstd);
+#endif
 		kfree(comp);
 		return ERR_PTR(error);
 	}
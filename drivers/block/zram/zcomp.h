@@ -10,10 +10,25 @@
 #ifndef _ZCOMP_H_
 #define _ZCOMP_H_
 
+struct zcomp_zstd;
+struct zcomp_zstd_strm;
+
+/* backend tuning, only the zstd backend makes use of it */
+struct zcomp_params {
+	int level;		/* 0 selects the backend default */
+	const void *dict;	/* trained dictionary, NULL for none */
+	size_t dict_sz;
+};
+
 struct zcomp_strm {
 	/* compression/decompression buffer */
 	void *buffer;
 	struct crypto_comp *tfm;
+#ifdef CONFIG_ZRAM_ZSTD_PARAMS
+	/* used instead of ->tfm when set */
+	struct zcomp_zstd *zstd;
+	struct zcomp_zstd_strm *zstd_strm;
+#endif
 };
 
 /* dynamic per-device compression frontend */
@@ -22,12 +37,18 @@ struct zcomp {
 	struct notifier_block notifier;
 
 	const char *name;
+#ifdef CONFIG_ZRAM_ZSTD_PARAMS
+	/* level and dictionaries shared by all streams */
+	struct zcomp_zstd *zstd;
+#endif
 };
 
 ssize_t zcomp_available_show(const char *comp, char *buf);
 bool zcomp_available_algorithm(const char *comp);
+bool zcomp_level_valid(int level);
 
-struct zcomp *zcomp_create(const char *comp);
+struct zcomp *zcomp_create(const char *comp,
+		const struct zcomp_params *params);
 void zcomp_destroy(struct zcomp *comp);
 
 struct zcomp_strm *zcomp_stream_get(struct zcomp *comp);
@@ -40,4 +61,16 @@ int zcomp_decompress(struct zcomp_strm *zstrm,
 		const void *src, unsigned int src_len, void *dst);
 
 bool zcomp_set_max_streams(struct zcomp *comp, int num_strm);
+
+#ifdef CONFIG_ZRAM_ZSTD_PARAMS
+bool zcomp_zstd_level_valid(int level);
+struct zcomp_zstd *zcomp_zstd_create(const struct zcomp_params *params);
+void zcomp_zstd_destroy(struct zcomp_zstd *zstd);
+int zcomp_zstd_strm_init(struct zcomp_strm *zstrm, struct zcomp_zstd *zstd);
+void zcomp_zstd_strm_free(struct zcomp_strm *zstrm);
+int zcomp_zstd_compress(struct zcomp_strm *zstrm, const void *src,
+			unsigned int *dst_len);
+int zcomp_zstd_decompress(struct zcomp_strm *zstrm, const void *src,
+			  unsigned int src_len, void *dst);
+#endif
 #endif /* _ZCOMP_H_ */
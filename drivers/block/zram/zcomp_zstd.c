@@ -0,0 +1,195 @@
+/*
+ * zstd backend of zcomp with a tunable level and trained dictionary
+ *
+ * The crypto API has no way to pass a level or a dictionary to a
+ * compressor, so zstd is driven through lib/zstd directly. The frames are
+ * the same as those of the crypto "zstd" algorithm.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version
+ * 2 of the License, or (at your option) any later version.
+ */
+
+#include <linux/kernel.h>
+#include <linux/slab.h>
+#include <linux/string.h>
+#include <linux/vmalloc.h>
+#include <linux/zstd.h>
+
+#include "zcomp.h"
+
+#define ZCOMP_ZSTD_DEF_LEVEL	3
+
+/* state shared by all streams of one zcomp */
+struct zcomp_zstd {
+	ZSTD_parameters params;
+	size_t cwksp_size;
+	/* digested dictionaries, NULL without a dictionary */
+	ZSTD_CDict *cdict;
+	ZSTD_DDict *ddict;
+	void *cdict_wksp;
+	void *ddict_wksp;
+	void *dict;
+	size_t dict_sz;
+};
+
+struct zcomp_zstd_strm {
+	ZSTD_CCtx *cctx;
+	ZSTD_DCtx *dctx;
+	void *cwksp;
+	void *dwksp;
+};
+
+bool zcomp_zstd_level_valid(int level)
+{
+	return level >= 0 && level <= ZSTD_maxCLevel();
+}
+
+void zcomp_zstd_destroy(struct zcomp_zstd *zstd)
+{
+	if (!zstd)
+		return;
+	vfree(zstd->cdict_wksp);
+	vfree(zstd->ddict_wksp);
+	vfree(zstd->dict);
+	kfree(zstd);
+}
+
+struct zcomp_zstd *zcomp_zstd_create(const struct zcomp_params *params)
+{
+	struct zcomp_zstd *zstd;
+	int level = ZCOMP_ZSTD_DEF_LEVEL;
+	size_t dict_sz = 0;
+	size_t sz;
+
+	if (params && params->level)
+		level = params->level;
+	if (params && params->dict)
+		dict_sz = params->dict_sz;
+	if (!zcomp_zstd_level_valid(level))
+		return ERR_PTR(-EINVAL);
+
+	zstd = kzalloc(sizeof(*zstd), GFP_KERNEL);
+	if (!zstd)
+		return ERR_PTR(-ENOMEM);
+
+	/* zram only ever compresses one page at a time */
+	zstd->params = ZSTD_getParams(level, PAGE_SIZE, dict_sz);
+	zstd->cwksp_size = ZSTD_CCtxWorkspaceBound(zstd->params.cParams);
+	if (!dict_sz)
+		return zstd;
+
+	/* the digested dictionaries reference the buffer, keep our own */
+	zstd->dict = vmalloc(dict_sz);
+	if (!zstd->dict)
+		goto err;
+	memcpy(zstd->dict, params->dict, dict_sz);
+	zstd->dict_sz = dict_sz;
+
+	sz = ZSTD_CDictWorkspaceBound(zstd->params.cParams);
+	zstd->cdict_wksp = vzalloc(sz);
+	if (!zstd->cdict_wksp)
+		goto err;
+	zstd->cdict = ZSTD_initCDict(zstd->dict, dict_sz, zstd->params,
+				     zstd->cdict_wksp, sz);
+	if (!zstd->cdict)
+		goto err_inval;
+
+	sz = ZSTD_DDictWorkspaceBound();
+	zstd->ddict_wksp = vzalloc(sz);
+	if (!zstd->ddict_wksp)
+		goto err;
+	zstd->ddict = ZSTD_initDDict(zstd->dict, dict_sz,
+				     zstd->ddict_wksp, sz);
+	if (!zstd->ddict)
+		goto err_inval;
+
+	return zstd;
+
+err_inval:
+	zcomp_zstd_destroy(zstd);
+	return ERR_PTR(-EINVAL);
+err:
+	zcomp_zstd_destroy(zstd);
+	return ERR_PTR(-ENOMEM);
+}
+
+void zcomp_zstd_strm_free(struct zcomp_strm *zstrm)
+{
+	struct zcomp_zstd_strm *zs = zstrm->zstd_strm;
+
+	if (!zs)
+		return;
+	vfree(zs->cwksp);
+	vfree(zs->dwksp);
+	kfree(zs);
+	zstrm->zstd_strm = NULL;
+}
+
+int zcomp_zstd_strm_init(struct zcomp_strm *zstrm, struct zcomp_zstd *zstd)
+{
+	struct zcomp_zstd_strm *zs;
+	size_t sz;
+
+	zs = kzalloc(sizeof(*zs), GFP_KERNEL);
+	if (!zs)
+		return -ENOMEM;
+	zstrm->zstd = zstd;
+	zstrm->zstd_strm = zs;
+
+	zs->cwksp = vzalloc(zstd->cwksp_size);
+	if (!zs->cwksp)
+		goto err;
+	zs->cctx = ZSTD_initCCtx(zs->cwksp, zstd->cwksp_size);
+
+	sz = ZSTD_DCtxWorkspaceBound();
+	zs->dwksp = vzalloc(sz);
+	if (!zs->dwksp)
+		goto err;
+	zs->dctx = ZSTD_initDCtx(zs->dwksp, sz);
+
+	if (!zs->cctx || !zs->dctx)
+		goto err;
+	return 0;
+err:
+	zcomp_zstd_strm_free(zstrm);
+	return -ENOMEM;
+}
+
+int zcomp_zstd_compress(struct zcomp_strm *zstrm, const void *src,
+			unsigned int *dst_len)
+{
+	struct zcomp_zstd_strm *zs = zstrm->zstd_strm;
+	const struct zcomp_zstd *zstd = zstrm->zstd;
+	size_t ret;
+
+	if (zstd->cdict)
+		ret = ZSTD_compress_usingCDict(zs->cctx, zstrm->buffer,
+				*dst_len, src, PAGE_SIZE, zstd->cdict);
+	else
+		ret = ZSTD_compressCCtx(zs->cctx, zstrm->buffer, *dst_len,
+				src, PAGE_SIZE, zstd->params);
+	if (ZSTD_isError(ret))
+		return -EINVAL;
+	*dst_len = ret;
+	return 0;
+}
+
+int zcomp_zstd_decompress(struct zcomp_strm *zstrm, const void *src,
+			  unsigned int src_len, void *dst)
+{
+	struct zcomp_zstd_strm *zs = zstrm->zstd_strm;
+	const struct zcomp_zstd *zstd = zstrm->zstd;
+	size_t ret;
+
+	if (zstd->ddict)
+		ret = ZSTD_decompress_usingDDict(zs->dctx, dst, PAGE_SIZE,
+				src, src_len, zstd->ddict);
+	else
+		ret = ZSTD_decompressDCtx(zs->dctx, dst, PAGE_SIZE,
+				src, src_len);
+	if (ZSTD_isError(ret) || ret != PAGE_SIZE)
+		return -EINVAL;
+	return 0;
+}
@@ -0,0 +1,295 @@
+/*
+ * Content based deduplication of zram slots
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version
+ * 2 of the License, or (at your option) any later version.
+ */
+
+#define KMSG_COMPONENT "zram"
+#define pr_fmt(fmt) KMSG_COMPONENT ": " fmt
+
+#include <linux/vmalloc.h>
+#include <linux/jhash.h>
+#include <linux/highmem.h>
+
+#include "zram_drv.h"
+
+/* One slot per 16 pages is a reasonable trade-off */
+#define ZRAM_HASH_SHIFT		4
+#define ZRAM_HASH_SIZE_MIN	(1 << 10)
+#define ZRAM_HASH_SIZE_MAX	(1UL << 31)
+
+/*
+ * One compressed object in the pool that may back several slots. Entries
+ * with the same checksum share a bucket tree; equal keys are linked to
+ * the right so they sit next to each other in rb order.
+ */
+struct zram_entry {
+	struct rb_node rb_node;
+	unsigned long handle;
+	unsigned long refcount;
+	u32 checksum;
+	unsigned int len;
+};
+
+u64 zram_dedup_dup_size(struct zram *zram)
+{
+	return (u64)atomic64_read(&zram->stats.dup_data_size);
+}
+
+u64 zram_dedup_meta_size(struct zram *zram)
+{
+	return (u64)atomic64_read(&zram->stats.meta_data_size);
+}
+
+u32 zram_dedup_checksum(struct page *page)
+{
+	u32 checksum;
+	void *mem;
+
+	mem = kmap_atomic(page);
+	checksum = jhash2(mem, PAGE_SIZE / sizeof(u32), 0);
+	kunmap_atomic(mem);
+
+	return checksum;
+}
+
+static struct zram_hash *zram_dedup_hash(struct zram *zram, u32 checksum)
+{
+	return &zram->hash[checksum % zram->hash_size];
+}
+
+/* Returns the leftmost node carrying @checksum. Needs hash->lock held. */
+static struct rb_node *zram_dedup_first(struct zram_hash *hash, u32 checksum)
+{
+	struct rb_node *rb_node = hash->rb_root.rb_node;
+	struct rb_node *prev;
+	struct zram_entry *entry;
+
+	while (rb_node) {
+		entry = rb_entry(rb_node, struct zram_entry, rb_node);
+		if (checksum == entry->checksum)
+			break;
+
+		if (checksum < entry->checksum)
+			rb_node = rb_node->rb_left;
+		else
+			rb_node = rb_node->rb_right;
+	}
+
+	if (!rb_node)
+		return NULL;
+
+	while ((prev = rb_prev(rb_node))) {
+		entry = rb_entry(prev, struct zram_entry, rb_node);
+		if (entry->checksum != checksum)
+			break;
+		rb_node = prev;
+	}
+
+	return rb_node;
+}
+
+static struct zram_entry *zram_dedup_lookup(struct zram_hash *hash,
+				unsigned long handle, u32 checksum)
+{
+	struct rb_node *rb_node;
+	struct zram_entry *entry;
+
+	for (rb_node = zram_dedup_first(hash, checksum); rb_node;
+					rb_node = rb_next(rb_node)) {
+		entry = rb_entry(rb_node, struct zram_entry, rb_node);
+		if (entry->checksum != checksum)
+			break;
+		if (entry->handle == handle)
+			return entry;
+	}
+
+	return NULL;
+}
+
+/*
+ * A matching checksum is only a hint; compare the actual contents. Index
+ * entries are always stored with the primary algorithm.
+ */
+static bool zram_dedup_match(struct zram *zram, struct zram_entry *entry,
+				unsigned char *mem)
+{
+	struct zcomp_strm *zstrm;
+	unsigned char *cmem;
+	bool match = false;
+
+	cmem = zs_map_object(zram->mem_pool, entry->handle, ZS_MM_RO);
+	if (entry->len == PAGE_SIZE) {
+		match = !memcmp(mem, cmem, PAGE_SIZE);
+	} else {
+		zstrm = zcomp_stream_get(zram->comp);
+		if (!zcomp_decompress(zstrm, cmem, entry->len, zstrm->buffer))
+			match = !memcmp(mem, zstrm->buffer, PAGE_SIZE);
+		zcomp_stream_put(zram->comp);
+	}
+	zs_unmap_object(zram->mem_pool, entry->handle);
+
+	return match;
+}
+
+/*
+ * Look for an object holding the same data as @page. On success a
+ * reference is taken on it, its size is returned in @len and the handle
+ * can be stored in the slot; the caller must flag the slot ZRAM_DEDUP.
+ */
+unsigned long zram_dedup_find(struct zram *zram, struct page *page,
+				u32 checksum, unsigned int *len)
+{
+	struct zram_hash *hash = zram_dedup_hash(zram, checksum);
+	struct rb_node *rb_node;
+	struct zram_entry *entry;
+	unsigned long handle = 0;
+	unsigned char *mem;
+
+	mem = kmap_atomic(page);
+	spin_lock(&hash->lock);
+	for (rb_node = zram_dedup_first(hash, checksum); rb_node;
+					rb_node = rb_next(rb_node)) {
+		entry = rb_entry(rb_node, struct zram_entry, rb_node);
+		if (entry->checksum != checksum)
+			break;
+
+		if (zram_dedup_match(zram, entry, mem)) {
+			entry->refcount++;
+			handle = entry->handle;
+			*len = entry->len;
+			break;
+		}
+	}
+	spin_unlock(&hash->lock);
+	kunmap_atomic(mem);
+
+	if (handle)
+		atomic64_add(*len, &zram->stats.dup_data_size);
+
+	return handle;
+}
+
+/*
+ * Publish a freshly stored object so later writes of the same data can
+ * share it. Returns false if the index entry could not be allocated, in
+ * which case the slot owns the handle privately.
+ */
+bool zram_dedup_insert(struct zram *zram, unsigned long handle,
+				u32 checksum, unsigned int len)
+{
+	struct zram_hash *hash = zram_dedup_hash(zram, checksum);
+	struct rb_node **rb_node, *parent = NULL;
+	struct zram_entry *entry, *new;
+
+	new = kmalloc(sizeof(*new), GFP_NOIO | __GFP_NOWARN);
+	if (!new)
+		return false;
+
+	new->handle = handle;
+	new->refcount = 1;
+	new->checksum = checksum;
+	new->len = len;
+
+	spin_lock(&hash->lock);
+	rb_node = &hash->rb_root.rb_node;
+	while (*rb_node) {
+		parent = *rb_node;
+		entry = rb_entry(parent, struct zram_entry, rb_node);
+		if (checksum < entry->checksum)
+			rb_node = &parent->rb_left;
+		else
+			rb_node = &parent->rb_right;
+	}
+
+	rb_link_node(&new->rb_node, parent, rb_node);
+	rb_insert_color(&new->rb_node, &hash->rb_root);
+	spin_unlock(&hash->lock);
+
+	atomic64_add(sizeof(*new), &zram->stats.meta_data_size);
+
+	return true;
+}
+
+/*
+ * Drop a slot's reference on a shared object, freeing it with the last
+ * one. Accounts compr_data_size/dup_data_size on behalf of the caller.
+ */
+void zram_dedup_put(struct zram *zram, unsigned long handle,
+				u32 checksum, unsigned int len)
+{
+	struct zram_hash *hash = zram_dedup_hash(zram, checksum);
+	struct zram_entry *entry;
+
+	spin_lock(&hash->lock);
+	entry = zram_dedup_lookup(hash, handle, checksum);
+	if (WARN_ON_ONCE(!entry)) {
+		spin_unlock(&hash->lock);
+		goto free;
+	}
+
+	if (--entry->refcount) {
+		spin_unlock(&hash->lock);
+		atomic64_sub(len, &zram->stats.dup_data_size);
+		return;
+	}
+
+	rb_erase(&entry->rb_node, &hash->rb_root);
+	spin_unlock(&hash->lock);
+
+	kfree(entry);
+	atomic64_sub(sizeof(*entry), &zram->stats.meta_data_size);
+free:
+	zs_free(zram->mem_pool, handle);
+	atomic64_sub(len, &zram->stats.compr_data_size);
+}
+
+bool zram_dedup_shared(struct zram *zram, unsigned long handle, u32 checksum)
+{
+	struct zram_hash *hash = zram_dedup_hash(zram, checksum);
+	struct zram_entry *entry;
+	bool shared;
+
+	spin_lock(&hash->lock);
+	entry = zram_dedup_lookup(hash, handle, checksum);
+	shared = entry && entry->refcount > 1;
+	spin_unlock(&hash->lock);
+
+	return shared;
+}
+
+int zram_dedup_init(struct zram *zram, size_t num_pages)
+{
+	size_t i;
+	struct zram_hash *hash;
+
+	if (!zram->use_dedup)
+		return 0;
+
+	zram->hash_size = num_pages >> ZRAM_HASH_SHIFT;
+	zram->hash_size = min_t(size_t, ZRAM_HASH_SIZE_MAX, zram->hash_size);
+	zram->hash_size = max_t(size_t, ZRAM_HASH_SIZE_MIN, zram->hash_size);
+	zram->hash = vzalloc(zram->hash_size * sizeof(struct zram_hash));
+	if (!zram->hash) {
+		pr_err("Error allocating zram entry hash\n");
+		return -ENOMEM;
+	}
+
+	for (i = 0; i < zram->hash_size; i++) {
+		hash = &zram->hash[i];
+		spin_lock_init(&hash->lock);
+		hash->rb_root = RB_ROOT;
+	}
+
+	return 0;
+}
+
+void zram_dedup_fini(struct zram *zram)
+{
+	vfree(zram->hash);
+	zram->hash = NULL;
+	zram->hash_size = 0;
+}
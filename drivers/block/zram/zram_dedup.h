@@ -0,0 +1,52 @@
+#ifndef _ZRAM_DEDUP_H_
+#define _ZRAM_DEDUP_H_
+
+struct zram;
+
+#ifdef CONFIG_ZRAM_DEDUP
+u64 zram_dedup_dup_size(struct zram *zram);
+u64 zram_dedup_meta_size(struct zram *zram);
+
+u32 zram_dedup_checksum(struct page *page);
+unsigned long zram_dedup_find(struct zram *zram, struct page *page,
+				u32 checksum, unsigned int *len);
+bool zram_dedup_insert(struct zram *zram, unsigned long handle,
+				u32 checksum, unsigned int len);
+void zram_dedup_put(struct zram *zram, unsigned long handle,
+				u32 checksum, unsigned int len);
+bool zram_dedup_shared(struct zram *zram, unsigned long handle,
+				u32 checksum);
+
+int zram_dedup_init(struct zram *zram, size_t num_pages);
+void zram_dedup_fini(struct zram *zram);
+#else
+static inline u64 zram_dedup_dup_size(struct zram *zram) { return 0; }
+static inline u64 zram_dedup_meta_size(struct zram *zram) { return 0; }
+
+static inline u32 zram_dedup_checksum(struct page *page) { return 0; }
+static inline unsigned long zram_dedup_find(struct zram *zram,
+		struct page *page, u32 checksum, unsigned int *len)
+{
+	return 0;
+}
+static inline bool zram_dedup_insert(struct zram *zram, unsigned long handle,
+		u32 checksum, unsigned int len)
+{
+	return false;
+}
+static inline void zram_dedup_put(struct zram *zram, unsigned long handle,
+		u32 checksum, unsigned int len) {}
+static inline bool zram_dedup_shared(struct zram *zram, unsigned long handle,
+		u32 checksum)
+{
+	return false;
+}
+
+static inline int zram_dedup_init(struct zram *zram, size_t num_pages)
+{
+	return 0;
+}
+static inline void zram_dedup_fini(struct zram *zram) {}
+#endif
+
+#endif /* _ZRAM_DEDUP_H_ */
@@ -27,11 +27,13 @@
 #include <linux/slab.h>
 #include <linux/backing-dev.h>
 #include <linux/string.h>
+#include <linux/swap.h>
 #include <linux/vmalloc.h>
 #include <linux/err.h>
 #include <linux/idr.h>
 #include <linux/sysfs.h>
 #include <linux/debugfs.h>
+#include <linux/firmware.h>
 
 #include "zram_drv.h"
 
@@ -126,6 +128,31 @@ static unsigned long zram_get_element(struct zram *zram, u32 index)
 	return zram->table[index].element;
 }
 
+#ifdef CONFIG_ZRAM_DEDUP
+static inline bool zram_dedup_enabled(struct zram *zram)
+{
+	return zram->use_dedup;
+}
+
+static void zram_set_checksum(struct zram *zram, u32 index, u32 checksum)
+{
+	zram->table[index].checksum = checksum;
+}
+
+static u32 zram_get_checksum(struct zram *zram, u32 index)
+{
+	return zram->table[index].checksum;
+}
+#else
+static inline bool zram_dedup_enabled(struct zram *zram) { return false; }
+static inline void zram_set_checksum(struct zram *zram, u32 index,
+				u32 checksum) {}
+static inline u32 zram_get_checksum(struct zram *zram, u32 index)
+{
+	return 0;
+}
+#endif
+
 static size_t zram_get_obj_size(struct zram *zram, u32 index)
 {
 	return zram->table[index].value & (BIT(ZRAM_FLAG_SHIFT) - 1);
@@ -291,6 +318,74 @@ static ssize_t mem_used_max_store(struct device *dev,
 	return len;
 }
 
+#ifdef CONFIG_ZRAM_DEDUP
+static ssize_t use_dedup_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	bool val;
+	struct zram *zram = dev_to_zram(dev);
+
+	down_read(&zram->init_lock);
+	val = zram->use_dedup;
+	up_read(&zram->init_lock);
+
+	return scnprintf(buf, PAGE_SIZE, "%d\n", (int)val);
+}
+
+static ssize_t use_dedup_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t len)
+{
+	int val;
+	struct zram *zram = dev_to_zram(dev);
+
+	if (kstrtoint(buf, 10, &val) || (val != 0 && val != 1))
+		return -EINVAL;
+
+	down_write(&zram->init_lock);
+	if (init_done(zram)) {
+		up_write(&zram->init_lock);
+		pr_info("Can't change dedup usage for initialized device\n");
+		return -EBUSY;
+	}
+	zram->use_dedup = val;
+	up_write(&zram->init_lock);
+
+	return len;
+}
+#endif
+
+static ssize_t idle_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t len)
+{
+	struct zram *zram = dev_to_zram(dev);
+	unsigned long nr_pages, index;
+
+	if (!sysfs_streq(buf, "all"))
+		return -EINVAL;
+
+	down_read(&zram->init_lock);
+	if (!init_done(zram)) {
+		up_read(&zram->init_lock);
+		return -EINVAL;
+	}
+
+	nr_pages = zram->disksize >> PAGE_SHIFT;
+	for (index = 0; index < nr_pages; index++) {
+		/*
+		 * Slots already in flight to the backing device are left
+		 * alone; the flag is cleared again on the next access.
+		 */
+		zram_slot_lock(zram, index);
+		if (zram_allocated(zram, index) &&
+				!zram_test_flag(zram, index, ZRAM_UNDER_WB))
+			zram_set_flag(zram, index, ZRAM_IDLE);
+		zram_slot_unlock(zram, index);
+	}
+	up_read(&zram->init_lock);
+
+	return len;
+}
+
 #ifdef CONFIG_ZRAM_WRITEBACK
 static bool zram_wb_enabled(struct zram *zram)
 {
@@ -451,22 +546,42 @@ out:
 	return err;
 }
 
-static unsigned long get_entry_bdev(struct zram *zram)
+/*
+ * Allocate a run of up to *nr contiguous blocks on the backing device so
+ * that a writeback batch can be issued as a single bio. The run length is
+ * halved until a free area is found and *nr is updated to the number of
+ * blocks actually reserved. Returns the first block, or 0 if none is free.
+ */
+static unsigned long get_entries_bdev(struct zram *zram, unsigned int *nr)
 {
 	unsigned long entry;
+	unsigned int want = *nr;
 
 	spin_lock(&zram->bitmap_lock);
-	/* skip 0 bit to confuse zram.handle = 0 */
-	entry = find_next_zero_bit(zram->bitmap, zram->nr_pages, 1);
-	if (entry == zram->nr_pages) {
-		spin_unlock(&zram->bitmap_lock);
-		return 0;
+	while (want) {
+		/* skip 0 bit to confuse zram.handle = 0 */
+		entry = bitmap_find_next_zero_area(zram->bitmap,
+					zram->nr_pages, 1, want, 0);
+		if (entry < zram->nr_pages) {
+			bitmap_set(zram->bitmap, entry, want);
+			spin_unlock(&zram->bitmap_lock);
+			atomic64_add(want, &zram->stats.bd_count);
+			*nr = want;
+			return entry;
+		}
+		want >>= 1;
 	}
-
-	set_bit(entry, zram->bitmap);
 	spin_unlock(&zram->bitmap_lock);
 
-	return entry;
+	*nr = 0;
+	return 0;
+}
+
+static unsigned long get_entry_bdev(struct zram *zram)
+{
+	unsigned int nr = 1;
+
+	return get_entries_bdev(zram, &nr);
 }
 
 static void put_entry_bdev(struct zram *zram, unsigned long entry)
@@ -477,6 +592,8 @@ static void put_entry_bdev(struct zram *zram, unsigned long entry)
 	was_set = test_and_clear_bit(entry, zram->bitmap);
 	spin_unlock(&zram->bitmap_lock);
 	WARN_ON_ONCE(!was_set);
+	if (was_set)
+		atomic64_dec(&zram->stats.bd_count);
 }
 
 static void zram_page_end_io(struct bio *bio)
@@ -515,6 +632,7 @@ static int read_from_bdev_async(struct zram *zram, struct bio_vec *bvec,
 	}
 
 	submit_bio(READ, bio);
+	atomic64_inc(&zram->stats.bd_reads);
 	return 1;
 }
 
@@ -534,115 +652,780 @@ static void zram_sync_read(struct work_struct *work)
 	unsigned long entry = zw->entry;
 	struct bio *bio = zw->bio;
 
-	read_from_bdev_async(zram, &bvec, entry, bio);
+	read_from_bdev_async(zram, &bvec, entry, bio);
+}
+
+/*
+ * Block layer want one ->make_request_fn to be active at a time
+ * so if we use chained IO with parent IO in same context,
+ * it's a deadlock. To avoid, it, it uses worker thread context.
+ */
+static int read_from_bdev_sync(struct zram *zram, struct bio_vec *bvec,
+				unsigned long entry, struct bio *bio)
+{
+	struct zram_work work;
+
+	work.zram = zram;
+	work.entry = entry;
+	work.bio = bio;
+
+	INIT_WORK_ONSTACK(&work.work, zram_sync_read);
+	queue_work(system_unbound_wq, &work.work);
+	flush_work(&work.work);
+	destroy_work_on_stack(&work.work);
+
+	return 1;
+}
+#else
+static int read_from_bdev_sync(struct zram *zram, struct bio_vec *bvec,
+				unsigned long entry, struct bio *bio)
+{
+	WARN_ON(1);
+	return -EIO;
+}
+#endif
+
+static int read_from_bdev(struct zram *zram, struct bio_vec *bvec,
+			unsigned long entry, struct bio *parent, bool sync)
+{
+	if (sync)
+		return read_from_bdev_sync(zram, bvec, entry, parent);
+	else
+		return read_from_bdev_async(zram, bvec, entry, parent);
+}
+
+static int write_to_bdev(struct zram *zram, struct bio_vec *bvec,
+					u32 index, struct bio *parent,
+					unsigned long *pentry)
+{
+	struct bio *bio;
+	unsigned long entry;
+
+	bio = bio_alloc(GFP_ATOMIC, 1);
+	if (!bio)
+		return -ENOMEM;
+
+	entry = get_entry_bdev(zram);
+	if (!entry) {
+		bio_put(bio);
+		return -ENOSPC;
+	}
+
+	bio->bi_iter.bi_sector = entry * (PAGE_SIZE >> 9);
+	bio->bi_bdev = zram->bdev;
+	if (!bio_add_page(bio, bvec->bv_page, bvec->bv_len,
+					bvec->bv_offset)) {
+		bio_put(bio);
+		put_entry_bdev(zram, entry);
+		return -EIO;
+	}
+
+	if (!parent) {
+		bio->bi_rw = REQ_WRITE | REQ_SYNC;
+		bio->bi_end_io = zram_page_end_io;
+	} else {
+		bio->bi_rw = parent->bi_rw;
+		bio_chain(bio, parent);
+	}
+
+	submit_bio(WRITE, bio);
+	atomic64_inc(&zram->stats.bd_writes);
+	*pentry = entry;
+
+	return 0;
+}
+
+static void zram_wb_clear(struct zram *zram, u32 index)
+{
+	unsigned long entry;
+
+	zram_clear_flag(zram, index, ZRAM_WB);
+	entry = zram_get_element(zram, index);
+	zram_set_element(zram, index, 0);
+	put_entry_bdev(zram, entry);
+}
+
+#define IDLE_WRITEBACK			(1 << 0)
+#define HUGE_WRITEBACK			(1 << 1)
+/* 128K per bio, well below max_sectors of any sane backing device */
+#define ZRAM_WB_BATCH_PAGES		32
+
+struct zram_wb_batch {
+	struct page *pages[ZRAM_WB_BATCH_PAGES];
+	u32 index[ZRAM_WB_BATCH_PAGES];
+	unsigned int nr;
+};
+
+/* Must be called with the slot lock held */
+static bool zram_wb_eligible(struct zram *zram, u32 index, int mode)
+{
+	if (!zram_allocated(zram, index))
+		return false;
+
+	if (zram_test_flag(zram, index, ZRAM_WB) ||
+			zram_test_flag(zram, index, ZRAM_SAME) ||
+			zram_test_flag(zram, index, ZRAM_UNDER_WB))
+		return false;
+
+	if ((mode & IDLE_WRITEBACK) && zram_test_flag(zram, index, ZRAM_IDLE))
+		return true;
+	if ((mode & HUGE_WRITEBACK) && zram_test_flag(zram, index, ZRAM_HUGE))
+		return true;
+
+	return false;
+}
+
+static int zram_wb_submit(struct zram *zram, struct page **pages,
+				unsigned int nr, unsigned long entry)
+{
+	struct bio *bio;
+	unsigned int i;
+	int ret;
+
+	bio = bio_alloc(GFP_KERNEL, nr);
+	if (!bio)
+		return -ENOMEM;
+
+	bio->bi_iter.bi_sector = entry * (PAGE_SIZE >> 9);
+	bio->bi_bdev = zram->bdev;
+	for (i = 0; i < nr; i++) {
+		if (!bio_add_page(bio, pages[i], PAGE_SIZE, 0)) {
+			bio_put(bio);
+			return -EIO;
+		}
+	}
+
+	ret = submit_bio_wait(WRITE | REQ_SYNC, bio);
+	bio_put(bio);
+	if (!ret)
+		atomic64_add(nr, &zram->stats.bd_writes);
+
+	return ret;
+}
+
+/*
+ * Write out every page collected in @wb, using as few bios as the backing
+ * device bitmap allows, then retarget the slots to the written blocks.
+ * Slots that were freed, overwritten or (for idle writeback) accessed while
+ * their data was in flight keep their in-memory copy and the block is
+ * released again.
+ */
+static int zram_wb_flush(struct zram *zram, struct zram_wb_batch *wb,
+				int mode)
+{
+	unsigned int done = 0, nr, i;
+	unsigned long entry;
+	int ret = 0;
+
+	while (done < wb->nr) {
+		nr = wb->nr - done;
+		entry = get_entries_bdev(zram, &nr);
+		if (!entry) {
+			ret = -ENOSPC;
+			break;
+		}
+
+		ret = zram_wb_submit(zram, &wb->pages[done], nr, entry);
+		if (ret) {
+			for (i = 0; i < nr; i++)
+				put_entry_bdev(zram, entry + i);
+			break;
+		}
+
+		for (i = 0; i < nr; i++) {
+			u32 index = wb->index[done + i];
+
+			zram_slot_lock(zram, index);
+			if (!zram_test_flag(zram, index, ZRAM_UNDER_WB) ||
+					(mode == IDLE_WRITEBACK &&
+					 !zram_test_flag(zram, index, ZRAM_IDLE))) {
+				zram_clear_flag(zram, index, ZRAM_UNDER_WB);
+				zram_slot_unlock(zram, index);
+				put_entry_bdev(zram, entry + i);
+				continue;
+			}
+
+			zram_free_page(zram, index);
+			zram_set_flag(zram, index, ZRAM_WB);
+			zram_set_element(zram, index, entry + i);
+			zram_slot_unlock(zram, index);
+			atomic64_inc(&zram->stats.pages_stored);
+		}
+		done += nr;
+	}
+
+	/* Whatever could not be written stays in memory */
+	for (i = done; i < wb->nr; i++) {
+		zram_slot_lock(zram, wb->index[i]);
+		zram_clear_flag(zram, wb->index[i], ZRAM_UNDER_WB);
+		zram_slot_unlock(zram, wb->index[i]);
+	}
+	wb->nr = 0;
+
+	return ret;
+}
+
+static int __zram_bvec_read(struct zram *zram, struct page *page, u32 index,
+				struct bio *bio, bool partial_io);
+
+static ssize_t writeback_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t len)
+{
+	struct zram *zram = dev_to_zram(dev);
+	struct zram_wb_batch *wb;
+	unsigned long nr_pages, index;
+	ssize_t ret = len;
+	int mode, err, i;
+
+	if (sysfs_streq(buf, "idle"))
+		mode = IDLE_WRITEBACK;
+	else if (sysfs_streq(buf, "huge"))
+		mode = HUGE_WRITEBACK;
+	else
+		return -EINVAL;
+
+	wb = kzalloc(sizeof(*wb), GFP_KERNEL);
+	if (!wb)
+		return -ENOMEM;
+
+	for (i = 0; i < ZRAM_WB_BATCH_PAGES; i++) {
+		wb->pages[i] = alloc_page(GFP_KERNEL);
+		if (!wb->pages[i]) {
+			ret = -ENOMEM;
+			goto out_free;
+		}
+	}
+
+	down_read(&zram->init_lock);
+	if (!init_done(zram)) {
+		ret = -EINVAL;
+		goto release_init_lock;
+	}
+
+	if (!zram_wb_enabled(zram)) {
+		ret = -ENODEV;
+		goto release_init_lock;
+	}
+
+	nr_pages = zram->disksize >> PAGE_SHIFT;
+	for (index = 0; index < nr_pages; index++) {
+		bool eligible;
+
+		zram_slot_lock(zram, index);
+		eligible = zram_wb_eligible(zram, index, mode);
+		if (eligible)
+			zram_set_flag(zram, index, ZRAM_UNDER_WB);
+		zram_slot_unlock(zram, index);
+
+		if (!eligible)
+			continue;
+
+		if (__zram_bvec_read(zram, wb->pages[wb->nr], index,
+					NULL, false)) {
+			zram_slot_lock(zram, index);
+			zram_clear_flag(zram, index, ZRAM_UNDER_WB);
+			zram_slot_unlock(zram, index);
+			continue;
+		}
+
+		wb->index[wb->nr++] = index;
+		if (wb->nr < ZRAM_WB_BATCH_PAGES)
+			continue;
+
+		err = zram_wb_flush(zram, wb, mode);
+		if (err) {
+			ret = err;
+			break;
+		}
+		cond_resched();
+	}
+
+	if (wb->nr) {
+		err = zram_wb_flush(zram, wb, mode);
+		if (err)
+			ret = err;
+	}
+
+release_init_lock:
+	up_read(&zram->init_lock);
+out_free:
+	for (i = 0; i < ZRAM_WB_BATCH_PAGES; i++) {
+		if (wb->pages[i])
+			__free_page(wb->pages[i]);
+	}
+	kfree(wb);
+
+	return ret;
+}
+
+#else
+static bool zram_wb_enabled(struct zram *zram) { return false; }
+static inline void reset_bdev(struct zram *zram) {};
+static int write_to_bdev(struct zram *zram, struct bio_vec *bvec,
+					u32 index, struct bio *parent,
+					unsigned long *pentry)
+
+{
+	return -EIO;
+}
+
+static int read_from_bdev(struct zram *zram, struct bio_vec *bvec,
+			unsigned long entry, struct bio *parent, bool sync)
+{
+	return -EIO;
+}
+static void zram_wb_clear(struct zram *zram, u32 index) {}
+#endif
+
+#ifdef CONFIG_ZRAM_ZSTD_PARAMS
+/* trained zstd dictionaries are typically around 100K */
+#define ZRAM_COMP_DICT_MAX		(1 << 20)
+
+static void zram_comp_params(struct zram *zram, struct zcomp_params *params)
+{
+	params->level = zram->comp_level;
+	params->dict = zram->comp_dict;
+	params->dict_sz = zram->comp_dict_sz;
+}
+
+static ssize_t comp_level_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct zram *zram = dev_to_zram(dev);
+	int level;
+
+	down_read(&zram->init_lock);
+	level = zram->comp_level;
+	up_read(&zram->init_lock);
+
+	return scnprintf(buf, PAGE_SIZE, "%d\n", level);
+}
+
+static ssize_t comp_level_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t len)
+{
+	struct zram *zram = dev_to_zram(dev);
+	int level;
+
+	if (kstrtoint(buf, 10, &level))
+		return -EINVAL;
+
+	if (!zcomp_level_valid(level))
+		return -EINVAL;
+
+	down_write(&zram->init_lock);
+	if (init_done(zram)) {
+		up_write(&zram->init_lock);
+		pr_info("Can't change level for initialized device\n");
+		return -EBUSY;
+	}
+
+	zram->comp_level = level;
+	up_write(&zram->init_lock);
+
+	return len;
+}
+
+static ssize_t comp_dict_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct zram *zram = dev_to_zram(dev);
+	ssize_t ret;
+
+	down_read(&zram->init_lock);
+	ret = scnprintf(buf, PAGE_SIZE, "%s\n", zram->comp_dict_name);
+	up_read(&zram->init_lock);
+
+	return ret;
+}
+
+/*
+ * The dictionary is loaded as a firmware file, so that a trained
+ * dictionary can ship with the other vendor blobs.
+ */
+static ssize_t comp_dict_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t len)
+{
+	struct zram *zram = dev_to_zram(dev);
+	char name[ARRAY_SIZE(zram->comp_dict_name)];
+	const struct firmware *fw;
+	void *dict = NULL;
+	size_t sz;
+	int err;
+
+	strlcpy(name, buf, sizeof(name));
+	/* ignore trailing newline */
+	sz = strlen(name);
+	if (sz > 0 && name[sz - 1] == '\n')
+		name[sz - 1] = 0x00;
+
+	/* an empty string drops the dictionary */
+	sz = 0;
+	if (name[0]) {
+		err = request_firmware(&fw, name, dev);
+		if (err)
+			return err;
+
+		sz = fw->size;
+		if (!sz || sz > ZRAM_COMP_DICT_MAX) {
+			release_firmware(fw);
+			return -EINVAL;
+		}
+		dict = vmalloc(sz);
+		if (dict)
+			memcpy(dict, fw->data, sz);
+		release_firmware(fw);
+		if (!dict)
+			return -ENOMEM;
+	}
+
+	down_write(&zram->init_lock);
+	if (init_done(zram)) {
+		up_write(&zram->init_lock);
+		vfree(dict);
+		pr_info("Can't change dictionary for initialized device\n");
+		return -EBUSY;
+	}
+
+	vfree(zram->comp_dict);
+	zram->comp_dict = dict;
+	zram->comp_dict_sz = sz;
+	strcpy(zram->comp_dict_name, name);
+	up_write(&zram->init_lock);
+
+	return len;
+}
+
+static void zram_comp_dict_free(struct zram *zram)
+{
+	vfree(zram->comp_dict);
+	zram->comp_dict = NULL;
+	zram->comp_dict_sz = 0;
+}
+#else
+static void zram_comp_params(struct zram *zram, struct zcomp_params *params)
+{
+	memset(params, 0, sizeof(*params));
+}
+static inline void zram_comp_dict_free(struct zram *zram) {};
+#endif
+
+#ifdef CONFIG_ZRAM_RECOMPRESS
+#define RECOMPRESS_IDLE			(1 << 0)
+#define RECOMPRESS_HUGE			(1 << 1)
+#define ZRAM_DEFAULT_RECOMP_THRESHOLD	10
+
+static struct zcomp *zram_slot_comp(struct zram *zram, u32 index)
+{
+	if (zram_test_flag(zram, index, ZRAM_RECOMP))
+		return zram->recomp;
+	return zram->comp;
+}
+
+static ssize_t recomp_algorithm_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	size_t sz;
+	struct zram *zram = dev_to_zram(dev);
+
+	down_read(&zram->init_lock);
+	sz = zcomp_available_show(zram->recomp_name, buf);
+	up_read(&zram->init_lock);
+
+	return sz;
+}
+
+static ssize_t recomp_algorithm_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t len)
+{
+	struct zram *zram = dev_to_zram(dev);
+	char compressor[ARRAY_SIZE(zram->recomp_name)];
+	size_t sz;
+
+	strlcpy(compressor, buf, sizeof(compressor));
+	/* ignore trailing newline */
+	sz = strlen(compressor);
+	if (sz > 0 && compressor[sz - 1] == '\n')
+		compressor[sz - 1] = 0x00;
+
+	/* an empty string disables recompression */
+	if (compressor[0] && !zcomp_available_algorithm(compressor))
+		return -EINVAL;
+
+	down_write(&zram->init_lock);
+	if (init_done(zram)) {
+		up_write(&zram->init_lock);
+		pr_info("Can't change algorithm for initialized device\n");
+		return -EBUSY;
+	}
+
+	strcpy(zram->recomp_name, compressor);
+	up_write(&zram->init_lock);
+
+	return len;
+}
+
+static ssize_t recomp_threshold_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct zram *zram = dev_to_zram(dev);
+
+	return scnprintf(buf, PAGE_SIZE, "%u\n",
+			READ_ONCE(zram->recomp_threshold));
+}
+
+static ssize_t recomp_threshold_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t len)
+{
+	struct zram *zram = dev_to_zram(dev);
+	unsigned int val;
+	int err;
+
+	err = kstrtouint(buf, 10, &val);
+	if (err || val >= 100)
+		return -EINVAL;
+
+	WRITE_ONCE(zram->recomp_threshold, val);
+
+	return len;
+}
+
+static ssize_t recompress_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t len)
+{
+	struct zram *zram = dev_to_zram(dev);
+	int mode;
+	ssize_t ret = len;
+
+	if (sysfs_streq(buf, "idle"))
+		mode = RECOMPRESS_IDLE;
+	else if (sysfs_streq(buf, "huge"))
+		mode = RECOMPRESS_HUGE;
+	else
+		return -EINVAL;
+
+	down_read(&zram->init_lock);
+	if (!init_done(zram)) {
+		ret = -EINVAL;
+		goto out;
+	}
+
+	if (!zram->recomp) {
+		ret = -ENODEV;
+		goto out;
+	}
+
+	atomic_or(mode, &zram->recomp_mode);
+	queue_work(system_unbound_wq, &zram->recomp_work);
+out:
+	up_read(&zram->init_lock);
+
+	return ret;
+}
+
+/* Must be called with the slot lock held */
+static bool zram_recomp_eligible(struct zram *zram, u32 index, int mode)
+{
+	if (!zram_get_handle(zram, index))
+		return false;
+
+	if (zram_test_flag(zram, index, ZRAM_WB) ||
+			zram_test_flag(zram, index, ZRAM_SAME) ||
+			zram_test_flag(zram, index, ZRAM_UNDER_WB) ||
+			zram_test_flag(zram, index, ZRAM_RECOMP) ||
+			zram_test_flag(zram, index, ZRAM_INCOMPRESSIBLE))
+		return false;
+
+	/* a private recompressed copy of a shared object saves nothing */
+	if (zram_test_flag(zram, index, ZRAM_DEDUP) &&
+			zram_dedup_shared(zram, zram_get_handle(zram, index),
+					  zram_get_checksum(zram, index)))
+		return false;
+
+	if ((mode & RECOMPRESS_IDLE) && zram_test_flag(zram, index, ZRAM_IDLE))
+		return true;
+	if ((mode & RECOMPRESS_HUGE) && zram_test_flag(zram, index, ZRAM_HUGE))
+		return true;
+
+	return false;
+}
+
+/*
+ * Recompress one slot with the secondary algorithm. Called with the slot
+ * lock held, so nothing here may sleep. Returns -ENOMEM if the pool can't
+ * take the new object without direct reclaim, 0 otherwise.
+ */
+static int zram_recompress_slot(struct zram *zram, u32 index,
+				struct page *page)
+{
+	unsigned long handle, new_handle;
+	unsigned int old_len, new_len, threshold;
+	struct zcomp_strm *zstrm;
+	bool idle;
+	void *src, *dst;
+	int ret = 0;
+
+	handle = zram_get_handle(zram, index);
+	old_len = zram_get_obj_size(zram, index);
+
+	src = zs_map_object(zram->mem_pool, handle, ZS_MM_RO);
+	dst = kmap_atomic(page);
+	if (old_len == PAGE_SIZE) {
+		memcpy(dst, src, PAGE_SIZE);
+	} else {
+		zstrm = zcomp_stream_get(zram->comp);
+		ret = zcomp_decompress(zstrm, src, old_len, dst);
+		zcomp_stream_put(zram->comp);
+	}
+	kunmap_atomic(dst);
+	zs_unmap_object(zram->mem_pool, handle);
+
+	if (unlikely(ret)) {
+		pr_err("Decompression failed! err=%d, page=%u\n", ret, index);
+		goto skip;
+	}
+
+	zstrm = zcomp_stream_get(zram->recomp);
+	src = kmap_atomic(page);
+	ret = zcomp_compress(zstrm, src, &new_len);
+	kunmap_atomic(src);
+
+	/* Keep the original unless the secondary algorithm saves enough */
+	threshold = READ_ONCE(zram->recomp_threshold);
+	if (ret || new_len >= huge_class_size ||
+			new_len > old_len - old_len * threshold / 100) {
+		zcomp_stream_put(zram->recomp);
+		goto skip;
+	}
+
+	new_handle = zs_malloc(zram->mem_pool, new_len,
+			__GFP_KSWAPD_RECLAIM |
+			__GFP_NOWARN |
+			__GFP_HIGHMEM |
+			__GFP_MOVABLE);
+	if (!new_handle) {
+		zcomp_stream_put(zram->recomp);
+		return -ENOMEM;
+	}
+
+	dst = zs_map_object(zram->mem_pool, new_handle, ZS_MM_WO);
+	memcpy(dst, zstrm->buffer, new_len);
+	zs_unmap_object(zram->mem_pool, new_handle);
+	zcomp_stream_put(zram->recomp);
+
+	idle = zram_test_flag(zram, index, ZRAM_IDLE);
+	zram_free_page(zram, index);
+	zram_set_handle(zram, index, new_handle);
+	zram_set_obj_size(zram, index, new_len);
+	zram_set_flag(zram, index, ZRAM_RECOMP);
+	/* still cold, so leave it to idle writeback too */
+	if (idle)
+		zram_set_flag(zram, index, ZRAM_IDLE);
+
+	atomic64_add(new_len, &zram->stats.compr_data_size);
+	atomic64_inc(&zram->stats.pages_stored);
+	atomic64_inc(&zram->stats.pages_recompressed);
+	return 0;
+
+skip:
+	zram_set_flag(zram, index, ZRAM_INCOMPRESSIBLE);
+	return 0;
 }
 
-/*
- * Block layer want one ->make_request_fn to be active at a time
- * so if we use chained IO with parent IO in same context,
- * it's a deadlock. To avoid, it, it uses worker thread context.
- */
-static int read_from_bdev_sync(struct zram *zram, struct bio_vec *bvec,
-				unsigned long entry, struct bio *bio)
+static void zram_recompress_work(struct work_struct *work)
 {
-	struct zram_work work;
-
-	work.zram = zram;
-	work.entry = entry;
-	work.bio = bio;
+	struct zram *zram = container_of(work, struct zram, recomp_work);
+	unsigned long nr_pages, index;
+	struct page *page;
+	int mode;
 
-	INIT_WORK_ONSTACK(&work.work, zram_sync_read);
-	queue_work(system_unbound_wq, &work.work);
-	flush_work(&work.work);
-	destroy_work_on_stack(&work.work);
+	mode = atomic_xchg(&zram->recomp_mode, 0);
+	if (!mode)
+		return;
 
-	return 1;
-}
-#else
-static int read_from_bdev_sync(struct zram *zram, struct bio_vec *bvec,
-				unsigned long entry, struct bio *bio)
-{
-	WARN_ON(1);
-	return -EIO;
-}
-#endif
+	page = alloc_page(GFP_KERNEL);
+	if (!page)
+		return;
 
-static int read_from_bdev(struct zram *zram, struct bio_vec *bvec,
-			unsigned long entry, struct bio *parent, bool sync)
-{
-	if (sync)
-		return read_from_bdev_sync(zram, bvec, entry, parent);
-	else
-		return read_from_bdev_async(zram, bvec, entry, parent);
-}
+	down_read(&zram->init_lock);
+	if (!init_done(zram) || !zram->recomp)
+		goto out;
 
-static int write_to_bdev(struct zram *zram, struct bio_vec *bvec,
-					u32 index, struct bio *parent,
-					unsigned long *pentry)
-{
-	struct bio *bio;
-	unsigned long entry;
+	nr_pages = zram->disksize >> PAGE_SHIFT;
+	for (index = 0; index < nr_pages; index++) {
+		int err = 0;
 
-	bio = bio_alloc(GFP_ATOMIC, 1);
-	if (!bio)
-		return -ENOMEM;
+		zram_slot_lock(zram, index);
+		if (zram_recomp_eligible(zram, index, mode))
+			err = zram_recompress_slot(zram, index, page);
+		zram_slot_unlock(zram, index);
 
-	entry = get_entry_bdev(zram);
-	if (!entry) {
-		bio_put(bio);
-		return -ENOSPC;
+		/* Pool is under pressure, retry on the next trigger */
+		if (err)
+			break;
+		cond_resched();
 	}
+out:
+	up_read(&zram->init_lock);
+	__free_page(page);
+}
 
-	bio->bi_iter.bi_sector = entry * (PAGE_SIZE >> 9);
-	bio->bi_bdev = zram->bdev;
-	if (!bio_add_page(bio, bvec->bv_page, bvec->bv_len,
-					bvec->bv_offset)) {
-		bio_put(bio);
-		put_entry_bdev(zram, entry);
-		return -EIO;
-	}
+static int zram_recomp_create(struct zram *zram)
+{
+	struct zcomp_params params;
+	struct zcomp *comp;
 
-	if (!parent) {
-		bio->bi_rw = REQ_WRITE | REQ_SYNC;
-		bio->bi_end_io = zram_page_end_io;
-	} else {
-		bio->bi_rw = parent->bi_rw;
-		bio_chain(bio, parent);
-	}
+	if (!zram->recomp_name[0])
+		return 0;
 
-	submit_bio(WRITE, bio);
-	*pentry = entry;
+	zram_comp_params(zram, &params);
+	comp = zcomp_create(zram->recomp_name, &params);
+	if (IS_ERR(comp)) {
+		pr_err("Cannot initialise %s recompressing backend\n",
+				zram->recomp_name);
+		return PTR_ERR(comp);
+	}
 
+	zram->recomp = comp;
 	return 0;
 }
 
-static void zram_wb_clear(struct zram *zram, u32 index)
+static void zram_recomp_destroy(struct zram *zram)
 {
-	unsigned long entry;
+	if (!zram->recomp)
+		return;
 
-	zram_clear_flag(zram, index, ZRAM_WB);
-	entry = zram_get_element(zram, index);
-	zram_set_element(zram, index, 0);
-	put_entry_bdev(zram, entry);
+	zcomp_destroy(zram->recomp);
+	zram->recomp = NULL;
 }
 
-#else
-static bool zram_wb_enabled(struct zram *zram) { return false; }
-static inline void reset_bdev(struct zram *zram) {};
-static int write_to_bdev(struct zram *zram, struct bio_vec *bvec,
-					u32 index, struct bio *parent,
-					unsigned long *pentry)
+static void zram_recomp_init(struct zram *zram)
+{
+	zram->recomp_threshold = ZRAM_DEFAULT_RECOMP_THRESHOLD;
+	atomic_set(&zram->recomp_mode, 0);
+	INIT_WORK(&zram->recomp_work, zram_recompress_work);
+}
 
+static void zram_recomp_cancel(struct zram *zram)
 {
-	return -EIO;
+	cancel_work_sync(&zram->recomp_work);
+	atomic_set(&zram->recomp_mode, 0);
 }
 
-static int read_from_bdev(struct zram *zram, struct bio_vec *bvec,
-			unsigned long entry, struct bio *parent, bool sync)
+static u64 zram_recomp_pages(struct zram *zram)
 {
-	return -EIO;
+	return (u64)atomic64_read(&zram->stats.pages_recompressed);
 }
-static void zram_wb_clear(struct zram *zram, u32 index) {}
+#else
+static struct zcomp *zram_slot_comp(struct zram *zram, u32 index)
+{
+	return zram->comp;
+}
+static int zram_recomp_create(struct zram *zram) { return 0; }
+static inline void zram_recomp_destroy(struct zram *zram) {};
+static inline void zram_recomp_init(struct zram *zram) {};
+static inline void zram_recomp_cancel(struct zram *zram) {};
+static u64 zram_recomp_pages(struct zram *zram) { return 0; }
 #endif
 
 #ifdef CONFIG_ZRAM_MEMORY_TRACKING
@@ -661,6 +1444,7 @@ static void zram_debugfs_destroy(void)
 
 static void zram_accessed(struct zram *zram, u32 index)
 {
+	zram_clear_flag(zram, index, ZRAM_IDLE);
 	zram->table[index].ac_time = ktime_get_boottime();
 }
 
@@ -706,12 +1490,13 @@ static ssize_t read_block_state(struct file *file, char __user *buf,
 
 		ts = ktime_to_timespec64(zram->table[index].ac_time);
 		copied = snprintf(kbuf + written, count,
-			"%12zd %12lld.%06lu %c%c%c\n",
+			"%12zd %12lld.%06lu %c%c%c%c\n",
 			index, (s64)ts.tv_sec,
 			ts.tv_nsec / NSEC_PER_USEC,
 			zram_test_flag(zram, index, ZRAM_SAME) ? 's' : '.',
 			zram_test_flag(zram, index, ZRAM_WB) ? 'w' : '.',
-			zram_test_flag(zram, index, ZRAM_HUGE) ? 'h' : '.');
+			zram_test_flag(zram, index, ZRAM_HUGE) ? 'h' : '.',
+			zram_test_flag(zram, index, ZRAM_IDLE) ? 'i' : '.');
 
 		if (count < copied) {
 			zram_slot_unlock(zram, index);
@@ -756,7 +1541,10 @@ static void zram_debugfs_unregister(struct zram *zram)
 #else
 static void zram_debugfs_create(void) {};
 static void zram_debugfs_destroy(void) {};
-static void zram_accessed(struct zram *zram, u32 index) {};
+static void zram_accessed(struct zram *zram, u32 index)
+{
+	zram_clear_flag(zram, index, ZRAM_IDLE);
+};
 static void zram_reset_access(struct zram *zram, u32 index) {};
 static void zram_debugfs_register(struct zram *zram) {};
 static void zram_debugfs_unregister(struct zram *zram) {};
@@ -882,7 +1670,7 @@ static ssize_t mm_stat_show(struct device *dev,
 	max_used = atomic_long_read(&zram->stats.max_used_pages);
 
 	ret = scnprintf(buf, PAGE_SIZE,
-			"%8llu %8llu %8llu %8lu %8ld %8llu %8lu %8llu\n",
+			"%8llu %8llu %8llu %8lu %8ld %8llu %8lu %8llu %8llu %8llu\n",
 			orig_size << PAGE_SHIFT,
 			(u64)atomic64_read(&zram->stats.compr_data_size),
 			mem_used << PAGE_SHIFT,
@@ -890,24 +1678,47 @@ static ssize_t mm_stat_show(struct device *dev,
 			max_used << PAGE_SHIFT,
 			(u64)atomic64_read(&zram->stats.same_pages),
 			pool_stats.pages_compacted,
-			(u64)atomic64_read(&zram->stats.huge_pages));
+			(u64)atomic64_read(&zram->stats.huge_pages),
+			zram_dedup_dup_size(zram),
+			zram_dedup_meta_size(zram));
+	up_read(&zram->init_lock);
+
+	return ret;
+}
+
+#ifdef CONFIG_ZRAM_WRITEBACK
+#define FOUR_K(x) ((x) * (1 << (PAGE_SHIFT - 12)))
+static ssize_t bd_stat_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct zram *zram = dev_to_zram(dev);
+	ssize_t ret;
+
+	down_read(&zram->init_lock);
+	ret = scnprintf(buf, PAGE_SIZE,
+		"%8llu %8llu %8llu\n",
+			FOUR_K((u64)atomic64_read(&zram->stats.bd_count)),
+			FOUR_K((u64)atomic64_read(&zram->stats.bd_reads)),
+			FOUR_K((u64)atomic64_read(&zram->stats.bd_writes)));
 	up_read(&zram->init_lock);
 
 	return ret;
 }
+#endif
 
 static ssize_t debug_stat_show(struct device *dev,
 		struct device_attribute *attr, char *buf)
 {
-	int version = 1;
+	int version = 2;
 	struct zram *zram = dev_to_zram(dev);
 	ssize_t ret;
 
 	down_read(&zram->init_lock);
 	ret = scnprintf(buf, PAGE_SIZE,
-			"version: %d\n%8llu\n",
+			"version: %d\n%8llu %8llu\n",
 			version,
-			(u64)atomic64_read(&zram->stats.writestall));
+			(u64)atomic64_read(&zram->stats.writestall),
+			zram_recomp_pages(zram));
 	up_read(&zram->init_lock);
 
 	return ret;
@@ -915,6 +1726,9 @@ static ssize_t debug_stat_show(struct device *dev,
 
 static DEVICE_ATTR_RO(io_stat);
 static DEVICE_ATTR_RO(mm_stat);
+#ifdef CONFIG_ZRAM_WRITEBACK
+static DEVICE_ATTR_RO(bd_stat);
+#endif
 static DEVICE_ATTR_RO(debug_stat);
 
 static void zram_meta_free(struct zram *zram, u64 disksize)
@@ -926,6 +1740,7 @@ static void zram_meta_free(struct zram *zram, u64 disksize)
 	for (index = 0; index < num_pages; index++)
 		zram_free_page(zram, index);
 
+	zram_dedup_fini(zram);
 	zs_destroy_pool(zram->mem_pool);
 	vfree(zram->table);
 }
@@ -945,6 +1760,12 @@ static bool zram_meta_alloc(struct zram *zram, u64 disksize)
 		return false;
 	}
 
+	if (zram_dedup_init(zram, num_pages)) {
+		zs_destroy_pool(zram->mem_pool);
+		vfree(zram->table);
+		return false;
+	}
+
 	if (!huge_class_size)
 		huge_class_size = zs_huge_class_size(zram->mem_pool);
 	return true;
@@ -961,6 +1782,15 @@ static void zram_free_page(struct zram *zram, size_t index)
 
 	zram_reset_access(zram, index);
 
+	/*
+	 * A pending writeback notices the cleared ZRAM_UNDER_WB and drops
+	 * the stale copy it wrote for this slot.
+	 */
+	zram_clear_flag(zram, index, ZRAM_IDLE);
+	zram_clear_flag(zram, index, ZRAM_UNDER_WB);
+	zram_clear_flag(zram, index, ZRAM_RECOMP);
+	zram_clear_flag(zram, index, ZRAM_INCOMPRESSIBLE);
+
 	if (zram_test_flag(zram, index, ZRAM_HUGE)) {
 		zram_clear_flag(zram, index, ZRAM_HUGE);
 		atomic64_dec(&zram->stats.huge_pages);
@@ -988,10 +1818,15 @@ static void zram_free_page(struct zram *zram, size_t index)
 	if (!handle)
 		return;
 
-	zs_free(zram->mem_pool, handle);
-
-	atomic64_sub(zram_get_obj_size(zram, index),
-			&zram->stats.compr_data_size);
+	if (zram_test_flag(zram, index, ZRAM_DEDUP)) {
+		zram_clear_flag(zram, index, ZRAM_DEDUP);
+		zram_dedup_put(zram, handle, zram_get_checksum(zram, index),
+				zram_get_obj_size(zram, index));
+	} else {
+		zs_free(zram->mem_pool, handle);
+		atomic64_sub(zram_get_obj_size(zram, index),
+				&zram->stats.compr_data_size);
+	}
 	atomic64_dec(&zram->stats.pages_stored);
 
 	zram_set_handle(zram, index, 0);
@@ -1046,12 +1881,13 @@ static int __zram_bvec_read(struct zram *zram, struct page *page, u32 index,
 		kunmap_atomic(dst);
 		ret = 0;
 	} else {
-		struct zcomp_strm *zstrm = zcomp_stream_get(zram->comp);
+		struct zcomp *comp = zram_slot_comp(zram, index);
+		struct zcomp_strm *zstrm = zcomp_stream_get(comp);
 
 		dst = kmap_atomic(page);
 		ret = zcomp_decompress(zstrm, src, size, dst);
 		kunmap_atomic(dst);
-		zcomp_stream_put(zram->comp);
+		zcomp_stream_put(comp);
 	}
 	zs_unmap_object(zram->mem_pool, handle);
 	zram_slot_unlock(zram, index);
@@ -1109,6 +1945,8 @@ static int __zram_bvec_write(struct zram *zram, struct bio_vec *bvec,
 	unsigned long element = 0;
 	enum zram_pageflags flags = 0;
 	bool allow_wb = true;
+	bool dedup = false;
+	u32 checksum = 0;
 
 	mem = kmap_atomic(page);
 	if (page_same_filled(mem, &element)) {
@@ -1120,6 +1958,15 @@ static int __zram_bvec_write(struct zram *zram, struct bio_vec *bvec,
 	}
 	kunmap_atomic(mem);
 
+	if (zram_dedup_enabled(zram)) {
+		checksum = zram_dedup_checksum(page);
+		handle = zram_dedup_find(zram, page, checksum, &comp_len);
+		if (handle) {
+			dedup = true;
+			goto out;
+		}
+	}
+
 compress_again:
 	zstrm = zcomp_stream_get(zram->comp);
 	src = kmap_atomic(page);
@@ -1199,6 +2046,9 @@ compress_again:
 	zcomp_stream_put(zram->comp);
 	zs_unmap_object(zram->mem_pool, handle);
 	atomic64_add(comp_len, &zram->stats.compr_data_size);
+
+	if (zram_dedup_enabled(zram))
+		dedup = zram_dedup_insert(zram, handle, checksum, comp_len);
 out:
 	/*
 	 * Free memory associated with this sector
@@ -1218,6 +2068,10 @@ out:
 	}  else {
 		zram_set_handle(zram, index, handle);
 		zram_set_obj_size(zram, index, comp_len);
+		if (dedup) {
+			zram_set_flag(zram, index, ZRAM_DEDUP);
+			zram_set_checksum(zram, index, checksum);
+		}
 	}
 	zram_slot_unlock(zram, index);
 
@@ -1305,6 +2159,19 @@ static void zram_bio_discard(struct zram *zram, u32 index,
 	}
 }
 
+/* tell swap how well the pages written to it compress, every 1024 writes */
+#define ZRAM_COMPR_REPORT_MASK	1023
+
+static void zram_report_compression(struct zram *zram)
+{
+	u64 stored = atomic64_read(&zram->stats.pages_stored);
+	u64 compr = atomic64_read(&zram->stats.compr_data_size);
+
+	if (stored)
+		swap_ratio_report_compression(zram->disk,
+			div64_u64(compr * 100, stored << PAGE_SHIFT));
+}
+
 /*
  * Returns errno if it has some problem. Otherwise return 0 or 1.
  * Returns 0 if IO request was done synchronously
@@ -1324,7 +2191,9 @@ static int zram_bvec_rw(struct zram *zram, struct bio_vec *bvec, u32 index,
 		ret = zram_bvec_read(zram, bvec, index, offset, bio);
 		flush_dcache_page(bvec->bv_page);
 	} else {
-		atomic64_inc(&zram->stats.num_writes);
+		if (!(atomic64_inc_return(&zram->stats.num_writes) &
+		      ZRAM_COMPR_REPORT_MASK))
+			zram_report_compression(zram);
 		ret = zram_bvec_write(zram, bvec, index, offset, bio);
 	}
 
@@ -1386,6 +2255,180 @@ out:
 	bio_io_error(bio);
 }
 
+#ifdef CONFIG_ZRAM_ASYNC_WRITE
+static struct workqueue_struct *zram_async_wq;
+
+static bool zram_async_enabled(struct zram *zram)
+{
+	return !cpumask_empty(&zram->async_cpus);
+}
+
+static void zram_async_work(struct work_struct *work)
+{
+	struct zram_async_queue *q = container_of(work,
+					struct zram_async_queue, work);
+	struct bio_list bios;
+	struct blk_plug plug;
+	struct bio *bio;
+
+	/* Drain everything queued meanwhile as a single batch */
+	blk_start_plug(&plug);
+	for (;;) {
+		spin_lock_irq(&q->lock);
+		bios = q->bios;
+		bio_list_init(&q->bios);
+		spin_unlock_irq(&q->lock);
+
+		if (bio_list_empty(&bios))
+			break;
+
+		while ((bio = bio_list_pop(&bios)))
+			__zram_make_request(q->zram, bio);
+	}
+	blk_finish_plug(&plug);
+}
+
+/*
+ * Stay on the submitting CPU if it is allowed, the page is cache hot
+ * there. Otherwise rotate over the allowed online CPUs. The mask is read
+ * without locking; a racing update at worst picks a CPU from the old set.
+ */
+static int zram_async_cpu(struct zram *zram)
+{
+	int cpu = raw_smp_processor_id();
+
+	if (cpumask_test_cpu(cpu, &zram->async_cpus))
+		return cpu;
+
+	cpu = cpumask_next_and(READ_ONCE(zram->async_last_cpu),
+				&zram->async_cpus, cpu_online_mask);
+	if (cpu >= nr_cpu_ids)
+		cpu = cpumask_first_and(&zram->async_cpus, cpu_online_mask);
+	WRITE_ONCE(zram->async_last_cpu, cpu);
+
+	return cpu;
+}
+
+/*
+ * Returns true if the bio was handed to a compression worker, which then
+ * owns its completion.
+ */
+static bool zram_async_submit(struct zram *zram, struct bio *bio)
+{
+	struct zram_async_queue *q;
+	unsigned long flags;
+	int cpu;
+
+	if (!zram_async_enabled(zram) || bio_data_dir(bio) != WRITE ||
+			(bio->bi_rw & REQ_DISCARD))
+		return false;
+
+	cpu = zram_async_cpu(zram);
+	if (cpu >= nr_cpu_ids)
+		return false;
+
+	q = per_cpu_ptr(zram->async_queues, cpu);
+	spin_lock_irqsave(&q->lock, flags);
+	bio_list_add(&q->bios, bio);
+	spin_unlock_irqrestore(&q->lock, flags);
+	queue_work_on(cpu, zram_async_wq, &q->work);
+
+	return true;
+}
+
+static ssize_t async_cpus_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct zram *zram = dev_to_zram(dev);
+
+	return scnprintf(buf, PAGE_SIZE, "%*pbl\n",
+			cpumask_pr_args(&zram->async_cpus));
+}
+
+static ssize_t async_cpus_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t len)
+{
+	struct zram *zram = dev_to_zram(dev);
+	cpumask_var_t mask;
+	int err;
+
+	if (!alloc_cpumask_var(&mask, GFP_KERNEL))
+		return -ENOMEM;
+
+	err = cpulist_parse(buf, mask);
+	if (!err) {
+		cpumask_and(mask, mask, cpu_possible_mask);
+		cpumask_copy(&zram->async_cpus, mask);
+	}
+	free_cpumask_var(mask);
+
+	return err ? err : len;
+}
+
+static int zram_async_init(struct zram *zram)
+{
+	int cpu;
+
+	zram->async_queues = alloc_percpu(struct zram_async_queue);
+	if (!zram->async_queues)
+		return -ENOMEM;
+
+	for_each_possible_cpu(cpu) {
+		struct zram_async_queue *q = per_cpu_ptr(zram->async_queues,
+							 cpu);
+
+		spin_lock_init(&q->lock);
+		bio_list_init(&q->bios);
+		INIT_WORK(&q->work, zram_async_work);
+		q->zram = zram;
+	}
+	cpumask_clear(&zram->async_cpus);
+	zram->async_last_cpu = -1;
+
+	return 0;
+}
+
+static void zram_async_flush(struct zram *zram)
+{
+	int cpu;
+
+	for_each_possible_cpu(cpu)
+		flush_work(&per_cpu_ptr(zram->async_queues, cpu)->work);
+}
+
+static void zram_async_destroy(struct zram *zram)
+{
+	cpumask_clear(&zram->async_cpus);
+	zram_async_flush(zram);
+	free_percpu(zram->async_queues);
+}
+
+static int zram_async_wq_create(void)
+{
+	/* workers run in the swap-out path, so they need a rescuer */
+	zram_async_wq = alloc_workqueue("zram_async", WQ_MEM_RECLAIM, 0);
+	if (!zram_async_wq)
+		return -ENOMEM;
+	return 0;
+}
+
+static void zram_async_wq_destroy(void)
+{
+	destroy_workqueue(zram_async_wq);
+}
+#else
+static inline bool zram_async_enabled(struct zram *zram) { return false; }
+static inline bool zram_async_submit(struct zram *zram, struct bio *bio)
+{
+	return false;
+}
+static inline int zram_async_init(struct zram *zram) { return 0; }
+static inline void zram_async_flush(struct zram *zram) {};
+static inline void zram_async_destroy(struct zram *zram) {};
+static inline int zram_async_wq_create(void) { return 0; }
+static inline void zram_async_wq_destroy(void) {};
+#endif
+
 /*
  * Handler function for all zram I/O requests.
  */
@@ -1399,6 +2442,9 @@ static blk_qc_t zram_make_request(struct request_queue *queue, struct bio *bio)
 		goto error;
 	}
 
+	if (zram_async_submit(zram, bio))
+		return BLK_QC_T_NONE;
+
 	__zram_make_request(zram, bio);
 	return BLK_QC_T_NONE;
 
@@ -1430,6 +2476,13 @@ static int zram_rw_page(struct block_device *bdev, sector_t sector,
 
 	zram = bdev->bd_disk->private_data;
 
+	/*
+	 * Let the caller fall back to a bio so the write can be queued to
+	 * a compression worker.
+	 */
+	if ((rw & WRITE) && zram_async_enabled(zram))
+		return -EOPNOTSUPP;
+
 	if (!valid_io_request(zram, sector, PAGE_SIZE)) {
 		atomic64_inc(&zram->stats.invalid_io);
 		ret = -EINVAL;
@@ -1474,6 +2527,10 @@ static void zram_reset_device(struct zram *zram)
 	struct zcomp *comp;
 	u64 disksize;
 
+	/* the workers take init_lock themselves, so stop them before we do */
+	zram_recomp_cancel(zram);
+	zram_async_flush(zram);
+
 	down_write(&zram->init_lock);
 
 	zram->limit_pages = 0;
@@ -1495,6 +2552,7 @@ static void zram_reset_device(struct zram *zram)
 	zram_meta_free(zram, disksize);
 	memset(&zram->stats, 0, sizeof(zram->stats));
 	zcomp_destroy(comp);
+	zram_recomp_destroy(zram);
 	reset_bdev(zram);
 }
 
@@ -1503,6 +2561,7 @@ static ssize_t disksize_store(struct device *dev,
 {
 	u64 disksize;
 	struct zcomp *comp;
+	struct zcomp_params params;
 	struct zram *zram = dev_to_zram(dev);
 	int err;
 
@@ -1523,7 +2582,8 @@ static ssize_t disksize_store(struct device *dev,
 		goto out_unlock;
 	}
 
-	comp = zcomp_create(zram->compressor);
+	zram_comp_params(zram, &params);
+	comp = zcomp_create(zram->compressor, &params);
 	if (IS_ERR(comp)) {
 		pr_err("Cannot initialise %s compressing backend\n",
 				zram->compressor);
@@ -1531,7 +2591,14 @@ static ssize_t disksize_store(struct device *dev,
 		goto out_free_meta;
 	}
 
+	err = zram_recomp_create(zram);
+	if (err) {
+		zcomp_destroy(comp);
+		goto out_free_meta;
+	}
+
 	zram->comp = comp;
+
 	zram->disksize = disksize;
 	set_capacity(zram->disk, zram->disksize >> SECTOR_SHIFT);
 
@@ -1622,8 +2689,25 @@ static DEVICE_ATTR_WO(mem_limit);
 static DEVICE_ATTR_WO(mem_used_max);
 static DEVICE_ATTR_RW(max_comp_streams);
 static DEVICE_ATTR_RW(comp_algorithm);
+static DEVICE_ATTR_WO(idle);
+#ifdef CONFIG_ZRAM_DEDUP
+static DEVICE_ATTR_RW(use_dedup);
+#endif
+#ifdef CONFIG_ZRAM_ASYNC_WRITE
+static DEVICE_ATTR_RW(async_cpus);
+#endif
 #ifdef CONFIG_ZRAM_WRITEBACK
 static DEVICE_ATTR_RW(backing_dev);
+static DEVICE_ATTR_WO(writeback);
+#endif
+#ifdef CONFIG_ZRAM_ZSTD_PARAMS
+static DEVICE_ATTR_RW(comp_level);
+static DEVICE_ATTR_RW(comp_dict);
+#endif
+#ifdef CONFIG_ZRAM_RECOMPRESS
+static DEVICE_ATTR_RW(recomp_algorithm);
+static DEVICE_ATTR_RW(recomp_threshold);
+static DEVICE_ATTR_WO(recompress);
 #endif
 
 static struct attribute *zram_disk_attrs[] = {
@@ -1635,11 +2719,31 @@ static struct attribute *zram_disk_attrs[] = {
 	&dev_attr_mem_used_max.attr,
 	&dev_attr_max_comp_streams.attr,
 	&dev_attr_comp_algorithm.attr,
+#ifdef CONFIG_ZRAM_ZSTD_PARAMS
+	&dev_attr_comp_level.attr,
+	&dev_attr_comp_dict.attr,
+#endif
+	&dev_attr_idle.attr,
+#ifdef CONFIG_ZRAM_DEDUP
+	&dev_attr_use_dedup.attr,
+#endif
+#ifdef CONFIG_ZRAM_ASYNC_WRITE
+	&dev_attr_async_cpus.attr,
+#endif
 #ifdef CONFIG_ZRAM_WRITEBACK
 	&dev_attr_backing_dev.attr,
+	&dev_attr_writeback.attr,
+#endif
+#ifdef CONFIG_ZRAM_RECOMPRESS
+	&dev_attr_recomp_algorithm.attr,
+	&dev_attr_recomp_threshold.attr,
+	&dev_attr_recompress.attr,
 #endif
 	&dev_attr_io_stat.attr,
 	&dev_attr_mm_stat.attr,
+#ifdef CONFIG_ZRAM_WRITEBACK
+	&dev_attr_bd_stat.attr,
+#endif
 	&dev_attr_debug_stat.attr,
 	NULL,
 };
@@ -1673,13 +2777,17 @@ static int zram_add(void)
 	device_id = ret;
 
 	init_rwsem(&zram->init_lock);
+	zram_recomp_init(zram);
+	ret = zram_async_init(zram);
+	if (ret)
+		goto out_free_idr;
 
 	queue = blk_alloc_queue(GFP_KERNEL);
 	if (!queue) {
 		pr_err("Error allocating disk queue for device %d\n",
 			device_id);
 		ret = -ENOMEM;
-		goto out_free_idr;
+		goto out_free_async;
 	}
 
 	blk_queue_make_request(queue, zram_make_request);
@@ -1747,6 +2855,8 @@ static int zram_add(void)
 
 out_free_queue:
 	blk_cleanup_queue(queue);
+out_free_async:
+	zram_async_destroy(zram);
 out_free_idr:
 	idr_remove(&zram_index_idr, device_id);
 out_free_dev:
@@ -1793,6 +2903,8 @@ static int zram_remove(struct zram *zram)
 	del_gendisk(zram->disk);
 	blk_cleanup_queue(zram->disk->queue);
 	put_disk(zram->disk);
+	zram_async_destroy(zram);
+	zram_comp_dict_free(zram);
 	kfree(zram);
 	return 0;
 }
@@ -1874,15 +2986,23 @@ static void destroy_devices(void)
 	zram_debugfs_destroy();
 	idr_destroy(&zram_index_idr);
 	unregister_blkdev(zram_major, "zram");
+	zram_async_wq_destroy();
 }
 
 static int __init zram_init(void)
 {
 	int ret;
 
+	ret = zram_async_wq_create();
+	if (ret) {
+		pr_err("Unable to create async compression workqueue\n");
+		return ret;
+	}
+
 	ret = class_register(&zram_control_class);
 	if (ret) {
 		pr_err("Unable to register zram-control class\n");
+		zram_async_wq_destroy();
 		return ret;
 	}
 
@@ -1891,6 +3011,7 @@ static int __init zram_init(void)
 	if (zram_major <= 0) {
 		pr_err("Unable to get major number\n");
 		class_unregister(&zram_control_class);
+		zram_async_wq_destroy();
 		return -EBUSY;
 	}
 
@@ -16,10 +16,15 @@
 #define _ZRAM_DRV_H_
 
 #include <linux/rwsem.h>
+#include <linux/rbtree.h>
+#include <linux/bio.h>
+#include <linux/cpumask.h>
+#include <linux/workqueue.h>
 #include <linux/zsmalloc.h>
 #include <linux/crypto.h>
 
 #include "zcomp.h"
+#include "zram_dedup.h"
 
 #define SECTOR_SHIFT		9
 #define SECTORS_PER_PAGE_SHIFT	(PAGE_SHIFT - SECTOR_SHIFT)
@@ -49,6 +54,11 @@ enum zram_pageflags {
 	ZRAM_SAME,	/* Page consists the same element */
 	ZRAM_WB,	/* page is stored on backing_device */
 	ZRAM_HUGE,	/* Incompressible page */
+	ZRAM_UNDER_WB,	/* page is being written back to backing_device */
+	ZRAM_IDLE,	/* not accessed since the last "idle" marking */
+	ZRAM_RECOMP,	/* compressed with the secondary algorithm */
+	ZRAM_INCOMPRESSIBLE,	/* secondary algorithm gave no gain */
+	ZRAM_DEDUP,	/* handle is shared through the dedup index */
 
 	__NR_ZRAM_PAGEFLAGS,
 };
@@ -65,8 +75,26 @@ struct zram_table_entry {
 #ifdef CONFIG_ZRAM_MEMORY_TRACKING
 	ktime_t ac_time;
 #endif
+#ifdef CONFIG_ZRAM_DEDUP
+	u32 checksum;
+#endif
+};
+
+struct zram_hash {
+	spinlock_t lock;
+	struct rb_root rb_root;
 };
 
+#ifdef CONFIG_ZRAM_ASYNC_WRITE
+/* Write bios waiting for the compression worker of one CPU */
+struct zram_async_queue {
+	spinlock_t lock;
+	struct bio_list bios;
+	struct work_struct work;
+	struct zram *zram;
+};
+#endif
+
 struct zram_stats {
 	atomic64_t compr_data_size;	/* compressed size of pages stored */
 	atomic64_t num_reads;	/* failed + successful */
@@ -80,12 +108,29 @@ struct zram_stats {
 	atomic64_t pages_stored;	/* no. of pages currently stored */
 	atomic_long_t max_used_pages;	/* no. of maximum pages stored */
 	atomic64_t writestall;		/* no. of write slow paths */
+#ifdef CONFIG_ZRAM_RECOMPRESS
+	atomic64_t pages_recompressed;	/* no. of slots recompressed */
+#endif
+#ifdef CONFIG_ZRAM_DEDUP
+	atomic64_t dup_data_size;	/* compressed size of pages shared */
+	atomic64_t meta_data_size;	/* size of dedup index entries */
+#endif
+#ifdef CONFIG_ZRAM_WRITEBACK
+	atomic64_t bd_count;		/* no. of pages in backing device */
+	atomic64_t bd_reads;		/* no. of reads from backing device */
+	atomic64_t bd_writes;		/* no. of writes to backing device */
+#endif
 };
 
 struct zram {
 	struct zram_table_entry *table;
 	struct zs_pool *mem_pool;
 	struct zcomp *comp;
+#ifdef CONFIG_ZRAM_DEDUP
+	struct zram_hash *hash;
+	size_t hash_size;
+	bool use_dedup;
+#endif
 	struct gendisk *disk;
 	/* Prevent concurrent execution of device init */
 	struct rw_semaphore init_lock;
@@ -101,6 +146,13 @@ struct zram {
 	 */
 	u64 disksize;	/* bytes */
 	char compressor[CRYPTO_MAX_ALG_NAME];
+#ifdef CONFIG_ZRAM_ZSTD_PARAMS
+	/* zstd level and dictionary, for every zstd backend of the device */
+	int comp_level;
+	void *comp_dict;
+	size_t comp_dict_sz;
+	char comp_dict_name[64];
+#endif
 	/*
 	 * zram is claimed so open request will be failed
 	 */
@@ -113,6 +165,21 @@ struct zram {
 	unsigned long nr_pages;
 	spinlock_t bitmap_lock;
 #endif
+#ifdef CONFIG_ZRAM_RECOMPRESS
+	/* secondary algorithm applied to cold slots in the background */
+	struct zcomp *recomp;
+	char recomp_name[CRYPTO_MAX_ALG_NAME];
+	/* minimum size reduction, in percent, to keep a recompressed slot */
+	unsigned int recomp_threshold;
+	atomic_t recomp_mode;
+	struct work_struct recomp_work;
+#endif
+#ifdef CONFIG_ZRAM_ASYNC_WRITE
+	/* CPUs allowed to compress write bios; empty means synchronous */
+	struct cpumask async_cpus;
+	int async_last_cpu;
+	struct zram_async_queue __percpu *async_queues;
+#endif
 #ifdef CONFIG_ZRAM_MEMORY_TRACKING
 	struct dentry *debugfs_dir;
 #endif
@@ -23,6 +23,8 @@
 #include <linux/cdev.h>
 #include <linux/list.h>
 #include <linux/hash.h>
+#include <linux/log2.h>
+#include <linux/poll.h>
 #include <linux/msm_ion.h>
 #include <soc/qcom/secure_buffer.h>
 #include <soc/qcom/smd.h>
@@ -85,6 +87,12 @@
 #define PERF_KEYS "count:flush:map:copy:glink:getargs:putargs:invalidate:invoke"
 #define FASTRPC_STATIC_HANDLE_LISTENER (3)
 #define FASTRPC_STATIC_HANDLE_MAX (20)
+#define FASTRPC_POLL_TIME_DEFAULT_US (100)
+#define FASTRPC_POLL_TIME_MAX_US (1000)
+/* argument buffers kept per process for reuse, sized in power of 2 classes */
+#define FASTRPC_MAX_CACHED_BUFS (16)
+#define FASTRPC_MAX_BUF_CLASS (512 * 1024)
+#define FASTRPC_MAX_ASYNC_JOBS (64)
 
 #define PERF_END (void)0
 
@@ -190,6 +198,13 @@ struct smq_invoke_ctx {
 	struct smq_msg msg;
 	unsigned int magic;
 	uint64_t ctxid;
+	/* asynchronous invokes, see fastrpc_internal_invoke_async() */
+	int async;
+	int async_notified;
+	atomic_t async_pending;
+	uint64_t job_id;
+	remote_arg_t *upra;
+	struct list_head asyncn;
 };
 
 struct fastrpc_ctx_lst {
@@ -301,6 +316,7 @@ struct fastrpc_file {
 	spinlock_t hlock;
 	struct hlist_head maps;
 	struct hlist_head cached_bufs;
+	int num_cached_bufs;
 	struct hlist_head remote_bufs;
 	struct fastrpc_ctx_lst clst;
 	struct fastrpc_session_ctx *sctx;
@@ -318,6 +334,16 @@ struct fastrpc_file {
 	struct dentry *debugfs_file;
 	struct mutex map_mutex;
 	char *debug_buf;
+	/* time to spin for a response before sleeping, 0 to sleep at once */
+	uint32_t poll_us;
+	int64_t poll_hits;
+	int64_t poll_misses;
+	/* completed asynchronous invokes, protected by async_lock */
+	spinlock_t async_lock;
+	struct list_head async_done;
+	wait_queue_head_t async_wq;
+	int num_async;
+	uint64_t async_job_id;
 };
 
 static struct fastrpc_apps gfa;
@@ -373,9 +399,14 @@ static void fastrpc_buf_free(struct fastrpc_buf *buf, int cache)
 		return;
 	if (cache) {
 		spin_lock(&fl->hlock);
-		hlist_add_head(&buf->hn, &fl->cached_bufs);
+		if (fl->num_cached_bufs < FASTRPC_MAX_CACHED_BUFS) {
+			hlist_add_head(&buf->hn, &fl->cached_bufs);
+			fl->num_cached_bufs++;
+			cache = 0;
+		}
 		spin_unlock(&fl->hlock);
-		return;
+		if (!cache)
+			return;
 	}
 	if (buf->remote) {
 		spin_lock(&fl->hlock);
@@ -414,6 +445,7 @@ static void fastrpc_cached_buf_list_free(struct fastrpc_file *fl)
 		spin_lock(&fl->hlock);
 		hlist_for_each_entry_safe(buf, n, &fl->cached_bufs, hn) {
 			hlist_del_init(&buf->hn);
+			fl->num_cached_bufs--;
 			free = buf;
 			break;
 		}
@@ -801,8 +833,10 @@ static int fastrpc_buf_alloc(struct fastrpc_file *fl, size_t size,
 			if (buf->size >= size && (!fr || fr->size > buf->size))
 				fr = buf;
 		}
-		if (fr)
+		if (fr) {
 			hlist_del_init(&fr->hn);
+			fl->num_cached_bufs--;
+		}
 		spin_unlock(&fl->hlock);
 		if (fr) {
 			*obuf = fr;
@@ -1001,6 +1035,7 @@ static int context_alloc(struct fastrpc_file *fl, uint32_t kernel,
 
 	INIT_HLIST_NODE(&ctx->hn);
 	hlist_add_fake(&ctx->hn);
+	INIT_LIST_HEAD(&ctx->asyncn);
 	ctx->fl = fl;
 	ctx->maps = (struct fastrpc_mmap **)(&ctx[1]);
 	ctx->lpra = (remote_arg_t *)(&ctx->maps[bufs]);
@@ -1083,9 +1118,17 @@ static void context_free(struct smq_invoke_ctx *ctx)
 	struct fastrpc_apps *me = &gfa;
 	int nbufs = REMOTE_SCALARS_INBUFS(ctx->sc) +
 		    REMOTE_SCALARS_OUTBUFS(ctx->sc);
+	unsigned long flags;
+
 	spin_lock(&ctx->fl->hlock);
 	hlist_del_init(&ctx->hn);
 	spin_unlock(&ctx->fl->hlock);
+	if (ctx->async) {
+		spin_lock_irqsave(&ctx->fl->async_lock, flags);
+		list_del_init(&ctx->asyncn);
+		ctx->fl->num_async--;
+		spin_unlock_irqrestore(&ctx->fl->async_lock, flags);
+	}
 	for (i = 0; i < nbufs; ++i)
 		fastrpc_mmap_free(ctx->maps[i]);
 	fastrpc_buf_free(ctx->buf, 1);
@@ -1104,8 +1147,38 @@ static void context_free(struct smq_invoke_ctx *ctx)
 	kfree(ctx);
 }
 
+/*
+ * An asynchronous invoke is queued for its response once it has both been
+ * answered and fully submitted, whichever comes last.
+ */
+static void context_async_put(struct smq_invoke_ctx *ctx)
+{
+	struct fastrpc_file *fl = ctx->fl;
+	unsigned long flags;
+
+	if (!atomic_dec_and_test(&ctx->async_pending))
+		return;
+
+	spin_lock_irqsave(&fl->async_lock, flags);
+	list_add_tail(&ctx->asyncn, &fl->async_done);
+	spin_unlock_irqrestore(&fl->async_lock, flags);
+	wake_up_interruptible(&fl->async_wq);
+}
+
+static void context_async_notify(struct smq_invoke_ctx *ctx, int retval)
+{
+	if (xchg(&ctx->async_notified, 1))
+		return;
+	ctx->retval = retval;
+	context_async_put(ctx);
+}
+
 static void context_notify_user(struct smq_invoke_ctx *ctx, int retval)
 {
+	if (ctx->async) {
+		context_async_notify(ctx, retval);
+		return;
+	}
 	ctx->retval = retval;
 	complete(&ctx->work);
 }
@@ -1117,7 +1190,10 @@ static void fastrpc_notify_users(struct fastrpc_file *me)
 
 	spin_lock(&me->hlock);
 	hlist_for_each_entry_safe(ictx, n, &me->clst.pending, hn) {
-		complete(&ictx->work);
+		if (ictx->async)
+			context_async_notify(ictx, -ECONNRESET);
+		else
+			complete(&ictx->work);
 	}
 	hlist_for_each_entry_safe(ictx, n, &me->clst.interrupted, hn) {
 		complete(&ictx->work);
@@ -1199,6 +1275,17 @@ static void fastrpc_file_list_dtor(struct fastrpc_apps *me)
 	} while (free);
 }
 
+/*
+ * Argument buffers are rounded up to a size class, so buffers cached from
+ * earlier invokes fit the next ones even when the argument sizes vary.
+ */
+static size_t fastrpc_buf_size_class(size_t size)
+{
+	if (size > FASTRPC_MAX_BUF_CLASS)
+		return PAGE_ALIGN(size);
+	return roundup_pow_of_two(max_t(size_t, size, PAGE_SIZE));
+}
+
 static int get_args(uint32_t kernel, struct smq_invoke_ctx *ctx)
 {
 	remote_arg64_t *rpra;
@@ -1260,8 +1347,9 @@ static int get_args(uint32_t kernel, struct smq_invoke_ctx *ctx)
 	if (copylen) {
 		DEFINE_DMA_ATTRS(ctx_attrs);
 
-		err = fastrpc_buf_alloc(ctx->fl, copylen, ctx_attrs,
-					0, 0, &ctx->buf);
+		err = fastrpc_buf_alloc(ctx->fl,
+					fastrpc_buf_size_class(copylen),
+					ctx_attrs, 0, 0, &ctx->buf);
 		if (err)
 			goto bail;
 	}
@@ -1372,7 +1460,13 @@ static int get_args(uint32_t kernel, struct smq_invoke_ctx *ctx)
 		int i = ctx->overps[oix]->raix;
 		struct fastrpc_mmap *map = ctx->maps[i];
 
-		if (map && map->uncached)
+		/*
+		 * Copied arguments live in the dma_alloc_attrs() buffer of the
+		 * context, which the kernel maps either coherent or uncached.
+		 */
+		if (!map)
+			continue;
+		if (map->uncached)
 			continue;
 		if (ctx->fl->sctx->smmu.coherent &&
 			!(map && (map->attr & FASTRPC_ATTR_NON_COHERENT)))
@@ -1452,7 +1546,8 @@ static void inv_args_pre(struct smq_invoke_ctx *ctx)
 	for (i = inbufs; i < inbufs + outbufs; ++i) {
 		struct fastrpc_mmap *map = ctx->maps[i];
 
-		if (map && map->uncached)
+		/* copied arguments need no maintenance, see get_args() */
+		if (!map || map->uncached)
 			continue;
 		if (!rpra[i].buf.len)
 			continue;
@@ -1507,7 +1602,8 @@ static void inv_args(struct smq_invoke_ctx *ctx)
 	for (i = inbufs; i < inbufs + outbufs; ++i) {
 		struct fastrpc_mmap *map = ctx->maps[i];
 
-		if (map && map->uncached)
+		/* copied arguments need no maintenance, see get_args() */
+		if (!map || map->uncached)
 			continue;
 		if (!rpra[i].buf.len)
 			continue;
@@ -1650,6 +1746,27 @@ static void fastrpc_init(struct fastrpc_apps *me)
 
 static int fastrpc_release_current_dsp_process(struct fastrpc_file *fl);
 
+/*
+ * Small calls often complete within tens of microseconds. Spinning for the
+ * rx callback to complete the context saves the wakeup and scheduling
+ * latency of sleeping on it; the caller falls back to sleeping otherwise.
+ */
+static void fastrpc_poll_for_response(struct fastrpc_file *fl,
+				      struct smq_invoke_ctx *ctx)
+{
+	ktime_t end = ktime_add_us(ktime_get(), fl->poll_us);
+
+	do {
+		if (completion_done(&ctx->work)) {
+			fl->poll_hits++;
+			return;
+		}
+		cpu_relax();
+	} while (!need_resched() && ktime_before(ktime_get(), end));
+
+	fl->poll_misses++;
+}
+
 static int fastrpc_internal_invoke(struct fastrpc_file *fl, uint32_t mode,
 				   uint32_t kernel,
 				   struct fastrpc_ioctl_invoke_attrs *inv)
@@ -1713,6 +1830,8 @@ static int fastrpc_internal_invoke(struct fastrpc_file *fl, uint32_t mode,
 		inv_args(ctx);
 	PERF_END);
  wait:
+	if (fl->poll_us)
+		fastrpc_poll_for_response(fl, ctx);
 	if (kernel)
 		wait_for_completion(&ctx->work);
 	else {
@@ -1748,6 +1867,131 @@ static int fastrpc_internal_invoke(struct fastrpc_file *fl, uint32_t mode,
 	return err;
 }
 
+/*
+ * Submit an invoke and return without waiting for the DSP. The response
+ * is collected with fastrpc_internal_async_response(), which also copies
+ * the output arguments back to the caller.
+ */
+static int fastrpc_internal_invoke_async(struct fastrpc_file *fl,
+				uint32_t mode,
+				struct fastrpc_ioctl_invoke_async *inva)
+{
+	struct smq_invoke_ctx *ctx = NULL;
+	struct fastrpc_ioctl_invoke *invoke = &inva->inv.inv;
+	int err = 0, sent = 0;
+
+	VERIFY(err, fl->sctx != NULL);
+	if (err)
+		goto bail;
+	VERIFY(err, fl->cid >= 0 && fl->cid < NUM_CHANNELS);
+	if (err)
+		goto bail;
+	if (fl->sctx->smmu.faults) {
+		err = FASTRPC_ENOSUCH;
+		goto bail;
+	}
+
+	spin_lock_irq(&fl->async_lock);
+	if (fl->num_async < FASTRPC_MAX_ASYNC_JOBS)
+		fl->num_async++;
+	else
+		err = -EBUSY;
+	spin_unlock_irq(&fl->async_lock);
+	if (err)
+		goto bail;
+
+	err = context_alloc(fl, 0, &inva->inv, &ctx);
+	if (err) {
+		spin_lock_irq(&fl->async_lock);
+		fl->num_async--;
+		spin_unlock_irq(&fl->async_lock);
+		goto bail;
+	}
+
+	/* one reference for the response, one for the submission */
+	atomic_set(&ctx->async_pending, 2);
+	ctx->upra = invoke->pra;
+	spin_lock_irq(&fl->async_lock);
+	ctx->job_id = ++fl->async_job_id;
+	spin_unlock_irq(&fl->async_lock);
+	ctx->async = 1;
+
+	if (REMOTE_SCALARS_LENGTH(ctx->sc)) {
+		VERIFY(err, 0 == get_args(0, ctx));
+		if (err)
+			goto bail;
+	}
+
+	inv_args_pre(ctx);
+	if (mode == FASTRPC_MODE_SERIAL)
+		inv_args(ctx);
+
+	VERIFY(err, 0 == fastrpc_invoke_send(ctx, 0, invoke->handle));
+	if (err)
+		goto bail;
+	sent = 1;
+
+	if (mode == FASTRPC_MODE_PARALLEL)
+		inv_args(ctx);
+
+	inva->job_id = ctx->job_id;
+	context_async_put(ctx);
+	return 0;
+ bail:
+	if (ctx && !sent)
+		context_free(ctx);
+	return err;
+}
+
+static struct smq_invoke_ctx *fastrpc_async_dequeue(struct fastrpc_file *fl,
+						    int *outstanding)
+{
+	struct smq_invoke_ctx *ctx;
+
+	spin_lock_irq(&fl->async_lock);
+	ctx = list_first_entry_or_null(&fl->async_done, struct smq_invoke_ctx,
+				       asyncn);
+	if (ctx)
+		list_del_init(&ctx->asyncn);
+	*outstanding = fl->num_async;
+	spin_unlock_irq(&fl->async_lock);
+
+	return ctx;
+}
+
+static int fastrpc_internal_async_response(struct fastrpc_file *fl,
+				struct fastrpc_ioctl_async_response *rsp)
+{
+	struct smq_invoke_ctx *ctx = NULL;
+	int err = 0, outstanding = 0;
+
+	while (!(ctx = fastrpc_async_dequeue(fl, &outstanding))) {
+		if (!outstanding) {
+			err = -ENOENT;
+			goto bail;
+		}
+		if (rsp->flags & FASTRPC_ASYNC_NONBLOCK) {
+			err = -EAGAIN;
+			goto bail;
+		}
+		err = wait_event_interruptible(fl->async_wq,
+				!list_empty_careful(&fl->async_done));
+		if (err)
+			goto bail;
+	}
+
+	rsp->job_id = ctx->job_id;
+	rsp->result = ctx->retval;
+	if (fl->ssrcount != fl->apps->channel[fl->cid].ssrcount)
+		rsp->result = -ECONNRESET;
+	else if (!rsp->result)
+		rsp->result = put_args(0, ctx, ctx->upra);
+
+	context_free(ctx);
+ bail:
+	return err;
+}
+
 static int fastrpc_channel_open(struct fastrpc_file *fl);
 static int fastrpc_init_process(struct fastrpc_file *fl,
 				struct fastrpc_ioctl_init_attrs *uproc)
@@ -2612,6 +2856,7 @@ static int fastrpc_glink_open(int cid)
 	cfg->edge = gcinfo[cid].link.link_info.edge;
 	cfg->transport = gcinfo[cid].link.link_info.transport;
 	cfg->name = FASTRPC_GLINK_GUID;
+	cfg->options = GLINK_OPT_RX_INTENT_POOL;
 	cfg->notify_rx = fastrpc_glink_notify_rx;
 	cfg->notify_tx_done = fastrpc_glink_notify_tx_done;
 	cfg->notify_state = fastrpc_glink_notify_state;
@@ -2738,6 +2983,12 @@ static ssize_t fastrpc_debugfs_read(struct file *filp, char __user *buffer,
 			"%s %6s %d\n", "file_close", ":", fl->file_close);
 		len += scnprintf(fileinfo + len, DEBUGFS_SIZE - len,
 			"%s %9s %d\n", "profile", ":", fl->profile);
+		len += scnprintf(fileinfo + len, DEBUGFS_SIZE - len,
+			"%s %9s %u\n", "poll_us", ":", fl->poll_us);
+		len += scnprintf(fileinfo + len, DEBUGFS_SIZE - len,
+			"%s %7s %lld\n", "poll_hits", ":", fl->poll_hits);
+		len += scnprintf(fileinfo + len, DEBUGFS_SIZE - len,
+			"%s %5s %lld\n", "poll_misses", ":", fl->poll_misses);
 		len += scnprintf(fileinfo + len, DEBUGFS_SIZE - len,
 			"%s %3s %d\n", "smmu.coherent", ":",
 			fl->sctx->smmu.coherent);
@@ -2960,6 +3211,9 @@ static int fastrpc_device_open(struct inode *inode, struct file *filp)
 	INIT_HLIST_HEAD(&fl->cached_bufs);
 	INIT_HLIST_HEAD(&fl->remote_bufs);
 	INIT_HLIST_NODE(&fl->hn);
+	spin_lock_init(&fl->async_lock);
+	INIT_LIST_HEAD(&fl->async_done);
+	init_waitqueue_head(&fl->async_wq);
 	fl->tgid = current->tgid;
 	fl->apps = me;
 	fl->mode = FASTRPC_MODE_SERIAL;
@@ -3019,6 +3273,19 @@ static int fastrpc_internal_control(struct fastrpc_file *fl,
 	case FASTRPC_CONTROL_KALLOC:
 		cp->kalloc.kalloc_support = 1;
 		break;
+	case FASTRPC_CONTROL_POLL:
+		VERIFY(err, cp->poll.timeout_us <= FASTRPC_POLL_TIME_MAX_US);
+		if (err) {
+			err = -EINVAL;
+			goto bail;
+		}
+		if (!cp->poll.enable)
+			fl->poll_us = 0;
+		else if (cp->poll.timeout_us)
+			fl->poll_us = cp->poll.timeout_us;
+		else
+			fl->poll_us = FASTRPC_POLL_TIME_DEFAULT_US;
+		break;
 	default:
 		err = -ENOTTY;
 		break;
@@ -3032,6 +3299,8 @@ static long fastrpc_device_ioctl(struct file *file, unsigned int ioctl_num,
 {
 	union {
 		struct fastrpc_ioctl_invoke_attrs inv;
+		struct fastrpc_ioctl_invoke_async inva;
+		struct fastrpc_ioctl_async_response rsp;
 		struct fastrpc_ioctl_mmap mmap;
 		struct fastrpc_ioctl_munmap munmap;
 		struct fastrpc_ioctl_init_attrs init;
@@ -3072,6 +3341,30 @@ static long fastrpc_device_ioctl(struct file *file, unsigned int ioctl_num,
 		if (err)
 			goto bail;
 		break;
+	case FASTRPC_IOCTL_INVOKE_ASYNC:
+		K_COPY_FROM_USER(err, 0, &p.inva, param, sizeof(p.inva));
+		if (err)
+			goto bail;
+		VERIFY(err, 0 == (err = fastrpc_internal_invoke_async(fl,
+						fl->mode, &p.inva)));
+		if (err)
+			goto bail;
+		K_COPY_TO_USER(err, 0, param, &p.inva, sizeof(p.inva));
+		if (err)
+			goto bail;
+		break;
+	case FASTRPC_IOCTL_ASYNC_RESPONSE:
+		K_COPY_FROM_USER(err, 0, &p.rsp, param, sizeof(p.rsp));
+		if (err)
+			goto bail;
+		VERIFY(err, 0 == (err = fastrpc_internal_async_response(fl,
+								&p.rsp)));
+		if (err)
+			goto bail;
+		K_COPY_TO_USER(err, 0, param, &p.rsp, sizeof(p.rsp));
+		if (err)
+			goto bail;
+		break;
 	case FASTRPC_IOCTL_MMAP:
 		K_COPY_FROM_USER(err, 0, &p.mmap, param,
 						sizeof(p.mmap));
@@ -3240,9 +3533,23 @@ static int fastrpc_smmu_fault_handler(struct iommu_domain *domain,
 	return 0;
 }
 
+static unsigned int fastrpc_device_poll(struct file *file,
+					struct poll_table_struct *wait)
+{
+	struct fastrpc_file *fl = (struct fastrpc_file *)file->private_data;
+	unsigned int mask = 0;
+
+	poll_wait(file, &fl->async_wq, wait);
+	if (!list_empty_careful(&fl->async_done))
+		mask |= POLLIN | POLLRDNORM;
+
+	return mask;
+}
+
 static const struct file_operations fops = {
 	.open = fastrpc_device_open,
 	.release = fastrpc_device_release,
+	.poll = fastrpc_device_poll,
 	.unlocked_ioctl = fastrpc_device_ioctl,
 	.compat_ioctl = compat_fastrpc_device_ioctl,
 };
@@ -38,6 +38,8 @@
 		_IOWR('R', 10, struct compat_fastrpc_ioctl_init_attrs)
 #define COMPAT_FASTRPC_IOCTL_CONTROL \
 		_IOWR('R', 12, struct compat_fastrpc_ioctl_control)
+#define COMPAT_FASTRPC_IOCTL_INVOKE_ASYNC \
+		_IOWR('R', 13, struct compat_fastrpc_ioctl_invoke_async)
 
 struct compat_remote_buf {
 	compat_uptr_t pv;	/* buffer pointer */
@@ -66,6 +68,11 @@ struct compat_fastrpc_ioctl_invoke_attrs {
 	compat_uptr_t attrs;	/* attribute list */
 };
 
+struct compat_fastrpc_ioctl_invoke_async {
+	struct compat_fastrpc_ioctl_invoke_attrs inv;
+	compat_u64 job_id;	/* returned, identifies the response */
+};
+
 struct compat_fastrpc_ioctl_mmap {
 	compat_int_t fd;	/* ion fd */
 	compat_uint_t flags;	/* flags for dsp to map with */
@@ -117,12 +124,19 @@ struct compat_fastrpc_ctrl_kalloc {
 	compat_uint_t kalloc_support; /* Remote memory allocation from kernel */
 };
 
+#define FASTRPC_CONTROL_POLL		(4)
+struct compat_fastrpc_ctrl_poll {
+	compat_uint_t enable;
+	compat_uint_t timeout_us;
+};
+
 struct compat_fastrpc_ioctl_control {
 	compat_uint_t req;
 	union {
 		struct compat_fastrpc_ctrl_latency lp;
 		struct compat_fastrpc_ctrl_smmu smmu;
 		struct compat_fastrpc_ctrl_kalloc kalloc;
+		struct compat_fastrpc_ctrl_poll poll;
 	};
 };
 
@@ -137,6 +151,7 @@ static int compat_get_fastrpc_ioctl_invoke(
 	struct fastrpc_ioctl_invoke_attrs *inv;
 	union compat_remote_arg *pra32;
 	union remote_arg *pra;
+	size_t hdr;
 	int err, len, num, j;
 
 	err = get_user(sc, &inv32->inv.sc);
@@ -144,12 +159,14 @@ static int compat_get_fastrpc_ioctl_invoke(
 		return err;
 
 	len = REMOTE_SCALARS_LENGTH(sc);
+	/* leave room for the job id of the asynchronous variant */
+	hdr = sizeof(struct fastrpc_ioctl_invoke_async);
 	VERIFY(err, NULL != (inv = compat_alloc_user_space(
-				sizeof(*inv) + len * sizeof(*pra))));
+				hdr + len * sizeof(*pra))));
 	if (err)
 		return -EFAULT;
 
-	pra = (union remote_arg *)(inv + 1);
+	pra = (union remote_arg *)((char *)inv + hdr);
 	err = put_user(pra, &inv->inv.pra);
 	err |= put_user(sc, &inv->inv.sc);
 	err |= get_user(u, &inv32->inv.handle);
@@ -159,7 +176,6 @@ static int compat_get_fastrpc_ioctl_invoke(
 		return err;
 
 	pra32 = compat_ptr(p);
-	pra = (union remote_arg *)(inv + 1);
 	num = REMOTE_SCALARS_INBUFS(sc) + REMOTE_SCALARS_OUTBUFS(sc);
 	for (j = 0; j < num; j++) {
 		err |= get_user(p, &pra32[j].buf.pv);
@@ -199,11 +215,11 @@ static int compat_put_fastrpc_ioctl_invoke(
 
 	err = get_user(u, &inv32->inv.sc);
 	err |= get_user(p, &inv32->inv.pra);
+	err |= get_user(pra, &inv->inv.pra);
 	if (err)
 		return err;
 
 	pra32 = compat_ptr(p);
-	pra = (union remote_arg *)(inv + 1);
 	num = REMOTE_SCALARS_INBUFS(u) + REMOTE_SCALARS_OUTBUFS(u)
 		+ REMOTE_SCALARS_INHANDLES(u);
 	for (i = 0;  i < REMOTE_SCALARS_OUTHANDLES(u); i++) {
@@ -289,6 +305,12 @@ static int compat_get_fastrpc_ioctl_control(
 
 	err = get_user(p, &ctrl32->req);
 	err |= put_user(p, &ctrl->req);
+	if (p == FASTRPC_CONTROL_POLL) {
+		err |= get_user(p, &ctrl32->poll.enable);
+		err |= put_user(p, &ctrl->poll.enable);
+		err |= get_user(p, &ctrl32->poll.timeout_us);
+		err |= put_user(p, &ctrl->poll.timeout_us);
+	}
 
 	return err;
 }
@@ -362,6 +384,42 @@ long compat_fastrpc_device_ioctl(struct file *filp, unsigned int cmd,
 		VERIFY(err, 0 == compat_put_fastrpc_ioctl_invoke(inv32, inv));
 		return err;
 	}
+	case COMPAT_FASTRPC_IOCTL_INVOKE_ASYNC:
+	{
+		struct compat_fastrpc_ioctl_invoke_async __user *inva32;
+		struct fastrpc_ioctl_invoke_attrs __user *inv;
+		struct fastrpc_ioctl_invoke_async __user *inva;
+		compat_uint_t sc;
+		uint64_t job_id;
+		long ret;
+
+		inva32 = compat_ptr(arg);
+		/*
+		 * Output handles are written back when the response is read,
+		 * by then the translated argument list would be gone.
+		 */
+		err = get_user(sc, &inva32->inv.inv.sc);
+		if (err)
+			return err;
+		if (REMOTE_SCALARS_OUTHANDLES(sc))
+			return -EINVAL;
+		VERIFY(err, 0 == compat_get_fastrpc_ioctl_invoke(&inva32->inv,
+				&inv, COMPAT_FASTRPC_IOCTL_INVOKE_ATTRS));
+		if (err)
+			return err;
+		inva = (struct fastrpc_ioctl_invoke_async __user *)inv;
+		ret = filp->f_op->unlocked_ioctl(filp,
+				FASTRPC_IOCTL_INVOKE_ASYNC, (unsigned long)inva);
+		if (ret)
+			return ret;
+		err = get_user(job_id, &inva->job_id);
+		err |= put_user(job_id, &inva32->job_id);
+		return err;
+	}
+	case FASTRPC_IOCTL_ASYNC_RESPONSE:
+		/* same layout for 32 and 64 bit callers */
+		return filp->f_op->unlocked_ioctl(filp, cmd,
+						(unsigned long)compat_ptr(arg));
 	case COMPAT_FASTRPC_IOCTL_MMAP:
 	{
 		struct compat_fastrpc_ioctl_mmap __user *map32;
@@ -28,6 +28,10 @@
 #define FASTRPC_IOCTL_GETPERF	_IOWR('R', 9, struct fastrpc_ioctl_perf)
 #define FASTRPC_IOCTL_INIT_ATTRS _IOWR('R', 10, struct fastrpc_ioctl_init_attrs)
 #define FASTRPC_IOCTL_CONTROL	_IOWR('R', 12, struct fastrpc_ioctl_control)
+#define FASTRPC_IOCTL_INVOKE_ASYNC \
+			_IOWR('R', 13, struct fastrpc_ioctl_invoke_async)
+#define FASTRPC_IOCTL_ASYNC_RESPONSE \
+			_IOWR('R', 14, struct fastrpc_ioctl_async_response)
 
 #define FASTRPC_GLINK_GUID "fastrpcglink-apps-dsp"
 #define FASTRPC_SMD_GUID "fastrpcsmd-apps-dsp"
@@ -151,6 +155,25 @@ struct fastrpc_ioctl_invoke_attrs {
 	unsigned *attrs;	/* attribute list */
 };
 
+/*
+ * Asynchronous invoke: the argument list and the output buffers must stay
+ * valid until the response of the job has been read, which is when the
+ * outputs are copied back.
+ */
+struct fastrpc_ioctl_invoke_async {
+	struct fastrpc_ioctl_invoke_attrs inv;
+	uint64_t job_id;	/* returned, identifies the response */
+};
+
+/* Return -EAGAIN rather than wait when no response is available */
+#define FASTRPC_ASYNC_NONBLOCK	0x1
+
+struct fastrpc_ioctl_async_response {
+	uint64_t job_id;	/* job the response is for */
+	int32_t result;		/* result of the remote invocation */
+	uint32_t flags;		/* FASTRPC_ASYNC_* */
+};
+
 struct fastrpc_ioctl_init {
 	uint32_t flags;		/* one of FASTRPC_INIT_* macros */
 	uintptr_t file;		/* pointer to elf file */
@@ -202,12 +225,19 @@ struct fastrpc_ctrl_kalloc {
 	uint32_t kalloc_support; /* Remote memory allocation from kernel */
 };
 
+#define FASTRPC_CONTROL_POLL	(4)
+struct fastrpc_ctrl_poll {
+	uint32_t enable;	/* spin for the response before sleeping */
+	uint32_t timeout_us;	/* time to spin for, 0 for the default */
+};
+
 struct fastrpc_ioctl_control {
 	uint32_t req;
 	union {
 		struct fastrpc_ctrl_latency lp;
 		struct fastrpc_ctrl_smmu smmu;
 		struct fastrpc_ctrl_kalloc kalloc;
+		struct fastrpc_ctrl_poll poll;
 	};
 };
 
@@ -0,0 +1,122 @@
+/* Copyright (c) 2018, The Linux Foundation. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 and
+ * only version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+/*
+ * Optional LZ4 compression of the peripheral data sent without HDLC
+ * encoding. Each buffer read from a peripheral already batches many diag
+ * packets; when compression is enabled it is replaced by a single
+ * compressed frame before being handed to the mux, unless that would not
+ * make it smaller.
+ */
+
+#include <linux/crypto.h>
+#include <linux/err.h>
+#include <linux/lz4.h>
+#include <linux/module.h>
+#include <linux/mutex.h>
+#include <linux/slab.h>
+#include "diagchar.h"
+#include "diagfwd_peripheral.h"
+#include "diag_compress.h"
+
+static bool compress_enable;
+module_param_named(compress, compress_enable, bool, S_IRUGO | S_IWUSR);
+MODULE_PARM_DESC(compress, "LZ4 compress non-HDLC peripheral data");
+
+struct diag_compress_stats_t diag_compress_stats;
+
+static struct crypto_comp *compress_tfm;
+/* lz4 assumes the output has room for the worst case */
+static unsigned char *compress_scratch;
+static DEFINE_MUTEX(compress_mutex);
+
+/**
+ * diag_compress_buf() - Compress a buffer of non-HDLC packets
+ * @dst: where to write the compressed frame
+ * @dst_size: size of @dst
+ * @src: the packets
+ * @len: length of @src
+ *
+ * Returns the length of the frame written to @dst, or 0 if @src is to be
+ * sent as is: compression is disabled, failed or does not pay off.
+ */
+int diag_compress_buf(unsigned char *dst, int dst_size,
+		      const unsigned char *src, int len)
+{
+	struct diag_compress_frame_t *frame;
+	unsigned int out_len;
+	int frame_len = 0;
+
+	if (!READ_ONCE(compress_enable) || !compress_tfm ||
+	    len <= 0 || len > MAX_PERIPHERAL_BUF_SZ)
+		return 0;
+
+	mutex_lock(&compress_mutex);
+	out_len = lz4_compressbound(MAX_PERIPHERAL_BUF_SZ);
+	if (crypto_comp_compress(compress_tfm, src, len, compress_scratch,
+				 &out_len))
+		goto skip;
+
+	frame_len = sizeof(*frame) + out_len + sizeof(uint8_t);
+	if (frame_len >= len || frame_len > dst_size) {
+		frame_len = 0;
+		goto skip;
+	}
+
+	frame = (struct diag_compress_frame_t *)dst;
+	frame->start = CONTROL_CHAR;
+	frame->version = DIAG_COMPRESS_VERSION;
+	frame->length = out_len;
+	frame->raw_length = len;
+	memcpy(frame + 1, compress_scratch, out_len);
+	dst[frame_len - 1] = CONTROL_CHAR;
+
+	diag_compress_stats.compressed++;
+	diag_compress_stats.raw_bytes += len;
+	diag_compress_stats.out_bytes += frame_len;
+	mutex_unlock(&compress_mutex);
+	return frame_len;
+
+skip:
+	diag_compress_stats.skipped++;
+	mutex_unlock(&compress_mutex);
+	return 0;
+}
+
+int diag_compress_init(void)
+{
+	compress_scratch = kmalloc(lz4_compressbound(MAX_PERIPHERAL_BUF_SZ),
+				   GFP_KERNEL);
+	if (!compress_scratch)
+		return -ENOMEM;
+
+	compress_tfm = crypto_alloc_comp("lz4", 0, 0);
+	if (IS_ERR(compress_tfm)) {
+		pr_err("diag: unable to allocate lz4 compressor, err: %ld\n",
+		       PTR_ERR(compress_tfm));
+		compress_tfm = NULL;
+		kfree(compress_scratch);
+		compress_scratch = NULL;
+		return -ENODEV;
+	}
+
+	return 0;
+}
+
+void diag_compress_exit(void)
+{
+	if (compress_tfm)
+		crypto_free_comp(compress_tfm);
+	compress_tfm = NULL;
+	kfree(compress_scratch);
+	compress_scratch = NULL;
+}
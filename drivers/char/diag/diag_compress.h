@@ -0,0 +1,61 @@
+/* Copyright (c) 2018, The Linux Foundation. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 and
+ * only version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef DIAG_COMPRESS_H
+#define DIAG_COMPRESS_H
+
+/*
+ * A compressed peripheral buffer goes out as one frame laid out like the
+ * non-HDLC packets, with its own version so the host tool can tell it
+ * apart: the header below, the LZ4 block of length bytes decompressing to
+ * raw_length bytes of non-HDLC packets, and a CONTROL_CHAR.
+ */
+#define DIAG_COMPRESS_VERSION	0x80
+
+struct diag_compress_frame_t {
+	uint8_t start;
+	uint8_t version;
+	uint16_t length;
+	uint16_t raw_length;
+} __packed;
+
+struct diag_compress_stats_t {
+	unsigned long compressed;
+	unsigned long skipped;
+	unsigned long raw_bytes;
+	unsigned long out_bytes;
+};
+
+#ifdef CONFIG_DIAG_COMPRESS
+extern struct diag_compress_stats_t diag_compress_stats;
+
+int diag_compress_init(void);
+void diag_compress_exit(void);
+int diag_compress_buf(unsigned char *dst, int dst_size,
+		      const unsigned char *src, int len);
+#else
+static inline int diag_compress_init(void)
+{
+	return 0;
+}
+
+static inline void diag_compress_exit(void)
+{
+}
+
+static inline int diag_compress_buf(unsigned char *dst, int dst_size,
+				    const unsigned char *src, int len)
+{
+	return 0;
+}
+#endif
+#endif
@@ -36,6 +36,7 @@
 #include "diagfwd_socket.h"
 #include "diagfwd_glink.h"
 #include "diag_debugfs.h"
+#include "diag_compress.h"
 #include "diag_ipc_logging.h"
 
 #define DEBUG_BUF_SIZE	4096
@@ -262,6 +263,42 @@ static ssize_t diag_dbgfs_read_power(struct file *file, char __user *ubuf,
 	return ret;
 }
 
+#ifdef CONFIG_DIAG_COMPRESS
+static ssize_t diag_dbgfs_read_compress(struct file *file, char __user *ubuf,
+					size_t count, loff_t *ppos)
+{
+	char *buf;
+	int ret;
+	unsigned int buf_size;
+
+	buf = kzalloc(sizeof(char) * DEBUG_BUF_SIZE, GFP_KERNEL);
+	if (!buf) {
+		pr_err("diag: %s, Error allocating memory\n", __func__);
+		return -ENOMEM;
+	}
+
+	buf_size = ksize(buf);
+	ret = scnprintf(buf, buf_size,
+		"Compressed buffers: %lu\n"
+		"Uncompressed buffers: %lu\n"
+		"Raw bytes: %lu\n"
+		"Compressed bytes: %lu\n",
+		diag_compress_stats.compressed,
+		diag_compress_stats.skipped,
+		diag_compress_stats.raw_bytes,
+		diag_compress_stats.out_bytes);
+
+	ret = simple_read_from_buffer(ubuf, count, ppos, buf, ret);
+
+	kfree(buf);
+	return ret;
+}
+
+const struct file_operations diag_dbgfs_compress_ops = {
+	.read = diag_dbgfs_read_compress,
+};
+#endif
+
 static ssize_t diag_dbgfs_read_table(struct file *file, char __user *ubuf,
 				     size_t count, loff_t *ppos)
 {
@@ -1152,6 +1189,13 @@ int diag_debugfs_init(void)
 	if (!entry)
 		goto err;
 
+#ifdef CONFIG_DIAG_COMPRESS
+	entry = debugfs_create_file("compress", 0444, diag_dbgfs_dent, 0,
+				    &diag_dbgfs_compress_ops);
+	if (!entry)
+		goto err;
+#endif
+
 #ifdef CONFIG_DIAGFWD_BRIDGE_CODE
 	entry = debugfs_create_file("bridge", 0444, diag_dbgfs_dent, 0,
 				    &diag_dbgfs_bridge_ops);
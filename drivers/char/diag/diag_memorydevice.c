@@ -22,6 +22,9 @@
 #include <linux/delay.h>
 #include <linux/kmemleak.h>
 #include <linux/uaccess.h>
+#include <linux/mm.h>
+#include <linux/vmalloc.h>
+#include <linux/log2.h>
 #include "diagchar.h"
 #include "diag_memorydevice.h"
 #include "diagfwd_bridge.h"
@@ -129,6 +132,67 @@ void diag_md_close_all()
 	diag_ws_reset(DIAG_WS_MUX);
 }
 
+static uint32_t diag_md_ring_used(struct diag_md_ring *ring)
+{
+	uint64_t used = ring->hdr->head - READ_ONCE(ring->hdr->tail);
+
+	/* The tail is written by user space, never trust it */
+	return used > ring->size ? ring->size : (uint32_t)used;
+}
+
+/*
+ * Append a buffer to the ring of the session it belongs to. Returns 0 or
+ * -ENOSPC if the ring is full, in which case the buffer is dropped and
+ * accounted in the header.
+ */
+static int diag_md_ring_write(struct diag_md_ring *ring, int id,
+			      unsigned char *buf, int len)
+{
+	struct diag_md_ring_rec *rec;
+	uint32_t need, pos, room, pad = 0;
+	unsigned long flags;
+	int err = 0;
+
+	need = ALIGN(sizeof(*rec) + len, sizeof(uint64_t));
+
+	spin_lock_irqsave(&ring->lock, flags);
+	pos = ring->hdr->head & (ring->size - 1);
+	room = ring->size - pos;
+	if (room < need)
+		pad = room;
+
+	if (ring->closed || need > ring->size ||
+	    diag_md_ring_used(ring) + pad + need > ring->size) {
+		ring->hdr->dropped++;
+		err = -ENOSPC;
+		goto out;
+	}
+	/* Order the tail read above before overwriting the space it freed */
+	smp_mb();
+
+	if (pad) {
+		rec = (struct diag_md_ring_rec *)(ring->data + pos);
+		rec->len = DIAG_MD_RING_PAD;
+		rec->remote_token = 0;
+		pos = 0;
+	}
+
+	rec = (struct diag_md_ring_rec *)(ring->data + pos);
+	rec->len = len;
+	rec->remote_token = id > 0 ? diag_get_remote(id) : 0;
+	memcpy(rec + 1, buf, len);
+
+	/* Publish the record before the head moving past it */
+	smp_wmb();
+	ring->hdr->head += pad + need;
+
+	if (diag_md_ring_used(ring) >= ring->wake_threshold)
+		wake_up_interruptible(&ring->wait_q);
+out:
+	spin_unlock_irqrestore(&ring->lock, flags);
+	return err;
+}
+
 int diag_md_write(int id, unsigned char *buf, int len, int ctx)
 {
 	int i, pid = 0;
@@ -156,11 +220,27 @@ int diag_md_write(int id, unsigned char *buf, int len, int ctx)
 		return -EIO;
 	}
 	pid = session_info->pid;
-	mutex_unlock(&driver->md_session_lock);
 
 	ch = &diag_md[id];
-	if (!ch)
-		return -EINVAL;
+
+	/*
+	 * A session consuming its data through the ring gets it copied in
+	 * right away, so the buffer goes back to its owner without waiting
+	 * for a read() and the table never fills up.
+	 */
+	if (session_info->ring) {
+		diag_md_ring_write(session_info->ring, id, buf, len);
+		mutex_unlock(&driver->md_session_lock);
+
+		diag_ws_on_read(DIAG_WS_MUX, len);
+		if (ch->ops && ch->ops->write_done)
+			ch->ops->write_done(buf, len, ctx,
+					    DIAG_MEMORY_DEVICE_MODE);
+		diag_ws_on_copy(DIAG_WS_MUX);
+		diag_ws_on_copy_complete(DIAG_WS_MUX);
+		return 0;
+	}
+	mutex_unlock(&driver->md_session_lock);
 
 	spin_lock_irqsave(&ch->lock, flags);
 	for (i = 0; i < ch->num_tbl_entries && !found; i++) {
@@ -345,6 +425,164 @@ drop_data:
 	return err;
 }
 
+static void diag_md_ring_free(struct kref *kref)
+{
+	struct diag_md_ring *ring = container_of(kref, struct diag_md_ring,
+						 kref);
+
+	vfree(ring->hdr);
+	kfree(ring);
+}
+
+struct diag_md_ring *diag_md_ring_get(struct diag_md_session_t *info)
+{
+	struct diag_md_ring *ring = info ? info->ring : NULL;
+
+	if (ring)
+		kref_get(&ring->kref);
+	return ring;
+}
+
+void diag_md_ring_put(struct diag_md_ring *ring)
+{
+	if (ring)
+		kref_put(&ring->kref, diag_md_ring_free);
+}
+
+/**
+ * diag_md_ring_create() - Set up the ring of a memory device session
+ * @info: the session, with md_session_lock held
+ * @config: ring size in bytes, rounded up to a power of two, and the
+ *	number of pending bytes waking up the session owner
+ */
+int diag_md_ring_create(struct diag_md_session_t *info,
+			struct diag_md_ring_config *config)
+{
+	struct diag_md_ring *ring;
+	uint32_t size;
+
+	if (!info)
+		return -EINVAL;
+	if (info->ring)
+		return -EBUSY;
+	if (config->size < DIAG_MD_RING_MIN_SIZE ||
+	    config->size > DIAG_MD_RING_MAX_SIZE)
+		return -EINVAL;
+
+	size = roundup_pow_of_two(config->size);
+
+	ring = kzalloc(sizeof(*ring), GFP_KERNEL);
+	if (!ring)
+		return -ENOMEM;
+
+	ring->hdr = vmalloc_user(PAGE_SIZE + size);
+	if (!ring->hdr) {
+		kfree(ring);
+		return -ENOMEM;
+	}
+
+	kref_init(&ring->kref);
+	spin_lock_init(&ring->lock);
+	init_waitqueue_head(&ring->wait_q);
+	ring->data = (unsigned char *)ring->hdr + PAGE_SIZE;
+	ring->size = size;
+	ring->wake_threshold = clamp_t(uint32_t, config->wake_threshold, 1,
+				       size / 2);
+
+	ring->hdr->version = DIAG_MD_RING_VERSION;
+	ring->hdr->data_offset = PAGE_SIZE;
+	ring->hdr->data_size = size;
+
+	info->ring = ring;
+	return 0;
+}
+
+/**
+ * diag_md_ring_release() - Detach the ring from a closing session
+ * @info: the session, with md_session_lock held
+ *
+ * The memory stays around until the last mapping of it goes away.
+ */
+void diag_md_ring_release(struct diag_md_session_t *info)
+{
+	struct diag_md_ring *ring = info->ring;
+	unsigned long flags;
+
+	if (!ring)
+		return;
+
+	spin_lock_irqsave(&ring->lock, flags);
+	ring->closed = 1;
+	spin_unlock_irqrestore(&ring->lock, flags);
+	wake_up_interruptible(&ring->wait_q);
+
+	info->ring = NULL;
+	diag_md_ring_put(ring);
+}
+
+static void diag_md_ring_vm_open(struct vm_area_struct *vma)
+{
+	struct diag_md_ring *ring = vma->vm_private_data;
+
+	kref_get(&ring->kref);
+}
+
+static void diag_md_ring_vm_close(struct vm_area_struct *vma)
+{
+	diag_md_ring_put(vma->vm_private_data);
+}
+
+static const struct vm_operations_struct diag_md_ring_vm_ops = {
+	.open = diag_md_ring_vm_open,
+	.close = diag_md_ring_vm_close,
+};
+
+int diag_md_ring_mmap(struct diag_md_session_t *info,
+		      struct vm_area_struct *vma)
+{
+	struct diag_md_ring *ring = info ? info->ring : NULL;
+	int err;
+
+	if (!ring)
+		return -ENODEV;
+	if (vma->vm_pgoff ||
+	    vma->vm_end - vma->vm_start != PAGE_SIZE + ring->size)
+		return -EINVAL;
+
+	err = remap_vmalloc_range(vma, ring->hdr, 0);
+	if (err)
+		return err;
+
+	vma->vm_private_data = ring;
+	vma->vm_ops = &diag_md_ring_vm_ops;
+	diag_md_ring_vm_open(vma);
+	return 0;
+}
+
+/**
+ * diag_md_ring_wait() - Wait for data in the ring
+ * @ring: the ring, referenced by the caller
+ * @timeout_ms: longest time to wait for the wake up threshold to be met
+ *
+ * Returns the number of bytes pending, which may be below the threshold
+ * on timeout, or a negative error code.
+ */
+long diag_md_ring_wait(struct diag_md_ring *ring, unsigned int timeout_ms)
+{
+	long ret;
+
+	ret = wait_event_interruptible_timeout(ring->wait_q,
+			ring->closed ||
+			diag_md_ring_used(ring) >= ring->wake_threshold,
+			msecs_to_jiffies(timeout_ms));
+	if (ret < 0)
+		return ret;
+	if (ring->closed)
+		return -ENODEV;
+
+	return diag_md_ring_used(ring);
+}
+
 int diag_md_close_peripheral(int id, uint8_t peripheral)
 {
 	int i;
@@ -13,6 +13,9 @@
 #ifndef DIAG_MEMORYDEVICE_H
 #define DIAG_MEMORYDEVICE_H
 
+#include <linux/kref.h>
+#include <linux/wait.h>
+
 #define DIAG_MD_LOCAL		0
 #define DIAG_MD_LOCAL_LAST	1
 #define DIAG_MD_BRIDGE_BASE	DIAG_MD_LOCAL_LAST
@@ -33,6 +36,54 @@ struct diag_buf_tbl_t {
 	int ctx;
 };
 
+/*
+ * Memory device ring
+ *
+ * Instead of read(), a memory device session can consume its data from a
+ * ring mapped with mmap() on the diag device. The first page holds the
+ * header, the data area follows. Records are 8 byte aligned and never
+ * wrap: a record with DIAG_MD_RING_PAD as length fills the end of the
+ * data area when the next one does not fit. head and tail are free
+ * running byte counts, the kernel advances head and the session owner
+ * advances tail once it is done with the records in between.
+ */
+#define DIAG_MD_RING_VERSION	1
+#define DIAG_MD_RING_PAD	0xFFFFFFFF
+#define DIAG_MD_RING_MIN_SIZE	(64 * 1024)
+#define DIAG_MD_RING_MAX_SIZE	(16 * 1024 * 1024)
+
+struct diag_md_ring_config {
+	uint32_t size;
+	uint32_t wake_threshold;
+} __packed;
+
+struct diag_md_ring_header {
+	uint32_t version;
+	uint32_t data_offset;
+	uint32_t data_size;
+	uint32_t reserved;
+	uint64_t head;
+	uint64_t tail;
+	uint64_t dropped;
+} __packed;
+
+struct diag_md_ring_rec {
+	uint32_t len;
+	/* 0 for local data, the remote token otherwise */
+	int32_t remote_token;
+} __packed;
+
+struct diag_md_ring {
+	struct kref kref;
+	spinlock_t lock;
+	wait_queue_head_t wait_q;
+	struct diag_md_ring_header *hdr;
+	unsigned char *data;
+	uint32_t size;
+	uint32_t wake_threshold;
+	int closed;
+};
+
 struct diag_md_info {
 	int id;
 	int ctx;
@@ -54,4 +105,12 @@ int diag_md_close_peripheral(int id, uint8_t peripheral);
 int diag_md_write(int id, unsigned char *buf, int len, int ctx);
 int diag_md_copy_to_user(char __user *buf, int *pret, size_t buf_size,
 			 struct diag_md_session_t *info);
+int diag_md_ring_create(struct diag_md_session_t *info,
+			struct diag_md_ring_config *config);
+void diag_md_ring_release(struct diag_md_session_t *info);
+int diag_md_ring_mmap(struct diag_md_session_t *info,
+		      struct vm_area_struct *vma);
+struct diag_md_ring *diag_md_ring_get(struct diag_md_session_t *info);
+void diag_md_ring_put(struct diag_md_ring *ring);
+long diag_md_ring_wait(struct diag_md_ring *ring, unsigned int timeout_ms);
 #endif
@@ -42,6 +42,7 @@
 #include "diag_mux.h"
 #include "diag_ipc_logging.h"
 #include "diagfwd_peripheral.h"
+#include "diag_compress.h"
 
 #include <linux/coresight-stm.h>
 #include <linux/kernel.h>
@@ -1505,6 +1506,7 @@ static void diag_md_session_exit(void)
 			diag_event_mask_free(session_info->event_mask);
 			kfree(session_info->event_mask);
 			session_info->event_mask = NULL;
+			diag_md_ring_release(session_info);
 			kfree(session_info);
 			session_info = NULL;
 			driver->md_session_map[i] = NULL;
@@ -1646,6 +1648,7 @@ static void diag_md_session_close(int pid)
 	kfree(session_info->event_mask);
 	session_info->event_mask = NULL;
 	del_timer(&session_info->hdlc_reset_timer);
+	diag_md_ring_release(session_info);
 
 	for (i = 0; i < NUM_MD_SESSIONS && !found; i++) {
 		if (driver->md_session_map[i] != NULL)
@@ -2435,6 +2438,39 @@ static int diag_ioctl_cmd_dereg(void)
 	return 0;
 }
 
+static int diag_ioctl_md_ring_config(unsigned long ioarg)
+{
+	struct diag_md_ring_config config;
+	int err;
+
+	if (copy_from_user(&config, (void __user *)ioarg, sizeof(config)))
+		return -EFAULT;
+
+	mutex_lock(&driver->md_session_lock);
+	err = diag_md_ring_create(diag_md_session_get_pid(current->tgid),
+				  &config);
+	mutex_unlock(&driver->md_session_lock);
+
+	return err;
+}
+
+static long diag_ioctl_md_ring_wait(unsigned long ioarg)
+{
+	struct diag_md_ring *ring;
+	long ret;
+
+	mutex_lock(&driver->md_session_lock);
+	ring = diag_md_ring_get(diag_md_session_get_pid(current->tgid));
+	mutex_unlock(&driver->md_session_lock);
+	if (!ring)
+		return -ENODEV;
+
+	ret = diag_md_ring_wait(ring, (unsigned int)ioarg);
+	diag_md_ring_put(ring);
+
+	return ret;
+}
+
 #ifdef CONFIG_COMPAT
 /*
  * @sync_obj_name: name of the synchronization object associated with this proc
@@ -2608,6 +2644,12 @@ long diagchar_compat_ioctl(struct file *filp,
 			return -EFAULT;
 		result = diag_ioctl_query_pd_logging(&mode_param);
 		break;
+	case DIAG_IOCTL_MD_RING_CONFIG:
+		result = diag_ioctl_md_ring_config(ioarg);
+		break;
+	case DIAG_IOCTL_MD_RING_WAIT:
+		result = diag_ioctl_md_ring_wait(ioarg);
+		break;
 	}
 	return result;
 }
@@ -2756,6 +2798,12 @@ long diagchar_ioctl(struct file *filp,
 			return -EFAULT;
 		result = diag_ioctl_query_pd_logging(&mode_param);
 		break;
+	case DIAG_IOCTL_MD_RING_CONFIG:
+		result = diag_ioctl_md_ring_config(ioarg);
+		break;
+	case DIAG_IOCTL_MD_RING_WAIT:
+		result = diag_ioctl_md_ring_wait(ioarg);
+		break;
 	}
 	return result;
 }
@@ -3877,6 +3925,17 @@ static int diag_real_time_info_init(void)
 	return 0;
 }
 
+static int diagchar_mmap(struct file *file, struct vm_area_struct *vma)
+{
+	int err;
+
+	mutex_lock(&driver->md_session_lock);
+	err = diag_md_ring_mmap(diag_md_session_get_pid(current->tgid), vma);
+	mutex_unlock(&driver->md_session_lock);
+
+	return err;
+}
+
 static const struct file_operations diagcharfops = {
 	.owner = THIS_MODULE,
 	.read = diagchar_read,
@@ -3885,6 +3944,7 @@ static const struct file_operations diagcharfops = {
 	.compat_ioctl = diagchar_compat_ioctl,
 #endif
 	.unlocked_ioctl = diagchar_ioctl,
+	.mmap = diagchar_mmap,
 	.open = diagchar_open,
 	.release = diagchar_close
 };
@@ -4099,6 +4159,8 @@ static int __init diagchar_init(void)
 	if (ret)
 		goto fail;
 	driver->dci_state = diag_dci_init();
+	if (diag_compress_init())
+		pr_warn("diag: compression not available\n");
 	ret = diagfwd_peripheral_init();
 	if (ret)
 		goto fail;
@@ -4134,6 +4196,7 @@ fail:
 	diagchar_cleanup();
 	diag_mux_exit();
 	diagfwd_peripheral_exit();
+	diag_compress_exit();
 	diagfwd_bridge_exit();
 	diagfwd_exit();
 	diagfwd_cntl_exit();
@@ -4148,6 +4211,7 @@ static void diagchar_exit(void)
 	diag_mempool_exit();
 	diag_mux_exit();
 	diagfwd_peripheral_exit();
+	diag_compress_exit();
 	diagfwd_exit();
 	diagfwd_cntl_exit();
 	diag_dci_exit();
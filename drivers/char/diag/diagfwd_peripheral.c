@@ -32,6 +32,7 @@
 #include "diag_ipc_logging.h"
 #include "diagfwd_glink.h"
 #include "diag_memorydevice.h"
+#include "diag_compress.h"
 
 struct data_header {
 	uint8_t control_char;
@@ -278,6 +279,25 @@ int diag_md_get_peripheral(int ctxt)
 	return peripheral;
 }
 
+/*
+ * Replace the raw data of a buffer sent without HDLC encoding by its
+ * compressed frame, built in the encoding buffer that is unused then.
+ */
+static void diagfwd_compress(struct diagfwd_buf_t *buf,
+			     unsigned char **write_buf, int *write_len)
+{
+	int len;
+
+	if (!buf->data)
+		return;
+
+	len = diag_compress_buf(buf->data, buf->len, *write_buf, *write_len);
+	if (len > 0) {
+		*write_buf = buf->data;
+		*write_len = len;
+	}
+}
+
 static void diagfwd_data_process_done(struct diagfwd_info *fwd_info,
 				   struct diagfwd_buf_t *buf, int len)
 {
@@ -341,6 +361,7 @@ static void diagfwd_data_process_done(struct diagfwd_info *fwd_info,
 		if (write_len <= 0)
 			goto end;
 		write_buf = buf->data_raw;
+		diagfwd_compress(buf, &write_buf, &write_len);
 	} else {
 		if (!buf) {
 			pr_err("diag: In %s, no match for non encode buffer %pK, peripheral %d, type: %d\n",
@@ -681,6 +702,7 @@ static void diagfwd_data_read_done(struct diagfwd_info *fwd_info,
 		}
 		write_len = len;
 		write_buf = buf;
+		diagfwd_compress(temp_buf, &write_buf, &write_len);
 	} else {
 		if (fwd_info->buf_1 && fwd_info->buf_1->data_raw == buf) {
 			temp_buf = fwd_info->buf_1;
@@ -29,6 +29,8 @@
 #include <linux/cdev.h>
 #include <linux/delay.h>
 #include <linux/crypto.h>
+#include <linux/percpu.h>
+#include <linux/workqueue.h>
 #include <crypto/internal/rng.h>
 
 #include <linux/platform_data/qcom_crypto_device.h>
@@ -52,14 +54,37 @@
 #define MAX_HW_FIFO_DEPTH 16                     /* FIFO is 16 words deep */
 #define MAX_HW_FIFO_SIZE (MAX_HW_FIFO_DEPTH * 4) /* FIFO is 32 bits wide  */
 
+/* bytes of random data buffered per CPU, refilled once half is used */
+#define MSM_RNG_PCPU_BUF_SIZE	512
+
 struct msm_rng_device {
 	struct platform_device *pdev;
 	void __iomem *base;
 	struct clk *prng_clk;
 	uint32_t qrng_perf_client;
 	struct mutex rng_lock;
+	struct work_struct refill_work;
+	u32 refill_buf[MSM_RNG_PCPU_BUF_SIZE / 4];
 };
 
+/*
+ * Random data read ahead from the h/w. The unread bytes are the last
+ * 'avail' bytes of 'data'; readers take from the front of them and the
+ * refill work prepends to them.
+ */
+struct msm_rng_pcpu_buf {
+	spinlock_t lock;
+	unsigned int avail;
+	u8 data[MSM_RNG_PCPU_BUF_SIZE];
+};
+
+static DEFINE_PER_CPU(struct msm_rng_pcpu_buf, msm_rng_pcpu_buf);
+
+static bool pcpu_buffer = true;
+module_param(pcpu_buffer, bool, 0644);
+MODULE_PARM_DESC(pcpu_buffer,
+	"serve reads from per-CPU buffers filled in the background");
+
 struct msm_rng_device msm_rng_device_info;
 static struct msm_rng_device *msm_rng_dev_cached;
 struct mutex cached_rng_lock;
@@ -83,31 +108,10 @@ static long msm_rng_ioctl(struct file *filp, unsigned int cmd,
 	return ret;
 }
 
-/*
- *
- *  This function calls hardware random bit generator directory and retuns it
- *  back to caller
- *
- */
-static int msm_rng_direct_read(struct msm_rng_device *msm_rng_dev,
-					void *data, size_t max)
+/* vote for the bus and the PRNG clock, with rng_lock held */
+static int msm_rng_hw_get(struct msm_rng_device *msm_rng_dev)
 {
-	struct platform_device *pdev;
-	void __iomem *base;
-	size_t currsize = 0;
-	u32 val;
-	u32 *retdata = data;
 	int ret;
-	int failed = 0;
-
-	pdev = msm_rng_dev->pdev;
-	base = msm_rng_dev->base;
-
-	/* no room for word data */
-	if (max < 4)
-		return 0;
-
-	mutex_lock(&msm_rng_dev->rng_lock);
 
 	if (msm_rng_dev->qrng_perf_client) {
 		ret = msm_bus_scale_client_update_request(
@@ -118,9 +122,43 @@ static int msm_rng_direct_read(struct msm_rng_device *msm_rng_dev,
 	/* enable PRNG clock */
 	ret = clk_prepare_enable(msm_rng_dev->prng_clk);
 	if (ret) {
-		dev_err(&pdev->dev, "failed to enable clock in callback\n");
-		goto err;
+		dev_err(&msm_rng_dev->pdev->dev,
+			"failed to enable clock in callback\n");
+		if (msm_rng_dev->qrng_perf_client)
+			msm_bus_scale_client_update_request(
+				msm_rng_dev->qrng_perf_client, 0);
 	}
+	return ret;
+}
+
+static void msm_rng_hw_put(struct msm_rng_device *msm_rng_dev)
+{
+	int ret;
+
+	/* vote to turn off clock */
+	clk_disable_unprepare(msm_rng_dev->prng_clk);
+	if (msm_rng_dev->qrng_perf_client) {
+		ret = msm_bus_scale_client_update_request(
+				msm_rng_dev->qrng_perf_client, 0);
+		if (ret)
+			pr_err("bus_scale_client_update_req failed!\n");
+	}
+}
+
+/* read whole words from the FIFO, with the h/w voted on */
+static size_t msm_rng_fifo_read(struct msm_rng_device *msm_rng_dev,
+					void *data, size_t max)
+{
+	void __iomem *base = msm_rng_dev->base;
+	size_t currsize = 0;
+	u32 val;
+	u32 *retdata = data;
+	int failed = 0;
+
+	/* no room for word data */
+	if (max < 4)
+		return 0;
+
 	/* read random data from h/w */
 	do {
 		/* check status bit if data is available */
@@ -149,27 +187,123 @@ static int msm_rng_direct_read(struct msm_rng_device *msm_rng_dev,
 
 	} while (currsize < max);
 
-	/* vote to turn off clock */
-	clk_disable_unprepare(msm_rng_dev->prng_clk);
-err:
-	if (msm_rng_dev->qrng_perf_client) {
-		ret = msm_bus_scale_client_update_request(
-				msm_rng_dev->qrng_perf_client, 0);
-		if (ret)
-			pr_err("bus_scale_client_update_req failed!\n");
+	val = 0L;
+	return currsize;
+}
+
+/*
+ *
+ *  This function calls hardware random bit generator directory and retuns it
+ *  back to caller
+ *
+ */
+static int msm_rng_direct_read(struct msm_rng_device *msm_rng_dev,
+					void *data, size_t max)
+{
+	size_t currsize = 0;
+
+	/* no room for word data */
+	if (max < 4)
+		return 0;
+
+	mutex_lock(&msm_rng_dev->rng_lock);
+	if (!msm_rng_hw_get(msm_rng_dev)) {
+		currsize = msm_rng_fifo_read(msm_rng_dev, data, max);
+		msm_rng_hw_put(msm_rng_dev);
 	}
 	mutex_unlock(&msm_rng_dev->rng_lock);
 
-	val = 0L;
 	return currsize;
 }
+
+/*
+ * Tops up the buffer of every CPU that has used half of it, under a single
+ * bus and clock vote.
+ */
+static void msm_rng_refill_work(struct work_struct *work)
+{
+	struct msm_rng_device *msm_rng_dev = container_of(work,
+				struct msm_rng_device, refill_work);
+	struct msm_rng_pcpu_buf *buf;
+	bool voted = false;
+	size_t len;
+	int cpu;
+
+	mutex_lock(&msm_rng_dev->rng_lock);
+	for_each_online_cpu(cpu) {
+		buf = per_cpu_ptr(&msm_rng_pcpu_buf, cpu);
+		len = MSM_RNG_PCPU_BUF_SIZE - READ_ONCE(buf->avail);
+		if (len < MSM_RNG_PCPU_BUF_SIZE / 2)
+			continue;
+
+		if (!voted) {
+			if (msm_rng_hw_get(msm_rng_dev))
+				break;
+			voted = true;
+		}
+		len = msm_rng_fifo_read(msm_rng_dev, msm_rng_dev->refill_buf,
+					len);
+
+		spin_lock(&buf->lock);
+		len = min_t(size_t, len, MSM_RNG_PCPU_BUF_SIZE - buf->avail);
+		buf->avail += len;
+		memcpy(buf->data + MSM_RNG_PCPU_BUF_SIZE - buf->avail,
+		       msm_rng_dev->refill_buf, len);
+		spin_unlock(&buf->lock);
+	}
+	if (voted)
+		msm_rng_hw_put(msm_rng_dev);
+	memzero_explicit(msm_rng_dev->refill_buf,
+			 sizeof(msm_rng_dev->refill_buf));
+	mutex_unlock(&msm_rng_dev->rng_lock);
+}
+
+/* whole words from this CPU's buffer, without touching the h/w */
+static size_t msm_rng_pcpu_read(struct msm_rng_device *msm_rng_dev,
+					void *data, size_t max)
+{
+	struct msm_rng_pcpu_buf *buf;
+	size_t len;
+	u8 *src;
+	bool low;
+
+	buf = get_cpu_ptr(&msm_rng_pcpu_buf);
+	spin_lock(&buf->lock);
+	len = min_t(size_t, max, buf->avail) & ~3;
+	src = buf->data + MSM_RNG_PCPU_BUF_SIZE - buf->avail;
+	memcpy(data, src, len);
+	memzero_explicit(src, len);
+	buf->avail -= len;
+	low = buf->avail < MSM_RNG_PCPU_BUF_SIZE / 2;
+	spin_unlock(&buf->lock);
+	put_cpu_ptr(&msm_rng_pcpu_buf);
+
+	if (low)
+		schedule_work(&msm_rng_dev->refill_work);
+	return len;
+}
+
+/* serve from the per-CPU buffer, the h/w is only read on underrun */
+static int msm_rng_get(struct msm_rng_device *msm_rng_dev,
+					void *data, size_t max)
+{
+	size_t len = 0;
+
+	if (pcpu_buffer)
+		len = msm_rng_pcpu_read(msm_rng_dev, data, max);
+	if (max - len >= 4)
+		len += msm_rng_direct_read(msm_rng_dev, (u8 *)data + len,
+					   max - len);
+	return len;
+}
+
 static int msm_rng_read(struct hwrng *rng, void *data, size_t max, bool wait)
 {
 	struct msm_rng_device *msm_rng_dev;
 	int rv = 0;
 
 	msm_rng_dev = (struct msm_rng_device *)rng->priv;
-	rv = msm_rng_direct_read(msm_rng_dev, data, max);
+	rv = msm_rng_get(msm_rng_dev, data, max);
 
 	return rv;
 }
@@ -250,6 +384,7 @@ static int msm_rng_probe(struct platform_device *pdev)
 	bool configure_qrng = true;
 	int error = 0;
 	int ret = 0;
+	int cpu;
 	struct device *dev;
 
 	struct msm_bus_scale_pdata *qrng_platform_support = NULL;
@@ -318,6 +453,9 @@ static int msm_rng_probe(struct platform_device *pdev)
 
 	mutex_init(&msm_rng_dev->rng_lock);
 	mutex_init(&cached_rng_lock);
+	INIT_WORK(&msm_rng_dev->refill_work, msm_rng_refill_work);
+	for_each_possible_cpu(cpu)
+		spin_lock_init(&per_cpu_ptr(&msm_rng_pcpu_buf, cpu)->lock);
 
 	/* register with hwrng framework */
 	msm_rng.priv = (unsigned long) msm_rng_dev;
@@ -344,6 +482,8 @@ static int msm_rng_probe(struct platform_device *pdev)
 	}
 	cdev_init(&msm_rng_cdev, &msm_rng_fops);
 	msm_rng_dev_cached = msm_rng_dev;
+	if (pcpu_buffer)
+		schedule_work(&msm_rng_dev->refill_work);
 	return error;
 
 unregister_chrdev:
@@ -361,9 +501,19 @@ err_exit:
 static int msm_rng_remove(struct platform_device *pdev)
 {
 	struct msm_rng_device *msm_rng_dev = platform_get_drvdata(pdev);
+	int cpu;
 
 	unregister_chrdev(QRNG_IOC_MAGIC, DRIVER_NAME);
 	hwrng_unregister(&msm_rng);
+	msm_rng_dev_cached = NULL;
+	cancel_work_sync(&msm_rng_dev->refill_work);
+	for_each_possible_cpu(cpu) {
+		struct msm_rng_pcpu_buf *buf = per_cpu_ptr(&msm_rng_pcpu_buf,
+							   cpu);
+
+		memzero_explicit(buf->data, sizeof(buf->data));
+		buf->avail = 0;
+	}
 	clk_put(msm_rng_dev->prng_clk);
 	iounmap(msm_rng_dev->base);
 	platform_set_drvdata(pdev, NULL);
@@ -371,7 +521,6 @@ static int msm_rng_remove(struct platform_device *pdev)
 		msm_bus_scale_unregister_client(msm_rng_dev->qrng_perf_client);
 
 	kzfree(msm_rng_dev);
-	msm_rng_dev_cached = NULL;
 	return 0;
 }
 
@@ -400,7 +549,7 @@ static int qrng_get_random(struct crypto_rng *tfm, const u8 *src,
 		rv = -ERESTARTSYS;
 		goto err_exit;
 	}
-	sizeread = msm_rng_direct_read(msm_rng_dev_cached, rdata, dlen);
+	sizeread = msm_rng_get(msm_rng_dev_cached, rdata, dlen);
 
 	if (sizeread == dlen)
 		rv = 0;
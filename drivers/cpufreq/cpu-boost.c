@@ -16,6 +16,8 @@
 #include <linux/kernel.h>
 #include <linux/init.h>
 #include <linux/cpufreq.h>
+#include <linux/cpufreq_arbiter.h>
+#include <linux/cpu_boost.h>
 #include <linux/cpu.h>
 #include <linux/sched.h>
 #include <linux/moduleparam.h>
@@ -24,10 +26,10 @@
 #include <linux/time.h>
 #include <linux/kthread.h>
 #include <linux/sched/rt.h>
+#include <linux/wake_intent.h>
 
 struct cpu_sync {
 	int cpu;
-	unsigned int input_boost_min;
 	unsigned int input_boost_freq;
 };
 
@@ -45,11 +47,19 @@ static int dynamic_stune_boost;
 module_param(dynamic_stune_boost, uint, 0644);
 #endif /* CONFIG_DYNAMIC_STUNE_BOOST */
 
+static struct kthread_work wake_boost_work;
+static unsigned int wake_boost_ms = 500;
+module_param(wake_boost_ms, uint, 0644);
+
 static struct delayed_work input_boost_rem;
 static u64 last_input_time;
 
+static struct freq_arb_client *input_boost_client;
+static struct freq_arb_client *wake_boost_client;
+
 static struct kthread_worker cpu_boost_worker;
 static struct task_struct *cpu_boost_worker_thread;
+static bool cpu_boost_ready;
 
 #define MIN_INPUT_INTERVAL (150 * USEC_PER_MSEC)
 
@@ -111,81 +121,13 @@ static const struct kernel_param_ops param_ops_input_boost_freq = {
 };
 module_param_cb(input_boost_freq, &param_ops_input_boost_freq, NULL, 0644);
 
-/*
- * The CPUFREQ_ADJUST notifier is used to override the current policy min to
- * make sure policy min >= boost_min. The cpufreq framework then does the job
- * of enforcing the new policy.
- *
- * The sync kthread needs to run on the CPU in question to avoid deadlocks in
- * the wake up code. Achieve this by binding the thread to the respective
- * CPU. But a CPU going offline unbinds threads from that CPU. So, set it up
- * again each time the CPU comes back up. We can use CPUFREQ_START to figure
- * out a CPU is coming online instead of registering for hotplug notifiers.
- */
-static int boost_adjust_notify(struct notifier_block *nb, unsigned long val,
-				void *data)
-{
-	struct cpufreq_policy *policy = data;
-	unsigned int cpu = policy->cpu;
-	struct cpu_sync *s = &per_cpu(sync_info, cpu);
-	unsigned int ib_min = s->input_boost_min;
-
-	switch (val) {
-	case CPUFREQ_ADJUST:
-		if (!ib_min)
-			break;
-
-		pr_debug("CPU%u policy min before boost: %u kHz\n",
-			 cpu, policy->min);
-		pr_debug("CPU%u boost min: %u kHz\n", cpu, ib_min);
-
-		cpufreq_verify_within_limits(policy, ib_min, UINT_MAX);
-
-		pr_debug("CPU%u policy min after boost: %u kHz\n",
-			 cpu, policy->min);
-		break;
-	}
-
-	return NOTIFY_OK;
-}
-
-static struct notifier_block boost_adjust_nb = {
-	.notifier_call = boost_adjust_notify,
-};
-
-static void update_policy_online(void)
-{
-	unsigned int i;
-
-	/* Re-evaluate policy to trigger adjust notifier for online CPUs */
-	get_online_cpus();
-	for_each_online_cpu(i) {
-		pr_debug("Updating policy for CPU%d\n", i);
-		cpufreq_update_policy(i);
-	}
-	put_online_cpus();
-}
-
+/* The frequency vote expires on its own in the arbiter */
 static void do_input_boost_rem(struct work_struct *work)
 {
-	unsigned int i;
-	struct cpu_sync *i_sync_info;
-
-	/* Reset the input_boost_min for all CPUs in the system */
-	pr_debug("Resetting input boost min for all CPUs\n");
-	for_each_possible_cpu(i) {
-		i_sync_info = &per_cpu(sync_info, i);
-		i_sync_info->input_boost_min = 0;
-	}
-
 #ifdef CONFIG_DYNAMIC_STUNE_BOOST
 	/* Reset dynamic stune boost value to the default value */
 	reset_stune_boost("top-app");
 #endif /* CONFIG_DYNAMIC_STUNE_BOOST */
-
-	/* Update policies for all online CPUs */
-	update_policy_online();
-
 }
 
 static void do_input_boost(struct kthread_work *work)
@@ -195,15 +137,14 @@ static void do_input_boost(struct kthread_work *work)
 
 	cancel_delayed_work_sync(&input_boost_rem);
 
-	/* Set the input_boost_min for all CPUs in the system */
+	/* Vote input_boost_freq as the min for all CPUs in the system */
 	pr_debug("Setting input boost min for all CPUs\n");
 	for_each_possible_cpu(i) {
 		i_sync_info = &per_cpu(sync_info, i);
-		i_sync_info->input_boost_min = i_sync_info->input_boost_freq;
+		freq_arb_set_min(input_boost_client, i,
+				 i_sync_info->input_boost_freq);
 	}
-
-	/* Update policies for all online CPUs */
-	update_policy_online();
+	freq_arb_apply(input_boost_client, input_boost_ms);
 
 #ifdef CONFIG_DYNAMIC_STUNE_BOOST
 	/* Set dynamic stune boost value */
@@ -213,12 +154,12 @@ static void do_input_boost(struct kthread_work *work)
 	schedule_delayed_work(&input_boost_rem, msecs_to_jiffies(input_boost_ms));
 }
 
-static void cpuboost_input_event(struct input_handle *handle,
-		unsigned int type, unsigned int code, int value)
+void cpuboost_kick(void)
 {
 	u64 now;
 
-	if (!input_boost_enabled)
+	/* drivers may kick before the worker exists */
+	if (!input_boost_enabled || !cpu_boost_ready)
 		return;
 
 	now = ktime_to_us(ktime_get());
@@ -231,6 +172,39 @@ static void cpuboost_input_event(struct input_handle *handle,
 	queue_kthread_work(&cpu_boost_worker, &input_boost_work);
 	last_input_time = ktime_to_us(ktime_get());
 }
+EXPORT_SYMBOL_GPL(cpuboost_kick);
+
+/*
+ * A wake intent means the display and touch are about to resume, boost
+ * for long enough to cover that rather than for a single input event.
+ */
+static void do_wake_boost(struct kthread_work *work)
+{
+	unsigned int i;
+
+	for_each_possible_cpu(i)
+		freq_arb_set_min(wake_boost_client, i,
+				 per_cpu(sync_info, i).input_boost_freq);
+	freq_arb_apply(wake_boost_client, wake_boost_ms);
+}
+
+static int cpuboost_wake_intent(struct notifier_block *nb,
+				unsigned long source, void *data)
+{
+	if (input_boost_enabled && wake_boost_ms && cpu_boost_ready)
+		queue_kthread_work(&cpu_boost_worker, &wake_boost_work);
+	return NOTIFY_OK;
+}
+
+static struct notifier_block cpuboost_wake_intent_nb = {
+	.notifier_call = cpuboost_wake_intent,
+};
+
+static void cpuboost_input_event(struct input_handle *handle,
+		unsigned int type, unsigned int code, int value)
+{
+	cpuboost_kick();
+}
 
 static int cpuboost_input_connect(struct input_handler *handler,
 		struct input_dev *dev, const struct input_device_id *id)
@@ -315,6 +289,17 @@ static int cpu_boost_init(void)
 	struct sched_param param = { .sched_priority = 2 };
 	cpumask_t sys_bg_mask;
 
+	input_boost_client = freq_arb_register("input_boost",
+					       FREQ_ARB_PRIO_INPUT);
+	if (IS_ERR(input_boost_client))
+		return PTR_ERR(input_boost_client);
+	wake_boost_client = freq_arb_register("wake_boost",
+					      FREQ_ARB_PRIO_INPUT);
+	if (IS_ERR(wake_boost_client)) {
+		freq_arb_unregister(input_boost_client);
+		return PTR_ERR(wake_boost_client);
+	}
+
 	/* Hardcode the cpumask to bind the kthread to it */
 	for (i = 0; i <= 2; i++) {
 		cpumask_set_cpu(i, &sys_bg_mask);
@@ -339,13 +324,15 @@ static int cpu_boost_init(void)
 	wake_up_process(cpu_boost_worker_thread);
 
 	init_kthread_work(&input_boost_work, do_input_boost);
+	init_kthread_work(&wake_boost_work, do_wake_boost);
 	INIT_DELAYED_WORK(&input_boost_rem, do_input_boost_rem);
 
 	for_each_possible_cpu(cpu) {
 		s = &per_cpu(sync_info, cpu);
 		s->cpu = cpu;
 	}
-	cpufreq_register_notifier(&boost_adjust_nb, CPUFREQ_POLICY_NOTIFIER);
+	cpu_boost_ready = true;
+	wake_intent_register_notifier(&cpuboost_wake_intent_nb);
 	ret = input_register_handler(&cpuboost_input_handler);
 
 	return ret;
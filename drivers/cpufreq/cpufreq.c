@@ -377,6 +377,8 @@ static void adjust_jiffies(unsigned long val, struct cpufreq_freqs *ci)
 static DEFINE_PER_CPU(unsigned long, freq_scale) = SCHED_CAPACITY_SCALE;
 static DEFINE_PER_CPU(unsigned long, max_freq_cpu);
 static DEFINE_PER_CPU(unsigned long, max_freq_scale) = SCHED_CAPACITY_SCALE;
+static DEFINE_PER_CPU(unsigned long, policy_max_freq);
+static DEFINE_PER_CPU(unsigned long, hw_max_freq);
 static DEFINE_PER_CPU(unsigned long, min_freq_scale);
 
 static void
@@ -411,9 +413,17 @@ scale_max_freq_capacity(const cpumask_t *cpus, unsigned long policy_max_freq)
 
 	max_freq = per_cpu(max_freq_cpu, cpu);
 
+	for_each_cpu(cpu, cpus)
+		per_cpu(policy_max_freq, cpu) = policy_max_freq;
+
 	if (!max_freq)
 		return;
 
+	/* a hardware limit below the policy also reduces the capacity */
+	cpu = cpumask_first(cpus);
+	if (per_cpu(hw_max_freq, cpu))
+		policy_max_freq = min(policy_max_freq, per_cpu(hw_max_freq, cpu));
+
 	scale = (policy_max_freq << SCHED_CAPACITY_SHIFT) / max_freq;
 
 	for_each_cpu(cpu, cpus)
@@ -428,6 +438,30 @@ unsigned long cpufreq_scale_max_freq_capacity(struct sched_domain *sd, int cpu)
 	return per_cpu(max_freq_scale, cpu);
 }
 
+/**
+ * cpufreq_update_hw_max_freq - report a frequency limit applied by hardware
+ * @cpus: CPUs sharing the limit
+ * @freq: limit in kHz, or 0 once the hardware stops limiting
+ *
+ * Limits management hardware can cap the CPU clock behind cpufreq's back.
+ * Fold that cap into the max frequency capacity the scheduler uses for task
+ * placement. Safe to call from atomic context.
+ */
+void cpufreq_update_hw_max_freq(const struct cpumask *cpus, unsigned long freq)
+{
+	int cpu = cpumask_first(cpus);
+
+	if (cpu >= nr_cpu_ids || per_cpu(hw_max_freq, cpu) == freq)
+		return;
+
+	for_each_cpu(cpu, cpus)
+		per_cpu(hw_max_freq, cpu) = freq;
+
+	scale_max_freq_capacity(cpus,
+			per_cpu(policy_max_freq, cpumask_first(cpus)));
+}
+EXPORT_SYMBOL_GPL(cpufreq_update_hw_max_freq);
+
 static void
 scale_min_freq_capacity(const cpumask_t *cpus, unsigned long policy_min_freq)
 {
@@ -0,0 +1,336 @@
+/*
+ * Copyright (c) 2018, The Linux Foundation. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 and
+ * only version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+/*
+ * Single owner of the boost/cap adjustments made to cpufreq policies.
+ *
+ * Boost drivers register as named clients with a priority and vote per-CPU
+ * min and max frequencies, optionally for a limited duration. One
+ * CPUFREQ_ADJUST notifier folds the votes of all clients over the CPUs of a
+ * policy: the highest min and the lowest max win, except that a vote that
+ * contradicts what a higher priority client already asked for is ignored.
+ * The outcome and the client responsible for each bound are traced.
+ */
+
+#define pr_fmt(fmt) "freq_arb: " fmt
+
+#include <linux/cpu.h>
+#include <linux/cpufreq.h>
+#include <linux/cpufreq_arbiter.h>
+#include <linux/init.h>
+#include <linux/list.h>
+#include <linux/module.h>
+#include <linux/slab.h>
+#include <linux/spinlock.h>
+#include <linux/string.h>
+#include <linux/workqueue.h>
+
+#define CREATE_TRACE_POINTS
+#include <trace/events/cpufreq_arbiter.h>
+
+struct freq_arb_req {
+	unsigned int min;
+	unsigned int max;
+};
+
+struct freq_arb_client {
+	struct list_head node;
+	const char *name;
+	int prio;
+	/* CPUs with a vote in place, and CPUs changed since the last apply */
+	cpumask_t cpus;
+	cpumask_t dirty;
+	struct delayed_work expire;
+	struct freq_arb_req *req;
+};
+
+/* Clients sorted by decreasing priority, protected by freq_arb_lock */
+static LIST_HEAD(freq_arb_clients);
+static DEFINE_SPINLOCK(freq_arb_lock);
+
+static bool freq_arb_req_idle(struct freq_arb_req *r)
+{
+	return !r->min && r->max == UINT_MAX;
+}
+
+/*
+ * Re-evaluate the policies covering @cpus so the adjust notifier picks up
+ * the new votes. Only one CPU per policy needs to be updated.
+ */
+static void freq_arb_refresh(const struct cpumask *cpus)
+{
+	struct cpufreq_policy *policy;
+	cpumask_t pending;
+	unsigned int cpu;
+
+	get_online_cpus();
+	cpumask_and(&pending, cpus, cpu_online_mask);
+	while ((cpu = cpumask_first(&pending)) < nr_cpu_ids) {
+		policy = cpufreq_cpu_get(cpu);
+		if (!policy) {
+			cpumask_clear_cpu(cpu, &pending);
+			continue;
+		}
+		cpumask_andnot(&pending, &pending, policy->related_cpus);
+		cpufreq_cpu_put(policy);
+
+		cpufreq_update_policy(cpu);
+	}
+	put_online_cpus();
+}
+
+static void __freq_arb_clear(struct freq_arb_client *c, bool expired)
+{
+	cpumask_t changed;
+	unsigned long flags;
+	int cpu;
+
+	spin_lock_irqsave(&freq_arb_lock, flags);
+	cpumask_or(&changed, &c->cpus, &c->dirty);
+	for_each_cpu(cpu, &changed) {
+		c->req[cpu].min = 0;
+		c->req[cpu].max = UINT_MAX;
+	}
+	cpumask_clear(&c->cpus);
+	cpumask_clear(&c->dirty);
+	trace_freq_arb_release(c->name, c->prio, expired);
+	spin_unlock_irqrestore(&freq_arb_lock, flags);
+
+	freq_arb_refresh(&changed);
+}
+
+static void freq_arb_expire(struct work_struct *work)
+{
+	struct freq_arb_client *c = container_of(to_delayed_work(work),
+						 struct freq_arb_client,
+						 expire);
+
+	__freq_arb_clear(c, true);
+}
+
+static void freq_arb_set(struct freq_arb_client *c, int cpu,
+			 unsigned int freq, bool is_max)
+{
+	struct freq_arb_req *r;
+	unsigned long flags;
+
+	if (!c || cpu < 0 || cpu >= nr_cpu_ids)
+		return;
+
+	spin_lock_irqsave(&freq_arb_lock, flags);
+	r = &c->req[cpu];
+	if (is_max)
+		r->max = freq;
+	else
+		r->min = freq;
+	if (freq_arb_req_idle(r))
+		cpumask_clear_cpu(cpu, &c->cpus);
+	else
+		cpumask_set_cpu(cpu, &c->cpus);
+	cpumask_set_cpu(cpu, &c->dirty);
+	spin_unlock_irqrestore(&freq_arb_lock, flags);
+}
+
+/**
+ * freq_arb_set_min - record the min frequency @c wants on @cpu
+ * @c: the client
+ * @cpu: the CPU; the vote covers the whole policy @cpu belongs to
+ * @min: min frequency in kHz, 0 to withdraw
+ *
+ * Votes are only recorded here; freq_arb_apply() makes them effective.
+ */
+void freq_arb_set_min(struct freq_arb_client *c, int cpu, unsigned int min)
+{
+	freq_arb_set(c, cpu, min, false);
+}
+EXPORT_SYMBOL_GPL(freq_arb_set_min);
+
+/**
+ * freq_arb_set_max - record the max frequency @c allows on @cpu
+ * @c: the client
+ * @cpu: the CPU; the vote covers the whole policy @cpu belongs to
+ * @max: max frequency in kHz, UINT_MAX to withdraw
+ */
+void freq_arb_set_max(struct freq_arb_client *c, int cpu, unsigned int max)
+{
+	freq_arb_set(c, cpu, max, true);
+}
+EXPORT_SYMBOL_GPL(freq_arb_set_max);
+
+/**
+ * freq_arb_apply - make the votes recorded by @c effective
+ * @c: the client
+ * @duration_ms: drop all of @c's votes after this long, 0 to keep them
+ *
+ * Re-applying before the duration elapsed restarts it. May sleep.
+ */
+void freq_arb_apply(struct freq_arb_client *c, unsigned int duration_ms)
+{
+	cpumask_t changed;
+	unsigned long flags;
+	bool idle;
+	int cpu;
+
+	if (!c)
+		return;
+
+	spin_lock_irqsave(&freq_arb_lock, flags);
+	cpumask_or(&changed, &c->cpus, &c->dirty);
+	cpumask_clear(&c->dirty);
+	idle = cpumask_empty(&c->cpus);
+	for_each_cpu(cpu, &c->cpus)
+		trace_freq_arb_request(c->name, c->prio, cpu, c->req[cpu].min,
+				       c->req[cpu].max, duration_ms);
+	if (idle)
+		trace_freq_arb_release(c->name, c->prio, false);
+	spin_unlock_irqrestore(&freq_arb_lock, flags);
+
+	if (idle || !duration_ms)
+		cancel_delayed_work(&c->expire);
+	else
+		mod_delayed_work(system_highpri_wq, &c->expire,
+				 msecs_to_jiffies(duration_ms));
+
+	freq_arb_refresh(&changed);
+}
+EXPORT_SYMBOL_GPL(freq_arb_apply);
+
+/**
+ * freq_arb_clear - withdraw all votes of @c
+ * @c: the client
+ *
+ * May sleep.
+ */
+void freq_arb_clear(struct freq_arb_client *c)
+{
+	if (!c)
+		return;
+
+	cancel_delayed_work(&c->expire);
+	__freq_arb_clear(c, false);
+}
+EXPORT_SYMBOL_GPL(freq_arb_clear);
+
+/**
+ * freq_arb_register - add a client to the arbiter
+ * @name: name reported in the traces
+ * @prio: one of FREQ_ARB_PRIO_*, higher wins on conflicting votes
+ *
+ * Returns the client or an ERR_PTR().
+ */
+struct freq_arb_client *freq_arb_register(const char *name, int prio)
+{
+	struct freq_arb_client *c, *pos;
+	unsigned long flags;
+	int cpu;
+
+	c = kzalloc(sizeof(*c), GFP_KERNEL);
+	if (!c)
+		return ERR_PTR(-ENOMEM);
+
+	c->req = kcalloc(nr_cpu_ids, sizeof(*c->req), GFP_KERNEL);
+	c->name = kstrdup_const(name, GFP_KERNEL);
+	if (!c->req || !c->name) {
+		kfree(c->req);
+		kfree_const(c->name);
+		kfree(c);
+		return ERR_PTR(-ENOMEM);
+	}
+
+	for (cpu = 0; cpu < nr_cpu_ids; cpu++)
+		c->req[cpu].max = UINT_MAX;
+	c->prio = prio;
+	INIT_DELAYED_WORK(&c->expire, freq_arb_expire);
+
+	spin_lock_irqsave(&freq_arb_lock, flags);
+	list_for_each_entry(pos, &freq_arb_clients, node)
+		if (pos->prio < prio)
+			break;
+	list_add_tail(&c->node, &pos->node);
+	spin_unlock_irqrestore(&freq_arb_lock, flags);
+
+	return c;
+}
+EXPORT_SYMBOL_GPL(freq_arb_register);
+
+void freq_arb_unregister(struct freq_arb_client *c)
+{
+	cpumask_t changed;
+	unsigned long flags;
+
+	if (IS_ERR_OR_NULL(c))
+		return;
+
+	spin_lock_irqsave(&freq_arb_lock, flags);
+	list_del(&c->node);
+	cpumask_or(&changed, &c->cpus, &c->dirty);
+	spin_unlock_irqrestore(&freq_arb_lock, flags);
+
+	cancel_delayed_work_sync(&c->expire);
+	freq_arb_refresh(&changed);
+
+	kfree(c->req);
+	kfree_const(c->name);
+	kfree(c);
+}
+EXPORT_SYMBOL_GPL(freq_arb_unregister);
+
+static int freq_arb_adjust_notify(struct notifier_block *nb,
+				  unsigned long val, void *data)
+{
+	struct cpufreq_policy *policy = data;
+	struct freq_arb_client *c;
+	struct freq_arb_req *r;
+	const char *min_owner = "none", *max_owner = "none";
+	unsigned int min = 0, max = UINT_MAX;
+	unsigned long flags;
+	int cpu;
+
+	if (val != CPUFREQ_ADJUST)
+		return NOTIFY_OK;
+
+	spin_lock_irqsave(&freq_arb_lock, flags);
+	list_for_each_entry(c, &freq_arb_clients, node) {
+		for_each_cpu_and(cpu, &c->cpus, policy->related_cpus) {
+			r = &c->req[cpu];
+			if (r->min > min && r->min <= max) {
+				min = r->min;
+				min_owner = c->name;
+			}
+			if (r->max < max && r->max >= min) {
+				max = r->max;
+				max_owner = c->name;
+			}
+		}
+	}
+	trace_freq_arb_limits(policy->cpu, min, max, min_owner, max_owner);
+	spin_unlock_irqrestore(&freq_arb_lock, flags);
+
+	pr_debug("CPU%u policy before: %u:%u kHz, votes %u:%u kHz\n",
+		 policy->cpu, policy->min, policy->max, min, max);
+
+	cpufreq_verify_within_limits(policy, min, max);
+
+	return NOTIFY_OK;
+}
+
+static struct notifier_block freq_arb_adjust_nb = {
+	.notifier_call = freq_arb_adjust_notify,
+};
+
+static int __init freq_arb_init(void)
+{
+	return cpufreq_register_notifier(&freq_arb_adjust_nb,
+					 CPUFREQ_POLICY_NOTIFIER);
+}
+core_initcall(freq_arb_init);
@@ -56,6 +56,7 @@ struct cpufreq_interactive_policyinfo {
 	bool notif_pending;
 	unsigned long notif_cpu;
 	int governor_enabled;
+	bool update_util_set; /* update_util hooks registered, gov_lock */
 	struct cpufreq_interactive_tunables *cached_tunables;
 	struct sched_load *sl;
 };
@@ -67,6 +68,7 @@ struct cpufreq_interactive_cpuinfo {
 	u64 cputime_speedadj;
 	u64 cputime_speedadj_timestamp;
 	unsigned int loadadjfreq;
+	struct update_util_data update_util;
 };
 
 static DEFINE_PER_CPU(struct cpufreq_interactive_policyinfo *, polinfo);
@@ -160,6 +162,13 @@ struct cpufreq_interactive_tunables {
 
 	/* Whether to enable prediction or not */
 	bool enable_prediction;
+
+	/*
+	 * Evaluate only when the scheduler reports a utilization change,
+	 * using WALT load, instead of from the periodic policy timer. An
+	 * idle CPU then takes no governor wakeups beyond the slack timer.
+	 */
+	bool event_driven;
 };
 
 /* For cases where we have single governor instance for system */
@@ -245,8 +254,10 @@ static void cpufreq_interactive_timer_start(
 	int i;
 
 	spin_lock_irqsave(&ppol->load_lock, flags);
-	ppol->policy_timer.expires = expires;
-	add_timer(&ppol->policy_timer);
+	if (!tunables->event_driven) {
+		ppol->policy_timer.expires = expires;
+		add_timer(&ppol->policy_timer);
+	}
 	if (tunables->timer_slack_val >= 0 &&
 	    ppol->target_freq > ppol->policy->min) {
 		expires += usecs_to_jiffies(tunables->timer_slack_val);
@@ -451,6 +462,13 @@ static unsigned int sl_busy_to_laf(struct cpufreq_interactive_policyinfo *ppol,
 	return prev_load;
 }
 
+static unsigned int walt_util_to_laf(struct cpufreq_interactive_policyinfo *ppol,
+				     unsigned long util)
+{
+	return mult_frac(ppol->policy->cpuinfo.max_freq * 100, util,
+			 SCHED_CAPACITY_SCALE);
+}
+
 #define NEW_TASK_RATIO 75
 #define PRED_TOLERANCE_PCT 10
 static void cpufreq_interactive_timer(unsigned long data)
@@ -468,6 +486,7 @@ static void cpufreq_interactive_timer(unsigned long data)
 	unsigned int new_freq;
 	unsigned int prev_laf = 0, t_prevlaf;
 	unsigned int pred_laf = 0, t_predlaf = 0;
+	unsigned long util, pred_util;
 	unsigned int prev_chfreq, pred_chfreq, chosen_freq;
 	unsigned int index;
 	unsigned long flags;
@@ -504,7 +523,15 @@ static void cpufreq_interactive_timer(unsigned long data)
 	i = 0;
 	for_each_cpu(cpu, ppol->policy->cpus) {
 		pcpu = &per_cpu(cpuinfo, cpu);
-		if (tunables->use_sched_load) {
+		if (tunables->event_driven) {
+			util = sched_get_cpu_walt_load(cpu, &pred_util);
+			t_prevlaf = walt_util_to_laf(ppol, util);
+			prev_l = t_prevlaf / ppol->target_freq;
+			if (tunables->enable_prediction) {
+				t_predlaf = walt_util_to_laf(ppol, pred_util);
+				pred_l = t_predlaf / ppol->target_freq;
+			}
+		} else if (tunables->use_sched_load) {
 			t_prevlaf = sl_busy_to_laf(ppol, sl[i].prev_load);
 			prev_l = t_prevlaf / ppol->target_freq;
 			if (tunables->enable_prediction) {
@@ -674,7 +701,9 @@ static void cpufreq_interactive_timer(unsigned long data)
 	wake_up_process_no_notif(speedchange_task);
 
 rearm:
-	if (!timer_pending(&ppol->policy_timer))
+	if (tunables->event_driven)
+		cpufreq_interactive_timer_resched(data, true);
+	else if (!timer_pending(&ppol->policy_timer))
 		cpufreq_interactive_timer_resched(data, false);
 
 	/*
@@ -849,6 +878,67 @@ static struct notifier_block load_notifier_block = {
 	.notifier_call = load_change_callback,
 };
 
+/*
+ * Scheduler utilization update hook, called with the rq lock held on the
+ * CPU whose utilization changed. In event-driven mode this replaces the
+ * policy timer: evaluation is kicked through notif_timer at most once per
+ * timer_rate, and a CPU with its tick stopped never gets here.
+ */
+static void cpufreq_interactive_update_util(struct update_util_data *data,
+					    u64 time, unsigned int flags)
+{
+	int cpu = smp_processor_id();
+	struct cpufreq_interactive_policyinfo *ppol = per_cpu(polinfo, cpu);
+	struct cpufreq_interactive_tunables *tunables;
+	unsigned long irqflags;
+
+	if (!ppol || ppol->reject_notification)
+		return;
+
+	if (!down_read_trylock(&ppol->enable_sem))
+		return;
+	if (!ppol->governor_enabled)
+		goto exit;
+
+	tunables = ppol->policy->governor_data;
+	if (!tunables->event_driven || hrtimer_is_queued(&ppol->notif_timer))
+		goto exit;
+
+	if (time_before64(get_jiffies_64(), ppol->last_evaluated_jiffy +
+			  usecs_to_jiffies(tunables->timer_rate)))
+		goto exit;
+
+	spin_lock_irqsave(&ppol->target_freq_lock, irqflags);
+	ppol->notif_cpu = cpu;
+	spin_unlock_irqrestore(&ppol->target_freq_lock, irqflags);
+
+	hrtimer_start(&ppol->notif_timer, ms_to_ktime(1), HRTIMER_MODE_REL);
+exit:
+	up_read(&ppol->enable_sem);
+}
+
+/* Called with gov_lock held */
+static void cpufreq_interactive_set_update_util(
+		struct cpufreq_interactive_policyinfo *ppol, bool enable)
+{
+	int j;
+
+	if (ppol->update_util_set == enable)
+		return;
+
+	if (enable) {
+		for_each_cpu(j, ppol->policy->cpus)
+			cpufreq_add_update_util_hook(j,
+					&per_cpu(cpuinfo, j).update_util,
+					cpufreq_interactive_update_util);
+	} else {
+		for_each_cpu(j, ppol->policy->cpus)
+			cpufreq_remove_update_util_hook(j);
+		synchronize_sched();
+	}
+	ppol->update_util_set = enable;
+}
+
 static int cpufreq_interactive_notifier(
 	struct notifier_block *nb, unsigned long val, void *data)
 {
@@ -1355,6 +1445,61 @@ static ssize_t store_use_sched_load(
 	return count;
 }
 
+static ssize_t show_event_driven(
+		struct cpufreq_interactive_tunables *tunables, char *buf)
+{
+	return snprintf(buf, PAGE_SIZE, "%d\n", tunables->event_driven);
+}
+
+static ssize_t store_event_driven(
+		struct cpufreq_interactive_tunables *tunables,
+		const char *buf, size_t count)
+{
+	struct cpufreq_interactive_policyinfo *ppol;
+	unsigned long val;
+	int ret, cpu;
+
+	ret = kstrtoul(buf, 0, &val);
+	if (ret < 0)
+		return ret;
+
+	/* The event-driven load comes from WALT */
+	if (val && !IS_ENABLED(CONFIG_SCHED_WALT))
+		return -EINVAL;
+
+	mutex_lock(&gov_lock);
+	if (tunables->event_driven == (bool) val)
+		goto out;
+	tunables->event_driven = val;
+
+	/* Restart the timers so the new mode takes effect right away */
+	for_each_online_cpu(cpu) {
+		ppol = per_cpu(polinfo, cpu);
+		if (!ppol || !ppol->policy || cpu != ppol->policy->cpu ||
+		    ppol->policy->governor_data != tunables)
+			continue;
+
+		/* stop the hook before the policy timer takes over again */
+		if (!val)
+			cpufreq_interactive_set_update_util(ppol, false);
+
+		down_write(&ppol->enable_sem);
+		if (ppol->governor_enabled) {
+			del_timer_sync(&ppol->policy_timer);
+			del_timer_sync(&ppol->policy_slack_timer);
+			ppol->last_evaluated_jiffy = get_jiffies_64();
+			cpufreq_interactive_timer_start(tunables, cpu);
+		}
+		up_write(&ppol->enable_sem);
+
+		if (val && ppol->governor_enabled)
+			cpufreq_interactive_set_update_util(ppol, true);
+	}
+out:
+	mutex_unlock(&gov_lock);
+	return count;
+}
+
 static ssize_t show_use_migration_notif(
 		struct cpufreq_interactive_tunables *tunables, char *buf)
 {
@@ -1453,6 +1598,7 @@ show_store_gov_pol_sys(align_windows);
 show_store_gov_pol_sys(ignore_hispeed_on_notif);
 show_store_gov_pol_sys(fast_ramp_down);
 show_store_gov_pol_sys(enable_prediction);
+show_store_gov_pol_sys(event_driven);
 
 #define gov_sys_attr_rw(_name)						\
 static struct global_attr _name##_gov_sys =				\
@@ -1483,6 +1629,7 @@ gov_sys_pol_attr_rw(align_windows);
 gov_sys_pol_attr_rw(ignore_hispeed_on_notif);
 gov_sys_pol_attr_rw(fast_ramp_down);
 gov_sys_pol_attr_rw(enable_prediction);
+gov_sys_pol_attr_rw(event_driven);
 
 static struct global_attr boostpulse_gov_sys =
 	__ATTR(boostpulse, 0200, NULL, store_boostpulse_gov_sys);
@@ -1510,6 +1657,7 @@ static struct attribute *interactive_attributes_gov_sys[] = {
 	&ignore_hispeed_on_notif_gov_sys.attr,
 	&fast_ramp_down_gov_sys.attr,
 	&enable_prediction_gov_sys.attr,
+	&event_driven_gov_sys.attr,
 	NULL,
 };
 
@@ -1538,6 +1686,7 @@ static struct attribute *interactive_attributes_gov_pol[] = {
 	&ignore_hispeed_on_notif_gov_pol.attr,
 	&fast_ramp_down_gov_pol.attr,
 	&enable_prediction_gov_pol.attr,
+	&event_driven_gov_pol.attr,
 	NULL,
 };
 
@@ -1554,8 +1703,18 @@ static struct attribute_group *get_sysfs_attr(void)
 		return &interactive_attr_group_gov_sys;
 }
 
-static void cpufreq_interactive_nop_timer(unsigned long data)
+/*
+ * The slack timer only wakes an idle CPU so the deferrable policy timer can
+ * run. In event-driven mode the latter is not armed, so evaluate here.
+ */
+static void cpufreq_interactive_slack_timer(unsigned long data)
 {
+	struct cpufreq_interactive_policyinfo *ppol = per_cpu(polinfo, data);
+	struct cpufreq_interactive_tunables *tunables =
+		ppol->policy->governor_data;
+
+	if (tunables->event_driven && !timer_pending(&ppol->policy_timer))
+		cpufreq_interactive_timer(data);
 }
 
 static struct cpufreq_interactive_tunables *alloc_tunable(
@@ -1611,7 +1770,7 @@ static struct cpufreq_interactive_policyinfo *get_policyinfo(
 	init_timer_deferrable(&ppol->policy_timer);
 	ppol->policy_timer.function = cpufreq_interactive_timer;
 	init_timer(&ppol->policy_slack_timer);
-	ppol->policy_slack_timer.function = cpufreq_interactive_nop_timer;
+	ppol->policy_slack_timer.function = cpufreq_interactive_slack_timer;
 	hrtimer_init(&ppol->notif_timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
 	ppol->notif_timer.function = cpufreq_interactive_hrtimer;
 	spin_lock_init(&ppol->load_lock);
@@ -1767,12 +1926,16 @@ static int cpufreq_governor_interactive(struct cpufreq_policy *policy,
 		del_timer_sync(&ppol->policy_timer);
 		del_timer_sync(&ppol->policy_slack_timer);
 		ppol->policy_timer.data = policy->cpu;
+		ppol->policy_slack_timer.data = policy->cpu;
 		ppol->last_evaluated_jiffy = get_jiffies_64();
 		cpufreq_interactive_timer_start(tunables, policy->cpu);
 		ppol->governor_enabled = 1;
 		up_write(&ppol->enable_sem);
 		ppol->reject_notification = false;
 
+		if (tunables->event_driven)
+			cpufreq_interactive_set_update_util(ppol, true);
+
 		mutex_unlock(&gov_lock);
 		break;
 
@@ -1780,6 +1943,8 @@ static int cpufreq_governor_interactive(struct cpufreq_policy *policy,
 		mutex_lock(&gov_lock);
 
 		ppol = per_cpu(polinfo, policy->cpu);
+		cpufreq_interactive_set_update_util(ppol, false);
+
 		ppol->reject_notification = true;
 		down_write(&ppol->enable_sem);
 		ppol->governor_enabled = 0;
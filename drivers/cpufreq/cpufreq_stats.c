@@ -95,39 +95,14 @@ static struct uid_entry *find_or_register_uid(uid_t uid)
 }
 
 
-static int uid_time_in_state_show(struct seq_file *m, void *v)
+/* Caller must hold uid lock */
+static void uid_collect_alive_time_in_state(void)
 {
 	struct uid_entry *uid_entry;
 	struct task_struct *task, *temp;
-	unsigned long bkt, flags;
-	struct cpufreq_policy *last_policy = NULL;
+	unsigned long flags;
 	int i;
 
-	if (!cpufreq_stats_initialized)
-		return 0;
-
-	seq_puts(m, "uid:");
-	for_each_possible_cpu(i) {
-		struct cpufreq_frequency_table *table, *pos;
-		struct cpufreq_policy *policy;
-
-		policy = cpufreq_cpu_get(i);
-		if (!policy)
-			continue;
-		table = cpufreq_frequency_get_table(i);
-
-		/* Assumes cpus are colocated within a policy */
-		if (table && last_policy != policy) {
-			last_policy = policy;
-			cpufreq_for_each_valid_entry(pos, table)
-				seq_printf(m, " %d", pos->frequency);
-		}
-		cpufreq_cpu_put(policy);
-	}
-	seq_putc(m, '\n');
-
-	rt_mutex_lock(&uid_lock);
-
 	rcu_read_lock();
 	do_each_thread(temp, task) {
 
@@ -161,6 +136,62 @@ static int uid_time_in_state_show(struct seq_file *m, void *v)
 
 	} while_each_thread(temp, task);
 	rcu_read_unlock();
+}
+
+/* Caller must hold uid lock */
+static u64 uid_entry_time_in_state(struct uid_entry *uid_entry, int i)
+{
+	u64 total_time_in_state = 0;
+
+	if (uid_entry->dead_time_in_state && i < uid_entry->dead_max_state)
+		total_time_in_state = uid_entry->dead_time_in_state[i];
+	if (uid_entry->alive_time_in_state && i < uid_entry->alive_max_state)
+		total_time_in_state += uid_entry->alive_time_in_state[i];
+
+	return total_time_in_state;
+}
+
+/* Caller must hold uid lock */
+static void uid_release_alive_time_in_state(struct uid_entry *uid_entry)
+{
+	kfree(uid_entry->alive_time_in_state);
+	uid_entry->alive_time_in_state = NULL;
+	uid_entry->alive_max_state = 0;
+}
+
+static int uid_time_in_state_show(struct seq_file *m, void *v)
+{
+	struct uid_entry *uid_entry;
+	unsigned long bkt;
+	struct cpufreq_policy *last_policy = NULL;
+	int i;
+
+	if (!cpufreq_stats_initialized)
+		return 0;
+
+	seq_puts(m, "uid:");
+	for_each_possible_cpu(i) {
+		struct cpufreq_frequency_table *table, *pos;
+		struct cpufreq_policy *policy;
+
+		policy = cpufreq_cpu_get(i);
+		if (!policy)
+			continue;
+		table = cpufreq_frequency_get_table(i);
+
+		/* Assumes cpus are colocated within a policy */
+		if (table && last_policy != policy) {
+			last_policy = policy;
+			cpufreq_for_each_valid_entry(pos, table)
+				seq_printf(m, " %d", pos->frequency);
+		}
+		cpufreq_cpu_put(policy);
+	}
+	seq_putc(m, '\n');
+
+	rt_mutex_lock(&uid_lock);
+
+	uid_collect_alive_time_in_state();
 
 	hash_for_each(uid_hash_table, bkt, uid_entry, hash) {
 		int max_state = uid_entry->dead_max_state;
@@ -170,27 +201,68 @@ static int uid_time_in_state_show(struct seq_file *m, void *v)
 		if (max_state)
 			seq_printf(m, "%d:", uid_entry->uid);
 		for (i = 0; i < max_state; ++i) {
-			u64 total_time_in_state = 0;
-
-			if (uid_entry->dead_time_in_state &&
-				i < uid_entry->dead_max_state) {
-				total_time_in_state =
-					uid_entry->dead_time_in_state[i];
-			}
-			if (uid_entry->alive_time_in_state &&
-				i < uid_entry->alive_max_state) {
-				total_time_in_state +=
-					uid_entry->alive_time_in_state[i];
-			}
-			seq_printf(m, " %lu", (unsigned long)
-				cputime_to_clock_t(total_time_in_state));
+			seq_printf(m, " %lu", (unsigned long)cputime_to_clock_t(
+				uid_entry_time_in_state(uid_entry, i)));
 		}
 		if (max_state)
 			seq_putc(m, '\n');
 
-		kfree(uid_entry->alive_time_in_state);
-		uid_entry->alive_time_in_state = NULL;
-		uid_entry->alive_max_state = 0;
+		uid_release_alive_time_in_state(uid_entry);
+	}
+
+	rt_mutex_unlock(&uid_lock);
+	return 0;
+}
+
+/*
+ * Binary form of uid_time_in_state for on-device collectors, which
+ * otherwise spend more time parsing the text than the kernel spends
+ * producing it. All values are native endian:
+ *
+ *	u32 nr_states
+ *	u32 freq[nr_states]			(kHz)
+ *	{ u32 uid; u32 pad; u64 time[nr_states]; }	(clock_t, per uid)
+ *
+ * The frequency list is the concatenation of every policy's table, in the
+ * same order as the text header.
+ */
+static int uid_time_in_state_bin_show(struct seq_file *m, void *v)
+{
+	struct uid_entry *uid_entry;
+	unsigned long bkt;
+	u32 nr_states, val;
+	u64 time;
+	int i;
+
+	if (!cpufreq_stats_initialized)
+		return 0;
+
+	nr_states = cpufreq_max_state;
+	seq_write(m, &nr_states, sizeof(nr_states));
+	for (i = 0; i < nr_states; i++) {
+		val = cpufreq_states[i];
+		seq_write(m, &val, sizeof(val));
+	}
+
+	rt_mutex_lock(&uid_lock);
+
+	uid_collect_alive_time_in_state();
+
+	hash_for_each(uid_hash_table, bkt, uid_entry, hash) {
+		if (!uid_entry->dead_max_state && !uid_entry->alive_max_state)
+			continue;
+
+		val = uid_entry->uid;
+		seq_write(m, &val, sizeof(val));
+		val = 0;
+		seq_write(m, &val, sizeof(val));
+		for (i = 0; i < nr_states; i++) {
+			time = cputime_to_clock_t(
+				uid_entry_time_in_state(uid_entry, i));
+			seq_write(m, &time, sizeof(time));
+		}
+
+		uid_release_alive_time_in_state(uid_entry);
 	}
 
 	rt_mutex_unlock(&uid_lock);
@@ -658,6 +730,18 @@ static const struct file_operations uid_time_in_state_fops = {
 	.release	= single_release,
 };
 
+static int uid_time_in_state_bin_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, uid_time_in_state_bin_show, PDE_DATA(inode));
+}
+
+static const struct file_operations uid_time_in_state_bin_fops = {
+	.open		= uid_time_in_state_bin_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
 static struct notifier_block notifier_policy_block = {
 	.notifier_call = cpufreq_stat_notifier_policy
 };
@@ -720,6 +804,8 @@ static int __init cpufreq_stats_init(void)
 
 	proc_create_data("uid_time_in_state", 0444, NULL,
 		&uid_time_in_state_fops, NULL);
+	proc_create_data("uid_time_in_state_bin", 0444, NULL,
+		&uid_time_in_state_bin_fops, NULL);
 
 	profile_event_register(PROFILE_TASK_EXIT, &process_notifier_block);
 
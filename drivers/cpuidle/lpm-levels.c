@@ -15,6 +15,8 @@
 
 #include <linux/module.h>
 #include <linux/kernel.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
 #include <linux/init.h>
 #include <linux/slab.h>
 #include <linux/platform_device.h>
@@ -503,6 +505,7 @@ static int cpu_power_select(struct cpuidle_device *dev,
 	int i, idx_restrict;
 	uint32_t lvl_latency_us = 0;
 	uint64_t predicted = 0;
+	uint32_t hist_predicted;
 	uint32_t htime = 0, idx_restrict_time = 0;
 	uint32_t next_wakeup_us = (uint32_t)sleep_us;
 	uint32_t *min_residency = get_per_cpu_min_residency(dev->cpu);
@@ -549,6 +552,21 @@ static int cpu_power_select(struct cpuidle_device *dev,
 			if (next_wakeup_us > max_residency[i]) {
 				predicted = lpm_cpuidle_predict(dev, cpu,
 					&idx_restrict, &idx_restrict_time);
+				/*
+				 * The histograms see further back and know
+				 * when periodic wakeup sources are due, so
+				 * they take precedence when they have an
+				 * opinion.
+				 */
+				hist_predicted = lpm_hist_predict(dev->cpu,
+							next_wakeup_us);
+				if (hist_predicted) {
+					predicted = hist_predicted;
+					idx_restrict = cpu->nlevels + 1;
+					per_cpu(hist, dev->cpu).stime =
+						ktime_to_us(ktime_get())
+						+ predicted;
+				}
 				if (predicted && (predicted < min_residency[i]))
 					predicted = min_residency[i];
 			} else
@@ -1103,6 +1121,14 @@ static void cluster_unprepare(struct lpm_cluster *cluster,
 	lpm_stats_cluster_exit(cluster->stats, cluster->last_level, true);
 
 	level = &cluster->levels[cluster->last_level];
+	if (from_idle) {
+		level->idle_entries++;
+		/* a sibling or timer woke the cluster before break-even */
+		if (cluster->stats->sleep_time &&
+			cluster->stats->sleep_time <
+			(int64_t)level->pwr.min_residency * NSEC_PER_USEC)
+			level->early_exits++;
+	}
 	if (level->notify_rpm) {
 		msm_rpm_exit_sleep();
 
@@ -1324,8 +1350,11 @@ static void update_history(struct cpuidle_device *dev, int idx)
 		history->resi[history->hptr] += dev->last_residency;
 		history->htmr_wkup = 0;
 		tmr = 1;
-	} else
+		lpm_hist_amend(dev->cpu, dev->last_residency);
+	} else {
 		history->resi[history->hptr] = dev->last_residency;
+		lpm_hist_record(dev->cpu, dev->last_residency);
+	}
 
 	history->mode[history->hptr] = idx;
 
@@ -1608,6 +1637,44 @@ static const struct platform_suspend_ops lpm_suspend_ops = {
 	.wake = lpm_suspend_wake,
 };
 
+static void lpm_mispredict_show_cluster(struct seq_file *m,
+		struct lpm_cluster *cluster)
+{
+	struct lpm_cluster *child;
+	int i;
+
+	for (i = 0; i < cluster->nlevels; i++) {
+		struct lpm_cluster_level *level = &cluster->levels[i];
+
+		seq_printf(m, "%-12s %-16s %10u %10u\n", cluster->cluster_name,
+				level->level_name, level->idle_entries,
+				level->early_exits);
+	}
+
+	list_for_each_entry(child, &cluster->child, list)
+		lpm_mispredict_show_cluster(m, child);
+}
+
+static int lpm_mispredict_show(struct seq_file *m, void *unused)
+{
+	seq_printf(m, "%-12s %-16s %10s %10s\n", "cluster", "level",
+			"entries", "early_exit");
+	lpm_mispredict_show_cluster(m, lpm_root_node);
+	return 0;
+}
+
+static int lpm_mispredict_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, lpm_mispredict_show, NULL);
+}
+
+static const struct file_operations lpm_mispredict_fops = {
+	.open = lpm_mispredict_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
 static int lpm_probe(struct platform_device *pdev)
 {
 	int ret;
@@ -1664,6 +1731,9 @@ static int lpm_probe(struct platform_device *pdev)
 		goto failed;
 	}
 
+	debugfs_create_file("lpm_cluster_mispredict", S_IRUGO, NULL, NULL,
+			&lpm_mispredict_fops);
+
 	return 0;
 failed:
 	free_cluster_node(lpm_root_node);
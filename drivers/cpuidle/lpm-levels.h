@@ -79,6 +79,9 @@ struct lpm_cluster_level {
 	unsigned int psci_id;
 	bool is_reset;
 	int reset_level;
+	/* idle entries, and those woken before min_residency was reached */
+	u32 idle_entries;
+	u32 early_exits;
 };
 
 struct low_power_ops {
@@ -146,6 +149,19 @@ uint32_t *get_per_cpu_max_residency(int cpu);
 uint32_t *get_per_cpu_min_residency(int cpu);
 extern struct lpm_cluster *lpm_root_node;
 
+#ifdef CONFIG_MSM_LPM_HIST_PREDICT
+uint32_t lpm_hist_predict(int cpu, uint32_t next_wakeup_us);
+void lpm_hist_record(int cpu, uint32_t residency_us);
+void lpm_hist_amend(int cpu, uint32_t residency_us);
+#else
+static inline uint32_t lpm_hist_predict(int cpu, uint32_t next_wakeup_us)
+{
+	return 0;
+}
+static inline void lpm_hist_record(int cpu, uint32_t residency_us) {}
+static inline void lpm_hist_amend(int cpu, uint32_t residency_us) {}
+#endif
+
 #ifdef CONFIG_SMP
 extern DEFINE_PER_CPU(bool, pending_ipi);
 static inline bool is_IPI_pending(const struct cpumask *mask)
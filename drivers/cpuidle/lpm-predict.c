@@ -0,0 +1,399 @@
+/* Copyright (c) 2018, The Linux Foundation. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 and
+ * only version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+/*
+ * Histogram based idle residency prediction.
+ *
+ * Two kinds of histograms are kept per CPU, both over log2 buckets of
+ * microseconds and periodically halved so they follow workload changes:
+ *
+ *  - the residency of every idle period, which gives a conservative
+ *    estimate (a low percentile) of how long the next one will last;
+ *  - for each of the most recent interrupt sources of the CPU, the
+ *    interval between two of its interrupts. A source whose intervals
+ *    mostly fall in one bucket is treated as periodic, and its next
+ *    arrival is extrapolated from the last one.
+ *
+ * The prediction is the earliest of the two. Everything is per CPU and
+ * only touched by that CPU with interrupts disabled, from idle or from
+ * the irq_handler_entry probe, so no locking is needed.
+ */
+
+#include <linux/kernel.h>
+#include <linux/init.h>
+#include <linux/debugfs.h>
+#include <linux/interrupt.h>
+#include <linux/irq.h>
+#include <linux/irqdesc.h>
+#include <linux/log2.h>
+#include <linux/moduleparam.h>
+#include <linux/percpu.h>
+#include <linux/sched.h>
+#include <linux/seq_file.h>
+#include <trace/events/irq.h>
+#include "lpm-levels.h"
+
+#define LPM_HIST_BUCKETS	16
+/* Bucket 0 holds intervals below 32us, bucket 15 those above ~0.5s */
+#define LPM_HIST_SHIFT		4
+#define LPM_HIST_DECAY		64
+#define LPM_HIST_MIN_SAMPLES	16
+#define LPM_IRQ_SOURCES		8
+#define LPM_IRQ_MIN_SAMPLES	8
+/* A periodic source silent for this many periods is not predicted */
+#define LPM_IRQ_STALE_PERIODS	4
+
+static bool lpm_hist_enabled = true;
+module_param_named(lpm_hist_predict,
+	lpm_hist_enabled, bool, S_IRUGO | S_IWUSR | S_IWGRP);
+
+/* Percentage of samples a prediction must be backed by */
+static uint32_t lpm_hist_conf = 75;
+module_param_named(
+	lpm_hist_conf, lpm_hist_conf, uint, S_IRUGO | S_IWUSR | S_IWGRP
+);
+
+struct lpm_hist {
+	u16 count[LPM_HIST_BUCKETS];
+	u32 sum_us[LPM_HIST_BUCKETS];
+	u16 total;
+};
+
+struct lpm_irq_source {
+	unsigned int irq;
+	u64 last_ns;
+	struct lpm_hist hist;
+};
+
+struct lpm_predict {
+	struct lpm_hist idle;
+	struct lpm_irq_source src[LPM_IRQ_SOURCES];
+	uint32_t last_us;
+	/* Prediction that was used for the current idle period, or 0 */
+	uint32_t predicted_us;
+	bool from_irq;
+
+	u64 predictions;
+	u64 irq_predictions;
+	u64 hits;
+	/* Woke up before half the predicted residency */
+	u64 early;
+	/* Slept for more than twice the predicted residency */
+	u64 late;
+};
+
+static DEFINE_PER_CPU(struct lpm_predict, lpm_predict);
+
+static int lpm_hist_bucket(uint32_t us)
+{
+	int b;
+
+	if (us < (1U << (LPM_HIST_SHIFT + 1)))
+		return 0;
+
+	b = ilog2(us) - LPM_HIST_SHIFT;
+	return min(b, LPM_HIST_BUCKETS - 1);
+}
+
+static uint32_t lpm_hist_bucket_floor(int b)
+{
+	return b ? 1U << (b + LPM_HIST_SHIFT) : 1;
+}
+
+static void lpm_hist_add(struct lpm_hist *h, uint32_t us)
+{
+	int b = lpm_hist_bucket(us);
+	int i;
+
+	if (h->total >= LPM_HIST_DECAY) {
+		h->total = 0;
+		for (i = 0; i < LPM_HIST_BUCKETS; i++) {
+			h->count[i] >>= 1;
+			h->sum_us[i] >>= 1;
+			h->total += h->count[i];
+		}
+	}
+
+	h->count[b]++;
+	h->sum_us[b] += us;
+	h->total++;
+}
+
+static void lpm_hist_del(struct lpm_hist *h, uint32_t us)
+{
+	int b = lpm_hist_bucket(us);
+
+	if (!h->count[b])
+		return;
+
+	h->count[b]--;
+	h->sum_us[b] -= min(h->sum_us[b], us);
+	h->total--;
+}
+
+/*
+ * Residency that at least lpm_hist_conf percent of the idle periods
+ * reached, i.e. the low percentile of the histogram, or 0 if there are
+ * not enough samples yet.
+ */
+static uint32_t lpm_hist_floor(struct lpm_hist *h)
+{
+	uint32_t cum = 0, thresh;
+	int b;
+
+	if (h->total < LPM_HIST_MIN_SAMPLES)
+		return 0;
+
+	thresh = h->total * (100 - min(lpm_hist_conf, 100U));
+	for (b = 0; b < LPM_HIST_BUCKETS; b++) {
+		cum += h->count[b];
+		if (cum * 100 > thresh)
+			break;
+	}
+
+	return lpm_hist_bucket_floor(min(b, LPM_HIST_BUCKETS - 1));
+}
+
+/*
+ * Period of a source whose intervals mostly fall in a single bucket,
+ * or 0.
+ */
+static uint32_t lpm_hist_period(struct lpm_hist *h)
+{
+	int b, best = 0;
+
+	if (h->total < LPM_IRQ_MIN_SAMPLES)
+		return 0;
+
+	for (b = 1; b < LPM_HIST_BUCKETS; b++)
+		if (h->count[b] > h->count[best])
+			best = b;
+
+	if (h->count[best] * 100 < h->total * lpm_hist_conf)
+		return 0;
+
+	return h->sum_us[best] / h->count[best];
+}
+
+/* Time until the first periodic source is due, or 0 if none is known */
+static uint32_t lpm_irq_next(struct lpm_predict *p, u64 now)
+{
+	uint32_t next = 0, period, elapsed;
+	struct lpm_irq_source *s;
+	u64 delta;
+	int i;
+
+	for (i = 0; i < LPM_IRQ_SOURCES; i++) {
+		s = &p->src[i];
+		if (!s->irq)
+			continue;
+
+		period = lpm_hist_period(&s->hist);
+		if (!period)
+			continue;
+
+		delta = div_u64(now - s->last_ns, NSEC_PER_USEC);
+		if (delta >= (u64)period * LPM_IRQ_STALE_PERIODS)
+			continue;
+
+		elapsed = (uint32_t)delta % period;
+		if (!next || period - elapsed < next)
+			next = period - elapsed;
+	}
+
+	return next;
+}
+
+/**
+ * lpm_hist_predict - predicted residency of the idle period about to start
+ * @cpu: the CPU going idle, must be the local CPU
+ * @next_wakeup_us: time until the next known timer event
+ *
+ * Returns the prediction in microseconds, never beyond @next_wakeup_us,
+ * or 0 when the histograms do not support one.
+ */
+uint32_t lpm_hist_predict(int cpu, uint32_t next_wakeup_us)
+{
+	struct lpm_predict *p = &per_cpu(lpm_predict, cpu);
+	uint32_t floor, irq_next, pred;
+
+	p->predicted_us = 0;
+	if (!lpm_hist_enabled)
+		return 0;
+
+	floor = lpm_hist_floor(&p->idle);
+	irq_next = lpm_irq_next(p, local_clock());
+
+	if (floor && irq_next)
+		pred = min(floor, irq_next);
+	else
+		pred = floor ? floor : irq_next;
+
+	if (!pred)
+		return 0;
+
+	p->from_irq = pred == irq_next;
+	pred = min(pred, next_wakeup_us);
+	p->predicted_us = pred;
+	p->predictions++;
+	if (p->from_irq)
+		p->irq_predictions++;
+
+	return pred;
+}
+
+/**
+ * lpm_hist_record - account the residency of the idle period just ended
+ * @cpu: the local CPU
+ * @residency_us: time spent idle
+ */
+void lpm_hist_record(int cpu, uint32_t residency_us)
+{
+	struct lpm_predict *p = &per_cpu(lpm_predict, cpu);
+	uint32_t pred = p->predicted_us;
+
+	if (!lpm_hist_enabled)
+		return;
+
+	lpm_hist_add(&p->idle, residency_us);
+	p->last_us = residency_us;
+
+	if (!pred)
+		return;
+
+	if (residency_us < pred / 2)
+		p->early++;
+	else if (residency_us / 2 > pred)
+		p->late++;
+	else
+		p->hits++;
+	p->predicted_us = 0;
+}
+
+/**
+ * lpm_hist_amend - extend the last recorded idle period
+ * @cpu: the local CPU
+ * @residency_us: additional residency
+ *
+ * Used when the previous period was cut short by the prediction guard
+ * timer rather than by a real wakeup.
+ */
+void lpm_hist_amend(int cpu, uint32_t residency_us)
+{
+	struct lpm_predict *p = &per_cpu(lpm_predict, cpu);
+
+	if (!lpm_hist_enabled)
+		return;
+
+	lpm_hist_del(&p->idle, p->last_us);
+	p->last_us += residency_us;
+	lpm_hist_add(&p->idle, p->last_us);
+	p->predicted_us = 0;
+}
+
+static void lpm_irq_probe(void *data, int irq, struct irqaction *action)
+{
+	struct lpm_predict *p = this_cpu_ptr(&lpm_predict);
+	struct lpm_irq_source *s, *victim = NULL;
+	struct irq_desc *desc = irq_to_desc(irq);
+	u64 now;
+	int i;
+
+	if (!lpm_hist_enabled || !desc)
+		return;
+
+	/*
+	 * Only the first action of a shared line, and no per-CPU interrupts:
+	 * the local timer is covered by the next timer event already.
+	 */
+	if (desc->action != action || irq_is_percpu(irq))
+		return;
+
+	now = local_clock();
+	for (i = 0; i < LPM_IRQ_SOURCES; i++) {
+		s = &p->src[i];
+		if (s->irq == irq) {
+			lpm_hist_add(&s->hist,
+				(uint32_t)min_t(u64, div_u64(now - s->last_ns,
+						NSEC_PER_USEC), UINT_MAX));
+			s->last_ns = now;
+			return;
+		}
+		if (!victim || s->last_ns < victim->last_ns)
+			victim = s;
+	}
+
+	/* Replace the source that has been quiet the longest */
+	memset(victim, 0, sizeof(*victim));
+	victim->irq = irq;
+	victim->last_ns = now;
+}
+
+static int lpm_predict_show(struct seq_file *m, void *v)
+{
+	struct lpm_predict *p;
+	struct lpm_irq_source *s;
+	int cpu, b, i;
+
+	for_each_possible_cpu(cpu) {
+		p = &per_cpu(lpm_predict, cpu);
+		seq_printf(m, "cpu%d: predictions %llu (irq %llu) hits %llu early %llu late %llu\n",
+			   cpu, p->predictions, p->irq_predictions, p->hits,
+			   p->early, p->late);
+
+		seq_puts(m, "  idle:");
+		for (b = 0; b < LPM_HIST_BUCKETS; b++)
+			seq_printf(m, " %u", p->idle.count[b]);
+		seq_puts(m, "\n");
+
+		for (i = 0; i < LPM_IRQ_SOURCES; i++) {
+			s = &p->src[i];
+			if (!s->irq)
+				continue;
+			seq_printf(m, "  irq %u: samples %u period %uus\n",
+				   s->irq, s->hist.total,
+				   lpm_hist_period(&s->hist));
+		}
+	}
+
+	return 0;
+}
+
+static int lpm_predict_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, lpm_predict_show, NULL);
+}
+
+static const struct file_operations lpm_predict_fops = {
+	.open		= lpm_predict_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static int __init lpm_predict_init(void)
+{
+	int ret;
+
+	ret = register_trace_irq_handler_entry(lpm_irq_probe, NULL);
+	if (ret) {
+		pr_err("%s: failed to register irq probe: %d\n", __func__, ret);
+		return ret;
+	}
+
+	debugfs_create_file("lpm_predict", S_IRUGO, NULL, NULL,
+			    &lpm_predict_fops);
+
+	return 0;
+}
+late_initcall(lpm_predict_init);
@@ -135,6 +135,7 @@ struct qcrypto_req_control {
 	struct crypto_async_request *req;
 	struct qcrypto_resp_ctx *arsp;
 	int res; /* execution result */
+	unsigned int nbytes; /* payload, accounted in the engine in flight */
 };
 
 struct crypto_engine {
@@ -174,7 +175,11 @@ struct crypto_engine {
 	bool issue_req;		/* an request is being issued to qce */
 	bool first_engine;	/* this engine is the first engine or not */
 	unsigned int irq_cpu;	/* the cpu running the irq of this engine */
+	/* bytes of the requests issued and not yet completed */
+	atomic_long_t inflight_bytes;
 	unsigned int max_req_used; /* debug stats */
+	unsigned int max_qlen; /* debug stats */
+	unsigned long max_inflight_bytes; /* debug stats */
 };
 
 #define MAX_SMP_CPU    8
@@ -266,6 +271,8 @@ static void qcrypto_free_req_control(struct crypto_engine *pce,
 	if (xchg(&preq->in_use, false) == false) {
 		pr_warn("request info %pK free already\n", preq);
 	} else {
+		atomic_long_sub(preq->nbytes, &pce->inflight_bytes);
+		preq->nbytes = 0;
 		atomic_dec(&pce->req_count);
 	}
 }
@@ -696,6 +703,9 @@ static void qcrypto_bw_reaper_work(struct work_struct *work)
 			pengine->check_flag = false;
 			goto ret;
 		}
+		/* keep the vote while requests are waiting to be issued */
+		if (pengine->req_queue.qlen || cp->req_queue.qlen)
+			goto ret;
 		if (cp->platform_support.bus_scale_table == NULL)
 			goto ret;
 		pengine->bw_state = BUS_BANDWIDTH_RELEASING;
@@ -1267,6 +1277,14 @@ static int _disp_stats(int id)
 			pe->unit,
 			pe->err_req
 		);
+		len += scnprintf(
+			_debug_read_buf + len,
+			DEBUG_MAX_RW_BUF - len - 1,
+			"   Engine %4d queue max, bytes in flight max : %u %lu\n",
+			pe->unit,
+			pe->max_qlen,
+			pe->max_inflight_bytes
+		);
 		qce_get_driver_stats(pe->qce);
 	}
 	spin_unlock_irqrestore(&cp->lock, flags);
@@ -2214,6 +2232,7 @@ static int _start_qcrypto_process(struct crypto_priv *cp,
 	struct qcrypto_resp_ctx *arsp;
 	struct qcrypto_req_control *pqcrypto_req_control;
 	unsigned int cpu = MAX_SMP_CPU;
+	unsigned long inflight;
 
 	if (ACCESS_ONCE(cp->ce_req_proc_sts) == STOPPED)
 		return 0;
@@ -2277,6 +2296,7 @@ again:
 			&arsp->list,
 			&((struct qcrypto_sha_ctx *)tfm_ctx)
 				->rsp_queue);
+		pqcrypto_req_control->nbytes = ahash_req->nbytes;
 		break;
 	case CRYPTO_ALG_TYPE_ABLKCIPHER:
 		ablkcipher_req = container_of(async_req,
@@ -2287,6 +2307,7 @@ again:
 			&arsp->list,
 			&((struct qcrypto_cipher_ctx *)tfm_ctx)
 				->rsp_queue);
+		pqcrypto_req_control->nbytes = ablkcipher_req->nbytes;
 		break;
 	case CRYPTO_ALG_TYPE_AEAD:
 	default:
@@ -2298,8 +2319,14 @@ again:
 			&arsp->list,
 			&((struct qcrypto_cipher_ctx *)tfm_ctx)
 				->rsp_queue);
+		pqcrypto_req_control->nbytes = aead_req->assoclen +
+						aead_req->cryptlen;
 		break;
 	}
+	inflight = atomic_long_add_return(pqcrypto_req_control->nbytes,
+					  &pengine->inflight_bytes);
+	if (inflight > pengine->max_inflight_bytes)
+		pengine->max_inflight_bytes = inflight;
 
 	arsp->res = -EINPROGRESS;
 	arsp->async_req = async_req;
@@ -2366,6 +2393,12 @@ static inline struct crypto_engine *_next_eng(struct crypto_priv *cp,
 		p = list_entry(p->elist.next, struct crypto_engine, elist);
 	return p;
 }
+/*
+ * Of the engines that can take another request, pick the one with the
+ * fewest bytes in flight, so a few large requests on one engine do not
+ * hold back the small ones. The scan starts after the engine picked last,
+ * which spreads ties round robin.
+ */
 static struct crypto_engine *_avail_eng(struct crypto_priv *cp)
 {
 	/* call this function with spinlock set */
@@ -2373,6 +2406,7 @@ static struct crypto_engine *_avail_eng(struct crypto_priv *cp)
 	struct crypto_engine *p = cp->scheduled_eng;
 	struct crypto_engine *q1;
 	int eng_cnt = cp->total_units;
+	long bytes, least = LONG_MAX;
 
 	if (unlikely(list_empty(&cp->engine_list))) {
 		pr_err("%s: no valid ce to schedule\n", __func__);
@@ -2383,8 +2417,13 @@ static struct crypto_engine *_avail_eng(struct crypto_priv *cp)
 	q1 = p;
 	while (eng_cnt-- > 0) {
 		if (!p->issue_req && atomic_read(&p->req_count) < p->max_req) {
-			q = p;
-			break;
+			bytes = atomic_long_read(&p->inflight_bytes);
+			if (bytes < least) {
+				least = bytes;
+				q = p;
+				if (!bytes)
+					break;
+			}
 		}
 		p = _next_eng(cp, p);
 		if (q1 == p)
@@ -2405,6 +2444,8 @@ static int _qcrypto_queue_req(struct crypto_priv *cp,
 
 	if (pengine) {
 		ret = crypto_enqueue_request(&pengine->req_queue, req);
+		if (pengine->req_queue.qlen > pengine->max_qlen)
+			pengine->max_qlen = pengine->req_queue.qlen;
 	} else {
 		ret = crypto_enqueue_request(&cp->req_queue, req);
 		pengine = _avail_eng(cp);
@@ -4922,6 +4963,9 @@ static int  _qcrypto_probe(struct platform_device *pdev)
 	pengine->last_active_seq = 0;
 	pengine->check_flag = false;
 	pengine->max_req_used = 0;
+	pengine->max_qlen = 0;
+	pengine->max_inflight_bytes = 0;
+	atomic_long_set(&pengine->inflight_bytes, 0);
 	pengine->issue_req = false;
 
 	crypto_init_queue(&pengine->req_queue, MSM_QCRYPTO_REQ_QUEUE_LENGTH);
@@ -5466,6 +5510,8 @@ static ssize_t _debug_stats_write(struct file *file, const char __user *buf,
 		pe->err_req = 0;
 		qce_clear_driver_stats(pe->qce);
 		pe->max_req_used = 0;
+		pe->max_qlen = 0;
+		pe->max_inflight_bytes = 0;
 	}
 	cp->max_qlen = 0;
 	cp->resp_start = 0;
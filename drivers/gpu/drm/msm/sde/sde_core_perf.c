@@ -336,29 +336,62 @@ static u32 _sde_core_perf_get_core_clk_rate(struct sde_kms *kms,
 	return clk_rate;
 }
 
-void sde_core_perf_crtc_update(struct drm_crtc *crtc,
-		int params_changed, bool stop_req)
+/*
+ * Apply the votes cached in @perf, the bus vote before the clock so the
+ * bandwidth is available before the clock rate is increased.
+ */
+static void _sde_core_perf_crtc_apply(struct sde_kms *kms,
+		struct drm_crtc *crtc, struct sde_core_perf_params *perf,
+		int update_bus, int update_clk)
 {
-	struct sde_core_perf_params *new, *old;
-	int update_bus = 0, update_clk = 0;
+	struct msm_drm_private *priv = kms->dev->dev_private;
 	u32 clk_rate = 0;
-	struct sde_crtc *sde_crtc;
-	struct sde_crtc_state *sde_cstate;
 	int ret;
-	struct msm_drm_private *priv;
-	struct sde_kms *kms;
 
-	if (!crtc) {
-		SDE_ERROR("invalid crtc\n");
-		return;
-	}
+	/*
+	 * Calculate mdp clock before bandwidth calculation. If traffic shaper
+	 * is enabled and clock increased, the bandwidth calculation can
+	 * use the new clock for the rotator bw calculation.
+	 */
+	if (update_clk)
+		clk_rate = _sde_core_perf_get_core_clk_rate(kms, perf, crtc);
 
-	kms = _sde_crtc_get_kms(crtc);
-	if (!kms || !kms->catalog) {
-		SDE_ERROR("invalid kms\n");
-		return;
+	if (update_bus)
+		_sde_core_perf_crtc_update_bus(kms, crtc, clk_rate);
+
+	if (update_clk) {
+		SDE_ATRACE_INT(kms->perf.clk_name, clk_rate);
+
+		ret = sde_power_clk_set_rate(&priv->phandle,
+				kms->perf.clk_name, clk_rate);
+		if (ret) {
+			SDE_ERROR("failed to set %s clock rate %u\n",
+					kms->perf.clk_name, clk_rate);
+			return;
+		}
+
+		kms->perf.core_clk_rate = clk_rate;
+		SDE_DEBUG("update clk rate = %d HZ\n", clk_rate);
 	}
-	priv = kms->dev->dev_private;
+}
+
+static void _sde_core_perf_params_max(struct sde_core_perf_params *dst,
+		const struct sde_core_perf_params *src)
+{
+	dst->bw_ctl = max(dst->bw_ctl, src->bw_ctl);
+	dst->max_per_pipe_ib = max(dst->max_per_pipe_ib, src->max_per_pipe_ib);
+	dst->core_clk_rate = max(dst->core_clk_rate, src->core_clk_rate);
+}
+
+/* Called with perf_lock held */
+static void _sde_core_perf_crtc_update(struct sde_kms *kms,
+		struct drm_crtc *crtc, int params_changed, bool stop_req,
+		bool delayed)
+{
+	struct sde_core_perf_params *new, *old, target;
+	int update_bus = 0, update_clk = 0;
+	struct sde_crtc *sde_crtc;
+	struct sde_crtc_state *sde_cstate;
 
 	sde_crtc = to_sde_crtc(crtc);
 	sde_cstate = to_sde_crtc_state(crtc->state);
@@ -374,14 +407,47 @@ void sde_core_perf_crtc_update(struct drm_crtc *crtc,
 	 * perf update that happens post kickoff.
 	 */
 
-	if (params_changed)
+	if (params_changed) {
 		memcpy(&sde_crtc->new_perf, &sde_cstate->new_perf,
 			   sizeof(struct sde_core_perf_params));
 
+		/* the queued commits pre-voted for have now been flushed */
+		memset(&sde_crtc->pending_perf, 0,
+				sizeof(sde_crtc->pending_perf));
+		sde_crtc->perf_down_pending = false;
+	}
+
 	old = &sde_crtc->cur_perf;
 	new = &sde_crtc->new_perf;
 
 	if (_sde_core_perf_crtc_is_power_on(crtc) && !stop_req) {
+		/*
+		 * Never drop below what a commit still queued behind its
+		 * fences was pre-voted for.
+		 */
+		target = *new;
+		if (!params_changed)
+			_sde_core_perf_params_max(&target,
+					&sde_crtc->pending_perf);
+
+		/*
+		 * Hold a lower vote for the hysteresis period, so a workload
+		 * alternating between light and heavy frames does not go
+		 * through a bus and clock change on every frame.
+		 */
+		if (!params_changed && !delayed &&
+				kms->perf.down_hysteresis_ms &&
+				(target.bw_ctl < old->bw_ctl ||
+				 target.core_clk_rate < old->core_clk_rate)) {
+			sde_crtc->perf_down_pending = true;
+			mod_delayed_work(system_wq, &sde_crtc->perf_down_work,
+				msecs_to_jiffies(kms->perf.down_hysteresis_ms));
+			SDE_EVT32(DRMID(crtc), target.bw_ctl, old->bw_ctl,
+					target.core_clk_rate,
+					old->core_clk_rate);
+			goto end;
+		}
+
 		/*
 		 * cases for bus bandwidth update.
 		 * 1. new bandwidth vote or writeback output vote
@@ -389,65 +455,147 @@ void sde_core_perf_crtc_update(struct drm_crtc *crtc,
 		 * 2. new bandwidth vote or writeback output vote are
 		 *    lower than current vote at end of commit or stop.
 		 */
-		if ((params_changed && ((new->bw_ctl > old->bw_ctl))) ||
-		    (!params_changed && ((new->bw_ctl < old->bw_ctl)))) {
+		if ((params_changed && ((target.bw_ctl > old->bw_ctl))) ||
+		    (!params_changed && ((target.bw_ctl < old->bw_ctl)))) {
 			SDE_DEBUG("crtc=%d p=%d new_bw=%llu,old_bw=%llu\n",
-				crtc->base.id, params_changed, new->bw_ctl,
+				crtc->base.id, params_changed, target.bw_ctl,
 				old->bw_ctl);
-			old->bw_ctl = new->bw_ctl;
-			old->max_per_pipe_ib = new->max_per_pipe_ib;
+			old->bw_ctl = target.bw_ctl;
+			old->max_per_pipe_ib = target.max_per_pipe_ib;
 			update_bus = 1;
 		}
 
 		if ((params_changed &&
-				(new->core_clk_rate > old->core_clk_rate)) ||
+				(target.core_clk_rate > old->core_clk_rate)) ||
 				(!params_changed &&
-				(new->core_clk_rate < old->core_clk_rate))) {
-			old->core_clk_rate = new->core_clk_rate;
+				(target.core_clk_rate < old->core_clk_rate))) {
+			old->core_clk_rate = target.core_clk_rate;
 			update_clk = 1;
 		}
 	} else {
 		SDE_DEBUG("crtc=%d disable\n", crtc->base.id);
 		memset(old, 0, sizeof(*old));
 		memset(new, 0, sizeof(*new));
+		memset(&sde_crtc->pending_perf, 0,
+				sizeof(sde_crtc->pending_perf));
+		sde_crtc->perf_down_pending = false;
 		update_bus = 1;
 		update_clk = 1;
 	}
 
-	/*
-	 * Calculate mdp clock before bandwidth calculation. If traffic shaper
-	 * is enabled and clock increased, the bandwidth calculation can
-	 * use the new clock for the rotator bw calculation.
-	 */
+	_sde_core_perf_crtc_apply(kms, crtc, old, update_bus, update_clk);
+
 	if (update_clk)
-		clk_rate = _sde_core_perf_get_core_clk_rate(kms, old, crtc);
+		SDE_EVT32(kms->dev, stop_req, kms->perf.core_clk_rate,
+				params_changed, old->core_clk_rate,
+				new->core_clk_rate);
 
-	if (update_bus)
-		_sde_core_perf_crtc_update_bus(kms, crtc, clk_rate);
+end:
+	SDE_ATRACE_END(__func__);
+}
 
-	/*
-	 * Update the clock after bandwidth vote to ensure
-	 * bandwidth is available before clock rate is increased.
-	 */
-	if (update_clk) {
-		SDE_ATRACE_INT(kms->perf.clk_name, clk_rate);
-		SDE_EVT32(kms->dev, stop_req, clk_rate, params_changed,
-				  old->core_clk_rate, new->core_clk_rate);
+void sde_core_perf_crtc_update(struct drm_crtc *crtc,
+		int params_changed, bool stop_req)
+{
+	struct sde_crtc *sde_crtc;
+	struct sde_kms *kms;
 
-		ret = sde_power_clk_set_rate(&priv->phandle,
-				kms->perf.clk_name, clk_rate);
-		if (ret) {
-			SDE_ERROR("failed to set %s clock rate %u\n",
-					kms->perf.clk_name, clk_rate);
-			goto end;
-		}
+	if (!crtc) {
+		SDE_ERROR("invalid crtc\n");
+		return;
+	}
 
-		kms->perf.core_clk_rate = clk_rate;
-		SDE_DEBUG("update clk rate = %d HZ\n", clk_rate);
+	kms = _sde_crtc_get_kms(crtc);
+	if (!kms || !kms->catalog) {
+		SDE_ERROR("invalid kms\n");
+		return;
 	}
 
-end:
-	SDE_ATRACE_END(__func__);
+	sde_crtc = to_sde_crtc(crtc);
+
+	/* a delayed lower vote would be stale once the crtc is stopped */
+	if (stop_req)
+		cancel_delayed_work_sync(&sde_crtc->perf_down_work);
+
+	mutex_lock(&kms->perf.perf_lock);
+	_sde_core_perf_crtc_update(kms, crtc, params_changed, stop_req, false);
+	mutex_unlock(&kms->perf.perf_lock);
+}
+
+void sde_core_perf_crtc_down_work(struct work_struct *work)
+{
+	struct sde_crtc *sde_crtc = container_of(to_delayed_work(work),
+			struct sde_crtc, perf_down_work);
+	struct drm_crtc *crtc = &sde_crtc->base;
+	struct sde_kms *kms;
+
+	kms = _sde_crtc_get_kms(crtc);
+	if (!kms || !kms->catalog)
+		return;
+
+	mutex_lock(&kms->perf.perf_lock);
+	if (sde_crtc->perf_down_pending) {
+		sde_crtc->perf_down_pending = false;
+		_sde_core_perf_crtc_update(kms, crtc, 0, false, true);
+	}
+	mutex_unlock(&kms->perf.perf_lock);
+}
+
+void sde_core_perf_crtc_prepare(struct drm_crtc *crtc)
+{
+	struct sde_core_perf_params *pending, *old;
+	int update_bus = 0, update_clk = 0;
+	struct sde_crtc *sde_crtc;
+	struct sde_crtc_state *sde_cstate;
+	struct sde_kms *kms;
+
+	if (!crtc || !crtc->state) {
+		SDE_ERROR("invalid crtc\n");
+		return;
+	}
+
+	kms = _sde_crtc_get_kms(crtc);
+	if (!kms || !kms->catalog) {
+		SDE_ERROR("invalid kms\n");
+		return;
+	}
+
+	/* a crtc being enabled is voted for by the atomic flush */
+	if (!kms->perf.enable_prevote || !_sde_core_perf_crtc_is_power_on(crtc))
+		return;
+
+	sde_crtc = to_sde_crtc(crtc);
+	sde_cstate = to_sde_crtc_state(crtc->state);
+
+	mutex_lock(&kms->perf.perf_lock);
+
+	pending = &sde_crtc->pending_perf;
+	old = &sde_crtc->cur_perf;
+	_sde_core_perf_params_max(pending, &sde_cstate->new_perf);
+
+	/* the queued commit needs at least the current votes */
+	sde_crtc->perf_down_pending = false;
+
+	if (pending->bw_ctl > old->bw_ctl) {
+		old->bw_ctl = pending->bw_ctl;
+		old->max_per_pipe_ib = max(old->max_per_pipe_ib,
+				pending->max_per_pipe_ib);
+		update_bus = 1;
+	}
+
+	if (pending->core_clk_rate > old->core_clk_rate) {
+		old->core_clk_rate = pending->core_clk_rate;
+		update_clk = 1;
+	}
+
+	if (update_bus || update_clk) {
+		SDE_EVT32(DRMID(crtc), pending->bw_ctl,
+				pending->core_clk_rate, update_bus, update_clk);
+		_sde_core_perf_crtc_apply(kms, crtc, old, update_bus,
+				update_clk);
+	}
+
+	mutex_unlock(&kms->perf.perf_lock);
 }
 
 #ifdef CONFIG_DEBUG_FS
@@ -553,6 +701,10 @@ static int sde_debugfs_core_perf_init(struct sde_core_perf *perf,
 			&perf->core_clk_rate);
 	debugfs_create_u32("enable_bw_release", 0644, perf->debugfs_root,
 			(u32 *)&perf->enable_bw_release);
+	debugfs_create_u32("enable_prevote", 0644, perf->debugfs_root,
+			&perf->enable_prevote);
+	debugfs_create_u32("down_hysteresis_ms", 0644, perf->debugfs_root,
+			&perf->down_hysteresis_ms);
 	debugfs_create_u32("threshold_low", 0644, perf->debugfs_root,
 			(u32 *)&catalog->perf.max_bw_low);
 	debugfs_create_u32("threshold_high", 0644, perf->debugfs_root,
@@ -611,6 +763,8 @@ int sde_core_perf_init(struct sde_core_perf *perf,
 	perf->pclient = pclient;
 	perf->clk_name = clk_name;
 	mutex_init(&perf->perf_lock);
+	perf->enable_prevote = 1;
+	perf->down_hysteresis_ms = SDE_PERF_DOWN_HYSTERESIS_MS;
 
 	perf->core_clk = sde_power_clk_get_clk(phandle, clk_name);
 	if (!perf->core_clk) {
@@ -16,11 +16,15 @@
 #include <linux/types.h>
 #include <linux/dcache.h>
 #include <linux/mutex.h>
+#include <linux/workqueue.h>
 #include <drm/drm_crtc.h>
 
 #include "sde_hw_catalog.h"
 #include "sde_power_handle.h"
 
+/* default delay before a lower bandwidth and clock vote is applied */
+#define SDE_PERF_DOWN_HYSTERESIS_MS	32
+
 /**
  * struct sde_core_perf_params - definition of performance parameters
  * @max_per_pipe_ib: maximum instantaneous bandwidth request
@@ -57,6 +61,9 @@ struct sde_core_perf_tune {
  * @max_core_clk_rate: maximum allowable core clock rate
  * @perf_tune: debug control for performance tuning
  * @enable_bw_release: debug control for bandwidth release
+ * @enable_prevote: debug control for voting up when a commit is queued
+ * @down_hysteresis_ms: delay before applying a lower vote, 0 to apply
+ *	it at frame done
  */
 struct sde_core_perf {
 	struct drm_device *dev;
@@ -71,6 +78,8 @@ struct sde_core_perf {
 	u64 max_core_clk_rate;
 	struct sde_core_perf_tune perf_tune;
 	u32 enable_bw_release;
+	u32 enable_prevote;
+	u32 down_hysteresis_ms;
 };
 
 /**
@@ -91,6 +100,21 @@ int sde_core_perf_crtc_check(struct drm_crtc *crtc,
 void sde_core_perf_crtc_update(struct drm_crtc *crtc,
 		int params_changed, bool stop_req);
 
+/**
+ * sde_core_perf_crtc_prepare - vote for a commit queued on the given crtc
+ * @crtc: Pointer to crtc, its state being the one of the queued commit
+ *
+ * Raises the votes to what the queued commit needs ahead of its kickoff,
+ * lower votes are left to the update at frame done.
+ */
+void sde_core_perf_crtc_prepare(struct drm_crtc *crtc);
+
+/**
+ * sde_core_perf_crtc_down_work - apply a lower vote after the hysteresis
+ * @work: Pointer to the delayed work of the crtc
+ */
+void sde_core_perf_crtc_down_work(struct work_struct *work);
+
 /**
  * sde_core_perf_crtc_release_bw - release bandwidth of the given crtc
  * @crtc: Pointer to crtc
@@ -81,6 +81,8 @@ static void sde_crtc_destroy(struct drm_crtc *crtc)
 	if (!crtc)
 		return;
 
+	cancel_delayed_work_sync(&sde_crtc->perf_down_work);
+
 	if (sde_crtc->blob_info)
 		drm_property_unreference_blob(sde_crtc->blob_info);
 	msm_property_destroy(&sde_crtc->property_info);
@@ -380,6 +382,9 @@ void sde_crtc_prepare_commit(struct drm_crtc *crtc,
 
 	/* prepare main output fence */
 	sde_fence_prepare(&sde_crtc->output_fence);
+
+	/* the commit is queued behind its fences, vote for it already */
+	sde_core_perf_crtc_prepare(crtc);
 }
 
 bool sde_crtc_is_rt(struct drm_crtc *crtc)
@@ -663,6 +668,45 @@ static void _sde_crtc_set_input_fence_timeout(struct sde_crtc_state *cstate)
 	cstate->input_fence_timeout_ns *= NSEC_PER_MSEC;
 }
 
+/**
+ * _sde_crtc_wait_for_fences_async - wait for all the incoming fences at once
+ * @crtc: Pointer to CRTC object
+ * @timeout_ms: Time to wait for the last fence, in milliseconds
+ * Returns: Zero when all fences signalled, -ETIME or -ENOMEM otherwise
+ */
+static int _sde_crtc_wait_for_fences_async(struct drm_crtc *crtc,
+		uint32_t timeout_ms)
+{
+	struct drm_plane *plane = NULL;
+	void **fences;
+	uint32_t count = 0, max;
+	void *fence;
+	int ret;
+
+	max = hweight32(crtc->state->plane_mask);
+	if (!max)
+		return 0;
+
+	fences = kcalloc(max, sizeof(*fences), GFP_KERNEL);
+	if (!fences)
+		return -ENOMEM;
+
+	drm_atomic_crtc_for_each_plane(plane, crtc) {
+		if (!plane->state || count >= max)
+			continue;
+
+		fence = to_sde_plane_state(plane->state)->input_fence;
+		if (fence)
+			fences[count++] = fence;
+	}
+
+	ret = sde_sync_wait_multiple(fences, count, timeout_ms);
+	SDE_EVT32(DRMID(crtc), count, -ret);
+
+	kfree(fences);
+	return ret;
+}
+
 /**
  * _sde_crtc_wait_for_fences - wait for incoming framebuffer sync fences
  * @crtc: Pointer to CRTC object
@@ -684,16 +728,27 @@ static void _sde_crtc_wait_for_fences(struct drm_crtc *crtc)
 	kt_end = ktime_add_ns(ktime_get(),
 		to_sde_crtc_state(crtc->state)->input_fence_timeout_ns);
 
+	SDE_ATRACE_BEGIN("plane_wait_input_fence");
+
+	/*
+	 * Sleep once until the last fence signals, rather than once per fence.
+	 * Afterwards each fence is only checked, so that each plane can react
+	 * appropriately if its fence has timed out.
+	 */
+	if (_sde_crtc_wait_for_fences_async(crtc,
+			max_t(s64, ktime_ms_delta(kt_end, ktime_get()), 0)) !=
+			-ENOMEM)
+		wait_ms = 0;
+
 	/*
-	 * Wait for fences sequentially, as all of them need to be signalled
-	 * before we can proceed.
+	 * Without memory for the callbacks, wait for fences sequentially, as
+	 * all of them need to be signalled before we can proceed.
 	 *
 	 * Limit total wait time to INPUT_FENCE_TIMEOUT, but still call
 	 * sde_plane_wait_input_fence with wait_ms == 0 after the timeout so
 	 * that each plane can check its fence status and react appropriately
 	 * if its fence has timed out.
 	 */
-	SDE_ATRACE_BEGIN("plane_wait_input_fence");
 	drm_atomic_crtc_for_each_plane(plane, crtc) {
 		if (wait_ms) {
 			/* determine updated wait time */
@@ -708,6 +763,25 @@ static void _sde_crtc_wait_for_fences(struct drm_crtc *crtc)
 	SDE_ATRACE_END("plane_wait_input_fence");
 }
 
+/**
+ * _sde_crtc_flush_planes - wait for the input fences and finalize planes
+ * @crtc: Pointer to CRTC object
+ */
+static void _sde_crtc_flush_planes(struct drm_crtc *crtc)
+{
+	struct drm_plane *plane;
+
+	_sde_crtc_wait_for_fences(crtc);
+
+	/*
+	 * Final plane updates: Give each plane a chance to complete all
+	 *                      required writes/flushing before crtc's "flush
+	 *                      everything" call below.
+	 */
+	drm_atomic_crtc_for_each_plane(plane, crtc)
+		sde_plane_flush(plane);
+}
+
 static void _sde_crtc_setup_mixer_for_encoder(
 		struct drm_crtc *crtc,
 		struct drm_encoder *enc)
@@ -841,7 +915,6 @@ static void sde_crtc_atomic_flush(struct drm_crtc *crtc,
 {
 	struct sde_crtc *sde_crtc;
 	struct drm_device *dev;
-	struct drm_plane *plane;
 	unsigned long flags;
 
 	if (!crtc) {
@@ -878,19 +951,18 @@ static void sde_crtc_atomic_flush(struct drm_crtc *crtc,
 	if (unlikely(!sde_crtc->num_mixers))
 		return;
 
-	/* wait for acquire fences before anything else is done */
-	_sde_crtc_wait_for_fences(crtc);
-
 	/* update performance setting before crtc kickoff */
 	sde_core_perf_crtc_update(crtc, 1, false);
 
 	/*
-	 * Final plane updates: Give each plane a chance to complete all
-	 *                      required writes/flushing before crtc's "flush
-	 *                      everything" call below.
+	 * The planes are programmed already and only latch on the ctl flush,
+	 * so the wait for the acquire fences is deferred to the kickoff. The
+	 * other crtcs of the commit are then not held back by these fences.
 	 */
-	drm_atomic_crtc_for_each_plane(plane, crtc)
-		sde_plane_flush(plane);
+	if (crtc->state->active)
+		sde_crtc->fences_pending = true;
+	else
+		_sde_crtc_flush_planes(crtc);
 
 	/* Kickoff will be scheduled by outer layer */
 }
@@ -948,6 +1020,11 @@ void sde_crtc_commit_kickoff(struct drm_crtc *crtc)
 	if (unlikely(!sde_crtc->num_mixers))
 		return;
 
+	/* wait for acquire fences before anything is flushed */
+	if (sde_crtc->fences_pending) {
+		sde_crtc->fences_pending = false;
+		_sde_crtc_flush_planes(crtc);
+	}
 
 	SDE_ATRACE_BEGIN("crtc_commit");
 	list_for_each_entry(encoder, &dev->mode_config.encoder_list, head) {
@@ -2007,6 +2084,8 @@ struct drm_crtc *sde_crtc_init(struct drm_device *dev,
 		init_kthread_work(&sde_crtc->frame_events[i].work,
 				sde_crtc_frame_event_work);
 	}
+	INIT_DELAYED_WORK(&sde_crtc->perf_down_work,
+			sde_core_perf_crtc_down_work);
 
 	drm_crtc_init_with_planes(dev, crtc, plane, NULL, &sde_crtc_funcs);
 
@@ -91,12 +91,17 @@ struct sde_crtc_frame_event {
  * @dirty_list    : list of color processing features are dirty
  * @crtc_lock     : crtc lock around create, destroy and access.
  * @frame_pending : Whether or not an update is pending
+ * @fences_pending : Whether the acquire fences of the flushed commit are
+ *	still to be waited for at kickoff
  * @frame_events  : static allocation of in-flight frame events
  * @frame_event_list : available frame event list
  * @pending       : Whether any page-flip events are pending signal
  * @spin_lock     : spin lock for frame event, transaction status, etc...
  * @cur_perf      : current performance committed to clock/bandwidth driver
  * @new_perf      : new performance committed to clock/bandwidth driver
+ * @pending_perf  : performance pre-voted for commits queued but not flushed
+ * @perf_down_work : delayed work applying a lower vote
+ * @perf_down_pending : whether @perf_down_work still has a vote to apply
  */
 struct sde_crtc {
 	struct drm_crtc base;
@@ -133,12 +138,16 @@ struct sde_crtc {
 	struct mutex crtc_lock;
 
 	atomic_t frame_pending;
+	bool fences_pending;
 	struct sde_crtc_frame_event frame_events[SDE_CRTC_FRAME_EVENT_SIZE];
 	struct list_head frame_event_list;
 	spinlock_t spin_lock;
 
 	struct sde_core_perf_params cur_perf;
 	struct sde_core_perf_params new_perf;
+	struct sde_core_perf_params pending_perf;
+	struct delayed_work perf_down_work;
+	bool perf_down_pending;
 };
 
 #define to_sde_crtc(x) container_of(x, struct sde_crtc, base)
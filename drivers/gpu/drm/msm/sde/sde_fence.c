@@ -10,6 +10,8 @@
  * GNU General Public License for more details.
  */
 
+#include <linux/slab.h>
+#include <linux/wait.h>
 #include <sync.h>
 #include <sw_sync.h>
 #include "msm_drv.h"
@@ -35,6 +37,79 @@ int sde_sync_wait(void *fence, long timeout_ms)
 	return sync_fence_wait(fence, timeout_ms);
 }
 
+/**
+ * struct sde_sync_waiter - waiter of sde_sync_wait_multiple
+ * @base: Sync framework waiter, registered on the fence
+ * @fence: Fence @base is registered on, NULL if it was signalled already
+ * @pending: Number of fences of the wait not signalled yet
+ * @wq: Wait queue the caller sleeps on
+ */
+struct sde_sync_waiter {
+	struct sync_fence_waiter base;
+	struct sync_fence *fence;
+	atomic_t *pending;
+	wait_queue_head_t *wq;
+};
+
+static void _sde_sync_waiter_cb(struct sync_fence *fence,
+		struct sync_fence_waiter *base)
+{
+	struct sde_sync_waiter *waiter =
+		container_of(base, struct sde_sync_waiter, base);
+
+	if (atomic_dec_and_test(waiter->pending))
+		wake_up(waiter->wq);
+}
+
+int sde_sync_wait_multiple(void **fences, uint32_t count, long timeout_ms)
+{
+	DECLARE_WAIT_QUEUE_HEAD_ONSTACK(wq);
+	struct sde_sync_waiter *waiters;
+	atomic_t pending;
+	uint32_t i;
+	int ret = 0;
+
+	if (!count)
+		return 0;
+
+	waiters = kcalloc(count, sizeof(*waiters), GFP_KERNEL);
+	if (!waiters)
+		return -ENOMEM;
+
+	/* hold one count until all the callbacks are registered */
+	atomic_set(&pending, 1);
+
+	for (i = 0; i < count; ++i) {
+		if (!fences[i])
+			continue;
+
+		sync_fence_waiter_init(&waiters[i].base, _sde_sync_waiter_cb);
+		waiters[i].pending = &pending;
+		waiters[i].wq = &wq;
+
+		atomic_inc(&pending);
+		if (sync_fence_wait_async(fences[i], &waiters[i].base))
+			/* signalled or in error, there is nothing to wait for */
+			atomic_dec(&pending);
+		else
+			waiters[i].fence = fences[i];
+	}
+
+	if (!atomic_dec_and_test(&pending) &&
+			!wait_event_timeout(wq, !atomic_read(&pending),
+				msecs_to_jiffies(timeout_ms)))
+		ret = -ETIME;
+
+	/* the callbacks run under the fence lock, taken by the cancel */
+	for (i = 0; i < count; ++i)
+		if (waiters[i].fence)
+			sync_fence_cancel_async(waiters[i].fence,
+					&waiters[i].base);
+
+	kfree(waiters);
+	return ret;
+}
+
 uint32_t sde_sync_get_name_prefix(void *fence)
 {
 	char *name;
@@ -53,6 +53,20 @@ void sde_sync_put(void *fence);
  */
 int sde_sync_wait(void *fence, long timeout_ms);
 
+/**
+ * sde_sync_wait_multiple - Wait for several sync fence objects at once
+ *
+ * Callbacks are registered on all the fences that are not signalled yet,
+ * and the caller sleeps until the last of them signals.
+ *
+ * @fences: Array of pointers to sync fences
+ * @count: Number of entries in @fences
+ * @timeout_ms: Time to wait, in milliseconds
+ *
+ * Return: Zero on success, -ETIME on timeout or -ENOMEM
+ */
+int sde_sync_wait_multiple(void **fences, uint32_t count, long timeout_ms);
+
 /**
  * sde_sync_get_name_prefix - get integer representation of fence name prefix
  * @fence: Pointer to opaque fence structure
@@ -76,6 +90,12 @@ static inline int sde_sync_wait(void *fence, long timeout_ms)
 	return 0;
 }
 
+static inline int sde_sync_wait_multiple(void **fences, uint32_t count,
+		long timeout_ms)
+{
+	return 0;
+}
+
 static inline uint32_t sde_sync_get_name_prefix(void *fence)
 {
 	return 0x0;
@@ -110,6 +110,8 @@ struct sde_phy_plane {
 	struct sde_hw_sharp_cfg sharp_cfg;
 	struct sde_hw_scaler3_cfg *scaler3_cfg;
 	struct sde_hw_pipe_qos_cfg pipe_qos_cfg;
+	struct sde_hw_pipe_qos_cfg pipe_qos_cfg_hw;
+	bool qos_cfg_valid;
 	uint32_t color_fill;
 	bool is_rt_pipe;
 
@@ -448,8 +450,15 @@ static void _sde_plane_set_qos_ctrl(struct sde_phy_plane *pp,
 		pp->pipe_qos_cfg.danger_vblank,
 		pp->is_rt_pipe);
 
+	/* every flip sets this, only write it when it changes */
+	if (pp->qos_cfg_valid && !memcmp(&pp->pipe_qos_cfg_hw,
+			&pp->pipe_qos_cfg, sizeof(pp->pipe_qos_cfg)))
+		return;
+
 	pp->pipe_hw->ops.setup_qos_ctrl(pp->pipe_hw,
 			&pp->pipe_qos_cfg);
+	pp->pipe_qos_cfg_hw = pp->pipe_qos_cfg;
+	pp->qos_cfg_valid = true;
 }
 
 static int sde_plane_danger_signal_ctrl(struct sde_phy_plane *pp, bool enable)
@@ -1301,6 +1310,10 @@ static int _sde_plane_mode_set(struct drm_plane *plane,
 			memset(&(pp->pipe_cfg), 0,
 					sizeof(struct sde_hw_pipe_cfg));
 
+		/* the pipe may have lost its registers, program everything */
+		if (pstate->dirty == SDE_PLANE_DIRTY_ALL)
+			pp->qos_cfg_valid = false;
+
 		_sde_plane_set_scanout(pp, pstate, &pp->pipe_cfg, fb);
 
 		pstate->pending = true;
@@ -63,12 +63,15 @@ struct sde_rm_requirements {
  *		CRTCs may be connected to multiple Encoders.
  *		An encoder or connector id identifies the display path.
  * @topology	DRM<->HW topology use case
+ * @reqs:	Requirements the reservation was made for, before any
+ *		adjustment made while reserving
  */
 struct sde_rm_rsvp {
 	struct list_head list;
 	uint32_t seq;
 	uint32_t enc_id;
 	enum sde_rm_topology_name topology;
+	struct sde_rm_requirements reqs;
 };
 
 /**
@@ -1196,6 +1199,23 @@ static int _sde_rm_commit_rsvp(
 	return ret;
 }
 
+static bool _sde_rm_reqs_equal(
+		struct sde_rm_requirements *a,
+		struct sde_rm_requirements *b)
+{
+	return a->top_name == b->top_name &&
+		a->top_ctrl == b->top_ctrl &&
+		a->num_lm == b->num_lm &&
+		a->num_ctl == b->num_ctl &&
+		a->needs_split_display == b->needs_split_display &&
+		a->hw_res.needs_cdm == b->hw_res.needs_cdm &&
+		a->hw_res.display_num_of_h_tiles ==
+			b->hw_res.display_num_of_h_tiles &&
+		!memcmp(a->hw_res.intfs, b->hw_res.intfs,
+			sizeof(a->hw_res.intfs)) &&
+		!memcmp(a->hw_res.wbs, b->hw_res.wbs, sizeof(a->hw_res.wbs));
+}
+
 int sde_rm_check_property_topctl(uint64_t val)
 {
 	if ((BIT(SDE_RM_TOPCTL_FORCE_TILING) & val) &&
@@ -1241,6 +1261,26 @@ int sde_rm_reserve(
 		return ret;
 	}
 
+	/*
+	 * A modeset that keeps the topology, e.g. a refresh rate switch or
+	 * the test-only checks repeated by the compositor, can keep the
+	 * blocks it already holds instead of reserving and swapping them.
+	 */
+	rsvp_cur = _sde_rm_get_rsvp(rm, enc);
+	if (rsvp_cur && !RM_RQ_CLEAR(&reqs) &&
+			_sde_rm_reqs_equal(&rsvp_cur->reqs, &reqs)) {
+		SDE_DEBUG("reuse rsvp[s%de%d] test_only %d\n",
+				rsvp_cur->seq, rsvp_cur->enc_id, test_only);
+		if (test_only)
+			return 0;
+		return msm_property_set_property(
+				sde_connector_get_propinfo(
+						conn_state->connector),
+				sde_connector_get_property_values(conn_state),
+				CONNECTOR_PROP_TOPOLOGY_NAME,
+				rsvp_cur->topology);
+	}
+
 	/*
 	 * We only support one active reservation per-hw-block. But to implement
 	 * transactional semantics for test-only, and for allowing failure while
@@ -1255,8 +1295,7 @@ int sde_rm_reserve(
 	rsvp_nxt = kzalloc(sizeof(*rsvp_nxt), GFP_KERNEL);
 	if (!rsvp_nxt)
 		return -ENOMEM;
-
-	rsvp_cur = _sde_rm_get_rsvp(rm, enc);
+	rsvp_nxt->reqs = reqs;
 
 	/*
 	 * User can request that we clear out any reservation during the
@@ -873,6 +873,7 @@ static int adreno_probe(struct platform_device *pdev)
 	adreno_profile_init(adreno_dev);
 
 	adreno_sysfs_init(adreno_dev);
+	adreno_telemetry_init(adreno_dev);
 
 	kgsl_pwrscale_init(&pdev->dev, CONFIG_QCOM_ADRENO_DEFAULT_GOVERNOR);
 
@@ -927,6 +928,7 @@ static int adreno_remove(struct platform_device *pdev)
 	/* The memory is fading */
 	_adreno_free_memories(adreno_dev);
 
+	adreno_telemetry_close(adreno_dev);
 	adreno_sysfs_close(adreno_dev);
 
 	adreno_coresight_remove(adreno_dev);
@@ -316,6 +316,28 @@ struct adreno_gpu_core {
 	unsigned int max_power;
 };
 
+/**
+ * struct adreno_telemetry - Always-on GPU counter sampling ring
+ * @lock: Serializes the producers, retirement runs per ringbuffer
+ * @enabled: True while the counters are reserved and sampled
+ * @header: Start of the ring shared with user space
+ * @entries: Entries following @header
+ * @size: Size of the ring allocation in bytes
+ * @lo: Low dword register of each sampled counter
+ * @hi: High dword register of each sampled counter
+ * @last: Value of each counter at the previous sample
+ */
+struct adreno_telemetry {
+	spinlock_t lock;
+	bool enabled;
+	struct kgsl_telemetry_header *header;
+	struct kgsl_telemetry_entry *entries;
+	size_t size;
+	unsigned int lo[KGSL_TELEMETRY_COUNTERS];
+	unsigned int hi[KGSL_TELEMETRY_COUNTERS];
+	uint64_t last[KGSL_TELEMETRY_COUNTERS];
+};
+
 /**
  * struct adreno_device - The mothership structure for all adreno related info
  * @dev: Reference to struct kgsl_device
@@ -373,6 +395,7 @@ struct adreno_gpu_core {
  * @irq_storm_work: Worker to handle possible interrupt storms
  * @active_list: List to track active contexts
  * @active_list_lock: Lock to protect active_list
+ * @telemetry: Always-on GPU counter sampling ring
  */
 struct adreno_device {
 	struct kgsl_device dev;    /* Must be first field in this struct */
@@ -438,6 +461,8 @@ struct adreno_device {
 
 	struct list_head active_list;
 	spinlock_t active_list_lock;
+
+	struct adreno_telemetry telemetry;
 };
 
 /**
@@ -926,6 +951,13 @@ void adreno_cp_callback(struct adreno_device *adreno_dev, int bit);
 int adreno_sysfs_init(struct adreno_device *adreno_dev);
 void adreno_sysfs_close(struct adreno_device *adreno_dev);
 
+int adreno_telemetry_init(struct adreno_device *adreno_dev);
+void adreno_telemetry_close(struct adreno_device *adreno_dev);
+int adreno_telemetry_enable(struct adreno_device *adreno_dev, bool enable);
+void adreno_telemetry_start(struct adreno_device *adreno_dev);
+void adreno_telemetry_retire(struct adreno_device *adreno_dev,
+		struct kgsl_drawobj *drawobj);
+
 void adreno_irqctrl(struct adreno_device *adreno_dev, int state);
 
 long adreno_ioctl_perfcounter_get(struct kgsl_device_private *dev_priv,
@@ -78,6 +78,15 @@ unsigned int adreno_drawobj_timeout = 2000;
 /* Interval for reading and comparing fault detection registers */
 static unsigned int _fault_timer_interval = 200;
 
+/*
+ * Maximum number of commands a lower priority ringbuffer retires while holding
+ * the dispatcher mutex before giving higher priority ringbuffers a chance
+ */
+static unsigned int _dispatcher_retire_burst = 16;
+
+/* RT priority of the dispatcher thread of the highest priority ringbuffer */
+#define ADRENO_DISPATCH_RT_PRIO 16
+
 #define DRAWQUEUE_RB(_drawqueue) \
 	((struct adreno_ringbuffer *) \
 		container_of((_drawqueue),\
@@ -86,7 +95,8 @@ static unsigned int _fault_timer_interval = 200;
 #define DRAWQUEUE(_ringbuffer) (&(_ringbuffer)->dispatch_q)
 
 static int adreno_dispatch_retire_drawqueue(struct adreno_device *adreno_dev,
-		struct adreno_dispatcher_drawqueue *drawqueue);
+		struct adreno_dispatcher_drawqueue *drawqueue,
+		unsigned int limit);
 
 static inline bool drawqueue_is_current(
 		struct adreno_dispatcher_drawqueue *drawqueue)
@@ -374,6 +384,11 @@ static int _retire_markerobj(struct kgsl_drawobj_cmd *cmdobj,
 {
 	if (_marker_expired(cmdobj)) {
 		_pop_drawobj(drawctxt);
+
+		if (cmdobj->base.flags & KGSL_DRAWOBJ_END_OF_FRAME)
+			kgsl_pwrscale_frame_retire(cmdobj->base.device,
+				&drawctxt->base, 0, true);
+
 		_retire_timestamp(DRAWOBJ(cmdobj));
 		return 0;
 	}
@@ -600,6 +615,7 @@ static int sendcmd(struct adreno_device *adreno_dev,
 			del_timer_sync(&dispatcher->fault_timer);
 
 			fault_detect_read(adreno_dev);
+			adreno_telemetry_start(adreno_dev);
 
 			/* Start the fault timer on first submission */
 			start_fault_timer(adreno_dev);
@@ -656,6 +672,7 @@ static int sendcmd(struct adreno_device *adreno_dev,
 	mutex_unlock(&device->mutex);
 
 	cmdobj->submit_ticks = time.ticks;
+	cmdobj->submit_ktime = time.ktime;
 
 	dispatch_q->cmd_q[dispatch_q->tail] = cmdobj;
 	dispatch_q->tail = (dispatch_q->tail + 1) %
@@ -2138,7 +2155,7 @@ static int dispatcher_do_fault(struct adreno_device *adreno_dev)
 	 */
 	FOR_EACH_RINGBUFFER(adreno_dev, rb, i) {
 		adreno_dispatch_retire_drawqueue(adreno_dev,
-			&(rb->dispatch_q));
+			&(rb->dispatch_q), 0);
 		/* Select the active dispatch_q */
 		if (base == rb->buffer_desc.gpuaddr) {
 			dispatch_q = &(rb->dispatch_q);
@@ -2264,6 +2281,33 @@ static void cmdobj_profile_ticks(struct adreno_device *adreno_dev,
 	*retire = entry->retired;
 }
 
+/*
+ * Account the GPU time of a retired command for frame DCVS. Use the profiled
+ * start and retire ticks if there are any, otherwise the time since the
+ * command was submitted or since the previous command of the ringbuffer
+ * retired, whichever is later.
+ */
+static void _retire_frame_busy(struct adreno_device *adreno_dev,
+		struct kgsl_drawobj_cmd *cmdobj, uint64_t start, uint64_t end)
+{
+	struct kgsl_drawobj *drawobj = DRAWOBJ(cmdobj);
+	struct adreno_ringbuffer *rb = ADRENO_DRAWOBJ_RB(drawobj);
+	u64 now = local_clock();
+	u64 begin = max(cmdobj->submit_ktime, rb->retire_ktime);
+	u64 busy = 0;
+
+	if (end > start)
+		/* 19.2MHz always on ticks to ns */
+		busy = div_u64((end - start) * 10000, 192);
+	else if (now > begin)
+		busy = now - begin;
+
+	rb->retire_ktime = now;
+
+	kgsl_pwrscale_frame_retire(KGSL_DEVICE(adreno_dev), drawobj->context,
+		busy, drawobj->flags & KGSL_DRAWOBJ_END_OF_FRAME);
+}
+
 static void retire_cmdobj(struct adreno_device *adreno_dev,
 		struct kgsl_drawobj_cmd *cmdobj)
 {
@@ -2280,6 +2324,8 @@ static void retire_cmdobj(struct adreno_device *adreno_dev,
 	if (test_bit(CMDOBJ_PROFILE, &cmdobj->priv))
 		cmdobj_profile_ticks(adreno_dev, cmdobj, &start, &end);
 
+	adreno_telemetry_retire(adreno_dev, drawobj);
+
 	/*
 	 * For A3xx we still get the rptr from the CP_RB_RPTR instead of
 	 * rptr scratch out address. At this point GPU clocks turned off.
@@ -2301,11 +2347,18 @@ static void retire_cmdobj(struct adreno_device *adreno_dev,
 	drawctxt->ticks_index = (drawctxt->ticks_index + 1) %
 		SUBMIT_RETIRE_TICKS_SIZE;
 
+	_retire_frame_busy(adreno_dev, cmdobj, start, end);
+
 	kgsl_drawobj_destroy(drawobj);
 }
 
+/*
+ * Retire the completed commands of @drawqueue, at most @limit of them unless
+ * @limit is 0
+ */
 static int adreno_dispatch_retire_drawqueue(struct adreno_device *adreno_dev,
-		struct adreno_dispatcher_drawqueue *drawqueue)
+		struct adreno_dispatcher_drawqueue *drawqueue,
+		unsigned int limit)
 {
 	struct kgsl_device *device = KGSL_DEVICE(adreno_dev);
 	struct adreno_dispatcher *dispatcher = &adreno_dev->dispatcher;
@@ -2331,6 +2384,8 @@ static int adreno_dispatch_retire_drawqueue(struct adreno_device *adreno_dev,
 			ADRENO_DISPATCH_DRAWQUEUE_SIZE);
 
 		count++;
+		if (limit && count >= limit)
+			break;
 	}
 
 	return count;
@@ -2362,9 +2417,11 @@ static void _adreno_dispatch_check_timeout(struct adreno_device *adreno_dev,
 }
 
 static int adreno_dispatch_process_drawqueue(struct adreno_device *adreno_dev,
-		struct adreno_dispatcher_drawqueue *drawqueue)
+		struct adreno_dispatcher_drawqueue *drawqueue,
+		unsigned int limit)
 {
-	int count = adreno_dispatch_retire_drawqueue(adreno_dev, drawqueue);
+	int count = adreno_dispatch_retire_drawqueue(adreno_dev, drawqueue,
+		limit);
 
 	/* Nothing to do if there are no pending commands */
 	if (adreno_drawqueue_is_empty(drawqueue))
@@ -2438,34 +2495,56 @@ static void _dispatcher_power_down(struct adreno_device *adreno_dev)
 	mutex_unlock(&device->mutex);
 }
 
+static inline bool _is_highest_rb(struct adreno_device *adreno_dev,
+		struct adreno_ringbuffer *rb)
+{
+	return rb == &adreno_dev->ringbuffers[0];
+}
+
+static inline void _dispatcher_schedule_rb(struct adreno_ringbuffer *rb)
+{
+	queue_kthread_work(&rb->dispatch_worker, &rb->dispatch_work);
+}
+
+/*
+ * Each ringbuffer has its own dispatcher thread that retires the commands of
+ * that ringbuffer. The thread of the highest priority ringbuffer is the one
+ * that gets scheduled for interrupts, timers and new submissions; it hands
+ * the retire pass of the other ringbuffers to their own threads so a long
+ * retire pass for a background context doesn't delay the submissions of the
+ * highest priority ones. Every thread then runs the rest of the dispatcher
+ * (fault handling, preemption and submission) under the dispatcher mutex.
+ */
 static void adreno_dispatcher_work(struct kthread_work *work)
 {
-	struct adreno_dispatcher *dispatcher =
-		container_of(work, struct adreno_dispatcher, work);
-	struct adreno_device *adreno_dev =
-		container_of(dispatcher, struct adreno_device, dispatcher);
+	struct adreno_ringbuffer *rb =
+		container_of(work, struct adreno_ringbuffer, dispatch_work);
+	struct adreno_device *adreno_dev = ADRENO_RB_DEVICE(rb);
+	struct adreno_dispatcher *dispatcher = &adreno_dev->dispatcher;
 	struct kgsl_device *device = KGSL_DEVICE(adreno_dev);
 	struct adreno_gpudev *gpudev = ADRENO_GPU_DEVICE(adreno_dev);
-	int count = 0;
-	unsigned int i = 0;
+	bool highest = _is_highest_rb(adreno_dev, rb);
+	unsigned int limit = highest ? 0 : _dispatcher_retire_burst;
+	struct adreno_ringbuffer *other;
+	bool more;
+	int count, i;
 
 	mutex_lock(&dispatcher->mutex);
 
-	/*
-	 * As long as there are inflight commands, process retired comamnds from
-	 * all drawqueues
-	 */
-	for (i = 0; i < adreno_dev->num_ringbuffers; i++) {
-		struct adreno_dispatcher_drawqueue *drawqueue =
-			DRAWQUEUE(&adreno_dev->ringbuffers[i]);
+	count = adreno_dispatch_process_drawqueue(adreno_dev, DRAWQUEUE(rb),
+		limit);
+	more = limit && count >= limit &&
+		!adreno_drawqueue_is_empty(DRAWQUEUE(rb));
 
-		count += adreno_dispatch_process_drawqueue(adreno_dev,
-			drawqueue);
-		if (dispatcher->inflight == 0)
-			break;
-	}
+	if (highest) {
+		FOR_EACH_RINGBUFFER(adreno_dev, other, i) {
+			if (other != rb &&
+				!adreno_drawqueue_is_empty(DRAWQUEUE(other)))
+				_dispatcher_schedule_rb(other);
+		}
 
-	kgsl_process_event_groups(device);
+		kgsl_process_event_groups(device);
+	}
 
 	/*
 	 * dispatcher_do_fault() returns 0 if no faults occurred. If that is the
@@ -2491,14 +2570,81 @@ static void adreno_dispatcher_work(struct kthread_work *work)
 		_dispatcher_power_down(adreno_dev);
 
 	mutex_unlock(&dispatcher->mutex);
+
+	/* Come back for the rest of the retired commands */
+	if (more)
+		_dispatcher_schedule_rb(rb);
 }
 
 void adreno_dispatcher_schedule(struct kgsl_device *device)
 {
 	struct adreno_device *adreno_dev = ADRENO_DEVICE(device);
-	struct adreno_dispatcher *dispatcher = &adreno_dev->dispatcher;
 
-	queue_kthread_work(&kgsl_driver.worker, &dispatcher->work);
+	_dispatcher_schedule_rb(&adreno_dev->ringbuffers[0]);
+}
+
+static void _dispatcher_flush_workers(struct adreno_device *adreno_dev)
+{
+	struct adreno_ringbuffer *rb;
+	int i;
+
+	FOR_EACH_RINGBUFFER(adreno_dev, rb, i) {
+		if (!IS_ERR_OR_NULL(rb->dispatch_thread))
+			flush_kthread_worker(&rb->dispatch_worker);
+	}
+}
+
+static void _dispatcher_stop_threads(struct adreno_device *adreno_dev)
+{
+	struct adreno_ringbuffer *rb;
+	int i;
+
+	FOR_EACH_RINGBUFFER(adreno_dev, rb, i) {
+		if (IS_ERR_OR_NULL(rb->dispatch_thread))
+			continue;
+
+		flush_kthread_worker(&rb->dispatch_worker);
+		kthread_stop(rb->dispatch_thread);
+		rb->dispatch_thread = NULL;
+	}
+}
+
+static int _dispatcher_start_threads(struct adreno_device *adreno_dev)
+{
+	struct sched_param param = { .sched_priority = ADRENO_DISPATCH_RT_PRIO };
+	struct adreno_ringbuffer *rb;
+	int i;
+
+	FOR_EACH_RINGBUFFER(adreno_dev, rb, i) {
+		init_kthread_worker(&rb->dispatch_worker);
+		init_kthread_work(&rb->dispatch_work, adreno_dispatcher_work);
+
+		if (_is_highest_rb(adreno_dev, rb))
+			rb->dispatch_thread = kthread_run_perf_critical(
+				kthread_worker_fn, &rb->dispatch_worker,
+				"kgsl_dispatch_rb%d", rb->id);
+		else
+			rb->dispatch_thread = kthread_run(kthread_worker_fn,
+				&rb->dispatch_worker, "kgsl_dispatch_rb%d",
+				rb->id);
+
+		if (IS_ERR(rb->dispatch_thread)) {
+			int ret = PTR_ERR(rb->dispatch_thread);
+
+			KGSL_DRV_ERR(KGSL_DEVICE(adreno_dev),
+				"unable to start dispatcher thread for rb%d: %d\n",
+				rb->id, ret);
+			_dispatcher_stop_threads(adreno_dev);
+			return ret;
+		}
+
+		/* Only the highest priority ringbuffer gets realtime */
+		if (_is_highest_rb(adreno_dev, rb))
+			sched_setscheduler(rb->dispatch_thread, SCHED_FIFO,
+				&param);
+	}
+
+	return 0;
 }
 
 /**
@@ -2635,6 +2781,8 @@ void adreno_dispatcher_close(struct adreno_device *adreno_dev)
 
 	mutex_unlock(&dispatcher->mutex);
 
+	_dispatcher_stop_threads(adreno_dev);
+
 	kobject_put(&dispatcher->kobj);
 }
 
@@ -2718,6 +2866,8 @@ static DISPATCHER_UINT_ATTR(dispatch_time_slice, 0644, 0,
 	adreno_dispatch_time_slice);
 static DISPATCHER_UINT_ATTR(dispatch_starvation_time, 0644, 0,
 	adreno_dispatch_starvation_time);
+static DISPATCHER_UINT_ATTR(retire_burst, 0644, ADRENO_DISPATCH_DRAWQUEUE_SIZE,
+	_dispatcher_retire_burst);
 
 static struct attribute *dispatcher_attrs[] = {
 	&dispatcher_attr_inflight.attr,
@@ -2732,6 +2882,7 @@ static struct attribute *dispatcher_attrs[] = {
 	&dispatcher_attr_disp_preempt_fair_sched.attr,
 	&dispatcher_attr_dispatch_time_slice.attr,
 	&dispatcher_attr_dispatch_starvation_time.attr,
+	&dispatcher_attr_retire_burst.attr,
 	NULL,
 };
 
@@ -2794,16 +2945,20 @@ int adreno_dispatcher_init(struct adreno_device *adreno_dev)
 	setup_timer(&dispatcher->fault_timer, adreno_dispatcher_fault_timer,
 		(unsigned long) adreno_dev);
 
-	init_kthread_work(&dispatcher->work, adreno_dispatcher_work);
-
 	init_completion(&dispatcher->idle_gate);
 	complete_all(&dispatcher->idle_gate);
 
 	plist_head_init(&dispatcher->pending);
 	spin_lock_init(&dispatcher->plist_lock);
 
+	ret = _dispatcher_start_threads(adreno_dev);
+	if (ret)
+		return ret;
+
 	ret = kobject_init_and_add(&dispatcher->kobj, &ktype_dispatcher,
 		&device->dev->kobj, "dispatch");
+	if (ret)
+		_dispatcher_stop_threads(adreno_dev);
 
 	return ret;
 }
@@ -2851,11 +3006,11 @@ int adreno_dispatcher_idle(struct adreno_device *adreno_dev)
 	mutex_unlock(&device->mutex);
 
 	/*
-	 * Flush the worker to make sure all executing
-	 * or pending dispatcher works on worker are
-	 * finished
+	 * Flush the workers to make sure all executing
+	 * or pending dispatcher works on the ringbuffer
+	 * workers are finished
 	 */
-	flush_kthread_worker(&kgsl_driver.worker);
+	_dispatcher_flush_workers(adreno_dev);
 
 	ret = wait_for_completion_timeout(&dispatcher->idle_gate,
 			msecs_to_jiffies(ADRENO_IDLE_TIMEOUT));
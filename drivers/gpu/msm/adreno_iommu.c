@@ -198,6 +198,14 @@ static unsigned int _tlbiall(struct adreno_device *adreno_dev,
 	unsigned int *start = cmds;
 	unsigned int tlbstatus;
 
+	/*
+	 * With ASID tagged TLBs the entries of the other pagetables stay
+	 * resident and are simply not matched, switching back to one of
+	 * them finds its translations still cached.
+	 */
+	if (MMU_FEATURE(KGSL_MMU(adreno_dev), KGSL_MMU_ASID_TLB))
+		return 0;
+
 	tlbstatus = kgsl_mmu_get_reg_ahbaddr(KGSL_MMU(adreno_dev),
 			KGSL_IOMMU_CONTEXT_USER,
 			KGSL_IOMMU_CTX_TLBSTATUS) >> 2;
@@ -105,6 +105,11 @@ struct adreno_ringbuffer_pagetable_info {
  * or how long it has been scheduled for after preempting in
  * @starve_timer_state: Indicates the state of the wait.
  * @preempt_lock: Lock to protect the wptr pointer while it is being updated
+ * @dispatch_worker: Dedicated worker that retires and submits the commands of
+ * this RB, so lower priority RBs can't delay higher priority ones
+ * @dispatch_thread: Thread running @dispatch_worker
+ * @dispatch_work: Dispatcher work item queued on @dispatch_worker
+ * @retire_ktime: Local clock time the last command of this RB was retired
  */
 struct adreno_ringbuffer {
 	uint32_t flags;
@@ -127,6 +132,10 @@ struct adreno_ringbuffer {
 	unsigned long sched_timer;
 	enum adreno_dispatcher_starve_timer_states starve_timer_state;
 	spinlock_t preempt_lock;
+	struct kthread_worker dispatch_worker;
+	struct task_struct *dispatch_thread;
+	struct kthread_work dispatch_work;
+	u64 retire_ktime;
 };
 
 /* Returns the current ringbuffer */
@@ -198,6 +198,14 @@ static inline void parse_ib(struct kgsl_device *device,
 					gpuaddr, dwords << 2))
 		return;
 
+	/*
+	 * Parsing the other IBs isn't needed to see where the GPU hung, leave
+	 * it to the snapshot worker so that recovery isn't held up
+	 */
+	if (device->snapshot_deferred &&
+		!kgsl_snapshot_defer_ib(snapshot, gpuaddr, dwords))
+		return;
+
 	if (-E2BIG == adreno_ib_create_object_list(device, process,
 				gpuaddr, dwords, snapshot->ib2base,
 				&ib_obj_list))
@@ -233,6 +233,17 @@ static unsigned int _lm_show(struct adreno_device *adreno_dev)
 	return test_bit(ADRENO_LM_CTRL, &adreno_dev->pwrctrl_flag);
 }
 
+static int _telemetry_store(struct adreno_device *adreno_dev,
+		unsigned int val)
+{
+	return adreno_telemetry_enable(adreno_dev, val);
+}
+
+static unsigned int _telemetry_show(struct adreno_device *adreno_dev)
+{
+	return adreno_dev->telemetry.enabled;
+}
+
 static ssize_t _sysfs_store_u32(struct device *dev,
 		struct device_attribute *attr,
 		const char *buf, size_t count)
@@ -326,6 +337,7 @@ static ADRENO_SYSFS_BOOL(lm);
 static ADRENO_SYSFS_BOOL(preemption);
 static ADRENO_SYSFS_BOOL(hwcg);
 static ADRENO_SYSFS_BOOL(throttling);
+static ADRENO_SYSFS_BOOL(telemetry);
 
 
 
@@ -341,6 +353,7 @@ static const struct device_attribute *_attr_list[] = {
 	&adreno_attr_preemption.attr,
 	&adreno_attr_hwcg.attr,
 	&adreno_attr_throttling.attr,
+	&adreno_attr_telemetry.attr,
 	NULL,
 };
 
@@ -0,0 +1,307 @@
+/* Copyright (c) 2018, The Linux Foundation. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 and
+ * only version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+/*
+ * Always-on GPU counter telemetry
+ *
+ * A small fixed set of perfcounters is reserved for the kernel and read
+ * every time a command retires. The deltas since the previous retirement
+ * are written with the pid and context of the command into a ring that
+ * user space maps read-only, so the GPU time, ALU activity and memory
+ * stalls of production workloads can be attributed to processes without
+ * the cost of the profiling interfaces.
+ *
+ * Commands of different ringbuffers may overlap on the GPU; the interval
+ * between two retirements is charged to the command retiring last.
+ */
+
+#include <linux/mm.h>
+#include <linux/sysfs.h>
+#include <linux/vmalloc.h>
+
+#include "adreno.h"
+#include "kgsl_device.h"
+#include "a3xx_reg.h"
+#include "a5xx_reg.h"
+
+#define ADRENO_TELEMETRY_ENTRIES 1024
+
+struct adreno_telemetry_countable {
+	unsigned int group;
+	unsigned int countable;
+};
+
+static void _telemetry_countables(struct adreno_device *adreno_dev,
+		struct adreno_telemetry_countable *c)
+{
+	c[KGSL_TELEMETRY_BUSY].group = KGSL_PERFCOUNTER_GROUP_PWR;
+	c[KGSL_TELEMETRY_BUSY].countable = 1;
+
+	c[KGSL_TELEMETRY_ALU].group = KGSL_PERFCOUNTER_GROUP_SP;
+	if (adreno_is_a5xx(adreno_dev))
+		c[KGSL_TELEMETRY_ALU].countable = A5XX_SP_ALU_ACTIVE_CYCLES;
+	else
+		c[KGSL_TELEMETRY_ALU].countable = SP_ALU_ACTIVE_CYCLES;
+
+	c[KGSL_TELEMETRY_RAM_STALL].group = KGSL_PERFCOUNTER_GROUP_VBIF_PWR;
+	c[KGSL_TELEMETRY_RAM_STALL].countable = 0;
+}
+
+static uint64_t _telemetry_read(struct kgsl_device *device,
+		unsigned int lo, unsigned int hi)
+{
+	unsigned int l = 0, h = 0;
+
+	kgsl_regread(device, lo, &l);
+	kgsl_regread(device, hi, &h);
+
+	return (((uint64_t) h) << 32) | l;
+}
+
+/**
+ * adreno_telemetry_start() - Take the counter baseline
+ * @adreno_dev: Pointer to an adreno_device structure
+ *
+ * Called with the GPU powered when it goes from idle to busy, so the idle
+ * time and a reset of the counters over a power collapse are not charged
+ * to the first command retiring afterwards.
+ */
+void adreno_telemetry_start(struct adreno_device *adreno_dev)
+{
+	struct adreno_telemetry *t = &adreno_dev->telemetry;
+	struct kgsl_device *device = KGSL_DEVICE(adreno_dev);
+	unsigned long flags;
+	int i;
+
+	spin_lock_irqsave(&t->lock, flags);
+	if (t->enabled)
+		for (i = 0; i < KGSL_TELEMETRY_COUNTERS; i++)
+			t->last[i] = _telemetry_read(device, t->lo[i],
+				t->hi[i]);
+	spin_unlock_irqrestore(&t->lock, flags);
+}
+
+/**
+ * adreno_telemetry_retire() - Sample the counters for a retired command
+ * @adreno_dev: Pointer to an adreno_device structure
+ * @drawobj: The command that retired
+ *
+ * Called from the dispatcher while the command is still accounted as in
+ * flight, so the GPU is known to be powered.
+ */
+void adreno_telemetry_retire(struct adreno_device *adreno_dev,
+		struct kgsl_drawobj *drawobj)
+{
+	struct adreno_telemetry *t = &adreno_dev->telemetry;
+	struct kgsl_device *device = KGSL_DEVICE(adreno_dev);
+	struct kgsl_telemetry_entry *entry;
+	unsigned long flags;
+	uint64_t val;
+	int i;
+
+	if (!READ_ONCE(t->enabled) || device->state != KGSL_STATE_ACTIVE)
+		return;
+
+	spin_lock_irqsave(&t->lock, flags);
+
+	/* Sampling may have been stopped and the counters released */
+	if (!t->enabled) {
+		spin_unlock_irqrestore(&t->lock, flags);
+		return;
+	}
+
+	entry = &t->entries[t->header->head % t->header->num_entries];
+
+	for (i = 0; i < KGSL_TELEMETRY_COUNTERS; i++) {
+		val = _telemetry_read(device, t->lo[i], t->hi[i]);
+		/* A counter going backwards was reset by a power collapse */
+		entry->counters[i] = val >= t->last[i] ? val - t->last[i] : val;
+		t->last[i] = val;
+	}
+
+	entry->ktime = ktime_get_ns();
+	entry->pid = drawobj->context->proc_priv->pid;
+	entry->context_id = drawobj->context->id;
+	entry->timestamp = drawobj->timestamp;
+	entry->flags = (drawobj->flags & KGSL_DRAWOBJ_END_OF_FRAME) ?
+		KGSL_TELEMETRY_FLAG_EOF : 0;
+
+	/* Publish the entry before moving the head past it */
+	smp_wmb();
+	t->header->head++;
+
+	spin_unlock_irqrestore(&t->lock, flags);
+}
+
+static void _telemetry_put(struct adreno_device *adreno_dev,
+		struct adreno_telemetry_countable *c)
+{
+	struct adreno_telemetry *t = &adreno_dev->telemetry;
+	int i;
+
+	for (i = 0; i < KGSL_TELEMETRY_COUNTERS; i++) {
+		if (t->lo[i] != 0)
+			adreno_perfcounter_put(adreno_dev, c[i].group,
+				c[i].countable, PERFCOUNTER_FLAG_KERNEL);
+		t->lo[i] = 0;
+		t->hi[i] = 0;
+	}
+}
+
+/**
+ * adreno_telemetry_enable() - Start or stop the telemetry sampling
+ * @adreno_dev: Pointer to an adreno_device structure
+ * @enable: True to reserve the counters and start sampling
+ *
+ * Returns 0 on success or a negative error code if the counters could
+ * not be reserved.
+ */
+int adreno_telemetry_enable(struct adreno_device *adreno_dev, bool enable)
+{
+	struct adreno_telemetry *t = &adreno_dev->telemetry;
+	struct kgsl_device *device = KGSL_DEVICE(adreno_dev);
+	struct adreno_telemetry_countable c[KGSL_TELEMETRY_COUNTERS];
+	int i, ret = 0;
+
+	if (t->header == NULL)
+		return -ENODEV;
+
+	_telemetry_countables(adreno_dev, c);
+
+	mutex_lock(&device->mutex);
+
+	if (enable == t->enabled)
+		goto done;
+
+	ret = kgsl_active_count_get(device);
+	if (ret)
+		goto done;
+
+	if (!enable) {
+		spin_lock_irq(&t->lock);
+		t->enabled = false;
+		spin_unlock_irq(&t->lock);
+
+		_telemetry_put(adreno_dev, c);
+		goto put;
+	}
+
+	for (i = 0; i < KGSL_TELEMETRY_COUNTERS; i++) {
+		ret = adreno_perfcounter_get(adreno_dev, c[i].group,
+			c[i].countable, &t->lo[i], &t->hi[i],
+			PERFCOUNTER_FLAG_KERNEL);
+		if (ret) {
+			KGSL_DRV_ERR(device,
+				"Unable to allocate telemetry perfcounter %d/%d\n",
+				c[i].group, c[i].countable);
+			_telemetry_put(adreno_dev, c);
+			goto put;
+		}
+	}
+
+	spin_lock_irq(&t->lock);
+	t->header->head = 0;
+	memset(t->entries, 0, t->header->num_entries * sizeof(*t->entries));
+	for (i = 0; i < KGSL_TELEMETRY_COUNTERS; i++)
+		t->last[i] = _telemetry_read(device, t->lo[i], t->hi[i]);
+	t->enabled = true;
+	spin_unlock_irq(&t->lock);
+
+put:
+	kgsl_active_count_put(device);
+done:
+	mutex_unlock(&device->mutex);
+	return ret;
+}
+
+static ssize_t _telemetry_bin_read(struct file *filp, struct kobject *kobj,
+		struct bin_attribute *attr, char *buf, loff_t off, size_t count)
+{
+	struct adreno_telemetry *t = attr->private;
+
+	if (off >= t->size)
+		return 0;
+
+	count = min_t(size_t, count, t->size - off);
+	memcpy(buf, (void *) t->header + off, count);
+
+	return count;
+}
+
+static int _telemetry_bin_mmap(struct file *filp, struct kobject *kobj,
+		struct bin_attribute *attr, struct vm_area_struct *vma)
+{
+	struct adreno_telemetry *t = attr->private;
+
+	if (vma->vm_flags & VM_WRITE)
+		return -EPERM;
+
+	vma->vm_flags &= ~VM_MAYWRITE;
+
+	return remap_vmalloc_range(vma, t->header, vma->vm_pgoff);
+}
+
+static struct bin_attribute _telemetry_attr = {
+	.attr = { .name = "telemetry_ring", .mode = 0444 },
+	.read = _telemetry_bin_read,
+	.mmap = _telemetry_bin_mmap,
+};
+
+/**
+ * adreno_telemetry_init() - Allocate the telemetry ring
+ * @adreno_dev: Pointer to an adreno_device structure
+ *
+ * The counters are only reserved once sampling is enabled from sysfs.
+ */
+int adreno_telemetry_init(struct adreno_device *adreno_dev)
+{
+	struct adreno_telemetry *t = &adreno_dev->telemetry;
+	struct kgsl_device *device = KGSL_DEVICE(adreno_dev);
+	int ret;
+
+	spin_lock_init(&t->lock);
+
+	t->size = PAGE_ALIGN(sizeof(*t->header) +
+		ADRENO_TELEMETRY_ENTRIES * sizeof(*t->entries));
+	t->header = vmalloc_user(t->size);
+	if (t->header == NULL)
+		return -ENOMEM;
+
+	t->header->version = KGSL_TELEMETRY_VERSION;
+	t->header->num_entries = ADRENO_TELEMETRY_ENTRIES;
+	t->entries = (struct kgsl_telemetry_entry *) (t->header + 1);
+
+	_telemetry_attr.size = t->size;
+	_telemetry_attr.private = t;
+
+	ret = device_create_bin_file(device->dev, &_telemetry_attr);
+	if (ret) {
+		vfree(t->header);
+		t->header = NULL;
+	}
+
+	return ret;
+}
+
+void adreno_telemetry_close(struct adreno_device *adreno_dev)
+{
+	struct adreno_telemetry *t = &adreno_dev->telemetry;
+	struct kgsl_device *device = KGSL_DEVICE(adreno_dev);
+
+	if (t->header == NULL)
+		return;
+
+	adreno_telemetry_enable(adreno_dev, false);
+	device_remove_bin_file(device->dev, &_telemetry_attr);
+	vfree(t->header);
+	t->header = NULL;
+}
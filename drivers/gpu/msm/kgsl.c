@@ -2964,6 +2964,45 @@ long kgsl_ioctl_sharedmem_flush_cache(struct kgsl_device_private *dev_priv,
 	return ret;
 }
 
+/* Sort sync objects by ID, operation and offset so they can be coalesced */
+static int gpuobj_sync_cmp(const void *_a, const void *_b)
+{
+	const struct kgsl_gpuobj_sync_obj *a = _a, *b = _b;
+
+	if (a->id != b->id)
+		return (a->id > b->id) ? 1 : -1;
+	if (a->op != b->op)
+		return (a->op > b->op) ? 1 : -1;
+	if (a->offset != b->offset)
+		return (a->offset > b->offset) ? 1 : -1;
+	return 0;
+}
+
+/*
+ * Merge @obj into @prev if both apply the same operation to overlapping or
+ * adjacent ranges of the same object. The merged range is still subject to
+ * the limits of kgsl_cache_range_op().
+ */
+static bool gpuobj_sync_merge(struct kgsl_gpuobj_sync_obj *prev,
+		struct kgsl_gpuobj_sync_obj *obj)
+{
+	uint64_t end;
+
+	if (prev->id != obj->id || prev->op != obj->op)
+		return false;
+
+	if (obj->length > U64_MAX - obj->offset ||
+			obj->offset > prev->offset + prev->length)
+		return false;
+
+	end = max(prev->offset + prev->length, obj->offset + obj->length);
+	if (end - prev->offset > UINT_MAX)
+		return false;
+
+	prev->length = end - prev->offset;
+	return true;
+}
+
 long kgsl_ioctl_gpuobj_sync(struct kgsl_device_private *dev_priv,
 		unsigned int cmd, void *data)
 {
@@ -2972,9 +3011,9 @@ long kgsl_ioctl_gpuobj_sync(struct kgsl_device_private *dev_priv,
 	struct kgsl_gpuobj_sync_obj *objs;
 	struct kgsl_mem_entry **entries;
 	long ret = 0;
-	bool full_flush = false;
+	bool full_flush = true;
 	uint64_t size = 0;
-	int i;
+	int i, prev = -1, count = 0;
 	void __user *ptr;
 
 	if (param->count == 0 || param->count > 128)
@@ -2998,36 +3037,87 @@ long kgsl_ioctl_gpuobj_sync(struct kgsl_device_private *dev_priv,
 		if (ret)
 			goto out;
 
-		entries[i] = kgsl_sharedmem_find_id(private, objs[i].id);
+		if (!(objs[i].op & KGSL_GPUMEM_CACHE_FLUSH)) {
+			ret = -EINVAL;
+			goto out;
+		}
+
+		/* Whole object syncs are ranges that get sized below */
+		if (!(objs[i].op & KGSL_GPUMEM_CACHE_RANGE)) {
+			objs[i].offset = 0;
+			objs[i].length = 0;
+		}
+
+		objs[i].op &= KGSL_GPUMEM_CACHE_FLUSH;
+		objs[i].op |= KGSL_GPUMEM_CACHE_RANGE;
+
+		ptr += sizeof(*objs);
+	}
+
+	/*
+	 * Coalesce the ranges of each object. This also orders the operations
+	 * on an object so that cleans are done before invalidates.
+	 */
+	sort(objs, param->count, sizeof(*objs), gpuobj_sync_cmp, NULL);
+
+	for (i = 0; i < param->count; i++) {
+		struct kgsl_gpuobj_sync_obj *obj = &objs[i];
+		struct kgsl_mem_entry *entry;
+		int mode;
+
+		if (count && obj->id == objs[count - 1].id)
+			/* Share the reference taken for the first range */
+			entry = entries[count - 1];
+		else
+			entry = kgsl_sharedmem_find_id(private, obj->id);
 
 		/* Not finding the ID is not a fatal failure - just skip it */
-		if (entries[i] == NULL)
+		if (entry == NULL)
 			continue;
 
-		if (!(objs[i].op & KGSL_GPUMEM_CACHE_RANGE))
-			size += entries[i]->memdesc.size;
-		else if (objs[i].offset < entries[i]->memdesc.size)
-			size += (entries[i]->memdesc.size - objs[i].offset);
+		if (obj->offset == 0 && obj->length == 0)
+			obj->length = entry->memdesc.size;
 
-		full_flush = check_full_flush(size, objs[i].op);
-		if (full_flush) {
-			trace_kgsl_mem_sync_full_cache(i, size);
-			flush_cache_all();
-			goto out;
+		objs[count] = *obj;
+		entries[count++] = entry;
+
+		/* Nothing to do for uncached memory */
+		mode = kgsl_memdesc_get_cachemode(&entry->memdesc);
+		if (mode == KGSL_CACHEMODE_UNCACHED ||
+				mode == KGSL_CACHEMODE_WRITECOMBINE) {
+			objs[count - 1].length = 0;
+			continue;
 		}
 
-		ptr += sizeof(*objs);
+		if (prev >= 0 && gpuobj_sync_merge(&objs[prev],
+				&objs[count - 1])) {
+			objs[count - 1].length = 0;
+			continue;
+		}
+
+		prev = count - 1;
+		size += objs[prev].length;
+		if (objs[prev].op != (KGSL_GPUMEM_CACHE_FLUSH |
+				KGSL_GPUMEM_CACHE_RANGE))
+			full_flush = false;
+	}
+
+	/* Flush the whole cache if that is cheaper than the merged ranges */
+	if (full_flush && check_full_flush(size, KGSL_GPUMEM_CACHE_FLUSH)) {
+		trace_kgsl_mem_sync_full_cache(count, size);
+		flush_cache_all();
+		goto out;
 	}
 
-	for (i = 0; !ret && i < param->count; i++)
-		if (entries[i])
+	for (i = 0; !ret && i < count; i++)
+		if (objs[i].length)
 			ret = _kgsl_gpumem_sync_cache(entries[i],
 					objs[i].offset, objs[i].length,
 					objs[i].op);
 
 out:
-	for (i = 0; i < param->count; i++)
-		if (entries[i])
+	for (i = 0; i < count; i++)
+		if (i == 0 || entries[i] != entries[i - 1])
 			kgsl_mem_entry_put(entries[i]);
 
 	kfree(entries);
@@ -3076,7 +3166,8 @@ static struct kgsl_mem_entry *gpumem_alloc_entry(
 		| KGSL_MEMALIGN_MASK
 		| KGSL_MEMFLAGS_USE_CPU_MAP
 		| KGSL_MEMFLAGS_SECURE
-		| KGSL_MEMFLAGS_FORCE_32BIT;
+		| KGSL_MEMFLAGS_FORCE_32BIT
+		| KGSL_MEMFLAGS_LAZY;
 
 	/* Turn off SVM if the system doesn't support it */
 	if (!kgsl_mmu_use_cpu_map(&dev_priv->device->mmu))
@@ -4892,6 +4983,7 @@ static void kgsl_core_exit(void)
 	kgsl_drawobjs_cache_exit();
 
 	kgsl_memfree_exit();
+	kgsl_sharedmem_lazy_exit();
 	unregister_chrdev_region(kgsl_driver.major, KGSL_DEVICE_MAX);
 }
 
@@ -4996,6 +5088,7 @@ static int __init kgsl_core_init(void)
 		goto err;
 
 	kgsl_memfree_init();
+	kgsl_sharedmem_lazy_init();
 
 	return 0;
 
@@ -189,6 +189,8 @@ struct kgsl_memdesc_ops {
 #define KGSL_MEMDESC_TZ_LOCKED BIT(7)
 /* The memdesc is allocated through contiguous memory */
 #define KGSL_MEMDESC_CONTIG BIT(8)
+/* The pages of the memdesc are allocated on first use */
+#define KGSL_MEMDESC_LAZY BIT(9)
 
 /**
  * struct kgsl_memdesc - GPU memory object descriptor
@@ -209,6 +211,10 @@ struct kgsl_memdesc_ops {
  * @pages: An array of pointers to allocated pages
  * @page_count: Total number of pages allocated
  * @cur_bindings: Number of sparse pages actively bound
+ * @lazy_lock: Protects @pages and the GPU mapping of a lazy memdesc
+ * @lazy_pages: Number of pages of a lazy memdesc currently populated
+ * @lazy_mapped: The populated pages of a lazy memdesc are mapped in @pagetable
+ * @lazy_node: Entry in the list of lazy memdescs scanned by the shrinker
  */
 struct kgsl_memdesc {
 	struct kgsl_pagetable *pagetable;
@@ -228,6 +234,10 @@ struct kgsl_memdesc {
 	struct page **pages;
 	unsigned int page_count;
 	unsigned int cur_bindings;
+	struct mutex lazy_lock;
+	unsigned int lazy_pages;
+	bool lazy_mapped;
+	struct list_head lazy_node;
 };
 
 /*
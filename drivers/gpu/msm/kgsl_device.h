@@ -287,6 +287,10 @@ struct kgsl_device {
 
 	/* Use CP Crash dumper to get GPU snapshot*/
 	bool snapshot_crashdumper;
+	/* Parse the IBs of the snapshot from the worker after recovery */
+	bool snapshot_deferred;
+	/* Save the frozen GPU buffers compressed */
+	bool snapshot_compress;
 
 	struct kobject snapshot_kobj;
 
@@ -371,6 +375,20 @@ struct kgsl_process_private;
  * @fault_count: number of times gpu hanged in last _context_throttle_time ms
  * @fault_time: time of the first gpu hang in last _context_throttle_time ms
  */
+/**
+ * struct kgsl_context_frame - Frame accounting of a context for frame DCVS
+ * @last_eof: Time the last end of frame command retired, in ns
+ * @busy_ns: GPU time spent on the context since @last_eof
+ * @busy_cycles: GPU cycles spent on the context since @last_eof
+ * @freq: GPU frequency the last frame needed to meet its deadline
+ */
+struct kgsl_context_frame {
+	u64 last_eof;
+	u64 busy_ns;
+	u64 busy_cycles;
+	unsigned long freq;
+};
+
 struct kgsl_context {
 	struct kref refcount;
 	uint32_t id;
@@ -387,6 +405,7 @@ struct kgsl_context {
 	struct kgsl_pwr_constraint pwr_constraint;
 	unsigned int fault_count;
 	unsigned long fault_time;
+	struct kgsl_context_frame frame;
 };
 
 #define _context_comm(_c) \
@@ -473,6 +492,7 @@ struct kgsl_device_private {
  * @mempool_size: Size of the memory pool
  * @obj_list: List of frozen GPU buffers that are waiting to be dumped.
  * @cp_list: List of IB's to be dumped.
+ * @ib_list: List of IB's to be parsed by the worker.
  * @work: worker to dump the frozen memory
  * @dump_gate: completion gate signaled by worker when it is finished.
  * @process: the process that caused the hang, if known.
@@ -494,6 +514,7 @@ struct kgsl_snapshot {
 	size_t mempool_size;
 	struct list_head obj_list;
 	struct list_head cp_list;
+	struct list_head ib_list;
 	struct work_struct work;
 	struct completion dump_gate;
 	struct kgsl_process_private *process;
@@ -882,6 +903,9 @@ struct adreno_ib_object_list;
 int kgsl_snapshot_add_ib_obj_list(struct kgsl_snapshot *snapshot,
 	struct adreno_ib_object_list *ib_obj_list);
 
+int kgsl_snapshot_defer_ib(struct kgsl_snapshot *snapshot,
+	uint64_t gpuaddr, uint64_t dwords);
+
 void kgsl_snapshot_add_section(struct kgsl_device *device, u16 id,
 	struct kgsl_snapshot *snapshot,
 	size_t (*func)(struct kgsl_device *, u8 *, size_t, void *),
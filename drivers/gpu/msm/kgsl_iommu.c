@@ -757,6 +757,18 @@ static int kgsl_iommu_fault_handler(struct iommu_domain *domain,
 
 	context = kgsl_context_get(device, curr_context_id);
 
+	/*
+	 * A translation fault on lazily allocated memory is expected: back the
+	 * faulting range with pages and have the MMU retry the transaction
+	 */
+	if (context != NULL && MMU_FEATURE(mmu, KGSL_MMU_RETRY_ON_FAULT) &&
+		(flags & IOMMU_FAULT_TRANSLATION) &&
+		(flags & IOMMU_FAULT_TRANSACTION_STALLED) &&
+		!kgsl_sharedmem_lazy_fault(context->proc_priv, addr)) {
+		kgsl_context_put(context);
+		return -EAGAIN;
+	}
+
 	write = (flags & IOMMU_FAULT_WRITE) ? 1 : 0;
 	if (flags & IOMMU_FAULT_TRANSLATION)
 		fault_type = "translation";
@@ -1479,6 +1491,36 @@ done:
 	return status;
 }
 
+/*
+ * If pagefault policy is GPUHALT_ENABLE,
+ * 1) Program CFCFG to 1 to enable STALL mode
+ * 2) Program HUPCF to 0 (Stall or terminate subsequent
+ *    transactions in the presence of an outstanding fault)
+ * else
+ * 1) Program CFCFG to 0 to disable STALL mode (0=Terminate)
+ * 2) Program HUPCF to 1 (Process subsequent transactions
+ *    independently of any outstanding fault)
+ *
+ * An MMU that retries on fault always stalls, so faults on lazily allocated
+ * memory can be fixed up and the transaction retried.
+ */
+static unsigned int _iommu_sctlr_fault_cfg(struct kgsl_mmu *mmu,
+		unsigned int sctlr_val, unsigned long pf_policy)
+{
+	if (test_bit(KGSL_FT_PAGEFAULT_GPUHALT_ENABLE, &pf_policy)) {
+		sctlr_val |= (0x1 << KGSL_IOMMU_SCTLR_CFCFG_SHIFT);
+		sctlr_val &= ~(0x1 << KGSL_IOMMU_SCTLR_HUPCF_SHIFT);
+	} else {
+		if (MMU_FEATURE(mmu, KGSL_MMU_RETRY_ON_FAULT))
+			sctlr_val |= (0x1 << KGSL_IOMMU_SCTLR_CFCFG_SHIFT);
+		else
+			sctlr_val &= ~(0x1 << KGSL_IOMMU_SCTLR_CFCFG_SHIFT);
+		sctlr_val |= (0x1 << KGSL_IOMMU_SCTLR_HUPCF_SHIFT);
+	}
+
+	return sctlr_val;
+}
+
 static int _setup_user_context(struct kgsl_mmu *mmu)
 {
 	int ret = 0;
@@ -1515,27 +1557,8 @@ static int _setup_user_context(struct kgsl_mmu *mmu)
 	kgsl_iommu_enable_clk(mmu);
 
 	sctlr_val = KGSL_IOMMU_GET_CTX_REG(ctx, SCTLR);
-
-	/*
-	 * If pagefault policy is GPUHALT_ENABLE,
-	 * 1) Program CFCFG to 1 to enable STALL mode
-	 * 2) Program HUPCF to 0 (Stall or terminate subsequent
-	 *    transactions in the presence of an outstanding fault)
-	 * else
-	 * 1) Program CFCFG to 0 to disable STALL mode (0=Terminate)
-	 * 2) Program HUPCF to 1 (Process subsequent transactions
-	 *    independently of any outstanding fault)
-	 */
-
-	sctlr_val = KGSL_IOMMU_GET_CTX_REG(ctx, SCTLR);
-	if (test_bit(KGSL_FT_PAGEFAULT_GPUHALT_ENABLE,
-				&adreno_dev->ft_pf_policy)) {
-		sctlr_val |= (0x1 << KGSL_IOMMU_SCTLR_CFCFG_SHIFT);
-		sctlr_val &= ~(0x1 << KGSL_IOMMU_SCTLR_HUPCF_SHIFT);
-	} else {
-		sctlr_val &= ~(0x1 << KGSL_IOMMU_SCTLR_CFCFG_SHIFT);
-		sctlr_val |= (0x1 << KGSL_IOMMU_SCTLR_HUPCF_SHIFT);
-	}
+	sctlr_val = _iommu_sctlr_fault_cfg(mmu, sctlr_val,
+			adreno_dev->ft_pf_policy);
 	KGSL_IOMMU_SET_CTX_REG(ctx, SCTLR, sctlr_val);
 	kgsl_iommu_disable_clk(mmu);
 
@@ -1627,12 +1650,25 @@ kgsl_iommu_unmap_offset(struct kgsl_pagetable *pt,
 	return _iommu_unmap_sync_pc(pt, addr + offset, size);
 }
 
+static void _iommu_unmap_lazy_memdesc(struct kgsl_pagetable *pt,
+		struct kgsl_memdesc *memdesc);
+
 static int
 kgsl_iommu_unmap(struct kgsl_pagetable *pt, struct kgsl_memdesc *memdesc)
 {
 	if (memdesc->size == 0 || memdesc->gpuaddr == 0)
 		return -EINVAL;
 
+	if (memdesc->priv & KGSL_MEMDESC_LAZY) {
+		_iommu_unmap_lazy_memdesc(pt, memdesc);
+
+		if (!kgsl_memdesc_has_guard_page(memdesc))
+			return 0;
+
+		return _iommu_unmap_sync_pc(pt, memdesc->gpuaddr + memdesc->size,
+			kgsl_memdesc_guard_page_size(memdesc));
+	}
+
 	return kgsl_iommu_unmap_offset(pt, memdesc, memdesc->gpuaddr, 0,
 			kgsl_memdesc_footprint(memdesc));
 }
@@ -1707,6 +1743,99 @@ static unsigned int _get_protection_flags(struct kgsl_memdesc *memdesc)
 	return flags;
 }
 
+/* Map the populated pages [offset, offset + size) of a lazy memdesc */
+static int kgsl_iommu_map_lazy(struct kgsl_pagetable *pt,
+		struct kgsl_memdesc *memdesc, uint64_t offset, uint64_t size)
+{
+	struct sg_table sgt;
+	int ret;
+
+	if (size == 0 || !IS_ALIGNED(offset | size, PAGE_SIZE) ||
+			offset + size > memdesc->size)
+		return -EINVAL;
+
+	ret = sg_alloc_table_from_pages(&sgt,
+			memdesc->pages + (offset >> PAGE_SHIFT),
+			size >> PAGE_SHIFT, 0, size, GFP_KERNEL);
+	if (ret)
+		return ret;
+
+	ret = _iommu_map_sg_sync_pc(pt, memdesc->gpuaddr + offset, sgt.sgl,
+			sgt.nents, _get_protection_flags(memdesc));
+	sg_free_table(&sgt);
+
+	return ret;
+}
+
+/* Unmap the runs of populated pages of a lazy memdesc below page @end */
+static void _iommu_unmap_lazy_pages(struct kgsl_pagetable *pt,
+		struct kgsl_memdesc *memdesc, unsigned int end)
+{
+	unsigned int i = 0, start;
+
+	while (i < end) {
+		if (memdesc->pages[i] == NULL) {
+			i++;
+			continue;
+		}
+
+		for (start = i; i < end && memdesc->pages[i] != NULL; i++)
+			;
+
+		_iommu_unmap_sync_pc(pt,
+			memdesc->gpuaddr + ((uint64_t) start << PAGE_SHIFT),
+			(uint64_t) (i - start) << PAGE_SHIFT);
+	}
+}
+
+/*
+ * Only the pages of a lazy memdesc that are already populated get mapped,
+ * the rest is mapped as the pages are allocated on first use
+ */
+static int _iommu_map_lazy_memdesc(struct kgsl_pagetable *pt,
+		struct kgsl_memdesc *memdesc)
+{
+	unsigned int i = 0, start;
+	int ret = 0;
+
+	mutex_lock(&memdesc->lazy_lock);
+
+	while (i < memdesc->page_count) {
+		if (memdesc->pages[i] == NULL) {
+			i++;
+			continue;
+		}
+
+		for (start = i; i < memdesc->page_count &&
+				memdesc->pages[i] != NULL; i++)
+			;
+
+		ret = kgsl_iommu_map_lazy(pt, memdesc,
+			(uint64_t) start << PAGE_SHIFT,
+			(uint64_t) (i - start) << PAGE_SHIFT);
+		if (ret) {
+			_iommu_unmap_lazy_pages(pt, memdesc, start);
+			break;
+		}
+	}
+
+	if (ret == 0)
+		memdesc->lazy_mapped = true;
+
+	mutex_unlock(&memdesc->lazy_lock);
+
+	return ret;
+}
+
+static void _iommu_unmap_lazy_memdesc(struct kgsl_pagetable *pt,
+		struct kgsl_memdesc *memdesc)
+{
+	mutex_lock(&memdesc->lazy_lock);
+	_iommu_unmap_lazy_pages(pt, memdesc, memdesc->page_count);
+	memdesc->lazy_mapped = false;
+	mutex_unlock(&memdesc->lazy_lock);
+}
+
 static int
 kgsl_iommu_map(struct kgsl_pagetable *pt,
 			struct kgsl_memdesc *memdesc)
@@ -1717,6 +1846,18 @@ kgsl_iommu_map(struct kgsl_pagetable *pt,
 	unsigned int flags = _get_protection_flags(memdesc);
 	struct sg_table *sgt = NULL;
 
+	if (memdesc->priv & KGSL_MEMDESC_LAZY) {
+		ret = _iommu_map_lazy_memdesc(pt, memdesc);
+		if (ret)
+			return ret;
+
+		ret = _iommu_map_guard_page(pt, memdesc, addr + size, flags);
+		if (ret)
+			_iommu_unmap_lazy_memdesc(pt, memdesc);
+
+		return ret;
+	}
+
 	/*
 	 * For paged memory allocated through kgsl, memdesc->pages is not NULL.
 	 * Allocate sgt here just for its map operation. Contiguous memory
@@ -2000,6 +2141,10 @@ static int kgsl_iommu_set_pt(struct kgsl_mmu *mmu, struct kgsl_pagetable *pt)
 	mb();
 	temp = KGSL_IOMMU_GET_CTX_REG_Q(ctx, TTBR0);
 
+	/* Entries of the previous pagetable can't match the new ASID */
+	if (MMU_FEATURE(mmu, KGSL_MMU_ASID_TLB))
+		goto done;
+
 	KGSL_IOMMU_SET_CTX_REG(ctx, TLBIALL, 1);
 	/* make sure the TBLI write completes before we wait */
 	mb();
@@ -2022,6 +2167,7 @@ static int kgsl_iommu_set_pt(struct kgsl_mmu *mmu, struct kgsl_pagetable *pt)
 		cpu_relax();
 	}
 
+done:
 	kgsl_iommu_disable_clk(mmu);
 	return 0;
 }
@@ -2054,15 +2200,7 @@ static int kgsl_iommu_set_pf_policy(struct kgsl_mmu *mmu,
 		kgsl_iommu_enable_clk(mmu);
 
 		sctlr_val = KGSL_IOMMU_GET_CTX_REG(ctx, SCTLR);
-
-		if (test_bit(KGSL_FT_PAGEFAULT_GPUHALT_ENABLE, &pf_policy)) {
-			sctlr_val |= (0x1 << KGSL_IOMMU_SCTLR_CFCFG_SHIFT);
-			sctlr_val &= ~(0x1 << KGSL_IOMMU_SCTLR_HUPCF_SHIFT);
-		} else {
-			sctlr_val &= ~(0x1 << KGSL_IOMMU_SCTLR_CFCFG_SHIFT);
-			sctlr_val |= (0x1 << KGSL_IOMMU_SCTLR_HUPCF_SHIFT);
-		}
-
+		sctlr_val = _iommu_sctlr_fault_cfg(mmu, sctlr_val, pf_policy);
 		KGSL_IOMMU_SET_CTX_REG(ctx, SCTLR, sctlr_val);
 
 		kgsl_iommu_disable_clk(mmu);
@@ -2488,6 +2626,8 @@ static const struct {
 	{ "qcom,global_pt", KGSL_MMU_GLOBAL_PAGETABLE },
 	{ "qcom,hyp_secure_alloc", KGSL_MMU_HYP_SECURE_ALLOC },
 	{ "qcom,force-32bit", KGSL_MMU_FORCE_32BIT },
+	{ "qcom,retry-on-fault", KGSL_MMU_RETRY_ON_FAULT },
+	{ "qcom,asid-tlb", KGSL_MMU_ASID_TLB },
 };
 
 static int _kgsl_iommu_probe(struct kgsl_device *device,
@@ -2544,6 +2684,10 @@ static int _kgsl_iommu_probe(struct kgsl_device *device,
 			device->mmu.features |= kgsl_iommu_features[i].bit;
 	}
 
+	/* Only the dynamic domains of the v2 SMMU get an ASID each */
+	if (iommu->version == 1)
+		device->mmu.features &= ~KGSL_MMU_ASID_TLB;
+
 	if (of_property_read_u32(node, "qcom,micro-mmu-control",
 		&iommu->micro_mmu_ctrl))
 		iommu->micro_mmu_ctrl = UINT_MAX;
@@ -2632,5 +2776,6 @@ static struct kgsl_mmu_pt_ops iommu_pt_ops = {
 	.addr_in_range = kgsl_iommu_addr_in_range,
 	.mmu_map_offset = kgsl_iommu_map_offset,
 	.mmu_unmap_offset = kgsl_iommu_unmap_offset,
+	.mmu_map_lazy = kgsl_iommu_map_lazy,
 	.mmu_sparse_dummy_map = kgsl_iommu_sparse_dummy_map,
 };
@@ -563,6 +563,33 @@ int kgsl_mmu_sparse_dummy_map(struct kgsl_pagetable *pagetable,
 }
 EXPORT_SYMBOL(kgsl_mmu_sparse_dummy_map);
 
+/*
+ * The whole footprint of a lazy memdesc is accounted as mapped when the
+ * memdesc is mapped, so populating and releasing its pages doesn't touch the
+ * pagetable statistics.
+ */
+int kgsl_mmu_map_lazy(struct kgsl_pagetable *pagetable,
+		struct kgsl_memdesc *memdesc, uint64_t offset, uint64_t size)
+{
+	if (PT_OP_VALID(pagetable, mmu_map_lazy))
+		return pagetable->pt_ops->mmu_map_lazy(pagetable, memdesc,
+				offset, size);
+
+	return -EINVAL;
+}
+EXPORT_SYMBOL(kgsl_mmu_map_lazy);
+
+int kgsl_mmu_unmap_lazy(struct kgsl_pagetable *pagetable,
+		struct kgsl_memdesc *memdesc, uint64_t offset, uint64_t size)
+{
+	if (PT_OP_VALID(pagetable, mmu_unmap_offset))
+		return pagetable->pt_ops->mmu_unmap_offset(pagetable, memdesc,
+				memdesc->gpuaddr, offset, size);
+
+	return -EINVAL;
+}
+EXPORT_SYMBOL(kgsl_mmu_unmap_lazy);
+
 void kgsl_mmu_remove_global(struct kgsl_device *device,
 		struct kgsl_memdesc *memdesc)
 {
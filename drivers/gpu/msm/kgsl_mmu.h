@@ -110,6 +110,9 @@ struct kgsl_mmu_pt_ops {
 	int (*mmu_sparse_dummy_map)(struct kgsl_pagetable *pt,
 			struct kgsl_memdesc *memdesc, uint64_t offset,
 			uint64_t size);
+	int (*mmu_map_lazy)(struct kgsl_pagetable *pt,
+			struct kgsl_memdesc *memdesc, uint64_t offset,
+			uint64_t size);
 };
 
 /*
@@ -135,6 +138,13 @@ struct kgsl_mmu_pt_ops {
 #define KGSL_MMU_PAGED BIT(8)
 /* The device requires a guard page */
 #define KGSL_MMU_NEED_GUARD_PAGE BIT(9)
+/* The MMU stalls faulting transactions so they can be fixed up and retried */
+#define KGSL_MMU_RETRY_ON_FAULT BIT(10)
+/*
+ * TLB entries are tagged with the ASID of their pagetable and invalidated
+ * by ASID on unmap, so a pagetable switch does not need a TLB flush
+ */
+#define KGSL_MMU_ASID_TLB BIT(11)
 
 /**
  * struct kgsl_mmu - Master definition for KGSL MMU devices
@@ -238,6 +248,11 @@ struct kgsl_memdesc *kgsl_mmu_get_qtimer_global_entry(
 int kgsl_mmu_sparse_dummy_map(struct kgsl_pagetable *pagetable,
 		struct kgsl_memdesc *memdesc, uint64_t offset, uint64_t size);
 
+int kgsl_mmu_map_lazy(struct kgsl_pagetable *pagetable,
+		struct kgsl_memdesc *memdesc, uint64_t offset, uint64_t size);
+int kgsl_mmu_unmap_lazy(struct kgsl_pagetable *pagetable,
+		struct kgsl_memdesc *memdesc, uint64_t offset, uint64_t size);
+
 /*
  * Static inline functions of MMU that simply call the SMMU specific
  * function using a function pointer. These functions can be thought
@@ -16,15 +16,33 @@
 #include <linux/slab.h>
 #include <linux/highmem.h>
 #include <linux/version.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
 
 #include "kgsl.h"
 #include "kgsl_device.h"
 #include "kgsl_pool.h"
+#include "kgsl_debugfs.h"
 
 #define KGSL_MAX_POOLS 4
 #define KGSL_MAX_POOL_ORDER 8
 #define KGSL_MAX_RESERVED_PAGES 4096
 
+/* Number of 4K pages each CPU may cache in front of a pool */
+#define KGSL_POOL_PCP_PAGES 256
+
+/**
+ * struct kgsl_pool_pcp - Per-CPU front cache of a pool
+ * @lock: Protects the cache, only taken remotely when the pool is drained
+ * @count: Number of pool sized pages in the cache
+ * @list: Pages in the cache
+ */
+struct kgsl_pool_pcp {
+	spinlock_t lock;
+	int count;
+	struct list_head list;
+};
+
 /**
  * struct kgsl_page_pool - Structure to hold information for the pool
  * @pool_order: Page order describing the size of the page
@@ -34,6 +52,12 @@
  * from system memory
  * @list_lock: Spinlock for page list in the pool
  * @page_list: List of pages held/reserved in this pool
+ * @pcp: Per-CPU caches in front of @page_list, NULL if not available
+ * @pcp_high: Pages a CPU cache may hold before spilling to @page_list
+ * @pcp_batch: Pages moved between a CPU cache and @page_list at once
+ * @pcp_hits: Allocations served by the local CPU cache
+ * @pool_hits: Allocations that had to refill from @page_list
+ * @misses: Allocations that found the pool empty
  */
 struct kgsl_page_pool {
 	unsigned int pool_order;
@@ -42,6 +66,12 @@ struct kgsl_page_pool {
 	bool allocation_allowed;
 	spinlock_t list_lock;
 	struct list_head page_list;
+	struct kgsl_pool_pcp __percpu *pcp;
+	int pcp_high;
+	int pcp_batch;
+	atomic_long_t pcp_hits;
+	atomic_long_t pool_hits;
+	atomic_long_t misses;
 };
 
 static struct kgsl_page_pool kgsl_pools[KGSL_MAX_POOLS];
@@ -79,21 +109,103 @@ _kgsl_pool_zero_page(struct page *p, unsigned int pool_order)
 	}
 }
 
+/* Move up to count pages from the head of one list to the tail of another */
+static int
+_kgsl_pool_move_pages(struct list_head *from, struct list_head *to, int count)
+{
+	struct page *p;
+	int moved = 0;
+
+	while (moved < count && !list_empty(from)) {
+		p = list_first_entry(from, struct page, lru);
+		list_move_tail(&p->lru, to);
+		moved++;
+	}
+
+	return moved;
+}
+
+/* Give back a batch of pages from a CPU cache, called with pcp->lock held */
+static void
+_kgsl_pool_spill_pcp(struct kgsl_page_pool *pool, struct kgsl_pool_pcp *pcp)
+{
+	int moved;
+
+	spin_lock(&pool->list_lock);
+	moved = _kgsl_pool_move_pages(&pcp->list, &pool->page_list,
+				      pool->pcp_batch);
+	pool->page_count += moved;
+	spin_unlock(&pool->list_lock);
+	pcp->count -= moved;
+}
+
+/* Grab a batch of pages for a CPU cache, called with pcp->lock held */
+static void
+_kgsl_pool_refill_pcp(struct kgsl_page_pool *pool, struct kgsl_pool_pcp *pcp)
+{
+	int moved;
+
+	spin_lock(&pool->list_lock);
+	moved = _kgsl_pool_move_pages(&pool->page_list, &pcp->list,
+				      pool->pcp_batch);
+	pool->page_count -= moved;
+	spin_unlock(&pool->list_lock);
+	pcp->count += moved;
+}
+
+/* Return all CPU cached pages of a pool to the shared list */
+static void
+_kgsl_pool_drain_pcp(struct kgsl_page_pool *pool)
+{
+	struct kgsl_pool_pcp *pcp;
+	int cpu;
+
+	if (pool->pcp == NULL)
+		return;
+
+	for_each_possible_cpu(cpu) {
+		pcp = per_cpu_ptr(pool->pcp, cpu);
+
+		spin_lock(&pcp->lock);
+		if (pcp->count) {
+			spin_lock(&pool->list_lock);
+			list_splice_tail_init(&pcp->list, &pool->page_list);
+			pool->page_count += pcp->count;
+			spin_unlock(&pool->list_lock);
+			pcp->count = 0;
+		}
+		spin_unlock(&pcp->lock);
+	}
+}
+
 /* Add a page to specified pool */
 static void
 _kgsl_pool_add_page(struct kgsl_page_pool *pool, struct page *p)
 {
+	struct kgsl_pool_pcp *pcp;
+
 	_kgsl_pool_zero_page(p, pool->pool_order);
 
+	if (pool->pcp != NULL) {
+		pcp = raw_cpu_ptr(pool->pcp);
+
+		spin_lock(&pcp->lock);
+		list_add(&p->lru, &pcp->list);
+		if (++pcp->count > pool->pcp_high)
+			_kgsl_pool_spill_pcp(pool, pcp);
+		spin_unlock(&pcp->lock);
+		return;
+	}
+
 	spin_lock(&pool->list_lock);
 	list_add_tail(&p->lru, &pool->page_list);
 	pool->page_count++;
 	spin_unlock(&pool->list_lock);
 }
 
-/* Returns a page from specified pool */
+/* Returns a page from the shared list of the specified pool */
 static struct page *
-_kgsl_pool_get_page(struct kgsl_page_pool *pool)
+__kgsl_pool_get_page(struct kgsl_page_pool *pool)
 {
 	struct page *p = NULL;
 
@@ -108,17 +220,55 @@ _kgsl_pool_get_page(struct kgsl_page_pool *pool)
 	return p;
 }
 
-/* Returns the number of pages in specified pool */
+/* Returns a page from specified pool, preferring the local CPU cache */
+static struct page *
+_kgsl_pool_get_page(struct kgsl_page_pool *pool)
+{
+	struct kgsl_pool_pcp *pcp;
+	struct page *p = NULL;
+
+	if (pool->pcp == NULL) {
+		p = __kgsl_pool_get_page(pool);
+		atomic_long_inc(p ? &pool->pool_hits : &pool->misses);
+		return p;
+	}
+
+	pcp = raw_cpu_ptr(pool->pcp);
+
+	spin_lock(&pcp->lock);
+	if (pcp->count) {
+		atomic_long_inc(&pool->pcp_hits);
+	} else {
+		_kgsl_pool_refill_pcp(pool, pcp);
+		atomic_long_inc(pcp->count ? &pool->pool_hits : &pool->misses);
+	}
+
+	if (pcp->count) {
+		p = list_first_entry(&pcp->list, struct page, lru);
+		list_del(&p->lru);
+		pcp->count--;
+	}
+	spin_unlock(&pcp->lock);
+
+	return p;
+}
+
+/*
+ * Returns the number of pages in specified pool. No lock is held, so the
+ * result is approximate.
+ */
 static int
 kgsl_pool_size(struct kgsl_page_pool *kgsl_pool)
 {
-	int size;
+	int count = READ_ONCE(kgsl_pool->page_count);
+	int cpu;
 
-	spin_lock(&kgsl_pool->list_lock);
-	size = kgsl_pool->page_count * (1 << kgsl_pool->pool_order);
-	spin_unlock(&kgsl_pool->list_lock);
+	if (kgsl_pool->pcp != NULL)
+		for_each_possible_cpu(cpu)
+			count += READ_ONCE(per_cpu_ptr(kgsl_pool->pcp,
+						       cpu)->count);
 
-	return size;
+	return count * (1 << kgsl_pool->pool_order);
 }
 
 /* Returns the number of pages in all kgsl page pools */
@@ -145,8 +295,11 @@ _kgsl_pool_shrink(struct kgsl_page_pool *pool, int num_pages)
 	if (pool == NULL || num_pages <= 0)
 		return pcount;
 
+	if ((READ_ONCE(pool->page_count) << pool->pool_order) < num_pages)
+		_kgsl_pool_drain_pcp(pool);
+
 	for (j = 0; j < num_pages >> pool->pool_order; j++) {
-		struct page *page = _kgsl_pool_get_page(pool);
+		struct page *page = __kgsl_pool_get_page(pool);
 
 		if (page != NULL) {
 			__free_pages(page, pool->pool_order);
@@ -437,6 +590,9 @@ static void kgsl_pool_reserve_pages(void)
 			if (page != NULL)
 				_kgsl_pool_add_page(&kgsl_pools[i], page);
 		}
+
+		/* Reserved pages belong to the pool, not the probing CPU */
+		_kgsl_pool_drain_pcp(&kgsl_pools[i]);
 	}
 }
 
@@ -477,6 +633,29 @@ static struct shrinker kgsl_pool_shrinker = {
 	.batch = 0,
 };
 
+static void kgsl_pool_init_pcp(struct kgsl_page_pool *pool)
+{
+	struct kgsl_pool_pcp *pcp;
+	int cpu;
+
+	pool->pcp_high = max(KGSL_POOL_PCP_PAGES >> pool->pool_order, 1);
+	pool->pcp_batch = max(pool->pcp_high / 2, 1);
+
+	pool->pcp = alloc_percpu(struct kgsl_pool_pcp);
+	if (pool->pcp == NULL) {
+		pr_warn("kgsl: no per-CPU cache for pool order %u\n",
+			pool->pool_order);
+		return;
+	}
+
+	for_each_possible_cpu(cpu) {
+		pcp = per_cpu_ptr(pool->pcp, cpu);
+		spin_lock_init(&pcp->lock);
+		pcp->count = 0;
+		INIT_LIST_HEAD(&pcp->list);
+	}
+}
+
 static void kgsl_pool_config(unsigned int order, unsigned int reserved_pages,
 		bool allocation_allowed)
 {
@@ -495,6 +674,7 @@ static void kgsl_pool_config(unsigned int order, unsigned int reserved_pages,
 	kgsl_pools[kgsl_num_pools].allocation_allowed = allocation_allowed;
 	spin_lock_init(&kgsl_pools[kgsl_num_pools].list_lock);
 	INIT_LIST_HEAD(&kgsl_pools[kgsl_num_pools].page_list);
+	kgsl_pool_init_pcp(&kgsl_pools[kgsl_num_pools]);
 	kgsl_num_pools++;
 }
 
@@ -541,6 +721,36 @@ static void kgsl_of_get_mempools(struct device_node *parent)
 	}
 }
 
+static int kgsl_pool_stats_print(struct seq_file *s, void *unused)
+{
+	int i;
+
+	seq_puts(s, "order pages pcp_hits pool_hits misses\n");
+	for (i = 0; i < kgsl_num_pools; i++) {
+		struct kgsl_page_pool *pool = &kgsl_pools[i];
+
+		seq_printf(s, "%5u %5d %8ld %9ld %6ld\n", pool->pool_order,
+			kgsl_pool_size(pool),
+			atomic_long_read(&pool->pcp_hits),
+			atomic_long_read(&pool->pool_hits),
+			atomic_long_read(&pool->misses));
+	}
+
+	return 0;
+}
+
+static int kgsl_pool_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, kgsl_pool_stats_print, NULL);
+}
+
+static const struct file_operations kgsl_pool_stats_fops = {
+	.open = kgsl_pool_stats_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
 void kgsl_init_page_pools(struct platform_device *pdev)
 {
 
@@ -552,14 +762,25 @@ void kgsl_init_page_pools(struct platform_device *pdev)
 
 	/* Initialize shrinker */
 	register_shrinker(&kgsl_pool_shrinker);
+
+	if (!IS_ERR_OR_NULL(kgsl_get_debugfs_dir()))
+		debugfs_create_file("mempools", 0444, kgsl_get_debugfs_dir(),
+			NULL, &kgsl_pool_stats_fops);
 }
 
 void kgsl_exit_page_pools(void)
 {
+	int i;
+
 	/* Release all pages in pools, if any.*/
 	kgsl_pool_reduce(0, true);
 
 	/* Unregister shrinker */
 	unregister_shrinker(&kgsl_pool_shrinker);
+
+	for (i = 0; i < kgsl_num_pools; i++) {
+		free_percpu(kgsl_pools[i].pcp);
+		kgsl_pools[i].pcp = NULL;
+	}
 }
 
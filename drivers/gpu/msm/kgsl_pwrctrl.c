@@ -1396,6 +1396,108 @@ static ssize_t kgsl_pwrctrl_pwrscale_show(struct device *dev,
 	return snprintf(buf, PAGE_SIZE, "%u\n", psc->enabled);
 }
 
+static ssize_t kgsl_pwrctrl_frame_show(struct device *dev,
+					struct device_attribute *attr,
+					char *buf)
+{
+	struct kgsl_device *device = kgsl_device_from_dev(dev);
+	struct kgsl_pwrscale_frame *frame;
+	unsigned int val;
+
+	if (device == NULL)
+		return 0;
+
+	frame = &device->pwrscale.frame;
+
+	if (!strcmp(attr->attr.name, "frame_dcvs"))
+		val = frame->enabled;
+	else if (!strcmp(attr->attr.name, "frame_period_us"))
+		val = frame->period_us;
+	else
+		val = frame->headroom;
+
+	return snprintf(buf, PAGE_SIZE, "%u\n", val);
+}
+
+static ssize_t kgsl_pwrctrl_frame_store(struct device *dev,
+					struct device_attribute *attr,
+					const char *buf, size_t count)
+{
+	struct kgsl_device *device = kgsl_device_from_dev(dev);
+	struct kgsl_pwrscale_frame *frame;
+	unsigned int val = 0;
+	int ret;
+
+	if (device == NULL)
+		return 0;
+
+	frame = &device->pwrscale.frame;
+
+	ret = kgsl_sysfs_store(buf, &val);
+	if (ret)
+		return ret;
+
+	spin_lock(&frame->lock);
+	if (!strcmp(attr->attr.name, "frame_dcvs"))
+		frame->enabled = val ? true : false;
+	else if (!strcmp(attr->attr.name, "frame_period_us"))
+		frame->period_us = max(val, 1U);
+	else
+		frame->headroom = clamp(val, 1U, 100U);
+	spin_unlock(&frame->lock);
+
+	return count;
+}
+
+static ssize_t kgsl_pwrctrl_frame_hist_show(struct device *dev,
+					struct device_attribute *attr,
+					char *buf)
+{
+	struct kgsl_device *device = kgsl_device_from_dev(dev);
+	struct kgsl_pwrscale_frame *frame;
+	unsigned int hist[KGSL_FRAME_HIST_BUCKETS];
+	int i, num_chars = 0;
+
+	if (device == NULL)
+		return 0;
+
+	frame = &device->pwrscale.frame;
+
+	spin_lock(&frame->lock);
+	memcpy(hist, frame->hist, sizeof(hist));
+	spin_unlock(&frame->lock);
+
+	/* GPU busy time of each frame in percent of its deadline */
+	for (i = 0; i < KGSL_FRAME_HIST_BUCKETS - 1; i++)
+		num_chars += scnprintf(buf + num_chars, PAGE_SIZE - num_chars,
+			"%d-%d%%: %u\n", i * 10, (i + 1) * 10, hist[i]);
+
+	num_chars += scnprintf(buf + num_chars, PAGE_SIZE - num_chars,
+		"missed: %u\n", hist[i]);
+
+	return num_chars;
+}
+
+/* Writing anything clears the histogram */
+static ssize_t kgsl_pwrctrl_frame_hist_store(struct device *dev,
+					struct device_attribute *attr,
+					const char *buf, size_t count)
+{
+	struct kgsl_device *device = kgsl_device_from_dev(dev);
+	struct kgsl_pwrscale_frame *frame;
+
+	if (device == NULL)
+		return 0;
+
+	frame = &device->pwrscale.frame;
+
+	spin_lock(&frame->lock);
+	memset(frame->hist, 0, sizeof(frame->hist));
+	spin_unlock(&frame->lock);
+
+	return count;
+}
+
 static DEVICE_ATTR(gpuclk, 0644, kgsl_pwrctrl_gpuclk_show,
 	kgsl_pwrctrl_gpuclk_store);
 static DEVICE_ATTR(max_gpuclk, 0644, kgsl_pwrctrl_max_gpuclk_show,
@@ -1457,6 +1559,14 @@ static DEVICE_ATTR(temp, 0444, kgsl_pwrctrl_temp_show, NULL);
 static DEVICE_ATTR(pwrscale, 0644,
 	kgsl_pwrctrl_pwrscale_show,
 	kgsl_pwrctrl_pwrscale_store);
+static DEVICE_ATTR(frame_dcvs, 0644, kgsl_pwrctrl_frame_show,
+	kgsl_pwrctrl_frame_store);
+static DEVICE_ATTR(frame_period_us, 0644, kgsl_pwrctrl_frame_show,
+	kgsl_pwrctrl_frame_store);
+static DEVICE_ATTR(frame_headroom, 0644, kgsl_pwrctrl_frame_show,
+	kgsl_pwrctrl_frame_store);
+static DEVICE_ATTR(frame_hist, 0644, kgsl_pwrctrl_frame_hist_show,
+	kgsl_pwrctrl_frame_hist_store);
 
 static const struct device_attribute *pwrctrl_attr_list[] = {
 	&dev_attr_gpuclk,
@@ -1484,6 +1594,10 @@ static const struct device_attribute *pwrctrl_attr_list[] = {
 	&dev_attr_freq_table_mhz,
 	&dev_attr_temp,
 	&dev_attr_pwrscale,
+	&dev_attr_frame_dcvs,
+	&dev_attr_frame_period_us,
+	&dev_attr_frame_headroom,
+	&dev_attr_frame_hist,
 	NULL
 };
 
@@ -2081,6 +2195,130 @@ static void kgsl_pwrctrl_disable_unused_opp(struct kgsl_device *device)
 	}
 }
 
+static int kgsl_cooling_get_max_state(struct thermal_cooling_device *cdev,
+		unsigned long *state)
+{
+	struct kgsl_device *device = cdev->devdata;
+
+	*state = device->pwrctrl.num_pwrlevels - 2;
+	return 0;
+}
+
+static int kgsl_cooling_get_cur_state(struct thermal_cooling_device *cdev,
+		unsigned long *state)
+{
+	struct kgsl_device *device = cdev->devdata;
+
+	*state = device->pwrctrl.thermal_pwrlevel;
+	return 0;
+}
+
+static int kgsl_cooling_set_cur_state(struct thermal_cooling_device *cdev,
+		unsigned long state)
+{
+	struct kgsl_device *device = cdev->devdata;
+	struct kgsl_pwrctrl *pwr = &device->pwrctrl;
+
+	if (state > pwr->num_pwrlevels - 2)
+		return -EINVAL;
+
+	mutex_lock(&device->mutex);
+	pwr->thermal_pwrlevel = state;
+	kgsl_pwrctrl_pwrlevel_change(device, pwr->active_pwrlevel);
+	mutex_unlock(&device->mutex);
+
+	return 0;
+}
+
+static u32 kgsl_pwrlevel_power(struct kgsl_pwrctrl *pwr, unsigned int level)
+{
+	u64 mhz = pwr->pwrlevels[level].gpu_freq / 1000000;
+
+	return div_u64(mhz * pwr->dyn_power_coeff, 1000);
+}
+
+static int kgsl_cooling_get_requested_power(struct thermal_cooling_device *cdev,
+		struct thermal_zone_device *tz, u32 *power)
+{
+	struct kgsl_device *device = cdev->devdata;
+	struct kgsl_pwrctrl *pwr = &device->pwrctrl;
+
+	/* An idle GPU does not compete for the power budget */
+	if (!test_bit(KGSL_PWRFLAGS_CLK_ON, &pwr->power_flags))
+		*power = 0;
+	else
+		*power = kgsl_pwrlevel_power(pwr, pwr->active_pwrlevel);
+	return 0;
+}
+
+static int kgsl_cooling_state2power(struct thermal_cooling_device *cdev,
+		struct thermal_zone_device *tz, unsigned long state, u32 *power)
+{
+	struct kgsl_device *device = cdev->devdata;
+	struct kgsl_pwrctrl *pwr = &device->pwrctrl;
+
+	if (state > pwr->num_pwrlevels - 2)
+		return -EINVAL;
+
+	*power = kgsl_pwrlevel_power(pwr, state);
+	return 0;
+}
+
+static int kgsl_cooling_power2state(struct thermal_cooling_device *cdev,
+		struct thermal_zone_device *tz, u32 power, unsigned long *state)
+{
+	struct kgsl_device *device = cdev->devdata;
+	struct kgsl_pwrctrl *pwr = &device->pwrctrl;
+	unsigned int level;
+
+	/* Power levels are ordered from the fastest to the slowest */
+	for (level = 0; level < pwr->num_pwrlevels - 2; level++)
+		if (kgsl_pwrlevel_power(pwr, level) <= power)
+			break;
+
+	*state = level;
+	return 0;
+}
+
+static const struct thermal_cooling_device_ops kgsl_cooling_ops = {
+	.get_max_state = kgsl_cooling_get_max_state,
+	.get_cur_state = kgsl_cooling_get_cur_state,
+	.set_cur_state = kgsl_cooling_set_cur_state,
+};
+
+static const struct thermal_cooling_device_ops kgsl_power_cooling_ops = {
+	.get_max_state = kgsl_cooling_get_max_state,
+	.get_cur_state = kgsl_cooling_get_cur_state,
+	.set_cur_state = kgsl_cooling_set_cur_state,
+	.get_requested_power = kgsl_cooling_get_requested_power,
+	.state2power = kgsl_cooling_state2power,
+	.power2state = kgsl_cooling_power2state,
+};
+
+/*
+ * Expose thermal_pwrlevel as a cooling device so that thermal zones can
+ * throttle the GPU. With qcom,gpu-dynamic-power-coeff the device also has a
+ * power model and can share a power_allocator budget with the CPUs.
+ */
+static void kgsl_pwrctrl_cooling_register(struct kgsl_device *device)
+{
+	struct kgsl_pwrctrl *pwr = &device->pwrctrl;
+	struct device_node *node = device->pdev->dev.of_node;
+	const struct thermal_cooling_device_ops *ops = &kgsl_cooling_ops;
+
+	if (!of_property_read_u32(node, "qcom,gpu-dynamic-power-coeff",
+			&pwr->dyn_power_coeff) && pwr->dyn_power_coeff)
+		ops = &kgsl_power_cooling_ops;
+
+	pwr->cooling_dev = thermal_of_cooling_device_register(node,
+			"kgsl-gpu", device, ops);
+	if (IS_ERR(pwr->cooling_dev)) {
+		KGSL_PWR_INFO(device, "no GPU cooling device %ld\n",
+			PTR_ERR(pwr->cooling_dev));
+		pwr->cooling_dev = NULL;
+	}
+}
+
 int kgsl_pwrctrl_init(struct kgsl_device *device)
 {
 	int i, k, m, n = 0, result, freq;
@@ -2291,6 +2529,8 @@ int kgsl_pwrctrl_init(struct kgsl_device *device)
 			goto error_cleanup_pwr_limit;
 		}
 	}
+
+	kgsl_pwrctrl_cooling_register(device);
 	return result;
 
 error_cleanup_pwr_limit:
@@ -2321,6 +2561,10 @@ void kgsl_pwrctrl_close(struct kgsl_device *device)
 
 	KGSL_PWR_INFO(device, "close device %d\n", device->id);
 
+	if (pwr->cooling_dev)
+		thermal_cooling_device_unregister(pwr->cooling_dev);
+	pwr->cooling_dev = NULL;
+
 	cx_ipeak_unregister(pwr->gpu_cx_ipeak);
 
 	pwr->power_flags = 0;
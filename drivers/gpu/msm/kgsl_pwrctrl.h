@@ -156,6 +156,8 @@ struct kgsl_regulator {
  * tsens_name - pointer to temperature sensor name of GPU temperature sensor
  * gpu_cx_ipeak - pointer to cx ipeak client used by GPU
  * gpu_cx_ipeak_clk - GPU threshold frequency to call cx ipeak driver API
+ * cooling_dev - thermal cooling device driving thermal_pwrlevel
+ * dyn_power_coeff - dynamic power in uW per MHz, 0 if no power model
  */
 
 struct kgsl_pwrctrl {
@@ -211,6 +213,8 @@ struct kgsl_pwrctrl {
 	const char *tsens_name;
 	struct cx_ipeak_client *gpu_cx_ipeak;
 	unsigned int gpu_cx_ipeak_clk;
+	struct thermal_cooling_device *cooling_dev;
+	u32 dyn_power_coeff;
 };
 
 int kgsl_pwrctrl_init(struct kgsl_device *device);
@@ -14,6 +14,7 @@
 #include <linux/export.h>
 #include <linux/kernel.h>
 #include <linux/hrtimer.h>
+#include <linux/sched.h>
 
 #include "kgsl.h"
 #include "kgsl_pwrscale.h"
@@ -35,6 +36,16 @@ static struct kgsl_midframe_info {
 static void do_devfreq_suspend(struct work_struct *work);
 static void do_devfreq_resume(struct work_struct *work);
 static void do_devfreq_notify(struct work_struct *work);
+static void do_devfreq_frame(struct work_struct *work);
+
+/* Default display refresh period */
+#define KGSL_FRAME_PERIOD_US	16667
+/* Default percentage of the deadline a frame should keep the GPU busy */
+#define KGSL_FRAME_HEADROOM	80
+/* Frames further apart than this many periods are paced by something else */
+#define KGSL_FRAME_MAX_PERIODS	4
+/* A context stops counting towards the target this long after a frame */
+#define KGSL_FRAME_ACTIVE_NS	(100 * NSEC_PER_MSEC)
 
 /*
  * These variables are used to keep the latest data
@@ -168,6 +179,126 @@ void kgsl_pwrscale_update(struct kgsl_device *device)
 }
 EXPORT_SYMBOL(kgsl_pwrscale_update);
 
+/*
+ * The deadline of a frame is the number of whole display periods since the
+ * previous frame of the context, so a context rendering at a fraction of the
+ * refresh rate gets the matching deadline while one that missed the refresh is
+ * still asked to meet it.
+ */
+static u64 _frame_deadline(struct kgsl_pwrscale_frame *frame, u64 interval)
+{
+	u64 period = (u64) frame->period_us * NSEC_PER_USEC;
+	u64 periods = div64_u64(interval, period);
+
+	if (periods == 0 || periods > KGSL_FRAME_MAX_PERIODS)
+		periods = 1;
+
+	return periods * period;
+}
+
+/* Sum of the frequencies needed by the contexts that recently made a frame */
+static unsigned long _frame_target(struct kgsl_device *device, u64 now)
+{
+	struct kgsl_context *context;
+	unsigned long target = 0;
+	int id;
+
+	read_lock(&device->context_lock);
+	idr_for_each_entry(&device->context_idr, context, id) {
+		if (now - context->frame.last_eof < KGSL_FRAME_ACTIVE_NS)
+			target += context->frame.freq;
+	}
+	read_unlock(&device->context_lock);
+
+	return target;
+}
+
+/**
+ * kgsl_pwrscale_frame_retire() - Account a retired command for frame DCVS
+ * @device: The device
+ * @context: Context the command belongs to
+ * @busy_ns: GPU time the command took
+ * @eof: Whether the command ends a frame
+ *
+ * At the end of a frame compute the GPU frequency the frame needed to use
+ * at most the headroom percentage of its deadline, and share the new device
+ * target with the governor.
+ */
+void kgsl_pwrscale_frame_retire(struct kgsl_device *device,
+		struct kgsl_context *context, u64 busy_ns, bool eof)
+{
+	struct kgsl_pwrscale *psc = &device->pwrscale;
+	struct kgsl_pwrscale_frame *frame = &psc->frame;
+	struct kgsl_context_frame *cf = &context->frame;
+	unsigned long freq = kgsl_pwrctrl_active_freq(&device->pwrctrl);
+	u64 now, deadline;
+	unsigned int bucket;
+	bool apply;
+
+	busy_ns = min_t(u64, busy_ns, NSEC_PER_SEC);
+	cf->busy_ns += busy_ns;
+	cf->busy_cycles += div_u64(busy_ns * freq, NSEC_PER_SEC);
+
+	if (!eof)
+		return;
+
+	now = local_clock();
+
+	if (cf->last_eof == 0) {
+		cf->last_eof = now;
+		cf->busy_ns = 0;
+		cf->busy_cycles = 0;
+		return;
+	}
+
+	spin_lock(&frame->lock);
+
+	deadline = _frame_deadline(frame, now - cf->last_eof);
+	cf->freq = div64_u64(div_u64(cf->busy_cycles * 100, frame->headroom) *
+		NSEC_PER_SEC, deadline);
+	cf->last_eof = now;
+
+	bucket = div64_u64(cf->busy_ns * 10, deadline);
+	frame->hist[min_t(unsigned int, bucket,
+		KGSL_FRAME_HIST_BUCKETS - 1)]++;
+
+	spin_unlock(&frame->lock);
+
+	freq = _frame_target(device, now);
+
+	spin_lock(&frame->lock);
+	frame->target_freq = freq;
+	frame->target_time = now;
+	apply = frame->enabled && psc->enabled && psc->devfreqptr;
+	spin_unlock(&frame->lock);
+
+	trace_kgsl_pwrscale_frame(device, context->id, cf->busy_ns, deadline,
+		cf->freq, freq);
+
+	cf->busy_ns = 0;
+	cf->busy_cycles = 0;
+
+	/* to call update_devfreq() from a kernel thread */
+	if (apply)
+		queue_work(psc->devfreq_wq, &frame->frame_ws);
+}
+EXPORT_SYMBOL(kgsl_pwrscale_frame_retire);
+
+/* Frequency frame DCVS wants, or 0 to follow the governor */
+static unsigned long _frame_target_freq(struct kgsl_device *device)
+{
+	struct kgsl_pwrscale_frame *frame = &device->pwrscale.frame;
+	unsigned long freq = 0;
+
+	spin_lock(&frame->lock);
+	if (frame->enabled && frame->target_freq &&
+		local_clock() - frame->target_time < KGSL_FRAME_ACTIVE_NS)
+		freq = frame->target_freq;
+	spin_unlock(&frame->lock);
+
+	return freq;
+}
+
 void kgsl_pwrscale_midframe_timer_restart(struct kgsl_device *device)
 {
 	if (kgsl_midframe) {
@@ -304,7 +435,7 @@ int kgsl_devfreq_target(struct device *dev, unsigned long *freq, u32 flags)
 	struct kgsl_pwrlevel *pwr_level;
 	int level;
 	unsigned int i;
-	unsigned long cur_freq;
+	unsigned long cur_freq, frame_freq;
 
 	if (device == NULL)
 		return -ENODEV;
@@ -323,6 +454,14 @@ int kgsl_devfreq_target(struct device *dev, unsigned long *freq, u32 flags)
 		return 0;
 	}
 
+	/*
+	 * While contexts produce frames, pick the lowest level that meets
+	 * their deadlines instead of the busy ratio based recommendation
+	 */
+	frame_freq = _frame_target_freq(device);
+	if (frame_freq)
+		*freq = frame_freq;
+
 	mutex_lock(&device->mutex);
 	cur_freq = kgsl_pwrctrl_active_freq(pwr);
 	level = pwr->active_pwrlevel;
@@ -699,6 +838,15 @@ int kgsl_pwrscale_init(struct device *dev, const char *governor)
 			data->bin.ctxt_aware_busy_penalty = 12000;
 	}
 
+	spin_lock_init(&pwrscale->frame.lock);
+	pwrscale->frame.enabled = of_property_read_bool(
+		device->pdev->dev.of_node, "qcom,enable-frame-dcvs");
+	if (of_property_read_u32(device->pdev->dev.of_node,
+			"qcom,frame-period-us", &pwrscale->frame.period_us) ||
+			!pwrscale->frame.period_us)
+		pwrscale->frame.period_us = KGSL_FRAME_PERIOD_US;
+	pwrscale->frame.headroom = KGSL_FRAME_HEADROOM;
+
 	if (of_property_read_bool(device->pdev->dev.of_node,
 			"qcom,enable-midframe-timer")) {
 		kgsl_midframe = kzalloc(
@@ -762,6 +910,7 @@ int kgsl_pwrscale_init(struct device *dev, const char *governor)
 	INIT_WORK(&pwrscale->devfreq_suspend_ws, do_devfreq_suspend);
 	INIT_WORK(&pwrscale->devfreq_resume_ws, do_devfreq_resume);
 	INIT_WORK(&pwrscale->devfreq_notify_ws, do_devfreq_notify);
+	INIT_WORK(&pwrscale->frame.frame_ws, do_devfreq_frame);
 	if (kgsl_midframe)
 		INIT_WORK(&kgsl_midframe->timer_check_ws,
 				kgsl_pwrscale_midframe_timer_check);
@@ -846,3 +995,14 @@ static void do_devfreq_notify(struct work_struct *work)
 				 ADRENO_DEVFREQ_NOTIFY_RETIRE,
 				 devfreq);
 }
+
+static void do_devfreq_frame(struct work_struct *work)
+{
+	struct kgsl_pwrscale *pwrscale = container_of(work,
+			struct kgsl_pwrscale, frame.frame_ws);
+	struct devfreq *devfreq = pwrscale->devfreqptr;
+
+	mutex_lock(&devfreq->lock);
+	update_devfreq(devfreq);
+	mutex_unlock(&devfreq->lock);
+}
@@ -18,6 +18,8 @@
 #include <linux/msm_adreno_devfreq.h>
 #include "kgsl_pwrctrl.h"
 
+struct kgsl_context;
+
 /* devfreq governor call window in usec */
 #define KGSL_GOVERNOR_CALL_INTERVAL 10000
 
@@ -52,6 +54,32 @@ struct kgsl_pwr_history {
 	unsigned int size;
 };
 
+/* Frame busy histogram in 10% steps of the deadline, plus missed deadlines */
+#define KGSL_FRAME_HIST_BUCKETS	11
+
+/**
+ * struct kgsl_pwrscale_frame - Frame based DCVS settings and statistics
+ * @lock - Protects the target and the statistics
+ * @enabled - Whether the frame target overrides the governor recommendation
+ * @period_us - Display refresh period, the shortest frame deadline
+ * @headroom - Percentage of the deadline a frame should keep the GPU busy
+ * @target_freq - Lowest GPU frequency meeting the deadlines of the contexts
+ * producing frames, 0 if there are none
+ * @target_time - Time @target_freq was computed, in ns
+ * @hist - Number of frames per busy time bucket
+ * @frame_ws - Let the governor apply a new @target_freq
+ */
+struct kgsl_pwrscale_frame {
+	spinlock_t lock;
+	bool enabled;
+	unsigned int period_us;
+	unsigned int headroom;
+	unsigned long target_freq;
+	u64 target_time;
+	unsigned int hist[KGSL_FRAME_HIST_BUCKETS];
+	struct work_struct frame_ws;
+};
+
 /**
  * struct kgsl_pwrscale - Power scaling settings for a KGSL device
  * @devfreqptr - Pointer to the devfreq device
@@ -72,6 +100,7 @@ struct kgsl_pwr_history {
  * @next_governor_call - Timestamp after which the governor may be notified of
  * a new sample
  * @history - History of power events with timestamps and durations
+ * @frame - Frame based DCVS state
  */
 struct kgsl_pwrscale {
 	struct devfreq *devfreqptr;
@@ -91,6 +120,7 @@ struct kgsl_pwrscale {
 	struct work_struct devfreq_notify_ws;
 	ktime_t next_governor_call;
 	struct kgsl_pwr_history history[KGSL_PWREVENT_MAX];
+	struct kgsl_pwrscale_frame frame;
 };
 
 int kgsl_pwrscale_init(struct device *dev, const char *governor);
@@ -102,6 +132,9 @@ void kgsl_pwrscale_busy(struct kgsl_device *device);
 void kgsl_pwrscale_sleep(struct kgsl_device *device);
 void kgsl_pwrscale_wake(struct kgsl_device *device);
 
+void kgsl_pwrscale_frame_retire(struct kgsl_device *device,
+		struct kgsl_context *context, u64 busy_ns, bool eof);
+
 void kgsl_pwrscale_midframe_timer_restart(struct kgsl_device *device);
 void kgsl_pwrscale_midframe_timer_cancel(struct kgsl_device *device);
 
@@ -336,12 +336,22 @@ int kgsl_allocate_user(struct kgsl_device *device,
 {
 	int ret;
 
+	/*
+	 * Lazy allocations rely on the MMU retrying the transaction once the
+	 * faulting page is populated, fall back to allocating everything now
+	 */
+	if (!MMU_FEATURE(&device->mmu, KGSL_MMU_RETRY_ON_FAULT) ||
+			(flags & KGSL_MEMFLAGS_SECURE))
+		flags &= ~((uint64_t) KGSL_MEMFLAGS_LAZY);
+
 	memdesc->flags = flags;
 
 	if (kgsl_mmu_get_mmutype(device) == KGSL_MMU_TYPE_NONE)
 		ret = kgsl_sharedmem_alloc_contig(device, memdesc, size);
 	else if (flags & KGSL_MEMFLAGS_SECURE)
 		ret = kgsl_allocate_secure(device, memdesc, size);
+	else if (flags & KGSL_MEMFLAGS_LAZY)
+		ret = kgsl_sharedmem_lazy_alloc_user(memdesc, size);
 	else
 		ret = kgsl_sharedmem_page_alloc_user(memdesc, size);
 
@@ -620,6 +630,9 @@ static int kgsl_do_cache_op(struct page *page, void *addr,
 	return 0;
 }
 
+static int kgsl_lazy_cache_range_op(struct kgsl_memdesc *memdesc,
+		uint64_t offset, uint64_t size, unsigned int op);
+
 int kgsl_cache_range_op(struct kgsl_memdesc *memdesc, uint64_t offset,
 		uint64_t size, unsigned int op)
 {
@@ -650,6 +663,9 @@ int kgsl_cache_range_op(struct kgsl_memdesc *memdesc, uint64_t offset,
 		return ret;
 	}
 
+	if (memdesc->priv & KGSL_MEMDESC_LAZY)
+		return kgsl_lazy_cache_range_op(memdesc, offset, size, op);
+
 	/*
 	 * If the buffer is not to mapped to kernel, perform cache
 	 * operations after mapping to kernel.
@@ -1213,6 +1229,416 @@ static void kgsl_cma_unlock_secure(struct kgsl_memdesc *memdesc)
 		ClearPagePrivate(sg_page(memdesc->sgt->sgl));
 }
 
+/*
+ * Lazily allocated memory
+ *
+ * Only the page array is allocated up front. Pages are allocated on the first
+ * CPU fault, or on the first GPU fault if the MMU stalls and retries faulting
+ * transactions, which is a requirement of KGSL_MEMFLAGS_LAZY. A GPU fault
+ * populates the KGSL_LAZY_FAULT_PAGES aligned chunk around the faulting
+ * address since GPU accesses tend to be sequential.
+ *
+ * The populated pages of a lazy memdesc are always mapped in its pagetable
+ * once the memdesc itself is mapped; both are protected by lazy_lock.
+ */
+
+/* Number of pages populated together on a GPU fault */
+#define KGSL_LAZY_FAULT_PAGES 16
+
+static LIST_HEAD(kgsl_lazy_list);
+static DEFINE_MUTEX(kgsl_lazy_list_lock);
+static atomic_long_t kgsl_lazy_populated;
+
+static int _lazy_alloc_page(struct page **page)
+{
+	int page_size = PAGE_SIZE;
+	unsigned int align = PAGE_SHIFT;
+
+	return kgsl_pool_alloc_page(&page_size, page, 1, &align) == 1 ?
+		0 : -ENOMEM;
+}
+
+static void _lazy_release(struct kgsl_memdesc *memdesc, unsigned int first,
+		unsigned int end)
+{
+	unsigned int i;
+
+	for (i = first; i < end; i++) {
+		kgsl_pool_free_page(memdesc->pages[i]);
+		memdesc->pages[i] = NULL;
+	}
+}
+
+static void _lazy_account(struct kgsl_memdesc *memdesc, long count)
+{
+	memdesc->lazy_pages += count;
+	atomic_long_add(count, &kgsl_lazy_populated);
+
+	if (count > 0)
+		KGSL_STATS_ADD((uint64_t) count << PAGE_SHIFT,
+			&kgsl_driver.stats.page_alloc,
+			&kgsl_driver.stats.page_alloc_max);
+	else
+		atomic_long_add(count << PAGE_SHIFT,
+			&kgsl_driver.stats.page_alloc);
+}
+
+/*
+ * Allocate the missing pages in [first, first + count) and map them if the
+ * memdesc is mapped. Must be called with lazy_lock held.
+ */
+static int _lazy_populate(struct kgsl_memdesc *memdesc, unsigned int first,
+		unsigned int count)
+{
+	unsigned int end = min(first + count, memdesc->page_count);
+	unsigned int i = first, start;
+	int ret = 0;
+
+	while (i < end) {
+		if (memdesc->pages[i] != NULL) {
+			i++;
+			continue;
+		}
+
+		for (start = i; i < end && memdesc->pages[i] == NULL; i++) {
+			ret = _lazy_alloc_page(&memdesc->pages[i]);
+			if (ret)
+				break;
+		}
+
+		if (ret == 0 && memdesc->lazy_mapped)
+			ret = kgsl_mmu_map_lazy(memdesc->pagetable, memdesc,
+				(uint64_t) start << PAGE_SHIFT,
+				(uint64_t) (i - start) << PAGE_SHIFT);
+
+		if (ret) {
+			_lazy_release(memdesc, start, i);
+			return ret;
+		}
+
+		_lazy_account(memdesc, i - start);
+	}
+
+	return 0;
+}
+
+/**
+ * kgsl_sharedmem_lazy_fault() - Populate lazy memory the GPU faulted on
+ * @private: Process that owns the faulting context
+ * @gpuaddr: Faulting GPU address
+ *
+ * Return 0 if @gpuaddr is now backed and the access can be retried, or an
+ * error if the fault is not on lazily allocated memory or can't be handled.
+ */
+int kgsl_sharedmem_lazy_fault(struct kgsl_process_private *private,
+		uint64_t gpuaddr)
+{
+	struct kgsl_mem_entry *entry;
+	struct kgsl_memdesc *memdesc;
+	unsigned int first;
+	int ret = -ENOENT;
+
+	if (private == NULL)
+		return -ENOENT;
+
+	entry = kgsl_sharedmem_find(private, gpuaddr);
+	if (entry == NULL)
+		return -ENOENT;
+
+	memdesc = &entry->memdesc;
+
+	if ((memdesc->priv & KGSL_MEMDESC_LAZY) &&
+			gpuaddr < memdesc->gpuaddr + memdesc->size) {
+		first = ((gpuaddr - memdesc->gpuaddr) >> PAGE_SHIFT) &
+			~(KGSL_LAZY_FAULT_PAGES - 1);
+
+		mutex_lock(&memdesc->lazy_lock);
+		if (memdesc->lazy_mapped)
+			ret = _lazy_populate(memdesc, first,
+				KGSL_LAZY_FAULT_PAGES);
+		else
+			ret = -EINVAL;
+		mutex_unlock(&memdesc->lazy_lock);
+	}
+
+	kgsl_mem_entry_put(entry);
+
+	return ret;
+}
+
+static int kgsl_lazy_vmfault(struct kgsl_memdesc *memdesc,
+				struct vm_area_struct *vma,
+				struct vm_fault *vmf)
+{
+	unsigned long offset;
+	unsigned int pgoff;
+	struct page *page;
+	int ret;
+
+	offset = ((unsigned long) vmf->virtual_address - vma->vm_start);
+
+	if (offset >= memdesc->size)
+		return VM_FAULT_SIGBUS;
+
+	pgoff = offset >> PAGE_SHIFT;
+
+	mutex_lock(&memdesc->lazy_lock);
+	ret = _lazy_populate(memdesc, pgoff, 1);
+	page = memdesc->pages[pgoff];
+	if (ret == 0) {
+		get_page(page);
+		memdesc->mapsize += PAGE_SIZE;
+	}
+	mutex_unlock(&memdesc->lazy_lock);
+
+	if (ret)
+		return VM_FAULT_OOM;
+
+	vmf->page = page;
+
+	return 0;
+}
+
+static int kgsl_lazy_map_kernel(struct kgsl_memdesc *memdesc)
+{
+	int ret;
+
+	/* A kernel mapping needs every page */
+	mutex_lock(&memdesc->lazy_lock);
+	ret = _lazy_populate(memdesc, 0, memdesc->page_count);
+	if (ret == 0)
+		ret = kgsl_page_alloc_map_kernel(memdesc);
+	mutex_unlock(&memdesc->lazy_lock);
+
+	return ret;
+}
+
+static void kgsl_lazy_free(struct kgsl_memdesc *memdesc)
+{
+	kgsl_page_alloc_unmap_kernel(memdesc);
+	/* we certainly do not expect the hostptr to still be mapped */
+	BUG_ON(memdesc->hostptr);
+
+	mutex_lock(&kgsl_lazy_list_lock);
+	list_del(&memdesc->lazy_node);
+	mutex_unlock(&kgsl_lazy_list_lock);
+
+	_lazy_account(memdesc, -(long) memdesc->lazy_pages);
+	_lazy_release(memdesc, 0, memdesc->page_count);
+}
+
+static struct kgsl_memdesc_ops kgsl_lazy_alloc_ops = {
+	.free = kgsl_lazy_free,
+	.vmflags = VM_DONTDUMP | VM_DONTEXPAND | VM_DONTCOPY,
+	.vmfault = kgsl_lazy_vmfault,
+	.map_kernel = kgsl_lazy_map_kernel,
+	.unmap_kernel = kgsl_page_alloc_unmap_kernel,
+};
+
+int kgsl_sharedmem_lazy_alloc_user(struct kgsl_memdesc *memdesc,
+		uint64_t size)
+{
+	unsigned int align;
+
+	size = PAGE_ALIGN(size);
+	if (size == 0 || size > UINT_MAX)
+		return -EINVAL;
+
+	/* Pages are populated one at a time */
+	align = (memdesc->flags & KGSL_MEMALIGN_MASK) >> KGSL_MEMALIGN_SHIFT;
+	if (align < PAGE_SHIFT)
+		kgsl_memdesc_set_align(memdesc, PAGE_SHIFT);
+
+	memdesc->page_count = size >> PAGE_SHIFT;
+	memdesc->pages = kgsl_malloc(memdesc->page_count *
+		sizeof(struct page *));
+	if (memdesc->pages == NULL) {
+		memset(memdesc, 0, sizeof(*memdesc));
+		return -ENOMEM;
+	}
+
+	memset(memdesc->pages, 0, memdesc->page_count * sizeof(struct page *));
+
+	memdesc->size = size;
+	memdesc->ops = &kgsl_lazy_alloc_ops;
+	memdesc->priv |= KGSL_MEMDESC_LAZY;
+	mutex_init(&memdesc->lazy_lock);
+
+	mutex_lock(&kgsl_lazy_list_lock);
+	list_add_tail(&memdesc->lazy_node, &kgsl_lazy_list);
+	mutex_unlock(&kgsl_lazy_list_lock);
+
+	return 0;
+}
+
+static int kgsl_lazy_cache_range_op(struct kgsl_memdesc *memdesc,
+		uint64_t offset, uint64_t size, unsigned int op)
+{
+	uint64_t end = offset + size;
+	uint64_t len;
+	int ret = 0;
+
+	mutex_lock(&memdesc->lazy_lock);
+
+	/* Pages that aren't populated yet have nothing in the caches */
+	for (; offset < end && ret == 0; offset += len) {
+		struct page *page = memdesc->pages[offset >> PAGE_SHIFT];
+
+		len = min_t(uint64_t, end - offset,
+			PAGE_SIZE - (offset & ~PAGE_MASK));
+
+		if (page != NULL)
+			ret = kgsl_do_cache_op(page, NULL,
+				offset & ~PAGE_MASK, len, op);
+	}
+
+	mutex_unlock(&memdesc->lazy_lock);
+
+	return ret;
+}
+
+static bool _lazy_page_is_zero(struct page *page)
+{
+	void *addr;
+	bool zero;
+
+	/* Drop the lines left by zeroing the page, the GPU doesn't snoop */
+	kgsl_do_cache_op(page, NULL, 0, PAGE_SIZE, KGSL_CACHE_OP_INV);
+
+	addr = kmap_atomic(page);
+	zero = memchr_inv(addr, 0, PAGE_SIZE) == NULL;
+	kunmap_atomic(addr);
+
+	return zero;
+}
+
+/*
+ * Release the populated pages of @memdesc that were never written. Each run
+ * of pages is unmapped from the GPU before it is checked, so a GPU access in
+ * between faults and waits for lazy_lock instead of racing with the check.
+ * The pages that are in use are mapped again. Called with lazy_lock held.
+ */
+static unsigned long _lazy_shrink_memdesc(struct kgsl_memdesc *memdesc,
+		unsigned long nr)
+{
+	unsigned int i = 0, j, start, end;
+	unsigned long freed = 0;
+
+	while (i < memdesc->page_count && freed < nr) {
+		if (memdesc->pages[i] == NULL) {
+			i++;
+			continue;
+		}
+
+		for (start = i; i < memdesc->page_count &&
+				memdesc->pages[i] != NULL; i++)
+			;
+
+		if (memdesc->lazy_mapped && kgsl_mmu_unmap_lazy(
+				memdesc->pagetable, memdesc,
+				(uint64_t) start << PAGE_SHIFT,
+				(uint64_t) (i - start) << PAGE_SHIFT))
+			continue;
+
+		for (j = start; j < i; j++) {
+			if (!_lazy_page_is_zero(memdesc->pages[j]))
+				continue;
+
+			_lazy_release(memdesc, j, j + 1);
+			freed++;
+		}
+
+		if (!memdesc->lazy_mapped)
+			continue;
+
+		for (j = start; j < i; j = end) {
+			if (memdesc->pages[j] == NULL) {
+				end = j + 1;
+				continue;
+			}
+
+			for (end = j; end < i && memdesc->pages[end] != NULL;
+					end++)
+				;
+
+			if (kgsl_mmu_map_lazy(memdesc->pagetable, memdesc,
+					(uint64_t) j << PAGE_SHIFT,
+					(uint64_t) (end - j) << PAGE_SHIFT)) {
+				/*
+				 * Better lose the contents than have the GPU
+				 * fault on a populated page forever
+				 */
+				KGSL_CORE_ERR("lazy remap failed: 0x%llx\n",
+					memdesc->gpuaddr +
+					((uint64_t) j << PAGE_SHIFT));
+				_lazy_release(memdesc, j, end);
+				freed += end - j;
+			}
+		}
+	}
+
+	_lazy_account(memdesc, -(long) freed);
+
+	return freed;
+}
+
+static unsigned long
+kgsl_lazy_shrink_count_objects(struct shrinker *shrinker,
+		struct shrink_control *sc)
+{
+	return atomic_long_read(&kgsl_lazy_populated);
+}
+
+static unsigned long
+kgsl_lazy_shrink_scan_objects(struct shrinker *shrinker,
+		struct shrink_control *sc)
+{
+	struct kgsl_memdesc *memdesc;
+	unsigned long freed = 0;
+
+	if (!mutex_trylock(&kgsl_lazy_list_lock))
+		return SHRINK_STOP;
+
+	list_for_each_entry(memdesc, &kgsl_lazy_list, lazy_node) {
+		if (freed >= sc->nr_to_scan)
+			break;
+
+		/* CPU writes can't be tracked, leave CPU mapped memory alone */
+		if (memdesc->mapsize)
+			continue;
+
+		if (!mutex_trylock(&memdesc->lazy_lock))
+			continue;
+
+		if (memdesc->hostptr == NULL)
+			freed += _lazy_shrink_memdesc(memdesc,
+				sc->nr_to_scan - freed);
+
+		mutex_unlock(&memdesc->lazy_lock);
+	}
+
+	mutex_unlock(&kgsl_lazy_list_lock);
+
+	return freed;
+}
+
+static struct shrinker kgsl_lazy_shrinker = {
+	.count_objects = kgsl_lazy_shrink_count_objects,
+	.scan_objects = kgsl_lazy_shrink_scan_objects,
+	.seeks = DEFAULT_SEEKS,
+	.batch = 0,
+};
+
+void kgsl_sharedmem_lazy_init(void)
+{
+	register_shrinker(&kgsl_lazy_shrinker);
+}
+
+void kgsl_sharedmem_lazy_exit(void)
+{
+	unregister_shrinker(&kgsl_lazy_shrinker);
+}
+
 void kgsl_sharedmem_set_noretry(bool val)
 {
 	sharedmem_noretry_flag = val;
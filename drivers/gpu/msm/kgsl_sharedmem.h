@@ -73,6 +73,15 @@ void kgsl_get_memory_usage(char *str, size_t len, uint64_t memflags);
 int kgsl_sharedmem_page_alloc_user(struct kgsl_memdesc *memdesc,
 				uint64_t size);
 
+int kgsl_sharedmem_lazy_alloc_user(struct kgsl_memdesc *memdesc,
+				uint64_t size);
+
+int kgsl_sharedmem_lazy_fault(struct kgsl_process_private *private,
+				uint64_t gpuaddr);
+
+void kgsl_sharedmem_lazy_init(void);
+void kgsl_sharedmem_lazy_exit(void);
+
 #define MEMFLAGS(_flags, _mask, _shift) \
 	((unsigned int) (((_flags) & (_mask)) >> (_shift)))
 
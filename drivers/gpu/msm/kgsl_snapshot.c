@@ -16,6 +16,8 @@
 #include <linux/utsname.h>
 #include <linux/sched.h>
 #include <linux/idr.h>
+#include <linux/lz4.h>
+#include <linux/vmalloc.h>
 
 #include "kgsl.h"
 #include "kgsl_log.h"
@@ -31,6 +33,13 @@ struct kgsl_snapshot_cp_obj {
 	struct list_head node;
 };
 
+/* An IB of the faulting process that still needs to be parsed */
+struct kgsl_snapshot_ib {
+	uint64_t gpuaddr;
+	uint64_t dwords;
+	struct list_head node;
+};
+
 struct snapshot_obj_itr {
 	u8 *buf;      /* Buffer pointer to write to */
 	int pos;        /* Current position in the sequence */
@@ -611,6 +620,7 @@ void kgsl_device_snapshot(struct kgsl_device *device,
 	init_completion(&snapshot->dump_gate);
 	INIT_LIST_HEAD(&snapshot->obj_list);
 	INIT_LIST_HEAD(&snapshot->cp_list);
+	INIT_LIST_HEAD(&snapshot->ib_list);
 	INIT_WORK(&snapshot->work, kgsl_snapshot_save_frozen_objs);
 
 	snapshot->start = device->snapshot_memory.ptr;
@@ -697,6 +707,34 @@ static void kgsl_snapshot_process_ib_obj_list(struct kgsl_snapshot *snapshot)
 	}
 }
 
+/**
+ * kgsl_snapshot_process_deferred_ibs() - Parse the IBs deferred by the
+ * snapshot and queue the objects they use to be dumped
+ * @device: device being snapshotted
+ * @snapshot: the snapshot instance
+ */
+static void kgsl_snapshot_process_deferred_ibs(struct kgsl_device *device,
+		struct kgsl_snapshot *snapshot)
+{
+	struct kgsl_snapshot_ib *ib, *tmp;
+	struct adreno_ib_object_list *ib_obj_list;
+
+	list_for_each_entry_safe(ib, tmp, &snapshot->ib_list, node) {
+		ib_obj_list = NULL;
+
+		adreno_ib_create_object_list(device, snapshot->process,
+			ib->gpuaddr, ib->dwords, snapshot->ib2base,
+			&ib_obj_list);
+
+		if (ib_obj_list &&
+			kgsl_snapshot_add_ib_obj_list(snapshot, ib_obj_list))
+			adreno_ib_destroy_obj_list(ib_obj_list);
+
+		list_del(&ib->node);
+		kfree(ib);
+	}
+}
+
 #define to_snapshot_attr(a) \
 container_of(a, struct kgsl_snapshot_attribute, attr)
 
@@ -861,6 +899,49 @@ static ssize_t snapshot_crashdumper_store(struct kgsl_device *device,
 	return (ssize_t) ret < 0 ? ret : count;
 }
 
+/* Show whether the IBs are parsed after recovery */
+static ssize_t snapshot_deferred_show(struct kgsl_device *device, char *buf)
+{
+	return snprintf(buf, PAGE_SIZE, "%d\n", device->snapshot_deferred);
+}
+
+static ssize_t snapshot_deferred_store(struct kgsl_device *device,
+	const char *buf, size_t count)
+{
+	unsigned int val = 0;
+	int ret;
+
+	ret = kgsl_sysfs_store(buf, &val);
+
+	if (!ret && device)
+		device->snapshot_deferred = (bool)val;
+
+	return (ssize_t) ret < 0 ? ret : count;
+}
+
+/* Show whether the frozen buffers are saved compressed */
+static ssize_t snapshot_compress_show(struct kgsl_device *device, char *buf)
+{
+	return snprintf(buf, PAGE_SIZE, "%d\n", device->snapshot_compress);
+}
+
+static ssize_t snapshot_compress_store(struct kgsl_device *device,
+	const char *buf, size_t count)
+{
+	unsigned int val = 0;
+	int ret;
+
+	if (!IS_ENABLED(CONFIG_QCOM_KGSL_SNAPSHOT_COMPRESS))
+		return -ENODEV;
+
+	ret = kgsl_sysfs_store(buf, &val);
+
+	if (!ret && device)
+		device->snapshot_compress = (bool)val;
+
+	return (ssize_t) ret < 0 ? ret : count;
+}
+
 /* Show the timestamp of the last collected snapshot */
 static ssize_t timestamp_show(struct kgsl_device *device, char *buf)
 {
@@ -889,6 +970,10 @@ static SNAPSHOT_ATTR(faultcount, 0644, faultcount_show, faultcount_store);
 static SNAPSHOT_ATTR(force_panic, 0644, force_panic_show, force_panic_store);
 static SNAPSHOT_ATTR(snapshot_crashdumper, 0644, snapshot_crashdumper_show,
 	snapshot_crashdumper_store);
+static SNAPSHOT_ATTR(snapshot_deferred, 0644, snapshot_deferred_show,
+	snapshot_deferred_store);
+static SNAPSHOT_ATTR(snapshot_compress, 0644, snapshot_compress_show,
+	snapshot_compress_store);
 
 static ssize_t snapshot_sysfs_show(struct kobject *kobj,
 	struct attribute *attr, char *buf)
@@ -970,6 +1055,8 @@ int kgsl_device_snapshot_init(struct kgsl_device *device)
 	device->snapshot_faultcount = 0;
 	device->force_panic = 0;
 	device->snapshot_crashdumper = 0;
+	device->snapshot_deferred = 0;
+	device->snapshot_compress = 0;
 
 	ret = kobject_init_and_add(&device->snapshot_kobj, &ktype_snapshot,
 		&device->dev->kobj, "snapshot");
@@ -995,6 +1082,16 @@ int kgsl_device_snapshot_init(struct kgsl_device *device)
 
 	ret  = sysfs_create_file(&device->snapshot_kobj,
 			&attr_snapshot_crashdumper.attr);
+	if (ret)
+		goto done;
+
+	ret  = sysfs_create_file(&device->snapshot_kobj,
+			&attr_snapshot_deferred.attr);
+	if (ret)
+		goto done;
+
+	ret  = sysfs_create_file(&device->snapshot_kobj,
+			&attr_snapshot_compress.attr);
 done:
 	return ret;
 }
@@ -1048,8 +1145,82 @@ int kgsl_snapshot_add_ib_obj_list(struct kgsl_snapshot *snapshot,
 	return 0;
 }
 
+/**
+ * kgsl_snapshot_defer_ib() - Leave an IB to be parsed by the snapshot worker
+ * @snapshot: the snapshot instance
+ * @gpuaddr: GPU address of the IB in the faulting process
+ * @dwords: size of the IB in dwords
+ *
+ * Parsing the IB and freezing the buffers it uses is then done after the
+ * GPU has been recovered, at the cost of missing buffers that the process
+ * frees in the meantime. Returns 0 on success else -ENOMEM.
+ */
+int kgsl_snapshot_defer_ib(struct kgsl_snapshot *snapshot,
+	uint64_t gpuaddr, uint64_t dwords)
+{
+	struct kgsl_snapshot_ib *ib;
+
+	ib = kzalloc(sizeof(*ib), GFP_KERNEL);
+	if (!ib)
+		return -ENOMEM;
+	ib->gpuaddr = gpuaddr;
+	ib->dwords = dwords;
+	list_add_tail(&ib->node, &snapshot->ib_list);
+	return 0;
+}
+
+#ifdef CONFIG_QCOM_KGSL_SNAPSHOT_COMPRESS
+/*
+ * Write @obj as a compressed section into the space reserved for its
+ * uncompressed section. Returns the size of the section, or 0 if the data
+ * doesn't compress well enough to fit and has to be stored as is.
+ */
+static size_t _mempool_compress_object(u8 *data,
+		struct kgsl_snapshot_object *obj, void *src, void *wrkmem)
+{
+	struct kgsl_snapshot_section_header *section =
+		(struct kgsl_snapshot_section_header *)data;
+	struct kgsl_snapshot_gpu_object_lz4 *header =
+		(struct kgsl_snapshot_gpu_object_lz4 *)(data + sizeof(*section));
+	u8 *dest = data + sizeof(*section) + sizeof(*header);
+	int room, csize;
+
+	if (obj->size > INT_MAX)
+		return 0;
+
+	/* Leave room for the difference between the section headers */
+	room = (int) obj->size - (int) (sizeof(*header) -
+		sizeof(struct kgsl_snapshot_gpu_object_v2));
+	if (room <= 0)
+		return 0;
+
+	csize = LZ4_compress_default(src, dest, obj->size, room, wrkmem);
+	if (csize <= 0)
+		return 0;
+
+	section->magic = SNAPSHOT_SECTION_MAGIC;
+	section->id = KGSL_SNAPSHOT_SECTION_GPU_OBJECT_LZ4;
+	section->size = ALIGN(csize, 4) + sizeof(*header) + sizeof(*section);
+
+	header->size = obj->size >> 2;
+	header->csize = csize;
+	header->gpuaddr = obj->gpuaddr;
+	header->ptbase =
+		kgsl_mmu_pagetable_get_ttbr0(obj->entry->priv->pagetable);
+	header->type = obj->type;
+
+	return section->size;
+}
+#else
+static inline size_t _mempool_compress_object(u8 *data,
+		struct kgsl_snapshot_object *obj, void *src, void *wrkmem)
+{
+	return 0;
+}
+#endif
+
 static size_t _mempool_add_object(struct kgsl_snapshot *snapshot, u8 *data,
-		struct kgsl_snapshot_object *obj)
+		struct kgsl_snapshot_object *obj, void *wrkmem)
 {
 	struct kgsl_snapshot_section_header *section =
 		(struct kgsl_snapshot_section_header *)data;
@@ -1083,6 +1254,16 @@ static size_t _mempool_add_object(struct kgsl_snapshot *snapshot, u8 *data,
 				snapshot->ib2base, snapshot->ib2size))
 		snapshot->ib2dumped = true;
 
+	if (wrkmem != NULL) {
+		size_t ret = _mempool_compress_object(data, obj,
+			obj->entry->memdesc.hostptr + obj->offset, wrkmem);
+
+		if (ret) {
+			kgsl_memdesc_unmap(&obj->entry->memdesc);
+			return ret;
+		}
+	}
+
 	memcpy(dest, obj->entry->memdesc.hostptr + obj->offset, size);
 	kgsl_memdesc_unmap(&obj->entry->memdesc);
 
@@ -1102,11 +1283,12 @@ void kgsl_snapshot_save_frozen_objs(struct work_struct *work)
 	struct kgsl_device *device = kgsl_get_device(KGSL_DEVICE_3D0);
 	struct kgsl_snapshot_object *obj, *tmp;
 	size_t size = 0;
-	void *ptr;
+	void *ptr, *wrkmem = NULL;
 
 	if (IS_ERR_OR_NULL(device))
 		return;
 
+	kgsl_snapshot_process_deferred_ibs(device, snapshot);
 	kgsl_snapshot_process_ib_obj_list(snapshot);
 
 	list_for_each_entry(obj, &snapshot->obj_list, node) {
@@ -1122,19 +1304,36 @@ void kgsl_snapshot_save_frozen_objs(struct work_struct *work)
 
 	snapshot->mempool = vmalloc(size);
 
+	if (IS_ENABLED(CONFIG_QCOM_KGSL_SNAPSHOT_COMPRESS) &&
+		device->snapshot_compress)
+		wrkmem = vmalloc(LZ4_MEM_COMPRESS);
+
 	ptr = snapshot->mempool;
 	snapshot->mempool_size = 0;
 
 	/* even if vmalloc fails, make sure we clean up the obj_list */
 	list_for_each_entry_safe(obj, tmp, &snapshot->obj_list, node) {
 		if (snapshot->mempool) {
-			size_t ret = _mempool_add_object(snapshot, ptr, obj);
+			size_t ret = _mempool_add_object(snapshot, ptr, obj,
+				wrkmem);
 			ptr += ret;
 			snapshot->mempool_size += ret;
 		}
 
 		kgsl_snapshot_put_object(obj);
 	}
+
+	vfree(wrkmem);
+
+	/* Give back what compression saved */
+	if (snapshot->mempool && snapshot->mempool_size < size) {
+		ptr = vmalloc(snapshot->mempool_size);
+		if (ptr) {
+			memcpy(ptr, snapshot->mempool, snapshot->mempool_size);
+			vfree(snapshot->mempool);
+			snapshot->mempool = ptr;
+		}
+	}
 done:
 	/*
 	 * Get rid of the process struct here, so that it doesn't sit
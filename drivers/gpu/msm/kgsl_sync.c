@@ -134,6 +134,171 @@ static int _add_fence_event(struct kgsl_device *device,
 	return ret;
 }
 
+/*
+ * Pending fences
+ *
+ * The fences of a timeline that wait for their timestamp share a single
+ * timestamp event, registered for the oldest one. When it fires, every fence
+ * retired by then is signaled at once and the event is registered again for
+ * the next one. A request for a timestamp that already has a pending fence
+ * gets another reference to that fence rather than a new sync_pt. Only when
+ * too many fences are pending does a fence get an event of its own.
+ */
+
+static void kgsl_fence_timeline_cb(struct kgsl_device *device,
+		struct kgsl_event_group *group, void *priv, int result);
+
+/* Must be called with fence_lock held */
+static int _arm_timeline_event(struct kgsl_device *device,
+		struct kgsl_context *context, unsigned int timestamp)
+{
+	struct kgsl_sync_timeline *ktimeline =
+		(struct kgsl_sync_timeline *) context->timeline;
+	int ret;
+
+	ret = kgsl_add_event(device, &context->events, timestamp,
+		kgsl_fence_timeline_cb, ktimeline);
+	if (ret == 0) {
+		ktimeline->armed = true;
+		ktimeline->armed_ts = timestamp;
+	}
+
+	return ret;
+}
+
+/*
+ * Remove the pending fences up to @timestamp and move them to @done. Must be
+ * called with fence_lock held.
+ */
+static unsigned int _retire_pending(struct kgsl_sync_timeline *ktimeline,
+		unsigned int timestamp, struct sync_fence **done)
+{
+	unsigned int i;
+
+	for (i = 0; i < ktimeline->num_pending; i++) {
+		if (timestamp_cmp(ktimeline->pending[i].timestamp,
+				timestamp) > 0)
+			break;
+
+		done[i] = ktimeline->pending[i].fence;
+	}
+
+	ktimeline->num_pending -= i;
+	memmove(ktimeline->pending, ktimeline->pending + i,
+		ktimeline->num_pending * sizeof(ktimeline->pending[0]));
+
+	return i;
+}
+
+/**
+ * kgsl_fence_timeline_cb - Event callback for the pending fences of a
+ * timeline
+ * @device - The KGSL device that expired the timestamp
+ * @group - Event group of the context that owns the timeline
+ * @priv: The timeline
+ * @result - Result of the event (retired or canceled)
+ *
+ * Signal all the fences retired so far and register the event for the next
+ * pending one. A cancelled event signals all the pending fences, as a
+ * cancelled fence event does.
+ */
+static void kgsl_fence_timeline_cb(struct kgsl_device *device,
+		struct kgsl_event_group *group, void *priv, int result)
+{
+	struct kgsl_sync_timeline *ktimeline = priv;
+	struct kgsl_context *context = group->context;
+	struct sync_fence *done[KGSL_SYNC_PENDING_FENCES];
+	unsigned int retired, last, i, count;
+
+	kgsl_readtimestamp(device, context, KGSL_TIMESTAMP_RETIRED, &retired);
+	last = retired;
+
+	mutex_lock(&ktimeline->fence_lock);
+
+	if (ktimeline->armed &&
+			timestamp_cmp(retired, ktimeline->armed_ts) >= 0)
+		ktimeline->armed = false;
+
+	if (ktimeline->num_pending) {
+		last = ktimeline->pending[ktimeline->num_pending - 1].timestamp;
+
+		if (result == KGSL_EVENT_CANCELLED &&
+				timestamp_cmp(last, retired) > 0)
+			retired = last;
+	}
+
+	count = _retire_pending(ktimeline, retired, done);
+
+	if (!ktimeline->armed && ktimeline->num_pending &&
+		_arm_timeline_event(device, context,
+			ktimeline->pending[0].timestamp)) {
+		/* Don't leave the fences hanging if the event can't be added */
+		retired = last;
+		count += _retire_pending(ktimeline, retired, done + count);
+	}
+
+	mutex_unlock(&ktimeline->fence_lock);
+
+	kgsl_sync_timeline_signal(context->timeline, retired);
+
+	for (i = 0; i < count; i++)
+		sync_fence_put(done[i]);
+}
+
+/* Must be called with fence_lock held */
+static struct sync_fence *_get_pending_fence(
+		struct kgsl_sync_timeline *ktimeline, unsigned int timestamp)
+{
+	unsigned int i;
+
+	for (i = 0; i < ktimeline->num_pending; i++) {
+		struct sync_fence *fence = ktimeline->pending[i].fence;
+
+		if (ktimeline->pending[i].timestamp == timestamp) {
+			get_file(fence->file);
+			return fence;
+		}
+	}
+
+	return NULL;
+}
+
+/* Must be called with fence_lock held */
+static int _add_pending_fence(struct kgsl_device *device,
+		struct kgsl_context *context, unsigned int timestamp,
+		struct sync_fence *fence)
+{
+	struct kgsl_sync_timeline *ktimeline =
+		(struct kgsl_sync_timeline *) context->timeline;
+	unsigned int i;
+	int ret;
+
+	if (ktimeline->num_pending == KGSL_SYNC_PENDING_FENCES)
+		return _add_fence_event(device, context, timestamp);
+
+	if (!ktimeline->armed ||
+			timestamp_cmp(timestamp, ktimeline->armed_ts) < 0) {
+		ret = _arm_timeline_event(device, context, timestamp);
+		if (ret)
+			return ret;
+	}
+
+	for (i = ktimeline->num_pending; i > 0; i--) {
+		if (timestamp_cmp(ktimeline->pending[i - 1].timestamp,
+				timestamp) < 0)
+			break;
+
+		ktimeline->pending[i] = ktimeline->pending[i - 1];
+	}
+
+	get_file(fence->file);
+	ktimeline->pending[i].timestamp = timestamp;
+	ktimeline->pending[i].fence = fence;
+	ktimeline->num_pending++;
+
+	return 0;
+}
+
 /**
  * kgsl_add_fence_event - Create a new fence event
  * @device - KGSL device to create the event on
@@ -153,6 +318,7 @@ int kgsl_add_fence_event(struct kgsl_device *device,
 {
 	struct kgsl_timestamp_event_fence priv;
 	struct kgsl_context *context;
+	struct kgsl_sync_timeline *ktimeline;
 	struct sync_pt *pt;
 	struct sync_fence *fence = NULL;
 	int ret = -EINVAL;
@@ -172,11 +338,30 @@ int kgsl_add_fence_event(struct kgsl_device *device,
 	if (test_bit(KGSL_CONTEXT_PRIV_INVALID, &context->priv))
 		goto out;
 
+	priv.fence_fd = get_unused_fd_flags(0);
+	if (priv.fence_fd < 0) {
+		KGSL_DRV_CRIT_RATELIMIT(device,
+			"Unable to get a file descriptor: %d\n",
+			priv.fence_fd);
+		ret = priv.fence_fd;
+		goto out;
+	}
+
+	ktimeline = (struct kgsl_sync_timeline *) context->timeline;
+	mutex_lock(&ktimeline->fence_lock);
+
+	/* Share the fence already waiting for this timestamp */
+	fence = _get_pending_fence(ktimeline, timestamp);
+	if (fence != NULL) {
+		ret = 0;
+		goto unlock;
+	}
+
 	pt = kgsl_sync_pt_create(context->timeline, context, timestamp);
 	if (pt == NULL) {
 		KGSL_DRV_CRIT_RATELIMIT(device, "kgsl_sync_pt_create failed\n");
 		ret = -ENOMEM;
-		goto out;
+		goto unlock;
 	}
 	snprintf(fence_name, sizeof(fence_name),
 		"%s-pid-%d-ctx-%d-ts-%u",
@@ -190,22 +375,13 @@ int kgsl_add_fence_event(struct kgsl_device *device,
 		kgsl_sync_pt_destroy(pt);
 		KGSL_DRV_CRIT_RATELIMIT(device, "sync_fence_create failed\n");
 		ret = -ENOMEM;
-		goto out;
-	}
-
-	priv.fence_fd = get_unused_fd_flags(0);
-	if (priv.fence_fd < 0) {
-		KGSL_DRV_CRIT_RATELIMIT(device,
-			"Unable to get a file descriptor: %d\n",
-			priv.fence_fd);
-		ret = priv.fence_fd;
-		goto out;
+		goto unlock;
 	}
 
 	/*
-	 * If the timestamp hasn't expired yet create an event to trigger it.
-	 * Otherwise, just signal the fence - there is no reason to go through
-	 * the effort of creating a fence we don't need.
+	 * If the timestamp hasn't expired yet queue the fence to be signaled
+	 * when it does. Otherwise, just signal the fence - there is no reason
+	 * to go through the effort of creating a fence we don't need.
 	 */
 
 	kgsl_readtimestamp(device, context, KGSL_TIMESTAMP_RETIRED, &cur);
@@ -213,11 +389,13 @@ int kgsl_add_fence_event(struct kgsl_device *device,
 	if (timestamp_cmp(cur, timestamp) >= 0) {
 		ret = 0;
 		kgsl_sync_timeline_signal(context->timeline, cur);
-	} else {
-		ret = _add_fence_event(device, context, timestamp);
-		if (ret)
-			goto out;
-	}
+	} else
+		ret = _add_pending_fence(device, context, timestamp, fence);
+
+unlock:
+	mutex_unlock(&ktimeline->fence_lock);
+	if (ret)
+		goto out;
 
 	if (copy_to_user(data, &priv, sizeof(priv))) {
 		ret = -EFAULT;
@@ -342,6 +520,7 @@ int kgsl_sync_timeline_create(struct kgsl_context *context)
 	ktimeline->context_id = context->id;
 
 	spin_lock_init(&ktimeline->lock);
+	mutex_init(&ktimeline->fence_lock);
 	return 0;
 }
 
@@ -361,7 +540,22 @@ static void kgsl_sync_timeline_signal(struct sync_timeline *timeline,
 
 void kgsl_sync_timeline_destroy(struct kgsl_context *context)
 {
+	struct kgsl_sync_timeline *ktimeline =
+		(struct kgsl_sync_timeline *) context->timeline;
+	struct sync_fence *done[KGSL_SYNC_PENDING_FENCES];
+	unsigned int i, count;
+
+	mutex_lock(&ktimeline->fence_lock);
+	count = ktimeline->num_pending;
+	for (i = 0; i < count; i++)
+		done[i] = ktimeline->pending[i].fence;
+	ktimeline->num_pending = 0;
+	mutex_unlock(&ktimeline->fence_lock);
+
 	sync_timeline_destroy(context->timeline);
+
+	for (i = 0; i < count; i++)
+		sync_fence_put(done[i]);
 }
 
 static void kgsl_sync_callback(struct sync_fence *fence,
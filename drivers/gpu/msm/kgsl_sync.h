@@ -16,12 +16,39 @@
 #include "sync.h"
 #include "kgsl_device.h"
 
+/* Number of pending fences a timeline signals from a shared event */
+#define KGSL_SYNC_PENDING_FENCES 16
+
+struct kgsl_sync_pending_fence {
+	unsigned int timestamp;
+	struct sync_fence *fence;
+};
+
+/**
+ * struct kgsl_sync_timeline - KGSL timeline of a context
+ * @timeline: Base sync timeline, this needs to be the first entry
+ * @last_timestamp: Last timestamp signaled on the timeline
+ * @device: Device that owns the context
+ * @context_id: ID of the context
+ * @lock: Protects @last_timestamp
+ * @fence_lock: Protects the pending fences and the timestamp event
+ * @pending: Fences waiting for their timestamp, sorted by timestamp and
+ * holding a reference
+ * @num_pending: Number of entries in @pending
+ * @armed: Whether a timestamp event is registered for @pending
+ * @armed_ts: Timestamp of that event
+ */
 struct kgsl_sync_timeline {
 	struct sync_timeline timeline;
 	unsigned int last_timestamp;
 	struct kgsl_device *device;
 	u32 context_id;
 	spinlock_t lock;
+	struct mutex fence_lock;
+	struct kgsl_sync_pending_fence pending[KGSL_SYNC_PENDING_FENCES];
+	unsigned int num_pending;
+	bool armed;
+	unsigned int armed_ts;
 };
 
 struct kgsl_sync_pt {
@@ -367,6 +367,37 @@ TRACE_EVENT(kgsl_pwrstats,
 	)
 );
 
+TRACE_EVENT(kgsl_pwrscale_frame,
+	TP_PROTO(struct kgsl_device *device, unsigned int id, u64 busy_ns,
+		u64 deadline_ns, unsigned long freq, unsigned long target),
+
+	TP_ARGS(device, id, busy_ns, deadline_ns, freq, target),
+
+	TP_STRUCT__entry(
+		__string(device_name, device->name)
+		__field(unsigned int, id)
+		__field(u64, busy_ns)
+		__field(u64, deadline_ns)
+		__field(unsigned long, freq)
+		__field(unsigned long, target)
+	),
+
+	TP_fast_assign(
+		__assign_str(device_name, device->name);
+		__entry->id = id;
+		__entry->busy_ns = busy_ns;
+		__entry->deadline_ns = deadline_ns;
+		__entry->freq = freq;
+		__entry->target = target;
+	),
+
+	TP_printk(
+		"d_name=%s ctx=%u busy=%llu deadline=%llu freq=%lu target=%lu",
+		__get_str(device_name), __entry->id, __entry->busy_ns,
+		__entry->deadline_ns, __entry->freq, __entry->target
+	)
+);
+
 DECLARE_EVENT_CLASS(kgsl_pwrstate_template,
 	TP_PROTO(struct kgsl_device *device, unsigned int state),
 
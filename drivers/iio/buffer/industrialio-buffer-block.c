@@ -0,0 +1,403 @@
+/*
+ * Block based IIO buffer with mmap() access
+ *
+ * Samples are stored into fixed size blocks that userspace maps once and
+ * then passes back and forth with the IIO_BUFFER_BLOCK_ENQUEUE/DEQUEUE
+ * ioctls, so a batch of samples costs one ioctl and no copy to userspace.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as published by
+ * the Free Software Foundation.
+ */
+
+#include <linux/kernel.h>
+#include <linux/list.h>
+#include <linux/mm.h>
+#include <linux/module.h>
+#include <linux/mutex.h>
+#include <linux/poll.h>
+#include <linux/sizes.h>
+#include <linux/slab.h>
+#include <linux/spinlock.h>
+#include <linux/vmalloc.h>
+#include <linux/iio/iio.h>
+#include <linux/iio/buffer.h>
+#include <linux/iio/buffer-block.h>
+
+#define IIO_BLOCK_BUFFER_MAX_BLOCKS	64
+#define IIO_BLOCK_BUFFER_MAX_SIZE	SZ_1M
+
+enum iio_block_state {
+	IIO_BLOCK_STATE_DEQUEUED,	/* owned by userspace */
+	IIO_BLOCK_STATE_QUEUED,		/* waiting to be filled */
+	IIO_BLOCK_STATE_ACTIVE,		/* being filled */
+	IIO_BLOCK_STATE_DONE,		/* waiting to be dequeued */
+};
+
+struct iio_block {
+	struct iio_buffer_block block;
+	enum iio_block_state state;
+	struct list_head head;
+};
+
+/*
+ * @lock serializes allocation, freeing and mapping of the blocks.
+ * @list_lock protects the queues and the block states, it is taken from
+ * store_to which may run in interrupt context.
+ */
+struct iio_block_buffer {
+	struct iio_buffer buffer;
+	struct mutex lock;
+	spinlock_t list_lock;
+
+	void *mem;
+	struct iio_block *blocks;
+	unsigned int num_blocks;
+	atomic_t mappings;
+
+	struct list_head incoming;
+	struct list_head outgoing;
+	struct iio_block *active;
+	size_t outgoing_bytes;
+	bool overrun;
+};
+
+#define iio_to_block_buffer(r) container_of(r, struct iio_block_buffer, buffer)
+
+static void iio_block_buffer_free_locked(struct iio_block_buffer *bb)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&bb->list_lock, flags);
+	INIT_LIST_HEAD(&bb->incoming);
+	INIT_LIST_HEAD(&bb->outgoing);
+	bb->active = NULL;
+	bb->outgoing_bytes = 0;
+	bb->overrun = false;
+	bb->num_blocks = 0;
+	spin_unlock_irqrestore(&bb->list_lock, flags);
+
+	vfree(bb->mem);
+	bb->mem = NULL;
+	kfree(bb->blocks);
+	bb->blocks = NULL;
+}
+
+static int iio_block_buffer_free_blocks(struct iio_buffer *r)
+{
+	struct iio_block_buffer *bb = iio_to_block_buffer(r);
+	int ret = 0;
+
+	mutex_lock(&bb->lock);
+	if (atomic_read(&bb->mappings))
+		ret = -EBUSY;
+	else
+		iio_block_buffer_free_locked(bb);
+	mutex_unlock(&bb->lock);
+
+	return ret;
+}
+
+static int iio_block_buffer_alloc_blocks(struct iio_buffer *r,
+					 struct iio_buffer_block_alloc_req *req)
+{
+	struct iio_block_buffer *bb = iio_to_block_buffer(r);
+	struct iio_block *blocks;
+	unsigned long flags;
+	size_t size;
+	void *mem;
+	int i;
+
+	if (!req->count || req->count > IIO_BLOCK_BUFFER_MAX_BLOCKS ||
+	    !req->size || req->size > IIO_BLOCK_BUFFER_MAX_SIZE)
+		return -EINVAL;
+
+	size = PAGE_ALIGN(req->size);
+	if (size < r->bytes_per_datum)
+		return -EINVAL;
+
+	mutex_lock(&bb->lock);
+	if (atomic_read(&bb->mappings)) {
+		mutex_unlock(&bb->lock);
+		return -EBUSY;
+	}
+	iio_block_buffer_free_locked(bb);
+
+	blocks = kcalloc(req->count, sizeof(*blocks), GFP_KERNEL);
+	mem = vmalloc_user(size * req->count);
+	if (!blocks || !mem) {
+		kfree(blocks);
+		vfree(mem);
+		mutex_unlock(&bb->lock);
+		return -ENOMEM;
+	}
+
+	for (i = 0; i < req->count; i++) {
+		blocks[i].block.id = i;
+		blocks[i].block.size = size;
+		blocks[i].block.offset = (u64)size * i;
+		blocks[i].state = IIO_BLOCK_STATE_DEQUEUED;
+		INIT_LIST_HEAD(&blocks[i].head);
+	}
+
+	spin_lock_irqsave(&bb->list_lock, flags);
+	bb->mem = mem;
+	bb->blocks = blocks;
+	bb->num_blocks = req->count;
+	spin_unlock_irqrestore(&bb->list_lock, flags);
+	mutex_unlock(&bb->lock);
+
+	req->size = size;
+	return 0;
+}
+
+static int iio_block_buffer_query_block(struct iio_buffer *r,
+					struct iio_buffer_block *block)
+{
+	struct iio_block_buffer *bb = iio_to_block_buffer(r);
+	unsigned long flags;
+	int ret = 0;
+
+	spin_lock_irqsave(&bb->list_lock, flags);
+	if (block->id >= bb->num_blocks)
+		ret = -EINVAL;
+	else
+		*block = bb->blocks[block->id].block;
+	spin_unlock_irqrestore(&bb->list_lock, flags);
+
+	return ret;
+}
+
+static int iio_block_buffer_enqueue_block(struct iio_buffer *r,
+					  struct iio_buffer_block *block)
+{
+	struct iio_block_buffer *bb = iio_to_block_buffer(r);
+	struct iio_block *blk;
+	unsigned long flags;
+	int ret = 0;
+
+	spin_lock_irqsave(&bb->list_lock, flags);
+	if (block->id >= bb->num_blocks) {
+		ret = -EINVAL;
+		goto out;
+	}
+
+	blk = &bb->blocks[block->id];
+	if (blk->state != IIO_BLOCK_STATE_DEQUEUED) {
+		ret = -EBUSY;
+		goto out;
+	}
+
+	blk->block.bytes_used = 0;
+	blk->block.flags = 0;
+	blk->state = IIO_BLOCK_STATE_QUEUED;
+	list_add_tail(&blk->head, &bb->incoming);
+out:
+	spin_unlock_irqrestore(&bb->list_lock, flags);
+	return ret;
+}
+
+static int iio_block_buffer_dequeue_block(struct iio_buffer *r,
+					  struct iio_buffer_block *block)
+{
+	struct iio_block_buffer *bb = iio_to_block_buffer(r);
+	struct iio_block *blk;
+	unsigned long flags;
+
+	spin_lock_irqsave(&bb->list_lock, flags);
+	blk = list_first_entry_or_null(&bb->outgoing, struct iio_block, head);
+	if (blk) {
+		list_del_init(&blk->head);
+		bb->outgoing_bytes -= blk->block.bytes_used;
+		blk->state = IIO_BLOCK_STATE_DEQUEUED;
+		*block = blk->block;
+	}
+	spin_unlock_irqrestore(&bb->list_lock, flags);
+
+	return blk ? 0 : -EAGAIN;
+}
+
+static int iio_block_buffer_store_to(struct iio_buffer *r, const void *data)
+{
+	struct iio_block_buffer *bb = iio_to_block_buffer(r);
+	size_t bpd = r->bytes_per_datum;
+	struct iio_block *blk;
+	unsigned long flags;
+	bool done = false;
+
+	spin_lock_irqsave(&bb->list_lock, flags);
+	blk = bb->active;
+	if (!blk) {
+		blk = list_first_entry_or_null(&bb->incoming, struct iio_block,
+					       head);
+		if (!blk || blk->block.size < bpd) {
+			bb->overrun = true;
+			spin_unlock_irqrestore(&bb->list_lock, flags);
+			return -EBUSY;
+		}
+
+		list_del_init(&blk->head);
+		blk->state = IIO_BLOCK_STATE_ACTIVE;
+		blk->block.timestamp = iio_get_time_ns();
+		if (bb->overrun)
+			blk->block.flags |= IIO_BUFFER_BLOCK_FLAG_OVERRUN;
+		bb->overrun = false;
+		bb->active = blk;
+	}
+
+	memcpy(bb->mem + blk->block.offset + blk->block.bytes_used, data, bpd);
+	blk->block.bytes_used += bpd;
+
+	if (blk->block.size - blk->block.bytes_used < bpd) {
+		blk->state = IIO_BLOCK_STATE_DONE;
+		list_add_tail(&blk->head, &bb->outgoing);
+		bb->outgoing_bytes += blk->block.bytes_used;
+		bb->active = NULL;
+		done = true;
+	}
+	spin_unlock_irqrestore(&bb->list_lock, flags);
+
+	if (done)
+		wake_up_interruptible_poll(&r->pollq, POLLIN | POLLRDNORM);
+
+	return 0;
+}
+
+static size_t iio_block_buffer_data_available(struct iio_buffer *r)
+{
+	struct iio_block_buffer *bb = iio_to_block_buffer(r);
+	unsigned long flags;
+	size_t bytes;
+
+	spin_lock_irqsave(&bb->list_lock, flags);
+	bytes = bb->outgoing_bytes;
+	spin_unlock_irqrestore(&bb->list_lock, flags);
+
+	if (!r->bytes_per_datum)
+		return 0;
+	return bytes / r->bytes_per_datum;
+}
+
+static int iio_block_buffer_set_bytes_per_datum(struct iio_buffer *r,
+						size_t bpd)
+{
+	r->bytes_per_datum = bpd;
+	return 0;
+}
+
+static int iio_block_buffer_set_length(struct iio_buffer *r,
+				       unsigned int length)
+{
+	r->length = length;
+	return 0;
+}
+
+static void iio_block_buffer_vm_open(struct vm_area_struct *vma)
+{
+	struct iio_block_buffer *bb = vma->vm_private_data;
+
+	atomic_inc(&bb->mappings);
+	iio_buffer_get(&bb->buffer);
+}
+
+static void iio_block_buffer_vm_close(struct vm_area_struct *vma)
+{
+	struct iio_block_buffer *bb = vma->vm_private_data;
+
+	atomic_dec(&bb->mappings);
+	iio_buffer_put(&bb->buffer);
+}
+
+static const struct vm_operations_struct iio_block_buffer_vm_ops = {
+	.open = iio_block_buffer_vm_open,
+	.close = iio_block_buffer_vm_close,
+};
+
+static int iio_block_buffer_mmap(struct iio_buffer *r,
+				 struct vm_area_struct *vma)
+{
+	struct iio_block_buffer *bb = iio_to_block_buffer(r);
+	int ret;
+
+	mutex_lock(&bb->lock);
+	if (!bb->mem) {
+		ret = -EINVAL;
+		goto out;
+	}
+
+	ret = remap_vmalloc_range(vma, bb->mem, vma->vm_pgoff);
+	if (ret)
+		goto out;
+
+	vma->vm_private_data = bb;
+	vma->vm_ops = &iio_block_buffer_vm_ops;
+	iio_block_buffer_vm_open(vma);
+out:
+	mutex_unlock(&bb->lock);
+	return ret;
+}
+
+static void iio_block_buffer_release(struct iio_buffer *r)
+{
+	struct iio_block_buffer *bb = iio_to_block_buffer(r);
+
+	iio_block_buffer_free_locked(bb);
+	mutex_destroy(&bb->lock);
+	kfree(bb);
+}
+
+static const struct iio_buffer_access_funcs iio_block_buffer_access_funcs = {
+	.store_to = iio_block_buffer_store_to,
+	.data_available = iio_block_buffer_data_available,
+	.set_bytes_per_datum = iio_block_buffer_set_bytes_per_datum,
+	.set_length = iio_block_buffer_set_length,
+	.release = iio_block_buffer_release,
+
+	.alloc_blocks = iio_block_buffer_alloc_blocks,
+	.free_blocks = iio_block_buffer_free_blocks,
+	.query_block = iio_block_buffer_query_block,
+	.enqueue_block = iio_block_buffer_enqueue_block,
+	.dequeue_block = iio_block_buffer_dequeue_block,
+	.mmap = iio_block_buffer_mmap,
+
+	.modes = INDIO_BUFFER_SOFTWARE | INDIO_BUFFER_TRIGGERED,
+	.flags = IIO_BUFFER_FLAG_OWN_WAKEUP,
+};
+
+/**
+ * iio_block_buffer_allocate() - allocate a block based buffer
+ *
+ * The buffer has no blocks until userspace allocates them with the
+ * IIO_BUFFER_BLOCK_ALLOC ioctl. It can be used wherever a kfifo buffer
+ * would be, but read() is not supported on it.
+ *
+ * Return: the buffer, or NULL on failure
+ */
+struct iio_buffer *iio_block_buffer_allocate(void)
+{
+	struct iio_block_buffer *bb;
+
+	bb = kzalloc(sizeof(*bb), GFP_KERNEL);
+	if (!bb)
+		return NULL;
+
+	iio_buffer_init(&bb->buffer);
+	bb->buffer.access = &iio_block_buffer_access_funcs;
+	mutex_init(&bb->lock);
+	spin_lock_init(&bb->list_lock);
+	atomic_set(&bb->mappings, 0);
+	INIT_LIST_HEAD(&bb->incoming);
+	INIT_LIST_HEAD(&bb->outgoing);
+
+	return &bb->buffer;
+}
+EXPORT_SYMBOL_GPL(iio_block_buffer_allocate);
+
+void iio_block_buffer_free(struct iio_buffer *r)
+{
+	iio_buffer_put(r);
+}
+EXPORT_SYMBOL_GPL(iio_block_buffer_free);
+
+MODULE_DESCRIPTION("Block based IIO buffer with mmap access");
+MODULE_LICENSE("GPL v2");
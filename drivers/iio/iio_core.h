@@ -42,17 +42,22 @@ ssize_t iio_format_value(char *buf, unsigned int type, int size, int *vals);
 
 #ifdef CONFIG_IIO_BUFFER
 struct poll_table_struct;
+struct vm_area_struct;
 
 unsigned int iio_buffer_poll(struct file *filp,
 			     struct poll_table_struct *wait);
 ssize_t iio_buffer_read_first_n_outer(struct file *filp, char __user *buf,
 				      size_t n, loff_t *f_ps);
+int iio_buffer_mmap(struct file *filp, struct vm_area_struct *vma);
+long iio_buffer_ioctl(struct iio_dev *indio_dev, struct file *filp,
+		      unsigned int cmd, unsigned long arg);
 
 int iio_buffer_alloc_sysfs_and_mask(struct iio_dev *indio_dev);
 void iio_buffer_free_sysfs_and_mask(struct iio_dev *indio_dev);
 
 #define iio_buffer_poll_addr (&iio_buffer_poll)
 #define iio_buffer_read_first_n_outer_addr (&iio_buffer_read_first_n_outer)
+#define iio_buffer_mmap_addr (&iio_buffer_mmap)
 
 void iio_disable_all_buffers(struct iio_dev *indio_dev);
 void iio_buffer_wakeup_poll(struct iio_dev *indio_dev);
@@ -61,6 +66,14 @@ void iio_buffer_wakeup_poll(struct iio_dev *indio_dev);
 
 #define iio_buffer_poll_addr NULL
 #define iio_buffer_read_first_n_outer_addr NULL
+#define iio_buffer_mmap_addr NULL
+
+static inline long iio_buffer_ioctl(struct iio_dev *indio_dev,
+				    struct file *filp, unsigned int cmd,
+				    unsigned long arg)
+{
+	return -EINVAL;
+}
 
 static inline int iio_buffer_alloc_sysfs_and_mask(struct iio_dev *indio_dev)
 {
@@ -21,6 +21,8 @@
 #include <linux/slab.h>
 #include <linux/poll.h>
 #include <linux/sched.h>
+#include <linux/mm.h>
+#include <linux/uaccess.h>
 
 #include <linux/iio/iio.h>
 #include "iio_core.h"
@@ -198,6 +200,120 @@ void iio_buffer_wakeup_poll(struct iio_dev *indio_dev)
 	wake_up(&indio_dev->buffer->pollq);
 }
 
+static int iio_buffer_dequeue_block(struct iio_dev *indio_dev,
+				    struct file *filp,
+				    struct iio_buffer_block *block)
+{
+	struct iio_buffer *rb = indio_dev->buffer;
+	int ret;
+
+	for (;;) {
+		ret = rb->access->dequeue_block(rb, block);
+		if (ret != -EAGAIN || (filp->f_flags & O_NONBLOCK))
+			return ret;
+
+		ret = wait_event_interruptible(rb->pollq,
+				!indio_dev->info ||
+				iio_buffer_data_available(rb));
+		if (ret)
+			return ret;
+		if (!indio_dev->info)
+			return -ENODEV;
+	}
+}
+
+/**
+ * iio_buffer_ioctl() - block buffer ioctls on the chrdev
+ * @indio_dev:	The IIO device
+ * @filp:	File structure pointer for the char device
+ * @cmd:	One of the IIO_BUFFER_BLOCK_* ioctls
+ * @arg:	Userspace pointer to the argument of @cmd
+ *
+ * Return: 0 on success, -EINVAL if the buffer has no blocks or @cmd is not
+ *	   a buffer ioctl, or another negative error code
+ */
+long iio_buffer_ioctl(struct iio_dev *indio_dev, struct file *filp,
+		      unsigned int cmd, unsigned long arg)
+{
+	struct iio_buffer *rb = indio_dev->buffer;
+	void __user *p = (void __user *)arg;
+	struct iio_buffer_block_alloc_req req;
+	struct iio_buffer_block block;
+	int ret;
+
+	if (!rb || !rb->access->alloc_blocks)
+		return -EINVAL;
+
+	switch (cmd) {
+	case IIO_BUFFER_BLOCK_ALLOC_IOCTL:
+		if (copy_from_user(&req, p, sizeof(req)))
+			return -EFAULT;
+		if (req.reserved[0] || req.reserved[1])
+			return -EINVAL;
+
+		mutex_lock(&indio_dev->mlock);
+		if (iio_buffer_is_active(rb))
+			ret = -EBUSY;
+		else
+			ret = rb->access->alloc_blocks(rb, &req);
+		mutex_unlock(&indio_dev->mlock);
+		if (ret)
+			return ret;
+
+		return copy_to_user(p, &req, sizeof(req)) ? -EFAULT : 0;
+	case IIO_BUFFER_BLOCK_FREE_IOCTL:
+		mutex_lock(&indio_dev->mlock);
+		if (iio_buffer_is_active(rb))
+			ret = -EBUSY;
+		else
+			ret = rb->access->free_blocks(rb);
+		mutex_unlock(&indio_dev->mlock);
+		return ret;
+	case IIO_BUFFER_BLOCK_QUERY_IOCTL:
+		if (copy_from_user(&block, p, sizeof(block)))
+			return -EFAULT;
+		ret = rb->access->query_block(rb, &block);
+		if (ret)
+			return ret;
+		return copy_to_user(p, &block, sizeof(block)) ? -EFAULT : 0;
+	case IIO_BUFFER_BLOCK_ENQUEUE_IOCTL:
+		if (copy_from_user(&block, p, sizeof(block)))
+			return -EFAULT;
+		return rb->access->enqueue_block(rb, &block);
+	case IIO_BUFFER_BLOCK_DEQUEUE_IOCTL:
+		ret = iio_buffer_dequeue_block(indio_dev, filp, &block);
+		if (ret)
+			return ret;
+		return copy_to_user(p, &block, sizeof(block)) ? -EFAULT : 0;
+	}
+
+	return -EINVAL;
+}
+
+/**
+ * iio_buffer_mmap() - chrdev mmap for block buffer access
+ * @filp:	File structure pointer for the char device
+ * @vma:	Area to map the blocks into, vm_pgoff selects the first block
+ *
+ * Return: 0 on success or a negative error code
+ */
+int iio_buffer_mmap(struct file *filp, struct vm_area_struct *vma)
+{
+	struct iio_dev *indio_dev = filp->private_data;
+	struct iio_buffer *rb = indio_dev->buffer;
+
+	if (!indio_dev->info)
+		return -ENODEV;
+
+	if (!rb || !rb->access->mmap)
+		return -ENODEV;
+
+	if (!(vma->vm_flags & VM_SHARED))
+		return -EINVAL;
+
+	return rb->access->mmap(rb, vma);
+}
+
 void iio_buffer_init(struct iio_buffer *buffer)
 {
 	INIT_LIST_HEAD(&buffer->demux_list);
@@ -1196,6 +1312,9 @@ static int iio_push_to_buffer(struct iio_buffer *buffer, const void *data)
 	if (ret)
 		return ret;
 
+	if (buffer->access->flags & IIO_BUFFER_FLAG_OWN_WAKEUP)
+		return 0;
+
 	/*
 	 * We can't just test for watermark to decide if we wake the poll queue
 	 * because read may request less samples than the watermark.
@@ -29,6 +29,7 @@
 #include <linux/io.h>
 #include <linux/slab.h>
 #include <linux/hall_sensor.h>
+#include <linux/wake_intent.h>
 
 #define DRIVER_NAME "HL"
 
@@ -279,6 +280,8 @@ static void report_cover_event(int pole, int irq, struct ak_hall_data *hl)
 		wake_lock_timeout(&hl->wake_lock, (2 * HZ));
 
 		if (prev_val_n != val_n) {
+			if (val_n)
+				wake_intent_notify(WAKE_INTENT_COVER_OPEN);
 			input_report_key(hl->input_dev, HALL_N_POLE, !val_n);
 			input_sync(hl->input_dev);
 			prev_val_n = val_n;
@@ -293,6 +296,8 @@ static void report_cover_event(int pole, int irq, struct ak_hall_data *hl)
 		wake_lock_timeout(&hl->wake_lock, (2 * HZ));
 
 		if (prev_val_s != val_s) {
+			if (val_s)
+				wake_intent_notify(WAKE_INTENT_COVER_OPEN);
 			input_report_key(hl->input_dev, HALL_S_POLE, !val_s);
 			input_sync(hl->input_dev);
 			prev_val_s = val_s;
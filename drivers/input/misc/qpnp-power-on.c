@@ -32,6 +32,7 @@
 #include <linux/regulator/of_regulator.h>
 #include <linux/input/qpnp-power-on.h>
 #include <linux/power_supply.h>
+#include <linux/wake_intent.h>
 #include <../../power/reset/htc_restart_handler.h>
 
 #include <linux/htc_flags.h>
@@ -856,6 +857,10 @@ qpnp_pon_input_dispatch(struct qpnp_pon *pon, u32 pon_type)
 			pon->kpdpwr_last_release_time = ktime_get();
 	}
 
+	/* a press is the earliest hint that the screen is about to go on */
+	if (cfg->pon_type == PON_KPDPWR && key_status && !cfg->old_state)
+		wake_intent_notify(WAKE_INTENT_POWER_KEY);
+
 #ifdef CONFIG_QPNP_KEY_INPUT
 	/*
 	 * simulate press event in case release event occurred
@@ -27,6 +27,7 @@
 #include <linux/wakelock.h>
 #include <linux/of_gpio.h>
 #include <linux/of_irq.h>
+#include <linux/cpu_boost.h>
 #ifdef HTC_FEATURE
 #include <linux/pinctrl/consumer.h>
 #endif
@@ -1100,6 +1101,7 @@ static void nvt_ts_work_func(struct work_struct *work)
 #endif
 
 	input_sync(ts->input_dev);
+	ts->touch_down = finger_cnt > 0;
 #ifdef HTC_FEATURE
 	if (debug_mask & (TOUCH_KPI_LOG | TOUCH_BREAKDOWN_TIME)) {
 		getnstimeofday(&ts->tp_sync_time);
@@ -1252,6 +1254,13 @@ static irqreturn_t nvt_ts_irq_handler(int32_t irq, void *dev_id)
 	}
 #endif
 
+	/*
+	 * Kick the input boost on the first touch rather than waiting for
+	 * the report to be read and for the input core to see the event.
+	 */
+	if (!ts->touch_down)
+		cpuboost_kick();
+
 #ifdef HTC_FEATURE
 	nvt_ts_input_report();
 #else
@@ -1760,6 +1769,7 @@ static void release_all_fingers(void)
 	input_sync(ts->input_dev);
 
 	memset(ts->report_points, 0, sizeof(struct nvt_finger_info) * TOUCH_MAX_FINGER_NUM);
+	ts->touch_down = false;
 
 	NVT_LOG("Release touch\n");
 }
@@ -199,6 +199,7 @@ struct nvt_ts_data {
 #endif
 	struct mutex lock;
 	const struct nvt_ts_mem_map *mmap;
+	bool touch_down;
 };
 
 #if NVT_TOUCH_PROC
@@ -1101,11 +1101,18 @@ static void arm_smmu_tlb_sync_cb(struct arm_smmu_device *smmu,
 static void arm_smmu_tlb_sync(void *cookie)
 {
 	struct arm_smmu_domain *smmu_domain = cookie;
+	struct arm_smmu_cfg *cfg = &smmu_domain->cfg;
 
 	if (smmu_domain->smmu == NULL)
 		return;
 
-	arm_smmu_tlb_sync_cb(smmu_domain->smmu, smmu_domain->cfg.cbndx);
+	/* SMMUv1 stage 2 invalidations go through the global TLBIVMID */
+	if (cfg->cbar == CBAR_TYPE_S2_TRANS &&
+	    (!IS_ENABLED(CONFIG_64BIT) ||
+	     smmu_domain->smmu->version != ARM_SMMU_V2))
+		__arm_smmu_tlb_sync(smmu_domain->smmu);
+	else
+		arm_smmu_tlb_sync_cb(smmu_domain->smmu, cfg->cbndx);
 }
 
 /* Must be called with clocks/regulators enabled */
@@ -1422,6 +1429,16 @@ static irqreturn_t arm_smmu_context_fault(int irq, void *dev)
 			"soft iova-to-phys=%pa\n", &phys_soft);
 		ret = IRQ_HANDLED;
 		resume = RESUME_TERMINATE;
+	} else if (tmp == -EAGAIN && (fsr & FSR_SS)) {
+		/*
+		 * The client fixed up the fault (e.g. populated the page on
+		 * demand), let the stalled transaction go through again.
+		 */
+		dev_dbg(smmu->dev,
+			"Context fault fixed up by client: iova=0x%08lx, fsr=0x%x, cb=%d\n",
+			iova, fsr, cfg->cbndx);
+		ret = IRQ_HANDLED;
+		resume = RESUME_RETRY;
 	} else {
 		phys_addr_t phys_atos = arm_smmu_verify_fault(domain, iova,
 							      fsr);
@@ -14,6 +14,8 @@
 #include <linux/dma-mapping.h>
 #include <linux/dma-mapping-fast.h>
 #include <linux/io-pgtable-fast.h>
+#include <linux/log2.h>
+#include <linux/percpu.h>
 #include <linux/vmalloc.h>
 #include <asm/cacheflush.h>
 #include <asm/dma-iommu.h>
@@ -148,6 +150,41 @@ static bool __bit_covered_stale(unsigned long upcoming_stale,
 	return true;
 }
 
+/*
+ * Invalidates the whole TLB of the mapping. Every range unmapped so far can
+ * be reused afterwards, so the dirty ranges of the depot become clean.
+ * Called with the mapping lock held.
+ */
+static void __fast_smmu_flush_stale(struct dma_fast_smmu_mapping *mapping,
+				    bool skip_sync)
+{
+	int class;
+
+	iommu_tlbiall(mapping->domain);
+	mapping->have_stale_tlbs = false;
+	av8l_fast_clear_stale_ptes(mapping->pgtbl_pmds,
+			mapping->domain->geometry.aperture_start,
+			mapping->base,
+			mapping->base + mapping->size - 1,
+			skip_sync);
+
+	if (!mapping->depot)
+		return;
+
+	for (class = 0; class < FAST_IOVA_RCACHE_CLASSES; class++) {
+		struct dma_fast_smmu_depot *depot = &mapping->depot[class];
+
+		while (depot->nr_dirty) {
+			unsigned long bit = depot->dirty[--depot->nr_dirty];
+
+			if (depot->nr_clean < FAST_IOVA_DEPOT_SIZE)
+				depot->clean[depot->nr_clean++] = bit;
+			else
+				bitmap_clear(mapping->bitmap, bit, 1UL << class);
+		}
+	}
+}
+
 static dma_addr_t __fast_smmu_alloc_iova(struct dma_fast_smmu_mapping *mapping,
 					 struct dma_attrs *attrs,
 					 size_t size)
@@ -183,17 +220,9 @@ static dma_addr_t __fast_smmu_alloc_iova(struct dma_fast_smmu_mapping *mapping,
 	if (mapping->have_stale_tlbs &&
 	    __bit_covered_stale(mapping->upcoming_stale_bit,
 				prev_search_start,
-				bit + nbits - 1)) {
-		bool skip_sync = dma_get_attr(DMA_ATTR_SKIP_CPU_SYNC, attrs);
-
-		iommu_tlbiall(mapping->domain);
-		mapping->have_stale_tlbs = false;
-		av8l_fast_clear_stale_ptes(mapping->pgtbl_pmds,
-				mapping->domain->geometry.aperture_start,
-				mapping->base,
-				mapping->base + mapping->size - 1,
-				skip_sync);
-	}
+				bit + nbits - 1))
+		__fast_smmu_flush_stale(mapping,
+				dma_get_attr(DMA_ATTR_SKIP_CPU_SYNC, attrs));
 
 	return (bit << FAST_PAGE_SHIFT) + mapping->base;
 }
@@ -304,6 +333,98 @@ static void __fast_smmu_free_iova(struct dma_fast_smmu_mapping *mapping,
 	mapping->have_stale_tlbs = true;
 }
 
+/*
+ * Per-packet map/unmap of small buffers goes through per-cpu magazines of
+ * ranges of 1, 2, 4 or 8 pages so that the bitmap search and the mapping
+ * lock are only taken to move a whole magazine to or from the depot.
+ *
+ * Unmapped ranges collect in the dirty half of a magazine. A full dirty
+ * magazine is spilled to the depot. A cpu whose clean magazine runs dry
+ * refills it from the clean depot ranges. If there are none but enough
+ * dirty ones have piled up, one TLBIALL makes them all reusable. That
+ * is the deferred, batched invalidation, rather than one per unmap or
+ * one per bitmap wrap.
+ *
+ * With PROVE_TLB the stale ptes of the whole aperture are rewritten under
+ * the lock, so the lockless pte updates of the cached path are not
+ * allowed there.
+ */
+static bool fast_iova_rcache_enabled(struct dma_fast_smmu_mapping *mapping)
+{
+	return !IS_ENABLED(CONFIG_IOMMU_IO_PGTABLE_FAST_PROVE_TLB) &&
+		mapping->rcache;
+}
+
+/* rcache size class of a range of nbits pages, -1 if it is too big */
+static int fast_iova_class(struct dma_fast_smmu_mapping *mapping,
+			   unsigned long nbits)
+{
+	if (!fast_iova_rcache_enabled(mapping) ||
+	    nbits > 1UL << (FAST_IOVA_RCACHE_CLASSES - 1))
+		return -1;
+	return order_base_2(nbits);
+}
+
+static dma_addr_t __fast_smmu_rcache_alloc(
+	struct dma_fast_smmu_mapping *mapping, struct dma_attrs *attrs,
+	int class)
+{
+	struct dma_fast_smmu_depot *depot = &mapping->depot[class];
+	struct dma_fast_smmu_magazine *mag;
+	dma_addr_t iova = DMA_ERROR_CODE;
+	unsigned long flags;
+	unsigned int n;
+
+	local_irq_save(flags);
+	mag = &this_cpu_ptr(mapping->rcache)->mags[class];
+	if (!mag->nr_clean) {
+		spin_lock(&mapping->lock);
+		if (!depot->nr_clean && depot->nr_dirty >= FAST_IOVA_MAG_SIZE)
+			__fast_smmu_flush_stale(mapping,
+				dma_get_attr(DMA_ATTR_SKIP_CPU_SYNC, attrs));
+		n = min_t(unsigned int, depot->nr_clean, FAST_IOVA_MAG_SIZE);
+		depot->nr_clean -= n;
+		memcpy(mag->clean, depot->clean + depot->nr_clean,
+		       n * sizeof(*mag->clean));
+		mag->nr_clean = n;
+		spin_unlock(&mapping->lock);
+	}
+	if (mag->nr_clean)
+		iova = (mag->clean[--mag->nr_clean] << FAST_PAGE_SHIFT) +
+			mapping->base;
+	local_irq_restore(flags);
+
+	return iova;
+}
+
+static void __fast_smmu_rcache_free(struct dma_fast_smmu_mapping *mapping,
+				    dma_addr_t iova, int class)
+{
+	struct dma_fast_smmu_depot *depot = &mapping->depot[class];
+	struct dma_fast_smmu_magazine *mag;
+	unsigned long flags;
+	unsigned int i;
+
+	local_irq_save(flags);
+	mag = &this_cpu_ptr(mapping->rcache)->mags[class];
+	if (mag->nr_dirty == FAST_IOVA_MAG_SIZE) {
+		spin_lock(&mapping->lock);
+		for (i = 0; i < mag->nr_dirty; i++) {
+			if (depot->nr_dirty < FAST_IOVA_DEPOT_SIZE) {
+				depot->dirty[depot->nr_dirty++] = mag->dirty[i];
+				continue;
+			}
+			__fast_smmu_free_iova(mapping,
+				(mag->dirty[i] << FAST_PAGE_SHIFT) +
+				mapping->base, FAST_PAGE_SIZE << class);
+		}
+		mag->nr_dirty = 0;
+		spin_unlock(&mapping->lock);
+	}
+	mag->dirty[mag->nr_dirty++] = (iova - mapping->base) >> FAST_PAGE_SHIFT;
+	local_irq_restore(flags);
+}
+
 
 static void __fast_dma_page_cpu_to_dev(struct page *page, unsigned long off,
 				       size_t size, enum dma_data_direction dir)
@@ -355,6 +476,7 @@ static dma_addr_t fast_smmu_map_page(struct device *dev, struct page *page,
 	bool skip_sync = dma_get_attr(DMA_ATTR_SKIP_CPU_SYNC, attrs);
 	int prot = __fast_dma_direction_to_prot(dir);
 	bool is_coherent = is_dma_coherent(dev, attrs);
+	int class = fast_iova_class(mapping, nptes);
 
 	prot = __get_iommu_pgprot(attrs, prot, is_coherent);
 
@@ -362,6 +484,29 @@ static dma_addr_t fast_smmu_map_page(struct device *dev, struct page *page,
 		__fast_dma_page_cpu_to_dev(phys_to_page(phys_to_map),
 					   offset_from_phys_to_map, size, dir);
 
+	if (class >= 0) {
+		/* the range is ours alone, its ptes need no lock */
+		iova = __fast_smmu_rcache_alloc(mapping, attrs, class);
+		if (iova == DMA_ERROR_CODE) {
+			spin_lock_irqsave(&mapping->lock, flags);
+			iova = __fast_smmu_alloc_iova(mapping, attrs,
+					FAST_PAGE_SIZE << class);
+			spin_unlock_irqrestore(&mapping->lock, flags);
+			if (unlikely(iova == DMA_ERROR_CODE))
+				return DMA_ERROR_CODE;
+		}
+
+		pmd = iopte_pmd_offset(mapping->pgtbl_pmds,
+			mapping->domain->geometry.aperture_start, iova);
+		if (unlikely(av8l_fast_map_public(pmd, phys_to_map, len,
+						  prot))) {
+			__fast_smmu_rcache_free(mapping, iova, class);
+			return DMA_ERROR_CODE;
+		}
+		fast_dmac_clean_range(mapping, pmd, pmd + nptes);
+		return iova + offset_from_phys_to_map;
+	}
+
 	spin_lock_irqsave(&mapping->lock, flags);
 
 	iova = __fast_smmu_alloc_iova(mapping, attrs, len);
@@ -381,7 +526,7 @@ static dma_addr_t fast_smmu_map_page(struct device *dev, struct page *page,
 	return iova + offset_from_phys_to_map;
 
 fail_free_iova:
-	__fast_smmu_free_iova(mapping, iova, size);
+	__fast_smmu_free_iova(mapping, iova, len);
 fail:
 	spin_unlock_irqrestore(&mapping->lock, flags);
 	return DMA_ERROR_CODE;
@@ -402,10 +547,18 @@ static void fast_smmu_unmap_page(struct device *dev, dma_addr_t iova,
 	struct page *page = phys_to_page((*pmd & FAST_PTE_ADDR_MASK));
 	bool skip_sync = dma_get_attr(DMA_ATTR_SKIP_CPU_SYNC, attrs);
 	bool is_coherent = is_dma_coherent(dev, attrs);
+	int class = fast_iova_class(mapping, nptes);
 
 	if (!skip_sync && !is_coherent)
 		__fast_dma_page_dev_to_cpu(page, offset, size, dir);
 
+	if (class >= 0) {
+		av8l_fast_unmap_public(pmd, len);
+		fast_dmac_clean_range(mapping, pmd, pmd + nptes);
+		__fast_smmu_rcache_free(mapping, iova, class);
+		return;
+	}
+
 	spin_lock_irqsave(&mapping->lock, flags);
 	av8l_fast_unmap_public(pmd, len);
 	fast_dmac_clean_range(mapping, pmd, pmd + nptes);
@@ -757,6 +910,17 @@ static struct dma_fast_smmu_mapping *__fast_smmu_create_mapping_sized(
 	if (!fast->bitmap)
 		goto err2;
 
+	/* the IOVA caches are an optimisation, carry on without them */
+	fast->depot = kcalloc(FAST_IOVA_RCACHE_CLASSES, sizeof(*fast->depot),
+			      GFP_KERNEL | __GFP_NOWARN);
+	fast->rcache = alloc_percpu(struct dma_fast_smmu_rcache);
+	if (!fast->depot || !fast->rcache) {
+		kfree(fast->depot);
+		free_percpu(fast->rcache);
+		fast->depot = NULL;
+		fast->rcache = NULL;
+	}
+
 	spin_lock_init(&fast->lock);
 
 	return fast;
@@ -844,6 +1008,8 @@ void fast_smmu_detach_device(struct device *dev,
 	dev->archdata.mapping = NULL;
 	set_dma_ops(dev, NULL);
 
+	free_percpu(mapping->fast->rcache);
+	kfree(mapping->fast->depot);
 	kvfree(mapping->fast->bitmap);
 	kfree(mapping->fast);
 }
@@ -845,12 +845,41 @@ static int __arm_lpae_unmap(struct arm_lpae_io_pgtable *data,
 	return __arm_lpae_unmap(data, iova, size, lvl + 1, ptep, prev_ptep);
 }
 
+/*
+ * Unmaps of up to this many granules are invalidated by VA, with a single
+ * sync at the end, so the rest of the context keeps its TLB entries. Larger
+ * ones invalidate the whole ASID/VMID, which is one register write no matter
+ * how many pages went away.
+ */
+#define ARM_LPAE_TLBI_VA_MAX		16
+
+static void arm_lpae_tlb_inv_unmapped(struct arm_lpae_io_pgtable *data,
+				      unsigned long iova, size_t size)
+{
+	struct io_pgtable *iop = &data->iop;
+	size_t granule = 1UL << data->pg_shift;
+	unsigned long end = iova + size;
+
+	/*
+	 * Non-leaf invalidations, as __arm_lpae_unmap() may have freed whole
+	 * tables and the walk caches must forget them too.
+	 */
+	if (size > granule * ARM_LPAE_TLBI_VA_MAX) {
+		iop->cfg.tlb->tlb_flush_all(iop->cookie);
+		return;
+	}
+
+	for (; iova < end; iova += granule)
+		iop->cfg.tlb->tlb_add_flush(iova, granule, false, iop->cookie);
+	iop->cfg.tlb->tlb_sync(iop->cookie);
+}
+
 static size_t arm_lpae_unmap(struct io_pgtable_ops *ops, unsigned long iova,
 			  size_t size)
 {
 	size_t unmapped = 0;
 	struct arm_lpae_io_pgtable *data = io_pgtable_ops_to_data(ops);
-	struct io_pgtable *iop = &data->iop;
+	unsigned long iova_start = iova;
 	arm_lpae_iopte *ptep;
 	int lvl = ARM_LPAE_START_LVL(data);
 
@@ -872,7 +901,7 @@ static size_t arm_lpae_unmap(struct io_pgtable_ops *ops, unsigned long iova,
 		iova += ret;
 	}
 	if (unmapped)
-		iop->cfg.tlb->tlb_flush_all(iop->cookie);
+		arm_lpae_tlb_inv_unmapped(data, iova_start, unmapped);
 
 	return unmapped;
 }
@@ -58,6 +58,7 @@ struct av8l_fast_io_pgtable {
 
 #define AV8L_FAST_PTE_NSTABLE		(((av8l_fast_iopte)1) << 63)
 #define AV8L_FAST_PTE_XN		(((av8l_fast_iopte)3) << 53)
+#define AV8L_FAST_PTE_CONT		(((av8l_fast_iopte)1) << 52)
 #define AV8L_FAST_PTE_AF		(((av8l_fast_iopte)1) << 10)
 #define AV8L_FAST_PTE_SH_NS		(((av8l_fast_iopte)0) << 8)
 #define AV8L_FAST_PTE_SH_OS		(((av8l_fast_iopte)2) << 8)
@@ -147,6 +148,10 @@ struct av8l_fast_io_pgtable {
 
 #define AV8L_FAST_PAGE_SHIFT		12
 
+/* 16 adjacent 4K ptes with the contiguous hint make one 64K TLB entry */
+#define AV8L_FAST_CONT_PTES		16
+#define AV8L_FAST_CONT_SIZE		(AV8L_FAST_CONT_PTES << AV8L_FAST_PAGE_SHIFT)
+
 
 #ifdef CONFIG_IOMMU_IO_PGTABLE_FAST_PROVE_TLB
 
@@ -197,7 +202,26 @@ static void __av8l_check_for_stale_tlb(av8l_fast_iopte *ptep)
 }
 #endif
 
-/* caller must take care of cache maintenance on *ptep */
+/*
+ * The pmds are whole page table pages, so the position of a pte within its
+ * page tells the alignment of the IOVA it maps.
+ */
+static bool av8l_fast_can_cont(av8l_fast_iopte *ptep, phys_addr_t paddr,
+			       int nptes)
+{
+	return nptes >= AV8L_FAST_CONT_PTES &&
+		IS_ALIGNED((unsigned long)ptep,
+			   AV8L_FAST_CONT_PTES * sizeof(*ptep)) &&
+		IS_ALIGNED(paddr, AV8L_FAST_CONT_SIZE);
+}
+
+/*
+ * caller must take care of cache maintenance on *ptep
+ *
+ * Every naturally aligned, physically contiguous 64K chunk of the range is
+ * mapped with the contiguous hint. Such a range must later be unmapped as
+ * a whole, which is what the DMA API callers do.
+ */
 int av8l_fast_map_public(av8l_fast_iopte *ptep, phys_addr_t paddr, size_t size,
 			 int prot)
 {
@@ -221,9 +245,19 @@ int av8l_fast_map_public(av8l_fast_iopte *ptep, phys_addr_t paddr, size_t size,
 		pte |= AV8L_FAST_PTE_AP_RW;
 
 	paddr &= AV8L_FAST_PTE_ADDR_MASK;
-	for (i = 0; i < nptes; i++, paddr += SZ_4K) {
-		__av8l_check_for_stale_tlb(ptep + i);
-		*(ptep + i) = pte | paddr;
+	for (i = 0; i < nptes; ) {
+		av8l_fast_iopte cont = 0;
+		int j, n = 1;
+
+		if (av8l_fast_can_cont(ptep + i, paddr, nptes - i)) {
+			cont = AV8L_FAST_PTE_CONT;
+			n = AV8L_FAST_CONT_PTES;
+		}
+
+		for (j = 0; j < n; j++, i++, paddr += SZ_4K) {
+			__av8l_check_for_stale_tlb(ptep + i);
+			*(ptep + i) = pte | cont | paddr;
+		}
 	}
 
 	return 0;
@@ -320,7 +354,36 @@ static int av8l_fast_map_sg(struct io_pgtable_ops *ops, unsigned long iova,
 			    struct scatterlist *sg, unsigned int nents,
 			    int prot, size_t *size)
 {
-	return -ENODEV;
+	struct av8l_fast_io_pgtable *data = iof_pgtable_ops_to_data(ops);
+	av8l_fast_iopte *start = iopte_pmd_offset(data->pmds, data->base, iova);
+	av8l_fast_iopte *ptep = start;
+	struct scatterlist *s;
+	size_t mapped = 0;
+	int i;
+
+	if (!(prot & (IOMMU_READ | IOMMU_WRITE)))
+		goto out_err;
+
+	/* one call per segment so each gets the contiguous hint it can */
+	for_each_sg(sg, s, nents, i) {
+		phys_addr_t phys = page_to_phys(sg_page(s)) + s->offset;
+		size_t len = ALIGN(s->length, SZ_4K);
+
+		if (!IS_ALIGNED(s->offset, SZ_4K))
+			goto out_err;
+
+		av8l_fast_map_public(ptep, phys, len, prot);
+		ptep += len >> AV8L_FAST_PAGE_SHIFT;
+		mapped += len;
+	}
+	dmac_clean_range(start, ptep);
+
+	return mapped;
+
+out_err:
+	/* Return the size of the partial mapping so that they can be undone */
+	*size = mapped;
+	return 0;
 }
 
 static struct av8l_fast_io_pgtable *
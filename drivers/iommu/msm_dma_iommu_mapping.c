@@ -14,8 +14,11 @@
 #include <linux/kernel.h>
 #include <linux/kref.h>
 #include <linux/slab.h>
-#include <linux/rbtree.h>
+#include <linux/hash.h>
+#include <linux/moduleparam.h>
 #include <linux/mutex.h>
+#include <linux/rculist.h>
+#include <linux/spinlock.h>
 #include <linux/err.h>
 #include <asm/barrier.h>
 
@@ -30,6 +33,9 @@
  * @dir - The direction for the unmap.
  * @meta - Backpointer to the meta this guy belongs to.
  * @ref - for reference counting this mapping
+ * @lru - node in the device's list of idle lazy mappings
+ * @dev_lru - the device's lru, NULL for mappings that are not lazy
+ * @lazy - the mapping holds the extra reference of a delayed unmap
  *
  * Represents a mapping of one dma_buf buffer to a particular device
  * and address range. There may exist other mappings of this buffer in
@@ -37,72 +43,135 @@
  */
 struct msm_iommu_map {
 	struct list_head lnode;
-	struct rb_node node;
+	struct list_head lru;
+	struct msm_iommu_dev_lru *dev_lru;
 	struct device *dev;
 	struct scatterlist sgl;
 	unsigned int nents;
 	enum dma_data_direction dir;
 	struct msm_iommu_meta *meta;
 	struct kref ref;
+	bool lazy;
 };
 
 struct msm_iommu_meta {
-	struct rb_node node;
+	struct hlist_node node;
 	struct list_head iommu_maps;
 	struct kref ref;
 	struct mutex lock;
 	void *buffer;
+	struct rcu_head rcu;
 };
 
-static struct rb_root iommu_root;
-static DEFINE_MUTEX(msm_iommu_map_mutex);
+/*
+ * Display and camera map the same buffers every frame from several threads,
+ * so the metas are hashed by buffer. Lookups walk a bucket under RCU and
+ * only take a reference. Adding a meta and dropping the last reference of
+ * one are serialised by the lock of its bucket.
+ */
+#define MSM_IOMMU_META_HASH_BITS	6
+
+static struct msm_iommu_meta_bucket {
+	struct hlist_head head;
+	struct mutex lock;
+} iommu_meta_hash[1 << MSM_IOMMU_META_HASH_BITS];
+
+/*
+ * A lazily unmapped buffer keeps its IOVA until the buffer is freed. To
+ * bound the IOVA space pinned by idle ones, each device keeps its idle lazy
+ * mappings on an LRU and releases the oldest once it holds more than
+ * lazy_unmap_max of them. 0 removes the bound.
+ */
+static unsigned int lazy_unmap_max = 128;
+module_param(lazy_unmap_max, uint, 0644);
+
+struct msm_iommu_dev_lru {
+	struct list_head node;
+	struct device *dev;
+	struct list_head idle;
+	unsigned int nr_idle;
+};
 
-static void msm_iommu_meta_add(struct msm_iommu_meta *meta)
+static LIST_HEAD(msm_iommu_dev_lrus);
+static DEFINE_SPINLOCK(msm_iommu_lru_lock);
+
+static struct msm_iommu_meta_bucket *msm_iommu_meta_bucket(void *buffer)
+{
+	return &iommu_meta_hash[hash_ptr(buffer, MSM_IOMMU_META_HASH_BITS)];
+}
+
+/* Returns the meta of @buffer with a reference taken, or NULL */
+static struct msm_iommu_meta *msm_iommu_meta_lookup(void *buffer)
 {
-	struct rb_root *root = &iommu_root;
-	struct rb_node **p = &root->rb_node;
-	struct rb_node *parent = NULL;
+	struct msm_iommu_meta_bucket *bucket = msm_iommu_meta_bucket(buffer);
 	struct msm_iommu_meta *entry;
 
-	while (*p) {
-		parent = *p;
-		entry = rb_entry(parent, struct msm_iommu_meta, node);
-
-		if (meta->buffer < entry->buffer) {
-			p = &(*p)->rb_left;
-		} else if (meta->buffer > entry->buffer) {
-			p = &(*p)->rb_right;
-		} else {
-			pr_err("%s: dma_buf %p already exists\n", __func__,
-				entry->buffer);
-			BUG();
+	rcu_read_lock();
+	hlist_for_each_entry_rcu(entry, &bucket->head, node) {
+		if (entry->buffer == buffer &&
+		    kref_get_unless_zero(&entry->ref)) {
+			rcu_read_unlock();
+			return entry;
 		}
 	}
+	rcu_read_unlock();
 
-	rb_link_node(&meta->node, parent, p);
-	rb_insert_color(&meta->node, root);
+	return NULL;
 }
 
-static struct msm_iommu_meta *msm_iommu_meta_lookup(void *buffer)
+static struct msm_iommu_dev_lru *msm_iommu_dev_lru(struct device *dev)
 {
-	struct rb_root *root = &iommu_root;
-	struct rb_node **p = &root->rb_node;
-	struct rb_node *parent = NULL;
-	struct msm_iommu_meta *entry = NULL;
-
-	while (*p) {
-		parent = *p;
-		entry = rb_entry(parent, struct msm_iommu_meta, node);
-
-		if (buffer < entry->buffer)
-			p = &(*p)->rb_left;
-		else if (buffer > entry->buffer)
-			p = &(*p)->rb_right;
-		else
-			return entry;
+	struct msm_iommu_dev_lru *lru, *new;
+
+	spin_lock(&msm_iommu_lru_lock);
+	list_for_each_entry(lru, &msm_iommu_dev_lrus, node)
+		if (lru->dev == dev)
+			goto out;
+	spin_unlock(&msm_iommu_lru_lock);
+
+	/* devices are few and long-lived, their lrus are never freed */
+	new = kzalloc(sizeof(*new), GFP_KERNEL);
+	if (!new)
+		return NULL;
+	new->dev = dev;
+	INIT_LIST_HEAD(&new->idle);
+
+	spin_lock(&msm_iommu_lru_lock);
+	list_for_each_entry(lru, &msm_iommu_dev_lrus, node)
+		if (lru->dev == dev) {
+			kfree(new);
+			goto out;
+		}
+	lru = new;
+	list_add(&lru->node, &msm_iommu_dev_lrus);
+out:
+	spin_unlock(&msm_iommu_lru_lock);
+	return lru;
+}
+
+static void msm_iommu_lru_add(struct msm_iommu_map *map)
+{
+	struct msm_iommu_dev_lru *lru = map->dev_lru;
+
+	spin_lock(&msm_iommu_lru_lock);
+	if (list_empty(&map->lru)) {
+		list_add_tail(&map->lru, &lru->idle);
+		lru->nr_idle++;
 	}
+	spin_unlock(&msm_iommu_lru_lock);
+}
 
-	return NULL;
+static void msm_iommu_lru_del(struct msm_iommu_map *map)
+{
+	if (!map->dev_lru)
+		return;
+
+	spin_lock(&msm_iommu_lru_lock);
+	if (!list_empty(&map->lru)) {
+		list_del_init(&map->lru);
+		map->dev_lru->nr_idle--;
+	}
+	spin_unlock(&msm_iommu_lru_lock);
 }
 
 static void msm_iommu_add(struct msm_iommu_meta *meta,
@@ -135,25 +204,80 @@ static struct msm_iommu_map *msm_iommu_lookup(struct msm_iommu_meta *meta,
 	return NULL;
 }
 
-static struct msm_iommu_meta *msm_iommu_meta_create(struct dma_buf *dma_buf)
+/*
+ * Returns the meta of the buffer with a reference taken, creating it unless
+ * another thread did so first. @created tells which happened.
+ */
+static struct msm_iommu_meta *msm_iommu_meta_create(struct dma_buf *dma_buf,
+						    bool *created)
 {
+	struct msm_iommu_meta_bucket *bucket;
 	struct msm_iommu_meta *meta;
 
-	meta = kzalloc(sizeof(*meta), GFP_KERNEL);
+	bucket = msm_iommu_meta_bucket(dma_buf->priv);
+	mutex_lock(&bucket->lock);
+	*created = false;
+	meta = msm_iommu_meta_lookup(dma_buf->priv);
+	if (meta)
+		goto out;
 
-	if (!meta)
-		return ERR_PTR(-ENOMEM);
+	meta = kzalloc(sizeof(*meta), GFP_KERNEL);
+	if (!meta) {
+		meta = ERR_PTR(-ENOMEM);
+		goto out;
+	}
 
 	INIT_LIST_HEAD(&meta->iommu_maps);
 	meta->buffer = dma_buf->priv;
 	kref_init(&meta->ref);
 	mutex_init(&meta->lock);
-	msm_iommu_meta_add(meta);
-
+	hlist_add_head_rcu(&meta->node, &bucket->head);
+	*created = true;
+out:
+	mutex_unlock(&bucket->lock);
 	return meta;
 }
 
 static void msm_iommu_meta_put(struct msm_iommu_meta *meta);
+static void msm_iommu_map_release(struct kref *kref);
+
+/*
+ * Releases the oldest idle lazy mappings of a device while it has more than
+ * lazy_unmap_max of them. The map is only looked at under the lru lock, it
+ * is found again through its meta before being released.
+ */
+static void msm_iommu_lru_trim(struct msm_iommu_dev_lru *lru)
+{
+	while (READ_ONCE(lazy_unmap_max)) {
+		struct msm_iommu_meta *meta = NULL;
+		struct msm_iommu_map *map;
+
+		spin_lock(&msm_iommu_lru_lock);
+		if (lru->nr_idle <= READ_ONCE(lazy_unmap_max)) {
+			spin_unlock(&msm_iommu_lru_lock);
+			break;
+		}
+		map = list_first_entry(&lru->idle, struct msm_iommu_map, lru);
+		list_del_init(&map->lru);
+		lru->nr_idle--;
+		if (kref_get_unless_zero(&map->meta->ref))
+			meta = map->meta;
+		spin_unlock(&msm_iommu_lru_lock);
+
+		if (!meta)
+			continue;
+
+		mutex_lock(&meta->lock);
+		map = msm_iommu_lookup(meta, lru->dev);
+		if (map && map->lazy && list_empty(&map->lru) &&
+		    atomic_read(&map->ref.refcount) == 1) {
+			map->lazy = false;
+			kref_put(&map->ref, msm_iommu_map_release);
+		}
+		mutex_unlock(&meta->lock);
+		msm_iommu_meta_put(meta);
+	}
+}
 
 static inline int __msm_dma_map_sg(struct device *dev, struct scatterlist *sg,
 				   int nents, enum dma_data_direction dir,
@@ -162,30 +286,28 @@ static inline int __msm_dma_map_sg(struct device *dev, struct scatterlist *sg,
 {
 	struct msm_iommu_map *iommu_map;
 	struct msm_iommu_meta *iommu_meta = NULL;
+	struct msm_iommu_dev_lru *dev_lru = NULL;
 	int ret = 0;
 	bool extra_meta_ref_taken = false;
+	bool created;
 	int late_unmap = !dma_get_attr(DMA_ATTR_NO_DELAYED_UNMAP, attrs);
 
-	mutex_lock(&msm_iommu_map_mutex);
 	iommu_meta = msm_iommu_meta_lookup(dma_buf->priv);
-
 	if (!iommu_meta) {
-		iommu_meta = msm_iommu_meta_create(dma_buf);
+		iommu_meta = msm_iommu_meta_create(dma_buf, &created);
 
 		if (IS_ERR(iommu_meta)) {
-			mutex_unlock(&msm_iommu_map_mutex);
 			ret = PTR_ERR(iommu_meta);
 			goto out;
 		}
-		if (late_unmap) {
+		if (created && late_unmap) {
 			kref_get(&iommu_meta->ref);
 			extra_meta_ref_taken = true;
 		}
-	} else {
-		kref_get(&iommu_meta->ref);
 	}
 
-	mutex_unlock(&msm_iommu_map_mutex);
+	if (late_unmap)
+		dev_lru = msm_iommu_dev_lru(dev);
 
 	mutex_lock(&iommu_meta->lock);
 	iommu_map = msm_iommu_lookup(iommu_meta, dev);
@@ -206,6 +328,9 @@ static inline int __msm_dma_map_sg(struct device *dev, struct scatterlist *sg,
 		kref_init(&iommu_map->ref);
 		if (late_unmap)
 			kref_get(&iommu_map->ref);
+		iommu_map->lazy = late_unmap;
+		INIT_LIST_HEAD(&iommu_map->lru);
+		iommu_map->dev_lru = dev_lru;
 		iommu_map->meta = iommu_meta;
 		iommu_map->sgl.dma_address = sg->dma_address;
 		iommu_map->sgl.dma_length = sg->dma_length;
@@ -218,6 +343,7 @@ static inline int __msm_dma_map_sg(struct device *dev, struct scatterlist *sg,
 		sg->dma_length = iommu_map->sgl.dma_length;
 
 		kref_get(&iommu_map->ref);
+		msm_iommu_lru_del(iommu_map);
 		if (is_device_dma_coherent(dev))
 			/*
 			 * Ensure all outstanding changes for coherent
@@ -279,22 +405,30 @@ static void msm_iommu_meta_destroy(struct kref *kref)
 	struct msm_iommu_meta *meta = container_of(kref, struct msm_iommu_meta,
 						ref);
 
+	struct msm_iommu_meta_bucket *bucket = msm_iommu_meta_bucket(
+						meta->buffer);
+	struct msm_iommu_map *iommu_map;
+
 	if (!list_empty(&meta->iommu_maps)) {
 		WARN(1, "%s: DMA Buffer %p being destroyed with outstanding iommu mappins!\n", __func__,
 			meta->buffer);
+		/* the lru must not reach the freed meta through them */
+		list_for_each_entry(iommu_map, &meta->iommu_maps, lnode)
+			msm_iommu_lru_del(iommu_map);
 	}
-	rb_erase(&meta->node, &iommu_root);
-	kfree(meta);
+	hlist_del_rcu(&meta->node);
+	mutex_unlock(&bucket->lock);
+	kfree_rcu(meta, rcu);
 }
 
 static void msm_iommu_meta_put(struct msm_iommu_meta *meta)
 {
 	/*
-	 * Need to lock here to prevent race against map/unmap
+	 * The bucket lock is only taken for the last reference, so that
+	 * a concurrent map can't find the meta half destroyed
 	 */
-	mutex_lock(&msm_iommu_map_mutex);
-	kref_put(&meta->ref, msm_iommu_meta_destroy);
-	mutex_unlock(&msm_iommu_map_mutex);
+	kref_put_mutex(&meta->ref, msm_iommu_meta_destroy,
+		       &msm_iommu_meta_bucket(meta->buffer)->lock);
 }
 
 static void msm_iommu_map_release(struct kref *kref)
@@ -303,6 +437,7 @@ static void msm_iommu_map_release(struct kref *kref)
 						ref);
 
 	list_del(&map->lnode);
+	msm_iommu_lru_del(map);
 	dma_unmap_sg(map->dev, &map->sgl, map->nents, map->dir);
 	kfree(map);
 }
@@ -312,16 +447,14 @@ void msm_dma_unmap_sg(struct device *dev, struct scatterlist *sgl, int nents,
 {
 	struct msm_iommu_map *iommu_map;
 	struct msm_iommu_meta *meta;
+	struct msm_iommu_dev_lru *dev_lru = NULL;
 
-	mutex_lock(&msm_iommu_map_mutex);
 	meta = msm_iommu_meta_lookup(dma_buf->priv);
 	if (!meta) {
 		WARN(1, "%s: (%p) was never mapped\n", __func__, dma_buf);
-		mutex_unlock(&msm_iommu_map_mutex);
 		goto out;
 
 	}
-	mutex_unlock(&msm_iommu_map_mutex);
 
 	mutex_lock(&meta->lock);
 	iommu_map = msm_iommu_lookup(meta, dev);
@@ -330,6 +463,7 @@ void msm_dma_unmap_sg(struct device *dev, struct scatterlist *sgl, int nents,
 		WARN(1, "%s: (%p) was never mapped for device  %p\n", __func__,
 				dma_buf, dev);
 		mutex_unlock(&meta->lock);
+		msm_iommu_meta_put(meta);
 		goto out;
 	}
 
@@ -341,11 +475,21 @@ void msm_dma_unmap_sg(struct device *dev, struct scatterlist *sgl, int nents,
 	 */
 	iommu_map->dir = dir;
 
-	kref_put(&iommu_map->ref, msm_iommu_map_release);
+	/* only the delayed unmap reference left, the mapping went idle */
+	if (!kref_put(&iommu_map->ref, msm_iommu_map_release) &&
+	    iommu_map->lazy && iommu_map->dev_lru &&
+	    atomic_read(&iommu_map->ref.refcount) == 1) {
+		dev_lru = iommu_map->dev_lru;
+		msm_iommu_lru_add(iommu_map);
+	}
 	mutex_unlock(&meta->lock);
 
+	/* the reference of the map call and the one of the lookup */
+	msm_iommu_meta_put(meta);
 	msm_iommu_meta_put(meta);
 
+	if (dev_lru)
+		msm_iommu_lru_trim(dev_lru);
 out:
 	return;
 }
@@ -355,29 +499,28 @@ int msm_dma_unmap_all_for_dev(struct device *dev)
 {
 	int ret = 0;
 	struct msm_iommu_meta *meta;
-	struct rb_root *root;
-	struct rb_node *meta_node;
+	int i;
 
-	mutex_lock(&msm_iommu_map_mutex);
-	root = &iommu_root;
-	meta_node = rb_first(root);
-	while (meta_node) {
-		struct msm_iommu_map *iommu_map;
-		struct msm_iommu_map *iommu_map_next;
+	for (i = 0; i < ARRAY_SIZE(iommu_meta_hash); i++) {
+		struct msm_iommu_meta_bucket *bucket = &iommu_meta_hash[i];
 
-		meta = rb_entry(meta_node, struct msm_iommu_meta, node);
-		mutex_lock(&meta->lock);
-		list_for_each_entry_safe(iommu_map, iommu_map_next,
-						&meta->iommu_maps, lnode)
-			if (iommu_map->dev == dev)
-				if (!kref_put(&iommu_map->ref,
+		mutex_lock(&bucket->lock);
+		hlist_for_each_entry(meta, &bucket->head, node) {
+			struct msm_iommu_map *iommu_map;
+			struct msm_iommu_map *iommu_map_next;
+
+			mutex_lock(&meta->lock);
+			list_for_each_entry_safe(iommu_map, iommu_map_next,
+						 &meta->iommu_maps, lnode)
+				if (iommu_map->dev == dev)
+					if (!kref_put(&iommu_map->ref,
 						msm_iommu_map_release))
-					ret = -EINVAL;
+						ret = -EINVAL;
 
-		mutex_unlock(&meta->lock);
-		meta_node = rb_next(meta_node);
+			mutex_unlock(&meta->lock);
+		}
+		mutex_unlock(&bucket->lock);
 	}
-	mutex_unlock(&msm_iommu_map_mutex);
 
 	return ret;
 }
@@ -392,21 +535,20 @@ void msm_dma_buf_freed(void *buffer)
 	struct msm_iommu_map *iommu_map_next;
 	struct msm_iommu_meta *meta;
 
-	mutex_lock(&msm_iommu_map_mutex);
 	meta = msm_iommu_meta_lookup(buffer);
 	if (!meta) {
 		/* Already unmapped (assuming no late unmapping) */
-		mutex_unlock(&msm_iommu_map_mutex);
 		goto out;
 
 	}
-	mutex_unlock(&msm_iommu_map_mutex);
 
 	mutex_lock(&meta->lock);
 
 	list_for_each_entry_safe(iommu_map, iommu_map_next, &meta->iommu_maps,
-				 lnode)
+				 lnode) {
+		iommu_map->lazy = false;
 		kref_put(&iommu_map->ref, msm_iommu_map_release);
+	}
 
 	if (!list_empty(&meta->iommu_maps)) {
 		WARN(1, "%s: DMA Buffer %p being destroyed with outstanding iommu mappins!\n", __func__,
@@ -416,9 +558,23 @@ void msm_dma_buf_freed(void *buffer)
 	INIT_LIST_HEAD(&meta->iommu_maps);
 	mutex_unlock(&meta->lock);
 
+	/* the delayed unmap reference and the one of the lookup */
+	msm_iommu_meta_put(meta);
 	msm_iommu_meta_put(meta);
 out:
 	return;
 
 }
 
+static int __init msm_dma_iommu_mapping_init(void)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(iommu_meta_hash); i++) {
+		INIT_HLIST_HEAD(&iommu_meta_hash[i].head);
+		mutex_init(&iommu_meta_hash[i].lock);
+	}
+	return 0;
+}
+core_initcall(msm_dma_iommu_mapping_init);
+
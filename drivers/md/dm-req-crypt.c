@@ -854,6 +854,48 @@ static inline void req_crypt_blk_partition_remap(struct bio *bio)
 	}
 }
 
+/*
+ * Point the clone and its bios at the underlying device.
+ */
+static void req_crypt_remap_clone(struct request *clone)
+{
+	int copy_bio_sector_to_req = 0;
+	struct bio *bio_src = NULL;
+
+	/* Get the queue of the underlying original device */
+	clone->q = bdev_get_queue(dev->bdev);
+	clone->rq_disk = dev->bdev->bd_disk;
+
+	__rq_for_each_bio(bio_src, clone) {
+		bio_src->bi_bdev = dev->bdev;
+		/* Currently the way req-dm works is that once the underlying
+		 * device driver completes the request by calling into the
+		 * block layer. The block layer completes the bios (clones) and
+		 * then the cloned request. This is undesirable for req-dm-crypt
+		 * hence added a flag BIO_DONTFREE, this flag will ensure that
+		 * blk layer does not complete the cloned bios before completing
+		 * the request. When the crypt endio is called, post-processing
+		 * is done and then the dm layer will complete the bios (clones)
+		 * and free them.
+		 */
+		if (encryption_mode == DM_REQ_CRYPT_ENCRYPTION_MODE_TRANSPARENT)
+			bio_src->bi_flags |= 1 << BIO_INLINECRYPT;
+		else
+			bio_src->bi_flags |= 1 << BIO_DONTFREE;
+
+		/*
+		 * If this device has partitions, remap block n
+		 * of partition p to block n+start(p) of the disk.
+		 */
+		req_crypt_blk_partition_remap(bio_src);
+		if (copy_bio_sector_to_req == 0) {
+			clone->__sector = bio_src->bi_iter.bi_sector;
+			copy_bio_sector_to_req++;
+		}
+		blk_queue_bounce(clone->q, &bio_src);
+	}
+}
+
 /*
  * The endio function is called from ksoftirqd context (atomic).
  * For write operations the new pages created form the mempool
@@ -870,9 +912,8 @@ static int req_crypt_endio(struct dm_target *ti, struct request *clone,
 	struct bio_vec bvec;
 	struct req_dm_crypt_io *req_io = map_context->ptr;
 
-	/* If it is for ICE, free up req_io and return */
+	/* For ICE the map context is the shared key setting, nothing to do */
 	if (encryption_mode == DM_REQ_CRYPT_ENCRYPTION_MODE_TRANSPARENT) {
-		mempool_free(req_io, req_io_pool);
 		err = error;
 		goto submit_request;
 	}
@@ -888,6 +929,12 @@ static int req_crypt_endio(struct dm_target *ti, struct request *clone,
 		mempool_free(req_io, req_io_pool);
 		goto submit_request;
 	} else if (rq_data_dir(clone) == READ) {
+		/* Plain reads complete here, without the worker */
+		if (!req_io->should_decrypt) {
+			mempool_free(req_io, req_io_pool);
+			err = error;
+			goto submit_request;
+		}
 		req_io->error = error;
 		req_cryptd_queue_crypt(req_io);
 		err = DM_ENDIO_INCOMPLETE;
@@ -911,10 +958,20 @@ static int req_crypt_map(struct dm_target *ti, struct request *clone,
 			 union map_info *map_context)
 {
 	struct req_dm_crypt_io *req_io = NULL;
-	int error = DM_REQ_CRYPT_ERROR, copy_bio_sector_to_req = 0;
-	struct bio *bio_src = NULL;
+	int error = DM_REQ_CRYPT_ERROR;
 	gfp_t gfp_flag = GFP_KERNEL;
 
+	/*
+	 * Inline crypto: the storage driver only needs the ICE key setting,
+	 * which is the same for every request. Tag the clone with it and
+	 * hand it straight to the lower queue, no per request state needed.
+	 */
+	if (encryption_mode == DM_REQ_CRYPT_ENCRYPTION_MODE_TRANSPARENT) {
+		map_context->ptr = ice_settings;
+		req_crypt_remap_clone(clone);
+		return DM_MAPIO_REMAPPED;
+	}
+
 	if (in_interrupt() || irqs_disabled())
 		gfp_flag = GFP_NOWAIT;
 
@@ -937,56 +994,18 @@ static int req_crypt_map(struct dm_target *ti, struct request *clone,
 	if (rq_data_dir(clone) == READ)
 		req_io->should_decrypt = req_crypt_should_deccrypt(req_io);
 
-	/* Get the queue of the underlying original device */
-	clone->q = bdev_get_queue(dev->bdev);
-	clone->rq_disk = dev->bdev->bd_disk;
-
-	__rq_for_each_bio(bio_src, clone) {
-		bio_src->bi_bdev = dev->bdev;
-		/* Currently the way req-dm works is that once the underlying
-		 * device driver completes the request by calling into the
-		 * block layer. The block layer completes the bios (clones) and
-		 * then the cloned request. This is undesirable for req-dm-crypt
-		 * hence added a flag BIO_DONTFREE, this flag will ensure that
-		 * blk layer does not complete the cloned bios before completing
-		 * the request. When the crypt endio is called, post-processing
-		 * is done and then the dm layer will complete the bios (clones)
-		 * and free them.
-		 */
-		if (encryption_mode == DM_REQ_CRYPT_ENCRYPTION_MODE_TRANSPARENT)
-			bio_src->bi_flags |= 1 << BIO_INLINECRYPT;
-		else
-			bio_src->bi_flags |= 1 << BIO_DONTFREE;
-
-		/*
-		 * If this device has partitions, remap block n
-		 * of partition p to block n+start(p) of the disk.
-		 */
-		req_crypt_blk_partition_remap(bio_src);
-		if (copy_bio_sector_to_req == 0) {
-			clone->__sector = bio_src->bi_iter.bi_sector;
-			copy_bio_sector_to_req++;
-		}
-		blk_queue_bounce(clone->q, &bio_src);
-	}
-
-	if (encryption_mode == DM_REQ_CRYPT_ENCRYPTION_MODE_TRANSPARENT) {
-		/* Set all crypto parameters for inline crypto engine */
-		memcpy(&req_io->ice_settings, ice_settings,
-					sizeof(struct ice_crypto_setting));
-	} else {
-		/* ICE checks for key_index which could be >= 0. If a chip has
-		 * both ICE and GPCE and wanted to use GPCE, there could be
-		 * issue. Storage driver send all requests to ICE driver. If
-		 * it sees key_index as 0, it would assume it is for ICE while
-		 * it is not. Hence set invalid key index by default.
-		 */
-		req_io->ice_settings.key_index = -1;
+	req_crypt_remap_clone(clone);
 
-	}
+	/* ICE checks for key_index which could be >= 0. If a chip has
+	 * both ICE and GPCE and wanted to use GPCE, there could be
+	 * issue. Storage driver send all requests to ICE driver. If
+	 * it sees key_index as 0, it would assume it is for ICE while
+	 * it is not. Hence set invalid key index by default.
+	 */
+	req_io->ice_settings.key_index = -1;
 
-	if (rq_data_dir(clone) == READ ||
-		encryption_mode == DM_REQ_CRYPT_ENCRYPTION_MODE_TRANSPARENT) {
+	/* Only writes to encrypt need the worker on the way down */
+	if (rq_data_dir(clone) == READ || !req_io->should_encrypt) {
 		error = DM_MAPIO_REMAPPED;
 		goto submit_request;
 	} else if (rq_data_dir(clone) == WRITE) {
@@ -12,6 +12,11 @@
  * hash device. Setting this greatly improves performance when data and hash
  * are on the same disk on different partitions on devices with poor random
  * access behavior.
+ *
+ * The upper levels of the hash tree are kept in memory once verified, up to
+ * "node_cache_max" blocks per target, so they are neither read nor hashed
+ * again. Bios of at least twice "parallel_blocks" data blocks are verified
+ * in parts spread over the CPUs; 0 disables the splitting.
  */
 
 #include "dm-verity.h"
@@ -29,6 +34,10 @@
 
 #define DM_VERITY_MAX_CORRUPTED_ERRS	100
 
+#define DM_VERITY_DEFAULT_NODE_CACHE	1024
+#define DM_VERITY_DEFAULT_PARALLEL_BLOCKS	32
+#define DM_VERITY_MAX_PARTS		8
+
 #define DM_VERITY_OPT_LOGGING		"ignore_corruption"
 #define DM_VERITY_OPT_RESTART		"restart_on_corruption"
 #define DM_VERITY_OPT_IGN_ZEROES	"ignore_zero_blocks"
@@ -44,6 +53,11 @@ module_param_named(prefetch_cluster, dm_verity_prefetch_cluster, uint, S_IRUGO |
 static int dm_verity_hash_prefetch_min_size = CONFIG_DM_VERITY_HASH_PREFETCH_MIN_SIZE;
 module_param_named(prefetch_min_size, dm_verity_hash_prefetch_min_size, int, S_IRUGO | S_IWUSR);
 
+static unsigned dm_verity_node_cache_max = DM_VERITY_DEFAULT_NODE_CACHE;
+module_param_named(node_cache_max, dm_verity_node_cache_max, uint, S_IRUGO | S_IWUSR);
+
+static unsigned dm_verity_parallel_blocks = DM_VERITY_DEFAULT_PARALLEL_BLOCKS;
+module_param_named(parallel_blocks, dm_verity_parallel_blocks, uint, S_IRUGO | S_IWUSR);
 
 struct dm_verity_prefetch_work {
 	struct work_struct work;
@@ -52,6 +66,15 @@ struct dm_verity_prefetch_work {
 	unsigned n_blocks;
 };
 
+/*
+ * One part of a parallel verification. The variably-sized fields of the
+ * io follow the structure, so the io must be the last member.
+ */
+struct dm_verity_part {
+	struct work_struct work;
+	struct dm_verity_io io;
+};
+
 /*
  * Auxiliary structure appended to each dm-bufio buffer. If the value
  * hash_verified is nonzero, hash of the block has been verified.
@@ -194,6 +217,42 @@ static void verity_hash_at_level(struct dm_verity *v, sector_t block, int level,
 		*offset = idx << (v->hash_dev_block_bits - v->hash_per_block_bits);
 }
 
+/*
+ * Return the cached copy of a verified upper level hash block, or NULL.
+ */
+static u8 *verity_node_cached(struct dm_verity *v, sector_t hash_block)
+{
+	sector_t idx = hash_block - v->hash_start;
+
+	if (idx >= v->node_cache_blocks)
+		return NULL;
+
+	return lockless_dereference(v->node_cache[idx]);
+}
+
+/*
+ * Remember a verified hash block if it belongs to the cached levels.
+ * Failing to allocate the copy is harmless, the block stays in dm-bufio.
+ */
+static void verity_node_cache_add(struct dm_verity *v, sector_t hash_block,
+				  const u8 *data)
+{
+	sector_t idx = hash_block - v->hash_start;
+	u8 *node;
+
+	if (idx >= v->node_cache_blocks || READ_ONCE(v->node_cache[idx]))
+		return;
+
+	node = kmalloc(1 << v->hash_dev_block_bits,
+		GFP_NOIO | __GFP_NORETRY | __GFP_NOMEMALLOC | __GFP_NOWARN);
+	if (!node)
+		return;
+
+	memcpy(node, data, 1 << v->hash_dev_block_bits);
+	if (cmpxchg(&v->node_cache[idx], NULL, node))
+		kfree(node);
+}
+
 /*
  * Handle verification errors.
  */
@@ -276,6 +335,12 @@ static int verity_verify_level(struct dm_verity *v, struct dm_verity_io *io,
 
 	verity_hash_at_level(v, block, level, &hash_block, &offset);
 
+	data = verity_node_cached(v, hash_block);
+	if (data) {
+		memcpy(want_digest, data + offset, v->digest_size);
+		return 0;
+	}
+
 	data = dm_bufio_read(v->bufio, hash_block, &buf);
 	if (IS_ERR(data))
 		return PTR_ERR(data);
@@ -297,7 +362,11 @@ static int verity_verify_level(struct dm_verity *v, struct dm_verity_io *io,
 		if (likely(memcmp(verity_io_real_digest(v, io), want_digest,
 				  v->digest_size) == 0))
 			aux->hash_verified = 1;
-		else if (verity_fec_decode(v, io,
+		else if (io->parent) {
+			/* leave correction and reporting to the serial pass */
+			r = -EAGAIN;
+			goto release_ret_r;
+		} else if (verity_fec_decode(v, io,
 					   DM_VERITY_BLOCK_TYPE_METADATA,
 					   hash_block, data, NULL) == 0)
 			aux->hash_verified = 1;
@@ -309,6 +378,9 @@ static int verity_verify_level(struct dm_verity *v, struct dm_verity_io *io,
 		}
 	}
 
+	if (aux->hash_verified)
+		verity_node_cache_add(v, hash_block, data);
+
 	data += offset;
 	memcpy(want_digest, data, v->digest_size);
 	r = 0;
@@ -367,7 +439,8 @@ int verity_for_bv_block(struct dm_verity *v, struct dm_verity_io *io,
 				       size_t len))
 {
 	unsigned todo = 1 << v->data_dev_block_bits;
-	struct bio *bio = dm_bio_from_per_bio_data(io, v->ti->per_bio_data_size);
+	struct bio *bio = dm_bio_from_per_bio_data(io->parent ? io->parent : io,
+						   v->ti->per_bio_data_size);
 
 	do {
 		int r;
@@ -456,6 +529,8 @@ static int verity_verify_io(struct dm_verity_io *io)
 		if (likely(memcmp(verity_io_real_digest(v, io),
 				  verity_io_want_digest(v, io), v->digest_size) == 0))
 			continue;
+		else if (io->parent)
+			return -EAGAIN;
 		else if (verity_fec_decode(v, io, DM_VERITY_BLOCK_TYPE_DATA,
 					   io->block + b, NULL, &start) == 0)
 			continue;
@@ -483,10 +558,101 @@ static void verity_finish_io(struct dm_verity_io *io, int error)
 	bio_endio(bio);
 }
 
+static void verity_part_work(struct work_struct *w)
+{
+	struct dm_verity_part *part = container_of(w, struct dm_verity_part,
+						   work);
+	struct dm_verity_io *io = part->io.parent;
+	int r;
+
+	r = verity_verify_io(&part->io);
+	if (unlikely(r))
+		WRITE_ONCE(io->parts_error, r);
+	kfree(part);
+
+	if (!atomic_dec_and_test(&io->parts))
+		return;
+
+	/*
+	 * Parts neither correct nor report errors, redo the whole io
+	 * serially if any of them failed.
+	 */
+	if (unlikely(READ_ONCE(io->parts_error)))
+		verity_finish_io(io, verity_verify_io(io));
+	else
+		verity_finish_io(io, 0);
+}
+
+/*
+ * Split the verification of a large io in parts that the unbound workqueue
+ * runs on several CPUs; the last part to finish ends the io. Returns false
+ * if the io is to be verified serially.
+ */
+static bool verity_submit_parts(struct dm_verity_io *io)
+{
+	struct dm_verity *v = io->v;
+	struct bio *bio = dm_bio_from_per_bio_data(io, v->ti->per_bio_data_size);
+	struct dm_verity_part *parts[DM_VERITY_MAX_PARTS];
+	unsigned min_blocks = ACCESS_ONCE(dm_verity_parallel_blocks);
+	unsigned left = io->n_blocks;
+	sector_t block = io->block;
+	struct bvec_iter iter = io->iter;
+	unsigned n, per, i;
+
+	if (!min_blocks || io->n_blocks / min_blocks < 2)
+		return false;
+
+	n = min3(io->n_blocks / min_blocks, num_online_cpus(),
+		 (unsigned)DM_VERITY_MAX_PARTS);
+	if (n < 2)
+		return false;
+	per = DIV_ROUND_UP(io->n_blocks, n);
+	n = DIV_ROUND_UP(io->n_blocks, per);
+
+	for (i = 0; i < n; i++) {
+		parts[i] = kmalloc(sizeof(struct dm_verity_part) +
+				   v->shash_descsize + v->digest_size * 2,
+			GFP_NOIO | __GFP_NORETRY | __GFP_NOMEMALLOC | __GFP_NOWARN);
+		if (!parts[i]) {
+			while (i--)
+				kfree(parts[i]);
+			return false;
+		}
+	}
+
+	atomic_set(&io->parts, n);
+	io->parts_error = 0;
+
+	for (i = 0; i < n; i++) {
+		struct dm_verity_io *pio = &parts[i]->io;
+
+		pio->v = v;
+		pio->parent = io;
+		pio->block = block;
+		pio->n_blocks = min(per, left);
+		pio->iter = iter;
+		bio_advance_iter(bio, &iter,
+				 pio->n_blocks << v->data_dev_block_bits);
+		block += pio->n_blocks;
+		left -= pio->n_blocks;
+		INIT_WORK(&parts[i]->work, verity_part_work);
+	}
+
+	/* The first part is verified here, it may end the io */
+	for (i = 1; i < n; i++)
+		queue_work(v->verify_wq, &parts[i]->work);
+	verity_part_work(&parts[0]->work);
+
+	return true;
+}
+
 static void verity_work(struct work_struct *w)
 {
 	struct dm_verity_io *io = container_of(w, struct dm_verity_io, work);
 
+	if (verity_submit_parts(io))
+		return;
+
 	verity_finish_io(io, verity_verify_io(io));
 }
 
@@ -521,6 +687,10 @@ static void verity_prefetch_io(struct work_struct *work)
 		sector_t hash_block_end;
 		verity_hash_at_level(v, pw->block, i, &hash_block_start, NULL);
 		verity_hash_at_level(v, pw->block + pw->n_blocks - 1, i, &hash_block_end, NULL);
+		/* cached upper levels need no reading */
+		if (i && verity_node_cached(v, hash_block_start) &&
+		    verity_node_cached(v, hash_block_end))
+			continue;
 		if (!i) {
 			unsigned cluster = ACCESS_ONCE(dm_verity_prefetch_cluster);
 
@@ -596,6 +766,7 @@ int verity_map(struct dm_target *ti, struct bio *bio)
 
 	io = dm_per_bio_data(bio, ti->per_bio_data_size);
 	io->v = v;
+	io->parent = NULL;
 	io->orig_bi_end_io = bio->bi_end_io;
 	io->block = bio->bi_iter.bi_sector >> (v->data_dev_block_bits - SECTOR_SHIFT);
 	io->n_blocks = bio->bi_iter.bi_size >> v->data_dev_block_bits;
@@ -725,6 +896,14 @@ void verity_dtr(struct dm_target *ti)
 	if (v->bufio)
 		dm_bufio_client_destroy(v->bufio);
 
+	if (v->node_cache) {
+		sector_t i;
+
+		for (i = 0; i < v->node_cache_blocks; i++)
+			kfree(v->node_cache[i]);
+		kfree(v->node_cache);
+	}
+
 	kfree(v->salt);
 	kfree(v->root_digest);
 	kfree(v->zero_digest);
@@ -1038,6 +1217,22 @@ int verity_ctr(struct dm_target *ti, unsigned argc, char **argv)
 	}
 	v->hash_blocks = hash_position;
 
+	/* the levels above the lowest one are stored first */
+	if (v->levels > 1) {
+		v->node_cache_blocks = min_t(sector_t,
+			v->hash_level_block[0] - v->hash_start,
+			ACCESS_ONCE(dm_verity_node_cache_max));
+		if (v->node_cache_blocks) {
+			v->node_cache = kcalloc(v->node_cache_blocks,
+						sizeof(u8 *), GFP_KERNEL);
+			if (!v->node_cache) {
+				ti->error = "Cannot allocate hash node cache";
+				r = -ENOMEM;
+				goto bad;
+			}
+		}
+	}
+
 	v->bufio = dm_bufio_client_create(v->hash_dev->bdev,
 		1 << v->hash_dev_block_bits, 1, sizeof(struct buffer_aux),
 		dm_bufio_alloc_callback, NULL);
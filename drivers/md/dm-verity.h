@@ -62,6 +62,13 @@ struct dm_verity {
 	/* starting blocks for each tree level. 0 is the lowest level. */
 	sector_t hash_level_block[DM_VERITY_MAX_LEVELS];
 
+	/*
+	 * Verified copies of the upper level hash blocks, which sit
+	 * contiguously from hash_start. Entries are only ever set once.
+	 */
+	u8 **node_cache;
+	sector_t node_cache_blocks;
+
 	struct dm_verity_fec *fec;	/* forward error correction */
 };
 
@@ -78,6 +85,11 @@ struct dm_verity_io {
 
 	struct work_struct work;
 
+	/* parallel verification: the io a part belongs to, or NULL */
+	struct dm_verity_io *parent;
+	atomic_t parts;
+	int parts_error;
+
 	/*
 	 * Three variably-size fields follow this struct:
 	 *
@@ -1195,6 +1195,7 @@ static void msm_jpegdma_device_run(void *priv)
 		ctx->pending_config = 0;
 	}
 
+	ctx->batch_cnt = 0;
 	msm_jpegdma_process_buffers(ctx, src_buf, dst_buf);
 	dev_dbg(ctx->jdma_device->dev, "Jpeg v4l2 dma device run X\n");
 }
@@ -1233,6 +1234,27 @@ static struct v4l2_m2m_ops msm_jpegdma_m2m_ops = {
 	.job_ready = msm_jpegdma_job_ready,
 };
 
+/*
+ * msm_jpegdma_batch_next - Check if the running job can take the next frame.
+ * @ctx: Pointer dma context.
+ *
+ * Burst thumbnail and downscale generation queues many small frames. They
+ * are processed back to back from the done interrupt without going through
+ * the mem2mem scheduler, up to MSM_JPEGDMA_MAX_BATCH frames per job so
+ * other contexts are not starved.
+ */
+static int msm_jpegdma_batch_next(struct jpegdma_ctx *ctx)
+{
+	if (!atomic_read(&ctx->active))
+		return 0;
+
+	if (++ctx->batch_cnt >= MSM_JPEGDMA_MAX_BATCH)
+		return 0;
+
+	return v4l2_m2m_num_src_bufs_ready(ctx->m2m_ctx) &&
+		v4l2_m2m_num_dst_bufs_ready(ctx->m2m_ctx);
+}
+
 /*
  * msm_jpegdma_isr_processing_done - Invoked by dma_hw when processing is done.
  * @dma: Pointer dma device.
@@ -1258,13 +1280,25 @@ void msm_jpegdma_isr_processing_done(struct msm_jpegdma_device *dma)
 				mutex_unlock(&dma->lock);
 				return;
 			}
-			complete_all(&ctx->completion);
 			ctx->plane_idx = 0;
 
 			v4l2_m2m_buf_done(src_buf, VB2_BUF_STATE_DONE);
 			v4l2_m2m_buf_done(dst_buf, VB2_BUF_STATE_DONE);
-			v4l2_m2m_job_finish(ctx->jdma_device->m2m_dev,
-				ctx->m2m_ctx);
+
+			if (msm_jpegdma_batch_next(ctx)) {
+				if (ctx->pending_config) {
+					msm_jpegdma_schedule_next_config(ctx);
+					ctx->pending_config = 0;
+				}
+				dst_buf = v4l2_m2m_next_dst_buf(ctx->m2m_ctx);
+				src_buf = v4l2_m2m_next_src_buf(ctx->m2m_ctx);
+				msm_jpegdma_process_buffers(ctx, src_buf,
+					dst_buf);
+			} else {
+				complete_all(&ctx->completion);
+				v4l2_m2m_job_finish(ctx->jdma_device->m2m_dev,
+					ctx->m2m_ctx);
+			}
 		} else {
 			dst_buf = v4l2_m2m_next_dst_buf(ctx->m2m_ctx);
 			src_buf = v4l2_m2m_next_src_buf(ctx->m2m_ctx);
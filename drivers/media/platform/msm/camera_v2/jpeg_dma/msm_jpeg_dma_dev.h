@@ -31,6 +31,8 @@
 #define MSM_JPEGDMA_MAX_PIPES 2
 /* Max number of hw configurations supported */
 #define MSM_JPEGDMA_MAX_CONFIGS 2
+/* Max number of frames processed back to back in one mem2mem job */
+#define MSM_JPEGDMA_MAX_BATCH 8
 /* Dma default fps */
 #define MSM_JPEGDMA_DEFAULT_FPS 30
 
@@ -252,6 +254,7 @@ struct msm_jpegdma_buf_handle {
  * @pending_config: Flag set if there is pending plane configuration.
  * @plane_idx: Processing plane index.
  * @format_idx: Current format index.
+ * @batch_cnt: Frames completed in the running mem2mem job.
  */
 struct jpegdma_ctx {
 	struct mutex lock;
@@ -273,6 +276,7 @@ struct jpegdma_ctx {
 
 	unsigned int plane_idx;
 	unsigned int format_idx;
+	unsigned int batch_cnt;
 };
 
 /*
@@ -11,10 +11,62 @@
  */
 #define pr_fmt(fmt) "CAM-BUFMGR %s:%d " fmt, __func__, __LINE__
 
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+#include <linux/slab.h>
+
 #include "msm_generic_buf_mgr.h"
 
 static struct msm_buf_mngr_device *msm_buf_mngr_dev;
 
+static inline uint32_t msm_buf_mngr_key(uint32_t session_id,
+	uint32_t stream_id, uint32_t index)
+{
+	return (session_id << 16) ^ (stream_id << 8) ^ index;
+}
+
+static struct msm_get_bufs *msm_buf_mngr_find(
+	struct msm_buf_mngr_device *dev, uint32_t session_id,
+	uint32_t stream_id, uint32_t index)
+{
+	struct msm_get_bufs *bufs;
+
+	hash_for_each_possible(dev->buf_hash, bufs, entry,
+		msm_buf_mngr_key(session_id, stream_id, index)) {
+		if ((bufs->session_id == session_id) &&
+			(bufs->stream_id == stream_id) &&
+			(bufs->index == index))
+			return bufs;
+	}
+	return NULL;
+}
+
+/* Called with buf_q_spinlock held */
+static void msm_buf_mngr_stat_update(struct msm_buf_mngr_device *dev,
+	enum msm_buf_mngr_stat_op op, ktime_t start)
+{
+	struct msm_buf_mngr_stat *stat = &dev->stats[op];
+	uint64_t ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+
+	stat->count++;
+	stat->total_ns += ns;
+	if (ns > stat->max_ns)
+		stat->max_ns = ns;
+}
+
+static void msm_buf_mngr_add(struct msm_buf_mngr_device *dev,
+	struct msm_get_bufs *bufs, ktime_t start)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&dev->buf_q_spinlock, flags);
+	hash_add(dev->buf_hash, &bufs->entry,
+		msm_buf_mngr_key(bufs->session_id, bufs->stream_id,
+			bufs->index));
+	msm_buf_mngr_stat_update(dev, MSM_BUF_MNGR_STAT_GET, start);
+	spin_unlock_irqrestore(&dev->buf_q_spinlock, flags);
+}
+
 struct v4l2_subdev *msm_buf_mngr_get_subdev(void)
 {
 	return &msm_buf_mngr_dev->subdev.sd;
@@ -52,31 +104,28 @@ static int32_t msm_buf_mngr_hdl_cont_get_buf(struct msm_buf_mngr_device *dev,
 static int32_t msm_buf_mngr_get_buf(struct msm_buf_mngr_device *dev,
 	void __user *argp)
 {
-	unsigned long flags;
 	int32_t rc = 0;
+	ktime_t start = ktime_get();
 	struct msm_buf_mngr_info *buf_info =
 		(struct msm_buf_mngr_info *)argp;
 	struct msm_get_bufs *new_entry =
-		kzalloc(sizeof(struct msm_get_bufs), GFP_KERNEL);
+		kmem_cache_zalloc(dev->buf_cache, GFP_KERNEL);
 
 	if (!new_entry) {
 		pr_err("%s:No mem\n", __func__);
 		return -ENOMEM;
 	}
-	INIT_LIST_HEAD(&new_entry->entry);
 	new_entry->vb2_v4l2_buf = dev->vb2_ops.get_buf(buf_info->session_id,
 		buf_info->stream_id);
 	if (!new_entry->vb2_v4l2_buf) {
 		pr_debug("%s:Get buf is null\n", __func__);
-		kfree(new_entry);
+		kmem_cache_free(dev->buf_cache, new_entry);
 		return -EINVAL;
 	}
 	new_entry->session_id = buf_info->session_id;
 	new_entry->stream_id = buf_info->stream_id;
 	new_entry->index = new_entry->vb2_v4l2_buf->vb2_buf.index;
-	spin_lock_irqsave(&dev->buf_q_spinlock, flags);
-	list_add_tail(&new_entry->entry, &dev->buf_qhead);
-	spin_unlock_irqrestore(&dev->buf_q_spinlock, flags);
+	msm_buf_mngr_add(dev, new_entry, start);
 	buf_info->index = new_entry->vb2_v4l2_buf->vb2_buf.index;
 	if (buf_info->type == MSM_CAMERA_BUF_MNGR_BUF_USER) {
 		mutex_lock(&dev->cont_mutex);
@@ -95,35 +144,32 @@ static int32_t msm_buf_mngr_get_buf(struct msm_buf_mngr_device *dev,
 static int32_t msm_buf_mngr_get_buf_by_idx(struct msm_buf_mngr_device *dev,
 	void *argp)
 {
-	unsigned long flags;
 	int32_t rc = 0;
+	ktime_t start = ktime_get();
 	struct msm_buf_mngr_info *buf_info =
 		(struct msm_buf_mngr_info *)argp;
 	struct msm_get_bufs *new_entry =
-		kzalloc(sizeof(struct msm_get_bufs), GFP_KERNEL);
+		kmem_cache_zalloc(dev->buf_cache, GFP_KERNEL);
 
 	if (!new_entry)
 		return -ENOMEM;
 
 	if (!buf_info) {
-		kfree(new_entry);
+		kmem_cache_free(dev->buf_cache, new_entry);
 		return -EIO;
 	}
 
-	INIT_LIST_HEAD(&new_entry->entry);
 	new_entry->vb2_v4l2_buf = dev->vb2_ops.get_buf_by_idx(
 		buf_info->session_id, buf_info->stream_id, buf_info->index);
 	if (!new_entry->vb2_v4l2_buf) {
 		pr_debug("%s:Get buf is null\n", __func__);
-		kfree(new_entry);
+		kmem_cache_free(dev->buf_cache, new_entry);
 		return -EINVAL;
 	}
 	new_entry->session_id = buf_info->session_id;
 	new_entry->stream_id = buf_info->stream_id;
 	new_entry->index = new_entry->vb2_v4l2_buf->vb2_buf.index;
-	spin_lock_irqsave(&dev->buf_q_spinlock, flags);
-	list_add_tail(&new_entry->entry, &dev->buf_qhead);
-	spin_unlock_irqrestore(&dev->buf_q_spinlock, flags);
+	msm_buf_mngr_add(dev, new_entry, start);
 	if (buf_info->type == MSM_CAMERA_BUF_MNGR_BUF_USER) {
 		mutex_lock(&dev->cont_mutex);
 		if (!list_empty(&dev->cont_qhead)) {
@@ -142,27 +188,27 @@ static int32_t msm_buf_mngr_buf_done(struct msm_buf_mngr_device *buf_mngr_dev,
 	struct msm_buf_mngr_info *buf_info)
 {
 	unsigned long flags;
-	struct msm_get_bufs *bufs, *save;
+	struct msm_get_bufs *bufs;
 	int32_t ret = -EINVAL;
+	ktime_t start = ktime_get();
 
 	spin_lock_irqsave(&buf_mngr_dev->buf_q_spinlock, flags);
-	list_for_each_entry_safe(bufs, save, &buf_mngr_dev->buf_qhead, entry) {
-		if ((bufs->session_id == buf_info->session_id) &&
-			(bufs->stream_id == buf_info->stream_id) &&
-			(bufs->index == buf_info->index)) {
-			ret = buf_mngr_dev->vb2_ops.buf_done
-					(bufs->vb2_v4l2_buf,
-						buf_info->session_id,
-						buf_info->stream_id,
-						buf_info->frame_id,
-						&buf_info->timestamp,
-						buf_info->reserved);
-			list_del_init(&bufs->entry);
-			kfree(bufs);
-			break;
-		}
+	bufs = msm_buf_mngr_find(buf_mngr_dev, buf_info->session_id,
+		buf_info->stream_id, buf_info->index);
+	if (bufs) {
+		ret = buf_mngr_dev->vb2_ops.buf_done(bufs->vb2_v4l2_buf,
+			buf_info->session_id,
+			buf_info->stream_id,
+			buf_info->frame_id,
+			&buf_info->timestamp,
+			buf_info->reserved);
+		hash_del(&bufs->entry);
+		msm_buf_mngr_stat_update(buf_mngr_dev, MSM_BUF_MNGR_STAT_DONE,
+			start);
 	}
 	spin_unlock_irqrestore(&buf_mngr_dev->buf_q_spinlock, flags);
+	if (bufs)
+		kmem_cache_free(buf_mngr_dev->buf_cache, bufs);
 	return ret;
 }
 
@@ -171,22 +217,23 @@ static int32_t msm_buf_mngr_put_buf(struct msm_buf_mngr_device *buf_mngr_dev,
 	struct msm_buf_mngr_info *buf_info)
 {
 	unsigned long flags;
-	struct msm_get_bufs *bufs, *save;
+	struct msm_get_bufs *bufs;
 	int32_t ret = -EINVAL;
+	ktime_t start = ktime_get();
 
 	spin_lock_irqsave(&buf_mngr_dev->buf_q_spinlock, flags);
-	list_for_each_entry_safe(bufs, save, &buf_mngr_dev->buf_qhead, entry) {
-		if ((bufs->session_id == buf_info->session_id) &&
-			(bufs->stream_id == buf_info->stream_id) &&
-			(bufs->index == buf_info->index)) {
-			ret = buf_mngr_dev->vb2_ops.put_buf(bufs->vb2_v4l2_buf,
-				buf_info->session_id, buf_info->stream_id);
-			list_del_init(&bufs->entry);
-			kfree(bufs);
-			break;
-		}
+	bufs = msm_buf_mngr_find(buf_mngr_dev, buf_info->session_id,
+		buf_info->stream_id, buf_info->index);
+	if (bufs) {
+		ret = buf_mngr_dev->vb2_ops.put_buf(bufs->vb2_v4l2_buf,
+			buf_info->session_id, buf_info->stream_id);
+		hash_del(&bufs->entry);
+		msm_buf_mngr_stat_update(buf_mngr_dev, MSM_BUF_MNGR_STAT_PUT,
+			start);
 	}
 	spin_unlock_irqrestore(&buf_mngr_dev->buf_q_spinlock, flags);
+	if (bufs)
+		kmem_cache_free(buf_mngr_dev->buf_cache, bufs);
 	return ret;
 }
 
@@ -195,16 +242,18 @@ static int32_t msm_generic_buf_mngr_flush(
 	struct msm_buf_mngr_info *buf_info)
 {
 	unsigned long flags;
-	struct msm_get_bufs *bufs, *save;
+	struct msm_get_bufs *bufs;
+	struct hlist_node *save;
 	int32_t ret = -EINVAL;
 	struct timeval ts;
+	int bkt;
 
 	spin_lock_irqsave(&buf_mngr_dev->buf_q_spinlock, flags);
 	/*
 	 * Sanity check on client buf list, remove buf mgr
 	 * queue entries in case any
 	 */
-	list_for_each_entry_safe(bufs, save, &buf_mngr_dev->buf_qhead, entry) {
+	hash_for_each_safe(buf_mngr_dev->buf_hash, bkt, save, bufs, entry) {
 		if ((bufs->session_id == buf_info->session_id) &&
 			(bufs->stream_id == buf_info->stream_id)) {
 			ret = buf_mngr_dev->vb2_ops.buf_done(bufs->vb2_v4l2_buf,
@@ -213,8 +262,8 @@ static int32_t msm_generic_buf_mngr_flush(
 			pr_err("Bufs not flushed: str_id = %d buf_index = %d ret = %d\n",
 			buf_info->stream_id, bufs->index,
 			ret);
-			list_del_init(&bufs->entry);
-			kfree(bufs);
+			hash_del(&bufs->entry);
+			kmem_cache_free(buf_mngr_dev->buf_cache, bufs);
 		}
 	}
 	spin_unlock_irqrestore(&buf_mngr_dev->buf_q_spinlock, flags);
@@ -287,23 +336,22 @@ static void msm_buf_mngr_sd_shutdown(struct msm_buf_mngr_device *dev,
 				     struct msm_sd_close_ioctl *session)
 {
 	unsigned long flags;
-	struct msm_get_bufs *bufs, *save;
+	struct msm_get_bufs *bufs;
+	struct hlist_node *save;
+	int bkt;
 
 	BUG_ON(!dev);
 	BUG_ON(!session);
 
 	spin_lock_irqsave(&dev->buf_q_spinlock, flags);
-	if (!list_empty(&dev->buf_qhead)) {
-		list_for_each_entry_safe(bufs,
-			save, &dev->buf_qhead, entry) {
-			pr_info("%s: Delete invalid bufs =%pK, session_id=%u, bufs->ses_id=%d, str_id=%d, idx=%d\n",
-				__func__, (void *)bufs, session->session,
-				bufs->session_id, bufs->stream_id,
-				bufs->index);
-			if (session->session == bufs->session_id) {
-				list_del_init(&bufs->entry);
-				kfree(bufs);
-			}
+	hash_for_each_safe(dev->buf_hash, bkt, save, bufs, entry) {
+		pr_info("%s: Delete invalid bufs =%pK, session_id=%u, bufs->ses_id=%d, str_id=%d, idx=%d\n",
+			__func__, (void *)bufs, session->session,
+			bufs->session_id, bufs->stream_id,
+			bufs->index);
+		if (session->session == bufs->session_id) {
+			hash_del(&bufs->entry);
+			kmem_cache_free(dev->buf_cache, bufs);
 		}
 	}
 	spin_unlock_irqrestore(&dev->buf_q_spinlock, flags);
@@ -826,6 +874,59 @@ static long msm_buf_subdev_fops_ioctl(struct file *file, unsigned int cmd,
 	return video_usercopy(file, cmd, arg, msm_bmgr_subdev_do_ioctl);
 }
 
+static const char * const msm_buf_mngr_stat_names[] = {
+	[MSM_BUF_MNGR_STAT_GET] = "get",
+	[MSM_BUF_MNGR_STAT_DONE] = "buf_done",
+	[MSM_BUF_MNGR_STAT_PUT] = "put",
+};
+
+static int msm_buf_mngr_stats_show(struct seq_file *m, void *v)
+{
+	struct msm_buf_mngr_device *dev = m->private;
+	struct msm_buf_mngr_stat stat;
+	unsigned long flags;
+	int i;
+
+	for (i = 0; i < MSM_BUF_MNGR_STAT_MAX; i++) {
+		spin_lock_irqsave(&dev->buf_q_spinlock, flags);
+		stat = dev->stats[i];
+		spin_unlock_irqrestore(&dev->buf_q_spinlock, flags);
+
+		seq_printf(m, "%s: count %llu avg %llu ns max %llu ns\n",
+			msm_buf_mngr_stat_names[i], stat.count,
+			stat.count ? div64_u64(stat.total_ns, stat.count) : 0,
+			stat.max_ns);
+	}
+	return 0;
+}
+
+static int msm_buf_mngr_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, msm_buf_mngr_stats_show, inode->i_private);
+}
+
+static ssize_t msm_buf_mngr_stats_write(struct file *file,
+	const char __user *buf, size_t count, loff_t *ppos)
+{
+	struct msm_buf_mngr_device *dev =
+		((struct seq_file *)file->private_data)->private;
+	unsigned long flags;
+
+	/* Any write resets the counters */
+	spin_lock_irqsave(&dev->buf_q_spinlock, flags);
+	memset(dev->stats, 0, sizeof(dev->stats));
+	spin_unlock_irqrestore(&dev->buf_q_spinlock, flags);
+	return count;
+}
+
+static const struct file_operations msm_buf_mngr_stats_fops = {
+	.open = msm_buf_mngr_stats_open,
+	.read = seq_read,
+	.write = msm_buf_mngr_stats_write,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
 static int32_t __init msm_buf_mngr_init(void)
 {
 	int32_t rc = 0;
@@ -867,8 +968,17 @@ static int32_t __init msm_buf_mngr_init(void)
 	v4l2_subdev_notify(&msm_buf_mngr_dev->subdev.sd, MSM_SD_NOTIFY_REQ_CB,
 		&msm_buf_mngr_dev->vb2_ops);
 
-	INIT_LIST_HEAD(&msm_buf_mngr_dev->buf_qhead);
+	hash_init(msm_buf_mngr_dev->buf_hash);
 	spin_lock_init(&msm_buf_mngr_dev->buf_q_spinlock);
+	msm_buf_mngr_dev->buf_cache = KMEM_CACHE(msm_get_bufs, 0);
+	if (!msm_buf_mngr_dev->buf_cache) {
+		pr_err("%s: Failed to create buf cache\n", __func__);
+		rc = -ENOMEM;
+		goto end;
+	}
+	msm_buf_mngr_dev->debugfs_entry = debugfs_create_file(
+		"msm_buf_mngr_stats", S_IRUGO | S_IWUSR, NULL,
+		msm_buf_mngr_dev, &msm_buf_mngr_stats_fops);
 
 	mutex_init(&msm_buf_mngr_dev->cont_mutex);
 	INIT_LIST_HEAD(&msm_buf_mngr_dev->cont_qhead);
@@ -886,6 +996,8 @@ end:
 static void __exit msm_buf_mngr_exit(void)
 {
 	msm_sd_unregister(&msm_buf_mngr_dev->subdev);
+	debugfs_remove(msm_buf_mngr_dev->debugfs_entry);
+	kmem_cache_destroy(msm_buf_mngr_dev->buf_cache);
 	mutex_destroy(&msm_buf_mngr_dev->cont_mutex);
 	kfree(msm_buf_mngr_dev);
 }
@@ -13,7 +13,9 @@
 #ifndef __MSM_BUF_GENERIC_MNGR_H__
 #define __MSM_BUF_GENERIC_MNGR_H__
 
+#include <linux/hashtable.h>
 #include <linux/io.h>
+#include <linux/ktime.h>
 #include <linux/of.h>
 #include <linux/module.h>
 #include <linux/platform_device.h>
@@ -24,17 +26,37 @@
 #include "msm.h"
 #include "msm_sd.h"
 
+/* Buffers handed out, hashed on session, stream and index */
+#define MSM_BUF_MNGR_HASH_BITS 6
+
 struct msm_get_bufs {
-	struct list_head entry;
+	struct hlist_node entry;
 	struct vb2_v4l2_buffer *vb2_v4l2_buf;
 	uint32_t session_id;
 	uint32_t stream_id;
 	uint32_t index;
 };
 
+enum msm_buf_mngr_stat_op {
+	MSM_BUF_MNGR_STAT_GET,
+	MSM_BUF_MNGR_STAT_DONE,
+	MSM_BUF_MNGR_STAT_PUT,
+	MSM_BUF_MNGR_STAT_MAX,
+};
+
+struct msm_buf_mngr_stat {
+	uint64_t count;
+	uint64_t total_ns;
+	uint64_t max_ns;
+};
+
 struct msm_buf_mngr_device {
-	struct list_head buf_qhead;
+	DECLARE_HASHTABLE(buf_hash, MSM_BUF_MNGR_HASH_BITS);
 	spinlock_t buf_q_spinlock;
+	/* Entries of msm_get_bufs are recycled through this cache */
+	struct kmem_cache *buf_cache;
+	struct msm_buf_mngr_stat stats[MSM_BUF_MNGR_STAT_MAX];
+	struct dentry *debugfs_entry;
 	struct ion_client *ion_client;
 	struct msm_sd_subdev subdev;
 	struct msm_sd_req_vb2_q vb2_ops;
@@ -35,6 +35,7 @@
 #include "msm_isp_util.h"
 #include "msm_camera_io_util.h"
 #include <linux/debugfs.h>
+#include <linux/seq_file.h>
 #include "cam_smmu_api.h"
 
 #define MSM_CPP_DRV_NAME "msm_cpp"
@@ -322,20 +323,27 @@ static void msm_cpp_clear_timer(struct cpp_device *cpp_dev)
 	}
 }
 
-static void msm_cpp_timer_queue_update(struct cpp_device *cpp_dev)
+/*
+ * Retire the @done oldest frames from the timeout bookkeeping and restart
+ * the timer once for the frames still in flight.
+ */
+static void msm_cpp_timer_queue_update(struct cpp_device *cpp_dev,
+	uint32_t done)
 {
 	uint32_t i;
 	unsigned long flags;
 
-	CPP_DBG("Frame done qlen %d\n", cpp_dev->processing_q.len);
-	if (cpp_dev->processing_q.len <= 1) {
+	CPP_DBG("Frame done qlen %d done %d\n", cpp_dev->processing_q.len,
+		done);
+	if (cpp_dev->processing_q.len <= done) {
 		msm_cpp_clear_timer(cpp_dev);
 	} else {
 		spin_lock_irqsave(&cpp_timer.data.processed_frame_lock, flags);
-		for (i = 0; i < cpp_dev->processing_q.len - 1; i++)
+		for (i = 0; i < cpp_dev->processing_q.len - done; i++)
 			cpp_timer.data.processed_frame[i] =
-				cpp_timer.data.processed_frame[i + 1];
-		cpp_timer.data.processed_frame[i] = NULL;
+				cpp_timer.data.processed_frame[i + done];
+		for (; i < MAX_CPP_PROCESSING_FRAME; i++)
+			cpp_timer.data.processed_frame[i] = NULL;
 		cpp_dev->timeout_trial_cnt = 0;
 		spin_unlock_irqrestore(&cpp_timer.data.processed_frame_lock,
 			flags);
@@ -1035,7 +1043,7 @@ void msm_cpp_do_tasklet(unsigned long data)
 	uint32_t irq_status;
 	uint32_t tx_level;
 	uint32_t msg_id, cmd_len;
-	uint32_t i;
+	uint32_t i, done;
 	uint32_t tx_fifo[MSM_CPP_TX_FIFO_LEVEL];
 	struct cpp_device *cpp_dev = (struct cpp_device *) data;
 	struct msm_cpp_tasklet_queue_cmd *queue_cmd;
@@ -1059,26 +1067,38 @@ void msm_cpp_do_tasklet(unsigned long data)
 
 		spin_unlock_irqrestore(&cpp_dev->tasklet_lock, flags);
 
+		/*
+		 * With several frames in flight the firmware may have acked
+		 * more than one of them by the time the fifo is drained, so
+		 * count them first and retire them in one go.
+		 */
+		done = 0;
 		for (i = 0; i < tx_level; i++) {
 			if (tx_fifo[i] == MSM_CPP_MSG_ID_CMD) {
 				cmd_len = tx_fifo[i+1];
 				msg_id = tx_fifo[i+2];
 				if (msg_id == MSM_CPP_MSG_ID_FRAME_ACK) {
 					CPP_DBG("Frame done!!\n");
-					/* delete CPP timer */
-					CPP_DBG("delete timer.\n");
-					msm_cpp_timer_queue_update(cpp_dev);
-					msm_cpp_notify_frame_done(cpp_dev, 0);
+					done++;
 				} else if (msg_id ==
 					MSM_CPP_MSG_ID_FRAME_NACK) {
 					pr_err("NACK error from hw!!\n");
-					CPP_DBG("delete timer.\n");
-					msm_cpp_timer_queue_update(cpp_dev);
-					msm_cpp_notify_frame_done(cpp_dev, 0);
+					cpp_dev->frame_stats.nacked++;
+					done++;
 				}
 				i += cmd_len + 2;
 			}
 		}
+
+		if (!done)
+			continue;
+
+		/* delete CPP timer */
+		CPP_DBG("delete timer.\n");
+		msm_cpp_timer_queue_update(cpp_dev, done);
+		cpp_dev->frame_stats.coalesced += done - 1;
+		while (done--)
+			msm_cpp_notify_frame_done(cpp_dev, 0);
 	}
 }
 
@@ -1662,6 +1682,12 @@ static int msm_cpp_notify_frame_done(struct cpp_device *cpp_dev,
 	if (frame_qcmd) {
 		processed_frame = frame_qcmd->command;
 		do_gettimeofday(&(processed_frame->out_time));
+		cpp_dev->frame_stats.done++;
+		cpp_dev->frame_stats.latency_us +=
+			(processed_frame->out_time.tv_sec -
+			processed_frame->in_time.tv_sec) * USEC_PER_SEC +
+			processed_frame->out_time.tv_usec -
+			processed_frame->in_time.tv_usec;
 		kfree(frame_qcmd);
 		event_qcmd = kzalloc(sizeof(struct msm_queue_cmd), GFP_ATOMIC);
 		if (!event_qcmd) {
@@ -2022,7 +2048,7 @@ static int msm_cpp_send_frame_to_hardware(struct cpp_device *cpp_dev,
 	struct msm_queue_cmd *qcmd = NULL;
 	uint32_t queue_len = 0, fifo_counter = 0;
 
-	if (cpp_dev->processing_q.len < MAX_CPP_PROCESSING_FRAME) {
+	if (cpp_dev->processing_q.len < cpp_dev->processing_depth) {
 		process_frame = frame_qcmd->command;
 		msm_cpp_dump_frame_cmd(process_frame);
 		spin_lock_irqsave(&cpp_timer.data.processed_frame_lock, flags);
@@ -2101,6 +2127,9 @@ static int msm_cpp_send_frame_to_hardware(struct cpp_device *cpp_dev,
 		msm_cpp_write(MSM_CPP_MSG_ID_TRAILER, cpp_dev->base);
 
 		do_gettimeofday(&(process_frame->in_time));
+		cpp_dev->frame_stats.submitted++;
+		cpp_dev->frame_stats.max_inflight = max_t(uint32_t,
+			cpp_dev->frame_stats.max_inflight, queue_len);
 		rc = 0;
 	} else {
 		pr_err("process queue full. drop frame\n");
@@ -4677,6 +4706,7 @@ static int cpp_probe(struct platform_device *pdev)
 
 	msm_queue_init(&cpp_dev->eventData_q, "eventdata");
 	msm_queue_init(&cpp_dev->processing_q, "frame");
+	cpp_dev->processing_depth = MSM_CPP_DEF_PROCESSING_DEPTH;
 	INIT_LIST_HEAD(&cpp_dev->tasklet_q);
 	tasklet_init(&cpp_dev->cpp_tasklet, msm_cpp_do_tasklet,
 		(unsigned long)cpp_dev);
@@ -4818,6 +4848,71 @@ static int msm_cpp_debugfs_error_s(void *data, u64 val)
 DEFINE_SIMPLE_ATTRIBUTE(cpp_debugfs_error, NULL,
 	msm_cpp_debugfs_error_s, "%llu\n");
 
+static int msm_cpp_debugfs_depth_s(void *data, u64 val)
+{
+	struct cpp_device *cpp_dev = data;
+
+	if (val < 1 || val > MAX_CPP_PROCESSING_FRAME)
+		return -EINVAL;
+
+	mutex_lock(&cpp_dev->mutex);
+	cpp_dev->processing_depth = val;
+	mutex_unlock(&cpp_dev->mutex);
+	return 0;
+}
+
+static int msm_cpp_debugfs_depth_g(void *data, u64 *val)
+{
+	struct cpp_device *cpp_dev = data;
+
+	*val = cpp_dev->processing_depth;
+	return 0;
+}
+
+DEFINE_SIMPLE_ATTRIBUTE(cpp_debugfs_depth, msm_cpp_debugfs_depth_g,
+	msm_cpp_debugfs_depth_s, "%llu\n");
+
+static int msm_cpp_throughput_show(struct seq_file *m, void *v)
+{
+	struct cpp_device *cpp_dev = m->private;
+	struct msm_cpp_frame_stats *stats = &cpp_dev->frame_stats;
+	ktime_t now = ktime_get();
+	uint64_t done = stats->done;
+	uint64_t fps = 0, elapsed_us;
+
+	/* Rate of the frames completed since the previous read */
+	elapsed_us = ktime_us_delta(now, stats->last_read);
+	if (stats->last_read.tv64 && elapsed_us)
+		fps = div64_u64((done - stats->last_done) * USEC_PER_SEC,
+			elapsed_us);
+	stats->last_read = now;
+	stats->last_done = done;
+
+	seq_printf(m, "submitted: %llu\n", stats->submitted);
+	seq_printf(m, "done: %llu\n", done);
+	seq_printf(m, "nacked: %llu\n", stats->nacked);
+	seq_printf(m, "coalesced: %llu\n", stats->coalesced);
+	seq_printf(m, "fps: %llu\n", fps);
+	seq_printf(m, "avg_latency_us: %llu\n",
+		done ? div64_u64(stats->latency_us, done) : 0);
+	seq_printf(m, "max_inflight: %u/%u\n", stats->max_inflight,
+		cpp_dev->processing_depth);
+
+	return 0;
+}
+
+static int msm_cpp_throughput_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, msm_cpp_throughput_show, inode->i_private);
+}
+
+static const struct file_operations cpp_debugfs_throughput = {
+	.open = msm_cpp_throughput_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
 static int msm_cpp_enable_debugfs(struct cpp_device *cpp_dev)
 {
 	struct dentry *debugfs_base;
@@ -4830,6 +4925,14 @@ static int msm_cpp_enable_debugfs(struct cpp_device *cpp_dev)
 		(void *)cpp_dev, &cpp_debugfs_error))
 		return -ENOMEM;
 
+	if (!debugfs_create_file("processing_depth", S_IRUGO | S_IWUSR,
+		debugfs_base, (void *)cpp_dev, &cpp_debugfs_depth))
+		return -ENOMEM;
+
+	if (!debugfs_create_file("throughput", S_IRUGO, debugfs_base,
+		(void *)cpp_dev, &cpp_debugfs_throughput))
+		return -ENOMEM;
+
 	return 0;
 }
 
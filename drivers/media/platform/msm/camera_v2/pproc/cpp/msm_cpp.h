@@ -18,6 +18,7 @@
 #include <linux/list.h>
 #include <linux/platform_device.h>
 #include <linux/interrupt.h>
+#include <linux/ktime.h>
 #include <media/v4l2-subdev.h>
 #include "msm_generic_buf_mgr.h"
 #include "msm_sd.h"
@@ -42,7 +43,8 @@
 #define VBIF_VERSION_2_3_0  0x20030000
 
 #define MAX_ACTIVE_CPP_INSTANCE 8
-#define MAX_CPP_PROCESSING_FRAME 2
+#define MAX_CPP_PROCESSING_FRAME 4
+#define MSM_CPP_DEF_PROCESSING_DEPTH 2
 #define MAX_CPP_V4l2_EVENTS 30
 
 #define MSM_CPP_MICRO_BASE          0x4000
@@ -224,6 +226,20 @@ struct msm_cpp_payload_params {
 	uint32_t dup_frame_indicator_off;
 };
 
+struct msm_cpp_frame_stats {
+	uint64_t submitted;
+	uint64_t done;
+	uint64_t nacked;
+	/* Frames acked in the same tasklet pass as an earlier one */
+	uint64_t coalesced;
+	/* Sum of the submit to done time of completed frames */
+	uint64_t latency_us;
+	uint32_t max_inflight;
+	/* Snapshot taken by the last throughput read */
+	uint64_t last_done;
+	ktime_t last_read;
+};
+
 struct cpp_device {
 	struct platform_device *pdev;
 	struct msm_sd_subdev msm_sd;
@@ -280,6 +296,9 @@ struct cpp_device {
 	 * store frame info for frames sent to microcontroller
 	 */
 	struct msm_device_queue processing_q;
+	/* Frames allowed in flight, up to MAX_CPP_PROCESSING_FRAME */
+	uint32_t processing_depth;
+	struct msm_cpp_frame_stats frame_stats;
 
 	struct msm_cpp_buff_queue_info_t *buff_queue;
 	uint32_t num_buffq;
@@ -1857,6 +1857,45 @@ static int sde_rotator_validate_fmt_and_item_flags(
 	return 0;
 }
 
+static void sde_rotator_fill_valid_item(struct sde_rot_valid_item *v,
+	struct sde_rot_entry *entry)
+{
+	struct sde_rotation_item *item = &entry->item;
+
+	memset(v, 0, sizeof(*v));
+	v->flags = item->flags;
+	v->src_rect = item->src_rect;
+	v->dst_rect = item->dst_rect;
+	v->input_format = item->input.format;
+	v->output_format = item->output.format;
+	v->wb_idx = item->wb_idx;
+}
+
+/*
+ * Steady state rotation (e.g. portrait video playback) submits the same
+ * geometry every frame. Once an item passed validation against the session
+ * configuration, identical items reuse the outcome.
+ */
+static bool sde_rotator_valid_item_hit(struct sde_rot_mgr *mgr,
+	struct sde_rot_perf *perf, struct sde_rot_entry *entry)
+{
+	struct sde_rot_valid_item v;
+
+	if (!mgr->sticky_session || !perf->valid_item_cached)
+		return false;
+
+	sde_rotator_fill_valid_item(&v, entry);
+	v.dnsc_factor_w = perf->valid_item.dnsc_factor_w;
+	v.dnsc_factor_h = perf->valid_item.dnsc_factor_h;
+	if (memcmp(&v, &perf->valid_item, sizeof(v)))
+		return false;
+
+	entry->dnsc_factor_w = v.dnsc_factor_w;
+	entry->dnsc_factor_h = v.dnsc_factor_h;
+	mgr->sticky_hits++;
+	return true;
+}
+
 static int sde_rotator_validate_entry(struct sde_rot_mgr *mgr,
 	struct sde_rot_file_private *private,
 	struct sde_rot_entry *entry)
@@ -1887,6 +1926,9 @@ static int sde_rotator_validate_entry(struct sde_rot_mgr *mgr,
 		return -EINVAL;
 	}
 
+	if (sde_rotator_valid_item_hit(mgr, perf, entry))
+		return 0;
+
 	ret = sde_rotator_validate_item_matches_session(&perf->config, item);
 	if (ret) {
 		SDEROT_DBG("Work item does not match session:%u\n",
@@ -1909,6 +1951,11 @@ static int sde_rotator_validate_entry(struct sde_rot_mgr *mgr,
 		SDEROT_DBG("fail to configure downscale factor\n");
 		return ret;
 	}
+
+	sde_rotator_fill_valid_item(&perf->valid_item, entry);
+	perf->valid_item.dnsc_factor_w = entry->dnsc_factor_w;
+	perf->valid_item.dnsc_factor_h = entry->dnsc_factor_h;
+	perf->valid_item_cached = true;
 	return ret;
 }
 
@@ -2234,7 +2281,19 @@ static int sde_rotator_config_session(struct sde_rot_mgr *mgr,
 		return -EINVAL;
 	}
 
+	/*
+	 * Restarting a stream with the configuration already in place keeps
+	 * the clock and bus votes computed for it.
+	 */
+	if (mgr->sticky_session && perf->clk_rate &&
+			!memcmp(&perf->config, config, sizeof(*config))) {
+		SDEROT_DBG("session id=%u config unchanged\n",
+			config->session_id);
+		return 0;
+	}
+
 	perf->config = *config;
+	perf->valid_item_cached = false;
 	ret = sde_rotator_calc_perf(mgr, perf);
 
 	if (ret) {
@@ -2775,6 +2834,7 @@ int sde_rotator_core_init(struct sde_rot_mgr **pmgr,
 	mgr->device = &pdev->dev;
 	mgr->pending_close_bw_vote = 0;
 	mgr->hwacquire_timeout = ROT_HW_ACQUIRE_TIMEOUT_IN_MS;
+	mgr->sticky_session = 1;
 	mgr->queue_count = 1;
 	mgr->pixel_per_clk.numer = ROT_PIXEL_PER_CLK_NUMERATOR;
 	mgr->pixel_per_clk.denom = ROT_PIXEL_PER_CLK_DENOMINATOR;
@@ -230,6 +230,28 @@ struct sde_rot_entry {
 	struct sde_rot_file_private *private;
 };
 
+/*
+ * struct sde_rot_valid_item - item parameters covered by entry validation
+ * @flags: rotation request flags
+ * @src_rect: source crop rectangle
+ * @dst_rect: destination rectangle
+ * @input_format: input pixel format
+ * @output_format: output pixel format
+ * @wb_idx: write-back block
+ * @dnsc_factor_w: downscale factor computed for the item
+ * @dnsc_factor_h: downscale factor computed for the item
+ */
+struct sde_rot_valid_item {
+	u32 flags;
+	struct sde_rect src_rect;
+	struct sde_rect dst_rect;
+	u32 input_format;
+	u32 output_format;
+	u32 wb_idx;
+	u32 dnsc_factor_w;
+	u32 dnsc_factor_h;
+};
+
 struct sde_rot_perf {
 	struct list_head list;
 	struct sde_rotation_config config;
@@ -240,6 +262,9 @@ struct sde_rot_perf {
 	int last_wb_idx; /* last known wb index, used when above count is 0 */
 	u32 rdot_limit;
 	u32 wrot_limit;
+	/* last item that passed validation against @config */
+	bool valid_item_cached;
+	struct sde_rot_valid_item valid_item;
 };
 
 struct sde_rot_file_private {
@@ -293,6 +318,9 @@ struct sde_rot_mgr {
 	u32 wrot_limit;
 
 	u32 hwacquire_timeout;
+	/* reuse validation and perf votes across identical frames */
+	u32 sticky_session;
+	u32 sticky_hits;
 	struct sde_mult_factor pixel_per_clk;
 	struct sde_mult_factor fudge_factor;
 	struct sde_mult_factor overhead;
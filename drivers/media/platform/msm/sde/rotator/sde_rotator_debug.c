@@ -861,6 +861,18 @@ static int sde_rotator_core_create_debugfs(
 		return -EINVAL;
 	}
 
+	if (!debugfs_create_u32("sticky_session", S_IRUGO | S_IWUSR,
+			debugfs_root, &mgr->sticky_session)) {
+		SDEROT_WARN("failed to create debugfs sticky session\n");
+		return -EINVAL;
+	}
+
+	if (!debugfs_create_u32("sticky_hits", S_IRUGO,
+			debugfs_root, &mgr->sticky_hits)) {
+		SDEROT_WARN("failed to create debugfs sticky hits\n");
+		return -EINVAL;
+	}
+
 	if (!debugfs_create_u32("ppc_numer", S_IRUGO | S_IWUSR,
 			debugfs_root, &mgr->pixel_per_clk.numer)) {
 		SDEROT_WARN("failed to create debugfs ppc numerator\n");
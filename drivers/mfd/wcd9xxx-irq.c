@@ -467,6 +467,30 @@ static int wcd9xxx_irq_setup_downstream_irq(
 	return 0;
 }
 
+/*
+ * The codec latency vote only matters on the CPU that services the codec
+ * interrupt, so once the upstream IRQ is known make the vote follow its
+ * affinity instead of keeping every CPU out of deep idle. Passing irq 0
+ * turns it back into a vote for all CPUs.
+ */
+static void wcd9xxx_irq_pm_qos_affine(struct wcd9xxx_core_resource *wcd9xxx_res,
+				      int irq)
+{
+	s32 val = PM_QOS_DEFAULT_VALUE;
+
+	mutex_lock(&wcd9xxx_res->pm_lock);
+	if (wcd9xxx_res->wlock_holders)
+		val = msm_cpuidle_get_deep_idle_latency();
+	pm_qos_remove_request(&wcd9xxx_res->pm_qos_req);
+	if (irq) {
+		wcd9xxx_res->pm_qos_req.type = PM_QOS_REQ_AFFINE_IRQ;
+		wcd9xxx_res->pm_qos_req.irq = irq;
+	}
+	pm_qos_add_request(&wcd9xxx_res->pm_qos_req, PM_QOS_CPU_DMA_LATENCY,
+			   val);
+	mutex_unlock(&wcd9xxx_res->pm_lock);
+}
+
 int wcd9xxx_irq_init(struct wcd9xxx_core_resource *wcd9xxx_res)
 {
 	int i, ret;
@@ -555,6 +579,8 @@ int wcd9xxx_irq_init(struct wcd9xxx_core_resource *wcd9xxx_res)
 	if (ret)
 		goto fail_irq_init;
 
+	wcd9xxx_irq_pm_qos_affine(wcd9xxx_res, wcd9xxx_res->irq);
+
 	return ret;
 
 fail_irq_init:
@@ -584,6 +610,7 @@ void wcd9xxx_irq_exit(struct wcd9xxx_core_resource *wcd9xxx_res)
 		wcd9xxx_res->irq);
 
 	if (wcd9xxx_res->irq) {
+		wcd9xxx_irq_pm_qos_affine(wcd9xxx_res, 0);
 		disable_irq_wake(wcd9xxx_res->irq);
 		free_irq(wcd9xxx_res->irq, wcd9xxx_res);
 		wcd9xxx_res->irq = 0;
@@ -3080,12 +3080,32 @@ int __qseecom_process_reentrancy(struct qseecom_command_scm_resp *resp,
 	}
 }
 
+/*
+ * Only the request and response buffers of a command are exchanged with
+ * the TA, so cache maintenance is limited to the part of the shared buffer
+ * that spans them instead of the whole buffer. Both buffers have already
+ * been validated to lie within the shared buffer.
+ */
+static void __qseecom_cmd_cache_span(struct qseecom_dev_handle *data,
+				struct qseecom_send_cmd_req *req,
+				unsigned long *offset, unsigned long *len)
+{
+	uintptr_t req_start = (uintptr_t)req->cmd_req_buf;
+	uintptr_t resp_start = (uintptr_t)req->resp_buf;
+	uintptr_t start, end;
+
+	start = min(req_start, resp_start);
+	end = max(req_start + req->cmd_req_len, resp_start + req->resp_len);
+
+	*offset = start - data->client.user_virt_sb_base;
+	*len = end - start;
+}
+
 static int __qseecom_send_cmd(struct qseecom_dev_handle *data,
 				struct qseecom_send_cmd_req *req)
 {
 	int ret = 0;
 	int ret2 = 0;
-	u32 reqd_len_sb_in = 0;
 	struct qseecom_client_send_data_ireq send_data_req = {0};
 	struct qseecom_client_send_data_64bit_ireq send_data_req_64bit = {0};
 	struct qseecom_command_scm_resp resp;
@@ -3095,8 +3115,8 @@ static int __qseecom_send_cmd(struct qseecom_dev_handle *data,
 	void *cmd_buf = NULL;
 	size_t cmd_len;
 	struct sglist_info *table = data->sglistinfo_ptr;
+	unsigned long cache_off, cache_len;
 
-	reqd_len_sb_in = req->cmd_req_len + req->resp_len;
 	/* find app_id & img_name from list */
 	spin_lock_irqsave(&qseecom.registered_app_list_lock, flags);
 	list_for_each_entry(ptr_app, &qseecom.registered_app_list_head,
@@ -3166,10 +3186,11 @@ static int __qseecom_send_cmd(struct qseecom_dev_handle *data,
 	else
 		*(uint32_t *)cmd_buf = QSEOS_CLIENT_SEND_DATA_COMMAND_WHITELIST;
 
-	ret = msm_ion_do_cache_op(qseecom.ion_clnt, data->client.ihandle,
-					data->client.sb_virt,
-					reqd_len_sb_in,
-					ION_IOC_CLEAN_INV_CACHES);
+	__qseecom_cmd_cache_span(data, req, &cache_off, &cache_len);
+	ret = msm_ion_do_cache_offset_op(qseecom.ion_clnt,
+					data->client.ihandle,
+					data->client.sb_virt, cache_off,
+					cache_len, ION_IOC_CLEAN_INV_CACHES);
 	if (ret) {
 		pr_err("cache operation failed %d\n", ret);
 		return ret;
@@ -3208,8 +3229,9 @@ static int __qseecom_send_cmd(struct qseecom_dev_handle *data,
 		}
 	}
 exit:
-	ret2 = msm_ion_do_cache_op(qseecom.ion_clnt, data->client.ihandle,
-				data->client.sb_virt, data->client.sb_length,
+	ret2 = msm_ion_do_cache_offset_op(qseecom.ion_clnt,
+				data->client.ihandle,
+				data->client.sb_virt, cache_off, cache_len,
 				ION_IOC_INV_CACHES);
 	if (ret2) {
 		pr_err("cache operation failed %d\n", ret2);
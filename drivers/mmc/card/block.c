@@ -212,6 +212,7 @@ static void mmc_blk_put(struct mmc_blk_data *md)
 	if (md->usage == 0) {
 		int devidx = mmc_get_devidx(md->disk);
 		blk_cleanup_queue(md->queue.queue);
+		mmc_cmdq_free_tag_set(&md->queue);
 
 		__clear_bit(devidx, dev_use);
 
@@ -1182,8 +1183,12 @@ idata_free:
 
 cmd_done:
 	mmc_blk_put(md);
-	if (card && card->cmdq_init)
-		wake_up(&card->host->cmdq_ctx.wait);
+	if (card && card->cmdq_init) {
+		struct mmc_blk_data *main_md = mmc_get_drvdata(card);
+
+		if (main_md)
+			mmc_cmdq_kick_queue(&main_md->queue);
+	}
 	return err;
 }
 
@@ -1885,6 +1890,45 @@ int mmc_access_rpmb(struct mmc_queue *mq)
 	return false;
 }
 
+/*
+ * CMDQ requests may come from a legacy or a blk-mq queue, see
+ * CONFIG_MMC_BLOCK_CMDQ_MQ. These end or requeue them either way.
+ */
+static void mmc_blk_cmdq_end_request(struct request *req, int err,
+				     unsigned int nr_bytes)
+{
+	if (!req->q->mq_ops) {
+		blk_end_request(req, err, nr_bytes);
+		return;
+	}
+
+	if (blk_update_request(req, err, nr_bytes)) {
+		/* issue what is left as a new task */
+		blk_mq_requeue_request(req);
+		blk_mq_kick_requeue_list(req->q);
+	} else {
+		__blk_mq_end_request(req, err);
+	}
+}
+
+static void mmc_blk_cmdq_end_request_all(struct request *req, int err)
+{
+	if (req->q->mq_ops)
+		blk_mq_end_request(req, err);
+	else
+		blk_end_request_all(req, err);
+}
+
+static void mmc_blk_cmdq_requeue_request(struct request *req)
+{
+	if (req->q->mq_ops) {
+		blk_mq_requeue_request(req);
+		blk_mq_kick_requeue_list(req->q);
+	} else {
+		blk_requeue_request(req->q, req);
+	}
+}
+
 static struct mmc_cmdq_req *mmc_blk_cmdq_prep_discard_req(struct mmc_queue *mq,
 						struct request *req)
 {
@@ -1921,7 +1965,7 @@ static int mmc_blk_cmdq_issue_discard_rq(struct mmc_queue *mq,
 
 	if (!mmc_can_erase(card)) {
 		err = -EOPNOTSUPP;
-		blk_end_request(req, err, blk_rq_bytes(req));
+		mmc_blk_cmdq_end_request(req, err, blk_rq_bytes(req));
 		goto out;
 	}
 
@@ -3113,7 +3157,7 @@ static void mmc_blk_cmdq_requeue_rw_rq(struct mmc_queue *mq,
 	struct mmc_host *host = card->host;
 
 	pr_info("%s %s\n", mmc_hostname(host), __func__);
-	blk_requeue_request(req->q, req);
+	mmc_blk_cmdq_requeue_request(req);
 	mmc_put_card(host->card);
 }
 
@@ -3274,7 +3318,7 @@ static bool is_cmdq_dcmd_req(struct request_queue *q, int tag)
 	struct mmc_queue_req *mq_rq;
 	struct mmc_cmdq_req *cmdq_req;
 
-	req = blk_queue_find_tag(q, tag);
+	req = mmc_cmdq_find_tag(q->queuedata, tag);
 	if (WARN_ON(!req))
 		goto out;
 	mq_rq = req->special;
@@ -3338,9 +3382,7 @@ static void mmc_blk_cmdq_reset_all(struct mmc_host *host, int err)
 		mmc_put_card(card);
 	}
 
-	spin_lock_irq(q->queue_lock);
-	blk_queue_invalidate_tags(q);
-	spin_unlock_irq(q->queue_lock);
+	mmc_cmdq_invalidate_tags(q->queuedata);
 }
 
 static void mmc_blk_cmdq_shutdown(struct mmc_queue *mq)
@@ -3508,7 +3550,7 @@ reset:
 	host->err_mrq = NULL;
 	clear_bit(CMDQ_STATE_REQ_TIMED_OUT, &ctx_info->curr_state);
 	WARN_ON(!test_and_clear_bit(CMDQ_STATE_ERR, &ctx_info->curr_state));
-	wake_up(&ctx_info->wait);
+	mmc_cmdq_kick_queue(mq);
 }
 
 /* invoked by block layer in softirq context */
@@ -3563,7 +3605,7 @@ void mmc_blk_cmdq_complete_rq(struct request *rq)
 		mmc_cmdq_post_req(host, cmdq_req->tag, err);
 	if (cmdq_req->cmdq_req_flags & DCMD) {
 		clear_bit(CMDQ_STATE_DCMD_ACTIVE, &ctx_info->curr_state);
-		blk_end_request_all(rq, err);
+		mmc_blk_cmdq_end_request_all(rq, err);
 		goto out;
 	}
 	/*
@@ -3574,7 +3616,7 @@ void mmc_blk_cmdq_complete_rq(struct request *rq)
 	 */
 	if (err && cmdq_req->skip_err_handling) {
 		cmdq_req->skip_err_handling = false;
-		blk_end_request_all(rq, err);
+		mmc_blk_cmdq_end_request_all(rq, err);
 		goto out;
 	}
 
@@ -3618,14 +3660,14 @@ void mmc_blk_cmdq_complete_rq(struct request *rq)
 		}
 	}
 
-	blk_end_request(rq, err, cmdq_req->data.bytes_xfered);
+	mmc_blk_cmdq_end_request(rq, err, cmdq_req->data.bytes_xfered);
 
 out:
 
 	mmc_cmdq_clk_scaling_stop_busy(host, true, is_dcmd);
 	if (!test_bit(CMDQ_STATE_ERR, &ctx_info->curr_state)) {
 		mmc_host_clk_release(host);
-		wake_up(&ctx_info->wait);
+		mmc_cmdq_kick_queue(mq);
 		mmc_put_card(host->card);
 	}
 
@@ -3641,6 +3683,8 @@ out:
 /*
  * Complete reqs from block layer softirq context
  * Invoked in irq context
+ * blk-mq requests also go through BLOCK_SOFTIRQ rather than
+ * blk_mq_complete_request(), which would run the completion here.
  */
 void mmc_blk_cmdq_req_done(struct mmc_request *mrq)
 {
@@ -4014,7 +4058,7 @@ static int mmc_blk_cmdq_issue_rq(struct mmc_queue *mq, struct request *req)
 
 out:
 	if (req)
-		blk_end_request_all(req, ret);
+		mmc_blk_cmdq_end_request_all(req, ret);
 	mmc_put_card(card);
 
 	return ret;
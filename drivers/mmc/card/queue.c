@@ -26,6 +26,9 @@
 
 #define MMC_QUEUE_BOUNCESZ	65536
 
+/* how often a blk-mq CMDQ queue rechecks a halted CQE */
+#define MMC_CMDQ_HALT_POLL_MS	1
+
 /*
  * Based on benchmark tests the default num of requests to trigger the write
  * packing was determined, to keep the read latency as low as possible and
@@ -88,6 +91,21 @@ static bool mmc_check_blk_queue_start_tag(struct request_queue *q,
 	return !!ret;
 }
 
+static bool mmc_cmdq_can_issue(struct mmc_host *host, struct request *req)
+{
+	struct mmc_cmdq_context_info *ctx = &host->cmdq_ctx;
+	struct mmc_card *card = host->card;
+
+	if ((req->cmd_flags & (REQ_FLUSH | REQ_DISCARD)) &&
+	    test_bit(CMDQ_STATE_DCMD_ACTIVE, &ctx->curr_state))
+		return false;
+	if (!card->part_curr && !mmc_card_suspended(card) &&
+	    (mmc_host_halt(host) || mmc_host_cq_disable(host)))
+		return false;
+
+	return !test_bit(CMDQ_STATE_ERR, &ctx->curr_state);
+}
+
 static inline void mmc_cmdq_ready_wait(struct mmc_host *host,
 					struct mmc_queue *mq)
 {
@@ -110,14 +128,8 @@ static inline void mmc_cmdq_ready_wait(struct mmc_host *host,
 	 * 5. free tag available to process the new request.
 	 */
 	wait_event(ctx->wait, kthread_should_stop()
-		|| (mmc_peek_request(mq) &&
-		!((mq->cmdq_req_peeked->cmd_flags & (REQ_FLUSH | REQ_DISCARD))
-		  && test_bit(CMDQ_STATE_DCMD_ACTIVE, &ctx->curr_state))
-		&& !(!host->card->part_curr && !mmc_card_suspended(host->card)
-		     && mmc_host_halt(host))
-		&& !(!host->card->part_curr && mmc_host_cq_disable(host) &&
-			!mmc_card_suspended(host->card))
-		&& !test_bit(CMDQ_STATE_ERR, &ctx->curr_state)
+		|| (mmc_peek_request(mq)
+		&& mmc_cmdq_can_issue(host, mq->cmdq_req_peeked)
 		&& !mmc_check_blk_queue_start_tag(q, mq->cmdq_req_peeked)));
 }
 
@@ -221,6 +233,9 @@ static void mmc_cmdq_dispatch_req(struct request_queue *q)
 	wake_up(&mq->card->host->cmdq_ctx.wait);
 }
 
+static struct request_queue *mmc_cmdq_alloc_queue(struct mmc_queue *mq,
+						  spinlock_t *lock);
+
 /*
  * Generic MMC request handler.  This is called for any queue on a
  * particular host.  When the host is not busy, we look for a request
@@ -346,7 +361,7 @@ int mmc_init_queue(struct mmc_queue *mq, struct mmc_card *card,
 	mq->card = card;
 	if (card->ext_csd.cmdq_support &&
 	    (area_type == MMC_BLK_DATA_AREA_MAIN)) {
-		mq->queue = blk_init_queue(mmc_cmdq_dispatch_req, lock);
+		mq->queue = mmc_cmdq_alloc_queue(mq, lock);
 		if (!mq->queue)
 			return -ENOMEM;
 		mmc_cmdq_setup_queue(mq, card);
@@ -355,12 +370,16 @@ int mmc_init_queue(struct mmc_queue *mq, struct mmc_card *card,
 			pr_err("%s: %d: cmdq: unable to set-up\n",
 			       mmc_hostname(card->host), ret);
 			blk_cleanup_queue(mq->queue);
+			mmc_cmdq_free_tag_set(mq);
 		} else {
 			sema_init(&mq->thread_sem, 1);
 			/* hook for pm qos cmdq init */
 			if (card->host->cmdq_ops->init)
 				card->host->cmdq_ops->init(card->host);
 			mq->queue->queuedata = mq;
+			/* blk-mq issues from ->queue_rq(), there is no thread */
+			if (mq->queue->mq_ops)
+				return 0;
 			mq->thread = kthread_run(mmc_cmdq_thread, mq,
 						 "mmc-cmdqd/%d%s",
 						 host->index,
@@ -566,13 +585,19 @@ void mmc_cleanup_queue(struct mmc_queue *mq)
 	mmc_queue_resume(mq);
 
 	/* Then terminate our worker thread */
-	kthread_stop(mq->thread);
+	if (mq->thread)
+		kthread_stop(mq->thread);
 
 	/* Empty the queue */
-	spin_lock_irqsave(q->queue_lock, flags);
-	q->queuedata = NULL;
-	blk_start_queue(q);
-	spin_unlock_irqrestore(q->queue_lock, flags);
+	if (q->mq_ops) {
+		q->queuedata = NULL;
+		blk_mq_start_stopped_hw_queues(q, true);
+	} else {
+		spin_lock_irqsave(q->queue_lock, flags);
+		q->queuedata = NULL;
+		blk_start_queue(q);
+		spin_unlock_irqrestore(q->queue_lock, flags);
+	}
 
 	if (!mmc_card_sd(mq->card)) {
 		kfree(mqrq_cur->bounce_sg);
@@ -664,6 +689,205 @@ enum blk_eh_timer_return mmc_cmdq_rq_timed_out(struct request *req)
 	return mq->cmdq_req_timed_out(req);
 }
 
+#ifdef CONFIG_MMC_BLOCK_CMDQ_MQ
+static int mmc_cmdq_queue_rq(struct blk_mq_hw_ctx *hctx,
+			     const struct blk_mq_queue_data *bd)
+{
+	struct request *req = bd->rq;
+	struct mmc_queue *mq = hctx->queue->queuedata;
+	struct mmc_host *host;
+
+	if (!mq) {
+		req->cmd_flags |= REQ_QUIET;
+		return BLK_MQ_RQ_QUEUE_ERROR;
+	}
+	host = mq->card->host;
+
+	/*
+	 * Both the submitter and kblockd can get here, and the issue path
+	 * sleeps (claim host, BKOPS halt, partition switch), so issue one
+	 * request at a time as the mmc-cmdqd thread did.
+	 */
+	mutex_lock(&mq->cmdq_issue_lock);
+	if (test_bit(BLK_MQ_S_STOPPED, &hctx->state))
+		goto busy;
+
+	if (!mmc_cmdq_can_issue(host, req)) {
+		/*
+		 * Request completion and the error handler restart the queue
+		 * once the DCMD or the recovery is done. The CQE halt is
+		 * lifted by the core with no hook back into the queue, so
+		 * poll for that one.
+		 */
+		blk_mq_stop_hw_queue(hctx);
+		if (mmc_host_halt(host) || mmc_host_cq_disable(host))
+			blk_mq_delay_queue(hctx, MMC_CMDQ_HALT_POLL_MS);
+		else if (mmc_cmdq_can_issue(host, req))
+			/* the completion that clears it may have missed us */
+			blk_mq_start_stopped_hw_queues(hctx->queue, true);
+		goto busy;
+	}
+
+	blk_mq_start_request(req);
+	mq->cmdq_issue_fn(mq, req);
+	mutex_unlock(&mq->cmdq_issue_lock);
+
+	return BLK_MQ_RQ_QUEUE_OK;
+
+busy:
+	mutex_unlock(&mq->cmdq_issue_lock);
+	return BLK_MQ_RQ_QUEUE_BUSY;
+}
+
+static enum blk_eh_timer_return mmc_cmdq_mq_timed_out(struct request *req,
+						      bool reserved)
+{
+	return mmc_cmdq_rq_timed_out(req);
+}
+
+static struct blk_mq_ops mmc_cmdq_mq_ops = {
+	.queue_rq	= mmc_cmdq_queue_rq,
+	.map_queue	= blk_mq_map_queue,
+	.complete	= mmc_cmdq_softirq_done,
+	.timeout	= mmc_cmdq_mq_timed_out,
+};
+
+static struct request_queue *mmc_cmdq_alloc_mq_queue(struct mmc_queue *mq)
+{
+	struct blk_mq_tag_set *set = &mq->tag_set;
+	struct request_queue *q;
+
+	memset(set, 0, sizeof(*set));
+	set->ops = &mmc_cmdq_mq_ops;
+	set->nr_hw_queues = 1;
+	/* one slot is reserved for dcmd requests */
+	set->queue_depth = mq->card->ext_csd.cmdq_depth - 1;
+	set->numa_node = NUMA_NO_NODE;
+	set->timeout = 120 * HZ;
+	set->flags = BLK_MQ_F_SHOULD_MERGE | BLK_MQ_F_BLOCKING |
+		     BLK_ALLOC_POLICY_TO_MQ_FLAG(BLK_TAG_ALLOC_FIFO);
+	set->driver_data = mq;
+
+	if (blk_mq_alloc_tag_set(set))
+		goto out;
+
+	q = blk_mq_init_queue(set);
+	if (IS_ERR(q)) {
+		mmc_cmdq_free_tag_set(mq);
+		goto out;
+	}
+	mutex_init(&mq->cmdq_issue_lock);
+
+	return q;
+out:
+	pr_warn("%s: blk-mq cmdq queue unavailable, using request_fn\n",
+		mmc_hostname(mq->card->host));
+	return NULL;
+}
+#endif
+
+static struct request_queue *mmc_cmdq_alloc_queue(struct mmc_queue *mq,
+						  spinlock_t *lock)
+{
+#ifdef CONFIG_MMC_BLOCK_CMDQ_MQ
+	struct request_queue *q;
+
+	q = mmc_cmdq_alloc_mq_queue(mq);
+	if (q)
+		return q;
+#endif
+	return blk_init_queue(mmc_cmdq_dispatch_req, lock);
+}
+
+void mmc_cmdq_free_tag_set(struct mmc_queue *mq)
+{
+	if (!mq->tag_set.tags)
+		return;
+
+	blk_mq_free_tag_set(&mq->tag_set);
+	mq->tag_set.tags = NULL;
+}
+
+/*
+ * Let the issue path look at the queue again after a DCMD completed or
+ * error recovery finished.
+ */
+void mmc_cmdq_kick_queue(struct mmc_queue *mq)
+{
+	if (mq->queue->mq_ops)
+		blk_mq_start_stopped_hw_queues(mq->queue, true);
+	else
+		wake_up(&mq->card->host->cmdq_ctx.wait);
+}
+
+struct request *mmc_cmdq_find_tag(struct mmc_queue *mq, int tag)
+{
+	if (mq->queue->mq_ops)
+		return blk_mq_tag_to_rq(mq->tag_set.tags[0], tag);
+
+	return blk_queue_find_tag(mq->queue, tag);
+}
+
+static void mmc_cmdq_requeue_busy(struct request *req, void *data,
+				  bool reserved)
+{
+	if (blk_mq_request_started(req))
+		blk_mq_requeue_request(req);
+}
+
+/* Put every request the CQE owned back on the queue after a reset */
+void mmc_cmdq_invalidate_tags(struct mmc_queue *mq)
+{
+	struct request_queue *q = mq->queue;
+
+	if (q->mq_ops) {
+		blk_mq_all_tag_busy_iter(mq->tag_set.tags[0],
+					 mmc_cmdq_requeue_busy, NULL);
+		blk_mq_kick_requeue_list(q);
+		return;
+	}
+
+	spin_lock_irq(q->queue_lock);
+	blk_queue_invalidate_tags(q);
+	spin_unlock_irq(q->queue_lock);
+}
+
+static void mmc_cmdq_tag_busy(struct request *req, void *data, bool reserved)
+{
+	*(bool *)data = true;
+}
+
+static int mmc_cmdq_mq_suspend(struct mmc_queue *mq, int wait)
+{
+	struct request_queue *q = mq->queue;
+	struct mmc_host *host = mq->card->host;
+	bool busy = false;
+
+	if (wait) {
+		/*
+		 * Freezing waits for every request to complete and keeps new
+		 * ones out, so nothing is issued after the CQE shutdown.
+		 */
+		blk_mq_freeze_queue(q);
+		mq->cmdq_shutdown(mq);
+		return 0;
+	}
+
+	blk_mq_stop_hw_queues(q);
+	/* let an issue that got past the stopped check finish */
+	mutex_lock(&mq->cmdq_issue_lock);
+	mutex_unlock(&mq->cmdq_issue_lock);
+
+	blk_mq_all_tag_busy_iter(mq->tag_set.tags[0], mmc_cmdq_tag_busy, &busy);
+	if (busy || host->cmdq_ctx.active_reqs) {
+		clear_bit(MMC_QUEUE_SUSPENDED, &mq->flags);
+		blk_mq_start_stopped_hw_queues(q, true);
+		return -EBUSY;
+	}
+
+	return 0;
+}
+
 int mmc_cmdq_init(struct mmc_queue *mq, struct mmc_card *card)
 {
 	int i, ret = 0;
@@ -699,20 +923,24 @@ int mmc_cmdq_init(struct mmc_queue *mq, struct mmc_card *card)
 		}
 	}
 
-	ret = blk_queue_init_tags(mq->queue, q_depth, NULL, BLK_TAG_ALLOC_FIFO);
-	if (ret) {
-		pr_warn("%s: unable to allocate cmdq tags %d\n",
-				mmc_card_name(card), q_depth);
-		goto free_mqrq_sg;
+	/* blk-mq takes tags, completion and timeout from the tag set */
+	if (!mq->queue->mq_ops) {
+		ret = blk_queue_init_tags(mq->queue, q_depth, NULL,
+					  BLK_TAG_ALLOC_FIFO);
+		if (ret) {
+			pr_warn("%s: unable to allocate cmdq tags %d\n",
+					mmc_card_name(card), q_depth);
+			goto free_mqrq_sg;
+		}
+
+		blk_queue_softirq_done(mq->queue, mmc_cmdq_softirq_done);
+		blk_queue_rq_timed_out(mq->queue, mmc_cmdq_rq_timed_out);
+		blk_queue_rq_timeout(mq->queue, 120 * HZ);
 	}
 
-	blk_queue_softirq_done(mq->queue, mmc_cmdq_softirq_done);
 	INIT_WORK(&mq->cmdq_err_work, mmc_cmdq_error_work);
 	init_completion(&mq->cmdq_shutdown_complete);
 	init_completion(&mq->cmdq_pending_req_done);
-
-	blk_queue_rq_timed_out(mq->queue, mmc_cmdq_rq_timed_out);
-	blk_queue_rq_timeout(mq->queue, 120 * HZ);
 	card->cmdq_init = true;
 
 	goto out;
@@ -731,9 +959,11 @@ void mmc_cmdq_clean(struct mmc_queue *mq, struct mmc_card *card)
 	int i;
 	int q_depth = card->ext_csd.cmdq_depth - 1;
 
-	blk_free_tags(mq->queue->queue_tags);
-	mq->queue->queue_tags = NULL;
-	blk_queue_free_tags(mq->queue);
+	if (!mq->queue->mq_ops) {
+		blk_free_tags(mq->queue->queue_tags);
+		mq->queue->queue_tags = NULL;
+		blk_queue_free_tags(mq->queue);
+	}
 
 	for (i = 0; i < q_depth; i++)
 		kfree(mq->mqrq_cmdq[i].sg);
@@ -758,12 +988,17 @@ int mmc_queue_suspend(struct mmc_queue *mq, int wait)
 	struct mmc_card *card = mq->card;
 	struct request *req;
 
-	if (card->cmdq_init && blk_queue_tagged(q)) {
+	if (card->cmdq_init && (blk_queue_tagged(q) || q->mq_ops)) {
 		struct mmc_host *host = card->host;
 
 		if (test_and_set_bit(MMC_QUEUE_SUSPENDED, &mq->flags))
 			goto out;
 
+		if (q->mq_ops) {
+			rc = mmc_cmdq_mq_suspend(mq, wait);
+			goto out;
+		}
+
 		if (wait) {
 
 			/*
@@ -840,9 +1075,14 @@ void mmc_queue_resume(struct mmc_queue *mq)
 
 	if (test_and_clear_bit(MMC_QUEUE_SUSPENDED, &mq->flags)) {
 
-		if (!(card->cmdq_init && blk_queue_tagged(q)))
+		if (!(card->cmdq_init && (blk_queue_tagged(q) || q->mq_ops)))
 			up(&mq->thread_sem);
 
+		if (q->mq_ops) {
+			blk_mq_start_stopped_hw_queues(q, true);
+			return;
+		}
+
 		spin_lock_irqsave(q->queue_lock, flags);
 		blk_start_queue(q);
 		spin_unlock_irqrestore(q->queue_lock, flags);
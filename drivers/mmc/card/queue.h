@@ -1,6 +1,8 @@
 #ifndef MMC_QUEUE_H
 #define MMC_QUEUE_H
 
+#include <linux/blk-mq.h>
+
 #define MMC_REQ_SPECIAL_MASK	(REQ_DISCARD | REQ_FLUSH)
 
 struct request;
@@ -77,6 +79,9 @@ struct mmc_queue {
 	int (*err_check_fn) (struct mmc_card *, struct mmc_async_req *);
 	void (*packed_test_fn) (struct request_queue *, struct mmc_queue_req *);
 	void (*cmdq_shutdown)(struct mmc_queue *);
+	/* blk-mq CMDQ queue: tags are CMDQ slots, issue is serialised */
+	struct blk_mq_tag_set	tag_set;
+	struct mutex		cmdq_issue_lock;
 #ifdef CONFIG_MMC_SIMULATE_MAX_SPEED
 	atomic_t max_write_speed;
 	atomic_t max_read_speed;
@@ -107,5 +112,9 @@ extern void print_mmc_packing_stats(struct mmc_card *card);
 
 extern int mmc_cmdq_init(struct mmc_queue *mq, struct mmc_card *card);
 extern void mmc_cmdq_clean(struct mmc_queue *mq, struct mmc_card *card);
+extern void mmc_cmdq_free_tag_set(struct mmc_queue *mq);
+extern void mmc_cmdq_kick_queue(struct mmc_queue *mq);
+extern struct request *mmc_cmdq_find_tag(struct mmc_queue *mq, int tag);
+extern void mmc_cmdq_invalidate_tags(struct mmc_queue *mq);
 
 #endif
@@ -850,6 +850,8 @@ static int cmdq_request(struct mmc_host *mmc, struct mmc_request *mrq)
 		}
 	}
 
+	sdhci_msm_bus_demand_start(host, blk_rq_bytes(mrq->req));
+
 	/* PM QoS */
 	sdhci_msm_pm_qos_irq_vote(host);
 	cmdq_pm_qos_vote(host, mrq);
@@ -1297,6 +1299,7 @@ static void cmdq_post_req(struct mmc_host *mmc, int tag, int err)
 			data->bytes_xfered = 0;
 		else
 			data->bytes_xfered = blk_rq_bytes(mrq->req);
+		sdhci_msm_bus_demand_done(sdhci_host, data->bytes_xfered);
 
 		/* we're in atomic context (soft-irq) so unvote async. */
 		sdhci_msm_pm_qos_irq_unvote(sdhci_host, true);
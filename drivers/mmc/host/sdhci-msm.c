@@ -35,6 +35,7 @@
 #include <linux/mmc/slot-gpio.h>
 #include <linux/dma-mapping.h>
 #include <linux/iopoll.h>
+#include <linux/math64.h>
 #include <linux/pinctrl/consumer.h>
 #include <linux/msm-bus.h>
 #include <linux/proc_fs.h>
@@ -344,6 +345,19 @@ module_param(disable_slots, int, S_IRUGO|S_IWUSR);
 static bool nocmdq;
 module_param(nocmdq, bool, S_IRUGO|S_IWUSR);
 
+/* Demand based bus voting, see sdhci_msm_bus_demand_work() */
+static unsigned int adaptive_bus_qd = 4;
+module_param(adaptive_bus_qd, uint, S_IRUGO|S_IWUSR);
+
+static unsigned int adaptive_bus_burst_kb = 256;
+module_param(adaptive_bus_burst_kb, uint, S_IRUGO|S_IWUSR);
+
+static unsigned int adaptive_bus_window_ms = 20;
+module_param(adaptive_bus_window_ms, uint, S_IRUGO|S_IWUSR);
+
+static unsigned int adaptive_bus_hold_ms = 100;
+module_param(adaptive_bus_hold_ms, uint, S_IRUGO|S_IWUSR);
+
 enum vdd_io_level {
 	/* set vdd_io_data->low_vol_level */
 	VDD_IO_LOW,
@@ -2182,6 +2196,9 @@ static void sdhci_msm_bus_cancel_work_and_set_vote(struct sdhci_host *host,
 	cancel_delayed_work_sync(&msm_host->msm_bus_vote.vote_work);
 	spin_lock_irqsave(&host->lock, flags);
 	vote = sdhci_msm_bus_get_vote_for_bw(msm_host, bw);
+	if (bw && msm_host->msm_bus_vote.adaptive &&
+	    !msm_host->msm_bus_vote.is_max_bw_needed)
+		vote = min(vote, READ_ONCE(msm_host->msm_bus_vote.demand_vote));
 	sdhci_msm_bus_set_vote(msm_host, vote, &flags);
 	spin_unlock_irqrestore(&host->lock, flags);
 }
@@ -2204,6 +2221,153 @@ static void sdhci_msm_bus_queue_work(struct sdhci_host *host)
 	spin_unlock_irqrestore(&host->lock, flags);
 }
 
+/*
+ * Demand based bus voting.
+ *
+ * The clock derived vote is what the controller needs when it transfers
+ * all the time, which it rarely does. With adaptive voting enabled that
+ * vote is capped by the demand: a deep queue or a large transfer raises
+ * the cap to the maximum at once, a window whose throughput needs more
+ * raises it to that level, and it is only lowered one level per hold
+ * period once the measured throughput no longer needs it.
+ */
+
+/*
+ * Close the measurement window if it is complete. The vote is taken for
+ * twice the measured throughput, so a bus saturated at the current level
+ * asks for the next one. Called with demand_lock held.
+ */
+static bool sdhci_msm_bus_demand_sample(struct sdhci_msm_host *msm_host,
+					ktime_t now)
+{
+	struct sdhci_msm_bus_vote *bv = &msm_host->msm_bus_vote;
+	s64 elapsed = ktime_to_ns(ktime_sub(now, bv->window_start));
+	u64 bw;
+
+	if (elapsed < (s64)adaptive_bus_window_ms * NSEC_PER_MSEC ||
+	    elapsed <= 0)
+		return false;
+
+	bw = div64_u64(bv->window_bytes * 2 * NSEC_PER_SEC, elapsed);
+	bv->window_vote = max(bv->low_bw_vote,
+		sdhci_msm_bus_get_vote_for_bw(msm_host,
+				(unsigned int)min_t(u64, bw, UINT_MAX)));
+	bv->window_bytes = 0;
+	bv->window_start = now;
+
+	return true;
+}
+
+/* Called with demand_lock held */
+static void sdhci_msm_bus_demand_raise(struct sdhci_msm_bus_vote *bv,
+				       int vote)
+{
+	if (vote < bv->demand_vote)
+		return;
+
+	bv->hold_until = jiffies + msecs_to_jiffies(adaptive_bus_hold_ms);
+	if (vote > bv->demand_vote) {
+		WRITE_ONCE(bv->demand_vote, vote);
+		mod_delayed_work(system_highpri_wq, &bv->demand_work, 0);
+	}
+}
+
+/**
+ * sdhci_msm_bus_demand_start - account a data request being issued
+ * @host: the sdhci host
+ * @bytes: size of the transfer
+ *
+ * May be called from atomic context.
+ */
+void sdhci_msm_bus_demand_start(struct sdhci_host *host, unsigned int bytes)
+{
+	struct sdhci_pltfm_host *pltfm_host = sdhci_priv(host);
+	struct sdhci_msm_host *msm_host = pltfm_host->priv;
+	struct sdhci_msm_bus_vote *bv = &msm_host->msm_bus_vote;
+	unsigned long flags;
+
+	if (!bv->adaptive)
+		return;
+
+	spin_lock_irqsave(&bv->demand_lock, flags);
+	bv->inflight++;
+	if (bv->inflight >= adaptive_bus_qd ||
+	    bytes >= adaptive_bus_burst_kb * 1024)
+		sdhci_msm_bus_demand_raise(bv, bv->max_bw_vote);
+	spin_unlock_irqrestore(&bv->demand_lock, flags);
+}
+
+/**
+ * sdhci_msm_bus_demand_done - account a data request being completed
+ * @host: the sdhci host
+ * @bytes: bytes transferred
+ *
+ * May be called from atomic context.
+ */
+void sdhci_msm_bus_demand_done(struct sdhci_host *host, unsigned int bytes)
+{
+	struct sdhci_pltfm_host *pltfm_host = sdhci_priv(host);
+	struct sdhci_msm_host *msm_host = pltfm_host->priv;
+	struct sdhci_msm_bus_vote *bv = &msm_host->msm_bus_vote;
+	unsigned long flags;
+
+	if (!bv->adaptive)
+		return;
+
+	spin_lock_irqsave(&bv->demand_lock, flags);
+	if (bv->inflight)
+		bv->inflight--;
+	bv->window_bytes += bytes;
+	if (sdhci_msm_bus_demand_sample(msm_host, ktime_get()))
+		sdhci_msm_bus_demand_raise(bv, bv->window_vote);
+	spin_unlock_irqrestore(&bv->demand_lock, flags);
+}
+
+/*
+ * Internal work. Applies the demand vote while the clocks are on and
+ * lowers it one level per hold period once the demand has dropped.
+ */
+static void sdhci_msm_bus_demand_work(struct work_struct *work)
+{
+	struct sdhci_msm_host *msm_host;
+	struct sdhci_msm_bus_vote *bv;
+	struct sdhci_host *host;
+	unsigned long flags;
+	int vote, clk_vote;
+	bool lower;
+
+	msm_host = container_of(work, struct sdhci_msm_host,
+				msm_bus_vote.demand_work.work);
+	bv = &msm_host->msm_bus_vote;
+	host = platform_get_drvdata(msm_host->pdev);
+
+	spin_lock_irqsave(&bv->demand_lock, flags);
+	sdhci_msm_bus_demand_sample(msm_host, ktime_get());
+	if (time_after_eq(jiffies, bv->hold_until) &&
+	    bv->window_vote < bv->demand_vote && bv->inflight < adaptive_bus_qd) {
+		WRITE_ONCE(bv->demand_vote, bv->demand_vote - 1);
+		bv->hold_until = jiffies +
+			msecs_to_jiffies(adaptive_bus_hold_ms);
+	}
+	vote = bv->demand_vote;
+	lower = bv->adaptive && vote > bv->low_bw_vote;
+	spin_unlock_irqrestore(&bv->demand_lock, flags);
+
+	spin_lock_irqsave(&host->lock, flags);
+	/* With the clocks off the vote is owned by sdhci_msm_bus_voting() */
+	if (bv->adaptive && !bv->is_max_bw_needed &&
+	    atomic_read(&msm_host->clks_on)) {
+		clk_vote = sdhci_msm_bus_get_vote_for_bw(msm_host,
+				sdhci_get_bw_required(host, &host->mmc->ios));
+		sdhci_msm_bus_set_vote(msm_host, min(vote, clk_vote), &flags);
+	}
+	spin_unlock_irqrestore(&host->lock, flags);
+
+	if (lower)
+		queue_delayed_work(system_wq, &bv->demand_work,
+				   msecs_to_jiffies(adaptive_bus_hold_ms));
+}
+
 static int sdhci_msm_bus_register(struct sdhci_msm_host *host,
 				struct platform_device *pdev)
 {
@@ -2251,6 +2415,10 @@ static int sdhci_msm_bus_register(struct sdhci_msm_host *host,
 				sdhci_msm_bus_get_vote_for_bw(host, 0);
 		host->msm_bus_vote.max_bw_vote =
 				sdhci_msm_bus_get_vote_for_bw(host, UINT_MAX);
+		/* lowest non-zero vote, the floor while transferring */
+		host->msm_bus_vote.low_bw_vote =
+				sdhci_msm_bus_get_vote_for_bw(host, 1);
+		host->msm_bus_vote.demand_vote = host->msm_bus_vote.max_bw_vote;
 	} else {
 		devm_kfree(dev, data);
 	}
@@ -2838,6 +3006,65 @@ store_sdhci_max_bus_bw(struct device *dev, struct device_attribute *attr,
 	return count;
 }
 
+static ssize_t
+show_sdhci_adaptive_bus_bw(struct device *dev, struct device_attribute *attr,
+			char *buf)
+{
+	struct sdhci_host *host = dev_get_drvdata(dev);
+	struct sdhci_pltfm_host *pltfm_host = sdhci_priv(host);
+	struct sdhci_msm_host *msm_host = pltfm_host->priv;
+	struct sdhci_msm_bus_vote *bv = &msm_host->msm_bus_vote;
+
+	return snprintf(buf, PAGE_SIZE, "%u vote %d/%d curr %u\n",
+			bv->adaptive, READ_ONCE(bv->demand_vote),
+			bv->max_bw_vote, bv->curr_vote);
+}
+
+static ssize_t
+store_sdhci_adaptive_bus_bw(struct device *dev, struct device_attribute *attr,
+		const char *buf, size_t count)
+{
+	struct sdhci_host *host = dev_get_drvdata(dev);
+	struct sdhci_pltfm_host *pltfm_host = sdhci_priv(host);
+	struct sdhci_msm_host *msm_host = pltfm_host->priv;
+	struct sdhci_msm_bus_vote *bv = &msm_host->msm_bus_vote;
+	unsigned long flags;
+	bool value;
+
+	if (!bv->client_handle)
+		return -ENODEV;
+
+	if (strtobool(buf, &value))
+		return -EINVAL;
+
+	if (value == bv->adaptive)
+		return count;
+
+	if (value) {
+		/* start from the maximum and let the demand bring it down */
+		spin_lock_irqsave(&bv->demand_lock, flags);
+		bv->inflight = 0;
+		bv->window_bytes = 0;
+		bv->window_start = ktime_get();
+		bv->window_vote = bv->max_bw_vote;
+		bv->demand_vote = bv->max_bw_vote;
+		bv->hold_until = jiffies +
+			msecs_to_jiffies(adaptive_bus_hold_ms);
+		bv->adaptive = true;
+		spin_unlock_irqrestore(&bv->demand_lock, flags);
+		queue_delayed_work(system_wq, &bv->demand_work,
+				   msecs_to_jiffies(adaptive_bus_hold_ms));
+	} else {
+		bv->adaptive = false;
+		cancel_delayed_work_sync(&bv->demand_work);
+		/* back to the clock derived vote */
+		if (atomic_read(&msm_host->clks_on))
+			sdhci_msm_bus_voting(host, 1);
+	}
+
+	return count;
+}
+
 static void sdhci_msm_check_power_status(struct sdhci_host *host, u32 req_type)
 {
 	struct sdhci_pltfm_host *pltfm_host = sdhci_priv(host);
@@ -4077,6 +4304,10 @@ static void sdhci_msm_pre_req(struct sdhci_host *host,
 	int prev_group = sdhci_msm_get_cpu_group(msm_host,
 			msm_host->pm_qos_prev_cpu);
 
+	if (mmc_req->data)
+		sdhci_msm_bus_demand_start(host,
+			mmc_req->data->blksz * mmc_req->data->blocks);
+
 	sdhci_msm_pm_qos_irq_vote(host);
 
 	cpu = get_cpu();
@@ -4104,6 +4335,9 @@ static void sdhci_msm_post_req(struct sdhci_host *host,
 	struct sdhci_pltfm_host *pltfm_host = sdhci_priv(host);
 	struct sdhci_msm_host *msm_host = pltfm_host->priv;
 
+	if (mmc_req->data)
+		sdhci_msm_bus_demand_done(host, mmc_req->data->bytes_xfered);
+
 	sdhci_msm_pm_qos_irq_unvote(host, false);
 
 	if (sdhci_msm_pm_qos_cpu_unvote(host, msm_host->pm_qos_prev_cpu, false))
@@ -4512,9 +4746,13 @@ static int sdhci_msm_probe(struct platform_device *pdev)
 	if (ret)
 		goto sleep_clk_disable;
 
-	if (msm_host->msm_bus_vote.client_handle)
+	if (msm_host->msm_bus_vote.client_handle) {
 		INIT_DELAYED_WORK(&msm_host->msm_bus_vote.vote_work,
 				  sdhci_msm_bus_work);
+		INIT_DELAYED_WORK(&msm_host->msm_bus_vote.demand_work,
+				  sdhci_msm_bus_demand_work);
+		spin_lock_init(&msm_host->msm_bus_vote.demand_lock);
+	}
 	sdhci_msm_bus_voting(host, 1);
 
 	/* Setup regulators */
@@ -4791,6 +5029,9 @@ static int sdhci_msm_probe(struct platform_device *pdev)
 	pm_runtime_enable(&pdev->dev);
 	pm_runtime_set_autosuspend_delay(&pdev->dev, MSM_AUTOSUSPEND_DELAY_MS);
 	pm_runtime_use_autosuspend(&pdev->dev);
+	/* card re-init on resume must not hold up the rest of the system */
+	if (IS_ENABLED(CONFIG_MMC_SDHCI_MSM_ASYNC_SUSPEND))
+		device_enable_async_suspend(&pdev->dev);
 
 	msm_host->msm_bus_vote.max_bus_bw.show = show_sdhci_max_bus_bw;
 	msm_host->msm_bus_vote.max_bus_bw.store = store_sdhci_max_bus_bw;
@@ -4802,6 +5043,18 @@ static int sdhci_msm_probe(struct platform_device *pdev)
 	if (ret)
 		goto remove_host;
 
+	msm_host->msm_bus_vote.adaptive_bus_bw.show =
+		show_sdhci_adaptive_bus_bw;
+	msm_host->msm_bus_vote.adaptive_bus_bw.store =
+		store_sdhci_adaptive_bus_bw;
+	sysfs_attr_init(&msm_host->msm_bus_vote.adaptive_bus_bw.attr);
+	msm_host->msm_bus_vote.adaptive_bus_bw.attr.name = "adaptive_bus_bw";
+	msm_host->msm_bus_vote.adaptive_bus_bw.attr.mode = S_IRUGO | S_IWUSR;
+	ret = device_create_file(&pdev->dev,
+			&msm_host->msm_bus_vote.adaptive_bus_bw);
+	if (ret)
+		goto remove_max_bus_bw_file;
+
 	if (!gpio_is_valid(msm_host->pdata->status_gpio)) {
 		msm_host->polling.show = show_polling;
 		msm_host->polling.store = store_polling;
@@ -4810,7 +5063,7 @@ static int sdhci_msm_probe(struct platform_device *pdev)
 		msm_host->polling.attr.mode = S_IRUGO | S_IWUSR;
 		ret = device_create_file(&pdev->dev, &msm_host->polling);
 		if (ret)
-			goto remove_max_bus_bw_file;
+			goto remove_adaptive_bus_bw_file;
 	}
 
 	msm_host->auto_cmd21_attr.show = show_auto_cmd21;
@@ -4838,6 +5091,9 @@ static int sdhci_msm_probe(struct platform_device *pdev)
 	/* Successful initialization */
 	goto out;
 
+remove_adaptive_bus_bw_file:
+	device_remove_file(&pdev->dev,
+			&msm_host->msm_bus_vote.adaptive_bus_bw);
 remove_max_bus_bw_file:
 	device_remove_file(&pdev->dev, &msm_host->msm_bus_vote.max_bus_bw);
 remove_host:
@@ -4886,6 +5142,8 @@ static int sdhci_msm_remove(struct platform_device *pdev)
 	pr_debug("%s: %s\n", dev_name(&pdev->dev), __func__);
 	if (!gpio_is_valid(msm_host->pdata->status_gpio))
 		device_remove_file(&pdev->dev, &msm_host->polling);
+	device_remove_file(&pdev->dev,
+			&msm_host->msm_bus_vote.adaptive_bus_bw);
 	device_remove_file(&pdev->dev, &msm_host->msm_bus_vote.max_bus_bw);
 	pm_runtime_disable(&pdev->dev);
 	sdhci_remove_host(host, dead);
@@ -4897,6 +5155,8 @@ static int sdhci_msm_remove(struct platform_device *pdev)
 	sdhci_msm_setup_pins(pdata, false);
 
 	if (msm_host->msm_bus_vote.client_handle) {
+		msm_host->msm_bus_vote.adaptive = false;
+		cancel_delayed_work_sync(&msm_host->msm_bus_vote.demand_work);
 		sdhci_msm_bus_cancel_work_and_set_vote(host, 0);
 		sdhci_msm_bus_unregister(msm_host);
 	}
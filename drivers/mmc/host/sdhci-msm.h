@@ -164,6 +164,21 @@ struct sdhci_msm_bus_vote {
 	bool is_max_bw_needed;
 	struct delayed_work vote_work;
 	struct device_attribute max_bus_bw;
+	/*
+	 * Demand based voting: the clock derived vote is capped by what the
+	 * recent queue depth and throughput need.
+	 */
+	bool adaptive;
+	int low_bw_vote;
+	int demand_vote;
+	int window_vote;
+	spinlock_t demand_lock;
+	unsigned int inflight;
+	u64 window_bytes;
+	ktime_t window_start;
+	unsigned long hold_until;
+	struct delayed_work demand_work;
+	struct device_attribute adaptive_bus_bw;
 };
 
 struct sdhci_msm_ice_data {
@@ -243,5 +258,8 @@ void sdhci_msm_pm_qos_cpu_vote(struct sdhci_host *host,
 		struct sdhci_msm_pm_qos_latency *latency, int cpu);
 bool sdhci_msm_pm_qos_cpu_unvote(struct sdhci_host *host, int cpu, bool async);
 
+void sdhci_msm_bus_demand_start(struct sdhci_host *host, unsigned int bytes);
+void sdhci_msm_bus_demand_done(struct sdhci_host *host, unsigned int bytes);
+
 
 #endif /* __SDHCI_MSM_H__ */
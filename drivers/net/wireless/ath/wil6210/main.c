@@ -555,6 +555,7 @@ int wil_priv_init(struct wil6210_priv *wil)
 	INIT_LIST_HEAD(&wil->probe_client_pending);
 	spin_lock_init(&wil->wmi_ev_lock);
 	spin_lock_init(&wil->net_queue_lock);
+	skb_queue_head_init(&wil->rx_recycle);
 	wil->net_queue_stopped = 1;
 	init_waitqueue_head(&wil->wq);
 
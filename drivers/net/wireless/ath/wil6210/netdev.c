@@ -23,6 +23,10 @@ static bool alt_ifname; /* = false; */
 module_param(alt_ifname, bool, S_IRUGO);
 MODULE_PARM_DESC(alt_ifname, " use an alternate interface name wigigN instead of wlanN");
 
+static bool napi_threaded; /* = false; */
+module_param(napi_threaded, bool, 0444);
+MODULE_PARM_DESC(napi_threaded, " poll Rx/Tx NAPI from kernel threads instead of softirq");
+
 static int wil_open(struct net_device *ndev)
 {
 	struct wil6210_priv *wil = ndev_to_wil(ndev);
@@ -235,6 +239,8 @@ int wil_if_add(struct wil6210_priv *wil)
 		       WIL6210_NAPI_BUDGET);
 	netif_napi_add(ndev, &wil->napi_tx, wil6210_netdev_poll_tx,
 		       WIL6210_NAPI_BUDGET);
+	if (napi_threaded && dev_set_threaded(ndev, true))
+		wil_err(wil, "failed to enable threaded NAPI\n");
 
 	wil_update_net_queues_bh(wil, NULL, true);
 
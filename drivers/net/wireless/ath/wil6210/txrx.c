@@ -41,6 +41,14 @@ bool rx_large_buf;
 module_param(rx_large_buf, bool, 0444);
 MODULE_PARM_DESC(rx_large_buf, " allocate 8KB RX buffers, default - no");
 
+static bool tx_doorbell_batch = true;
+module_param(tx_doorbell_batch, bool, 0644);
+MODULE_PARM_DESC(tx_doorbell_batch,
+		 " defer the Tx doorbell while the stack has more frames, default - yes");
+
+/* max. number of dropped Rx buffers kept for reuse */
+#define WIL_RX_RECYCLE_MAX 64
+
 static inline uint wil_rx_snaplen(void)
 {
 	return rx_align_2 ? 6 : 0;
@@ -308,12 +316,24 @@ static int wil_vring_alloc_skb(struct wil6210_priv *wil, struct vring *vring,
 	struct vring_rx_desc dd, *d = &dd;
 	volatile struct vring_rx_desc *_d = &vring->va[i].rx;
 	dma_addr_t pa;
-	struct sk_buff *skb = dev_alloc_skb(sz + headroom);
+	struct sk_buff *skb = skb_dequeue(&wil->rx_recycle);
 
-	if (unlikely(!skb))
-		return -ENOMEM;
+	/* recycled buffers were never modified beyond their length */
+	if (skb && (skb_headroom(skb) != NET_SKB_PAD + headroom ||
+		    skb_end_offset(skb) - skb_headroom(skb) < sz)) {
+		kfree_skb(skb);
+		skb = NULL;
+	}
+
+	if (skb) {
+		skb_trim(skb, 0);
+	} else {
+		skb = dev_alloc_skb(sz + headroom);
+		if (unlikely(!skb))
+			return -ENOMEM;
 
-	skb_reserve(skb, headroom);
+		skb_reserve(skb, headroom);
+	}
 	skb_put(skb, sz);
 
 	pa = dma_map_single(dev, skb->data, skb->len, DMA_FROM_DEVICE);
@@ -470,6 +490,21 @@ bool wil_is_rx_idle(struct wil6210_priv *wil)
  *
  * Safe to call from IRQ
  */
+/**
+ * Keep an Rx buffer that is dropped before being handed to the stack,
+ * so wil_vring_alloc_skb() can post it again without an allocation
+ */
+static void wil_rx_recycle(struct wil6210_priv *wil, struct sk_buff *skb)
+{
+	if (skb_queue_len(&wil->rx_recycle) >= WIL_RX_RECYCLE_MAX ||
+	    skb_shared(skb) || skb_cloned(skb)) {
+		kfree_skb(skb);
+		return;
+	}
+
+	skb_queue_tail(&wil->rx_recycle, skb);
+}
+
 static struct sk_buff *wil_vring_reap_rx(struct wil6210_priv *wil,
 					 struct vring *vring)
 {
@@ -525,7 +560,7 @@ again:
 	if (unlikely(dmalen > sz)) {
 		wil_err(wil, "Rx size too large: %d bytes!\n", dmalen);
 		stats->rx_large_frame++;
-		kfree_skb(skb);
+		wil_rx_recycle(wil, skb);
 		goto again;
 	}
 	skb_trim(skb, dmalen);
@@ -578,14 +613,14 @@ again:
 			wil_hex_dump_txrx("Rx ", DUMP_PREFIX_OFFSET, 16, 1,
 					  skb->data, skb_headlen(skb), false);
 		}
-		kfree_skb(skb);
+		wil_rx_recycle(wil, skb);
 		goto again;
 	}
 
 	if (unlikely(skb->len < ETH_HLEN + snaplen)) {
 		wil_err(wil, "Short frame, len = %d\n", skb->len);
 		stats->rx_short_frame++;
-		kfree_skb(skb);
+		wil_rx_recycle(wil, skb);
 		goto again;
 	}
 
@@ -897,6 +932,8 @@ void wil_rx_fini(struct wil6210_priv *wil)
 
 	if (vring->va)
 		wil_vring_free(wil, vring, 0);
+
+	skb_queue_purge(&wil->rx_recycle);
 }
 
 static inline void wil_tx_data_init(struct vring_tx_data *txdata)
@@ -911,6 +948,7 @@ static inline void wil_tx_data_init(struct vring_tx_data *txdata)
 	txdata->agg_timeout = 0;
 	txdata->agg_amsdu = 0;
 	txdata->addba_in_progress = false;
+	txdata->doorbell_pending = false;
 	spin_unlock_bh(&txdata->lock);
 }
 
@@ -1684,12 +1722,7 @@ static int __wil_tx_vring_tso(struct wil6210_priv *wil, struct vring *vring,
 	wil_vring_advance_head(vring, descs_used);
 	wil_dbg_txrx(wil, "TSO: Tx swhead %d -> %d\n", swhead, vring->swhead);
 
-	/* make sure all writes to descriptors (shared memory) are done before
-	 * committing them to HW
-	 */
-	wmb();
-
-	wil_w(wil, vring->hwtail, vring->swhead);
+	/* doorbell is rung by wil_tx_vring() */
 	return 0;
 
 mem_error:
@@ -1833,13 +1866,7 @@ static int __wil_tx_vring(struct wil6210_priv *wil, struct vring *vring,
 		     vring->swhead);
 	trace_wil6210_tx(vring_index, swhead, skb->len, nr_frags);
 
-	/* make sure all writes to descriptors (shared memory) are done before
-	 * committing them to HW
-	 */
-	wmb();
-
-	wil_w(wil, vring->hwtail, vring->swhead);
-
+	/* doorbell is rung by wil_tx_vring() */
 	return 0;
  dma_error:
 	/* unmap what we have mapped */
@@ -1880,12 +1907,60 @@ static int wil_tx_vring(struct wil6210_priv *wil, struct vring *vring,
 
 	rc = (skb_is_gso(skb) ? __wil_tx_vring_tso : __wil_tx_vring)
 	     (wil, vring, skb);
+	if (unlikely(rc))
+		goto out;
+
+	/* The stack has more frames for us: leave the doorbell to the last
+	 * of them, unless the net queues are about to be stopped and there
+	 * may be no next frame.
+	 */
+	if (tx_doorbell_batch && skb->xmit_more &&
+	    !wil_vring_avail_low(vring) &&
+	    !netif_xmit_stopped(skb_get_tx_queue(wil_to_ndev(wil), skb))) {
+		txdata->doorbell_pending = true;
+		goto out;
+	}
 
+	/* make sure all writes to descriptors (shared memory) are done before
+	 * committing them to HW
+	 */
+	wmb();
+
+	wil_w(wil, vring->hwtail, vring->swhead);
+	txdata->doorbell_pending = false;
+out:
 	spin_unlock(&txdata->lock);
 
 	return rc;
 }
 
+/**
+ * Ring the doorbell of every vring with descriptors not yet committed.
+ * Called when a burst ends, or when the net queues get stopped and the
+ * stack may not deliver the last frame of the burst.
+ */
+static void wil_tx_flush_doorbells(struct wil6210_priv *wil)
+{
+	struct vring_tx_data *txdata;
+	struct vring *vring;
+	int i;
+
+	for (i = 0; i < WIL6210_MAX_TX_RINGS; i++) {
+		txdata = &wil->vring_tx_data[i];
+		if (!READ_ONCE(txdata->doorbell_pending))
+			continue;
+
+		vring = &wil->vring_tx[i];
+		spin_lock_bh(&txdata->lock);
+		if (txdata->doorbell_pending && vring->va) {
+			wmb();
+			wil_w(wil, vring->hwtail, vring->swhead);
+		}
+		txdata->doorbell_pending = false;
+		spin_unlock_bh(&txdata->lock);
+	}
+}
+
 /**
  * Check status of tx vrings and stop/wake net queues if needed
  *
@@ -1972,6 +2047,9 @@ void wil_update_net_queues_bh(struct wil6210_priv *wil, struct vring *vring,
 	spin_lock_bh(&wil->net_queue_lock);
 	__wil_update_net_queues(wil, vring, check_stop);
 	spin_unlock_bh(&wil->net_queue_lock);
+
+	if (check_stop && wil->net_queue_stopped)
+		wil_tx_flush_doorbells(wil);
 }
 
 netdev_tx_t wil_start_xmit(struct sk_buff *skb, struct net_device *ndev)
@@ -1979,6 +2057,7 @@ netdev_tx_t wil_start_xmit(struct sk_buff *skb, struct net_device *ndev)
 	struct wil6210_priv *wil = ndev_to_wil(ndev);
 	struct ethhdr *eth = (void *)skb->data;
 	bool bcast = is_multicast_ether_addr(eth->h_dest);
+	bool more = skb->xmit_more;
 	struct vring *vring;
 	static bool pr_once_fw;
 	int rc;
@@ -2036,8 +2115,12 @@ netdev_tx_t wil_start_xmit(struct sk_buff *skb, struct net_device *ndev)
 		wil_update_net_queues_bh(wil, vring, true);
 		/* statistics will be updated on the tx_complete */
 		dev_kfree_skb_any(skb);
+		if (!more)
+			wil_tx_flush_doorbells(wil);
 		return NETDEV_TX_OK;
 	case -ENOMEM:
+		/* the stack retries this frame later, commit what we have */
+		wil_tx_flush_doorbells(wil);
 		return NETDEV_TX_BUSY;
 	default:
 		break; /* goto drop; */
@@ -2045,6 +2128,8 @@ netdev_tx_t wil_start_xmit(struct sk_buff *skb, struct net_device *ndev)
  drop:
 	ndev->stats.tx_dropped++;
 	dev_kfree_skb_any(skb);
+	if (!more)
+		wil_tx_flush_doorbells(wil);
 
 	return NET_XMIT_DROP;
 }
@@ -424,6 +424,7 @@ struct vring_tx_data {
 	u16 agg_timeout;
 	u8 agg_amsdu;
 	bool addba_in_progress; /* if set, agg_xxx is for request in progress */
+	bool doorbell_pending; /* descriptors posted, hwtail not written yet */
 	spinlock_t lock;
 };
 
@@ -686,6 +687,7 @@ struct wil6210_priv {
 	struct work_struct probe_client_worker;
 	/* DMA related */
 	struct vring vring_rx;
+	struct sk_buff_head rx_recycle; /* dropped Rx buffers for reuse */
 	unsigned int rx_buf_len;
 	struct vring vring_tx[WIL6210_MAX_TX_RINGS];
 	struct vring_tx_data vring_tx_data[WIL6210_MAX_TX_RINGS];
@@ -17,6 +17,7 @@
 #include <linux/etherdevice.h>
 #include <linux/msm-bus.h>
 #include <linux/pm_qos.h>
+#include <linux/shrinker.h>
 #include <net/cnss2.h>
 #include <soc/qcom/memory_dump.h>
 #include <soc/qcom/subsystem_restart.h>
@@ -114,6 +115,13 @@ struct cnss_fw_mem {
 	bool valid;
 };
 
+struct cnss_bdf_cache {
+	struct mutex lock; /* serializes BDF download against the shrinker */
+	const struct firmware *fw;
+	u32 board_id;
+	struct shrinker shrinker;
+};
+
 enum cnss_driver_event_type {
 	CNSS_DRIVER_EVENT_SERVER_ARRIVE,
 	CNSS_DRIVER_EVENT_SERVER_EXIT,
@@ -200,6 +208,7 @@ struct cnss_plat_data {
 	struct wlfw_fw_version_info_s_v01 fw_version_info;
 	struct cnss_fw_mem fw_mem;
 	struct cnss_fw_mem m3_mem;
+	struct cnss_bdf_cache bdf_cache;
 	struct cnss_pin_connect_result pin_result;
 	struct dentry *root_dentry;
 	atomic_t pm_count;
@@ -432,6 +432,65 @@ out:
 	return ret;
 }
 
+/*
+ * The BDF only depends on the board ID, so keep the last one around to
+ * avoid going back to the filesystem on every WLAN on/off and SSR.
+ * Called with bdf_cache.lock held.
+ */
+static int cnss_bdf_cache_get(struct cnss_plat_data *plat_priv,
+			      const char *filename,
+			      const struct firmware **fw_entry)
+{
+	struct cnss_bdf_cache *cache = &plat_priv->bdf_cache;
+	int ret;
+
+	if (cache->fw && cache->board_id == plat_priv->board_info.board_id) {
+		*fw_entry = cache->fw;
+		return 0;
+	}
+
+	release_firmware(cache->fw);
+	cache->fw = NULL;
+
+	ret = request_firmware(fw_entry, filename, &plat_priv->plat_dev->dev);
+	if (ret)
+		return ret;
+
+	cache->fw = *fw_entry;
+	cache->board_id = plat_priv->board_info.board_id;
+	return 0;
+}
+
+static unsigned long cnss_bdf_cache_count(struct shrinker *shrinker,
+					  struct shrink_control *sc)
+{
+	struct cnss_bdf_cache *cache =
+		container_of(shrinker, struct cnss_bdf_cache, shrinker);
+
+	return cache->fw ? 1 : 0;
+}
+
+static unsigned long cnss_bdf_cache_scan(struct shrinker *shrinker,
+					 struct shrink_control *sc)
+{
+	struct cnss_bdf_cache *cache =
+		container_of(shrinker, struct cnss_bdf_cache, shrinker);
+	unsigned long freed = 0;
+
+	/* a download in progress is using the blob */
+	if (!mutex_trylock(&cache->lock))
+		return SHRINK_STOP;
+
+	if (cache->fw) {
+		release_firmware(cache->fw);
+		cache->fw = NULL;
+		freed = 1;
+	}
+	mutex_unlock(&cache->lock);
+
+	return freed;
+}
+
 int cnss_wlfw_bdf_dnld_send_sync(struct cnss_plat_data *plat_priv)
 {
 	struct wlfw_bdf_download_req_msg_v01 *req;
@@ -459,7 +518,8 @@ int cnss_wlfw_bdf_dnld_send_sync(struct cnss_plat_data *plat_priv)
 			 BDF_FILE_NAME_PREFIX "%02x",
 			 plat_priv->board_info.board_id);
 
-	ret = request_firmware(&fw_entry, filename, &plat_priv->plat_dev->dev);
+	mutex_lock(&plat_priv->bdf_cache.lock);
+	ret = cnss_bdf_cache_get(plat_priv, filename, &fw_entry);
 	if (ret) {
 		cnss_pr_err("Failed to load BDF: %s\n", filename);
 		if (bdf_bypass) {
@@ -531,9 +591,8 @@ bypass_bdf:
 	}
 
 err_send:
-	if (!bdf_bypass)
-		release_firmware(fw_entry);
 err_req_fw:
+	mutex_unlock(&plat_priv->bdf_cache.lock);
 	kfree(req);
 out:
 	if (ret)
@@ -1021,15 +1080,35 @@ int cnss_qmi_init(struct cnss_plat_data *plat_priv)
 					      WLFW_SERVICE_VERS_V01,
 					      WLFW_SERVICE_INS_ID_V01,
 					      &plat_priv->qmi_wlfw_clnt_nb);
-	if (ret < 0)
+	if (ret < 0) {
 		cnss_pr_err("Failed to register QMI event notifier, err = %d\n",
 			    ret);
+		return ret;
+	}
+
+	mutex_init(&plat_priv->bdf_cache.lock);
+	plat_priv->bdf_cache.shrinker.count_objects = cnss_bdf_cache_count;
+	plat_priv->bdf_cache.shrinker.scan_objects = cnss_bdf_cache_scan;
+	plat_priv->bdf_cache.shrinker.seeks = DEFAULT_SEEKS;
+	ret = register_shrinker(&plat_priv->bdf_cache.shrinker);
+	if (ret) {
+		cnss_pr_err("Failed to register BDF cache shrinker, err = %d\n",
+			    ret);
+		qmi_svc_event_notifier_unregister(WLFW_SERVICE_ID_V01,
+						  WLFW_SERVICE_VERS_V01,
+						  WLFW_SERVICE_INS_ID_V01,
+						  &plat_priv->qmi_wlfw_clnt_nb);
+	}
 
 	return ret;
 }
 
 void cnss_qmi_deinit(struct cnss_plat_data *plat_priv)
 {
+	unregister_shrinker(&plat_priv->bdf_cache.shrinker);
+	release_firmware(plat_priv->bdf_cache.fw);
+	plat_priv->bdf_cache.fw = NULL;
+
 	qmi_svc_event_notifier_unregister(WLFW_SERVICE_ID_V01,
 					  WLFW_SERVICE_VERS_V01,
 					  WLFW_SERVICE_INS_ID_V01,
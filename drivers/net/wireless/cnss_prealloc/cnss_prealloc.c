@@ -18,6 +18,7 @@
 #include <linux/wcnss_wlan.h>
 #include <linux/spinlock.h>
 #include <linux/debugfs.h>
+#include <linux/hashtable.h>
 #include <net/cnss_prealloc.h>
 #ifdef CONFIG_WCNSS_SKB_PRE_ALLOC
 #include <linux/skbuff.h>
@@ -31,6 +32,12 @@ static DEFINE_SPINLOCK(alloc_lock);
 
 #define PRE_ALLOC_DEBUGFS_DIR		"cnss-prealloc"
 #define PRE_ALLOC_DEBUGFS_FILE_OBJ	"status"
+#define PRE_ALLOC_DEBUGFS_FILE_HIST	"histogram"
+
+/* distinct slot sizes, the slot table below must be sorted by size */
+#define WCNSS_PREALLOC_MAX_CLASSES	8
+/* request sizes in (2^(b-1), 2^b] bytes, the last bucket gets the rest */
+#define WCNSS_PREALLOC_HIST_BUCKETS	19
 
 static struct dentry *debug_base;
 
@@ -38,6 +45,10 @@ struct wcnss_prealloc {
 	int occupied;
 	size_t size;
 	void *ptr;
+	/* next free slot of the same size class, or -1 */
+	int next;
+	struct hlist_node node;
+	struct wcnss_prealloc_class *class;
 #ifdef CONFIG_SLUB_DEBUG
 	unsigned long stack_trace[WCNSS_MAX_STACK_TRACE];
 	struct stack_trace trace;
@@ -115,8 +126,46 @@ static struct wcnss_prealloc wcnss_allocs[] = {
 	{0, 128 * 1024, NULL},
 };
 
+/*
+ * The free slots of each size are kept on a list, so a request is served
+ * from the smallest class with a free slot without scanning the table,
+ * and a slot is found back from its address through a hash.
+ */
+struct wcnss_prealloc_class {
+	size_t size;
+	int free;
+	int nr_free;
+	int nr_slots;
+	/* requests of each size bucket served from this class */
+	unsigned long hits[WCNSS_PREALLOC_HIST_BUCKETS];
+};
+
+static struct wcnss_prealloc_class wcnss_classes[WCNSS_PREALLOC_MAX_CLASSES];
+static int wcnss_nr_classes;
+/* requests of each size bucket that could not be served */
+static unsigned long wcnss_misses[WCNSS_PREALLOC_HIST_BUCKETS];
+static DEFINE_HASHTABLE(wcnss_prealloc_hash, 7);
+
+static inline int wcnss_prealloc_bucket(size_t size)
+{
+	int b = size > 1 ? fls_long(size - 1) : 0;
+
+	return min(b, WCNSS_PREALLOC_HIST_BUCKETS - 1);
+}
+
+static inline void wcnss_prealloc_push(int i)
+{
+	struct wcnss_prealloc_class *class = wcnss_allocs[i].class;
+
+	wcnss_allocs[i].occupied = 0;
+	wcnss_allocs[i].next = class->free;
+	class->free = i;
+	class->nr_free++;
+}
+
 int wcnss_prealloc_init(void)
 {
+	struct wcnss_prealloc_class *class = NULL;
 	int i;
 
 	for (i = 0; i < ARRAY_SIZE(wcnss_allocs); i++) {
@@ -126,6 +175,26 @@ int wcnss_prealloc_init(void)
 			return -ENOMEM;
 	}
 
+	wcnss_nr_classes = 0;
+	for (i = 0; i < ARRAY_SIZE(wcnss_allocs); i++) {
+		if (!class || class->size != wcnss_allocs[i].size) {
+			BUG_ON(class && class->size > wcnss_allocs[i].size);
+			BUG_ON(wcnss_nr_classes == WCNSS_PREALLOC_MAX_CLASSES);
+			class = &wcnss_classes[wcnss_nr_classes++];
+			memset(class, 0, sizeof(*class));
+			class->size = wcnss_allocs[i].size;
+			class->free = -1;
+		}
+		wcnss_allocs[i].class = class;
+		class->nr_slots++;
+		hash_add(wcnss_prealloc_hash, &wcnss_allocs[i].node,
+			 (unsigned long)wcnss_allocs[i].ptr);
+	}
+
+	/* lowest slots first, as the table scan used to hand them out */
+	for (i = ARRAY_SIZE(wcnss_allocs) - 1; i >= 0; i--)
+		wcnss_prealloc_push(i);
+
 	return 0;
 }
 
@@ -134,9 +203,13 @@ void wcnss_prealloc_deinit(void)
 	int i = 0;
 
 	for (i = 0; i < ARRAY_SIZE(wcnss_allocs); i++) {
+		if (wcnss_allocs[i].class)
+			hash_del(&wcnss_allocs[i].node);
+		wcnss_allocs[i].class = NULL;
 		kfree(wcnss_allocs[i].ptr);
 		wcnss_allocs[i].ptr = NULL;
 	}
+	wcnss_nr_classes = 0;
 }
 
 #ifdef CONFIG_SLUB_DEBUG
@@ -163,22 +236,28 @@ static inline void wcnss_prealloc_save_stack_trace(struct wcnss_prealloc *entry)
 
 void *wcnss_prealloc_get(size_t size)
 {
-	int i = 0;
+	struct wcnss_prealloc_class *class;
+	int bucket = wcnss_prealloc_bucket(size);
+	int c, i;
 	unsigned long flags;
 
 	spin_lock_irqsave(&alloc_lock, flags);
-	for (i = 0; i < ARRAY_SIZE(wcnss_allocs); i++) {
-		if (wcnss_allocs[i].occupied)
+	for (c = 0; c < wcnss_nr_classes; c++) {
+		class = &wcnss_classes[c];
+		if (class->size < size || class->free < 0)
 			continue;
 
-		if (wcnss_allocs[i].size >= size) {
-			/* we found the slot */
-			wcnss_allocs[i].occupied = 1;
-			spin_unlock_irqrestore(&alloc_lock, flags);
-			wcnss_prealloc_save_stack_trace(&wcnss_allocs[i]);
-			return wcnss_allocs[i].ptr;
-		}
+		/* we found the slot */
+		i = class->free;
+		class->free = wcnss_allocs[i].next;
+		class->nr_free--;
+		class->hits[bucket]++;
+		wcnss_allocs[i].occupied = 1;
+		spin_unlock_irqrestore(&alloc_lock, flags);
+		wcnss_prealloc_save_stack_trace(&wcnss_allocs[i]);
+		return wcnss_allocs[i].ptr;
 	}
+	wcnss_misses[bucket]++;
 	spin_unlock_irqrestore(&alloc_lock, flags);
 
 	pr_err("wcnss: %s: prealloc not available for size: %zu\n",
@@ -190,13 +269,18 @@ EXPORT_SYMBOL(wcnss_prealloc_get);
 
 int wcnss_prealloc_put(void *ptr)
 {
-	int i = 0;
+	struct wcnss_prealloc *entry;
 	unsigned long flags;
 
+	if (!ptr)
+		return 0;
+
 	spin_lock_irqsave(&alloc_lock, flags);
-	for (i = 0; i < ARRAY_SIZE(wcnss_allocs); i++) {
-		if (wcnss_allocs[i].ptr == ptr) {
-			wcnss_allocs[i].occupied = 0;
+	hash_for_each_possible(wcnss_prealloc_hash, entry, node,
+			       (unsigned long)ptr) {
+		if (entry->ptr == ptr) {
+			if (entry->occupied)
+				wcnss_prealloc_push(entry - wcnss_allocs);
 			spin_unlock_irqrestore(&alloc_lock, flags);
 			return 1;
 		}
@@ -235,14 +319,17 @@ EXPORT_SYMBOL(wcnss_prealloc_check_memory_leak);
 int wcnss_pre_alloc_reset(void)
 {
 	int i, n = 0;
+	unsigned long flags;
 
+	spin_lock_irqsave(&alloc_lock, flags);
 	for (i = 0; i < ARRAY_SIZE(wcnss_allocs); i++) {
 		if (!wcnss_allocs[i].occupied)
 			continue;
 
-		wcnss_allocs[i].occupied = 0;
+		wcnss_prealloc_push(i);
 		n++;
 	}
+	spin_unlock_irqrestore(&alloc_lock, flags);
 
 	return n;
 }
@@ -303,6 +390,67 @@ static const struct file_operations prealloc_memory_stats_fops = {
 	.release = single_release,
 };
 
+/*
+ * Requests per size bucket, split by the slot size that served them.
+ * Requests served from a much larger class, or not at all, show which
+ * slots the pool is short of and which ones are never needed.
+ */
+static int prealloc_histogram_show(struct seq_file *fp, void *data)
+{
+	unsigned long hits[WCNSS_PREALLOC_MAX_CLASSES], misses;
+	int b, c;
+	unsigned long flags;
+	bool used;
+
+	seq_puts(fp, "Request(b) <=");
+	for (c = 0; c < wcnss_nr_classes; c++)
+		seq_printf(fp, "\t%zuKb", wcnss_classes[c].size / 1024);
+	seq_puts(fp, "\tFailed\n");
+
+	for (b = 0; b < WCNSS_PREALLOC_HIST_BUCKETS; b++) {
+		used = false;
+		spin_lock_irqsave(&alloc_lock, flags);
+		for (c = 0; c < wcnss_nr_classes; c++) {
+			hits[c] = wcnss_classes[c].hits[b];
+			used |= hits[c] != 0;
+		}
+		misses = wcnss_misses[b];
+		spin_unlock_irqrestore(&alloc_lock, flags);
+
+		if (!used && !misses)
+			continue;
+
+		if (b == WCNSS_PREALLOC_HIST_BUCKETS - 1)
+			seq_puts(fp, "larger\t");
+		else
+			seq_printf(fp, "%lu\t", 1UL << b);
+		for (c = 0; c < wcnss_nr_classes; c++)
+			seq_printf(fp, "\t%lu", hits[c]);
+		seq_printf(fp, "\t%lu\n", misses);
+	}
+
+	seq_puts(fp, "\nSlot_Size(Kb)\t[Slots : Free]\n");
+	for (c = 0; c < wcnss_nr_classes; c++)
+		seq_printf(fp, "%zu Kb\t\t[%d : %d]\n",
+			   wcnss_classes[c].size / 1024,
+			   wcnss_classes[c].nr_slots, wcnss_classes[c].nr_free);
+
+	return 0;
+}
+
+static int prealloc_histogram_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, prealloc_histogram_show, NULL);
+}
+
+static const struct file_operations prealloc_histogram_fops = {
+	.owner = THIS_MODULE,
+	.open = prealloc_histogram_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
 static int __init wcnss_pre_alloc_init(void)
 {
 	int ret;
@@ -322,6 +470,9 @@ static int __init wcnss_pre_alloc_init(void)
 			&prealloc_memory_stats_fops))) {
 		pr_err("%s: Failed to create debugfs file\n", __func__);
 		debugfs_remove_recursive(debug_base);
+	} else {
+		debugfs_create_file(PRE_ALLOC_DEBUGFS_FILE_HIST, 0444,
+				    debug_base, NULL, &prealloc_histogram_fops);
 	}
 
 	return ret;
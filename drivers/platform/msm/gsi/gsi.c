@@ -22,6 +22,8 @@
 #include "gsi_reg.h"
 
 #define GSI_CMD_TIMEOUT 5000
+#define GSI_MOD_WINDOW_MS 20
+#define GSI_MOD_MAX_LEVEL 5
 #define GSI_STOP_CMD_TIMEOUT_MS 20
 #define GSI_MAX_CH_LOW_WEIGHT 15
 #define GSI_MHI_ER_START 10
@@ -29,6 +31,25 @@
 
 #define GSI_RESET_WA_MIN_SLEEP 1000
 #define GSI_RESET_WA_MAX_SLEEP 2000
+
+/*
+ * Adaptive interrupt moderation: rings configured to interrupt on every
+ * event get their moderation counter doubled while the event rate stays
+ * above gsi_mod_rate_hi events per ms, and halved again below
+ * gsi_mod_rate_lo. The moderation timer set by the client still bounds
+ * the added latency.
+ */
+static bool gsi_adaptive_mod = true;
+module_param(gsi_adaptive_mod, bool, 0644);
+MODULE_PARM_DESC(gsi_adaptive_mod, "Adapt event ring interrupt moderation");
+
+static unsigned int gsi_mod_rate_hi = 16;
+module_param(gsi_mod_rate_hi, uint, 0644);
+MODULE_PARM_DESC(gsi_mod_rate_hi, "Events per ms to raise moderation");
+
+static unsigned int gsi_mod_rate_lo = 4;
+module_param(gsi_mod_rate_lo, uint, 0644);
+MODULE_PARM_DESC(gsi_mod_rate_lo, "Events per ms to lower moderation");
 static const struct of_device_id msm_gsi_match[] = {
 	{ .compatible = "qcom,msm_gsi", },
 	{ },
@@ -431,6 +452,68 @@ static void gsi_ring_chan_doorbell(struct gsi_chan_ctx *ctx)
 				gsi_ctx->per.ee));
 }
 
+static void gsi_program_evt_ring_mod(struct gsi_evt_ctx *ctx,
+		unsigned int ee)
+{
+	uint32_t val;
+
+	val = (((ctx->props.int_modt << GSI_EE_n_EV_CH_k_CNTXT_8_INT_MODT_SHFT) &
+		GSI_EE_n_EV_CH_k_CNTXT_8_INT_MODT_BMSK) |
+		((ctx->mod.modc << GSI_EE_n_EV_CH_k_CNTXT_8_INT_MODC_SHFT) &
+		 GSI_EE_n_EV_CH_k_CNTXT_8_INT_MODC_BMSK));
+	gsi_writel(val, gsi_ctx->base +
+			GSI_EE_n_EV_CH_k_CNTXT_8_OFFS(ctx->id, ee));
+}
+
+/*
+ * Called with the ring lock held after each interrupt of @ctx that
+ * processed @events events.
+ */
+static void gsi_update_evt_ring_mod(struct gsi_evt_ctx *ctx, unsigned int ee,
+		unsigned long events)
+{
+	struct gsi_evt_mod *mod = &ctx->mod;
+	unsigned long elapsed;
+	unsigned int rate, max_modc;
+	uint8_t level = mod->level;
+
+	ctx->stats.irqs++;
+
+	/* Only rings without a counter and with a timer to bound latency */
+	if (!gsi_adaptive_mod || ctx->props.int_modc != 1 ||
+		!ctx->props.int_modt)
+		return;
+
+	mod->irqs++;
+	mod->events += events;
+	elapsed = jiffies - mod->win_start;
+	if (elapsed < msecs_to_jiffies(GSI_MOD_WINDOW_MS))
+		return;
+
+	rate = mod->events / max(jiffies_to_msecs(elapsed), 1U);
+	if (elapsed > msecs_to_jiffies(4 * GSI_MOD_WINDOW_MS))
+		/* the ring went idle, start over from the client setting */
+		level = 0;
+	else if (rate > gsi_mod_rate_hi && level < GSI_MOD_MAX_LEVEL)
+		level++;
+	else if (rate < gsi_mod_rate_lo && level > 0)
+		level--;
+
+	mod->win_start = jiffies;
+	mod->irqs = 0;
+	mod->events = 0;
+
+	if (level == mod->level)
+		return;
+
+	/* Keep enough room on the ring for the events held back */
+	max_modc = max_t(unsigned int, ctx->ring.max_num_elem / 4, 1);
+	mod->level = level;
+	mod->modc = min(1U << level, max_modc);
+	ctx->stats.mod_changes++;
+	gsi_program_evt_ring_mod(ctx, ee);
+}
+
 static void gsi_handle_ieob(int ee)
 {
 	uint32_t ch;
@@ -440,6 +523,7 @@ static void gsi_handle_ieob(int ee)
 	struct gsi_chan_xfer_notify notify;
 	unsigned long flags;
 	unsigned long cntr;
+	unsigned long total;
 	uint32_t msk;
 
 	ch = gsi_readl(gsi_ctx->base +
@@ -459,6 +543,7 @@ static void gsi_handle_ieob(int ee)
 			ctx = &gsi_ctx->evtr[i];
 			BUG_ON(ctx->props.intf != GSI_EVT_CHTYPE_GPI_EV);
 			spin_lock_irqsave(&ctx->ring.slock, flags);
+			total = 0;
 check_again:
 			cntr = 0;
 			rp = gsi_readl(gsi_ctx->base +
@@ -476,8 +561,10 @@ check_again:
 				gsi_process_evt_re(ctx, &notify, true);
 			}
 			gsi_ring_evt_doorbell(ctx);
+			total += cntr;
 			if (cntr != 0)
 				goto check_again;
+			gsi_update_evt_ring_mod(ctx, ee, total);
 			spin_unlock_irqrestore(&ctx->ring.slock, flags);
 		}
 	}
@@ -965,6 +1052,11 @@ static void gsi_program_evt_ring_ctx(struct gsi_evt_ring_props *props,
 		 GSI_EE_n_EV_CH_k_CNTXT_8_INT_MODC_BMSK));
 	gsi_writel(val, gsi_ctx->base +
 			GSI_EE_n_EV_CH_k_CNTXT_8_OFFS(evt_id, ee));
+	gsi_ctx->evtr[evt_id].mod.level = 0;
+	gsi_ctx->evtr[evt_id].mod.modc = props->int_modc;
+	gsi_ctx->evtr[evt_id].mod.win_start = jiffies;
+	gsi_ctx->evtr[evt_id].mod.irqs = 0;
+	gsi_ctx->evtr[evt_id].mod.events = 0;
 
 	val = (props->intvec & GSI_EE_n_EV_CH_k_CNTXT_9_INTVEC_BMSK) <<
 		GSI_EE_n_EV_CH_k_CNTXT_9_INTVEC_SHFT;
@@ -136,6 +136,24 @@ struct gsi_chan_ctx {
 
 struct gsi_evt_stats {
 	unsigned long completed;
+	unsigned long irqs;
+	unsigned long mod_changes;
+};
+
+/**
+ * struct gsi_evt_mod - adaptive interrupt moderation state of an event ring
+ * @win_start: jiffies at the start of the sampling window
+ * @irqs: interrupts taken during the window
+ * @events: events processed during the window
+ * @level: current moderation level, 0 is the client configuration
+ * @modc: moderation counter currently programmed
+ */
+struct gsi_evt_mod {
+	unsigned long win_start;
+	uint32_t irqs;
+	uint32_t events;
+	uint8_t level;
+	uint8_t modc;
 };
 
 struct gsi_evt_ctx {
@@ -149,6 +167,7 @@ struct gsi_evt_ctx {
 	atomic_t chan_ref_cnt;
 	union __packed gsi_evt_scratch scratch;
 	struct gsi_evt_stats stats;
+	struct gsi_evt_mod mod;
 };
 
 struct gsi_ee_scratch {
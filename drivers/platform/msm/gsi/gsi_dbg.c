@@ -277,9 +277,13 @@ static void gsi_dump_ch_stats(struct gsi_chan_ctx *ctx)
 		ctx->stats.invalid_tre_error);
 	PRT_STAT("poll_ok=%lu poll_empty=%lu\n",
 		ctx->stats.poll_ok, ctx->stats.poll_empty);
-	if (ctx->evtr)
+	if (ctx->evtr) {
 		PRT_STAT("compl_evt=%lu\n",
 			ctx->evtr->stats.completed);
+		PRT_STAT("evt_irqs=%lu mod_changes=%lu modc=%u level=%u\n",
+			ctx->evtr->stats.irqs, ctx->evtr->stats.mod_changes,
+			ctx->evtr->mod.modc, ctx->evtr->mod.level);
+	}
 
 	PRT_STAT("ch_below_lo=%lu\n", ctx->stats.dp.ch_below_lo);
 	PRT_STAT("ch_below_hi=%lu\n", ctx->stats.dp.ch_below_hi);
@@ -103,6 +103,8 @@ static struct dentry *dfile_ntn_stats;
 static struct dentry *dfile_dbg_cnt;
 static struct dentry *dfile_msg;
 static struct dentry *dfile_ip4_nat;
+static struct dentry *dfile_ip4_nat_occupancy;
+static struct dentry *dfile_fltrt_commit_stats;
 static struct dentry *dfile_rm_stats;
 static struct dentry *dfile_status_stats;
 static struct dentry *dfile_active_clients;
@@ -1705,6 +1707,108 @@ static ssize_t ipa3_read_nat4(struct file *file,
 	return 0;
 }
 
+/* Number of expansion entries chained behind the base entry @entry */
+static u32 ipa3_nat4_chain_len(u32 *entry, u32 *expn_tbl, u32 expn_size)
+{
+	u32 len = 0, next;
+
+	next = entry[2] & 0x0000FFFF;
+	while (next && next < expn_size && len < expn_size) {
+		len++;
+		next = expn_tbl[next * ENTRY_U32_FIELDS + 2] & 0x0000FFFF;
+	}
+
+	return len;
+}
+
+static ssize_t ipa3_read_nat4_occupancy(struct file *file,
+		char __user *ubuf, size_t count, loff_t *ppos)
+{
+	u32 *base_tbl, *expn_tbl;
+	u32 base_size, expn_size, i, len;
+	u32 base_used = 0, expn_used = 0, chained = 0;
+	u32 max_chain = 0, sum_chain = 0;
+	int nbytes;
+
+	mutex_lock(&ipa3_ctx->nat_mem.lock);
+
+	if (!ipa3_ctx->nat_mem.is_sys_mem ||
+		!ipa3_ctx->nat_mem.ipv4_rules_addr) {
+		mutex_unlock(&ipa3_ctx->nat_mem.lock);
+		nbytes = scnprintf(dbg_buff, IPA_MAX_MSG_LEN,
+			"Not supported for local(shared) memory\n");
+		return simple_read_from_buffer(ubuf, count, ppos, dbg_buff,
+			nbytes);
+	}
+
+	base_tbl = (u32 *)ipa3_ctx->nat_mem.ipv4_rules_addr;
+	base_size = ipa3_ctx->nat_mem.size_base_tables + 1;
+	expn_tbl = (u32 *)ipa3_ctx->nat_mem.ipv4_expansion_rules_addr;
+	expn_size = expn_tbl ? ipa3_ctx->nat_mem.size_expansion_tables : 0;
+
+	for (i = 0; i < expn_size; i++)
+		if ((expn_tbl[i * ENTRY_U32_FIELDS + 4] >> 16) &
+			NAT_ENTRY_ENABLE)
+			expn_used++;
+
+	for (i = 0; i < base_size; i++) {
+		u32 *entry = &base_tbl[i * ENTRY_U32_FIELDS];
+
+		if (!((entry[4] >> 16) & NAT_ENTRY_ENABLE))
+			continue;
+		base_used++;
+		if (!expn_size)
+			continue;
+		len = ipa3_nat4_chain_len(entry, expn_tbl, expn_size);
+		if (len)
+			chained++;
+		sum_chain += len;
+		max_chain = max(max_chain, len);
+	}
+
+	mutex_unlock(&ipa3_ctx->nat_mem.lock);
+
+	nbytes = scnprintf(dbg_buff, IPA_MAX_MSG_LEN,
+		"base table: %u/%u entries used\n"
+		"expansion table: %u/%u entries used\n"
+		"base entries with a chain: %u\n"
+		"longest chain: %u\n"
+		"average chain: %u.%02u\n",
+		base_used, base_size, expn_used, expn_size, chained,
+		max_chain, chained ? sum_chain / chained : 0,
+		chained ? (sum_chain % chained) * 100 / chained : 0);
+
+	return simple_read_from_buffer(ubuf, count, ppos, dbg_buff, nbytes);
+}
+
+static ssize_t ipa3_read_fltrt_commit_stats(struct file *file,
+		char __user *ubuf, size_t count, loff_t *ppos)
+{
+	static const char * const names[] = { "v4", "v6" };
+	struct ipa3_fltrt_commit_stats *st;
+	int nbytes = 0;
+	int i, j;
+
+	mutex_lock(&ipa3_ctx->lock);
+	for (j = 0; j < 2; j++) {
+		for (i = IPA_IP_v4; i <= IPA_IP_v6; i++) {
+			st = j ? &ipa3_ctx->rt_commit_stats[i] :
+				&ipa3_ctx->flt_commit_stats[i];
+			nbytes += scnprintf(dbg_buff + nbytes,
+				IPA_MAX_MSG_LEN - nbytes,
+				"%s %s: commits %u avg %llu us max %u us dma sent %u skipped %u hash flush skipped %u\n",
+				j ? "rt" : "flt", names[i], st->commits,
+				st->commits ? div_u64(st->total_us,
+					st->commits) : 0,
+				st->max_us, st->dma_sent, st->dma_skipped,
+				st->flush_skipped);
+		}
+	}
+	mutex_unlock(&ipa3_ctx->lock);
+
+	return simple_read_from_buffer(ubuf, count, ppos, dbg_buff, nbytes);
+}
+
 static ssize_t ipa3_rm_read_stats(struct file *file, char __user *ubuf,
 		size_t count, loff_t *ppos)
 {
@@ -1941,6 +2045,14 @@ const struct file_operations ipa3_nat4_ops = {
 	.read = ipa3_read_nat4,
 };
 
+const struct file_operations ipa3_nat4_occupancy_ops = {
+	.read = ipa3_read_nat4_occupancy,
+};
+
+const struct file_operations ipa3_fltrt_commit_stats_ops = {
+	.read = ipa3_read_fltrt_commit_stats,
+};
+
 const struct file_operations ipa3_rm_stats = {
 	.read = ipa3_rm_read_stats,
 };
@@ -2136,6 +2248,21 @@ void ipa3_debugfs_init(void)
 		goto fail;
 	}
 
+	dfile_ip4_nat_occupancy = debugfs_create_file("ip4_nat_occupancy",
+			read_only_mode, dent, 0, &ipa3_nat4_occupancy_ops);
+	if (!dfile_ip4_nat_occupancy || IS_ERR(dfile_ip4_nat_occupancy)) {
+		IPAERR("fail to create file for debug_fs ip4 nat occupancy\n");
+		goto fail;
+	}
+
+	dfile_fltrt_commit_stats = debugfs_create_file("fltrt_commit_stats",
+			read_only_mode, dent, 0, &ipa3_fltrt_commit_stats_ops);
+	if (!dfile_fltrt_commit_stats ||
+		IS_ERR(dfile_fltrt_commit_stats)) {
+		IPAERR("fail to create file for debug_fs fltrt_commit_stats\n");
+		goto fail;
+	}
+
 	dfile_rm_stats = debugfs_create_file("rm_stats",
 			read_only_mode, dent, 0, &ipa3_rm_stats);
 	if (!dfile_rm_stats || IS_ERR(dfile_rm_stats)) {
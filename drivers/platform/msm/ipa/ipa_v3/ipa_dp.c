@@ -69,6 +69,8 @@
 #define IPA_GSI_CH_20_WA_VIRT_CHAN 29
 
 #define IPA_DEFAULT_SYS_YELLOW_WM 32
+/* Max packets queued on a channel before its doorbell must be rung */
+#define IPA_TX_DB_BATCH_MAX 16
 
 static struct sk_buff *ipa3_get_skb_ipa_rx(unsigned int len, gfp_t flags);
 static void ipa3_replenish_wlan_rx_cache(struct ipa3_sys_context *sys);
@@ -107,6 +109,7 @@ static void ipa3_wq_write_done_common(struct ipa3_sys_context *sys,
 				struct ipa3_tx_pkt_wrapper *tx_pkt)
 {
 	struct ipa3_tx_pkt_wrapper *next_pkt;
+	LIST_HEAD(done);
 	int i, cnt;
 
 	if (unlikely(tx_pkt == NULL)) {
@@ -116,16 +119,20 @@ static void ipa3_wq_write_done_common(struct ipa3_sys_context *sys,
 
 	cnt = tx_pkt->cnt;
 	IPADBG_LOW("cnt: %d\n", cnt);
-	for (i = 0; i < cnt; i++) {
-		spin_lock_bh(&sys->spinlock);
-		if (unlikely(list_empty(&sys->head_desc_list))) {
-			spin_unlock_bh(&sys->spinlock);
-			return;
-		}
+
+	/* Take the whole transaction off the pipe under a single lock */
+	spin_lock_bh(&sys->spinlock);
+	for (i = 0, next_pkt = tx_pkt; i < cnt; i++) {
+		if (unlikely(list_empty(&sys->head_desc_list)))
+			break;
+		tx_pkt = next_pkt;
 		next_pkt = list_next_entry(tx_pkt, link);
-		list_del(&tx_pkt->link);
+		list_move_tail(&tx_pkt->link, &done);
 		sys->len--;
-		spin_unlock_bh(&sys->spinlock);
+	}
+	spin_unlock_bh(&sys->spinlock);
+
+	list_for_each_entry_safe(tx_pkt, next_pkt, &done, link) {
 		if (!tx_pkt->no_unmap_dma) {
 			if (tx_pkt->type != IPA_DATA_DESC_SKB_PAGED) {
 				dma_unmap_single(ipa3_ctx->pdev,
@@ -134,8 +141,8 @@ static void ipa3_wq_write_done_common(struct ipa3_sys_context *sys,
 					DMA_TO_DEVICE);
 			} else {
 				dma_unmap_page(ipa3_ctx->pdev,
-					next_pkt->mem.phys_base,
-					next_pkt->mem.size,
+					tx_pkt->mem.phys_base,
+					tx_pkt->mem.size,
 					DMA_TO_DEVICE);
 			}
 		}
@@ -159,7 +166,6 @@ static void ipa3_wq_write_done_common(struct ipa3_sys_context *sys,
 		}
 
 		kmem_cache_free(ipa3_ctx->tx_pkt_wrapper_cache, tx_pkt);
-		tx_pkt = next_pkt;
 	}
 }
 
@@ -436,11 +442,14 @@ fail_mem_alloc:
 }
 
 /**
- * ipa3_send() - Send multiple descriptors in one HW transaction
+ * __ipa3_send() - Send multiple descriptors in one HW transaction
  * @sys: system pipe context
  * @num_desc: number of packets
  * @desc: packets to send (may be immediate command or data)
  * @in_atomic:  whether caller is in atomic context
+ * @xmit_more: more packets follow immediately; on GSI the channel doorbell
+ *   is then left for a later send to ring, up to IPA_TX_DB_BATCH_MAX
+ *   transactions
  *
  * This function is used for system-to-bam connection.
  * - SPS driver expect struct sps_transfer which will contain all the data
@@ -455,10 +464,11 @@ fail_mem_alloc:
  *
  * Return codes: 0: success, -EFAULT: failure
  */
-int ipa3_send(struct ipa3_sys_context *sys,
+static int __ipa3_send(struct ipa3_sys_context *sys,
 		u32 num_desc,
 		struct ipa3_desc *desc,
-		bool in_atomic)
+		bool in_atomic,
+		bool xmit_more)
 {
 	struct ipa3_tx_pkt_wrapper *tx_pkt, *tx_pkt_first;
 	struct ipahal_imm_cmd_pyld *tag_pyld_ret = NULL;
@@ -474,6 +484,7 @@ int ipa3_send(struct ipa3_sys_context *sys,
 	u32 mem_flag = GFP_ATOMIC;
 	int ipa_ep_idx;
 	struct ipa_gsi_ep_config *gsi_ep_cfg;
+	bool ring_db;
 
 	if (unlikely(!in_atomic))
 		mem_flag = GFP_KERNEL;
@@ -678,12 +689,20 @@ int ipa3_send(struct ipa3_sys_context *sys,
 	}
 
 	if (ipa3_ctx->transport_prototype == IPA_TRANSPORT_TYPE_GSI) {
+		ring_db = !xmit_more ||
+			sys->db_pending + 1 >= IPA_TX_DB_BATCH_MAX;
 		result = gsi_queue_xfer(sys->ep->gsi_chan_hdl, num_desc,
-				gsi_xfer_elem_array, true);
+				gsi_xfer_elem_array, ring_db);
 		if (result != GSI_STATUS_SUCCESS) {
 			IPAERR("GSI xfer failed.\n");
+			/* the caller may not come back, do not strand the rest */
+			if (sys->db_pending) {
+				gsi_start_xfer(sys->ep->gsi_chan_hdl);
+				sys->db_pending = 0;
+			}
 			goto failure;
 		}
+		sys->db_pending = ring_db ? 0 : sys->db_pending + 1;
 		kfree(gsi_xfer_elem_array);
 	} else {
 		result = sps_transfer(sys->ep->ep_hdl, &transfer);
@@ -740,6 +759,14 @@ failure:
 	return -EFAULT;
 }
 
+int ipa3_send(struct ipa3_sys_context *sys,
+		u32 num_desc,
+		struct ipa3_desc *desc,
+		bool in_atomic)
+{
+	return __ipa3_send(sys, num_desc, desc, in_atomic, false);
+}
+
 /**
  * ipa3_transport_irq_cmd_ack - callback function which will be called by SPS/GSI driver after an
  * immediate command is complete.
@@ -1878,7 +1905,8 @@ int ipa3_tx_dp(enum ipa_client_type dst, struct sk_buff *skb,
 			desc[data_idx].dma_address = meta->dma_address;
 		}
 		if (num_frags == 0) {
-			if (ipa3_send(sys, data_idx + 1, desc, true)) {
+			if (__ipa3_send(sys, data_idx + 1, desc, true,
+					skb->xmit_more)) {
 				IPAERR("fail to send skb %p HWP\n", skb);
 				goto fail_mem;
 			}
@@ -1897,8 +1925,8 @@ int ipa3_tx_dp(enum ipa_client_type dst, struct sk_buff *skb,
 			desc[data_idx+f].user2 = desc[data_idx].user2;
 			desc[data_idx].callback = NULL;
 
-			if (ipa3_send(sys, num_frags + data_idx + 1,
-				desc, true)) {
+			if (__ipa3_send(sys, num_frags + data_idx + 1,
+				desc, true, skb->xmit_more)) {
 				IPAERR("fail to send skb %p num_frags %u HWP\n",
 					skb, num_frags);
 				goto fail_mem;
@@ -1922,6 +1950,38 @@ fail_gen:
 	return -EFAULT;
 }
 
+/**
+ * ipa3_tx_dp_flush() - ring the doorbell left pending by ipa3_tx_dp()
+ * @dst: [in] the producer pipe the packets were sent on
+ *
+ * Packets sent with skb->xmit_more set are queued without ringing the
+ * GSI doorbell. A caller that stops before the end of such a burst, e.g.
+ * because its queue got stopped, must call this so they get processed.
+ */
+void ipa3_tx_dp_flush(enum ipa_client_type dst)
+{
+	struct ipa3_sys_context *sys;
+	int ep_idx;
+
+	if (ipa3_ctx->transport_prototype != IPA_TRANSPORT_TYPE_GSI)
+		return;
+
+	ep_idx = ipa3_get_ep_mapping(dst);
+	if (ep_idx == -1 || !ipa3_ctx->ep[ep_idx].valid)
+		return;
+
+	sys = ipa3_ctx->ep[ep_idx].sys;
+	if (!sys)
+		return;
+
+	spin_lock_bh(&sys->spinlock);
+	if (sys->db_pending) {
+		gsi_start_xfer(sys->ep->gsi_chan_hdl);
+		sys->db_pending = 0;
+	}
+	spin_unlock_bh(&sys->spinlock);
+}
+
 static void ipa3_wq_handle_rx(struct work_struct *work)
 {
 	struct ipa3_sys_context *sys;
@@ -2284,11 +2344,17 @@ static void ipa3_replenish_rx_cache_recycle(struct ipa3_sys_context *sys)
 	int rx_len_cached = 0;
 	struct gsi_xfer_elem gsi_xfer_elem_one;
 	gfp_t flag = GFP_NOWAIT | __GFP_NOWARN;
+	LIST_HEAD(rcycl);
 
 	rx_len_cached = sys->len;
 
+	/* Take all the recycled buffers at once rather than one per lock */
+	spin_lock_bh(&sys->spinlock);
+	list_splice_init(&sys->rcycl_list, &rcycl);
+	spin_unlock_bh(&sys->spinlock);
+
 	while (rx_len_cached < sys->rx_pool_sz) {
-		if (list_empty(&sys->rcycl_list)) {
+		if (list_empty(&rcycl)) {
 			rx_pkt = kmem_cache_zalloc(
 				ipa3_ctx->rx_pkt_wrapper_cache, flag);
 			if (!rx_pkt) {
@@ -2307,29 +2373,27 @@ static void ipa3_replenish_rx_cache_recycle(struct ipa3_sys_context *sys)
 					rx_pkt);
 				goto fail_kmem_cache_alloc;
 			}
-			ptr = skb_put(rx_pkt->data.skb, sys->rx_buff_sz);
-			rx_pkt->data.dma_addr = dma_map_single(ipa3_ctx->pdev,
-				ptr, sys->rx_buff_sz, DMA_FROM_DEVICE);
-			if (dma_mapping_error(ipa3_ctx->pdev,
-				rx_pkt->data.dma_addr)) {
-				IPAERR("dma_map_single failure %p for %p\n",
-					(void *)rx_pkt->data.dma_addr, ptr);
-				goto fail_dma_mapping;
-			}
 		} else {
-			spin_lock_bh(&sys->spinlock);
-			rx_pkt = list_first_entry(&sys->rcycl_list,
+			rx_pkt = list_first_entry(&rcycl,
 				struct ipa3_rx_pkt_wrapper, link);
 			list_del(&rx_pkt->link);
-			spin_unlock_bh(&sys->spinlock);
 			INIT_LIST_HEAD(&rx_pkt->link);
-			ptr = skb_put(rx_pkt->data.skb, sys->rx_buff_sz);
+		}
+
+		ptr = skb_put(rx_pkt->data.skb, sys->rx_buff_sz);
+		if (rx_pkt->data.dma_addr) {
+			/* Still mapped from its previous use */
+			dma_sync_single_for_device(ipa3_ctx->pdev,
+				rx_pkt->data.dma_addr, sys->rx_buff_sz,
+				DMA_FROM_DEVICE);
+		} else {
 			rx_pkt->data.dma_addr = dma_map_single(ipa3_ctx->pdev,
 				ptr, sys->rx_buff_sz, DMA_FROM_DEVICE);
 			if (dma_mapping_error(ipa3_ctx->pdev,
 				rx_pkt->data.dma_addr)) {
 				IPAERR("dma_map_single failure %p for %p\n",
 					(void *)rx_pkt->data.dma_addr, ptr);
+				rx_pkt->data.dma_addr = 0;
 				goto fail_dma_mapping;
 			}
 		}
@@ -2366,22 +2430,24 @@ static void ipa3_replenish_rx_cache_recycle(struct ipa3_sys_context *sys)
 		}
 	}
 
-	return;
+	goto out;
 fail_provide_rx_buffer:
 	rx_len_cached = --sys->len;
 	list_del(&rx_pkt->link);
 	INIT_LIST_HEAD(&rx_pkt->link);
-	dma_unmap_single(ipa3_ctx->pdev, rx_pkt->data.dma_addr,
-		sys->rx_buff_sz, DMA_FROM_DEVICE);
 fail_dma_mapping:
-	spin_lock_bh(&sys->spinlock);
-	list_add_tail(&rx_pkt->link, &sys->rcycl_list);
-	INIT_LIST_HEAD(&rx_pkt->link);
-	spin_unlock_bh(&sys->spinlock);
+	ipa3_skb_recycle(rx_pkt->data.skb);
+	list_add(&rx_pkt->link, &rcycl);
 fail_kmem_cache_alloc:
 	if (rx_len_cached == 0)
 		queue_delayed_work(sys->wq, &sys->replenish_rx_work,
 		msecs_to_jiffies(1));
+out:
+	if (!list_empty(&rcycl)) {
+		spin_lock_bh(&sys->spinlock);
+		list_splice(&rcycl, &sys->rcycl_list);
+		spin_unlock_bh(&sys->spinlock);
+	}
 }
 
 static void ipa3_fast_replenish_rx_cache(struct ipa3_sys_context *sys)
@@ -2487,8 +2553,9 @@ static void ipa3_cleanup_rx(struct ipa3_sys_context *sys)
 	list_for_each_entry_safe(rx_pkt, r,
 				 &sys->rcycl_list, link) {
 		list_del(&rx_pkt->link);
-		dma_unmap_single(ipa3_ctx->pdev, rx_pkt->data.dma_addr,
-			sys->rx_buff_sz, DMA_FROM_DEVICE);
+		if (rx_pkt->data.dma_addr)
+			dma_unmap_single(ipa3_ctx->pdev, rx_pkt->data.dma_addr,
+				sys->rx_buff_sz, DMA_FROM_DEVICE);
 		sys->free_skb(rx_pkt->data.skb);
 		kmem_cache_free(ipa3_ctx->rx_pkt_wrapper_cache, rx_pkt);
 	}
@@ -3072,7 +3139,10 @@ void ipa3_lan_rx_cb(void *priv, enum ipa_dp_evt_type evt, unsigned long data)
 
 static void ipa3_recycle_rx_wrapper(struct ipa3_rx_pkt_wrapper *rx_pkt)
 {
-	rx_pkt->data.dma_addr = 0;
+	/*
+	 * The buffer keeps its DMA mapping; ipa3_skb_recycle() puts skb->data
+	 * back at the offset it was mapped at.
+	 */
 	ipa3_skb_recycle(rx_pkt->data.skb);
 	INIT_LIST_HEAD(&rx_pkt->link);
 	spin_lock_bh(&rx_pkt->sys->spinlock);
@@ -3121,7 +3191,14 @@ static void ipa3_wq_rx_common(struct ipa3_sys_context *sys, u32 size)
 	if (size)
 		rx_pkt_expected->len = size;
 	rx_skb = rx_pkt_expected->data.skb;
-	dma_unmap_single(ipa3_ctx->pdev, rx_pkt_expected->data.dma_addr,
+	/* Recycled buffers stay mapped until the pipe is torn down */
+	if (sys->free_rx_wrapper == ipa3_recycle_rx_wrapper)
+		dma_sync_single_for_cpu(ipa3_ctx->pdev,
+			rx_pkt_expected->data.dma_addr,
+			sys->rx_buff_sz, DMA_FROM_DEVICE);
+	else
+		dma_unmap_single(ipa3_ctx->pdev,
+			rx_pkt_expected->data.dma_addr,
 			sys->rx_buff_sz, DMA_FROM_DEVICE);
 	skb_set_tail_pointer(rx_skb, rx_pkt_expected->len);
 	rx_skb->len = rx_pkt_expected->len;
@@ -475,6 +475,10 @@ int __ipa_commit_flt_v3(enum ipa_ip_type ip)
 	struct ipahal_reg_valmask valmask;
 	u32 tbl_hdr_width;
 	struct ipa3_flt_tbl *tbl;
+	struct ipa3_fltrt_img_cache *img;
+	bool hash_same, hash_bdy_same, nhash_bdy_same;
+	u32 dma_sent = 0, dma_skipped = 0;
+	ktime_t start = ktime_get();
 
 	tbl_hdr_width = ipahal_get_hw_tbl_hdr_width();
 	memset(&alloc_params, 0, sizeof(alloc_params));
@@ -556,30 +560,51 @@ int __ipa_commit_flt_v3(enum ipa_ip_type ip)
 		goto fail_size_valid;
 	}
 
+	/*
+	 * Leave out the parts SRAM already holds from the previous commit.
+	 * The hashable rules cache only needs a flush if a hashable table
+	 * changed.
+	 */
+	img = ipa3_ctx->flt_img[ip];
+	hash_bdy_same = !lcl_hash ||
+		ipa3_fltrt_img_same(&img[IPA3_FLTRT_IMG_HASH_BDY],
+		&alloc_params.hash_bdy, 0, alloc_params.hash_bdy.size);
+	nhash_bdy_same = !lcl_nhash ||
+		ipa3_fltrt_img_same(&img[IPA3_FLTRT_IMG_NHASH_BDY],
+		&alloc_params.nhash_bdy, 0, alloc_params.nhash_bdy.size);
+	hash_same = hash_bdy_same &&
+		ipa3_fltrt_img_same(&img[IPA3_FLTRT_IMG_HASH_HDR],
+		&alloc_params.hash_hdr, 0, alloc_params.hash_hdr.size);
+
 	/* flushing ipa internal hashable flt rules cache */
-	memset(&flush, 0, sizeof(flush));
-	if (ip == IPA_IP_v4)
-		flush.v4_flt = true;
-	else
-		flush.v6_flt = true;
-	ipahal_get_fltrt_hash_flush_valmask(&flush, &valmask);
-	reg_write_cmd.skip_pipeline_clear = false;
-	reg_write_cmd.pipeline_clear_options = IPAHAL_HPS_CLEAR;
-	reg_write_cmd.offset = ipahal_get_reg_ofst(IPA_FILT_ROUT_HASH_FLUSH);
-	reg_write_cmd.value = valmask.val;
-	reg_write_cmd.value_mask = valmask.mask;
-	cmd_pyld[0] = ipahal_construct_imm_cmd(
-		IPA_IMM_CMD_REGISTER_WRITE, &reg_write_cmd, false);
-	if (!cmd_pyld[0]) {
-		IPAERR("fail construct register_write imm cmd: IP %d\n", ip);
-		rc = -EFAULT;
-		goto fail_reg_write_construct;
+	if (!hash_same) {
+		memset(&flush, 0, sizeof(flush));
+		if (ip == IPA_IP_v4)
+			flush.v4_flt = true;
+		else
+			flush.v6_flt = true;
+		ipahal_get_fltrt_hash_flush_valmask(&flush, &valmask);
+		reg_write_cmd.skip_pipeline_clear = false;
+		reg_write_cmd.pipeline_clear_options = IPAHAL_HPS_CLEAR;
+		reg_write_cmd.offset =
+			ipahal_get_reg_ofst(IPA_FILT_ROUT_HASH_FLUSH);
+		reg_write_cmd.value = valmask.val;
+		reg_write_cmd.value_mask = valmask.mask;
+		cmd_pyld[0] = ipahal_construct_imm_cmd(
+			IPA_IMM_CMD_REGISTER_WRITE, &reg_write_cmd, false);
+		if (!cmd_pyld[0]) {
+			IPAERR("fail construct register_write imm cmd: IP %d\n",
+				ip);
+			rc = -EFAULT;
+			goto fail_reg_write_construct;
+		}
+		desc[0].opcode =
+			ipahal_imm_cmd_get_opcode(IPA_IMM_CMD_REGISTER_WRITE);
+		desc[0].pyld = cmd_pyld[0]->data;
+		desc[0].len = cmd_pyld[0]->len;
+		desc[0].type = IPA_IMM_CMD_DESC;
+		num_cmd++;
 	}
-	desc[0].opcode = ipahal_imm_cmd_get_opcode(IPA_IMM_CMD_REGISTER_WRITE);
-	desc[0].pyld = cmd_pyld[0]->data;
-	desc[0].len = cmd_pyld[0]->len;
-	desc[0].type = IPA_IMM_CMD_DESC;
-	num_cmd++;
 
 	hdr_idx = 0;
 	for (i = 0; i < ipa3_ctx->ipa_num_pipes; i++) {
@@ -596,6 +621,13 @@ int __ipa_commit_flt_v3(enum ipa_ip_type ip)
 		IPADBG_LOW("Prepare imm cmd for hdr at index %d for pipe %d\n",
 			hdr_idx, i);
 
+		if (ipa3_fltrt_img_same(&img[IPA3_FLTRT_IMG_NHASH_HDR],
+			&alloc_params.nhash_hdr, hdr_idx * tbl_hdr_width,
+			tbl_hdr_width)) {
+			dma_skipped++;
+			goto hash_hdr;
+		}
+
 		mem_cmd.is_read = false;
 		mem_cmd.skip_pipeline_clear = false;
 		mem_cmd.pipeline_clear_options = IPAHAL_HPS_CLEAR;
@@ -616,6 +648,16 @@ int __ipa_commit_flt_v3(enum ipa_ip_type ip)
 		desc[num_cmd].pyld = cmd_pyld[num_cmd]->data;
 		desc[num_cmd].len = cmd_pyld[num_cmd]->len;
 		desc[num_cmd++].type = IPA_IMM_CMD_DESC;
+		dma_sent++;
+
+hash_hdr:
+		if (ipa3_fltrt_img_same(&img[IPA3_FLTRT_IMG_HASH_HDR],
+			&alloc_params.hash_hdr, hdr_idx * tbl_hdr_width,
+			tbl_hdr_width)) {
+			dma_skipped++;
+			hdr_idx++;
+			continue;
+		}
 
 		mem_cmd.is_read = false;
 		mem_cmd.skip_pipeline_clear = false;
@@ -637,11 +679,14 @@ int __ipa_commit_flt_v3(enum ipa_ip_type ip)
 		desc[num_cmd].pyld = cmd_pyld[num_cmd]->data;
 		desc[num_cmd].len = cmd_pyld[num_cmd]->len;
 		desc[num_cmd++].type = IPA_IMM_CMD_DESC;
+		dma_sent++;
 
 		hdr_idx++;
 	}
 
-	if (lcl_nhash) {
+	if (lcl_nhash && nhash_bdy_same) {
+		dma_skipped++;
+	} else if (lcl_nhash) {
 		mem_cmd.is_read = false;
 		mem_cmd.skip_pipeline_clear = false;
 		mem_cmd.pipeline_clear_options = IPAHAL_HPS_CLEAR;
@@ -660,8 +705,11 @@ int __ipa_commit_flt_v3(enum ipa_ip_type ip)
 		desc[num_cmd].pyld = cmd_pyld[num_cmd]->data;
 		desc[num_cmd].len = cmd_pyld[num_cmd]->len;
 		desc[num_cmd++].type = IPA_IMM_CMD_DESC;
+		dma_sent++;
 	}
-	if (lcl_hash) {
+	if (lcl_hash && hash_bdy_same) {
+		dma_skipped++;
+	} else if (lcl_hash) {
 		mem_cmd.is_read = false;
 		mem_cmd.skip_pipeline_clear = false;
 		mem_cmd.pipeline_clear_options = IPAHAL_HPS_CLEAR;
@@ -680,14 +728,28 @@ int __ipa_commit_flt_v3(enum ipa_ip_type ip)
 		desc[num_cmd].pyld = cmd_pyld[num_cmd]->data;
 		desc[num_cmd].len = cmd_pyld[num_cmd]->len;
 		desc[num_cmd++].type = IPA_IMM_CMD_DESC;
+		dma_sent++;
 	}
 
-	if (ipa3_send_cmd(num_cmd, desc)) {
+	if (num_cmd && ipa3_send_cmd(num_cmd, desc)) {
 		IPAERR("fail to send immediate command\n");
+		/* SRAM content is unknown now, rewrite all of it next time */
+		ipa3_fltrt_img_invalidate(img);
 		rc = -EFAULT;
 		goto fail_imm_cmd_construct;
 	}
 
+	ipa3_fltrt_img_save(&img[IPA3_FLTRT_IMG_HASH_HDR],
+		&alloc_params.hash_hdr);
+	ipa3_fltrt_img_save(&img[IPA3_FLTRT_IMG_NHASH_HDR],
+		&alloc_params.nhash_hdr);
+	ipa3_fltrt_img_save(&img[IPA3_FLTRT_IMG_HASH_BDY],
+		lcl_hash ? &alloc_params.hash_bdy : NULL);
+	ipa3_fltrt_img_save(&img[IPA3_FLTRT_IMG_NHASH_BDY],
+		lcl_nhash ? &alloc_params.nhash_bdy : NULL);
+	ipa3_fltrt_commit_account(&ipa3_ctx->flt_commit_stats[ip], start,
+		dma_sent, dma_skipped, hash_same);
+
 	IPADBG_LOW("Hashable HEAD\n");
 	IPA_DUMP_BUFF(alloc_params.hash_hdr.base,
 		alloc_params.hash_hdr.phys_base, alloc_params.hash_hdr.size);
@@ -660,6 +660,7 @@ struct ipa3_sys_context {
 	struct work_struct repl_work;
 	void (*repl_hdlr)(struct ipa3_sys_context *sys);
 	struct ipa3_repl_ctx repl;
+	u32 db_pending;
 
 	/* ordering is important - mutable fields go above */
 	struct ipa3_ep_context *ep;
@@ -872,6 +873,46 @@ struct ipa3_stats {
 	u32 tx_non_linear;
 };
 
+/**
+ * enum ipa3_fltrt_img_type - parts of a filter/route table image
+ *  that are committed to IPA SRAM
+ */
+enum ipa3_fltrt_img_type {
+	IPA3_FLTRT_IMG_HASH_HDR,
+	IPA3_FLTRT_IMG_NHASH_HDR,
+	IPA3_FLTRT_IMG_HASH_BDY,
+	IPA3_FLTRT_IMG_NHASH_BDY,
+	IPA3_FLTRT_IMG_MAX,
+};
+
+/**
+ * struct ipa3_fltrt_img_cache - copy of the last committed table image
+ * @base: the image, NULL when nothing is known to be in SRAM
+ * @size: size of @base in bytes
+ */
+struct ipa3_fltrt_img_cache {
+	void *base;
+	u32 size;
+};
+
+/**
+ * struct ipa3_fltrt_commit_stats - filter/route commit accounting
+ * @commits: number of successful commits
+ * @dma_sent: SRAM writes issued by the commits
+ * @dma_skipped: SRAM writes left out as the SRAM already held the data
+ * @flush_skipped: hash cache flushes left out as no hashable rule changed
+ * @total_us: time spent in the commits
+ * @max_us: longest commit
+ */
+struct ipa3_fltrt_commit_stats {
+	u32 commits;
+	u32 dma_sent;
+	u32 dma_skipped;
+	u32 flush_skipped;
+	u64 total_us;
+	u32 max_us;
+};
+
 struct ipa3_active_clients {
 	struct mutex mutex;
 	spinlock_t spinlock;
@@ -1193,6 +1234,10 @@ struct ipa3_context {
 	bool ip4_flt_tbl_nhash_lcl;
 	bool ip6_flt_tbl_hash_lcl;
 	bool ip6_flt_tbl_nhash_lcl;
+	struct ipa3_fltrt_img_cache rt_img[IPA_IP_MAX][IPA3_FLTRT_IMG_MAX];
+	struct ipa3_fltrt_img_cache flt_img[IPA_IP_MAX][IPA3_FLTRT_IMG_MAX];
+	struct ipa3_fltrt_commit_stats rt_commit_stats[IPA_IP_MAX];
+	struct ipa3_fltrt_commit_stats flt_commit_stats[IPA_IP_MAX];
 	struct gen_pool *pipe_mem_pool;
 	struct dma_pool *dma_pool;
 	struct ipa3_active_clients ipa3_active_clients;
@@ -1686,6 +1731,8 @@ int ipa3_set_single_ndp_per_mbim(bool enable);
 int ipa3_tx_dp(enum ipa_client_type dst, struct sk_buff *skb,
 		struct ipa_tx_meta *metadata);
 
+void ipa3_tx_dp_flush(enum ipa_client_type dst);
+
 /*
  * To transfer multiple data packets
  * While passing the data descriptor list, the anchor node
@@ -1952,6 +1999,13 @@ int __ipa_commit_rt_v3(enum ipa_ip_type ip);
 
 int __ipa_commit_hdr_v3_0(void);
 void ipa3_skb_recycle(struct sk_buff *skb);
+bool ipa3_fltrt_img_same(struct ipa3_fltrt_img_cache *c,
+	struct ipa_mem_buffer *img, u32 ofst, u32 len);
+void ipa3_fltrt_img_save(struct ipa3_fltrt_img_cache *c,
+	struct ipa_mem_buffer *img);
+void ipa3_fltrt_img_invalidate(struct ipa3_fltrt_img_cache *c);
+void ipa3_fltrt_commit_account(struct ipa3_fltrt_commit_stats *stats,
+	ktime_t start, u32 sent, u32 skipped, bool flush_skipped);
 void ipa3_install_dflt_flt_rules(u32 ipa_ep_idx);
 void ipa3_delete_dflt_flt_rules(u32 ipa_ep_idx);
 
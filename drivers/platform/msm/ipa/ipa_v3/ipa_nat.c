@@ -34,6 +34,12 @@ enum nat_table_type {
 #define NAT_TABLE_ENTRY_SIZE_BYTE 32
 #define NAT_INTEX_TABLE_ENTRY_SIZE_BYTE 4
 
+/*
+ * NAT_DMA commands chained behind a single NO-OP, kept well below the TLV
+ * FIFO depth of the command pipe
+ */
+#define IPA_NAT_DMA_MAX_BATCH 8
+
 /*
  * Max NAT table entries is limited 1000 entries.
  * Limit the memory size required by user to prevent kernel memory starvation
@@ -617,13 +623,11 @@ bail:
  */
 int ipa3_nat_dma_cmd(struct ipa_ioc_nat_dma_cmd *dma)
 {
-#define NUM_OF_DESC 2
-
 	struct ipahal_imm_cmd_pyld *nop_cmd_pyld = NULL;
 	struct ipahal_imm_cmd_nat_dma cmd;
-	struct ipahal_imm_cmd_pyld *cmd_pyld = NULL;
+	struct ipahal_imm_cmd_pyld *cmd_pyld[IPA_NAT_DMA_MAX_BATCH];
 	struct ipa3_desc *desc = NULL;
-	u16 size = 0, cnt = 0;
+	u16 size = 0, cnt = 0, num = 0, i;
 	int ret = 0;
 
 	IPADBG("\n");
@@ -699,7 +703,7 @@ int ipa3_nat_dma_cmd(struct ipa_ioc_nat_dma_cmd *dma)
 		}
 	}
 
-	size = sizeof(struct ipa3_desc) * NUM_OF_DESC;
+	size = sizeof(struct ipa3_desc) * (IPA_NAT_DMA_MAX_BATCH + 1);
 	desc = kzalloc(size, GFP_KERNEL);
 	if (desc == NULL) {
 		IPAERR("Failed to alloc memory\n");
@@ -715,37 +719,49 @@ int ipa3_nat_dma_cmd(struct ipa_ioc_nat_dma_cmd *dma)
 		ret = -ENOMEM;
 		goto bail;
 	}
-	desc[0].type = IPA_IMM_CMD_DESC;
-	desc[0].opcode = ipahal_imm_cmd_get_opcode(IPA_IMM_CMD_REGISTER_WRITE);
-	desc[0].callback = NULL;
-	desc[0].user1 = NULL;
-	desc[0].user2 = 0;
-	desc[0].pyld = nop_cmd_pyld->data;
-	desc[0].len = nop_cmd_pyld->len;
 
-	for (cnt = 0; cnt < dma->entries; cnt++) {
-		cmd.table_index = dma->dma[cnt].table_index;
-		cmd.base_addr = dma->dma[cnt].base_addr;
-		cmd.offset = dma->dma[cnt].offset;
-		cmd.data = dma->dma[cnt].data;
-		cmd_pyld = ipahal_construct_imm_cmd(
-			IPA_IMM_CMD_NAT_DMA, &cmd, false);
-		if (!cmd_pyld) {
-			IPAERR_RL("Fail to construct nat_dma imm cmd\n");
-			continue;
+	/*
+	 * Send the updates in chains of up to IPA_NAT_DMA_MAX_BATCH behind one
+	 * NO-OP, so that a batch from the NAT client costs one transaction
+	 * and one completion instead of one per entry.
+	 */
+	for (cnt = 0; cnt < dma->entries; cnt += num) {
+		memset(desc, 0, size);
+		desc[0].type = IPA_IMM_CMD_DESC;
+		desc[0].opcode =
+			ipahal_imm_cmd_get_opcode(IPA_IMM_CMD_REGISTER_WRITE);
+		desc[0].pyld = nop_cmd_pyld->data;
+		desc[0].len = nop_cmd_pyld->len;
+
+		num = min_t(u16, dma->entries - cnt, IPA_NAT_DMA_MAX_BATCH);
+		for (i = 0; i < num; i++) {
+			cmd.table_index = dma->dma[cnt + i].table_index;
+			cmd.base_addr = dma->dma[cnt + i].base_addr;
+			cmd.offset = dma->dma[cnt + i].offset;
+			cmd.data = dma->dma[cnt + i].data;
+			cmd_pyld[i] = ipahal_construct_imm_cmd(
+				IPA_IMM_CMD_NAT_DMA, &cmd, false);
+			if (!cmd_pyld[i]) {
+				IPAERR_RL("Fail to construct nat_dma imm cmd\n");
+				ret = -ENOMEM;
+				goto destroy_imm_cmd;
+			}
+			desc[i + 1].type = IPA_IMM_CMD_DESC;
+			desc[i + 1].opcode =
+				ipahal_imm_cmd_get_opcode(IPA_IMM_CMD_NAT_DMA);
+			desc[i + 1].pyld = cmd_pyld[i]->data;
+			desc[i + 1].len = cmd_pyld[i]->len;
 		}
-		desc[1].type = IPA_IMM_CMD_DESC;
-		desc[1].opcode = ipahal_imm_cmd_get_opcode(IPA_IMM_CMD_NAT_DMA);
-		desc[1].callback = NULL;
-		desc[1].user1 = NULL;
-		desc[1].user2 = 0;
-		desc[1].pyld = cmd_pyld->data;
-		desc[1].len = cmd_pyld->len;
-
-		ret = ipa3_send_cmd(NUM_OF_DESC, desc);
-		if (ret == -EPERM)
-			IPAERR("Fail to send immediate command %d\n", cnt);
-		ipahal_destroy_imm_cmd(cmd_pyld);
+
+		ret = ipa3_send_cmd(num + 1, desc);
+		if (ret)
+			IPAERR("Fail to send immediate commands %d-%d\n",
+				cnt, cnt + num - 1);
+destroy_imm_cmd:
+		while (i--)
+			ipahal_destroy_imm_cmd(cmd_pyld[i]);
+		if (ret)
+			break;
 	}
 
 bail:
@@ -470,6 +470,11 @@ int __ipa_commit_rt_v3(enum ipa_ip_type ip)
 	struct ipa3_rt_tbl_set *set;
 	struct ipa3_rt_tbl *tbl;
 	u32 tbl_hdr_width;
+	struct ipa3_fltrt_img_cache *img;
+	bool hash_hdr_same, nhash_hdr_same;
+	bool hash_bdy_same, nhash_bdy_same;
+	u32 dma_sent = 0, dma_skipped = 0;
+	ktime_t start = ktime_get();
 
 	tbl_hdr_width = ipahal_get_hw_tbl_hdr_width();
 	memset(desc, 0, sizeof(desc));
@@ -560,70 +565,103 @@ int __ipa_commit_rt_v3(enum ipa_ip_type ip)
 		goto fail_size_valid;
 	}
 
+	/*
+	 * Leave out the parts SRAM already holds from the previous commit.
+	 * The hashable rules cache only needs a flush if a hashable table
+	 * changed.
+	 */
+	img = ipa3_ctx->rt_img[ip];
+	hash_hdr_same = ipa3_fltrt_img_same(&img[IPA3_FLTRT_IMG_HASH_HDR],
+		&alloc_params.hash_hdr, 0, alloc_params.hash_hdr.size);
+	nhash_hdr_same = ipa3_fltrt_img_same(&img[IPA3_FLTRT_IMG_NHASH_HDR],
+		&alloc_params.nhash_hdr, 0, alloc_params.nhash_hdr.size);
+	hash_bdy_same = !lcl_hash ||
+		ipa3_fltrt_img_same(&img[IPA3_FLTRT_IMG_HASH_BDY],
+		&alloc_params.hash_bdy, 0, alloc_params.hash_bdy.size);
+	nhash_bdy_same = !lcl_nhash ||
+		ipa3_fltrt_img_same(&img[IPA3_FLTRT_IMG_NHASH_BDY],
+		&alloc_params.nhash_bdy, 0, alloc_params.nhash_bdy.size);
+
 	/* flushing ipa internal hashable rt rules cache */
-	memset(&flush, 0, sizeof(flush));
-	if (ip == IPA_IP_v4)
-		flush.v4_rt = true;
-	else
-		flush.v6_rt = true;
-	ipahal_get_fltrt_hash_flush_valmask(&flush, &valmask);
-	reg_write_cmd.skip_pipeline_clear = false;
-	reg_write_cmd.pipeline_clear_options = IPAHAL_HPS_CLEAR;
-	reg_write_cmd.offset = ipahal_get_reg_ofst(IPA_FILT_ROUT_HASH_FLUSH);
-	reg_write_cmd.value = valmask.val;
-	reg_write_cmd.value_mask = valmask.mask;
-	cmd_pyld[num_cmd] = ipahal_construct_imm_cmd(
-		IPA_IMM_CMD_REGISTER_WRITE, &reg_write_cmd, false);
-	if (!cmd_pyld[num_cmd]) {
-		IPAERR("fail construct register_write imm cmd. IP %d\n", ip);
-		goto fail_size_valid;
+	if (!hash_hdr_same || !hash_bdy_same) {
+		memset(&flush, 0, sizeof(flush));
+		if (ip == IPA_IP_v4)
+			flush.v4_rt = true;
+		else
+			flush.v6_rt = true;
+		ipahal_get_fltrt_hash_flush_valmask(&flush, &valmask);
+		reg_write_cmd.skip_pipeline_clear = false;
+		reg_write_cmd.pipeline_clear_options = IPAHAL_HPS_CLEAR;
+		reg_write_cmd.offset =
+			ipahal_get_reg_ofst(IPA_FILT_ROUT_HASH_FLUSH);
+		reg_write_cmd.value = valmask.val;
+		reg_write_cmd.value_mask = valmask.mask;
+		cmd_pyld[num_cmd] = ipahal_construct_imm_cmd(
+			IPA_IMM_CMD_REGISTER_WRITE, &reg_write_cmd, false);
+		if (!cmd_pyld[num_cmd]) {
+			IPAERR("fail construct register_write imm cmd. IP %d\n",
+				ip);
+			goto fail_size_valid;
+		}
+		desc[num_cmd].opcode =
+			ipahal_imm_cmd_get_opcode(IPA_IMM_CMD_REGISTER_WRITE);
+		desc[num_cmd].pyld = cmd_pyld[num_cmd]->data;
+		desc[num_cmd].len = cmd_pyld[num_cmd]->len;
+		desc[num_cmd].type = IPA_IMM_CMD_DESC;
+		num_cmd++;
 	}
-	desc[num_cmd].opcode =
-		ipahal_imm_cmd_get_opcode(IPA_IMM_CMD_REGISTER_WRITE);
-	desc[num_cmd].pyld = cmd_pyld[num_cmd]->data;
-	desc[num_cmd].len = cmd_pyld[num_cmd]->len;
-	desc[num_cmd].type = IPA_IMM_CMD_DESC;
-	num_cmd++;
-
-	mem_cmd.is_read = false;
-	mem_cmd.skip_pipeline_clear = false;
-	mem_cmd.pipeline_clear_options = IPAHAL_HPS_CLEAR;
-	mem_cmd.size = alloc_params.nhash_hdr.size;
-	mem_cmd.system_addr = alloc_params.nhash_hdr.phys_base;
-	mem_cmd.local_addr = lcl_nhash_hdr;
-	cmd_pyld[num_cmd] = ipahal_construct_imm_cmd(
-		IPA_IMM_CMD_DMA_SHARED_MEM, &mem_cmd, false);
-	if (!cmd_pyld[num_cmd]) {
-		IPAERR("fail construct dma_shared_mem imm cmd. IP %d\n", ip);
-		goto fail_imm_cmd_construct;
+
+	if (!nhash_hdr_same) {
+		mem_cmd.is_read = false;
+		mem_cmd.skip_pipeline_clear = false;
+		mem_cmd.pipeline_clear_options = IPAHAL_HPS_CLEAR;
+		mem_cmd.size = alloc_params.nhash_hdr.size;
+		mem_cmd.system_addr = alloc_params.nhash_hdr.phys_base;
+		mem_cmd.local_addr = lcl_nhash_hdr;
+		cmd_pyld[num_cmd] = ipahal_construct_imm_cmd(
+			IPA_IMM_CMD_DMA_SHARED_MEM, &mem_cmd, false);
+		if (!cmd_pyld[num_cmd]) {
+			IPAERR("fail construct dma_shared_mem imm cmd. IP %d\n",
+				ip);
+			goto fail_imm_cmd_construct;
+		}
+		desc[num_cmd].opcode =
+			ipahal_imm_cmd_get_opcode(IPA_IMM_CMD_DMA_SHARED_MEM);
+		desc[num_cmd].pyld = cmd_pyld[num_cmd]->data;
+		desc[num_cmd].len = cmd_pyld[num_cmd]->len;
+		desc[num_cmd].type = IPA_IMM_CMD_DESC;
+		num_cmd++;
+		dma_sent++;
+	} else {
+		dma_skipped++;
 	}
-	desc[num_cmd].opcode =
-		ipahal_imm_cmd_get_opcode(IPA_IMM_CMD_DMA_SHARED_MEM);
-	desc[num_cmd].pyld = cmd_pyld[num_cmd]->data;
-	desc[num_cmd].len = cmd_pyld[num_cmd]->len;
-	desc[num_cmd].type = IPA_IMM_CMD_DESC;
-	num_cmd++;
-
-	mem_cmd.is_read = false;
-	mem_cmd.skip_pipeline_clear = false;
-	mem_cmd.pipeline_clear_options = IPAHAL_HPS_CLEAR;
-	mem_cmd.size = alloc_params.hash_hdr.size;
-	mem_cmd.system_addr = alloc_params.hash_hdr.phys_base;
-	mem_cmd.local_addr = lcl_hash_hdr;
-	cmd_pyld[num_cmd] = ipahal_construct_imm_cmd(
-		IPA_IMM_CMD_DMA_SHARED_MEM, &mem_cmd, false);
-	if (!cmd_pyld[num_cmd]) {
-		IPAERR("fail construct dma_shared_mem imm cmd. IP %d\n", ip);
-		goto fail_imm_cmd_construct;
+
+	if (!hash_hdr_same) {
+		mem_cmd.is_read = false;
+		mem_cmd.skip_pipeline_clear = false;
+		mem_cmd.pipeline_clear_options = IPAHAL_HPS_CLEAR;
+		mem_cmd.size = alloc_params.hash_hdr.size;
+		mem_cmd.system_addr = alloc_params.hash_hdr.phys_base;
+		mem_cmd.local_addr = lcl_hash_hdr;
+		cmd_pyld[num_cmd] = ipahal_construct_imm_cmd(
+			IPA_IMM_CMD_DMA_SHARED_MEM, &mem_cmd, false);
+		if (!cmd_pyld[num_cmd]) {
+			IPAERR("fail construct dma_shared_mem imm cmd. IP %d\n",
+				ip);
+			goto fail_imm_cmd_construct;
+		}
+		desc[num_cmd].opcode =
+			ipahal_imm_cmd_get_opcode(IPA_IMM_CMD_DMA_SHARED_MEM);
+		desc[num_cmd].pyld = cmd_pyld[num_cmd]->data;
+		desc[num_cmd].len = cmd_pyld[num_cmd]->len;
+		desc[num_cmd].type = IPA_IMM_CMD_DESC;
+		num_cmd++;
+		dma_sent++;
+	} else {
+		dma_skipped++;
 	}
-	desc[num_cmd].opcode =
-		ipahal_imm_cmd_get_opcode(IPA_IMM_CMD_DMA_SHARED_MEM);
-	desc[num_cmd].pyld = cmd_pyld[num_cmd]->data;
-	desc[num_cmd].len = cmd_pyld[num_cmd]->len;
-	desc[num_cmd].type = IPA_IMM_CMD_DESC;
-	num_cmd++;
 
-	if (lcl_nhash) {
+	if (lcl_nhash && !nhash_bdy_same) {
 		mem_cmd.is_read = false;
 		mem_cmd.skip_pipeline_clear = false;
 		mem_cmd.pipeline_clear_options = IPAHAL_HPS_CLEAR;
@@ -643,8 +681,11 @@ int __ipa_commit_rt_v3(enum ipa_ip_type ip)
 		desc[num_cmd].len = cmd_pyld[num_cmd]->len;
 		desc[num_cmd].type = IPA_IMM_CMD_DESC;
 		num_cmd++;
+		dma_sent++;
+	} else if (lcl_nhash) {
+		dma_skipped++;
 	}
-	if (lcl_hash) {
+	if (lcl_hash && !hash_bdy_same) {
 		mem_cmd.is_read = false;
 		mem_cmd.skip_pipeline_clear = false;
 		mem_cmd.pipeline_clear_options = IPAHAL_HPS_CLEAR;
@@ -664,14 +705,30 @@ int __ipa_commit_rt_v3(enum ipa_ip_type ip)
 		desc[num_cmd].len = cmd_pyld[num_cmd]->len;
 		desc[num_cmd].type = IPA_IMM_CMD_DESC;
 		num_cmd++;
+		dma_sent++;
+	} else if (lcl_hash) {
+		dma_skipped++;
 	}
 
-	if (ipa3_send_cmd(num_cmd, desc)) {
+	if (num_cmd && ipa3_send_cmd(num_cmd, desc)) {
 		IPAERR("fail to send immediate command\n");
+		/* SRAM content is unknown now, rewrite all of it next time */
+		ipa3_fltrt_img_invalidate(img);
 		rc = -EFAULT;
 		goto fail_imm_cmd_construct;
 	}
 
+	ipa3_fltrt_img_save(&img[IPA3_FLTRT_IMG_HASH_HDR],
+		&alloc_params.hash_hdr);
+	ipa3_fltrt_img_save(&img[IPA3_FLTRT_IMG_NHASH_HDR],
+		&alloc_params.nhash_hdr);
+	ipa3_fltrt_img_save(&img[IPA3_FLTRT_IMG_HASH_BDY],
+		lcl_hash ? &alloc_params.hash_bdy : NULL);
+	ipa3_fltrt_img_save(&img[IPA3_FLTRT_IMG_NHASH_BDY],
+		lcl_nhash ? &alloc_params.nhash_bdy : NULL);
+	ipa3_fltrt_commit_account(&ipa3_ctx->rt_commit_stats[ip], start,
+		dma_sent, dma_skipped, hash_hdr_same && hash_bdy_same);
+
 	IPADBG_LOW("Hashable HEAD\n");
 	IPA_DUMP_BUFF(alloc_params.hash_hdr.base,
 		alloc_params.hash_hdr.phys_base, alloc_params.hash_hdr.size);
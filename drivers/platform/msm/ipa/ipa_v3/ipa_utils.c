@@ -2581,6 +2581,85 @@ void ipa3_skb_recycle(struct sk_buff *skb)
 	skb_reset_tail_pointer(skb);
 }
 
+/**
+ * ipa3_fltrt_img_same() - check whether part of a table image is in SRAM
+ * @c: copy of the image last committed to the same SRAM location
+ * @img: the image about to be committed
+ * @ofst: offset of the part to check in @img
+ * @len: length of the part to check
+ *
+ * Return: true when the part equals what the previous commit wrote
+ */
+bool ipa3_fltrt_img_same(struct ipa3_fltrt_img_cache *c,
+	struct ipa_mem_buffer *img, u32 ofst, u32 len)
+{
+	if (!c->base || c->size != img->size || ofst + len > img->size)
+		return false;
+
+	return !memcmp(c->base + ofst, img->base + ofst, len);
+}
+
+/**
+ * ipa3_fltrt_img_save() - remember a table image committed to SRAM
+ * @c: the copy to refresh
+ * @img: the image that was committed, NULL if SRAM content is unknown
+ */
+void ipa3_fltrt_img_save(struct ipa3_fltrt_img_cache *c,
+	struct ipa_mem_buffer *img)
+{
+	if (!img || !img->size) {
+		kfree(c->base);
+		c->base = NULL;
+		c->size = 0;
+		return;
+	}
+
+	if (c->size != img->size) {
+		kfree(c->base);
+		c->base = kmalloc(img->size, GFP_KERNEL);
+		c->size = c->base ? img->size : 0;
+	}
+
+	if (c->base)
+		memcpy(c->base, img->base, img->size);
+}
+
+/**
+ * ipa3_fltrt_img_invalidate() - forget all images of a table type
+ * @c: the IPA3_FLTRT_IMG_MAX copies of one ip family
+ *
+ * The next commit then rewrites everything.
+ */
+void ipa3_fltrt_img_invalidate(struct ipa3_fltrt_img_cache *c)
+{
+	int i;
+
+	for (i = 0; i < IPA3_FLTRT_IMG_MAX; i++)
+		ipa3_fltrt_img_save(&c[i], NULL);
+}
+
+/**
+ * ipa3_fltrt_commit_account() - account a successful filter/route commit
+ * @stats: the statistics of the table type
+ * @start: when the commit started
+ * @sent: number of SRAM writes issued
+ * @skipped: number of SRAM writes left out
+ * @flush_skipped: whether the hash cache flush was left out
+ */
+void ipa3_fltrt_commit_account(struct ipa3_fltrt_commit_stats *stats,
+	ktime_t start, u32 sent, u32 skipped, bool flush_skipped)
+{
+	u32 us = (u32)ktime_us_delta(ktime_get(), start);
+
+	stats->commits++;
+	stats->dma_sent += sent;
+	stats->dma_skipped += skipped;
+	if (flush_skipped)
+		stats->flush_skipped++;
+	stats->total_us += us;
+	stats->max_us = max(stats->max_us, us);
+}
+
 int ipa3_alloc_rule_id(struct idr *rule_ids)
 {
 	/* There is two groups of rule-Ids, Modem ones and Apps ones.
@@ -91,6 +91,7 @@ struct ipa3_rmnet_plat_drv_res {
 	bool ipa_loaduC;
 	bool ipa_advertise_sg_support;
 	bool ipa_napi_enable;
+	bool ipa_napi_threaded;
 	u32 wan_rx_desc_size;
 };
 
@@ -1103,6 +1104,7 @@ static int ipa3_wwan_xmit(struct sk_buff *skb, struct net_device *dev)
 		current->comm);
 		dev_kfree_skb_any(skb);
 		dev->stats.tx_dropped++;
+		ipa3_tx_dp_flush(IPA_CLIENT_APPS_WAN_PROD);
 		return NETDEV_TX_OK;
 	}
 
@@ -1116,6 +1118,7 @@ static int ipa3_wwan_xmit(struct sk_buff *skb, struct net_device *dev)
 		} else {
 			pr_err("[%s]fatal: ipa3_wwan_xmit stopped\n",
 				  dev->name);
+			ipa3_tx_dp_flush(IPA_CLIENT_APPS_WAN_PROD);
 			return NETDEV_TX_BUSY;
 		}
 	}
@@ -1130,6 +1133,7 @@ static int ipa3_wwan_xmit(struct sk_buff *skb, struct net_device *dev)
 				netif_queue_stopped(dev));
 			IPAWANDBG_LOW("qmap_chk(%d)\n", qmap_check);
 			netif_stop_queue(dev);
+			ipa3_tx_dp_flush(IPA_CLIENT_APPS_WAN_PROD);
 			return NETDEV_TX_BUSY;
 		}
 	}
@@ -1140,6 +1144,7 @@ send:
 		IPA_RM_RESOURCE_WWAN_0_PROD);
 	if (ret == -EINPROGRESS) {
 		netif_stop_queue(dev);
+		ipa3_tx_dp_flush(IPA_CLIENT_APPS_WAN_PROD);
 		return NETDEV_TX_BUSY;
 	}
 	if (ret) {
@@ -1147,6 +1152,7 @@ send:
 		       dev->name, ret);
 		dev_kfree_skb_any(skb);
 		dev->stats.tx_dropped++;
+		ipa3_tx_dp_flush(IPA_CLIENT_APPS_WAN_PROD);
 		return -EFAULT;
 	}
 	/* IPA_RM checking end */
@@ -1163,6 +1169,7 @@ send:
 	}
 
 	if (ret) {
+		ipa3_tx_dp_flush(IPA_CLIENT_APPS_WAN_PROD);
 		ret = NETDEV_TX_BUSY;
 		goto out;
 	}
@@ -2076,6 +2083,12 @@ static int get_ipa_rmnet_dts_configuration(struct platform_device *pdev,
 	pr_info("IPA Napi Enable = %s\n",
 		ipa_rmnet_drv_res->ipa_napi_enable ? "True" : "False");
 
+	ipa_rmnet_drv_res->ipa_napi_threaded =
+		of_property_read_bool(pdev->dev.of_node,
+			"qcom,ipa-napi-threaded");
+	pr_info("IPA Napi Threaded = %s\n",
+		ipa_rmnet_drv_res->ipa_napi_threaded ? "True" : "False");
+
 	/* Get IPA WAN RX desc fifo size */
 	result = of_property_read_u32(pdev->dev.of_node,
 			"qcom,wan-rx-desc-size",
@@ -2271,6 +2284,10 @@ static int ipa3_wwan_probe(struct platform_device *pdev)
 		netif_napi_add(dev, &(rmnet_ipa3_ctx->wwan_priv->napi),
 		       ipa3_rmnet_poll, NAPI_WEIGHT);
 	ret = register_netdev(dev);
+	if (!ret && ipa3_rmnet_res.ipa_napi_enable &&
+	    ipa3_rmnet_res.ipa_napi_threaded &&
+	    dev_set_threaded(dev, true))
+		IPAWANERR("failed to enable threaded NAPI\n");
 	if (ret) {
 		IPAWANERR("unable to register ipa_netdev %d rc=%d\n",
 			0, ret);
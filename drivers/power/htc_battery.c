@@ -1953,6 +1953,26 @@ int htc_batt_schedule_batt_info_update(void)
         return 0;
 }
 
+/*
+ * Charger and gauge drivers report several properties back to back for
+ * one hardware event (status, capacity and health after a plug-in, say).
+ * Collect them into a single batt_worker run, and so a single uevent,
+ * rather than one run per property.
+ */
+static void htc_batt_schedule_event_update(void)
+{
+	if (!delayed_work_pending(&htc_batt_timer.batt_event_work)) {
+		wake_lock(&htc_batt_timer.battery_lock);
+		schedule_delayed_work(&htc_batt_timer.batt_event_work,
+				msecs_to_jiffies(BATT_EVENT_COALESCE_MS));
+	}
+}
+
+static void batt_event_worker(struct work_struct *work)
+{
+	htc_batt_schedule_batt_info_update();
+}
+
 #define USB_OVERHEAT_CHECK_PERIOD_MS 30000
 static void is_usb_overheat_worker(struct work_struct *work)
 {
@@ -2722,9 +2742,17 @@ static void batt_worker(struct work_struct *work)
 	htc_batt_timer.total_time_ms = 0; /* reset total time */
 	htc_batt_timer.batt_system_jiffies = cur_jiffies;
 
-	/* STEP 2: setup next batt uptate timer (can put in the last step)*/
+	/*
+	 * STEP 2: setup next batt uptate timer (can put in the last step).
+	 * Level changes are reported by the gauge as events, so with the
+	 * screen off and no charger attached nobody needs a fast poll.
+	 */
 	del_timer_sync(&htc_batt_timer.batt_timer);
-	batt_set_check_timer(htc_batt_timer.time_out);
+	if ((htc_batt_info.state & STATE_SCREEN_OFF) &&
+			htc_batt_info.rep.charging_source == 0)
+		batt_set_check_timer(BATT_TIMER_SCREEN_OFF_TIME);
+	else
+		batt_set_check_timer(htc_batt_timer.time_out);
 
 	/* STEP 3: update charging_source */
 	htc_batt_info.prev.charging_source = htc_batt_info.rep.charging_source;
@@ -3439,7 +3467,7 @@ void htc_battery_info_update(enum power_supply_property prop, int intval)
 				htc_stats_update_charging_statistics(g_latest_chg_src, htc_batt_info.rep.charging_source);
 #endif //CONFIG_HTC_BATT_PCN0021
 				htc_batt_info.rep.status = intval;
-				htc_batt_schedule_batt_info_update();
+				htc_batt_schedule_event_update();
 				if (!delayed_work_pending(&htc_batt_info.chg_full_check_work)
 					&& (g_latest_chg_src > POWER_SUPPLY_TYPE_UNKNOWN)) {
 						wake_lock(&htc_batt_info.charger_exist_lock);
@@ -3465,17 +3493,17 @@ void htc_battery_info_update(enum power_supply_property prop, int intval)
 		case POWER_SUPPLY_PROP_CAPACITY:
 			if (htc_batt_info.rep.level_raw != intval) {
 				htc_batt_info.rep.level_raw = intval;
-				htc_batt_schedule_batt_info_update();
+				htc_batt_schedule_event_update();
 			}
 			break;
 		case POWER_SUPPLY_PROP_HEALTH:
 			if (htc_batt_info.rep.health != intval) {
 				htc_batt_info.rep.health = intval;
-				htc_batt_schedule_batt_info_update();
+				htc_batt_schedule_event_update();
 			}
 			break;
 		case POWER_SUPPLY_PROP_SDP_CURRENT_MAX:
-			htc_batt_schedule_batt_info_update();
+			htc_batt_schedule_event_update();
 			break;
 		default:
 			break;
@@ -4586,6 +4614,7 @@ static int htc_battery_probe(struct platform_device *pdev)
 
 	htc_batt_info.icharger = &pdata->icharger;
 	INIT_WORK(&htc_batt_timer.batt_work, batt_worker);
+	INIT_DELAYED_WORK(&htc_batt_timer.batt_event_work, batt_event_worker);
 	INIT_DELAYED_WORK(&htc_batt_info.cable_impedance_work, cable_impedance_worker);
 	INIT_DELAYED_WORK(&htc_batt_info.chg_full_check_work, chg_full_check_worker);
 	INIT_DELAYED_WORK(&htc_batt_info.is_usb_overheat_work, is_usb_overheat_worker);
@@ -4595,7 +4624,7 @@ static int htc_battery_probe(struct platform_device *pdev)
 	INIT_DELAYED_WORK(&htc_batt_info.htcchg_init_work, htcchg_init_worker);
 	INIT_DELAYED_WORK(&htc_batt_info.htcchg_vbus_adjust_work, htcchg_vbus_adjust_worker);
 	INIT_DELAYED_WORK(&htc_batt_info.screen_ibat_limit_enable_work, screen_ibat_limit_enable_worker);
-	init_timer(&htc_batt_timer.batt_timer);
+	init_timer_deferrable(&htc_batt_timer.batt_timer);
 	htc_batt_timer.batt_timer.function = batt_regular_timer_handler;
 	alarm_init(&htc_batt_timer.batt_check_wakeup_alarm, ALARM_REALTIME,
 			batt_check_alarm_handler);
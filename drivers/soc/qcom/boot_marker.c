@@ -25,12 +25,14 @@
 #include <linux/export.h>
 #include <linux/types.h>
 #include <linux/mutex.h>
+#include <linux/seq_file.h>
 #include <soc/qcom/boot_stats.h>
 
 #define MAX_STRING_LEN 256
 #define BOOT_MARKER_MAX_LEN 40
+/* initcalls faster than this are left out of the timeline */
+#define BOOT_MARKER_INITCALL_MIN_NS (5 * NSEC_PER_MSEC)
 static struct dentry *dent_bkpi, *dent_bkpi_status;
-static struct boot_marker boot_marker_list;
 
 struct boot_marker {
 	char marker_name[BOOT_MARKER_MAX_LEN];
@@ -39,6 +41,15 @@ struct boot_marker {
 	struct mutex lock;
 };
 
+/*
+ * Statically initialized so that markers can be placed from initcalls that
+ * run before init_bootkpi().
+ */
+static struct boot_marker boot_marker_list = {
+	.list = LIST_HEAD_INIT(boot_marker_list.list),
+	.lock = __MUTEX_INITIALIZER(boot_marker_list.lock),
+};
+
 static void _create_boot_marker(const char *name,
 					unsigned long long int timer_value)
 {
@@ -84,31 +95,36 @@ void place_marker(const char *name)
 }
 EXPORT_SYMBOL(place_marker);
 
-static ssize_t bootkpi_reader(struct file *fp, char __user *user_buffer,
-			size_t count, loff_t *position)
+/*
+ * Record the duration of a slow initcall as a "D - " marker, converted to
+ * sclk ticks so it reads the same as the bootloader durations.
+ */
+void place_initcall_marker(void *fn, u64 duration_ns)
 {
-	int rc = 0;
-	char *buf;
-	int temp = 0;
-	struct boot_marker *marker;
+	char name[BOOT_MARKER_MAX_LEN];
+
+	if (duration_ns < BOOT_MARKER_INITCALL_MIN_NS)
+		return;
+
+	snprintf(name, sizeof(name), "D - %pf", fn);
+	_create_boot_marker(name,
+		div_u64(duration_ns * TIMER_KHZ, NSEC_PER_SEC));
+}
 
-	buf = kmalloc(PAGE_SIZE, GFP_KERNEL);
-	if (!buf)
-		return -ENOMEM;
+static int bootkpi_show(struct seq_file *s, void *unused)
+{
+	struct boot_marker *marker;
 
 	mutex_lock(&boot_marker_list.lock);
 	list_for_each_entry(marker, &boot_marker_list.list, list) {
-		temp += scnprintf(buf + temp, PAGE_SIZE - temp,
-			"%-41s:%llu.%03llu seconds\n",
+		seq_printf(s, "%-41s:%llu.%03llu seconds\n",
 			marker->marker_name,
 			marker->timer_value/TIMER_KHZ,
 			(((marker->timer_value % TIMER_KHZ)
 			* 1000) / TIMER_KHZ));
 	}
 	mutex_unlock(&boot_marker_list.lock);
-	rc = simple_read_from_buffer(user_buffer, count, position, buf, temp);
-	kfree(buf);
-	return rc;
+	return 0;
 }
 
 static ssize_t bootkpi_writer(struct file *fp, const char __user *user_buffer,
@@ -130,14 +146,16 @@ static ssize_t bootkpi_writer(struct file *fp, const char __user *user_buffer,
 
 static int bootkpi_open(struct inode *inode, struct file *file)
 {
-	return 0;
+	return single_open(file, bootkpi_show, NULL);
 }
 
 static const struct file_operations fops_bkpi = {
 	.owner = THIS_MODULE,
 	.open  = bootkpi_open,
-	.read  = bootkpi_reader,
+	.read  = seq_read,
 	.write = bootkpi_writer,
+	.llseek = seq_lseek,
+	.release = single_release,
 };
 
 static int __init init_bootkpi(void)
@@ -155,8 +173,6 @@ static int __init init_bootkpi(void)
 		return -ENODEV;
 	}
 
-	INIT_LIST_HEAD(&boot_marker_list.list);
-	mutex_init(&boot_marker_list.lock);
 	set_bootloader_stats();
 	return 0;
 }
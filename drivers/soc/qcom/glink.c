@@ -14,6 +14,7 @@
 #include <linux/ipc_logging.h>
 #include <linux/kthread.h>
 #include <linux/list.h>
+#include <linux/log2.h>
 #include <linux/spinlock.h>
 #include <linux/module.h>
 #include <linux/mutex.h>
@@ -39,6 +40,22 @@
 
 #define GLINK_KTHREAD_PRIO 1
 
+/*
+ * Core-owned RX intent pool (GLINK_OPT_RX_INTENT_POOL).  Received packet
+ * sizes are kept in a power-of-two histogram from GLINK_RX_POOL_MIN_SIZE up
+ * to GLINK_RX_POOL_MAX_SIZE; the pool keeps GLINK_RX_POOL_DEPTH intents of
+ * the most frequent size posted.  The histogram is halved every
+ * GLINK_RX_POOL_DECAY packets so that it follows changes in the traffic.
+ */
+#define GLINK_RX_POOL_MIN_SHIFT		6
+#define GLINK_RX_POOL_MAX_SHIFT		14
+#define GLINK_RX_POOL_MIN_SIZE		(1 << GLINK_RX_POOL_MIN_SHIFT)
+#define GLINK_RX_POOL_MAX_SIZE		(1 << GLINK_RX_POOL_MAX_SHIFT)
+#define GLINK_RX_POOL_BUCKETS \
+		(GLINK_RX_POOL_MAX_SHIFT - GLINK_RX_POOL_MIN_SHIFT + 1)
+#define GLINK_RX_POOL_DEPTH		4
+#define GLINK_RX_POOL_DECAY		256
+
 /**
  * struct glink_qos_priority_bin - Packet Scheduler's priority bucket
  * @max_rate_kBps:	Maximum rate supported by the priority bucket.
@@ -232,6 +249,14 @@ static DEFINE_MUTEX(edge_list_lock_lhd0);
  * @tx_cnt:				Packets to be picked by tx scheduler.
  * @rt_vote_on:				Number of times RT vote on is called.
  * @rt_vote_off:			Number of times RT vote off is called.
+ *
+ * @rx_pool:				Core maintains an RX intent pool
+ * @rx_pool_work:			Posts intents to the RX intent pool
+ * @rx_pool_avail:			Pool intents queued and not yet used
+ * @rx_pool_req:			Size of a remote intent request that
+ *					the pool has to answer
+ * @rx_pool_samples:			Packets since the last histogram decay
+ * @rx_pool_hist:			Received packet size histogram
 */
 struct channel_ctx {
 	struct rwref_lock ch_state_lhb2;
@@ -314,6 +339,13 @@ struct channel_ctx {
 
 	uint32_t rt_vote_on;
 	uint32_t rt_vote_off;
+
+	bool rx_pool;
+	struct work_struct rx_pool_work;
+	uint32_t rx_pool_avail;
+	size_t rx_pool_req;
+	uint32_t rx_pool_samples;
+	uint32_t rx_pool_hist[GLINK_RX_POOL_BUCKETS];
 };
 
 static struct glink_core_if core_impl;
@@ -435,6 +467,7 @@ static bool ch_update_local_state(struct channel_ctx *ctx,
 static bool ch_update_rmt_state(struct channel_ctx *ctx, bool rstate);
 static void glink_core_deinit_xprt_qos_cfg(
 			struct glink_core_xprt_ctx *xprt_ptr);
+static void glink_rx_pool_refill(struct work_struct *work);
 
 #define glink_prio_to_power_state(xprt_ctx, priority) \
 		((xprt_ctx)->prio_bin[priority].power_state)
@@ -1338,6 +1371,7 @@ struct glink_core_rx_intent *ch_push_local_rx_intent(struct channel_ctx *ctx,
 	intent->write_offset = 0;
 	intent->pkt_size = 0;
 	intent->bounce_buf = NULL;
+	intent->pooled = false;
 
 	spin_lock_irqsave(&ctx->local_rx_intent_lst_lock_lhc1, flags);
 	list_add_tail(&intent->list, &ctx->local_rx_intent_list);
@@ -1434,6 +1468,7 @@ struct glink_core_rx_intent *ch_get_dummy_rx_intent(struct channel_ctx *ctx,
 	intent->write_offset = 0;
 	intent->pkt_size = 0;
 	intent->bounce_buf = NULL;
+	intent->pooled = false;
 	intent->pkt_priv = NULL;
 
 	spin_lock_irqsave(&ctx->local_rx_intent_lst_lock_lhc1, flags);
@@ -1631,6 +1666,202 @@ struct glink_core_rx_intent *ch_get_free_local_rx_intent(
 	return ptr_intent;
 }
 
+/**
+ * glink_rx_pool_bucket() - Histogram bucket of a packet size
+ * @size:	Packet size
+ *
+ * Return: The bucket index, or -1 if @size is too large to be pooled.
+ */
+static int glink_rx_pool_bucket(size_t size)
+{
+	if (size > GLINK_RX_POOL_MAX_SIZE)
+		return -1;
+	if (size <= GLINK_RX_POOL_MIN_SIZE)
+		return 0;
+	return ilog2(roundup_pow_of_two(size)) - GLINK_RX_POOL_MIN_SHIFT;
+}
+
+/**
+ * glink_rx_pool_size() - Intent size the pool should keep posted
+ * @ctx:	Local channel context
+ *
+ * Must be called with local_rx_intent_lst_lock_lhc1 held.
+ *
+ * Return: Size of the most frequently received packets, 0 if nothing has
+ *         been received yet.
+ */
+static size_t glink_rx_pool_size(struct channel_ctx *ctx)
+{
+	uint32_t max = 0;
+	int i, hot = -1;
+
+	for (i = 0; i < GLINK_RX_POOL_BUCKETS; i++) {
+		if (ctx->rx_pool_hist[i] > max) {
+			max = ctx->rx_pool_hist[i];
+			hot = i;
+		}
+	}
+	if (hot < 0)
+		return 0;
+	return 1 << (hot + GLINK_RX_POOL_MIN_SHIFT);
+}
+
+/**
+ * glink_rx_pool_kick() - Schedule a refill of the RX intent pool
+ * @ctx:	Local channel context
+ *
+ * The work holds a reference to the channel which it drops when done.
+ */
+static void glink_rx_pool_kick(struct channel_ctx *ctx)
+{
+	rwref_get(&ctx->ch_state_lhb2);
+	if (!schedule_work(&ctx->rx_pool_work))
+		rwref_put(&ctx->ch_state_lhb2);
+}
+
+/**
+ * glink_rx_pool_account() - Account a received packet to the RX intent pool
+ * @ctx:	Local channel context
+ * @intent:	Intent the packet was received into
+ *
+ * Records the packet size in the histogram and refills the pool once it runs
+ * below GLINK_RX_POOL_DEPTH intents.
+ */
+static void glink_rx_pool_account(struct channel_ctx *ctx,
+				  struct glink_core_rx_intent *intent)
+{
+	unsigned long flags;
+	bool refill;
+	int bucket;
+	int i;
+
+	if (!ctx->rx_pool ||
+	    (ctx->transport_ptr->capabilities & GCAP_INTENTLESS))
+		return;
+
+	spin_lock_irqsave(&ctx->local_rx_intent_lst_lock_lhc1, flags);
+	bucket = glink_rx_pool_bucket(intent->pkt_size);
+	if (bucket >= 0)
+		ctx->rx_pool_hist[bucket]++;
+	if (++ctx->rx_pool_samples >= GLINK_RX_POOL_DECAY) {
+		for (i = 0; i < GLINK_RX_POOL_BUCKETS; i++)
+			ctx->rx_pool_hist[i] >>= 1;
+		ctx->rx_pool_samples = 0;
+	}
+	if (intent->pooled && ctx->rx_pool_avail)
+		ctx->rx_pool_avail--;
+	refill = ctx->rx_pool_avail < GLINK_RX_POOL_DEPTH;
+	spin_unlock_irqrestore(&ctx->local_rx_intent_lst_lock_lhc1, flags);
+
+	if (refill)
+		glink_rx_pool_kick(ctx);
+}
+
+/**
+ * glink_rx_pool_recycle() - Decide whether a pool intent is reused
+ * @ctx:	Local channel context
+ * @intent:	Intent returned through glink_rx_done()
+ * @reuse:	Reuse requested by the client
+ *
+ * A pool intent the client does not reuse is put back in the pool instead of
+ * being freed as long as the pool is short of intents and the intent still
+ * fits the traffic.  A reused pool intent is counted as available again.
+ *
+ * Return: true if the intent is to be reused.
+ */
+static bool glink_rx_pool_recycle(struct channel_ctx *ctx,
+				  struct glink_core_rx_intent *intent,
+				  bool reuse)
+{
+	unsigned long flags;
+
+	if (!ctx->rx_pool || !intent->pooled)
+		return reuse;
+
+	spin_lock_irqsave(&ctx->local_rx_intent_lst_lock_lhc1, flags);
+	if (!reuse)
+		reuse = ctx->rx_pool_avail < GLINK_RX_POOL_DEPTH &&
+			intent->intent_size >= glink_rx_pool_size(ctx);
+	if (reuse)
+		ctx->rx_pool_avail++;
+	spin_unlock_irqrestore(&ctx->local_rx_intent_lst_lock_lhc1, flags);
+	return reuse;
+}
+
+/**
+ * glink_rx_pool_intent_req() - Answer a remote intent request from the pool
+ * @ctx:	Local channel context
+ * @size:	Requested intent size
+ *
+ * Return: true if the pool will queue an intent of @size, false if the
+ *         request has to go to the client.
+ */
+static bool glink_rx_pool_intent_req(struct channel_ctx *ctx, size_t size)
+{
+	unsigned long flags;
+
+	if (!ctx->rx_pool || glink_rx_pool_bucket(size) < 0)
+		return false;
+
+	spin_lock_irqsave(&ctx->local_rx_intent_lst_lock_lhc1, flags);
+	ctx->rx_pool_req = max(ctx->rx_pool_req, size);
+	spin_unlock_irqrestore(&ctx->local_rx_intent_lst_lock_lhc1, flags);
+	glink_rx_pool_kick(ctx);
+	return true;
+}
+
+/**
+ * glink_rx_pool_refill() - Worker posting intents to the RX intent pool
+ * @work:	The rx_pool_work of the channel
+ *
+ * Answers a pending remote intent request first, then tops the pool up to
+ * GLINK_RX_POOL_DEPTH intents of the most frequently received size.
+ */
+static void glink_rx_pool_refill(struct work_struct *work)
+{
+	struct channel_ctx *ctx = container_of(work, struct channel_ctx,
+						rx_pool_work);
+	struct glink_core_rx_intent *intent;
+	unsigned long flags;
+	size_t size;
+	int ret;
+
+	while (ctx->rx_pool && ch_is_fully_opened(ctx) &&
+	       !(ctx->transport_ptr->capabilities & GCAP_INTENTLESS)) {
+		spin_lock_irqsave(&ctx->local_rx_intent_lst_lock_lhc1, flags);
+		size = ctx->rx_pool_req;
+		ctx->rx_pool_req = 0;
+		if (!size && ctx->rx_pool_avail < GLINK_RX_POOL_DEPTH)
+			size = glink_rx_pool_size(ctx);
+		spin_unlock_irqrestore(&ctx->local_rx_intent_lst_lock_lhc1,
+				       flags);
+		if (!size)
+			break;
+
+		size = max_t(size_t, roundup_pow_of_two(size),
+			     GLINK_RX_POOL_MIN_SIZE);
+		intent = ch_push_local_rx_intent(ctx, NULL, size);
+		if (!intent)
+			break;
+		intent->pooled = true;
+
+		ret = ctx->transport_ptr->ops->tx_cmd_local_rx_intent(
+			ctx->transport_ptr->ops, ctx->lcid, size, intent->id);
+		if (ret) {
+			ch_remove_local_rx_intent(ctx, intent->id);
+			break;
+		}
+		GLINK_DBG_CH(ctx, "%s: L[%u]:%zu pool intent\n", __func__,
+			     intent->id, size);
+
+		spin_lock_irqsave(&ctx->local_rx_intent_lst_lock_lhc1, flags);
+		ctx->rx_pool_avail++;
+		spin_unlock_irqrestore(&ctx->local_rx_intent_lst_lock_lhc1,
+				       flags);
+	}
+	rwref_put(&ctx->ch_state_lhb2);
+}
+
 /**
  * ch_purge_intent_lists() - Remove all intents for a channel
  *
@@ -1688,6 +1919,8 @@ void ch_purge_intent_lists(struct channel_ctx *ctx)
 		kfree(ptr_intent);
 	}
 	ctx->max_used_liid = 0;
+	ctx->rx_pool_avail = 0;
+	ctx->rx_pool_req = 0;
 	spin_unlock_irqrestore(&ctx->local_rx_intent_lst_lock_lhc1, flags);
 
 	spin_lock_irqsave(&ctx->rmt_rx_intent_lst_lock_lhc2, flags);
@@ -1868,6 +2101,7 @@ static struct channel_ctx *ch_name_to_ch_ctx_create(
 	spin_lock_init(&ctx->rmt_rx_intent_lst_lock_lhc2);
 	INIT_LIST_HEAD(&ctx->tx_active);
 	spin_lock_init(&ctx->tx_pending_rmt_done_lock_lhc4);
+	INIT_WORK(&ctx->rx_pool_work, glink_rx_pool_refill);
 	INIT_LIST_HEAD(&ctx->tx_pending_remote_done);
 	spin_lock_init(&ctx->tx_lists_lock_lhc3);
 
@@ -2645,6 +2879,12 @@ void *glink_open(const struct glink_open_config *cfg)
 	if (!ctx->rx_intent_req_timeout_jiffies)
 		ctx->rx_intent_req_timeout_jiffies = MAX_SCHEDULE_TIMEOUT;
 
+	ctx->rx_pool = !!(cfg->options & GLINK_OPT_RX_INTENT_POOL);
+	ctx->rx_pool_avail = 0;
+	ctx->rx_pool_req = 0;
+	ctx->rx_pool_samples = 0;
+	memset(ctx->rx_pool_hist, 0, sizeof(ctx->rx_pool_hist));
+
 	ctx->local_xprt_req = best_id;
 	ctx->no_migrate = cfg->transport &&
 				!(cfg->options & GLINK_OPT_INITIAL_XPORT);
@@ -3195,6 +3435,7 @@ int glink_rx_done(void *handle, const void *ptr, bool reuse)
 {
 	struct channel_ctx *ctx = (struct channel_ctx *)handle;
 	struct glink_core_rx_intent *liid_ptr;
+	unsigned long flags;
 	uint32_t id;
 	int ret = 0;
 
@@ -3213,6 +3454,7 @@ int glink_rx_done(void *handle, const void *ptr, bool reuse)
 	GLINK_INFO_PERF_CH(ctx, "%s: L[%u]: data[%p]. TID %u\n",
 			__func__, liid_ptr->id, ptr, current->pid);
 	id = liid_ptr->id;
+	reuse = glink_rx_pool_recycle(ctx, liid_ptr, reuse);
 	if (reuse) {
 		ret = ctx->transport_ptr->ops->reuse_rx_intent(
 					ctx->transport_ptr->ops, liid_ptr);
@@ -3221,6 +3463,15 @@ int glink_rx_done(void *handle, const void *ptr, bool reuse)
 					__func__, ret, ptr);
 			ret = -ENOBUFS;
 			reuse = false;
+			if (ctx->rx_pool && liid_ptr->pooled) {
+				spin_lock_irqsave(
+					&ctx->local_rx_intent_lst_lock_lhc1,
+					flags);
+				ctx->rx_pool_avail--;
+				spin_unlock_irqrestore(
+					&ctx->local_rx_intent_lst_lock_lhc1,
+					flags);
+			}
 			ctx->transport_ptr->ops->deallocate_rx_intent(
 					ctx->transport_ptr->ops, liid_ptr);
 		}
@@ -5132,7 +5383,8 @@ static void glink_core_remote_rx_intent_put_cookie(
  *
  * The function searches for the local channel to which the request for
  * rx_intent has arrived and informs this request to the local channel through
- * notify_rx_intent_req callback registered by the local channel.
+ * notify_rx_intent_req callback registered by the local channel, unless the
+ * RX intent pool of the channel takes the request.
  */
 static void glink_core_rx_cmd_remote_rx_intent_req(
 	struct glink_transport_if *if_ptr, uint32_t rcid, size_t size)
@@ -5155,7 +5407,9 @@ static void glink_core_rx_cmd_remote_rx_intent_req(
 		return;
 	}
 
-	cb_ret = ctx->notify_rx_intent_req(ctx, ctx->user_priv, size);
+	cb_ret = glink_rx_pool_intent_req(ctx, size);
+	if (!cb_ret)
+		cb_ret = ctx->notify_rx_intent_req(ctx, ctx->user_priv, size);
 	if_ptr->tx_cmd_remote_rx_intent_req_ack(if_ptr, ctx->lcid, cb_ret);
 	rwref_put(&ctx->ch_state_lhb2);
 }
@@ -5262,6 +5516,7 @@ void glink_core_rx_put_pkt_ctx(struct glink_transport_if *if_ptr,
 		return;
 	}
 
+	glink_rx_pool_account(ctx, intent_ptr);
 	if (unlikely(intent_ptr->tracer_pkt)) {
 		tracer_pkt_log_event(intent_ptr->data, GLINK_CORE_RX);
 		ch_set_local_rx_intent_notified(ctx, intent_ptr);
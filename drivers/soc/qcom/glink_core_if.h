@@ -85,6 +85,7 @@ struct glink_core_rx_intent {
 	struct list_head list;
 	const void *pkt_priv;
 	void *bounce_buf;
+	bool pooled;
 };
 
 /**
@@ -52,6 +52,7 @@
 #define RPM_FIFO_ADDR_ALIGN_BYTES 3
 #define TRACER_PKT_FEATURE BIT(2)
 #define DEFERRED_CMDS_THRESHOLD 25
+#define RX_IRQ_BUDGET SZ_16K /* fifo bytes drained per irq before deferring */
 /**
  * enum command_types - definition of the types of commands sent/received
  * @VERSION_CMD:		Version and feature set supported
@@ -149,6 +150,9 @@ struct mailbox_config_info {
  * @irq_line:			The incoming interrupt line.
  * @tx_irq_count:		Number of interrupts triggered.
  * @rx_irq_count:		Number of interrupts received.
+ * @rx_irq_deferred:		Number of interrupts that ran out of
+ *				RX_IRQ_BUDGET and left the rest of the fifo
+ *				to @kworker.
  * @tx_ch_desc:			Reference to the channel description structure
  *				for tx in SMEM for this edge.
  * @rx_ch_desc:			Reference to the channel description structure
@@ -199,6 +203,7 @@ struct edge_info {
 	uint32_t irq_line;
 	uint32_t tx_irq_count;
 	uint32_t rx_irq_count;
+	uint32_t rx_irq_deferred;
 	struct channel_desc *tx_ch_desc;
 	struct channel_desc *rx_ch_desc;
 	void __iomem *tx_fifo;
@@ -849,11 +854,32 @@ static void tx_wakeup_worker(struct edge_info *einfo)
 		wake_up_all(&einfo->tx_blocked_queue);
 }
 
+/**
+ * fifo_read_distance() - bytes read from the rx fifo since an earlier index
+ * @einfo:	The concerned edge.
+ * @from:	The rx read index sampled earlier.
+ *
+ * Return: The number of bytes consumed between @from and now.
+ */
+static uint32_t fifo_read_distance(struct edge_info *einfo, uint32_t from)
+{
+	uint32_t read_index = einfo->rx_ch_desc->read_index;
+
+	if (read_index >= from)
+		return read_index - from;
+	return einfo->rx_fifo_size - from + read_index;
+}
+
 /**
  * __rx_worker() - process received commands on a specific edge
  * @einfo:	Edge to process commands on.
  * @atomic_ctx:	Indicates if the caller is in atomic context and requires any
  *		non-atomic operations to be deferred.
+ *
+ * In atomic context at most RX_IRQ_BUDGET bytes are drained from the fifo.
+ * Small messages are so handled straight from the irq, while the tail of a
+ * large burst is handed to @kworker instead of being copied with interrupts
+ * disabled.
  */
 static void __rx_worker(struct edge_info *einfo, bool atomic_ctx)
 {
@@ -880,6 +906,8 @@ static void __rx_worker(struct edge_info *einfo, bool atomic_ctx)
 	char trash[FIFO_ALIGNMENT];
 	struct deferred_cmd *d_cmd;
 	void *cmd_data;
+	uint32_t budget = RX_IRQ_BUDGET;
+	uint32_t read_index;
 
 	rcu_id = srcu_read_lock(&einfo->use_ref);
 
@@ -922,6 +950,13 @@ static void __rx_worker(struct edge_info *einfo, bool atomic_ctx)
 		    einfo->deferred_cmds_cnt >= DEFERRED_CMDS_THRESHOLD)
 			break;
 
+		if (atomic_ctx && !budget) {
+			einfo->rx_irq_deferred++;
+			queue_kthread_work(&einfo->kworker, &einfo->kwork);
+			break;
+		}
+		read_index = einfo->rx_ch_desc->read_index;
+
 		if (!atomic_ctx && !list_empty(&einfo->deferred_cmds)) {
 			d_cmd = list_first_entry(&einfo->deferred_cmds,
 						struct deferred_cmd, list_node);
@@ -1189,6 +1224,10 @@ static void __rx_worker(struct edge_info *einfo, bool atomic_ctx)
 			pr_err("Unrecognized command: %d\n", cmd.id);
 			break;
 		}
+
+		if (atomic_ctx)
+			budget -= min(budget,
+				      fifo_read_distance(einfo, read_index));
 	}
 	spin_unlock_irqrestore(&einfo->rx_lock, flags);
 	srcu_read_unlock(&einfo->use_ref, rcu_id);
@@ -3015,11 +3054,13 @@ ID|EDGE      |TX READ   |TX WRITE  |TX SIZE   |RX READ   |RX WRITE  |RX SIZE
 						einfo->rx_fifo_size);
 
 	seq_puts(s, "\nInterrupt information:\n");
-	seq_printf(s, "%-10s|%-10s|%-10s\n", "EDGE", "TX INT", "RX INT");
-	seq_puts(s, "--------------------------------\n");
-	seq_printf(s, "%-10s|0x%08X|0x%08X\n", einfo->xprt_cfg.edge,
+	seq_printf(s, "%-10s|%-10s|%-10s|%-10s\n", "EDGE", "TX INT", "RX INT",
+								"RX DEFER");
+	seq_puts(s, "-------------------------------------------\n");
+	seq_printf(s, "%-10s|0x%08X|0x%08X|0x%08X\n", einfo->xprt_cfg.edge,
 						einfo->tx_irq_count,
-						einfo->rx_irq_count);
+						einfo->rx_irq_count,
+						einfo->rx_irq_deferred);
 }
 
 /**
@@ -324,9 +324,13 @@ static bool ipc_router_glink_xprt_latency_info(struct msm_ipc_router_xprt *xprt)
 	return glink_xprtp->low_latency_xprt;
 }
 
+/*
+ * Copy the received G-Link packet into a single linear skb, so that the
+ * router never has to defragment it when forwarding.
+ */
 static struct rr_packet *glink_xprt_copy_data(struct read_work *rx_work)
 {
-	void *buf, *pbuf, *dest_buf;
+	void *buf, *pbuf;
 	size_t buf_size;
 	struct rr_packet *pkt;
 	struct sk_buff *skb;
@@ -337,7 +341,16 @@ static struct rr_packet *glink_xprt_copy_data(struct read_work *rx_work)
 		return NULL;
 	}
 
-	do {
+	skb = alloc_skb(rx_work->iovec_size, GFP_KERNEL);
+	if (!skb) {
+		IPC_RTR_ERR("%s: Couldn't alloc skb of size %zu\n",
+			    __func__, rx_work->iovec_size);
+		release_pkt(pkt);
+		return NULL;
+	}
+	skb_queue_tail(pkt->pkt_fragment_q, skb);
+
+	while (pkt->length < rx_work->iovec_size) {
 		buf_size = 0;
 		if (rx_work->vbuf_provider) {
 			buf = rx_work->vbuf_provider(rx_work->iovec,
@@ -350,18 +363,11 @@ static struct rr_packet *glink_xprt_copy_data(struct read_work *rx_work)
 		if (!buf_size || !buf)
 			break;
 
-		skb = alloc_skb(buf_size, GFP_KERNEL);
-		if (!skb) {
-			IPC_RTR_ERR("%s: Couldn't alloc skb of size %zu\n",
-				    __func__, buf_size);
-			release_pkt(pkt);
-			return NULL;
-		}
-		dest_buf = skb_put(skb, buf_size);
-		memcpy(dest_buf, buf, buf_size);
-		skb_queue_tail(pkt->pkt_fragment_q, skb);
+		buf_size = min_t(size_t, buf_size,
+				 rx_work->iovec_size - pkt->length);
+		memcpy(skb_put(skb, buf_size), buf, buf_size);
 		pkt->length += buf_size;
-	} while (buf && buf_size);
+	}
 	return pkt;
 }
 
@@ -391,8 +397,7 @@ static void glink_xprt_read_data(struct kthread_work *work)
 	}
 
 	msm_ipc_router_xprt_notify(&glink_xprtp->xprt,
-				   IPC_ROUTER_XPRT_EVENT_DATA, pkt);
-	release_pkt(pkt);
+				   IPC_ROUTER_XPRT_EVENT_DATA_OWNED, pkt);
 out_read_data:
 	glink_rx_done(glink_xprtp->ch_hndl, rx_work->iovec, reuse_intent);
 	kfree(rx_work);
@@ -676,6 +676,31 @@ static void add_node_to_clist(struct msm_bus_node_device_type *node)
 	}
 }
 
+/*
+ * Every lnode along a path carries the same request, so the first hop tells
+ * whether a new request for the path differs from the one in place.
+ */
+static bool path_unchanged(struct device *src_dev, int src_idx,
+			uint64_t act_req_ib, uint64_t act_req_bw,
+			uint64_t slp_req_ib, uint64_t slp_req_bw)
+{
+	struct msm_bus_node_device_type *dev_info;
+	struct link_node *lnode;
+
+	if (IS_ERR_OR_NULL(src_dev) || src_idx < 0)
+		return false;
+
+	dev_info = to_msm_bus_node(src_dev);
+	if (src_idx >= dev_info->num_lnodes)
+		return false;
+
+	lnode = &dev_info->lnode_list[src_idx];
+	return lnode->lnode_ib[ACTIVE_CTX] == act_req_ib &&
+		lnode->lnode_ab[ACTIVE_CTX] == act_req_bw &&
+		lnode->lnode_ib[DUAL_CTX] == slp_req_ib &&
+		lnode->lnode_ab[DUAL_CTX] == slp_req_bw;
+}
+
 static int update_path(struct device *src_dev, int dest, uint64_t act_req_ib,
 			uint64_t act_req_bw, uint64_t slp_req_ib,
 			uint64_t slp_req_bw, uint64_t cur_ib, uint64_t cur_bw,
@@ -1050,6 +1075,7 @@ static int update_client_paths(struct msm_bus_client *client, bool log_trns,
 	int i, ret = 0;
 	struct msm_bus_scale_pdata *pdata;
 	struct device *src_dev;
+	bool updated = false;
 
 	if (!client) {
 		MSM_BUS_ERR("Client handle  Null");
@@ -1093,6 +1119,11 @@ static int update_client_paths(struct msm_bus_client *client, bool log_trns,
 			slp_bw = req_bw;
 		}
 
+		/* usecases often share the vote of some of their paths */
+		if (path_unchanged(src_dev, lnode, req_clk, req_bw, slp_clk,
+					slp_bw))
+			continue;
+
 		ret = update_path(src_dev, dest, req_clk, req_bw, slp_clk,
 			slp_bw, curr_clk, curr_bw, lnode, pdata->active_only);
 
@@ -1101,11 +1132,13 @@ static int update_client_paths(struct msm_bus_client *client, bool log_trns,
 					__func__, ret, pdata->active_only);
 			goto exit_update_client_paths;
 		}
+		updated = true;
 
 		if (log_trns)
 			getpath_debug(src, lnode, pdata->active_only);
 	}
-	commit_data();
+	if (updated)
+		commit_data();
 exit_update_client_paths:
 	return ret;
 }
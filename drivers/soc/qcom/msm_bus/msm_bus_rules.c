@@ -10,6 +10,7 @@
  * GNU General Public License for more details.
  */
 
+#include <linux/hashtable.h>
 #include <linux/list_sort.h>
 #include <linux/msm-bus-board.h>
 #include <linux/msm_bus_rules.h>
@@ -25,11 +26,30 @@ struct node_vote_info {
 	u64 clk;
 };
 
+struct rule_node_info;
+struct rules_def;
+
+/*
+ * One entry per (rule, source) pair, hashed by source node id so that a
+ * vote only visits the rules that actually reference the voting node.
+ */
+struct rule_src_ref {
+	int id;
+	int idx;
+	struct rules_def *rule;
+	struct rule_node_info *node;
+	struct hlist_node hash;
+};
+
 struct rules_def {
 	int rule_id;
 	int num_src;
 	int state;
 	struct node_vote_info *src_info;
+	struct rule_src_ref *src_refs;
+	/* running sum of src_field over all sources */
+	u64 field;
+	bool evaluated;
 	struct bus_rule_type rule_ops;
 	bool state_change;
 	struct list_head link;
@@ -41,13 +61,17 @@ struct rule_node_info {
 	struct raw_notifier_head rule_notify_list;
 	struct rules_def *cur_rule;
 	int num_rules;
+	bool dirty;
 	struct list_head node_rules;
 	struct list_head link;
 	struct rule_apply_rcm_info apply;
 };
 
+#define RULE_SRC_HASH_BITS	5
+
 DEFINE_MUTEX(msm_bus_rules_lock);
 static LIST_HEAD(node_list);
+static DEFINE_HASHTABLE(rule_src_tbl, RULE_SRC_HASH_BITS);
 static struct rule_node_info *get_node(u32 id, void *data);
 static int node_rules_compare(void *priv, struct list_head *a,
 					struct list_head *b);
@@ -138,47 +162,26 @@ static bool do_compare_op(u64 op1, u64 op2, int op)
 	return ret;
 }
 
-static void update_src_id_vote(struct rule_update_path_info *inp_node,
-				struct rule_node_info *rule_node)
-{
-	struct rules_def *rule;
-	int i;
-
-	list_for_each_entry(rule, &rule_node->node_rules, link) {
-		for (i = 0; i < rule->num_src; i++) {
-			if (rule->src_info[i].id == inp_node->id) {
-				rule->src_info[i].ib = inp_node->ib;
-				rule->src_info[i].ab = inp_node->ab;
-				rule->src_info[i].clk = inp_node->clk;
-			}
-		}
-	}
-}
-
-static u64 get_field(struct rules_def *rule, int src_id)
+static u64 get_src_field(struct rules_def *rule, struct node_vote_info *src)
 {
 	u64 field = 0;
-	int i;
 
-	for (i = 0; i < rule->num_src; i++) {
-		switch (rule->rule_ops.src_field) {
-		case FLD_IB:
-			field += rule->src_info[i].ib;
-			break;
-		case FLD_AB:
-			field += rule->src_info[i].ab;
-			break;
-		case FLD_CLK:
-			field += rule->src_info[i].clk;
-			break;
-		}
+	switch (rule->rule_ops.src_field) {
+	case FLD_IB:
+		field = src->ib;
+		break;
+	case FLD_AB:
+		field = src->ab;
+		break;
+	case FLD_CLK:
+		field = src->clk;
+		break;
 	}
 
 	return field;
 }
 
-static bool check_rule(struct rules_def *rule,
-			struct rule_update_path_info *inp)
+static bool check_rule(struct rules_def *rule)
 {
 	bool ret = false;
 
@@ -190,12 +193,9 @@ static bool check_rule(struct rules_def *rule,
 	case OP_LT:
 	case OP_GT:
 	case OP_GE:
-	{
-		u64 src_field = get_field(rule, inp->id);
-		ret = do_compare_op(src_field, rule->rule_ops.thresh,
+		ret = do_compare_op(rule->field, rule->rule_ops.thresh,
 							rule->rule_ops.op);
 		break;
-	}
 	default:
 		pr_err("Unsupported op %d", rule->rule_ops.op);
 		break;
@@ -204,33 +204,80 @@ static bool check_rule(struct rules_def *rule,
 }
 
 static void match_rule(struct rule_update_path_info *inp_node,
-			struct rule_node_info *node)
+			struct rule_src_ref *ref)
+{
+	struct rules_def *rule = ref->rule;
+	struct rule_node_info *node = ref->node;
+
+	if (check_rule(rule)) {
+		trace_bus_rules_matches(
+			(node->cur_rule ? node->cur_rule->rule_id : -1),
+			inp_node->id, inp_node->ab,
+			inp_node->ib, inp_node->clk);
+		if (rule->state == RULE_STATE_NOT_APPLIED)
+			rule->state_change = true;
+		rule->state = RULE_STATE_APPLIED;
+	} else {
+		if (rule->state == RULE_STATE_APPLIED)
+			rule->state_change = true;
+		rule->state = RULE_STATE_NOT_APPLIED;
+	}
+
+	if (rule->state_change)
+		node->dirty = true;
+}
+
+/*
+ * Fold a new vote from one source into the rule's running total. The
+ * threshold is only re-checked when the field the rule looks at moved,
+ * and the owning node only needs to be re-applied on a crossing.
+ */
+static void update_src_vote(struct rule_update_path_info *inp_node,
+				struct rule_src_ref *ref)
+{
+	struct rules_def *rule = ref->rule;
+	struct node_vote_info *src = &rule->src_info[ref->idx];
+	u64 old_field = get_src_field(rule, src);
+	u64 new_field;
+
+	src->ib = inp_node->ib;
+	src->ab = inp_node->ab;
+	src->clk = inp_node->clk;
+	new_field = get_src_field(rule, src);
+
+	if (rule->evaluated && old_field == new_field)
+		return;
+
+	rule->field = rule->field - old_field + new_field;
+	rule->evaluated = true;
+	match_rule(inp_node, ref);
+}
+
+static void add_rule_srcs(struct rule_node_info *node, struct rules_def *rule)
 {
-	struct rules_def *rule;
 	int i;
 
-	list_for_each_entry(rule, &node->node_rules, link) {
-		for (i = 0; i < rule->num_src; i++) {
-			if (rule->src_info[i].id == inp_node->id) {
-				if (check_rule(rule, inp_node)) {
-					trace_bus_rules_matches(
-					(node->cur_rule ?
-						node->cur_rule->rule_id : -1),
-					inp_node->id, inp_node->ab,
-					inp_node->ib, inp_node->clk);
-					if (rule->state ==
-						RULE_STATE_NOT_APPLIED)
-						rule->state_change = true;
-					rule->state = RULE_STATE_APPLIED;
-				} else {
-					if (rule->state ==
-						RULE_STATE_APPLIED)
-						rule->state_change = true;
-					rule->state = RULE_STATE_NOT_APPLIED;
-				}
-			}
-		}
+	for (i = 0; i < rule->num_src; i++) {
+		rule->src_refs[i].node = node;
+		hash_add(rule_src_tbl, &rule->src_refs[i].hash,
+						rule->src_refs[i].id);
+	}
+}
+
+static void del_rule(struct rule_node_info *node, struct rules_def *rule)
+{
+	int i;
+
+	for (i = 0; i < rule->num_src; i++)
+		hash_del(&rule->src_refs[i].hash);
+	list_del(&rule->link);
+	/* force a re-apply so cur_rule never points at a freed rule */
+	if (node->cur_rule == rule) {
+		node->cur_rule = NULL;
+		node->dirty = true;
 	}
+	kfree(rule->src_refs);
+	kfree(rule);
 }
 
 static void apply_rule(struct rule_node_info *node,
@@ -283,17 +330,22 @@ int msm_rules_update_path(struct list_head *input_list,
 	int ret = 0;
 	struct rule_update_path_info  *inp_node;
 	struct rule_node_info *node_it = NULL;
+	struct rule_src_ref *ref;
 
 	mutex_lock(&msm_bus_rules_lock);
 	list_for_each_entry(inp_node, input_list, link) {
-		list_for_each_entry(node_it, &node_list, link) {
-			update_src_id_vote(inp_node, node_it);
-			match_rule(inp_node, node_it);
+		hash_for_each_possible(rule_src_tbl, ref, hash, inp_node->id) {
+			if (ref->id == inp_node->id)
+				update_src_vote(inp_node, ref);
 		}
 	}
 
-	list_for_each_entry(node_it, &node_list, link)
+	list_for_each_entry(node_it, &node_list, link) {
+		if (!node_it->dirty)
+			continue;
+		node_it->dirty = false;
 		apply_rule(node_it, output_list);
+	}
 	mutex_unlock(&msm_bus_rules_lock);
 	return ret;
 }
@@ -500,8 +552,19 @@ static int copy_rule(struct bus_rule_type *src, struct rules_def *node_rule,
 						__func__);
 		return -ENOMEM;
 	}
-	for (i = 0; i < src->num_src; i++)
+	node_rule->src_refs = kcalloc(node_rule->rule_ops.num_src,
+			sizeof(struct rule_src_ref), GFP_KERNEL);
+	if (!node_rule->src_refs) {
+		pr_err("%s:Failed to allocate for src_refs",
+						__func__);
+		return -ENOMEM;
+	}
+	for (i = 0; i < src->num_src; i++) {
 		node_rule->src_info[i].id = src->src_id[i];
+		node_rule->src_refs[i].id = src->src_id[i];
+		node_rule->src_refs[i].idx = i;
+		node_rule->src_refs[i].rule = node_rule;
+	}
 
 	return ret;
 }
@@ -558,6 +621,7 @@ static bool __rule_register(int num_rules, struct bus_rule_type *rule,
 				node->data = nb;
 
 			list_add_tail(&node_rule->link, &node->node_rules);
+			add_rule_srcs(node, node_rule);
 		}
 	}
 	list_sort(NULL, &node->node_rules, node_rules_compare);
@@ -618,8 +682,7 @@ static bool __rule_unregister(int num_rules, struct bus_rule_type *rule,
 					&node->node_rules, link) {
 			if (comp_rules(&node_rule->rule_ops,
 					&rule[i]) == 0) {
-				list_del(&node_rule->link);
-				kfree(node_rule);
+				del_rule(node, node_rule);
 				match_found = true;
 				node->num_rules--;
 				list_sort(NULL,
@@ -640,8 +703,7 @@ static bool __rule_unregister(int num_rules, struct bus_rule_type *rule,
 				node_rule_tmp, &node->node_rules, link) {
 					if (comp_rules(&node_rule->rule_ops,
 						&rule[i]) == 0) {
-						list_del(&node_rule->link);
-						kfree(node_rule);
+						del_rule(node, node_rule);
 						match_found = true;
 						node->num_rules--;
 						list_sort(NULL,
@@ -17,6 +17,7 @@
 #include <linux/moduleparam.h>
 #include <linux/cpumask.h>
 #include <linux/cpufreq.h>
+#include <linux/cpufreq_arbiter.h>
 #include <linux/slab.h>
 #include <linux/sched.h>
 #include <linux/tick.h>
@@ -36,10 +37,10 @@ static struct mutex managed_cpus_lock;
 static unsigned int num_clusters;
 struct cluster {
 	cpumask_var_t cpus;
-	/* Number of CPUs to maintain online */
+	/* Number of CPUs to keep available to the scheduler */
 	int max_cpu_request;
-	/* To track CPUs that the module decides to offline */
-	cpumask_var_t offlined_cpus;
+	/* To track CPUs that the module decides to isolate */
+	cpumask_var_t isolated_cpus;
 	/* stats for load detection */
 	/* IO */
 	u64 last_io_check_ts;
@@ -111,6 +112,7 @@ struct cpu_status {
 	unsigned int max;
 };
 static DEFINE_PER_CPU(struct cpu_status, cpu_stats);
+static struct freq_arb_client *perflock_client;
 
 #ifndef CONFIG_MSM_PERFORMANCE_CPUFREQ_LIMITS_VOTING_ONLY
 static unsigned int num_online_managed(struct cpumask *mask);
@@ -302,7 +304,7 @@ static int set_managed_cpus(const char *buf, const struct kernel_param *kp)
 		if (cpumask_empty(managed_clusters[i]->cpus)) {
 			mutex_lock(&managed_cpus_lock);
 			cpumask_copy(managed_clusters[i]->cpus, &tmp_mask);
-			cpumask_clear(managed_clusters[i]->offlined_cpus);
+			cpumask_clear(managed_clusters[i]->isolated_cpus);
 			mutex_unlock(&managed_cpus_lock);
 			break;
 		}
@@ -363,7 +365,7 @@ static int get_managed_online_cpus(char *buf, const struct kernel_param *kp)
 		i_cl = managed_clusters[i];
 
 		cpumask_clear(&tmp_mask);
-		cpumask_complement(&tmp_mask, i_cl->offlined_cpus);
+		cpumask_complement(&tmp_mask, i_cl->isolated_cpus);
 		cpumask_and(&tmp_mask, i_cl->cpus, &tmp_mask);
 
 		cnt = cpumap_print_to_pagebuf(true, buf, &tmp_mask);
@@ -402,13 +404,10 @@ device_param_cb(managed_online_cpus, &param_ops_managed_online_cpus,
  */
 static int set_cpu_min_freq(const char *buf, const struct kernel_param *kp)
 {
-	int i, j, ntokens = 0;
+	int i, ntokens = 0;
 	unsigned int val, cpu;
 	const char *cp = buf;
 	struct cpu_status *i_cpu_stats;
-	struct cpufreq_policy policy;
-	cpumask_var_t limit_mask;
-	int ret;
 
 	while ((cp = strpbrk(cp + 1, " :")))
 		ntokens++;
@@ -418,7 +417,6 @@ static int set_cpu_min_freq(const char *buf, const struct kernel_param *kp)
 		return -EINVAL;
 
 	cp = buf;
-	cpumask_clear(limit_mask);
 	for (i = 0; i < ntokens; i += 2) {
 		if (sscanf(cp, "%u:%u", &cpu, &val) != 2)
 			return -EINVAL;
@@ -428,35 +426,14 @@ static int set_cpu_min_freq(const char *buf, const struct kernel_param *kp)
 		i_cpu_stats = &per_cpu(cpu_stats, cpu);
 
 		i_cpu_stats->min = val;
-		cpumask_set_cpu(cpu, limit_mask);
+		freq_arb_set_min(perflock_client, cpu, val);
 
 		cp = strnchr(cp, strlen(cp), ' ');
 		cp++;
 	}
 
-	/*
-	 * Since on synchronous systems policy is shared amongst multiple
-	 * CPUs only one CPU needs to be updated for the limit to be
-	 * reflected for the entire cluster. We can avoid updating the policy
-	 * of other CPUs in the cluster once it is done for at least one CPU
-	 * in the cluster
-	 */
-	get_online_cpus();
-	for_each_cpu(i, limit_mask) {
-		i_cpu_stats = &per_cpu(cpu_stats, i);
-
-		if (cpufreq_get_policy(&policy, i))
-			continue;
-
-		if (cpu_online(i) && (policy.min != i_cpu_stats->min)) {
-			ret = cpufreq_update_policy(i);
-			if (ret)
-				continue;
-		}
-		for_each_cpu(j, policy.related_cpus)
-			cpumask_clear_cpu(j, limit_mask);
-	}
-	put_online_cpus();
+	/* Votes stay until userspace withdraws them */
+	freq_arb_apply(perflock_client, 0);
 
 	return 0;
 }
@@ -485,13 +462,10 @@ module_param_cb(cpu_min_freq, &param_ops_cpu_min_freq, NULL, 0644);
  */
 static int set_cpu_max_freq(const char *buf, const struct kernel_param *kp)
 {
-	int i, j, ntokens = 0;
+	int i, ntokens = 0;
 	unsigned int val, cpu;
 	const char *cp = buf;
 	struct cpu_status *i_cpu_stats;
-	struct cpufreq_policy policy;
-	cpumask_var_t limit_mask;
-	int ret;
 
 	while ((cp = strpbrk(cp + 1, " :")))
 		ntokens++;
@@ -501,7 +475,6 @@ static int set_cpu_max_freq(const char *buf, const struct kernel_param *kp)
 		return -EINVAL;
 
 	cp = buf;
-	cpumask_clear(limit_mask);
 	for (i = 0; i < ntokens; i += 2) {
 		if (sscanf(cp, "%u:%u", &cpu, &val) != 2)
 			return -EINVAL;
@@ -511,27 +484,13 @@ static int set_cpu_max_freq(const char *buf, const struct kernel_param *kp)
 		i_cpu_stats = &per_cpu(cpu_stats, cpu);
 
 		i_cpu_stats->max = val;
-		cpumask_set_cpu(cpu, limit_mask);
+		freq_arb_set_max(perflock_client, cpu, val);
 
 		cp = strnchr(cp, strlen(cp), ' ');
 		cp++;
 	}
 
-	get_online_cpus();
-	for_each_cpu(i, limit_mask) {
-		i_cpu_stats = &per_cpu(cpu_stats, i);
-		if (cpufreq_get_policy(&policy, i))
-			continue;
-
-		if (cpu_online(i) && (policy.max != i_cpu_stats->max)) {
-			ret = cpufreq_update_policy(i);
-			if (ret)
-				continue;
-		}
-		for_each_cpu(j, policy.related_cpus)
-			cpumask_clear_cpu(j, limit_mask);
-	}
-	put_online_cpus();
+	freq_arb_apply(perflock_client, 0);
 
 	return 0;
 }
@@ -1575,45 +1534,19 @@ static struct attribute_group events_attr_group = {
 };
 /*******************************sysfs ends************************************/
 
+/* Managed CPUs that are online and not isolated */
 static unsigned int num_online_managed(struct cpumask *mask)
 {
 	struct cpumask tmp_mask;
 
 	cpumask_clear(&tmp_mask);
 	cpumask_and(&tmp_mask, mask, cpu_online_mask);
+	cpumask_andnot(&tmp_mask, &tmp_mask, cpu_isolated_mask);
 
 	return cpumask_weight(&tmp_mask);
 }
 #endif // CONFIG_MSM_PERFORMANCE_CPUFREQ_LIMITS_VOTING_ONLY
 
-static int perf_adjust_notify(struct notifier_block *nb, unsigned long val,
-							void *data)
-{
-	struct cpufreq_policy *policy = data;
-	unsigned int cpu = policy->cpu;
-	struct cpu_status *cpu_st = &per_cpu(cpu_stats, cpu);
-	unsigned int min = cpu_st->min, max = cpu_st->max;
-
-
-	if (val != CPUFREQ_ADJUST)
-		return NOTIFY_OK;
-
-	pr_debug("msm_perf: CPU%u policy before: %u:%u kHz\n", cpu,
-						policy->min, policy->max);
-	pr_debug("msm_perf: CPU%u seting min:max %u:%u kHz\n", cpu, min, max);
-
-	cpufreq_verify_within_limits(policy, min, max);
-
-	pr_debug("msm_perf: CPU%u policy after: %u:%u kHz\n", cpu,
-						policy->min, policy->max);
-
-	return NOTIFY_OK;
-}
-
-static struct notifier_block perf_cpufreq_nb = {
-	.notifier_call = perf_adjust_notify,
-};
-
 #ifndef CONFIG_MSM_PERFORMANCE_CPUFREQ_LIMITS_VOTING_ONLY
 static bool check_notify_status(void)
 {
@@ -2308,8 +2241,8 @@ static struct notifier_block perf_cputransitions_nb = {
 };
 
 /*
- * Attempt to offline CPUs based on their power cost.
- * CPUs with higher power costs are offlined first.
+ * Attempt to isolate CPUs based on their power cost.
+ * CPUs with higher power costs are isolated first.
  */
 static int __ref rm_high_pwr_cost_cpus(struct cluster *cl)
 {
@@ -2354,19 +2287,16 @@ static int __ref rm_high_pwr_cost_cpus(struct cluster *cl)
 			}
 		}
 
-		if (!cpu_online(max_cost_cpu))
+		if (!cpu_online(max_cost_cpu) || cpu_isolated(max_cost_cpu))
 			goto end;
 
-		pr_debug("msm_perf: Offlining CPU%d Power:%d\n", max_cost_cpu,
+		pr_debug("msm_perf: Isolating CPU%d Power:%d\n", max_cost_cpu,
 								max_cost);
-		cpumask_set_cpu(max_cost_cpu, cl->offlined_cpus);
-		lock_device_hotplug();
-		if (device_offline(get_cpu_device(max_cost_cpu))) {
-			cpumask_clear_cpu(max_cost_cpu, cl->offlined_cpus);
-			pr_debug("msm_perf: Offlining CPU%d failed\n",
+		if (!sched_isolate_cpu(max_cost_cpu))
+			cpumask_set_cpu(max_cost_cpu, cl->isolated_cpus);
+		else
+			pr_debug("msm_perf: Isolating CPU%d failed\n",
 								max_cost_cpu);
-		}
-		unlock_device_hotplug();
 
 end:
 		pcpu_pwr = &per_cpu(cpu_power_cost, max_cost_cpu);
@@ -2385,19 +2315,19 @@ end:
 }
 
 /*
- * try_hotplug tries to online/offline cores based on the current requirement.
- * It loops through the currently managed CPUs and tries to online/offline
- * them until the max_cpu_request criteria is met.
+ * try_hotplug tries to isolate/unisolate cores based on the current
+ * requirement. It loops through the currently managed CPUs and tries to
+ * isolate/unisolate them until the max_cpu_request criteria is met.
+ * Isolation keeps the CPUs online, which is much faster than hotplug.
  */
 static void __ref try_hotplug(struct cluster *data)
 {
 	unsigned int i;
-	struct device *dev;
 
 	if (!clusters_inited)
 		return;
 
-	pr_debug("msm_perf: Trying hotplug...%d:%d\n",
+	pr_debug("msm_perf: Trying isolation...%d:%d\n",
 			num_online_managed(data->cpus),	num_online_cpus());
 
 	mutex_lock(&managed_cpus_lock);
@@ -2408,45 +2338,35 @@ static void __ref try_hotplug(struct cluster *data)
 		}
 
 		/*
-		 * If power aware offlining fails due to power cost info
+		 * If power aware isolation fails due to power cost info
 		 * being unavaiable fall back to original implementation
 		 */
 		for (i = num_present_cpus() - 1; i >= 0 &&
 						i < num_present_cpus(); i--) {
-			if (!cpumask_test_cpu(i, data->cpus) ||	!cpu_online(i))
+			if (!cpumask_test_cpu(i, data->cpus) ||	!cpu_online(i) ||
+			    cpu_isolated(i))
 				continue;
 
-			pr_debug("msm_perf: Offlining CPU%d\n", i);
-			cpumask_set_cpu(i, data->offlined_cpus);
-			lock_device_hotplug();
-			dev = get_cpu_device(i);
-			if (!dev || device_offline(dev)) {
-				cpumask_clear_cpu(i, data->offlined_cpus);
-				pr_debug("msm_perf: Offlining CPU%d failed\n",
+			pr_debug("msm_perf: Isolating CPU%d\n", i);
+			if (sched_isolate_cpu(i)) {
+				pr_debug("msm_perf: Isolating CPU%d failed\n",
 									i);
-				unlock_device_hotplug();
 				continue;
 			}
-			unlock_device_hotplug();
+			cpumask_set_cpu(i, data->isolated_cpus);
 			if (num_online_managed(data->cpus) <=
 							data->max_cpu_request)
 				break;
 		}
 	} else {
-		for_each_cpu(i, data->cpus) {
-			if (cpu_online(i))
-				continue;
-			pr_debug("msm_perf: Onlining CPU%d\n", i);
-			lock_device_hotplug();
-			dev = get_cpu_device(i);
-			if (!dev || device_online(dev)) {
-				pr_debug("msm_perf: Onlining CPU%d failed\n",
+		for_each_cpu(i, data->isolated_cpus) {
+			pr_debug("msm_perf: Unisolating CPU%d\n", i);
+			if (sched_unisolate_cpu(i)) {
+				pr_debug("msm_perf: Unisolating CPU%d failed\n",
 									i);
-				unlock_device_hotplug();
 				continue;
 			}
-			unlock_device_hotplug();
-			cpumask_clear_cpu(i, data->offlined_cpus);
+			cpumask_clear_cpu(i, data->isolated_cpus);
 			if (num_online_managed(data->cpus) >=
 							data->max_cpu_request)
 				break;
@@ -2455,28 +2375,18 @@ static void __ref try_hotplug(struct cluster *data)
 	mutex_unlock(&managed_cpus_lock);
 }
 
-static void __ref release_cluster_control(struct cpumask *off_cpus)
+static void __ref release_cluster_control(struct cpumask *iso_cpus)
 {
 	int cpu;
-	struct device *dev;
 
-	for_each_cpu(cpu, off_cpus) {
+	for_each_cpu(cpu, iso_cpus) {
 		pr_debug("msm_perf: Release CPU %d\n", cpu);
-		lock_device_hotplug();
-		dev = get_cpu_device(cpu);
-		if (!dev) {
-			pr_debug("msm_perf: Failed to get CPU%d\n",
-								cpu);
-			unlock_device_hotplug();
-			continue;
-		}
-		if (!device_online(dev))
-			cpumask_clear_cpu(cpu, off_cpus);
-		unlock_device_hotplug();
+		if (!sched_unisolate_cpu(cpu))
+			cpumask_clear_cpu(cpu, iso_cpus);
 	}
 }
 
-/* Work to evaluate current online CPU status and hotplug CPUs as per need*/
+/* Work to evaluate current CPU isolation status and apply it as per need */
 static void check_cluster_status(struct work_struct *work)
 {
 	int i;
@@ -2489,8 +2399,8 @@ static void check_cluster_status(struct work_struct *work)
 			continue;
 
 		if (i_cl->max_cpu_request < 0) {
-			if (!cpumask_empty(i_cl->offlined_cpus))
-				release_cluster_control(i_cl->offlined_cpus);
+			if (!cpumask_empty(i_cl->isolated_cpus))
+				release_cluster_control(i_cl->isolated_cpus);
 			continue;
 		}
 
@@ -2524,30 +2434,24 @@ static int __ref msm_performance_cpu_callback(struct notifier_block *nfb,
 	if (i_cl == NULL)
 		return NOTIFY_OK;
 
-	if (action == CPU_UP_PREPARE || action == CPU_UP_PREPARE_FROZEN) {
-		/*
-		 * Prevent onlining of a managed CPU if max_cpu criteria is
-		 * already satisfied
-		 */
-		if (i_cl->offlined_cpus == NULL)
-			return NOTIFY_OK;
-		if (i_cl->max_cpu_request <=
-					num_online_managed(i_cl->cpus)) {
-			pr_debug("msm_perf: Prevent CPU%d onlining\n", cpu);
-			cpumask_set_cpu(cpu, i_cl->offlined_cpus);
-			return NOTIFY_BAD;
-		}
-		cpumask_clear_cpu(cpu, i_cl->offlined_cpus);
+	if (action == CPU_ONLINE || action == CPU_ONLINE_FROZEN) {
+		/* A managed CPU came back, isolate it if it is not needed */
+		if (i_cl->max_cpu_request >= 0 &&
+		    i_cl->max_cpu_request < num_online_managed(i_cl->cpus))
+			schedule_delayed_work(&evaluate_hotplug_work, 0);
 
 	} else if (action == CPU_DEAD) {
-		if (i_cl->offlined_cpus == NULL)
+		if (i_cl->isolated_cpus == NULL)
 			return NOTIFY_OK;
-		if (cpumask_test_cpu(cpu, i_cl->offlined_cpus))
+		/* Don't leave a CPU both offline and isolated */
+		if (cpumask_test_cpu(cpu, i_cl->isolated_cpus)) {
+			sched_unisolate_cpu_unlocked(cpu);
+			cpumask_clear_cpu(cpu, i_cl->isolated_cpus);
 			return NOTIFY_OK;
+		}
 		/*
-		 * Schedule a re-evaluation to check if any more CPUs can be
-		 * brought online to meet the max_cpu_request requirement. This
-		 * work is delayed to account for CPU hotplug latencies
+		 * Schedule a re-evaluation to check if any isolated CPUs
+		 * should be released to meet the max_cpu_request requirement.
 		 */
 		if (schedule_delayed_work(&evaluate_hotplug_work, 0)) {
 			trace_reevaluate_hotplug(cpumask_bits(i_cl->cpus)[0],
@@ -2658,7 +2562,7 @@ static int init_cluster_control(void)
 			ret = -ENOMEM;
 			goto error;
 		}
-		if (!alloc_cpumask_var(&managed_clusters[i]->offlined_cpus,
+		if (!alloc_cpumask_var(&managed_clusters[i]->isolated_cpus,
 		     GFP_KERNEL)) {
 			pr_err("msm_perf:Cluster %u off_cpus alloc failed\n",
 			       i);
@@ -2741,8 +2645,8 @@ error:
 	for (i = 0; i < num_clusters; i++) {
 		if (!managed_clusters[i])
 			break;
-		if (managed_clusters[i]->offlined_cpus)
-			free_cpumask_var(managed_clusters[i]->offlined_cpus);
+		if (managed_clusters[i]->isolated_cpus)
+			free_cpumask_var(managed_clusters[i]->isolated_cpus);
 		if (managed_clusters[i]->cpus)
 			free_cpumask_var(managed_clusters[i]->cpus);
 		kfree(managed_clusters[i]);
@@ -2790,7 +2694,10 @@ static int __init msm_performance_init(void)
 {
 	unsigned int cpu;
 
-	cpufreq_register_notifier(&perf_cpufreq_nb, CPUFREQ_POLICY_NOTIFIER);
+	perflock_client = freq_arb_register("msm_perf", FREQ_ARB_PRIO_PERFLOCK);
+	if (IS_ERR(perflock_client))
+		return PTR_ERR(perflock_client);
+
 #ifndef CONFIG_MSM_PERFORMANCE_CPUFREQ_LIMITS_VOTING_ONLY
 	cpufreq_register_notifier(&perf_govinfo_nb, CPUFREQ_GOVINFO_NOTIFIER);
 	cpufreq_register_notifier(&perf_cputransitions_nb,
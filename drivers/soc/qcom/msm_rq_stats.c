@@ -14,25 +14,23 @@
 #include <linux/kernel.h>
 #include <linux/init.h>
 #include <linux/module.h>
-#include <linux/hrtimer.h>
 #include <linux/cpu.h>
 #include <linux/kobject.h>
 #include <linux/sysfs.h>
 #include <linux/notifier.h>
 #include <linux/slab.h>
-#include <linux/workqueue.h>
 #include <linux/sched.h>
-#include <linux/spinlock.h>
 #include <linux/rq_stats.h>
 #include <linux/cpufreq.h>
+#include <linux/topology.h>
 #include <linux/kernel_stat.h>
 #include <linux/tick.h>
 #include <asm/smp_plat.h>
 #include <linux/suspend.h>
 
 #define MAX_LONG_SIZE 24
-#define DEFAULT_RQ_POLL_JIFFIES 1
-#define DEFAULT_DEF_TIMER_JIFFIES 5
+
+struct rq_data rq_info;
 
 struct notifier_block freq_transition;
 struct notifier_block cpu_hotplug;
@@ -198,99 +196,50 @@ static ssize_t hotplug_disable_show(struct kobject *kobj,
 
 static struct kobj_attribute hotplug_disabled_attr = __ATTR_RO(hotplug_disable);
 
-static void def_work_fn(struct work_struct *work)
-{
-	/* Notify polling threads on change of value */
-	sysfs_notify(rq_info.kobj, NULL, "def_timer_ms");
-}
-
 static ssize_t run_queue_avg_show(struct kobject *kobj,
 		struct kobj_attribute *attr, char *buf)
 {
-	unsigned int val = 0;
-	unsigned long flags = 0;
+	struct sched_avg_stats stats;
 
-	spin_lock_irqsave(&rq_lock, flags);
-	/* rq avg currently available only on one core */
-	val = rq_info.rq_avg;
-	rq_info.rq_avg = 0;
-	spin_unlock_irqrestore(&rq_lock, flags);
+	sched_get_nr_running_avg(cpu_online_mask, &stats);
 
-	return snprintf(buf, PAGE_SIZE, "%d.%d\n", val/10, val%10);
+	/* One decimal, as it used to be */
+	return snprintf(buf, PAGE_SIZE, "%u.%u\n", stats.avg / 100,
+			(stats.avg % 100) / 10);
 }
 
 static struct kobj_attribute run_queue_avg_attr = __ATTR_RO(run_queue_avg);
 
-static ssize_t show_run_queue_poll_ms(struct kobject *kobj,
-				      struct kobj_attribute *attr, char *buf)
-{
-	int ret = 0;
-	unsigned long flags = 0;
-
-	spin_lock_irqsave(&rq_lock, flags);
-	ret = snprintf(buf, MAX_LONG_SIZE, "%u\n",
-		       jiffies_to_msecs(rq_info.rq_poll_jiffies));
-	spin_unlock_irqrestore(&rq_lock, flags);
-
-	return ret;
-}
-
-static ssize_t store_run_queue_poll_ms(struct kobject *kobj,
-				       struct kobj_attribute *attr,
-				       const char *buf, size_t count)
-{
-	unsigned int val = 0;
-	unsigned long flags = 0;
-	static DEFINE_MUTEX(lock_poll_ms);
-
-	mutex_lock(&lock_poll_ms);
-
-	spin_lock_irqsave(&rq_lock, flags);
-	if (kstrtouint(buf, 0, &val))
-		count = -EINVAL;
-	else
-		rq_info.rq_poll_jiffies = msecs_to_jiffies(val);
-	spin_unlock_irqrestore(&rq_lock, flags);
-
-	mutex_unlock(&lock_poll_ms);
-
-	return count;
-}
-
-static struct kobj_attribute run_queue_poll_ms_attr =
-	__ATTR(run_queue_poll_ms, S_IWUSR | S_IRUSR, show_run_queue_poll_ms,
-			store_run_queue_poll_ms);
-
-static ssize_t show_def_timer_ms(struct kobject *kobj,
+/*
+ * One line per cluster: first CPU, average and big task average (scaled
+ * by 100), and the most tasks runnable on one of its CPUs, over the last
+ * scheduler window.
+ */
+static ssize_t cluster_stats_show(struct kobject *kobj,
 		struct kobj_attribute *attr, char *buf)
 {
-	int64_t diff;
-	unsigned int udiff;
-
-	diff = ktime_to_ns(ktime_get()) - rq_info.def_start_time;
-	do_div(diff, 1000 * 1000);
-	udiff = (unsigned int) diff;
-
-	return snprintf(buf, MAX_LONG_SIZE, "%u\n", udiff);
-}
+	struct sched_avg_stats stats;
+	cpumask_t done;
+	ssize_t len = 0;
+	int cpu;
 
-static ssize_t store_def_timer_ms(struct kobject *kobj,
-		struct kobj_attribute *attr, const char *buf, size_t count)
-{
-	unsigned int val = 0;
+	cpumask_clear(&done);
+	for_each_possible_cpu(cpu) {
+		const struct cpumask *cluster = topology_core_cpumask(cpu);
 
-	if (kstrtouint(buf, 0, &val))
-		return -EINVAL;
+		if (cpumask_test_cpu(cpu, &done))
+			continue;
+		cpumask_or(&done, &done, cluster);
 
-	rq_info.def_timer_jiffies = msecs_to_jiffies(val);
+		sched_get_nr_running_avg(cluster, &stats);
+		len += snprintf(buf + len, PAGE_SIZE - len, "%d %u %u %u\n",
+				cpu, stats.avg, stats.big_avg, stats.max);
+	}
 
-	rq_info.def_start_time = ktime_to_ns(ktime_get());
-	return count;
+	return len;
 }
 
-static struct kobj_attribute def_timer_ms_attr =
-	__ATTR(def_timer_ms, S_IWUSR | S_IRUSR, show_def_timer_ms,
-			store_def_timer_ms);
+static struct kobj_attribute cluster_stats_attr = __ATTR_RO(cluster_stats);
 
 static ssize_t show_cpu_normalized_load(struct kobject *kobj,
 		struct kobj_attribute *attr, char *buf)
@@ -304,9 +253,8 @@ static struct kobj_attribute cpu_normalized_load_attr =
 
 static struct attribute *rq_attrs[] = {
 	&cpu_normalized_load_attr.attr,
-	&def_timer_ms_attr.attr,
+	&cluster_stats_attr.attr,
 	&run_queue_avg_attr.attr,
-	&run_queue_poll_ms_attr.attr,
 	&hotplug_disabled_attr.attr,
 	NULL,
 };
@@ -319,7 +267,6 @@ static int init_rq_attribs(void)
 {
 	int err;
 
-	rq_info.rq_avg = 0;
 	rq_info.attr_group = &rq_attr_group;
 
 	/* Create /sys/devices/system/cpu/cpu0/rq-stats/... */
@@ -349,14 +296,6 @@ static int __init msm_rq_stats_init(void)
 	return -ENOSYS;
 #endif
 
-	rq_wq = create_singlethread_workqueue("rq_stats");
-	BUG_ON(!rq_wq);
-	INIT_WORK(&rq_info.def_timer_work, def_work_fn);
-	spin_lock_init(&rq_lock);
-	rq_info.rq_poll_jiffies = DEFAULT_RQ_POLL_JIFFIES;
-	rq_info.def_timer_jiffies = DEFAULT_DEF_TIMER_JIFFIES;
-	rq_info.rq_poll_last_jiffy = 0;
-	rq_info.def_timer_last_jiffy = 0;
 	rq_info.hotplug_disabled = 0;
 	ret = init_rq_attribs();
 
@@ -32,9 +32,11 @@
 #include <linux/of_address.h>
 #include <linux/io.h>
 #include <linux/dma-mapping.h>
+#include <linux/async.h>
 #include <soc/qcom/ramdump.h>
 #include <soc/qcom/subsystem_restart.h>
 #include <soc/qcom/secure_buffer.h>
+#include <soc/qcom/boot_stats.h>
 
 #include <asm/uaccess.h>
 #include <asm/setup.h>
@@ -112,6 +114,9 @@ struct pil_seg {
 	int num;
 	struct list_head list;
 	bool relocated;
+	struct pil_desc *desc;
+	async_cookie_t cookie;
+	int load_ret;
 };
 
 /**
@@ -129,6 +134,8 @@ struct pil_seg {
  * non-relocatable images
  * @region: region allocated for relocatable images
  * @unvoted_flag: flag to keep track if we have unvoted or not.
+ * @seg_domain: async domain the segments of one image are loaded in
+ * @boot_marked: boot markers have been placed for the first boot
  *
  * This struct contains data for a pil_desc that should not be exposed outside
  * of this file. This structure points to the descriptor and the descriptor
@@ -153,6 +160,8 @@ struct pil_priv {
 	int id;
 	int unvoted_flag;
 	size_t region_size;
+	struct async_domain seg_domain;
+	bool boot_marked;
 };
 
 static int pil_do_minidump(struct pil_desc *desc, void *ramdump_dev)
@@ -528,6 +537,8 @@ static struct pil_seg *pil_init_seg(const struct pil_desc *desc,
 	seg->filesz = phdr->p_filesz;
 	seg->sz = phdr->p_memsz;
 	seg->relocated = reloc;
+	seg->desc = (struct pil_desc *)desc;
+	seg->load_ret = 0;
 	INIT_LIST_HEAD(&seg->list);
 
 	return seg;
@@ -856,15 +867,62 @@ static int pil_load_seg(struct pil_desc *desc, struct pil_seg *seg)
 		paddr += size;
 	}
 
-	if (desc->ops->verify_blob) {
-		ret = desc->ops->verify_blob(desc, seg->paddr, seg->sz);
-		if (ret) {
-			pil_err(desc, "Blob%u failed verification(rc:%d)\n",
-								num, ret);
-			subsys_set_error(desc->subsys_dev, firmware_error_msg);
+	return 0;
+}
+
+static void pil_load_seg_async(void *data, async_cookie_t cookie)
+{
+	struct pil_seg *seg = data;
+	struct pil_desc *desc = seg->desc;
+	char name[40];
+
+	seg->load_ret = pil_load_seg(desc, seg);
+
+	if (!desc->priv->boot_marked && boot_marker_enabled()) {
+		snprintf(name, sizeof(name), "M - %s.b%02d Loaded",
+				desc->fw_name, seg->num);
+		place_marker(name);
+	}
+}
+
+/*
+ * Segments are independent files loaded into disjoint memory, so they are
+ * all read in parallel. Verification is left in segment order, since the
+ * verifier (e.g. the modem MBA) may authenticate the image incrementally;
+ * it overlaps with the loading of the segments that follow.
+ */
+static int pil_load_segs(struct pil_desc *desc)
+{
+	struct pil_priv *priv = desc->priv;
+	struct pil_seg *seg;
+	int ret = 0;
+
+	list_for_each_entry(seg, &priv->segs, list)
+		seg->cookie = async_schedule_domain(pil_load_seg_async, seg,
+						    &priv->seg_domain);
+
+	list_for_each_entry(seg, &priv->segs, list) {
+		async_synchronize_cookie_domain(seg->cookie + 1,
+						&priv->seg_domain);
+		ret = seg->load_ret;
+		if (ret)
+			break;
+
+		if (desc->ops->verify_blob) {
+			ret = desc->ops->verify_blob(desc, seg->paddr, seg->sz);
+			if (ret) {
+				pil_err(desc, "Blob%u failed verification(rc:%d)\n",
+								seg->num, ret);
+				subsys_set_error(desc->subsys_dev,
+							firmware_error_msg);
+				break;
+			}
 		}
 	}
 
+	/* don't let any loader outlive a failed boot */
+	if (ret)
+		async_synchronize_full_domain(&priv->seg_domain);
 	return ret;
 }
 
@@ -921,7 +979,6 @@ int pil_boot(struct pil_desc *desc)
 	char fw_name[30];
 	const struct pil_mdt *mdt;
 	const struct elf32_hdr *ehdr;
-	struct pil_seg *seg;
 	const struct firmware *fw;
 	struct pil_priv *priv = desc->priv;
 	bool mem_protect = false;
@@ -1028,11 +1085,9 @@ int pil_boot(struct pil_desc *desc)
 	}
 
 	trace_pil_event("before_load_seg", desc);
-	list_for_each_entry(seg, &desc->priv->segs, list) {
-		ret = pil_load_seg(desc, seg);
-		if (ret)
-			goto err_deinit_image;
-	}
+	ret = pil_load_segs(desc);
+	if (ret)
+		goto err_deinit_image;
 
 	if (desc->subsys_vmid > 0) {
 		trace_pil_event("before_reclaim_mem", desc);
@@ -1056,6 +1111,14 @@ int pil_boot(struct pil_desc *desc)
 	}
 	trace_pil_event("reset_done", desc);
 	pil_info(desc, "Brought out of reset\n");
+	if (!priv->boot_marked && boot_marker_enabled()) {
+		char name[40];
+
+		snprintf(name, sizeof(name), "M - %s Out of Reset",
+				desc->fw_name);
+		place_marker(name);
+	}
+	priv->boot_marked = true;
 	desc->modem_ssr = false;
 err_auth_and_reset:
 	if (ret && desc->subsys_vmid > 0) {
@@ -1176,6 +1239,8 @@ int pil_desc_init(struct pil_desc *desc)
 		return -ENOMEM;
 	desc->priv = priv;
 	priv->desc = desc;
+	INIT_LIST_HEAD(&priv->seg_domain.pending);
+	priv->seg_domain.registered = 0;
 
 	priv->id = ret = ida_simple_get(&pil_ida, 0, PIL_NUM_DESC, GFP_KERNEL);
 	if (priv->id < 0)
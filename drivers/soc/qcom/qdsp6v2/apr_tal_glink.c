@@ -31,8 +31,12 @@
 #include <linux/qdsp6v2/apr_tal.h>
 
 #define APR_MAXIMUM_NUM_OF_RETRIES 2
+#define APR_TX_BUF_POOL_SIZE 8
 
 struct apr_tx_buf {
+	struct list_head list;
+	struct apr_svc_ch_dev *apr_ch;
+	bool pooled;
 	struct apr_pkt_priv pkt_priv;
 	char buf[APR_MAX_BUF];
 };
@@ -60,15 +64,71 @@ static char *svc_names[APR_DEST_MAX][APR_CLIENT_MAX] = {
 static struct apr_svc_ch_dev
 	apr_svc_ch[APR_DL_MAX][APR_DEST_MAX][APR_CLIENT_MAX];
 
-static struct apr_tx_buf *apr_alloc_buf(int len)
+/*
+ * Each channel keeps a few TX buffers around so that commands sent from
+ * atomic context do not depend on an atomic allocation succeeding. The
+ * pool is filled on first open and kept for the life of the channel.
+ */
+static void apr_tx_pool_init(struct apr_svc_ch_dev *apr_ch)
 {
+	struct apr_tx_buf *tx_buf;
+	unsigned long flags;
+
+	while (apr_ch->tx_buf_cnt < APR_TX_BUF_POOL_SIZE) {
+		tx_buf = kmalloc(sizeof(struct apr_tx_buf), GFP_KERNEL);
+		if (!tx_buf)
+			break;
+		tx_buf->apr_ch = apr_ch;
+		tx_buf->pooled = true;
+		spin_lock_irqsave(&apr_ch->tx_buf_lock, flags);
+		list_add_tail(&tx_buf->list, &apr_ch->tx_buf_pool);
+		spin_unlock_irqrestore(&apr_ch->tx_buf_lock, flags);
+		apr_ch->tx_buf_cnt++;
+	}
+}
+
+static struct apr_tx_buf *apr_alloc_buf(struct apr_svc_ch_dev *apr_ch,
+					int len)
+{
+	struct apr_tx_buf *tx_buf = NULL;
+	unsigned long flags;
 
 	if (len > APR_MAX_BUF) {
 		pr_err("%s: buf too large [%d]\n", __func__, len);
 		return ERR_PTR(-EINVAL);
 	}
 
-	return kzalloc(sizeof(struct apr_tx_buf), GFP_ATOMIC);
+	spin_lock_irqsave(&apr_ch->tx_buf_lock, flags);
+	if (!list_empty(&apr_ch->tx_buf_pool)) {
+		tx_buf = list_first_entry(&apr_ch->tx_buf_pool,
+					  struct apr_tx_buf, list);
+		list_del(&tx_buf->list);
+	}
+	spin_unlock_irqrestore(&apr_ch->tx_buf_lock, flags);
+	if (tx_buf)
+		return tx_buf;
+
+	tx_buf = kmalloc(sizeof(struct apr_tx_buf), GFP_ATOMIC);
+	if (tx_buf) {
+		tx_buf->apr_ch = apr_ch;
+		tx_buf->pooled = false;
+	}
+	return tx_buf;
+}
+
+static void apr_put_buf(struct apr_tx_buf *tx_buf)
+{
+	struct apr_svc_ch_dev *apr_ch = tx_buf->apr_ch;
+	unsigned long flags;
+
+	if (!tx_buf->pooled) {
+		kfree(tx_buf);
+		return;
+	}
+
+	spin_lock_irqsave(&apr_ch->tx_buf_lock, flags);
+	list_add(&tx_buf->list, &apr_ch->tx_buf_pool);
+	spin_unlock_irqrestore(&apr_ch->tx_buf_lock, flags);
 }
 
 static void apr_free_buf(const void *ptr)
@@ -86,7 +146,7 @@ static void apr_free_buf(const void *ptr)
 		tx_buf = container_of((void *)apr_pkt_priv,
 				      struct apr_tx_buf, pkt_priv);
 		pr_debug("%s: Freeing buffer %pK", __func__, tx_buf);
-		kfree(tx_buf);
+		apr_put_buf(tx_buf);
 	}
 }
 
@@ -121,7 +181,7 @@ int apr_tal_write(struct apr_svc_ch_dev *apr_ch, void *data,
 		return -EINVAL;
 
 	if (pkt_priv->pkt_owner == APR_PKT_OWNER_DRIVER) {
-		tx_buf = apr_alloc_buf(len);
+		tx_buf = apr_alloc_buf(apr_ch, len);
 		if (IS_ERR_OR_NULL(tx_buf)) {
 			rc = -EINVAL;
 			goto exit;
@@ -144,7 +204,7 @@ int apr_tal_write(struct apr_svc_ch_dev *apr_ch, void *data,
 	if (rc < 0) {
 		pr_err("%s: Unable to send the packet, rc:%d\n", __func__, rc);
 		if (pkt_priv->pkt_owner == APR_PKT_OWNER_DRIVER)
-			kfree(tx_buf);
+			apr_put_buf(tx_buf);
 	}
 exit:
 	return rc;
@@ -344,6 +404,7 @@ struct apr_svc_ch_dev *apr_tal_open(uint32_t clnt, uint32_t dest, uint32_t dl,
 		goto close_link;
 	}
 
+	apr_tx_pool_init(apr_ch);
 	apr_ch->func = func;
 	apr_ch->priv = priv;
 
@@ -419,15 +480,19 @@ static struct glink_link_info lpass_link_info = {
 
 static int __init apr_tal_init(void)
 {
+	struct apr_svc_ch_dev *apr_ch;
 	int i, j, k;
 
 	for (i = 0; i < APR_DL_MAX; i++) {
 		for (j = 0; j < APR_DEST_MAX; j++) {
 			for (k = 0; k < APR_CLIENT_MAX; k++) {
-				init_waitqueue_head(&apr_svc_ch[i][j][k].wait);
-				spin_lock_init(&apr_svc_ch[i][j][k].w_lock);
-				spin_lock_init(&apr_svc_ch[i][j][k].r_lock);
-				mutex_init(&apr_svc_ch[i][j][k].m_lock);
+				apr_ch = &apr_svc_ch[i][j][k];
+				init_waitqueue_head(&apr_ch->wait);
+				spin_lock_init(&apr_ch->w_lock);
+				spin_lock_init(&apr_ch->r_lock);
+				spin_lock_init(&apr_ch->tx_buf_lock);
+				INIT_LIST_HEAD(&apr_ch->tx_buf_pool);
+				mutex_init(&apr_ch->m_lock);
 			}
 		}
 	}
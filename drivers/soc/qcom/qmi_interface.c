@@ -906,17 +906,14 @@ static int qmi_encode_and_send_req(struct qmi_txn **ret_txn_handle,
 	if ((!req && req_len) || (!req_len && req))
 		return -EINVAL;
 
-	mutex_lock(&handle->handle_lock);
-	if (handle->handle_reset) {
-		mutex_unlock(&handle->handle_lock);
-		return -ENETRESET;
-	}
-
-	/* Allocate Transaction Info */
+	/*
+	 * Allocate and encode outside of handle_lock, so that concurrent
+	 * requests on a handle only serialize on the transaction ID and
+	 * the send itself.
+	 */
 	txn_handle = kzalloc(sizeof(struct qmi_txn), GFP_KERNEL);
 	if (!txn_handle) {
 		pr_err("%s: Failed to allocate txn handle\n", __func__);
-		mutex_unlock(&handle->handle_lock);
 		return -ENOMEM;
 	}
 	txn_handle->type = type;
@@ -940,17 +937,23 @@ static int qmi_encode_and_send_req(struct qmi_txn **ret_txn_handle,
 	if (!encoded_req) {
 		pr_err("%s: Failed to allocate req_msg_buf\n", __func__);
 		rc = -ENOMEM;
-		goto encode_and_send_req_err1;
+		goto encode_and_send_req_err0;
 	}
 	rc = qmi_kernel_encode(req_desc,
 		(void *)(encoded_req + QMI_HEADER_SIZE),
 		req_desc->max_msg_len, req);
 	if (rc < 0) {
 		pr_err("%s: Encode Failure %d\n", __func__, rc);
-		goto encode_and_send_req_err2;
+		goto encode_and_send_req_err1;
 	}
 	encoded_req_len = rc;
 
+	mutex_lock(&handle->handle_lock);
+	if (handle->handle_reset) {
+		rc = -ENETRESET;
+		goto encode_and_send_req_err2;
+	}
+
 	/* Encode the header & Add to the txn_list */
 	if (!handle->next_txn_id)
 		handle->next_txn_id++;
@@ -1004,10 +1007,11 @@ append_pend_txn:
 encode_and_send_req_err3:
 	list_del(&txn_handle->list);
 encode_and_send_req_err2:
-	kfree(encoded_req);
+	mutex_unlock(&handle->handle_lock);
 encode_and_send_req_err1:
+	kfree(encoded_req);
+encode_and_send_req_err0:
 	kfree(txn_handle);
-	mutex_unlock(&handle->handle_lock);
 	return rc;
 }
 
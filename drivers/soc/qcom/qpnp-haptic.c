@@ -3219,6 +3219,7 @@ static struct platform_driver qpnp_haptic_driver = {
 		.name		= "qcom,qpnp-haptic",
 		.of_match_table	= spmi_match_table,
 		.pm		= &qpnp_haptic_pm_ops,
+		.probe_type	= PROBE_PREFER_ASYNCHRONOUS,
 	},
 	.probe		= qpnp_haptic_probe,
 	.remove		= qpnp_haptic_remove,
@@ -20,6 +20,7 @@
 #include <linux/fs.h>
 #include <linux/mm.h>
 #include <linux/slab.h>
+#include <linux/vmalloc.h>
 #include <linux/poll.h>
 #include <linux/uaccess.h>
 #include <linux/elf.h>
@@ -49,6 +50,8 @@ struct ramdump_device {
 	char *elfcore_buf;
 	struct dma_attrs attrs;
 	bool complete_ramdump;
+	/* bounce buffer for ramdump_read(), kept for the life of the reader */
+	void *read_buf;
 };
 
 static int ramdump_open(struct inode *inode, struct file *filep)
@@ -66,6 +69,8 @@ static int ramdump_release(struct inode *inode, struct file *filep)
 				struct ramdump_device, device);
 	rd_dev->consumer_present = 0;
 	rd_dev->data_ready = 0;
+	vfree(rd_dev->read_buf);
+	rd_dev->read_buf = NULL;
 	complete(&rd_dev->ramdump_complete);
 	return 0;
 }
@@ -168,7 +173,13 @@ static ssize_t ramdump_read(struct file *filep, char __user *buf, size_t count,
 		goto ramdump_done;
 	}
 
-	alignbuf = kzalloc(copy_size, GFP_KERNEL);
+	/*
+	 * A chunk is up to 1MB, which is costly to get physically contiguous
+	 * on every read, so the bounce buffer is allocated once per reader.
+	 */
+	if (!rd_dev->read_buf)
+		rd_dev->read_buf = vmalloc(MAX_IOREMAP_SIZE);
+	alignbuf = rd_dev->read_buf;
 	if (!alignbuf) {
 		pr_err("Ramdump(%s): Unable to alloc mem for aligned buf\n",
 				rd_dev->name);
@@ -206,7 +217,6 @@ static ssize_t ramdump_read(struct file *filep, char __user *buf, size_t count,
 		goto ramdump_done;
 	}
 
-	kfree(finalbuf);
 	if (!vaddr && origdevice_mem)
 		dma_unremap(rd_dev->device.parent, origdevice_mem, copy_size);
 
@@ -221,7 +231,6 @@ ramdump_done:
 	if (!vaddr && origdevice_mem)
 		dma_unremap(rd_dev->device.parent, origdevice_mem, copy_size);
 
-	kfree(finalbuf);
 	rd_dev->data_ready = 0;
 	*pos = 0;
 	complete(&rd_dev->ramdump_complete);
@@ -307,6 +316,7 @@ void destroy_ramdump_device(void *dev)
 		return;
 
 	misc_deregister(&rd_dev->device);
+	vfree(rd_dev->read_buf);
 	kfree(rd_dev);
 }
 EXPORT_SYMBOL(destroy_ramdump_device);
@@ -36,6 +36,8 @@
 #include <linux/of.h>
 #include <linux/of_platform.h>
 #include <linux/rbtree.h>
+#include <linux/hashtable.h>
+#include <linux/jhash.h>
 #include <soc/qcom/rpm-notifier.h>
 #include <soc/qcom/rpm-smd.h>
 #include <soc/qcom/smd.h>
@@ -715,6 +717,192 @@ int msm_rpm_smd_buffer_request(struct msm_rpm_request *cdata,
 	return 0;
 }
 
+/*
+ * Active set values last sent to the RPM, per resource and key. The RPM keeps
+ * the active set of a master until it is changed, so a request repeating
+ * the values already in place, typically from a client that creates a fresh
+ * request for every vote, does not need to go out at all.
+ *
+ * Only values of up to MSM_RPM_ACT_VAL_SIZE bytes are tracked. An entry is
+ * dropped when the message that set it is NACKed, and msm_rpm_act_seq lets
+ * the unserialized noirq path invalidate updates racing with it.
+ */
+#define MSM_RPM_ACT_HASH_BITS	7
+#define MSM_RPM_ACT_VAL_SIZE	8
+
+struct msm_rpm_act_kvp {
+	struct hlist_node node;
+	uint32_t rsc_type;
+	uint32_t rsc_id;
+	uint32_t key;
+	uint32_t nbytes;
+	uint32_t msg_id;
+	uint8_t value[MSM_RPM_ACT_VAL_SIZE];
+};
+
+static DEFINE_HASHTABLE(msm_rpm_act_tbl, MSM_RPM_ACT_HASH_BITS);
+static DEFINE_SPINLOCK(msm_rpm_act_lock);
+static uint32_t msm_rpm_act_seq;
+
+static inline u32 msm_rpm_act_hash(uint32_t rsc_type, uint32_t rsc_id,
+		uint32_t key)
+{
+	return jhash_3words(rsc_type, rsc_id, key, 0);
+}
+
+/* Must be called with msm_rpm_act_lock held. */
+static struct msm_rpm_act_kvp *msm_rpm_act_find(uint32_t rsc_type,
+		uint32_t rsc_id, uint32_t key)
+{
+	struct msm_rpm_act_kvp *a;
+
+	hash_for_each_possible(msm_rpm_act_tbl, a, node,
+			msm_rpm_act_hash(rsc_type, rsc_id, key)) {
+		if (a->rsc_type == rsc_type && a->rsc_id == rsc_id &&
+				a->key == key)
+			return a;
+	}
+	return NULL;
+}
+
+/* Must be called with msm_rpm_act_lock held. */
+static void msm_rpm_act_drop_rsc(uint32_t rsc_type, uint32_t rsc_id)
+{
+	struct msm_rpm_act_kvp *a;
+	struct hlist_node *tmp;
+	int bkt;
+
+	hash_for_each_safe(msm_rpm_act_tbl, bkt, tmp, a, node) {
+		if (a->rsc_type == rsc_type && a->rsc_id == rsc_id) {
+			hash_del(&a->node);
+			kfree(a);
+		}
+	}
+}
+
+/*
+ * Returns true if every pending KVP of an active set request matches what
+ * the RPM already has, in which case there is nothing to send.
+ */
+static bool msm_rpm_act_cached(struct msm_rpm_request *cdata)
+{
+	uint32_t rsc_type = get_rsc_type(cdata->client_buf);
+	uint32_t rsc_id = get_rsc_id(cdata->client_buf);
+	struct msm_rpm_act_kvp *a;
+	unsigned long flags;
+	bool cached = true;
+	uint32_t i;
+
+	spin_lock_irqsave(&msm_rpm_act_lock, flags);
+	for (i = 0; i < cdata->write_idx && cached; i++) {
+		if (!cdata->kvp[i].valid)
+			continue;
+		a = msm_rpm_act_find(rsc_type, rsc_id, cdata->kvp[i].key);
+		cached = a && a->nbytes == cdata->kvp[i].nbytes &&
+			!memcmp(a->value, cdata->kvp[i].value, a->nbytes);
+	}
+	spin_unlock_irqrestore(&msm_rpm_act_lock, flags);
+
+	return cached;
+}
+
+static void msm_rpm_act_update(struct msm_rpm_request *cdata,
+		uint32_t msg_id, uint32_t seq)
+{
+	uint32_t rsc_type = get_rsc_type(cdata->client_buf);
+	uint32_t rsc_id = get_rsc_id(cdata->client_buf);
+	struct msm_rpm_kvp_data *kvp;
+	struct msm_rpm_act_kvp *a;
+	unsigned long flags;
+	uint32_t i;
+
+	spin_lock_irqsave(&msm_rpm_act_lock, flags);
+	if (seq != msm_rpm_act_seq) {
+		/* a noirq request may have overtaken this one */
+		msm_rpm_act_drop_rsc(rsc_type, rsc_id);
+		goto out;
+	}
+
+	for (i = 0; i < cdata->write_idx; i++) {
+		kvp = &cdata->kvp[i];
+		if (!kvp->valid)
+			continue;
+
+		/* an empty KVP invalidates the whole resource request */
+		if (!kvp->nbytes) {
+			msm_rpm_act_drop_rsc(rsc_type, rsc_id);
+			continue;
+		}
+
+		a = msm_rpm_act_find(rsc_type, rsc_id, kvp->key);
+		if (kvp->nbytes > MSM_RPM_ACT_VAL_SIZE) {
+			if (a) {
+				hash_del(&a->node);
+				kfree(a);
+			}
+			continue;
+		}
+
+		if (!a) {
+			a = kzalloc(sizeof(*a), GFP_ATOMIC);
+			if (!a)
+				continue;
+			a->rsc_type = rsc_type;
+			a->rsc_id = rsc_id;
+			a->key = kvp->key;
+			hash_add(msm_rpm_act_tbl, &a->node,
+				msm_rpm_act_hash(rsc_type, rsc_id, kvp->key));
+		}
+		a->nbytes = kvp->nbytes;
+		a->msg_id = msg_id;
+		memcpy(a->value, kvp->value, kvp->nbytes);
+	}
+out:
+	spin_unlock_irqrestore(&msm_rpm_act_lock, flags);
+}
+
+/* Forget the values set by a message the RPM refused */
+static void msm_rpm_act_nack(uint32_t msg_id)
+{
+	struct msm_rpm_act_kvp *a;
+	struct hlist_node *tmp;
+	unsigned long flags;
+	int bkt;
+
+	spin_lock_irqsave(&msm_rpm_act_lock, flags);
+	hash_for_each_safe(msm_rpm_act_tbl, bkt, tmp, a, node) {
+		if (a->msg_id == msg_id) {
+			hash_del(&a->node);
+			kfree(a);
+		}
+	}
+	spin_unlock_irqrestore(&msm_rpm_act_lock, flags);
+}
+
+/* Invalidate the cached values of a resource written from the noirq path */
+static void msm_rpm_act_invalidate(struct msm_rpm_request *cdata)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&msm_rpm_act_lock, flags);
+	msm_rpm_act_drop_rsc(get_rsc_type(cdata->client_buf),
+			get_rsc_id(cdata->client_buf));
+	msm_rpm_act_seq++;
+	spin_unlock_irqrestore(&msm_rpm_act_lock, flags);
+}
+
+static uint32_t msm_rpm_act_get_seq(void)
+{
+	unsigned long flags;
+	uint32_t seq;
+
+	spin_lock_irqsave(&msm_rpm_act_lock, flags);
+	seq = msm_rpm_act_seq;
+	spin_unlock_irqrestore(&msm_rpm_act_lock, flags);
+
+	return seq;
+}
+
 static struct msm_rpm_driver_data msm_rpm_data = {
 	.smd_open = COMPLETION_INITIALIZER(msm_rpm_data.smd_open),
 };
@@ -1120,6 +1308,9 @@ static void msm_rpm_process_ack(uint32_t msg_id, int errno)
 	struct msm_rpm_wait_data *elem = NULL;
 	unsigned long flags;
 
+	if (errno)
+		msm_rpm_act_nack(msg_id);
+
 	spin_lock_irqsave(&msm_rpm_list_lock, flags);
 
 	list_for_each_safe(ptr, next, &msm_rpm_wait_list) {
@@ -1418,6 +1609,7 @@ static int msm_rpm_send_data(struct msm_rpm_request *cdata,
 	uint32_t data_len = get_data_len(cdata->client_buf);
 	uint32_t set = get_set_type(cdata->client_buf);
 	uint32_t msg_id;
+	uint32_t act_seq = 0;
 
 	if (probe_status)
 		return probe_status;
@@ -1425,6 +1617,19 @@ static int msm_rpm_send_data(struct msm_rpm_request *cdata,
 	if (!data_len)
 		return 1;
 
+	if (set == MSM_RPM_CTX_ACTIVE_SET && !standalone) {
+		if (noirq) {
+			msm_rpm_act_invalidate(cdata);
+		} else if (msm_rpm_act_cached(cdata)) {
+			for (i = 0; i < cdata->write_idx; i++)
+				cdata->kvp[i].valid = false;
+			set_data_len(cdata->client_buf, 0);
+			return 1;
+		} else {
+			act_seq = msm_rpm_act_get_seq();
+		}
+	}
+
 	msg_hdr_sz = rpm_msg_fmt_ver ? sizeof(struct rpm_message_header_v1) :
 			sizeof(struct rpm_message_header_v0);
 
@@ -1500,6 +1705,13 @@ static int msm_rpm_send_data(struct msm_rpm_request *cdata,
 
 	ret = msm_rpm_send_buffer(&cdata->buf[0], msg_size, noirq);
 
+	if (set == MSM_RPM_CTX_ACTIVE_SET) {
+		if (noirq)
+			msm_rpm_act_invalidate(cdata);
+		else if (ret == msg_size)
+			msm_rpm_act_update(cdata, msg_id, act_seq);
+	}
+
 	if (ret == msg_size) {
 		for (i = 0; (i < cdata->write_idx); i++)
 			cdata->kvp[i].valid = false;
@@ -1730,6 +1942,35 @@ bail:
 }
 EXPORT_SYMBOL(msm_rpm_send_message);
 
+int msm_rpm_send_message_nowait(enum msm_rpm_set set, uint32_t rsc_type,
+		uint32_t rsc_id, struct msm_rpm_kvp *kvp, int nelems)
+{
+	int i, rc;
+	struct msm_rpm_request *req =
+		msm_rpm_create_request(set, rsc_type, rsc_id, nelems);
+
+	if (IS_ERR(req))
+		return PTR_ERR(req);
+
+	if (!req)
+		return -ENOMEM;
+
+	for (i = 0; i < nelems; i++) {
+		rc = msm_rpm_add_kvp_data(req, kvp[i].key,
+				kvp[i].data, kvp[i].length);
+		if (rc)
+			goto bail;
+	}
+
+	rc = msm_rpm_send_request(req);
+	if (!rc)
+		rc = -EIO;
+bail:
+	msm_rpm_free_request(req);
+	return rc;
+}
+EXPORT_SYMBOL(msm_rpm_send_message_nowait);
+
 int msm_rpm_send_message_noirq(enum msm_rpm_set set, uint32_t rsc_type,
 		uint32_t rsc_id, struct msm_rpm_kvp *kvp, int nelems)
 {
@@ -18,6 +18,9 @@
 #include <linux/err.h>
 #include <linux/init.h>
 #include <linux/delay.h>
+#include <linux/debugfs.h>
+#include <linux/ktime.h>
+#include <linux/seq_file.h>
 
 #include <asm/cacheflush.h>
 #include <asm/compiler.h>
@@ -552,6 +555,25 @@ static enum scm_interface_version {
 /* This will be set to specify SMC32 or SMC64 */
 static u32 scm_version_mask;
 
+/*
+ * Extended argument buffer for scm_call2(). It is only touched with
+ * scm_lock held and is refilled before every SMC, so a retry after another
+ * caller has used it still sends the right arguments.
+ */
+static union {
+	struct scm_extra_arg arg;
+	u8 page[PAGE_SIZE];
+} scm_extra_arg_page __aligned(PAGE_SIZE);
+
+/* Per-service latency of scm_call2(), protected by scm_lock */
+struct scm_svc_stats {
+	u64 count;
+	u64 total_ns;
+	u64 max_ns;
+};
+
+static struct scm_svc_stats scm_stats[0x100];
+
 bool is_scm_armv8(void)
 {
 	int ret;
@@ -598,9 +620,26 @@ EXPORT_SYMBOL(is_scm_armv8);
  * the additional arguments in it. The extra argument buffer will be
  * pointed to by X5.
  */
-static int allocate_extra_arg_buffer(struct scm_desc *desc, gfp_t flags)
+static void scm_fill_extra_arg(struct scm_desc *desc,
+			       struct scm_extra_arg *argbuf, size_t argbuflen)
 {
 	int i, j;
+
+	j = FIRST_EXT_ARG_IDX;
+	if (scm_version == SCM_ARMV8_64)
+		for (i = 0; i < N_EXT_SCM_ARGS; i++)
+			argbuf->args64[i] = desc->args[j++];
+	else
+		for (i = 0; i < N_EXT_SCM_ARGS; i++)
+			argbuf->args32[i] = desc->args[j++];
+	desc->x5 = virt_to_phys(argbuf);
+	__cpuc_flush_dcache_area(argbuf, argbuflen);
+	outer_flush_range(virt_to_phys(argbuf),
+			  virt_to_phys(argbuf) + argbuflen);
+}
+
+static int allocate_extra_arg_buffer(struct scm_desc *desc, gfp_t flags)
+{
 	struct scm_extra_arg *argbuf;
 	int arglen = desc->arginfo & 0xf;
 	size_t argbuflen = PAGE_ALIGN(sizeof(struct scm_extra_arg));
@@ -619,22 +658,22 @@ static int allocate_extra_arg_buffer(struct scm_desc *desc, gfp_t flags)
 	}
 
 	desc->extra_arg_buf = argbuf;
-
-	j = FIRST_EXT_ARG_IDX;
-	if (scm_version == SCM_ARMV8_64)
-		for (i = 0; i < N_EXT_SCM_ARGS; i++)
-			argbuf->args64[i] = desc->args[j++];
-	else
-		for (i = 0; i < N_EXT_SCM_ARGS; i++)
-			argbuf->args32[i] = desc->args[j++];
-	desc->x5 = virt_to_phys(argbuf);
-	__cpuc_flush_dcache_area(argbuf, argbuflen);
-	outer_flush_range(virt_to_phys(argbuf),
-			  virt_to_phys(argbuf) + argbuflen);
+	scm_fill_extra_arg(desc, argbuf, argbuflen);
 
 	return 0;
 }
 
+static void scm_account_call(u64 x0, ktime_t start)
+{
+	struct scm_svc_stats *stats = &scm_stats[SCM_SVC_ID(x0)];
+	u64 delta = ktime_to_ns(ktime_sub(ktime_get(), start));
+
+	stats->count++;
+	stats->total_ns += delta;
+	if (delta > stats->max_ns)
+		stats->max_ns = delta;
+}
+
 /**
  * scm_call2() - Invoke a syscall in the secure world
  * @fn_id: The function ID for this syscall
@@ -660,14 +699,14 @@ int scm_call2(u32 fn_id, struct scm_desc *desc)
 {
 	int arglen = desc->arginfo & 0xf;
 	int ret, retry_count = 0;
+	ktime_t start;
 	u64 x0;
 
 	if (unlikely(!is_scm_armv8()))
 		return -ENODEV;
 
-	ret = allocate_extra_arg_buffer(desc, GFP_NOIO);
-	if (ret)
-		return ret;
+	desc->x5 = desc->args[FIRST_EXT_ARG_IDX];
+	desc->extra_arg_buf = NULL;
 
 	x0 = fn_id | scm_version_mask;
 
@@ -677,9 +716,14 @@ int scm_call2(u32 fn_id, struct scm_desc *desc)
 		if (SCM_SVC_ID(fn_id) == SCM_SVC_LMH)
 			mutex_lock(&scm_lmh_lock);
 
+		if (arglen > N_REGISTER_ARGS)
+			scm_fill_extra_arg(desc, &scm_extra_arg_page.arg,
+					   sizeof(scm_extra_arg_page));
+
 		desc->ret[0] = desc->ret[1] = desc->ret[2] = 0;
 
 		trace_scm_call_start(x0, desc);
+		start = ktime_get();
 
 		if (scm_version == SCM_ARMV8_64)
 			ret = __scm_call_armv8_64(x0, desc->arginfo,
@@ -694,6 +738,7 @@ int scm_call2(u32 fn_id, struct scm_desc *desc)
 						  &desc->ret[0], &desc->ret[1],
 						  &desc->ret[2]);
 
+		scm_account_call(x0, start);
 		trace_scm_call_end(desc);
 
 		if (SCM_SVC_ID(fn_id) == SCM_SVC_LMH)
@@ -711,8 +756,6 @@ int scm_call2(u32 fn_id, struct scm_desc *desc)
 		pr_err("scm_call failed: func id %#llx, ret: %d, syscall returns: %#llx, %#llx, %#llx\n",
 			x0, ret, desc->ret[0], desc->ret[1], desc->ret[2]);
 
-	if (arglen > N_REGISTER_ARGS)
-		kfree(desc->extra_arg_buf);
 	if (ret < 0)
 		return scm_remap_error(ret);
 	return 0;
@@ -1243,3 +1286,42 @@ bool scm_is_secure_device(void)
 		return false;
 }
 EXPORT_SYMBOL(scm_is_secure_device);
+
+static int scm_stats_show(struct seq_file *s, void *unused)
+{
+	struct scm_svc_stats *stats;
+	int svc;
+
+	seq_puts(s, "svc     count      avg_ns      max_ns\n");
+	mutex_lock(&scm_lock);
+	for (svc = 0; svc < ARRAY_SIZE(scm_stats); svc++) {
+		stats = &scm_stats[svc];
+		if (!stats->count)
+			continue;
+		seq_printf(s, "0x%02x %8llu %11llu %11llu\n", svc, stats->count,
+			   div64_u64(stats->total_ns, stats->count),
+			   stats->max_ns);
+	}
+	mutex_unlock(&scm_lock);
+	return 0;
+}
+
+static int scm_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, scm_stats_show, NULL);
+}
+
+static const struct file_operations scm_stats_fops = {
+	.open = scm_stats_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+static int __init scm_debugfs_init(void)
+{
+	debugfs_create_file("scm_stats", S_IRUSR, NULL, NULL,
+			    &scm_stats_fops);
+	return 0;
+}
+late_initcall(scm_debugfs_init);
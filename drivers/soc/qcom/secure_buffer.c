@@ -217,16 +217,27 @@ populate_dest_info(int *dest_vmids, int nelements, int *dest_perms,
 	return dest_info;
 }
 
-/* Must hold secure_buffer_mutex while allocated buffer is in use */
-static struct mem_prot_info *get_info_list_from_table(struct sg_table *table,
-						      size_t *size_in_bytes)
+#define BATCH_MAX_SIZE SZ_2M
+#define BATCH_MAX_SECTIONS 32
+
+/*
+ * Must hold secure_buffer_mutex while allocated buffer is in use.
+ *
+ * Physically contiguous entries, within and across tables, are merged so
+ * the hypervisor has fewer sections to walk and each SCM call can cover
+ * more memory. Merged entries stay below BATCH_MAX_SIZE to keep the time
+ * spent in a single call bounded.
+ */
+static struct mem_prot_info *get_info_list_from_tables(
+		struct sg_table **tables, int ntables, int *nents)
 {
-	int i;
+	int i, t, n = 0;
 	struct scatterlist *sg;
 	struct mem_prot_info *info;
-	size_t size;
+	size_t size = 0;
 
-	size = table->nents * sizeof(*info);
+	for (t = 0; t < ntables; t++)
+		size += tables[t]->nents * sizeof(*info);
 
 	if (size >= QCOM_SECURE_MEM_SIZE) {
 		pr_err("%s: Not enough memory allocated. Required size %zd\n",
@@ -243,19 +254,26 @@ static struct mem_prot_info *get_info_list_from_table(struct sg_table *table,
 	/* "Allocate" it */
 	info = qcom_secure_mem;
 
-	for_each_sg(table->sgl, sg, table->nents, i) {
-		info[i].addr = page_to_phys(sg_page(sg));
-		info[i].size = sg->length;
+	for (t = 0; t < ntables; t++) {
+		for_each_sg(tables[t]->sgl, sg, tables[t]->nents, i) {
+			phys_addr_t addr = page_to_phys(sg_page(sg));
+
+			if (n && info[n - 1].addr + info[n - 1].size == addr &&
+			    info[n - 1].size + sg->length < BATCH_MAX_SIZE) {
+				info[n - 1].size += sg->length;
+				continue;
+			}
+			info[n].addr = addr;
+			info[n].size = sg->length;
+			n++;
+		}
 	}
 
-	*size_in_bytes = size;
+	*nents = n;
 	return info;
 }
 
-#define BATCH_MAX_SIZE SZ_2M
-#define BATCH_MAX_SECTIONS 32
-
-int hyp_assign_table(struct sg_table *table,
+static int __hyp_assign_tables(struct sg_table **tables, int ntables,
 			u32 *source_vm_list, int source_nelems,
 			int *dest_vmids, int *dest_perms,
 			int dest_nelems)
@@ -268,6 +286,7 @@ int hyp_assign_table(struct sg_table *table,
 	size_t dest_vm_copy_size;
 	struct mem_prot_info *sg_table_copy;
 	size_t sg_table_copy_size;
+	int nents;
 
 	int batch_start, batch_end;
 	u64 batch_size;
@@ -293,11 +312,12 @@ int hyp_assign_table(struct sg_table *table,
 
 	mutex_lock(&secure_buffer_mutex);
 
-	sg_table_copy = get_info_list_from_table(table, &sg_table_copy_size);
+	sg_table_copy = get_info_list_from_tables(tables, ntables, &nents);
 	if (!sg_table_copy) {
 		ret = -ENOMEM;
 		goto out_unlock;
 	}
+	sg_table_copy_size = nents * sizeof(*sg_table_copy);
 
 	desc.args[0] = virt_to_phys(sg_table_copy);
 	desc.args[1] = sg_table_copy_size;
@@ -318,14 +338,14 @@ int hyp_assign_table(struct sg_table *table,
 			 (void *)dest_vm_copy + dest_vm_copy_size);
 
 	batch_start = 0;
-	while (batch_start < table->nents) {
+	while (batch_start < nents) {
 		/* Ensure no size zero batches */
 		batch_size = sg_table_copy[batch_start].size;
 		batch_end = batch_start + 1;
 		while (1) {
 			u64 size;
 
-			if (batch_end >= table->nents)
+			if (batch_end >= nents)
 				break;
 			if (batch_end - batch_start >= BATCH_MAX_SECTIONS)
 				break;
@@ -360,6 +380,38 @@ out_free:
 	return ret;
 }
 
+int hyp_assign_table(struct sg_table *table,
+			u32 *source_vm_list, int source_nelems,
+			int *dest_vmids, int *dest_perms,
+			int dest_nelems)
+{
+	return __hyp_assign_tables(&table, 1, source_vm_list, source_nelems,
+				   dest_vmids, dest_perms, dest_nelems);
+}
+
+/**
+ * hyp_assign_tables() - assign several buffers to the same set of VMs
+ * @tables:	buffers to assign
+ * @ntables:	number of entries in @tables
+ *
+ * The remaining arguments are as for hyp_assign_table(). The buffers are
+ * assigned with as few calls into the hypervisor as possible. If an error
+ * is returned, an unknown subset of the buffers may have been assigned.
+ */
+int hyp_assign_tables(struct sg_table **tables, int ntables,
+			u32 *source_vm_list, int source_nelems,
+			int *dest_vmids, int *dest_perms,
+			int dest_nelems)
+{
+	if (!tables || ntables <= 0)
+		return -EINVAL;
+
+	return __hyp_assign_tables(tables, ntables, source_vm_list,
+				   source_nelems, dest_vmids, dest_perms,
+				   dest_nelems);
+}
+EXPORT_SYMBOL(hyp_assign_tables);
+
 int hyp_assign_phys(phys_addr_t addr, u64 size, u32 *source_vm_list,
 			int source_nelems, int *dest_vmids,
 			int *dest_perms, int dest_nelems)
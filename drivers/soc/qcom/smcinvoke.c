@@ -18,6 +18,9 @@
 #include <linux/file.h>
 #include <linux/fs.h>
 #include <linux/anon_inodes.h>
+#include <linux/debugfs.h>
+#include <linux/ktime.h>
+#include <linux/seq_file.h>
 #include <linux/smcinvoke.h>
 #include <soc/qcom/scm.h>
 #include <asm/cacheflush.h>
@@ -74,8 +77,18 @@ struct smcinvoke_msg_hdr {
 
 struct smcinvoke_tzobj_context {
 	uint32_t	tzhandle;
+	struct list_head list;
+	/* invocation statistics, updated under smcinvoke_obj_lock */
+	uint64_t	nr_invokes;
+	uint64_t	nr_errors;
+	uint64_t	total_ns;
+	uint64_t	max_ns;
 };
 
+/* all open objects, for the debugfs statistics */
+static LIST_HEAD(smcinvoke_obj_list);
+static DEFINE_MUTEX(smcinvoke_obj_lock);
+
 /*
  * size_add saturates at SIZE_MAX. If integer overflow is detected,
  * this function would return SIZE_MAX otherwise normal a+b is returned.
@@ -168,6 +181,11 @@ static int get_fd_from_tzhandle(uint32_t tzhandle, int64_t *fd)
 	if (IS_ERR(f))
 		goto out;
 
+	/* on the list before the fd is visible, release will remove it */
+	mutex_lock(&smcinvoke_obj_lock);
+	list_add_tail(&cxt->list, &smcinvoke_obj_list);
+	mutex_unlock(&smcinvoke_obj_lock);
+
 	*fd = unused_fd;
 	fd_install(*fd, f);
 	((struct smcinvoke_tzobj_context *)
@@ -356,6 +374,21 @@ out:
 	return ret;
 }
 
+static void smcinvoke_account(struct smcinvoke_tzobj_context *tzobj,
+			      ktime_t start, bool failed)
+{
+	uint64_t delta = ktime_to_ns(ktime_sub(ktime_get(), start));
+
+	mutex_lock(&smcinvoke_obj_lock);
+	tzobj->nr_invokes++;
+	if (failed)
+		tzobj->nr_errors++;
+	tzobj->total_ns += delta;
+	if (delta > tzobj->max_ns)
+		tzobj->max_ns = delta;
+	mutex_unlock(&smcinvoke_obj_lock);
+}
+
 long smcinvoke_ioctl(struct file *filp, unsigned cmd, unsigned long arg)
 {
 	int    ret = -1, i = 0, nr_args = 0;
@@ -366,6 +399,7 @@ long smcinvoke_ioctl(struct file *filp, unsigned cmd, unsigned long arg)
 	union  smcinvoke_arg *args_buf = NULL;
 	struct file *filp_to_release[object_counts_max_OO] = {NULL};
 	struct smcinvoke_tzobj_context *tzobj = filp->private_data;
+	ktime_t start;
 
 	switch (cmd) {
 	case SMCINVOKE_IOCTL_INVOKE_REQ:
@@ -424,8 +458,10 @@ long smcinvoke_ioctl(struct file *filp, unsigned cmd, unsigned long arg)
 		if (ret)
 			goto out;
 
+		start = ktime_get();
 		ret = prepare_send_scm_msg(in_msg, inmsg_size, out_msg,
 				SMCINVOKE_TZ_MIN_BUF_SIZE, &req.result);
+		smcinvoke_account(tzobj, start, ret || req.result);
 		if (ret)
 			goto out;
 
@@ -472,6 +508,10 @@ static int smcinvoke_open(struct inode *nodp, struct file *filp)
 	tzcxt->tzhandle = SMCINVOKE_TZ_ROOT_OBJ;
 	filp->private_data = tzcxt;
 
+	mutex_lock(&smcinvoke_obj_lock);
+	list_add_tail(&tzcxt->list, &smcinvoke_obj_list);
+	mutex_unlock(&smcinvoke_obj_lock);
+
 	return 0;
 }
 
@@ -502,6 +542,9 @@ static int smcinvoke_release(struct inode *nodp, struct file *filp)
 	ret = prepare_send_scm_msg(in_buf, SMCINVOKE_TZ_MIN_BUF_SIZE,
 			out_buf, SMCINVOKE_TZ_MIN_BUF_SIZE, &smcinvoke_result);
 out:
+	mutex_lock(&smcinvoke_obj_lock);
+	list_del(&tzobj->list);
+	mutex_unlock(&smcinvoke_obj_lock);
 	kfree(filp->private_data);
 	free_page((long)in_buf);
 	free_page((long)out_buf);
@@ -509,8 +552,41 @@ out:
 	return ret;
 }
 
+static int smcinvoke_stats_show(struct seq_file *s, void *unused)
+{
+	struct smcinvoke_tzobj_context *tzobj;
+
+	seq_puts(s, "tzhandle    invokes   errors      avg_ns      max_ns\n");
+	mutex_lock(&smcinvoke_obj_lock);
+	list_for_each_entry(tzobj, &smcinvoke_obj_list, list) {
+		if (!tzobj->nr_invokes)
+			continue;
+		seq_printf(s, "0x%08x %8llu %8llu %11llu %11llu\n",
+			   tzobj->tzhandle, tzobj->nr_invokes,
+			   tzobj->nr_errors,
+			   div64_u64(tzobj->total_ns, tzobj->nr_invokes),
+			   tzobj->max_ns);
+	}
+	mutex_unlock(&smcinvoke_obj_lock);
+	return 0;
+}
+
+static int smcinvoke_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, smcinvoke_stats_show, NULL);
+}
+
+static const struct file_operations smcinvoke_stats_fops = {
+	.open = smcinvoke_stats_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
 static int __init smcinvoke_init(void)
 {
+	debugfs_create_file("smcinvoke", S_IRUSR, NULL, NULL,
+			    &smcinvoke_stats_fops);
 	return misc_register(&smcinvoke_miscdev);
 }
 
@@ -1377,6 +1377,75 @@ int msm_smp2p_out_modify(struct msm_smp2p_out *handle, uint32_t set_mask,
 }
 EXPORT_SYMBOL(msm_smp2p_out_modify);
 
+/**
+ * msm_smp2p_out_modify_batch - Modifies several entries with one interrupt.
+ *
+ * @updates: Array of entry updates, all for the same remote processor.
+ * @num: Number of elements in @updates.
+ * @returns: 0 on success, standard Linux error code otherwise.
+ *
+ * Applies each update as msm_smp2p_out_modify() would, under a single hold
+ * of the edge lock, and then raises at most one interrupt to the remote
+ * processor. No interrupt is sent if none of the entries changed value.
+ * If an update fails, the updates before it remain applied and the remote
+ * processor is still notified of them.
+ */
+int msm_smp2p_out_modify_batch(struct msm_smp2p_batch_update *updates,
+					int num)
+{
+	int ret = 0;
+	int i;
+	int remote_pid;
+	int changed = 0;
+	unsigned long flags;
+	struct smp2p_out_list_item *out_item;
+
+	if (!updates || num <= 0 || !updates[0].handle)
+		return -EINVAL;
+
+	remote_pid = updates[0].handle->remote_pid;
+	for (i = 1; i < num; i++)
+		if (!updates[i].handle ||
+				updates[i].handle->remote_pid != remote_pid)
+			return -EINVAL;
+
+	if ((remote_pid != SMP2P_REMOTE_MOCK_PROC) &&
+			!smp2p_int_cfgs[remote_pid].is_configured) {
+		SMP2P_INFO("%s before msm_smp2p_init(): pid[%d]\n",
+			__func__, remote_pid);
+		return -EPROBE_DEFER;
+	}
+
+	out_item = &out_list[remote_pid];
+	spin_lock_irqsave(&out_item->out_item_lock_lha1, flags);
+	for (i = 0; i < num; i++) {
+		uint32_t old_val = 0;
+		uint32_t new_val = 0;
+
+		ret = out_item->ops_ptr->read_entry(updates[i].handle,
+							&old_val);
+		if (ret)
+			break;
+		ret = out_item->ops_ptr->modify_entry(updates[i].handle,
+				updates[i].set_mask, updates[i].clear_mask,
+				false);
+		if (ret)
+			break;
+		out_item->ops_ptr->read_entry(updates[i].handle, &new_val);
+		if (new_val != old_val)
+			changed++;
+	}
+
+	if (changed) {
+		smp2p_send_interrupt(remote_pid);
+		smp2p_int_cfgs[remote_pid].out_interrupt_saved += changed - 1;
+	}
+	spin_unlock_irqrestore(&out_item->out_item_lock_lha1, flags);
+
+	return ret;
+}
+EXPORT_SYMBOL(msm_smp2p_out_modify_batch);
+
 /**
  * msm_smp2p_in_read - Read an entry on a remote processor.
  *
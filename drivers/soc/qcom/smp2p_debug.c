@@ -34,18 +34,20 @@ static void smp2p_int_stats(struct seq_file *s)
 		return;
 
 	seq_puts(s, "| Processor | Incoming Id | Incoming # |");
-	seq_puts(s, " Outgoing # | Base Ptr |   Mask   |\n");
+	seq_puts(s, " Outgoing # |  Saved #  | Base Ptr |   Mask   |\n");
 
 	for (pid = 0; pid < SMP2P_NUM_PROCS; ++pid) {
 		if (!int_cfg[pid].is_configured &&
 				pid != SMP2P_REMOTE_MOCK_PROC)
 			continue;
 
-		seq_printf(s, "| %5s (%d) | %11u | %10u | %10u | %pK | %08x |\n",
+		seq_printf(s,
+			"| %5s (%d) | %11u | %10u | %10u | %9u | %pK | %08x |\n",
 			int_cfg[pid].name,
 			pid, int_cfg[pid].in_int_id,
 			int_cfg[pid].in_interrupt_count,
 			int_cfg[pid].out_interrupt_count,
+			int_cfg[pid].out_interrupt_saved,
 			int_cfg[pid].out_int_ptr,
 			int_cfg[pid].out_int_mask);
 	}
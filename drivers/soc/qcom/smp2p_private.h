@@ -243,6 +243,8 @@ struct smp2p_interrupt_config {
 	/* interrupt stats */
 	unsigned in_interrupt_count;
 	unsigned out_interrupt_count;
+	/* interrupts not sent because a batch update was coalesced */
+	unsigned out_interrupt_saved;
 };
 
 struct smp2p_interrupt_config *smp2p_get_interrupt_config(void);
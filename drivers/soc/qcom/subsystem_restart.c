@@ -1290,9 +1290,12 @@ static void subsystem_restart_wq_func(struct work_struct *work)
 	/*
 	 * It's necessary to take the registration lock because the subsystem
 	 * list in the SoC restart order will be traversed and it shouldn't be
-	 * changed until _this_ restart sequence completes.
+	 * changed until _this_ restart sequence completes. A subsystem that
+	 * isn't part of any restart order only touches itself, so it doesn't
+	 * need to wait for the restart of an unrelated subsystem.
 	 */
-	mutex_lock(&soc_order_reg_lock);
+	if (order)
+		mutex_lock(&soc_order_reg_lock);
 
 	pr_debug("[%s:%d]: Starting restart sequence for %s\n",
 			current->comm, current->pid, desc->name);
@@ -1349,7 +1352,8 @@ err:
 	if (ret)
 		dev->count = 0;
 
-	mutex_unlock(&soc_order_reg_lock);
+	if (order)
+		mutex_unlock(&soc_order_reg_lock);
 	mutex_unlock(&track->lock);
 
 	spin_lock_irqsave(&track->s_lock, flags);
@@ -27,6 +27,7 @@
 #include <linux/list_sort.h>
 #include <linux/memblock.h>
 #include <linux/miscdevice.h>
+#include <linux/module.h>
 #include <linux/export.h>
 #include <linux/mm.h>
 #include <linux/mm_types.h>
@@ -41,6 +42,7 @@
 #include <linux/msm_ion.h>
 #include <linux/msm_dma_iommu_mapping.h>
 #include <trace/events/kmem.h>
+#include <asm/cacheflush.h>
 
 
 #include "ion.h"
@@ -78,6 +80,11 @@ static inline void ion_buffer_page_clean(struct page **page)
 	*page = (struct page *)((unsigned long)(*page) & ~(1UL));
 }
 
+#ifdef CONFIG_ION_BUFFER_RECYCLE
+static int recycle_max = CONFIG_ION_BUFFER_RECYCLE_MAX;
+module_param(recycle_max, int, S_IRUGO | S_IWUSR);
+#endif
+
 /* this function should only be called while dev->lock is held */
 static void ion_buffer_add(struct ion_device *dev,
 			   struct ion_buffer *buffer)
@@ -208,28 +215,194 @@ void ion_buffer_destroy(struct ion_buffer *buffer)
 
 	atomic_long_sub(buffer->size, &buffer->heap->total_allocated);
 	buffer->heap->ops->free(buffer);
+#ifdef CONFIG_ION_BUFFER_RECYCLE
+	put_pid(buffer->owner);
+#endif
 	vfree(buffer->pages);
 	kfree(buffer);
 }
 
-static void _ion_buffer_destroy(struct kref *kref)
+/* Hand a buffer nobody holds any more back to its heap */
+static void ion_buffer_release(struct ion_buffer *buffer)
 {
-	struct ion_buffer *buffer = container_of(kref, struct ion_buffer, ref);
 	struct ion_heap *heap = buffer->heap;
-	struct ion_device *dev = buffer->dev;
 
 	msm_dma_buf_freed(buffer);
 
-	mutex_lock(&dev->buffer_lock);
-	rb_erase(&buffer->node, &dev->buffers);
-	mutex_unlock(&dev->buffer_lock);
-
 	if (heap->flags & ION_HEAP_FLAG_DEFER_FREE)
 		ion_heap_freelist_add(heap, buffer);
 	else
 		ion_buffer_destroy(buffer);
 }
 
+#ifdef CONFIG_ION_BUFFER_RECYCLE
+/*
+ * Keep a freed buffer for its owner instead of handing it back to the
+ * heap. Buffers that are still mapped in some way, or whose owner has
+ * exited, go through the normal free path.
+ */
+static bool ion_buffer_recycle(struct ion_buffer *buffer)
+{
+	struct ion_device *dev = buffer->dev;
+	struct ion_buffer *evict = NULL;
+	bool alive;
+
+	if (READ_ONCE(recycle_max) <= 0 || !buffer->owner ||
+	    buffer->pages || buffer->kmap_cnt || !list_empty(&buffer->vmas))
+		return false;
+
+	rcu_read_lock();
+	alive = pid_task(buffer->owner, PIDTYPE_PID) != NULL;
+	rcu_read_unlock();
+	if (!alive)
+		return false;
+
+	mutex_lock(&dev->recycle_lock);
+	list_add(&buffer->list, &dev->recycle_list);
+	atomic_long_add(buffer->size, &dev->recycle_size);
+	if (++dev->recycle_count > recycle_max) {
+		evict = list_last_entry(&dev->recycle_list, struct ion_buffer,
+					list);
+		list_del(&evict->list);
+		atomic_long_sub(evict->size, &dev->recycle_size);
+		dev->recycle_count--;
+	}
+	mutex_unlock(&dev->recycle_lock);
+
+	if (evict)
+		ion_buffer_release(evict);
+
+	return true;
+}
+
+/*
+ * Find a buffer the current process freed earlier that can satisfy an
+ * allocation. The buffer is returned with the reference and tree state of
+ * a freshly created one.
+ */
+static struct ion_buffer *ion_buffer_recycle_get(struct ion_device *dev,
+		size_t len, size_t align, unsigned int heap_id_mask,
+		unsigned int flags)
+{
+	struct ion_buffer *buffer, *found = NULL;
+	struct pid *owner = task_tgid(current);
+
+	/* unlocked peek, the walk below rechecks under recycle_lock */
+	if (align > PAGE_SIZE || list_empty_careful(&dev->recycle_list))
+		return NULL;
+
+	mutex_lock(&dev->recycle_lock);
+	list_for_each_entry(buffer, &dev->recycle_list, list) {
+		if (buffer->owner == owner && buffer->size == len &&
+		    buffer->flags == flags &&
+		    ((1 << buffer->heap->id) & heap_id_mask)) {
+			found = buffer;
+			list_del(&buffer->list);
+			atomic_long_sub(buffer->size, &dev->recycle_size);
+			dev->recycle_count--;
+			break;
+		}
+	}
+	mutex_unlock(&dev->recycle_lock);
+
+	if (!found)
+		return NULL;
+
+	kref_init(&found->ref);
+	mutex_lock(&dev->buffer_lock);
+	ion_buffer_add(dev, found);
+	mutex_unlock(&dev->buffer_lock);
+
+	return found;
+}
+
+static void ion_buffer_set_owner(struct ion_buffer *buffer)
+{
+	if (!buffer->owner)
+		buffer->owner = get_pid(task_tgid(current));
+}
+
+static unsigned long ion_recycle_shrink_count(struct shrinker *shrinker,
+					      struct shrink_control *sc)
+{
+	struct ion_device *dev = container_of(shrinker, struct ion_device,
+					      recycle_shrinker);
+
+	return atomic_long_read(&dev->recycle_size) >> PAGE_SHIFT;
+}
+
+static unsigned long ion_recycle_shrink_scan(struct shrinker *shrinker,
+					     struct shrink_control *sc)
+{
+	struct ion_device *dev = container_of(shrinker, struct ion_device,
+					      recycle_shrinker);
+	struct ion_buffer *buffer;
+	unsigned long freed = 0;
+
+	while (freed < sc->nr_to_scan) {
+		mutex_lock(&dev->recycle_lock);
+		buffer = NULL;
+		if (!list_empty(&dev->recycle_list)) {
+			buffer = list_last_entry(&dev->recycle_list,
+						 struct ion_buffer, list);
+			list_del(&buffer->list);
+			atomic_long_sub(buffer->size, &dev->recycle_size);
+			dev->recycle_count--;
+		}
+		mutex_unlock(&dev->recycle_lock);
+		if (!buffer)
+			break;
+
+		/* no point in zeroing or pooling memory that is reclaimed */
+		freed += buffer->size >> PAGE_SHIFT;
+		buffer->private_flags |= ION_PRIV_FLAG_SHRINKER_FREE;
+		msm_dma_buf_freed(buffer);
+		ion_buffer_destroy(buffer);
+	}
+
+	return freed;
+}
+
+static void ion_recycle_init(struct ion_device *dev)
+{
+	INIT_LIST_HEAD(&dev->recycle_list);
+	mutex_init(&dev->recycle_lock);
+	dev->recycle_shrinker.count_objects = ion_recycle_shrink_count;
+	dev->recycle_shrinker.scan_objects = ion_recycle_shrink_scan;
+	dev->recycle_shrinker.seeks = DEFAULT_SEEKS;
+	register_shrinker(&dev->recycle_shrinker);
+}
+#else
+static inline bool ion_buffer_recycle(struct ion_buffer *buffer)
+{
+	return false;
+}
+
+static inline struct ion_buffer *ion_buffer_recycle_get(
+		struct ion_device *dev, size_t len, size_t align,
+		unsigned int heap_id_mask, unsigned int flags)
+{
+	return NULL;
+}
+
+static inline void ion_buffer_set_owner(struct ion_buffer *buffer) {}
+static inline void ion_recycle_init(struct ion_device *dev) {}
+#endif
+
+static void _ion_buffer_destroy(struct kref *kref)
+{
+	struct ion_buffer *buffer = container_of(kref, struct ion_buffer, ref);
+	struct ion_device *dev = buffer->dev;
+
+	mutex_lock(&dev->buffer_lock);
+	rb_erase(&buffer->node, &dev->buffers);
+	mutex_unlock(&dev->buffer_lock);
+
+	/* a recycled buffer keeps its SMMU mappings for the next user */
+	if (!ion_buffer_recycle(buffer))
+		ion_buffer_release(buffer);
+}
+
 static void ion_buffer_get(struct ion_buffer *buffer)
 {
 	kref_get(&buffer->ref);
@@ -505,6 +678,10 @@ static struct ion_handle *__ion_alloc(struct ion_client *client, size_t len,
 	if (!len)
 		return ERR_PTR(-EINVAL);
 
+	buffer = ion_buffer_recycle_get(dev, len, align, heap_id_mask, flags);
+	if (buffer)
+		goto create_handle;
+
 	down_read(&dev->lock);
 	plist_for_each_entry(heap, &dev->heaps, node) {
 		/* if the caller didn't specify this heap id */
@@ -554,6 +731,8 @@ static struct ion_handle *__ion_alloc(struct ion_client *client, size_t len,
 		return ERR_CAST(buffer);
 	}
 
+	ion_buffer_set_owner(buffer);
+create_handle:
 	handle = ion_handle_create(client, buffer);
 
 	/*
@@ -655,6 +834,33 @@ int ion_phys(struct ion_client *client, struct ion_handle *handle,
 }
 EXPORT_SYMBOL(ion_phys);
 
+static atomic_long_t ion_clean_stats[ION_CLEAN_NR_STATS];
+
+void ion_clean_stat_inc(enum ion_clean_stat stat)
+{
+	atomic_long_inc(&ion_clean_stats[stat]);
+}
+
+void ion_buffer_mark_clean(struct ion_buffer *buffer)
+{
+	if (buffer->kmap_cnt ||
+	    (buffer->private_flags & ION_PRIV_FLAG_USER_MAPPED) ||
+	    (buffer->private_flags & ION_PRIV_FLAG_CPU_CLEAN))
+		return;
+
+	buffer->private_flags |= ION_PRIV_FLAG_CPU_CLEAN;
+	ion_clean_stat_inc(ION_CLEAN_MARKED);
+}
+
+static void ion_buffer_mark_dirty(struct ion_buffer *buffer)
+{
+	if (!(buffer->private_flags & ION_PRIV_FLAG_CPU_CLEAN))
+		return;
+
+	buffer->private_flags &= ~ION_PRIV_FLAG_CPU_CLEAN;
+	ion_clean_stat_inc(ION_CLEAN_DIRTIED);
+}
+
 static void *ion_buffer_kmap_get(struct ion_buffer *buffer)
 {
 	void *vaddr;
@@ -671,6 +877,7 @@ static void *ion_buffer_kmap_get(struct ion_buffer *buffer)
 		return vaddr;
 	buffer->vaddr = vaddr;
 	buffer->kmap_cnt++;
+	ion_buffer_mark_dirty(buffer);
 	return vaddr;
 }
 
@@ -1263,6 +1470,10 @@ static int ion_mmap(struct dma_buf *dmabuf, struct vm_area_struct *vma)
 		vma->vm_page_prot = pgprot_writecombine(vma->vm_page_prot);
 
 	mutex_lock(&buffer->lock);
+	if (buffer->flags & ION_FLAG_CACHED) {
+		buffer->private_flags |= ION_PRIV_FLAG_USER_MAPPED;
+		ion_buffer_mark_dirty(buffer);
+	}
 	/* now map it to userspace */
 	ret = buffer->heap->ops->map_user(buffer->heap, buffer, vma);
 	mutex_unlock(&buffer->lock);
@@ -1293,6 +1504,23 @@ static void ion_dma_buf_kunmap(struct dma_buf *dmabuf, unsigned long offset,
 {
 }
 
+/*
+ * Cache maintenance for CPU access from the kernel is done on the kernel
+ * mapping and limited to the range the caller touches, so that software
+ * processing a stripe of a large frame doesn't pay for the whole buffer.
+ */
+static bool ion_buffer_cpu_range(struct ion_buffer *buffer, size_t *start,
+				 size_t *len)
+{
+	if (!(buffer->flags & ION_FLAG_CACHED) ||
+	    get_secure_vmid(buffer->flags) > 0)
+		return false;
+	if (*start >= buffer->size)
+		return false;
+	*len = min(*len, buffer->size - *start);
+	return *len != 0;
+}
+
 static int ion_dma_buf_begin_cpu_access(struct dma_buf *dmabuf, size_t start,
 					size_t len,
 					enum dma_data_direction direction)
@@ -1308,6 +1536,10 @@ static int ion_dma_buf_begin_cpu_access(struct dma_buf *dmabuf, size_t start,
 
 	mutex_lock(&buffer->lock);
 	vaddr = ion_buffer_kmap_get(buffer);
+	/* the device may have written the range, drop stale lines */
+	if (!IS_ERR(vaddr) && direction != DMA_TO_DEVICE &&
+	    ion_buffer_cpu_range(buffer, &start, &len))
+		dmac_inv_range(vaddr + start, vaddr + start + len);
 	mutex_unlock(&buffer->lock);
 	return PTR_ERR_OR_ZERO(vaddr);
 }
@@ -1317,9 +1549,17 @@ static void ion_dma_buf_end_cpu_access(struct dma_buf *dmabuf, size_t start,
 				       enum dma_data_direction direction)
 {
 	struct ion_buffer *buffer = dmabuf->priv;
+	bool whole = !start && len >= buffer->size;
 
 	mutex_lock(&buffer->lock);
+	/* a CPU that only read left nothing to write back */
+	if (direction != DMA_FROM_DEVICE &&
+	    ion_buffer_cpu_range(buffer, &start, &len))
+		dmac_clean_range(buffer->vaddr + start,
+				 buffer->vaddr + start + len);
 	ion_buffer_kmap_put(buffer);
+	if (whole && direction != DMA_FROM_DEVICE)
+		ion_buffer_mark_clean(buffer);
 	mutex_unlock(&buffer->lock);
 }
 
@@ -1870,6 +2110,31 @@ static int ion_debug_heap_show(struct seq_file *s, void *unused)
 	return 0;
 }
 
+static int ion_debug_cache_clean_show(struct seq_file *s, void *unused)
+{
+	seq_printf(s, "%16s %lu\n", "marked",
+		   atomic_long_read(&ion_clean_stats[ION_CLEAN_MARKED]));
+	seq_printf(s, "%16s %lu\n", "dirtied",
+		   atomic_long_read(&ion_clean_stats[ION_CLEAN_DIRTIED]));
+	seq_printf(s, "%16s %lu\n", "cleaned",
+		   atomic_long_read(&ion_clean_stats[ION_CLEAN_DONE]));
+	seq_printf(s, "%16s %lu\n", "clean skipped",
+		   atomic_long_read(&ion_clean_stats[ION_CLEAN_SKIPPED]));
+	return 0;
+}
+
+static int ion_debug_cache_clean_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, ion_debug_cache_clean_show, inode->i_private);
+}
+
+static const struct file_operations debug_cache_clean_fops = {
+	.open = ion_debug_cache_clean_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
 static int ion_debug_heap_open(struct inode *inode, struct file *file)
 {
 	return single_open(file, ion_debug_heap_show, inode->i_private);
@@ -2064,6 +2329,9 @@ struct ion_device *ion_device_create(long (*custom_ioctl)
 						idev->debug_root);
 	if (!idev->clients_debug_root)
 		pr_err("ion: failed to create debugfs clients directory.\n");
+	if (!debugfs_create_file("cache_clean", 0444, idev->debug_root, idev,
+				 &debug_cache_clean_fops))
+		pr_err("ion: failed to create debugfs cache_clean file.\n");
 
 debugfs_done:
 
@@ -2075,6 +2343,7 @@ debugfs_done:
 	idev->clients = RB_ROOT;
 	ion_root_client = &idev->clients;
 	mutex_init(&debugfs_mutex);
+	ion_recycle_init(idev);
 	return idev;
 }
 EXPORT_SYMBOL(ion_device_create);
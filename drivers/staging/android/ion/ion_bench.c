@@ -0,0 +1,225 @@
+/*
+ * ION system heap allocation benchmark
+ *
+ * Reading /sys/kernel/debug/ion_bench/run allocates and frees buffers of
+ * each size from a number of threads at once and reports throughput and
+ * latency percentiles per size, so that allocator changes can be compared
+ * across kernel builds with the same settings.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 and
+ * only version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#define pr_fmt(fmt) "ion-bench: " fmt
+
+#include <linux/completion.h>
+#include <linux/debugfs.h>
+#include <linux/err.h>
+#include <linux/kthread.h>
+#include <linux/ktime.h>
+#include <linux/module.h>
+#include <linux/msm_ion.h>
+#include <linux/mutex.h>
+#include <linux/seq_file.h>
+#include <linux/slab.h>
+#include <linux/sort.h>
+#include <linux/vmalloc.h>
+
+#include "ion.h"
+
+#define ION_BENCH_MAX_THREADS	16
+
+/* buffer sizes, as page orders, covering every system heap pool */
+static const unsigned int ion_bench_orders[] = {0, 4, 8, 9};
+
+static u32 ion_bench_threads = 4;
+static u32 ion_bench_iterations = 256;
+static DEFINE_MUTEX(ion_bench_lock);
+static struct dentry *ion_bench_dir;
+
+struct ion_bench_worker {
+	struct task_struct *task;
+	struct completion done;
+	size_t len;
+	u32 iterations;
+	u64 *lat_ns;
+	u32 nr_ok;
+	u32 nr_failed;
+};
+
+static int ion_bench_thread(void *data)
+{
+	struct ion_bench_worker *w = data;
+	struct ion_client *client;
+	struct ion_handle *handle;
+	u64 start;
+	u32 i;
+
+	client = msm_ion_client_create("ion_bench");
+	if (IS_ERR_OR_NULL(client)) {
+		w->nr_failed = w->iterations;
+		goto out;
+	}
+
+	for (i = 0; i < w->iterations; i++) {
+		start = ktime_get_ns();
+		handle = ion_alloc(client, w->len, PAGE_SIZE,
+				   ION_HEAP(ION_SYSTEM_HEAP_ID), 0);
+		if (IS_ERR_OR_NULL(handle)) {
+			w->nr_failed++;
+			continue;
+		}
+		ion_free(client, handle);
+		w->lat_ns[w->nr_ok++] = ktime_get_ns() - start;
+		cond_resched();
+	}
+
+	ion_client_destroy(client);
+out:
+	complete(&w->done);
+	return 0;
+}
+
+static int ion_bench_cmp(const void *a, const void *b)
+{
+	u64 x = *(const u64 *)a, y = *(const u64 *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+static void ion_bench_run_order(struct seq_file *m, unsigned int order,
+				struct ion_bench_worker *workers, u32 nr_threads,
+				u64 *lat_ns)
+{
+	u32 iterations = ion_bench_iterations;
+	u32 nr_ok = 0, nr_failed = 0;
+	u64 start, elapsed_ns;
+	u32 i;
+
+	for (i = 0; i < nr_threads; i++) {
+		struct ion_bench_worker *w = &workers[i];
+
+		init_completion(&w->done);
+		w->len = PAGE_SIZE << order;
+		w->iterations = iterations;
+		w->lat_ns = lat_ns + (size_t)i * iterations;
+		w->nr_ok = 0;
+		w->nr_failed = 0;
+		w->task = kthread_create(ion_bench_thread, w, "ion_bench/%u",
+					 i);
+		if (IS_ERR(w->task)) {
+			w->task = NULL;
+			w->nr_failed = iterations;
+			complete(&w->done);
+		}
+	}
+
+	start = ktime_get_ns();
+	for (i = 0; i < nr_threads; i++)
+		if (workers[i].task)
+			wake_up_process(workers[i].task);
+	for (i = 0; i < nr_threads; i++)
+		wait_for_completion(&workers[i].done);
+	elapsed_ns = ktime_get_ns() - start;
+
+	/* pack the successful samples of every thread together */
+	for (i = 0; i < nr_threads; i++) {
+		memmove(lat_ns + nr_ok, workers[i].lat_ns,
+			workers[i].nr_ok * sizeof(*lat_ns));
+		nr_ok += workers[i].nr_ok;
+		nr_failed += workers[i].nr_failed;
+	}
+
+	seq_printf(m, "%5u %7lu %7u %7u", order, PAGE_SIZE << order, nr_ok,
+		   nr_failed);
+	if (!nr_ok) {
+		seq_puts(m, "\n");
+		return;
+	}
+
+	sort(lat_ns, nr_ok, sizeof(*lat_ns), ion_bench_cmp, NULL);
+	seq_printf(m, " %9llu %9llu %9llu %9llu\n",
+		   div64_u64((u64)nr_ok * NSEC_PER_SEC, elapsed_ns ?: 1),
+		   lat_ns[nr_ok / 2], lat_ns[(u64)nr_ok * 99 / 100],
+		   lat_ns[nr_ok - 1]);
+}
+
+static int ion_bench_run_show(struct seq_file *m, void *unused)
+{
+	struct ion_bench_worker *workers;
+	u32 nr_threads;
+	u64 *lat_ns;
+	int i;
+
+	mutex_lock(&ion_bench_lock);
+
+	nr_threads = clamp_t(u32, ion_bench_threads, 1, ION_BENCH_MAX_THREADS);
+	if (!ion_bench_iterations) {
+		mutex_unlock(&ion_bench_lock);
+		return -EINVAL;
+	}
+
+	workers = kcalloc(nr_threads, sizeof(*workers), GFP_KERNEL);
+	lat_ns = vmalloc((size_t)nr_threads * ion_bench_iterations *
+			 sizeof(*lat_ns));
+	if (!workers || !lat_ns) {
+		kfree(workers);
+		vfree(lat_ns);
+		mutex_unlock(&ion_bench_lock);
+		return -ENOMEM;
+	}
+
+	seq_printf(m, "threads %u iterations %u\n", nr_threads,
+		   ion_bench_iterations);
+	seq_puts(m, "order    size      ok  failed     ops/s   p50(ns)   p99(ns)   max(ns)\n");
+	for (i = 0; i < ARRAY_SIZE(ion_bench_orders); i++)
+		ion_bench_run_order(m, ion_bench_orders[i], workers,
+				    nr_threads, lat_ns);
+
+	vfree(lat_ns);
+	kfree(workers);
+	mutex_unlock(&ion_bench_lock);
+	return 0;
+}
+
+static int ion_bench_run_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, ion_bench_run_show, NULL);
+}
+
+static const struct file_operations ion_bench_run_fops = {
+	.open = ion_bench_run_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+static int __init ion_bench_init(void)
+{
+	ion_bench_dir = debugfs_create_dir("ion_bench", NULL);
+	if (IS_ERR_OR_NULL(ion_bench_dir))
+		return -ENODEV;
+
+	debugfs_create_u32("threads", 0644, ion_bench_dir, &ion_bench_threads);
+	debugfs_create_u32("iterations", 0644, ion_bench_dir,
+			   &ion_bench_iterations);
+	debugfs_create_file("run", 0400, ion_bench_dir, NULL,
+			    &ion_bench_run_fops);
+	return 0;
+}
+
+static void __exit ion_bench_exit(void)
+{
+	debugfs_remove_recursive(ion_bench_dir);
+}
+
+module_init(ion_bench_init);
+module_exit(ion_bench_exit);
+MODULE_DESCRIPTION("ION system heap allocation benchmark");
+MODULE_LICENSE("GPL v2");
@@ -192,6 +192,37 @@ int ion_page_pool_total(struct ion_page_pool *pool, bool high)
 	return count << pool->order;
 }
 
+/*
+ * Add zeroed pages to the pool until it holds @nr_pages order-0 pages.
+ * The allocations never enter reclaim, so this stops as soon as free
+ * memory gets tight. Returns the number of order-0 pages added.
+ */
+int ion_page_pool_refill(struct ion_page_pool *pool, int nr_pages)
+{
+	gfp_t gfp_mask = (pool->gfp_mask | __GFP_NOWARN | __GFP_NORETRY) &
+			 ~(__GFP_RECLAIM | __GFP_ZERO);
+	struct page *page;
+	int added = 0;
+
+	while (ion_page_pool_total(pool, true) < nr_pages) {
+		page = alloc_pages(gfp_mask, pool->order);
+		if (!page)
+			break;
+
+		if (msm_ion_heap_high_order_page_zero(pool->dev, page,
+						      pool->order)) {
+			__free_pages(page, pool->order);
+			break;
+		}
+
+		ion_page_pool_alloc_set_cache_policy(pool, page);
+		ion_page_pool_add(pool, page);
+		added += 1 << pool->order;
+	}
+
+	return added;
+}
+
 int ion_page_pool_shrink(struct ion_page_pool *pool, gfp_t gfp_mask,
 				int nr_to_scan)
 {
@@ -69,6 +69,8 @@ struct ion_buffer *ion_handle_buffer(struct ion_handle *handle);
  *			handle, used for debugging
  * @pid:		pid of last client to reference this buffer in a
  *			handle, used for debugging
+ * @owner:		process that allocated the buffer, the only one it
+ *			may be recycled to
 */
 struct ion_buffer {
 	struct kref ref;
@@ -95,6 +97,9 @@ struct ion_buffer {
 	int handle_count;
 	char task_comm[TASK_COMM_LEN];
 	pid_t pid;
+#ifdef CONFIG_ION_BUFFER_RECYCLE
+	struct pid *owner;
+#endif
 };
 void ion_buffer_destroy(struct ion_buffer *buffer);
 
@@ -106,6 +111,11 @@ void ion_buffer_destroy(struct ion_buffer *buffer);
  * @lock:		rwsem protecting the tree of heaps and clients
  * @heaps:		list of all the heaps in the system
  * @user_clients:	list of all the clients created from userspace
+ * @recycle_list:	freed buffers kept for reuse, most recent first
+ * @recycle_lock:	protects @recycle_list and @recycle_count
+ * @recycle_count:	number of buffers on @recycle_list
+ * @recycle_size:	total size of the buffers on @recycle_list
+ * @recycle_shrinker:	drops recycled buffers under memory pressure
  */
 struct ion_device {
 	struct miscdevice dev;
@@ -119,6 +129,13 @@ struct ion_device {
 	struct dentry *debug_root;
 	struct dentry *heaps_debug_root;
 	struct dentry *clients_debug_root;
+#ifdef CONFIG_ION_BUFFER_RECYCLE
+	struct list_head recycle_list;
+	struct mutex recycle_lock;
+	int recycle_count;
+	atomic_long_t recycle_size;
+	struct shrinker recycle_shrinker;
+#endif
 };
 
 /**
@@ -233,6 +250,30 @@ struct ion_heap_ops {
  */
 #define ION_PRIV_FLAG_SHRINKER_FREE (1 << 0)
 
+/*
+ * The CPU caches hold no dirty lines of the buffer, a clean of it can be
+ * skipped. Only set while nothing maps the buffer for the CPU to write.
+ */
+#define ION_PRIV_FLAG_CPU_CLEAN (1 << 1)
+
+/*
+ * The buffer has been mapped cached to userspace. Writes through such a
+ * mapping can't be seen, so the buffer is never known clean again.
+ */
+#define ION_PRIV_FLAG_USER_MAPPED (1 << 2)
+
+/*
+ * Dirty-state accounting for ION_PRIV_FLAG_CPU_CLEAN, reported in
+ * <debugfs>/ion/cache_clean so the clean skip can be checked
+ */
+enum ion_clean_stat {
+	ION_CLEAN_MARKED,	/* buffer became known clean */
+	ION_CLEAN_DIRTIED,	/* known clean buffer mapped for CPU writes */
+	ION_CLEAN_DONE,		/* clean requests that walked the buffer */
+	ION_CLEAN_SKIPPED,	/* clean requests skipped, buffer known clean */
+	ION_CLEAN_NR_STATS,
+};
+
 /**
  * struct ion_heap - represents a heap in the system
  * @node:		rb node to put the heap on the device's tree of heaps
@@ -526,6 +567,7 @@ void *ion_page_pool_alloc_pool_only(struct ion_page_pool *);
 void ion_page_pool_free(struct ion_page_pool *, struct page *);
 void ion_page_pool_free_immediate(struct ion_page_pool *, struct page *);
 int ion_page_pool_total(struct ion_page_pool *pool, bool high);
+int ion_page_pool_refill(struct ion_page_pool *pool, int nr_pages);
 size_t ion_system_heap_secure_page_pool_total(struct ion_heap *heap, int vmid);
 
 #ifdef CONFIG_ION_POOL_CACHE_POLICY
@@ -588,4 +630,15 @@ struct ion_handle *ion_handle_get_by_id_nolock(struct ion_client *client,
 
 int ion_handle_put(struct ion_handle *handle);
 
+void ion_clean_stat_inc(enum ion_clean_stat stat);
+
+/**
+ * ion_buffer_mark_clean - record that the CPU caches hold no dirty lines
+ * @buffer:		buffer that was just cleaned or flushed as a whole
+ *
+ * Does nothing while the buffer is mapped for the CPU to write. Must be
+ * called with buffer->lock held.
+ */
+void ion_buffer_mark_clean(struct ion_buffer *buffer);
+
 #endif /* _ION_PRIV_H */
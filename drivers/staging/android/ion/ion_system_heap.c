@@ -18,8 +18,11 @@
 #include <asm/page.h>
 #include <linux/dma-mapping.h>
 #include <linux/err.h>
+#include <linux/freezer.h>
 #include <linux/highmem.h>
+#include <linux/kthread.h>
 #include <linux/mm.h>
+#include <linux/module.h>
 #include <linux/msm_ion.h>
 #include <linux/scatterlist.h>
 #include <linux/seq_file.h>
@@ -47,6 +50,17 @@ static const unsigned int orders[] = {0};
 #endif
 
 static const int num_orders = ARRAY_SIZE(orders);
+
+#ifdef CONFIG_ION_POOL_AUTO_REFILL
+/* Per pool order refill target, 0 stops refilling */
+static int pool_refill_kb = CONFIG_ION_POOL_AUTO_REFILL_KB;
+module_param(pool_refill_kb, int, S_IRUGO | S_IWUSR);
+
+/* How long the refill thread stays away after the pools were shrunk */
+static int pool_refill_backoff_ms = 1000;
+module_param(pool_refill_backoff_ms, int, S_IRUGO | S_IWUSR);
+#endif
+
 static int order_to_index(unsigned int order)
 {
 	int i;
@@ -69,6 +83,13 @@ struct ion_system_heap {
 	struct ion_page_pool **secure_pools[VMID_LAST];
 	/* Prevents unnecessary page splitting */
 	struct mutex split_page_mutex;
+#ifdef CONFIG_ION_POOL_AUTO_REFILL
+	struct task_struct *refill_task;
+	wait_queue_head_t refill_wait;
+	bool refill_pending;
+	/* jiffies until which the shrinker has priority over refilling */
+	unsigned long refill_resume;
+#endif
 };
 
 struct page_info {
@@ -331,6 +352,112 @@ static unsigned int process_info(struct page_info *info,
 	return i;
 }
 
+#ifdef CONFIG_ION_POOL_AUTO_REFILL
+static int ion_system_heap_refill_target(void)
+{
+	return max(pool_refill_kb, 0) >> (PAGE_SHIFT - 10);
+}
+
+static bool ion_system_heap_refill_backoff(struct ion_system_heap *sys_heap)
+{
+	return time_before(jiffies, READ_ONCE(sys_heap->refill_resume));
+}
+
+/*
+ * Kick the refill thread once any non-secure pool is below half of its
+ * target. Secure pools are left alone since their pages have to be
+ * assigned to a VM first.
+ */
+static void ion_system_heap_refill_kick(struct ion_system_heap *sys_heap)
+{
+	int low = ion_system_heap_refill_target() / 2;
+	int i;
+
+	if (!sys_heap->refill_task || !low ||
+	    ion_system_heap_refill_backoff(sys_heap))
+		return;
+
+	for (i = 0; i < num_orders; i++) {
+		if (ion_page_pool_total(sys_heap->uncached_pools[i], true) <
+		    low ||
+		    ion_page_pool_total(sys_heap->cached_pools[i], true) < low)
+			break;
+	}
+	if (i == num_orders)
+		return;
+
+	WRITE_ONCE(sys_heap->refill_pending, true);
+	wake_up(&sys_heap->refill_wait);
+}
+
+static int ion_system_heap_refill(void *data)
+{
+	struct ion_system_heap *sys_heap = data;
+	int i, target;
+
+	set_freezable();
+	while (!kthread_should_stop()) {
+		wait_event_freezable(sys_heap->refill_wait,
+				     READ_ONCE(sys_heap->refill_pending) ||
+				     kthread_should_stop());
+		WRITE_ONCE(sys_heap->refill_pending, false);
+
+		/* Fill the small orders first, they are the cheapest */
+		for (i = num_orders - 1; i >= 0; i--) {
+			target = ion_system_heap_refill_target();
+			if (ion_system_heap_refill_backoff(sys_heap) ||
+			    kthread_should_stop())
+				break;
+
+			ion_page_pool_refill(sys_heap->uncached_pools[i],
+					     target);
+			ion_page_pool_refill(sys_heap->cached_pools[i],
+					     target);
+			cond_resched();
+		}
+	}
+
+	return 0;
+}
+
+static void ion_system_heap_refill_init(struct ion_system_heap *sys_heap)
+{
+	struct sched_param param = { .sched_priority = 0 };
+
+	init_waitqueue_head(&sys_heap->refill_wait);
+	sys_heap->refill_task = kthread_run(ion_system_heap_refill, sys_heap,
+					    "ion_pool_refill");
+	if (IS_ERR(sys_heap->refill_task)) {
+		pr_err("%s: creating thread for pool refill failed\n",
+		       __func__);
+		sys_heap->refill_task = NULL;
+		return;
+	}
+	sched_setscheduler(sys_heap->refill_task, SCHED_IDLE, &param);
+}
+
+static void ion_system_heap_refill_stop(struct ion_system_heap *sys_heap)
+{
+	if (sys_heap->refill_task)
+		kthread_stop(sys_heap->refill_task);
+}
+
+static void ion_system_heap_refill_shrunk(struct ion_system_heap *sys_heap)
+{
+	WRITE_ONCE(sys_heap->refill_resume, jiffies +
+		   msecs_to_jiffies(max(pool_refill_backoff_ms, 0)));
+}
+#else
+static inline void ion_system_heap_refill_kick(
+		struct ion_system_heap *sys_heap) {}
+static inline void ion_system_heap_refill_init(
+		struct ion_system_heap *sys_heap) {}
+static inline void ion_system_heap_refill_stop(
+		struct ion_system_heap *sys_heap) {}
+static inline void ion_system_heap_refill_shrunk(
+		struct ion_system_heap *sys_heap) {}
+#endif
+
 static int ion_system_heap_allocate(struct ion_heap *heap,
 				     struct ion_buffer *buffer,
 				     unsigned long size, unsigned long align,
@@ -466,6 +593,8 @@ static int ion_system_heap_allocate(struct ion_heap *heap,
 	if (nents_sync)
 		sg_free_table(&table_sync);
 	msm_ion_heap_free_pages_mem(&data);
+	if (vmid <= 0)
+		ion_system_heap_refill_kick(sys_heap);
 	return 0;
 
 err_free_sg2:
@@ -614,6 +743,8 @@ static int ion_system_heap_shrink(struct ion_heap *heap, gfp_t gfp_mask,
 
 	if (!nr_to_scan)
 		only_scan = 1;
+	else
+		ion_system_heap_refill_shrunk(sys_heap);
 
 	for (i = 0; i < num_orders; i++) {
 		nr_freed = 0;
@@ -834,6 +965,7 @@ struct ion_heap *ion_system_heap_create(struct ion_platform_heap *data)
 		goto err_create_cached_pools;
 
 	mutex_init(&heap->split_page_mutex);
+	ion_system_heap_refill_init(heap);
 
 	heap->heap.debug_show = ion_system_heap_debug_show;
 	return &heap->heap;
@@ -863,6 +995,8 @@ void ion_system_heap_destroy(struct ion_heap *heap)
 							heap);
 	int i, j;
 
+	ion_system_heap_refill_stop(sys_heap);
+
 	for (i = 0; i < VMID_LAST; i++) {
 		if (!is_secure_vmid_valid(i))
 			continue;
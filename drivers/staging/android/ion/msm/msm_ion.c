@@ -344,6 +344,8 @@ int ion_do_cache_op(struct ion_client *client, struct ion_handle *handle,
 	unsigned long flags;
 	struct sg_table *table;
 	struct page *page;
+	struct ion_buffer *buffer;
+	bool whole;
 
 	ret = ion_handle_get_flags(client, handle, &flags);
 	if (ret)
@@ -360,6 +362,18 @@ int ion_do_cache_op(struct ion_client *client, struct ion_handle *handle,
 	if (IS_ERR_OR_NULL(table))
 		return PTR_ERR(table);
 
+	/*
+	 * Nothing can have dirtied a buffer that is known clean, clients
+	 * cleaning every buffer before handing it to hardware skip the walk.
+	 */
+	buffer = ion_handle_buffer(handle);
+	if (cmd == ION_IOC_CLEAN_CACHES &&
+	    (READ_ONCE(buffer->private_flags) & ION_PRIV_FLAG_CPU_CLEAN)) {
+		ion_clean_stat_inc(ION_CLEAN_SKIPPED);
+		return 0;
+	}
+	whole = !offset && len >= buffer->size;
+
 	page = sg_page(table->sgl);
 
 	if (page)
@@ -369,6 +383,15 @@ int ion_do_cache_op(struct ion_client *client, struct ion_handle *handle,
 		ret = ion_no_pages_cache_ops(client, handle, uaddr,
 					offset, len, cmd);
 
+	if (!ret && cmd == ION_IOC_CLEAN_CACHES)
+		ion_clean_stat_inc(ION_CLEAN_DONE);
+
+	if (!ret && whole && cmd != ION_IOC_INV_CACHES) {
+		mutex_lock(&buffer->lock);
+		ion_buffer_mark_clean(buffer);
+		mutex_unlock(&buffer->lock);
+	}
+
 	return ret;
 
 }
@@ -12,6 +12,10 @@
 #include <linux/oom.h>
 #include <linux/sched.h>
 #include <linux/simple_lmk.h>
+#include <linux/vmpressure.h>
+
+#define CREATE_TRACE_POINTS
+#include <trace/events/simple_lmk.h>
 
 /* Duration to boost CPU and DDR bus to the max per memory reclaim event */
 #define BOOST_DURATION_MS (250)
@@ -19,9 +23,13 @@
 static unsigned short slmk_minfree = CONFIG_ANDROID_SIMPLE_LMK_MINFREE;
 static unsigned short slmk_kswapd_timeout = CONFIG_ANDROID_SIMPLE_LMK_KSWAPD_TIMEOUT;
 static unsigned short slmk_oom_timeout = CONFIG_ANDROID_SIMPLE_LMK_OOM_TIMEOUT;
+static unsigned short slmk_stall_window = CONFIG_ANDROID_SIMPLE_LMK_STALL_WINDOW;
+static unsigned short slmk_stall_budget = CONFIG_ANDROID_SIMPLE_LMK_STALL_BUDGET;
 module_param(slmk_minfree, short, 0644);
 module_param(slmk_kswapd_timeout, short, 0644);
 module_param(slmk_oom_timeout, short, 0644);
+module_param(slmk_stall_window, short, 0644);
+module_param(slmk_stall_budget, short, 0644);
 
 #define MIN_FREE_PAGES (slmk_minfree * SZ_1M / PAGE_SIZE)
 
@@ -58,6 +66,23 @@ static struct workqueue_struct *simple_lmk_wq;
 static unsigned long last_reclaim_jiffies;
 static atomic_t simple_lmk_state = ATOMIC_INIT(DISABLED);
 
+/*
+ * Samples of the vmpressure stall counters, taken on every kswapd reclaim
+ * tick. With the default tick this covers 1.6 s; longer windows are
+ * clamped to the oldest sample. Protected by reclaim_lock.
+ */
+#define STALL_SAMPLES (16)
+struct stall_sample {
+	unsigned long time;
+	unsigned long stall;
+	unsigned long scanned;
+};
+static struct stall_sample stall_samples[STALL_SAMPLES];
+static unsigned int stall_head, stall_count;
+/* Sample taken when kswapd woke up, published through stall_reset */
+static struct stall_sample stall_base;
+static atomic_t stall_reset = ATOMIC_INIT(0);
+
 #define simple_lmk_is_ready() (atomic_read(&simple_lmk_state) == READY)
 
 static unsigned long scan_and_kill(int min_adj, int max_adj,
@@ -110,6 +135,8 @@ static unsigned long scan_and_kill(int min_adj, int max_adj,
 
 		victim->lmk_sigkill_sent = true;
 		sched_setscheduler_nocheck(victim, SCHED_FIFO, &param);
+		trace_simple_lmk_kill(victim->pid, victim->comm, oom_score_adj,
+				      tasksize);
 		put_task_struct(victim);
 
 		pages_freed += tasksize;
@@ -140,13 +167,74 @@ static unsigned long do_lmk_reclaim(unsigned long pages_needed)
 	return pages_freed * PAGE_SIZE / SZ_1M;
 }
 
+static void stall_sample_now(struct stall_sample *sample)
+{
+	sample->time = jiffies;
+	vmpressure_stall_read(&sample->stall, &sample->scanned);
+}
+
+/*
+ * Record a new stall sample and return the share, in percent, of the
+ * pages scanned since the oldest sample still inside the window that were
+ * scanned by direct reclaim. The length of the span actually covered is
+ * returned through @span.
+ */
+static unsigned int stall_in_window(unsigned long *span)
+{
+	struct stall_sample cur, base;
+	unsigned long start, scanned;
+	unsigned int i;
+
+	stall_sample_now(&cur);
+	start = cur.time - msecs_to_jiffies(slmk_stall_window);
+	base = cur;
+
+	if (atomic_xchg(&stall_reset, 0)) {
+		stall_samples[0] = stall_base;
+		stall_head = 1;
+		stall_count = 1;
+	}
+
+	for (i = 0; i < stall_count; i++) {
+		unsigned int idx = (stall_head + STALL_SAMPLES - stall_count + i) %
+				   STALL_SAMPLES;
+
+		if (time_after_eq(stall_samples[idx].time, start)) {
+			base = stall_samples[idx];
+			break;
+		}
+	}
+
+	stall_samples[stall_head] = cur;
+	stall_head = (stall_head + 1) % STALL_SAMPLES;
+	if (stall_count < STALL_SAMPLES)
+		stall_count++;
+
+	*span = cur.time - base.time;
+	scanned = cur.scanned - base.scanned;
+	if (!scanned)
+		return 0;
+
+	return div64_u64((u64)(cur.stall - base.stall) * 100, scanned);
+}
+
 static void simple_lmk_reclaim_work(struct work_struct *work)
 {
-	unsigned long mib_freed = 0;
+	unsigned long mib_freed = 0, span;
+	unsigned int stall_pct;
+	bool kill;
 
 	mutex_lock(&reclaim_lock);
-	if (time_after_eq(jiffies, last_reclaim_jiffies + KSWAPD_LMK_EXPIRES))
-		mib_freed = do_lmk_reclaim(MIN_FREE_PAGES);
+	stall_pct = stall_in_window(&span);
+	if (time_after_eq(jiffies, last_reclaim_jiffies + KSWAPD_LMK_EXPIRES)) {
+		/* kswapd alone falling behind is not worth a kill yet */
+		kill = !slmk_stall_budget || stall_pct >= slmk_stall_budget;
+		trace_simple_lmk_decision(false, stall_pct,
+					  jiffies_to_msecs(span),
+					  slmk_stall_budget, kill);
+		if (kill)
+			mib_freed = do_lmk_reclaim(MIN_FREE_PAGES);
+	}
 	mutex_unlock(&reclaim_lock);
 
 	if (mib_freed)
@@ -166,8 +254,14 @@ void simple_lmk_one_reclaim(void)
 	if (!mutex_trylock(&reclaim_lock))
 		return;
 
-	if (time_after_eq(jiffies, last_reclaim_jiffies + OOM_LMK_EXPIRES))
+	/*
+	 * An allocation has failed outright and is waiting for memory, so
+	 * the stall budget doesn't apply here.
+	 */
+	if (time_after_eq(jiffies, last_reclaim_jiffies + OOM_LMK_EXPIRES)) {
+		trace_simple_lmk_decision(true, 0, 0, slmk_stall_budget, true);
 		mib_freed = do_lmk_reclaim(MIN_FREE_PAGES);
+	}
 	mutex_unlock(&reclaim_lock);
 
 	if (mib_freed)
@@ -179,6 +273,10 @@ void simple_lmk_start_reclaim(void)
 	if (!simple_lmk_is_ready())
 		return;
 
+	/* Stall history from before kswapd last slept is stale */
+	stall_sample_now(&stall_base);
+	smp_wmb();
+	atomic_set(&stall_reset, 1);
 	queue_delayed_work(simple_lmk_wq, &reclaim_work, KSWAPD_LMK_EXPIRES);
 }
 
@@ -112,10 +112,18 @@ void sync_timeline_signal(struct sync_timeline *obj)
 
 	spin_lock_irqsave(&obj->child_list_lock, flags);
 
+	/*
+	 * The active list is kept in timeline order and a timeline only
+	 * moves forward, so everything past the first point that hasn't
+	 * signaled hasn't either. Every point up to the new value is
+	 * signaled in one pass under the lock.
+	 */
 	list_for_each_entry_safe(pt, next, &obj->active_list_head,
 				 active_list) {
 		if (fence_is_signaled_locked(&pt->base))
 			list_del_init(&pt->active_list);
+		else if (!obj->destroyed)
+			break;
 	}
 
 	spin_unlock_irqrestore(&obj->child_list_lock, flags);
@@ -251,6 +259,12 @@ static int sync_fence_add_pt(struct sync_fence *fence, int i, struct fence *pt)
 		pt, &fence->cbs[i].cb, fence_check_cb_func) ? 0 : 1;
 }
 
+/* a point that signaled without error adds nothing to a merged fence */
+static bool sync_fence_pt_done(struct fence *pt)
+{
+	return fence_is_signaled(pt) && pt->status >= 0;
+}
+
 struct sync_fence *sync_fence_merge(const char *name,
 				    struct sync_fence *a, struct sync_fence *b)
 {
@@ -272,6 +286,9 @@ struct sync_fence *sync_fence_merge(const char *name,
 	 *
 	 * If a sync_fence can only be created with sync_fence_merge
 	 * and sync_fence_create, this is a reasonable assumption.
+	 *
+	 * Points that already signaled are dropped, so that fences merged
+	 * again every frame don't keep growing with dead points.
 	 */
 	while (i_a < a->num_fences && i_b < b->num_fences) {
 		struct fence *pt_a = a->cbs[i_a].sync_pt;
@@ -280,16 +297,25 @@ struct sync_fence *sync_fence_merge(const char *name,
 			(pt_a->context < pt_b->context) ? pt_a :
 			(pt_a->context > pt_b->context) ? pt_b :
 			fence_is_later(pt_a, pt_b) ? pt_a : pt_b;
-		status += sync_fence_add_pt(fence, i++, pt);
+		if (!sync_fence_pt_done(pt))
+			status += sync_fence_add_pt(fence, i++, pt);
 		i_a += pt->context == pt_a->context ? 1 : 0;
 		i_b += pt->context == pt_b->context ? 1 : 0;
 	}
 
 	for (; i_a < a->num_fences; i_a++)
-		status += sync_fence_add_pt(fence, i++, a->cbs[i_a].sync_pt);
+		if (!sync_fence_pt_done(a->cbs[i_a].sync_pt))
+			status += sync_fence_add_pt(fence, i++,
+						    a->cbs[i_a].sync_pt);
 
 	for (; i_b < b->num_fences; i_b++)
-		status += sync_fence_add_pt(fence, i++, b->cbs[i_b].sync_pt);
+		if (!sync_fence_pt_done(b->cbs[i_b].sync_pt))
+			status += sync_fence_add_pt(fence, i++,
+						    b->cbs[i_b].sync_pt);
+
+	/* keep one point so the fence still reports a timeline */
+	if (!i)
+		status += sync_fence_add_pt(fence, i++, a->cbs[0].sync_pt);
 
 	if (num_fences > status)
 		atomic_sub(num_fences - status, &fence->status);
@@ -448,10 +474,17 @@ static bool android_fence_enable_signaling(struct fence *fence)
 	struct sync_pt *pt = container_of(fence, struct sync_pt, base);
 	struct sync_timeline *parent = sync_pt_parent(pt);
 
+	struct sync_pt *pos;
+
 	if (android_fence_signaled(fence))
 		return false;
 
-	list_add_tail(&pt->active_list, &parent->active_list_head);
+	/* keep the active list in timeline order, usually a tail append */
+	list_for_each_entry_reverse(pos, &parent->active_list_head,
+				    active_list)
+		if (parent->ops->compare(pos, pt) <= 0)
+			break;
+	list_add(&pt->active_list, &pos->active_list);
 	return true;
 }
 
@@ -24,10 +24,20 @@
 
 #define SPI_TIMEOUT		65535
 #define SPI_MIN_DMA		48
+#define NANOHUB_SPI_SPEED_HZ	10000000
 
 static int LEN_PROTECT;
 module_param(LEN_PROTECT, int, 0660);
 MODULE_PARM_DESC(LEN_PROTECT, "nanohub spi length protect") ;
+
+/*
+ * The controller's setup() also programs chip select and pinctrl state,
+ * which is lost when the controller is runtime suspended. Only skip it
+ * on platforms whose SPI controller keeps that state.
+ */
+static bool setup_once;
+module_param(setup_once, bool, 0660);
+MODULE_PARM_DESC(setup_once, "skip spi_setup while the comms settings are unchanged");
 static uint32_t print_count;
 
 struct nanohub_spi_data {
@@ -433,10 +443,24 @@ static int nanohub_spi_open(void *data)
 
 	down(&spi_data->spi_sem);
 	spi_bus_lock(spi_data->device->master);
-	spi_data->device->max_speed_hz = 10000000;
-	spi_data->device->mode = SPI_MODE_0;
-	spi_data->device->bits_per_word = 8;
-	ret = spi_setup(spi_data->device);
+	/*
+	 * Every event read opens the bus. With setup_once, only redo the
+	 * controller setup when the bootloader has left the device at its
+	 * own speed.
+	 */
+	ret = 0;
+	if (!setup_once ||
+	    spi_data->device->max_speed_hz != NANOHUB_SPI_SPEED_HZ ||
+	    spi_data->device->mode != SPI_MODE_0 ||
+	    spi_data->device->bits_per_word != 8) {
+		spi_data->device->max_speed_hz = NANOHUB_SPI_SPEED_HZ;
+		spi_data->device->mode = SPI_MODE_0;
+		spi_data->device->bits_per_word = 8;
+		ret = spi_setup(spi_data->device);
+		/* make the next open retry */
+		if (ret)
+			spi_data->device->max_speed_hz = 0;
+	}
 	if (!ret) {
 		udelay(40);
 		gpio_set_value(spi_data->cs, 0);
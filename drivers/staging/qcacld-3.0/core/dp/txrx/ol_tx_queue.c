@@ -1009,6 +1009,7 @@ ol_txrx_peer_link_status_handler(
 			u_int32_t thresh, limit, phy;
 
 			phy = peer_link_status->phy;
+			peer->tx_rate = peer_tput;
 			thresh = pdev->tx_peer_bal.ctl_thresh[phy].tput_thresh;
 			limit = pdev->tx_peer_bal.ctl_thresh[phy].tx_limit;
 
@@ -39,6 +39,7 @@
 #include <ol_txrx.h>
 #include <qdf_types.h>
 #include <qdf_mem.h>         /* qdf_os_mem_alloc_consistent et al */
+#include <qdf_util.h>        /* qdf_do_div */
 
 #if defined(CONFIG_HL_SUPPORT)
 
@@ -740,6 +741,158 @@ ol_tx_sched_wrr_adv_credit_sanity_check(struct ol_txrx_pdev_t *pdev,
 	qdf_assert(okay);
 }
 
+#ifdef QCA_BAD_PEER_TX_FLOW_CL
+/*
+ * Airtime fairness
+ *
+ * When the target reports the tx rate of each peer, the tx queues of a
+ * category are served by deficit round robin over airtime rather than
+ * over frames: a queue downloads only while it has airtime credit left,
+ * and is charged the time its frames take at the peer's rate. A slow
+ * peer thus gets as much of the medium as a fast one, instead of the
+ * same number of frames, which would let it hold the channel for most
+ * of the time.
+ */
+#define OL_TX_SCHED_AIRTIME_QUANTUM_US	4000
+/* Rate assumed before the first report, in the units of the report */
+#define OL_TX_SCHED_AIRTIME_DEFAULT_RATE	54000
+/* Bound on the queues skipped per selection, the work done under lock */
+#define OL_TX_SCHED_AIRTIME_MAX_SKIP	16
+
+static inline bool
+ol_tx_sched_airtime_enabled(struct ol_txrx_pdev_t *pdev)
+{
+	return pdev->tx_peer_bal.enabled == ol_tx_peer_bal_enable;
+}
+
+/**
+ * ol_tx_sched_airtime_select() - pick the next tx queue of a category
+ * @pdev: the physical device
+ * @category: the category to serve
+ *
+ * Queues without credit are given a quantum and moved to the back. If
+ * none has credit within a bounded number of steps the head is served
+ * anyway, so the scheduler never idles with frames pending.
+ *
+ * Return: the tx queue to serve, still linked in the category list
+ */
+static struct ol_tx_frms_queue_t *
+ol_tx_sched_airtime_select(struct ol_txrx_pdev_t *pdev,
+	struct ol_tx_sched_wrr_adv_category_info_t *category)
+{
+	struct ol_tx_frms_queue_t *txq;
+	int i;
+
+	if (!ol_tx_sched_airtime_enabled(pdev))
+		return TAILQ_FIRST(&category->state.head);
+
+	for (i = 0; i < OL_TX_SCHED_AIRTIME_MAX_SKIP; i++) {
+		txq = TAILQ_FIRST(&category->state.head);
+		if (!txq || !txq->peer || txq->airtime_deficit > 0)
+			return txq;
+
+		txq->airtime_deficit += OL_TX_SCHED_AIRTIME_QUANTUM_US;
+		if (!TAILQ_NEXT(txq, list_elem))
+			return txq;
+
+		TAILQ_REMOVE(&category->state.head, txq, list_elem);
+		TAILQ_INSERT_TAIL(&category->state.head, txq, list_elem);
+	}
+	return TAILQ_FIRST(&category->state.head);
+}
+
+/**
+ * ol_tx_sched_airtime_charge() - account the airtime of downloaded frames
+ * @pdev: the physical device
+ * @txq: the tx queue the frames came from
+ * @frames: number of frames
+ * @bytes: number of bytes
+ */
+static void
+ol_tx_sched_airtime_charge(struct ol_txrx_pdev_t *pdev,
+	struct ol_tx_frms_queue_t *txq, int frames, int bytes)
+{
+	struct ol_txrx_peer_t *peer = txq->peer;
+	u_int32_t rate, airtime;
+
+	if (!peer || !frames || !ol_tx_sched_airtime_enabled(pdev))
+		return;
+
+	rate = peer->tx_rate ? peer->tx_rate :
+		OL_TX_SCHED_AIRTIME_DEFAULT_RATE;
+	/* bits * 1000 / kbps = us */
+	airtime = (u_int32_t)qdf_do_div((u_int64_t)bytes * 8 * 1000, rate);
+
+	txq->airtime_deficit -= airtime;
+	/* credit is not kept across idle periods */
+	if (!txq->frms && txq->airtime_deficit > 0)
+		txq->airtime_deficit = 0;
+
+	peer->tx_airtime_us += airtime;
+	peer->tx_airtime_frms += frames;
+}
+
+static void ol_tx_sched_airtime_stats_display(struct ol_txrx_pdev_t *pdev)
+{
+	struct ol_txrx_vdev_t *vdev;
+	struct ol_txrx_peer_t *peer;
+
+	if (!ol_tx_sched_airtime_enabled(pdev))
+		return;
+
+	QDF_TRACE(QDF_MODULE_ID_TXRX, QDF_TRACE_LEVEL_ERROR,
+		  "Airtime: peer rate airtime_us frames");
+	qdf_spin_lock_bh(&pdev->peer_ref_mutex);
+	TAILQ_FOREACH(vdev, &pdev->vdev_list, vdev_list_elem) {
+		TAILQ_FOREACH(peer, &vdev->peer_list, peer_list_elem) {
+			QDF_TRACE(QDF_MODULE_ID_TXRX, QDF_TRACE_LEVEL_ERROR,
+				  "%pM %u %llu %u", peer->mac_addr.raw,
+				  peer->tx_rate, peer->tx_airtime_us,
+				  peer->tx_airtime_frms);
+		}
+	}
+	qdf_spin_unlock_bh(&pdev->peer_ref_mutex);
+}
+
+static void ol_tx_sched_airtime_stats_clear(struct ol_txrx_pdev_t *pdev)
+{
+	struct ol_txrx_vdev_t *vdev;
+	struct ol_txrx_peer_t *peer;
+
+	qdf_spin_lock_bh(&pdev->peer_ref_mutex);
+	TAILQ_FOREACH(vdev, &pdev->vdev_list, vdev_list_elem) {
+		TAILQ_FOREACH(peer, &vdev->peer_list, peer_list_elem) {
+			peer->tx_airtime_us = 0;
+			peer->tx_airtime_frms = 0;
+		}
+	}
+	qdf_spin_unlock_bh(&pdev->peer_ref_mutex);
+}
+#else
+static inline struct ol_tx_frms_queue_t *
+ol_tx_sched_airtime_select(struct ol_txrx_pdev_t *pdev,
+	struct ol_tx_sched_wrr_adv_category_info_t *category)
+{
+	return TAILQ_FIRST(&category->state.head);
+}
+
+static inline void
+ol_tx_sched_airtime_charge(struct ol_txrx_pdev_t *pdev,
+	struct ol_tx_frms_queue_t *txq, int frames, int bytes)
+{
+}
+
+static inline void
+ol_tx_sched_airtime_stats_display(struct ol_txrx_pdev_t *pdev)
+{
+}
+
+static inline void
+ol_tx_sched_airtime_stats_clear(struct ol_txrx_pdev_t *pdev)
+{
+}
+#endif /* QCA_BAD_PEER_TX_FLOW_CL */
+
 /*
  * The scheduler sync spinlock has been acquired outside this function,
  * so there is no need to worry about mutex within this function.
@@ -824,9 +977,10 @@ ol_tx_sched_select_batch_wrr_adv(
 	scheduler->index = index;
 
 	/*
-	 * Take the tx queue from the head of the category list.
+	 * Take the tx queue from the head of the category list, or the
+	 * first one with airtime credit left.
 	 */
-	txq = TAILQ_FIRST(&category->state.head);
+	txq = ol_tx_sched_airtime_select(pdev, category);
 
 	if (txq) {
 		TAILQ_REMOVE(&category->state.head, txq, list_elem);
@@ -848,6 +1002,7 @@ ol_tx_sched_select_batch_wrr_adv(
 			ol_tx_bad_peer_update_tx_limit(pdev, txq,
 						       frames,
 						       tx_limit_flag);
+			ol_tx_sched_airtime_charge(pdev, txq, frames, bytes);
 
 			OL_TX_SCHED_WRR_ADV_CAT_STAT_INC_DISPATCHED(category,
 								    frames);
@@ -1197,6 +1352,7 @@ ol_txrx_set_wmm_param(ol_txrx_pdev_handle data_pdev,
 void ol_tx_sched_stats_display(struct ol_txrx_pdev_t *pdev)
 {
 	OL_TX_SCHED_WRR_ADV_CAT_STAT_DUMP(pdev->tx_sched.scheduler);
+	ol_tx_sched_airtime_stats_display(pdev);
 }
 
 /**
@@ -1219,6 +1375,7 @@ void ol_tx_sched_cur_state_display(struct ol_txrx_pdev_t *pdev)
 void ol_tx_sched_stats_clear(struct ol_txrx_pdev_t *pdev)
 {
 	OL_TX_SCHED_WRR_ADV_CAT_STAT_CLEAR(pdev->tx_sched.scheduler);
+	ol_tx_sched_airtime_stats_clear(pdev);
 }
 
 #endif /* OL_TX_SCHED == OL_TX_SCHED_WRR_ADV */
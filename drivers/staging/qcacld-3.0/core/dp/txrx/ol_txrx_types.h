@@ -343,6 +343,8 @@ struct ol_tx_frms_queue_t {
 	struct ol_tx_queue_group_t *group_ptrs[OL_TX_MAX_GROUPS_PER_QUEUE];
 #if defined(CONFIG_HL_SUPPORT) && defined(QCA_BAD_PEER_TX_FLOW_CL)
 	struct ol_txrx_peer_t *peer;
+	/* airtime (us) this queue may still use in the current round */
+	int32_t airtime_deficit;
 #endif
 };
 
@@ -1345,6 +1347,10 @@ struct ol_txrx_peer_t {
 	u_int16_t tx_limit;
 	u_int16_t tx_limit_flag;
 	u_int16_t tx_pause_flag;
+	/* last tx rate reported by the target, and airtime stats */
+	u_int32_t tx_rate;
+	u_int64_t tx_airtime_us;
+	u_int32_t tx_airtime_frms;
 #endif
 	qdf_time_t last_assoc_rcvd;
 	qdf_time_t last_disassoc_rcvd;
@@ -2096,8 +2096,6 @@ struct hdd_context_s {
 	unsigned long tdls_source_bitmap;
 	/* tdls source timer to enable/disable TDLS on p2p listen */
 	qdf_mc_timer_t tdls_source_timer;
-	qdf_atomic_t disable_lro_in_concurrency;
-	qdf_atomic_t disable_lro_in_low_tput;
 	qdf_atomic_t vendor_disable_lro_flag;
 	uint8_t last_scan_reject_session_id;
 	scan_reject_states last_scan_reject_reason;
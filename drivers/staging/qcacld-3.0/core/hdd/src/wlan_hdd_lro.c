@@ -34,371 +34,32 @@
 #include <qdf_types.h>
 #include <wlan_hdd_lro.h>
 #include <wlan_hdd_napi.h>
+#include <hif.h>
 #include <wma_api.h>
 #include <ol_txrx_types.h>
 #include <ol_cfg.h>
 #include <cdp_txrx_lro.h>
 
-#include <linux/inet_lro.h>
-#include <linux/list.h>
+#include <linux/netdevice.h>
 #include <linux/random.h>
 #include <net/tcp.h>
 
-#define LRO_MAX_AGGR_SIZE 100
-
-#define LRO_VALID_FIELDS \
-	(LRO_DESC | LRO_ELIGIBILITY_CHECKED | LRO_TCP_ACK_NUM | \
-	 LRO_TCP_DATA_CSUM | LRO_TCP_SEQ_NUM | LRO_TCP_WIN)
-
-/**
- * hdd_lro_get_skb_header() - LRO callback function
- * @skb: network buffer
- * @ip_hdr: contains a pointer to the IP header
- * @tcpudp_hdr: contains a pointer to the TCP header
- * @hdr_flags: indicates if this is a TCP, IPV4 frame
- * @priv: private driver specific opaque pointer
- *
- * Get the IP and TCP headers from the skb
- *
- * Return: 0 - success, < 0 - failure
- */
-static int hdd_lro_get_skb_header(struct sk_buff *skb, void **ip_hdr,
-	void **tcpudp_hdr, u64 *hdr_flags, void *priv)
-{
-	if (QDF_NBUF_CB_RX_IPV6_PROTO(skb)) {
-		hdr_flags = 0;
-		return -EINVAL;
-	}
-
-	*hdr_flags |= (LRO_IPV4 | LRO_TCP);
-	(*ip_hdr) = skb->data;
-	(*tcpudp_hdr) = skb->data + QDF_NBUF_CB_RX_TCP_OFFSET(skb);
-	return 0;
-}
-
-/**
- * hdd_lro_desc_pool_init() - Initialize the free pool of LRO
- * descriptors
- * @lro_desc_pool: free pool of the LRO descriptors
- * @lro_mgr: LRO manager
- *
- * Initialize a list that holds the free LRO descriptors
- *
- * Return: none
- */
-static void hdd_lro_desc_pool_init(struct hdd_lro_desc_pool *lro_desc_pool,
-	 struct net_lro_mgr *lro_mgr)
-{
-	int i;
-
-	INIT_LIST_HEAD(&lro_desc_pool->lro_free_list_head);
-
-	for (i = 0; i < LRO_DESC_POOL_SZ; i++) {
-		lro_desc_pool->lro_desc_array[i].lro_desc =
-			 &lro_mgr->lro_arr[i];
-		list_add_tail(&lro_desc_pool->lro_desc_array[i].lro_node,
-			 &lro_desc_pool->lro_free_list_head);
-	}
-}
-
-/**
- * hdd_lro_desc_info_init() - Initialize the LRO descriptors
- * @hdd_info: HDD LRO data structure
- *
- * Initialize the free pool of LRO descriptors and the entries
- * of the hash table
- *
- * Return: none
- */
-static void hdd_lro_desc_info_init(struct hdd_lro_s *hdd_info)
-{
-	int i;
-
-	/* Initialize pool of free LRO desc.*/
-	hdd_lro_desc_pool_init(&hdd_info->lro_desc_info.lro_desc_pool,
-		 hdd_info->lro_mgr);
-
-	/* Initialize the hash table of LRO desc.*/
-	for (i = 0; i < LRO_DESC_TABLE_SZ; i++) {
-		/* initialize the flows in the hash table */
-		INIT_LIST_HEAD(&hdd_info->lro_desc_info.
-			 lro_hash_table[i].lro_desc_list);
-	}
-
-}
-
-/**
- * hdd_lro_tcp_flow_match() - function to check for a flow match
- * @iph: IP header
- * @tcph: TCP header
- * @lro_desc: LRO decriptor
- *
- * Checks if the descriptor belongs to the same flow as the one
- * indicated by the TCP and IP header.
- *
- * Return: true - flow match, false - flow does not match
- */
-static inline bool hdd_lro_tcp_flow_match(struct net_lro_desc *lro_desc,
-	 struct iphdr *iph,
-	 struct tcphdr *tcph)
-{
-	if ((lro_desc->tcph->source != tcph->source) ||
-		 (lro_desc->tcph->dest != tcph->dest) ||
-		 (lro_desc->iph->saddr != iph->saddr) ||
-		 (lro_desc->iph->daddr != iph->daddr))
-		return false;
-
-	return true;
-
-}
-
-/**
- * hdd_lro_desc_find() - LRO descriptor look-up function
- *
- * @adapter: HDD adaptor
- * @skb: network buffer
- * @iph: IP header
- * @tcph: TCP header
- * @lro_desc: contains a pointer to the LRO decriptor
- *
- * Look-up the LRO descriptor in the hash table based on the
- * flow ID toeplitz. If the flow is not found, allocates a new
- * LRO descriptor and places it in the hash table
- *
- * Return: 0 - success, < 0 - failure
- */
-static int hdd_lro_desc_find(struct hdd_lro_s *lro_info,
-	 struct sk_buff *skb, struct iphdr *iph, struct tcphdr *tcph,
-	 struct net_lro_desc **lro_desc)
-{
-	uint32_t i;
-	struct hdd_lro_desc_table *lro_hash_table;
-	struct list_head *ptr;
-	struct hdd_lro_desc_entry *entry;
-	struct hdd_lro_desc_pool *free_pool;
-	struct hdd_lro_desc_info *desc_info = &lro_info->lro_desc_info;
-
-	*lro_desc = NULL;
-	i = QDF_NBUF_CB_RX_FLOW_ID_TOEPLITZ(skb) & LRO_DESC_TABLE_SZ_MASK;
-
-	lro_hash_table = &desc_info->lro_hash_table[i];
-
-	if (!lro_hash_table) {
-		hdd_err("Invalid hash entry");
-		QDF_ASSERT(0);
-		return -EINVAL;
-	}
-
-	/* Check if this flow exists in the descriptor list */
-	list_for_each(ptr, &lro_hash_table->lro_desc_list) {
-		struct net_lro_desc *tmp_lro_desc = NULL;
-
-		entry = list_entry(ptr, struct hdd_lro_desc_entry, lro_node);
-		tmp_lro_desc = entry->lro_desc;
-		if (tmp_lro_desc->active) {
-			if (hdd_lro_tcp_flow_match(tmp_lro_desc, iph, tcph)) {
-				*lro_desc = entry->lro_desc;
-				return 0;
-			}
-		}
-	}
-
-	/* no existing flow found, a new LRO desc needs to be allocated */
-	free_pool = &lro_info->lro_desc_info.lro_desc_pool;
-	entry = list_first_entry_or_null(
-		 &free_pool->lro_free_list_head,
-		 struct hdd_lro_desc_entry, lro_node);
-	if (NULL == entry) {
-		hdd_debug("Could not allocate LRO desc!");
-		return -ENOMEM;
-	}
-
-	list_del_init(&entry->lro_node);
-
-	if (NULL == entry->lro_desc) {
-		hdd_err("entry->lro_desc is NULL!");
-		return -EINVAL;
-	}
-
-	qdf_mem_zero((void *)entry->lro_desc, sizeof(struct net_lro_desc));
-
-	/*
-	 * lro_desc->active should be 0 and lro_desc->tcp_rcv_tsval
-	 * should be 0 for newly allocated lro descriptors
-	 */
-	list_add_tail(&entry->lro_node,
-		 &lro_hash_table->lro_desc_list);
-	*lro_desc = entry->lro_desc;
-
-	return 0;
-}
-
-/**
- * hdd_lro_get_desc() - LRO descriptor look-up function
- * @iph: IP header
- * @tcph: TCP header
- * @lro_arr: Array of LRO decriptors
- * @lro_mgr: LRO manager
- *
- * Looks-up the LRO descriptor for a given flow
- *
- * Return: LRO descriptor
- */
-static struct net_lro_desc *hdd_lro_get_desc(struct net_lro_mgr *lro_mgr,
-	 struct net_lro_desc *lro_arr,
-	 struct iphdr *iph,
-	 struct tcphdr *tcph)
-{
-	int i;
-
-	for (i = 0; i < lro_mgr->max_desc; i++) {
-		if (lro_arr[i].active)
-			if (hdd_lro_tcp_flow_match(&lro_arr[i], iph, tcph))
-				return &lro_arr[i];
-	}
-
-	return NULL;
-}
-
-/**
- * hdd_lro_eligible() - LRO eligibilty check
- * @iph: IP header
- * @tcph: TCP header
- * @adapter: HDD adaptor
- * @desc: LRO descriptor
- * @skb: network buffer
- *
- * Determines if the frame is LRO eligible
- *
- * Return: true - LRO eligible frame, false - frame is not LRO
- * eligible
- */
-static bool hdd_lro_eligible(struct hdd_lro_s *lro_info, struct sk_buff *skb,
-	 struct iphdr *iph, struct tcphdr *tcph, struct net_lro_desc **desc)
-{
-	struct net_lro_desc *lro_desc = NULL;
-	int hw_lro_eligible =
-		 QDF_NBUF_CB_RX_LRO_ELIGIBLE(skb) &&
-		 (!QDF_NBUF_CB_RX_TCP_PURE_ACK(skb));
-
-	if (!hw_lro_eligible)
-		return false;
-
-	if (0 != hdd_lro_desc_find(lro_info, skb, iph, tcph, desc)) {
-		hdd_debug("finding the LRO desc failed");
-		return false;
-	}
-
-	lro_desc = *desc;
-	if (!lro_desc)
-		return false;
-
-	/* if this is not the first skb, check the timestamp option */
-	if (lro_desc->tcp_rcv_tsval) {
-		if (tcph->doff == 8) {
-			__be32 *topt = (__be32 *)(tcph + 1);
-
-			if (*topt != htonl((TCPOPT_NOP << 24)
-				 |(TCPOPT_NOP << 16)
-				 | (TCPOPT_TIMESTAMP << 8)
-				 | TCPOLEN_TIMESTAMP))
-				return true;
-
-			/* timestamp should be in right order */
-			topt++;
-			if (after(ntohl(lro_desc->tcp_rcv_tsval),
-					 ntohl(*topt)))
-				return false;
-
-			/* timestamp reply should not be zero */
-			topt++;
-			if (*topt == 0)
-				return false;
-		}
-	}
-
-	return true;
-}
-
-/**
- * hdd_lro_desc_free() - Free the LRO descriptor
- * @adapter: HDD adaptor
- * @desc: LRO descriptor
- *
- * Return the LRO descriptor to the free pool
- *
- * Return: none
- */
-static void hdd_lro_desc_free(struct net_lro_desc *desc,
-	struct hdd_lro_s *lro_info)
-{
-	struct hdd_lro_desc_entry *entry;
-	struct net_lro_mgr *lro_mgr = lro_info->lro_mgr;
-	struct net_lro_desc *arr_base = lro_mgr->lro_arr;
-	struct hdd_lro_desc_info *desc_info = &lro_info->lro_desc_info;
-	int i = desc - arr_base;
-
-	if (i >= LRO_DESC_POOL_SZ) {
-		hdd_err("invalid index %d", i);
-		return;
-	}
-
-	entry = &desc_info->lro_desc_pool.lro_desc_array[i];
-
-	list_del_init(&entry->lro_node);
-
-	list_add_tail(&entry->lro_node, &desc_info->
-		 lro_desc_pool.lro_free_list_head);
-}
-
-/**
- * hdd_lro_flush_pkt() - function to flush the LRO flow
- * @iph: IP header
- * @tcph: TCP header
- * @adapter: HDD adaptor
- * @lro_mgr: LRO manager
- *
- * Flush all the packets aggregated in the LRO manager for the
- * flow indicated by the TCP and IP header
- *
- * Return: none
- */
-static void hdd_lro_flush_pkt(struct net_lro_mgr *lro_mgr,
-			      struct iphdr *iph, struct tcphdr *tcph,
-			      struct hdd_lro_s *lro_info)
-{
-	struct net_lro_desc *lro_desc;
-
-	lro_desc = hdd_lro_get_desc(lro_mgr, lro_mgr->lro_arr, iph, tcph);
-
-	if (lro_desc) {
-		/* statistics */
-		hdd_lro_desc_free(lro_desc, lro_info);
-		lro_flush_desc(lro_mgr, lro_desc);
-	}
-}
-
 /**
  * hdd_lro_flush() - LRO flush callback
  * @data: opaque pointer containing HDD specific information
  *
- * Callback registered to flush all the packets aggregated in
- * the LRO manager for all the flows
+ * Callback registered to run at the end of each NAPI poll. Packets held
+ * by GRO for the NAPI instance are delivered to the stack, so aggregation
+ * never delays a packet beyond the poll it was received in.
  *
  * Return: none
  */
 static void hdd_lro_flush(void *data)
 {
 	struct hdd_lro_s *hdd_lro = data;
-	struct net_lro_mgr *lro_mgr = hdd_lro->lro_mgr;
-	int i;
 
-	for (i = 0; i < lro_mgr->max_desc; i++) {
-		if (lro_mgr->lro_arr[i].active) {
-			hdd_lro_desc_free(&lro_mgr->lro_arr[i], hdd_lro);
-			lro_flush_desc(lro_mgr, &lro_mgr->lro_arr[i]);
-		}
-	}
+	if (hdd_lro && hdd_lro->napi)
+		napi_gro_flush(hdd_lro->napi, false);
 }
 
 /**
@@ -449,67 +110,19 @@ static void *hdd_init_lro_mgr(void)
 {
 	struct hdd_lro_s *hdd_lro;
 	hdd_context_t *hdd_ctx = cds_get_context(QDF_MODULE_ID_HDD);
-	size_t lro_info_sz, lro_mgr_sz, desc_arr_sz, desc_pool_sz;
-	size_t hash_table_sz;
-	uint8_t *lro_mem_ptr;
 
 	if (NULL == hdd_ctx) {
 		hdd_err("hdd_ctx is NULL");
 		return NULL;
 	}
-	/*
-	 * Allocate all the LRO data structures at once and then carve
-	 * them up as needed
-	 */
-	lro_info_sz = sizeof(struct hdd_lro_s);
-	lro_mgr_sz = sizeof(struct net_lro_mgr);
-	desc_arr_sz = (LRO_DESC_POOL_SZ * sizeof(struct net_lro_desc));
-	desc_pool_sz = (LRO_DESC_POOL_SZ * sizeof(struct hdd_lro_desc_entry));
-	hash_table_sz = (sizeof(struct hdd_lro_desc_table) * LRO_DESC_TABLE_SZ);
 
-	lro_mem_ptr = qdf_mem_malloc(lro_info_sz + lro_mgr_sz + desc_arr_sz +
-					desc_pool_sz + hash_table_sz);
-
-	if (NULL == lro_mem_ptr) {
+	hdd_lro = qdf_mem_malloc(sizeof(*hdd_lro));
+	if (NULL == hdd_lro) {
 		hdd_err("Unable to allocate memory for LRO");
 		hdd_ctx->config->lro_enable = 0;
 		return NULL;
 	}
 
-	hdd_lro = (struct hdd_lro_s *)lro_mem_ptr;
-	lro_mem_ptr += lro_info_sz;
-	/* LRO manager */
-	hdd_lro->lro_mgr = (struct net_lro_mgr *)lro_mem_ptr;
-	lro_mem_ptr += lro_mgr_sz;
-
-	/* LRO decriptor array */
-	hdd_lro->lro_mgr->lro_arr = (struct net_lro_desc *)lro_mem_ptr;
-	lro_mem_ptr += desc_arr_sz;
-
-	/* LRO descriptor pool */
-	hdd_lro->lro_desc_info.lro_desc_pool.lro_desc_array =
-		 (struct hdd_lro_desc_entry *)lro_mem_ptr;
-	lro_mem_ptr += desc_pool_sz;
-
-	/* hash table to store the LRO descriptors */
-	hdd_lro->lro_desc_info.lro_hash_table =
-		 (struct hdd_lro_desc_table *)lro_mem_ptr;
-
-	/* Initialize the LRO descriptors */
-	hdd_lro_desc_info_init(hdd_lro);
-
-	if (hdd_ctx->enableRxThread)
-		hdd_lro->lro_mgr->features = LRO_F_NI;
-
-	if (hdd_napi_enabled(HDD_NAPI_ANY))
-		hdd_lro->lro_mgr->features |= LRO_F_NAPI;
-
-	hdd_lro->lro_mgr->ip_summed_aggr = CHECKSUM_UNNECESSARY;
-	hdd_lro->lro_mgr->max_aggr = LRO_MAX_AGGR_SIZE;
-	hdd_lro->lro_mgr->get_skb_header = hdd_lro_get_skb_header;
-	hdd_lro->lro_mgr->ip_summed = CHECKSUM_UNNECESSARY;
-	hdd_lro->lro_mgr->max_desc = LRO_DESC_POOL_SZ;
-
 	return hdd_lro;
 }
 
@@ -518,17 +131,16 @@ static void *hdd_init_lro_mgr(void)
  * @hdd_ctx: HDD context
  * @adapter: HDD adapter
  *
- * This function enables LRO in the network device attached to
- * the HDD adapter. It also allocates the HDD LRO instance for
- * that network device
+ * This function enables GRO in the network device attached to
+ * the HDD adapter. GRO output may be forwarded, so unlike LRO it
+ * is enabled in every device mode.
  *
  * Return: 0 - success, < 0 - failure
  */
 int hdd_lro_enable(hdd_context_t *hdd_ctx, hdd_adapter_t *adapter)
 {
 
-	if (!hdd_ctx->config->lro_enable ||
-		 QDF_STA_MODE != adapter->device_mode) {
+	if (!hdd_ctx->config->lro_enable) {
 		hdd_debug("LRO Disabled");
 		return 0;
 	}
@@ -541,7 +153,7 @@ int hdd_lro_enable(hdd_context_t *hdd_ctx, hdd_adapter_t *adapter)
 	if (qdf_atomic_read(&hdd_ctx->vendor_disable_lro_flag))
 		return 0;
 
-	adapter->dev->features |= NETIF_F_LRO;
+	adapter->dev->features |= NETIF_F_GRO;
 
 	if (hdd_ctx->config->enable_tcp_delack) {
 		hdd_ctx->config->enable_tcp_delack = 0;
@@ -577,17 +189,13 @@ static void hdd_deinit_lro_mgr(void *lro_info)
  * @hdd_ctx: HDD context
  * @adapter: HDD adapter
  *
- * This function frees the HDD LRO instance for the network
- * device attached to the HDD adapter
+ * Nothing is held per adapter: the GRO state belongs to the NAPI
+ * instances and is freed with them by hdd_lro_destroy()
  *
  * Return: none
  */
 void hdd_lro_disable(hdd_context_t *hdd_ctx, hdd_adapter_t *adapter)
 {
-	if (!hdd_ctx->config->lro_enable ||
-		 QDF_STA_MODE != adapter->device_mode)
-		return;
-
 }
 
 /**
@@ -607,71 +215,66 @@ void hdd_lro_destroy(void)
  * @adapter: HDD adapter
  * @skb: network buffer
  *
- * Delivers LRO eligible frames to the LRO manager
+ * Delivers TCP frames to GRO on the NAPI instance of the copy engine they
+ * were received on. This runs from that instance's poll, which is the only
+ * context GRO may be fed from, so frames delivered from the RX thread or
+ * from the peer cache keep the regular path. The firmware flow hash of
+ * frames it found eligible for aggregation is used as the skb hash, so
+ * GRO matches the flow without computing it.
  *
- * Return: HDD_LRO_RX - frame delivered to LRO manager
+ * Return: HDD_LRO_RX - frame delivered to GRO
  * HDD_LRO_NO_RX - frame not delivered
  */
 enum hdd_lro_rx_status hdd_lro_rx(hdd_context_t *hdd_ctx,
 	 hdd_adapter_t *adapter, struct sk_buff *skb)
 {
-	enum hdd_lro_rx_status status = HDD_LRO_NO_RX;
-
-	if (((adapter->dev->features & NETIF_F_LRO) != NETIF_F_LRO) ||
-			qdf_atomic_read(&hdd_ctx->disable_lro_in_concurrency) ||
-			QDF_NBUF_CB_RX_PEER_CACHED_FRM(skb) ||
-			qdf_atomic_read(&hdd_ctx->disable_lro_in_low_tput))
-		return status;
-
-	if (QDF_NBUF_CB_RX_TCP_PROTO(skb)) {
-		struct iphdr *iph;
-		struct tcphdr *tcph;
-		struct net_lro_desc *lro_desc = NULL;
-		struct hdd_lro_s *lro_info;
-		struct hif_opaque_softc *hif_hdl =
-			(struct hif_opaque_softc *)cds_get_context(
-							QDF_MODULE_ID_HIF);
-		if (hif_hdl == NULL) {
-			hdd_err("hif_hdl is NULL");
-			return status;
-		}
-
-		lro_info = hif_get_lro_info(QDF_NBUF_CB_RX_CTX_ID(skb),
-					hif_hdl);
-		if (lro_info == NULL) {
-			hdd_err("LRO mgr is NULL, vdev could be going down");
-			return status;
-		}
+	struct qca_napi_data *napid;
+	struct qca_napi_info *napii;
+	struct hdd_lro_s *lro_info;
+	int ctx_id = QDF_NBUF_CB_RX_CTX_ID(skb);
 
-		iph = (struct iphdr *)skb->data;
-		tcph = (struct tcphdr *)(skb->data + QDF_NBUF_CB_RX_TCP_OFFSET(skb));
-		lro_info->lro_mgr->dev = adapter->dev;
-		if (hdd_lro_eligible(lro_info, skb, iph, tcph, &lro_desc)) {
-			struct net_lro_info hdd_lro_info;
-
-			hdd_lro_info.valid_fields = LRO_VALID_FIELDS;
-
-			hdd_lro_info.lro_desc = lro_desc;
-			hdd_lro_info.lro_eligible = 1;
-			hdd_lro_info.tcp_ack_num = QDF_NBUF_CB_RX_TCP_ACK_NUM(skb);
-			hdd_lro_info.tcp_data_csum =
-				 csum_unfold(htons(QDF_NBUF_CB_RX_TCP_CHKSUM(skb)));
-			hdd_lro_info.tcp_seq_num = QDF_NBUF_CB_RX_TCP_SEQ_NUM(skb);
-			hdd_lro_info.tcp_win = QDF_NBUF_CB_RX_TCP_WIN(skb);
-
-			lro_receive_skb_ext(lro_info->lro_mgr, skb,
-				 (void *)adapter, &hdd_lro_info);
-
-			if (!hdd_lro_info.lro_desc->active)
-				hdd_lro_desc_free(lro_desc, lro_info);
+	if (!hdd_ctx->config->lro_enable ||
+	    ((adapter->dev->features & NETIF_F_GRO) != NETIF_F_GRO) ||
+	    hdd_ctx->enableRxThread ||
+	    QDF_NBUF_CB_RX_PEER_CACHED_FRM(skb) ||
+	    !QDF_NBUF_CB_RX_TCP_PROTO(skb) ||
+	    !hdd_napi_enabled(HDD_NAPI_ANY))
+		return HDD_LRO_NO_RX;
+
+	napid = hdd_napi_get_all();
+	if (unlikely(!napid || ctx_id >= CE_COUNT_MAX ||
+		     !(napid->ce_map & (0x01 << ctx_id))))
+		return HDD_LRO_NO_RX;
+
+	napii = napid->napis[ctx_id];
+	lro_info = napii ? napii->lro_ctx : NULL;
+	if (lro_info == NULL) {
+		hdd_err("LRO mgr is NULL, vdev could be going down");
+		return HDD_LRO_NO_RX;
+	}
 
-			status = HDD_LRO_RX;
-		} else {
-			hdd_lro_flush_pkt(lro_info->lro_mgr,
-				 iph, tcph, lro_info);
-		}
+	if (QDF_NBUF_CB_RX_LRO_ELIGIBLE(skb))
+		skb_set_hash(skb, QDF_NBUF_CB_RX_FLOW_ID_TOEPLITZ(skb),
+			     PKT_HASH_TYPE_L4);
+
+	lro_info->napi = &napii->napi;
+	switch (napi_gro_receive(&napii->napi, skb)) {
+	case GRO_MERGED:
+	case GRO_MERGED_FREE:
+		lro_info->lro_stats.merged++;
+		break;
+	case GRO_HELD:
+		lro_info->lro_stats.held++;
+		break;
+	case GRO_DROP:
+		lro_info->lro_stats.dropped++;
+		break;
+	default:
+		lro_info->lro_stats.normal++;
+		break;
 	}
-	return status;
+
+	return HDD_LRO_RX;
 }
 
 /**
@@ -682,52 +285,27 @@ enum hdd_lro_rx_status hdd_lro_rx(hdd_context_t *hdd_ctx,
  */
 void hdd_lro_display_stats(hdd_context_t *hdd_ctx)
 {
-	hdd_debug("LRO stats is broken, will fix it");
-}
+	struct qca_napi_data *napid = hdd_napi_get_all();
+	struct hdd_lro_s *lro_info;
+	int i;
 
-/**
- * hdd_enable_lro_in_concurrency() - Enable LRO if concurrency is not active
- * @hdd_ctx: hdd context
- *
- * Return: none
- */
-void hdd_enable_lro_in_concurrency(hdd_context_t *hdd_ctx)
-{
-	if (hdd_ctx->config->enable_tcp_delack) {
-		hdd_debug("Disable TCP delack as LRO is enabled");
-		hdd_ctx->config->enable_tcp_delack = 0;
-		hdd_reset_tcp_delack(hdd_ctx);
-	}
-	qdf_atomic_set(&hdd_ctx->disable_lro_in_concurrency, 0);
-}
+	if (!napid)
+		return;
 
-/**
- * hdd_disable_lro_in_concurrency() - Disable LRO due to concurrency
- * @hdd_ctx: hdd context
- *
- * Return: none
- */
-void hdd_disable_lro_in_concurrency(hdd_context_t *hdd_ctx)
-{
-	if (!hdd_ctx->config->enable_tcp_delack) {
-		struct wlan_rx_tp_data rx_tp_data = {0};
-
-		hdd_debug("Enable TCP delack as LRO disabled in concurrency");
-		rx_tp_data.rx_tp_flags |= TCP_DEL_ACK_IND;
-		rx_tp_data.level = hdd_ctx->cur_rx_level;
-		wlan_hdd_send_svc_nlink_msg(hdd_ctx->radio_index,
-			WLAN_SVC_WLAN_TP_IND, &rx_tp_data, sizeof(rx_tp_data));
-		hdd_ctx->config->enable_tcp_delack = 1;
-	}
-	qdf_atomic_set(&hdd_ctx->disable_lro_in_concurrency, 1);
-}
+	hdd_info("GRO stats: ce merged held normal dropped");
+	for (i = 0; i < CE_COUNT_MAX; i++) {
+		if (!(napid->ce_map & (0x01 << i)) || !napid->napis[i])
+			continue;
 
-void hdd_disable_lro_for_low_tput(hdd_context_t *hdd_ctx, bool disable)
-{
-	if (disable)
-		qdf_atomic_set(&hdd_ctx->disable_lro_in_low_tput, 1);
-	else
-		qdf_atomic_set(&hdd_ctx->disable_lro_in_low_tput, 0);
+		lro_info = napid->napis[i]->lro_ctx;
+		if (!lro_info)
+			continue;
+
+		hdd_info("%d %u %u %u %u", i,
+			 lro_info->lro_stats.merged, lro_info->lro_stats.held,
+			 lro_info->lro_stats.normal,
+			 lro_info->lro_stats.dropped);
+	}
 }
 
 /**
@@ -746,13 +324,12 @@ hdd_lro_set_reset(hdd_context_t *hdd_ctx, hdd_adapter_t *adapter,
 		qdf_atomic_set(&hdd_ctx->vendor_disable_lro_flag, 0);
 		hdd_lro_enable(hdd_ctx, adapter);
 	} else {
-		if (!hdd_ctx->config->lro_enable ||
-		    QDF_STA_MODE != adapter->device_mode)
+		if (!hdd_ctx->config->lro_enable)
 			return 0;
 
-		/* Disable LRO, Enable tcpdelack*/
+		/* Disable GRO, Enable tcpdelack*/
 		qdf_atomic_set(&hdd_ctx->vendor_disable_lro_flag, 1);
-		adapter->dev->features &= ~NETIF_F_LRO;
+		adapter->dev->features &= ~NETIF_F_GRO;
 		hdd_debug("LRO Disabled");
 
 		if (!hdd_ctx->config->enable_tcp_delack) {
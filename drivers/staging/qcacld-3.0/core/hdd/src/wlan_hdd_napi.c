@@ -31,6 +31,7 @@
  * WLAN HDD NAPI interface implementation
  */
 #include <smp.h> /* get_cpu */
+#include <linux/interrupt.h> /* irq_set_affinity_hint */
 
 #include "wlan_hdd_napi.h"
 #include "cds_api.h"       /* cds_get_context */
@@ -38,10 +39,15 @@
 #include "wlan_hdd_main.h" /* hdd_err/warn... */
 #include "qdf_types.h"     /* QDF_MODULE_ID_... */
 #include "ce_api.h"
+#include "wlan_hdd_tx_rx.h" /* hdd_send_rps_ind */
 
 /*  guaranteed to be initialized to zero/NULL by the standard */
 static struct qca_napi_data *hdd_napi_ctx;
 
+/* poll the CE NAPI instances from kthreads instead of NET_RX_SOFTIRQ */
+static bool napi_threaded;
+module_param(napi_threaded, bool, S_IRUSR | S_IRGRP | S_IROTH);
+
 /**
  * hdd_napi_get_all() - return the whole NAPI structure from HIF
  *
@@ -89,6 +95,28 @@ static uint32_t hdd_napi_get_map(void)
 	return map;
 }
 
+/**
+ * hdd_napi_set_threaded() - move NAPI instances to their own kthreads
+ * @map: bitmap of created instances, indexed by pipe_id
+ *
+ * Return: none
+ */
+static void hdd_napi_set_threaded(uint32_t map)
+{
+	struct qca_napi_data *napid = hdd_napi_get_all();
+	int i;
+
+	if (unlikely(NULL == napid))
+		return;
+
+	for (i = 0; i < CE_COUNT_MAX; i++) {
+		if (!(map & (0x01 << i)) || NULL == napid->napis[i])
+			continue;
+		if (napi_set_threaded(&napid->napis[i]->napi, true))
+			hdd_err("cannot thread napi %d", i);
+	}
+}
+
 /**
  * hdd_napi_create() - creates the NAPI structures for a given netdev
  *
@@ -129,6 +157,8 @@ int hdd_napi_create(void)
 				rc);
 		} else {
 			hdd_info("napi instances were created. Map=0x%x", rc);
+			if (napi_threaded)
+				hdd_napi_set_threaded(rc);
 			hdd_ctx = cds_get_context(QDF_MODULE_ID_HDD);
 			if (unlikely(NULL == hdd_ctx)) {
 				QDF_ASSERT(0);
@@ -313,6 +343,171 @@ hnpc_ret:
 	return rc;
 }
 
+/*
+ * A NAPI instance processing at least this many packets per bus bandwidth
+ * interval competes for its CPU with the other busy instances.
+ */
+#define HDD_NAPI_CE_BUSY_WORK 500
+
+static uint32_t hdd_napi_ce_work[CE_COUNT_MAX];
+
+/**
+ * hdd_napi_ce_load() - work done by each NAPI instance since the last call
+ * @napid: NAPI data
+ * @load: filled with the number of packets processed, indexed by CE id
+ *
+ * Return: number of busy instances
+ */
+static int hdd_napi_ce_load(struct qca_napi_data *napid, uint32_t *load)
+{
+	struct qca_napi_info *napii;
+	uint32_t work;
+	int i, cpu, busy = 0;
+
+	for (i = 0; i < CE_COUNT_MAX; i++) {
+		load[i] = 0;
+		napii = napid->napis[i];
+		if (!(napid->ce_map & (0x01 << i)) || !napii)
+			continue;
+
+		work = 0;
+		for_each_possible_cpu(cpu)
+			work += napii->stats[cpu].napi_workdone;
+		load[i] = work - hdd_napi_ce_work[i];
+		hdd_napi_ce_work[i] = work;
+		if (load[i] >= HDD_NAPI_CE_BUSY_WORK)
+			busy++;
+	}
+	return busy;
+}
+
+/**
+ * hdd_napi_next_cpu() - next online CPU of a cluster, wrapping around
+ * @napid: NAPI data
+ * @head: first CPU of the cluster
+ * @cpu: previous CPU returned, or -1 to start at @head
+ *
+ * Return: CPU index, or -1 if no CPU of the cluster is online
+ */
+static int hdd_napi_next_cpu(struct qca_napi_data *napid, int head, int cpu)
+{
+	int i;
+
+	for (i = 0; i < NR_CPUS; i++) {
+		cpu = (cpu < 0) ? -1 : napid->napi_cpu[cpu].cluster_nxt;
+		if (cpu < 0)
+			cpu = head;
+		if (napid->napi_cpu[cpu].state == QCA_NAPI_CPU_UP)
+			return cpu;
+	}
+	return -1;
+}
+
+/**
+ * hdd_napi_rebalance() - spread the busy NAPI instances over the big cluster
+ * @napid: NAPI data
+ *
+ * In the high throughput state all NAPI instances are moved to the perf
+ * cluster, where the busy RX CEs may end up sharing a core while the
+ * others idle. When that happens, assign the busy instances to distinct
+ * online cores, heaviest first, by moving their interrupts. Instances
+ * with little traffic are left where they are.
+ */
+static void hdd_napi_rebalance(struct qca_napi_data *napid)
+{
+	uint32_t load[CE_COUNT_MAX];
+	int order[CE_COUNT_MAX];
+	struct qca_napi_info *napii;
+	int i, j, n = 0, head, cpu = -1;
+	bool shared = false;
+
+	if (hdd_napi_ce_load(napid, load) < 2)
+		return;
+
+	/* busy instances sorted by decreasing load */
+	for (i = 0; i < CE_COUNT_MAX; i++) {
+		if (load[i] < HDD_NAPI_CE_BUSY_WORK)
+			continue;
+		for (j = n; j > 0 && load[order[j - 1]] < load[i]; j--)
+			order[j] = order[j - 1];
+		order[j] = i;
+		n++;
+	}
+
+	for (i = 0; i < n && !shared; i++)
+		for (j = i + 1; j < n && !shared; j++)
+			shared = napid->napis[order[i]]->cpu ==
+				 napid->napis[order[j]]->cpu;
+	if (!shared)
+		return;
+
+	head = (napid->bigcl_head >= 0) ? napid->bigcl_head :
+					  napid->lilcl_head;
+	if (head < 0)
+		return;
+
+	qdf_spin_lock_bh(&napid->lock);
+	for (i = 0; i < n; i++) {
+		cpu = hdd_napi_next_cpu(napid, head, cpu);
+		if (cpu < 0)
+			break;
+
+		napii = napid->napis[order[i]];
+		if (napii->cpu == cpu)
+			continue;
+
+		NAPI_DEBUG("%s: moving CE%d (load %u) from CPU%d to CPU%d",
+			   __func__, order[i], load[order[i]], napii->cpu, cpu);
+		napid->napi_cpu[napii->cpu].napis &= ~(0x01 << order[i]);
+		napid->napi_cpu[cpu].napis |= (0x01 << order[i]);
+		napii->cpu = cpu;
+		irq_set_affinity_hint(napii->irq, cpumask_of(cpu));
+	}
+	qdf_spin_unlock_bh(&napid->lock);
+}
+
+/**
+ * hdd_napi_set_rps() - distribute RX flows over CPUs while throughput is high
+ * @hddctx: HDD context
+ * @enable: true when entering the high throughput state
+ *
+ * The NAPI poll of a CE delivers all its packets on one CPU. When RPS is
+ * not statically enabled, but a CPU map is configured, enable it for the
+ * duration of the high throughput state so the stack processing of each
+ * flow is steered, by its hash, to a CPU of the map. Keeping a flow on one
+ * CPU preserves its ordering. The SAP uC offload path manages RPS itself.
+ *
+ * Return: none
+ */
+static void hdd_napi_set_rps(struct hdd_context_s *hddctx, bool enable)
+{
+	struct cds_config_info *cds_cfg = cds_get_ini_config();
+	hdd_adapter_list_node_t *adapter_node, *next;
+	hdd_adapter_t *adapter;
+	QDF_STATUS status;
+
+	if (!cds_cfg || hddctx->rps || hddctx->enableRxThread ||
+	    cds_cfg->uc_offload_enabled ||
+	    !strlen(hddctx->config->cpu_map_list))
+		return;
+
+	if (enable == cds_cfg->rps_enabled)
+		return;
+
+	status = hdd_get_front_adapter(hddctx, &adapter_node);
+	while (NULL != adapter_node && QDF_STATUS_SUCCESS == status) {
+		adapter = adapter_node->pAdapter;
+		if (NULL != adapter && NULL != adapter->dev) {
+			if (enable)
+				hdd_send_rps_ind(adapter);
+			else
+				hdd_send_rps_disable_ind(adapter);
+		}
+		status = hdd_get_next_adapter(hddctx, adapter_node, &next);
+		adapter_node = next;
+	}
+}
+
 /**
  * hdd_napi_apply_throughput_policy() - implement the throughput action policy
  * @hddctx:     HDD context
@@ -334,6 +529,10 @@ hnpc_ret:
  * - medium-threshold (default: 500 packets / 10 ms), because
  *   we would like to be more reactive.
  *
+ * While the state stays high, the busy NAPI instances are spread over the
+ * perf cluster and RX flows are distributed by RPS, see hdd_napi_rebalance()
+ * and hdd_napi_set_rps().
+ *
  * Return: 0 : no action taken, or action return code
  *         !0: error, or action error code
  */
@@ -384,6 +583,9 @@ int hdd_napi_apply_throughput_policy(struct hdd_context_s *hddctx,
 		rc = hdd_napi_perfd_cpufreq(req_state);
 		/* blacklist/boost_mode on/off */
 		rc = hdd_napi_event(NAPI_EVT_TPUT_STATE, (void *)req_state);
+		hdd_napi_set_rps(hddctx, req_state == QCA_NAPI_TPUT_HI);
+	} else if (req_state == QCA_NAPI_TPUT_HI) {
+		hdd_napi_rebalance(napid);
 	}
 	return rc;
 }
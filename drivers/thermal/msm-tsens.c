@@ -181,6 +181,14 @@ static uint32_t tsens_sec_to_msec_value = 1000;
 static uint32_t tsens_completion_timeout_hz = HZ/2;
 static uint32_t tsens_poll_check = 1;
 
+/*
+ * Reads of the same sensor within tsens_cache_ms share one register read.
+ * Threshold interrupts invalidate the cached values.
+ */
+static uint32_t tsens_cache_ms = 10;
+module_param(tsens_cache_ms, uint, 0644);
+MODULE_PARM_DESC(tsens_cache_ms, "Max age in ms of a cached sensor reading");
+
 /* Trips: warm and cool */
 enum tsens_trip_type {
 	TSENS_TRIP_WARM = 0,
@@ -230,6 +238,11 @@ struct tsens_tm_device_sensor {
 	int				dbg_adc_code;
 	u32				wa_temp1_calib_offset_factor;
 	u32				wa_temp2_calib_offset_factor;
+	/* last reading, see tsens_cache_ms */
+	int				cached_temp;
+	unsigned long			cached_jiffies;
+	int				cached_gen;
+	bool				cached;
 };
 
 struct tsens_dbg_counter {
@@ -259,6 +272,8 @@ struct tsens_tm_device {
 	struct list_head		list;
 	bool				is_ready;
 	bool				prev_reading_avail;
+	/* bumped on every threshold interrupt to drop cached readings */
+	atomic_t			cache_gen;
 	bool				calibration_less_mode;
 	bool				tsens_local_init;
 	bool				gain_offset_programmed;
@@ -743,7 +758,9 @@ static int msm_tsens_get_temp(int sensor_client_id, int *temp)
 	bool last_temp_valid = false, last_temp2_valid = false;
 	bool last_temp3_valid = false;
 	struct tsens_tm_device *tmdev = NULL;
+	struct tsens_tm_device_sensor *sensor;
 	uint32_t sensor_hw_num = 0;
+	int gen;
 
 	tmdev = get_tsens_controller_for_client_id(sensor_client_id);
 	if (tmdev == NULL) {
@@ -760,6 +777,15 @@ static int msm_tsens_get_temp(int sensor_client_id, int *temp)
 	}
 	pr_debug("sensor_hw_num:%d\n", sensor_hw_num);
 
+	sensor = &tmdev->sensor[sensor_hw_num];
+	gen = atomic_read(&tmdev->cache_gen);
+	if (tsens_cache_ms && sensor->cached && sensor->cached_gen == gen &&
+		time_before(jiffies, sensor->cached_jiffies +
+				msecs_to_jiffies(tsens_cache_ms))) {
+		*temp = sensor->cached_temp;
+		return 0;
+	}
+
 	if (tmdev->tsens_type == TSENS_TYPE2) {
 		trdy_addr = TSENS2_TRDY_ADDR(tmdev->tsens_addr);
 		sensor_addr = TSENS2_SN_STATUS_ADDR(tmdev->tsens_addr);
@@ -847,6 +873,11 @@ static int msm_tsens_get_temp(int sensor_client_id, int *temp)
 
 	tmdev->sensor[sensor_hw_num].dbg_adc_code = last_temp;
 
+	sensor->cached_temp = *temp;
+	sensor->cached_jiffies = jiffies;
+	sensor->cached_gen = gen;
+	sensor->cached = true;
+
 	trace_tsens_read(*temp, sensor_client_id);
 
 	return 0;
@@ -1799,6 +1830,8 @@ static irqreturn_t tsens_tm_critical_irq_thread(int irq, void *data)
 	int sensor_sw_id = -EINVAL, rc = 0;
 	int wd_mask;
 
+	atomic_inc(&tm->cache_gen);
+
 	tm->crit_set = false;
 	sensor_status_addr = TSENS_TM_SN_STATUS(tm->tsens_addr);
 	sensor_int_mask_addr =
@@ -1902,6 +1935,8 @@ static irqreturn_t tsens_tm_irq_thread(int irq, void *data)
 	int sensor_sw_id = -EINVAL, rc = 0;
 	uint32_t addr_offset;
 
+	atomic_inc(&tm->cache_gen);
+
 	sensor_status_addr = TSENS_TM_SN_STATUS(tm->tsens_addr);
 	sensor_int_mask_addr =
 		TSENS_TM_UPPER_LOWER_INT_MASK(tm->tsens_addr);
@@ -2014,6 +2049,8 @@ static irqreturn_t tsens_irq_thread(int irq, void *data)
 	int sensor_sw_id = -EINVAL;
 	uint32_t idx = 0;
 
+	atomic_inc(&tm->cache_gen);
+
 	if ((tm->tsens_type == TSENS_TYPE2) ||
 			(tm->tsens_type == TSENS_TYPE4))
 		sensor_status_addr = TSENS2_SN_STATUS_ADDR(tm->tsens_addr);
@@ -25,6 +25,7 @@
 #include <linux/timer.h>
 #include <linux/pm_opp.h>
 #include <linux/cpu_cooling.h>
+#include <linux/cpufreq.h>
 #include <linux/bitmap.h>
 #include <linux/msm_thermal.h>
 
@@ -150,6 +151,9 @@ static uint32_t msm_lmh_mitigation_notify(struct msm_lmh_dcvs_hw *hw)
 
 notify_exit:
 	hw->hw_freq_limit = max_limit;
+	/* let the scheduler see the throttled capacity */
+	cpufreq_update_hw_max_freq(&hw->core_map,
+			max_limit >= hw->max_freq ? 0 : max_limit);
 	return max_limit;
 }
 
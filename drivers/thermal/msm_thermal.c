@@ -222,6 +222,9 @@ static struct regulator *vdd_mx, *vdd_cx;
 static int *tsens_temp_at_panic;
 static bool tsens_temp_print;
 static uint32_t bucket;
+static uint32_t freq_predict_polls = 1;
+static int freq_ctrl_last_temp;
+static bool freq_ctrl_last_valid;
 static cpumask_t throttling_mask;
 static int tsens_scaling_factor = SENSOR_SCALING_FACTOR;
 static void *cxip_lm_reg_base;
@@ -3568,6 +3571,26 @@ exit:
 	return ret;
 }
 
+/*
+ * Extrapolate the sensor trend freq_predict_polls samples ahead while the
+ * temperature is rising, so that the limit is stepped down before the
+ * threshold is crossed and is not released while the part is still heating
+ * up. A falling temperature is used as measured.
+ */
+static int freq_ctrl_predict_temp(int temp)
+{
+	int slope = 0;
+
+	if (freq_ctrl_last_valid)
+		slope = temp - freq_ctrl_last_temp;
+	freq_ctrl_last_temp = temp;
+	freq_ctrl_last_valid = true;
+
+	if (slope <= 0)
+		return temp;
+	return temp + slope * (int)freq_predict_polls;
+}
+
 static void do_freq_control(int temp)
 {
 	uint32_t cpu = 0;
@@ -3575,6 +3598,7 @@ static void do_freq_control(int temp)
 
 	if (!boot_freq_mitig_enabled)
 		return;
+	temp = freq_ctrl_predict_temp(temp);
 	if (core_ptr)
 		return do_cluster_freq_ctrl(temp);
 	if (!freq_table_get)
@@ -4973,6 +4997,9 @@ module_param_named(hotplug_temp_degC, msm_thermal_info.hotplug_temp_degC,
 		   uint, 0644);
 module_param_named(freq_mitig_temp_degc,
 		   msm_thermal_info.freq_mitig_temp_degc, uint, 0644);
+module_param(freq_predict_polls, uint, 0644);
+MODULE_PARM_DESC(freq_predict_polls,
+	"number of polls to look ahead for frequency mitigation, 0 to disable");
  /* Control Mask */
 module_param_named(freq_control_mask,
 		   msm_thermal_info.bootup_freq_control_mask, uint, 0644);
@@ -24,6 +24,8 @@
 #include <linux/hid.h>
 #include <linux/module.h>
 #include <linux/uio.h>
+#include <linux/mm.h>
+#include <linux/scatterlist.h>
 #include <linux/ipc_logging.h>
 #include <asm/unaligned.h>
 
@@ -169,6 +171,11 @@ struct ffs_io_data {
 	struct usb_ep *ep;
 	struct usb_request *req;
 
+	/* User pages the request transfers to/from directly, or NULL */
+	struct page **pages;
+	int npages;
+	struct sg_table sgt;
+
 	struct ffs_data *ffs;
 };
 
@@ -705,6 +712,70 @@ static void ffs_epfile_io_complete(struct usb_ep *_ep, struct usb_request *req)
 	}
 }
 
+/*
+ * Zero copy AIO, enabled with the "zero_copy=1" mount option: the user
+ * buffer is pinned and handed to the controller as a scatter list instead
+ * of being bounced through a kmalloc'ed copy. Only done for transfers large
+ * enough to pay for the pinning, made of a single iovec whose length needs
+ * no rounding up to maxpacket, on controllers supporting scatter-gather.
+ */
+#define FFS_ZERO_COPY_MIN	(16 * 1024)
+
+static int ffs_io_data_pin(struct ffs_io_data *io_data, size_t len)
+{
+	struct page **pages;
+	size_t start;
+	ssize_t ret;
+	int npages, i;
+
+	if (!iter_is_iovec(&io_data->data) || io_data->data.nr_segs != 1 ||
+	    len < FFS_ZERO_COPY_MIN || len != iov_iter_count(&io_data->data))
+		return -EINVAL;
+
+	/* Pages are pinned writable when the iterator is read into */
+	ret = iov_iter_get_pages_alloc(&io_data->data, &pages, len, &start);
+	if (ret < 0)
+		return ret;
+
+	npages = DIV_ROUND_UP(start + ret, PAGE_SIZE);
+	if (ret != len) {
+		ret = -EFAULT;
+		goto put;
+	}
+
+	ret = sg_alloc_table_from_pages(&io_data->sgt, pages, npages, start,
+					len, GFP_KERNEL);
+	if (ret)
+		goto put;
+
+	io_data->pages = pages;
+	io_data->npages = npages;
+	return 0;
+
+put:
+	for (i = 0; i < npages; i++)
+		put_page(pages[i]);
+	kvfree(pages);
+	return ret;
+}
+
+static void ffs_io_data_unpin(struct ffs_io_data *io_data)
+{
+	int i;
+
+	if (!io_data->pages)
+		return;
+
+	sg_free_table(&io_data->sgt);
+	for (i = 0; i < io_data->npages; i++) {
+		if (io_data->read)
+			set_page_dirty_lock(io_data->pages[i]);
+		put_page(io_data->pages[i]);
+	}
+	kvfree(io_data->pages);
+	io_data->pages = NULL;
+}
+
 static void ffs_user_copy_worker(struct work_struct *work)
 {
 	struct ffs_io_data *io_data = container_of(work, struct ffs_io_data,
@@ -715,7 +786,7 @@ static void ffs_user_copy_worker(struct work_struct *work)
 
 	//ffs_log("enter: ret %d", ret);
 
-	if (io_data->read && ret > 0) {
+	if (io_data->read && ret > 0 && !io_data->pages) {
 		mm_segment_t oldfs = get_fs();
 
 		set_fs(USER_DS);
@@ -727,6 +798,8 @@ static void ffs_user_copy_worker(struct work_struct *work)
 		set_fs(oldfs);
 	}
 
+	ffs_io_data_unpin(io_data);
+
 	io_data->kiocb->ki_complete(io_data->kiocb, ret, ret);
 
 	if (io_data->ffs->ffs_eventfd && !kiocb_has_eventfd)
@@ -843,6 +916,10 @@ retry:
 			data_len = usb_ep_align_maybe(gadget, ep->ep, data_len);
 		spin_unlock_irq(&epfile->ffs->eps_lock);
 
+		if (io_data->aio && ffs->zero_copy && gadget->sg_supported &&
+		    !ffs_io_data_pin(io_data, data_len))
+			goto fire;
+
 		data = kmalloc(data_len, GFP_KERNEL);
 		if (unlikely(!data))
 			return -ENOMEM;
@@ -855,6 +932,7 @@ retry:
 		}
 	}
 
+fire:
 	/* We will be using request */
 	ret = ffs_mutex_lock(&epfile->mutex, file->f_flags & O_NONBLOCK);
 	if (unlikely(ret))
@@ -898,7 +976,12 @@ retry:
 			if (unlikely(!req))
 				goto error_lock;
 
-			req->buf      = data;
+			if (io_data->pages) {
+				req->sg      = io_data->sgt.sgl;
+				req->num_sgs = io_data->sgt.nents;
+			} else {
+				req->buf     = data;
+			}
 			req->length   = data_len;
 
 			io_data->buf = data;
@@ -1037,6 +1120,7 @@ error_lock:
 	spin_unlock_irq(&epfile->ffs->eps_lock);
 	mutex_unlock(&epfile->mutex);
 error:
+	ffs_io_data_unpin(io_data);
 	kfree(data);
 
 	//ffs_log("exit: ret %zu", ret);
@@ -1126,6 +1210,7 @@ static ssize_t ffs_epfile_write_iter(struct kiocb *kiocb, struct iov_iter *from)
 	p->kiocb = kiocb;
 	p->data = *from;
 	p->mm = current->mm;
+	p->pages = NULL;
 
 	kiocb->private = p;
 
@@ -1176,6 +1261,7 @@ static ssize_t ffs_epfile_read_iter(struct kiocb *kiocb, struct iov_iter *to)
 		p->to_free = NULL;
 	}
 	p->mm = current->mm;
+	p->pages = NULL;
 
 	kiocb->private = p;
 
@@ -1380,6 +1466,7 @@ struct ffs_sb_fill_data {
 	umode_t root_mode;
 	const char *dev_name;
 	bool no_disconnect;
+	bool zero_copy;
 	struct ffs_data *ffs_data;
 };
 
@@ -1462,6 +1549,12 @@ static int ffs_fs_parse_opts(struct ffs_sb_fill_data *data, char *opts)
 			else
 				goto invalid;
 			break;
+		case 9:
+			if (!memcmp(opts, "zero_copy", 9))
+				data->zero_copy = !!value;
+			else
+				goto invalid;
+			break;
 		case 5:
 			if (!memcmp(opts, "rmode", 5))
 				data->root_mode  = (value & 0555) | S_IFDIR;
@@ -1529,6 +1622,7 @@ ffs_fs_mount(struct file_system_type *t, int flags,
 		},
 		.root_mode = S_IFDIR | 0500,
 		.no_disconnect = false,
+		.zero_copy = false,
 	};
 	struct dentry *rv;
 	int ret;
@@ -1548,6 +1642,7 @@ ffs_fs_mount(struct file_system_type *t, int flags,
 		return ERR_PTR(-ENOMEM);
 	ffs->file_perms = data.perms;
 	ffs->no_disconnect = data.no_disconnect;
+	ffs->zero_copy = data.zero_copy;
 
 	ffs->dev_name = kstrdup(dev_name, GFP_KERNEL);
 	if (unlikely(!ffs->dev_name)) {
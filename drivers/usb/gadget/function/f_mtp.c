@@ -30,8 +30,10 @@
 #include <linux/debugfs.h>
 #include <linux/types.h>
 #include <linux/file.h>
+#include <linux/fs.h>
 #include <linux/device.h>
 #include <linux/miscdevice.h>
+#include <linux/sizes.h>
 
 #include <linux/usb.h>
 #include <linux/usb_usual.h>
@@ -48,6 +50,8 @@
 #define INTR_BUFFER_SIZE           28
 #define MAX_INST_NAME_LEN          40
 #define MTP_MAX_FILE_SIZE          0xFFFFFFFFL
+/* Upper bound of the readahead window used while sending a file */
+#define MTP_READAHEAD_MAX          (SZ_16M >> PAGE_SHIFT)
 
 /* String IDs */
 #define INTERFACE_STRING_INDEX	0
@@ -61,7 +65,7 @@
 
 /* number of tx and rx requests to allocate */
 #define MTP_TX_REQ_MAX 8
-#define RX_REQ_MAX 2
+#define RX_REQ_MAX 4
 #define INTR_REQ_MAX 5
 
 /* ID for Microsoft MTP OS String */
@@ -117,6 +121,8 @@ struct mtp_dev {
 	wait_queue_head_t intr_wq;
 	struct usb_request *rx_req[RX_REQ_MAX];
 	int rx_done;
+	/* Number of rx requests completed, they complete in queue order */
+	atomic_t rx_completed;
 
 	/* for processing MTP_SEND_FILE, MTP_RECEIVE_FILE and
 	 * MTP_SEND_FILE_WITH_HEADER ioctls on a work queue
@@ -139,6 +145,17 @@ struct mtp_dev {
 	} perf[MAX_ITERATION];
 	unsigned dbg_read_index;
 	unsigned dbg_write_index;
+	/*
+	 * File transfer totals since the stats were reset. A stall is a
+	 * wait for the host: no idle tx request, or the oldest rx request
+	 * still pending.
+	 */
+	struct mtp_xfer_stats {
+		u64 bytes;
+		u64 time_us;
+		u64 stall_us;
+		unsigned stalls;
+	} tx_stats, rx_stats;
 	bool is_ptp;
 	struct mutex  read_mutex;
 };
@@ -499,6 +516,7 @@ static void mtp_complete_out(struct usb_ep *ep, struct usb_request *req)
 	struct mtp_dev *dev = _mtp_dev;
 
 	dev->rx_done = 1;
+	atomic_inc(&dev->rx_completed);
 	if (req->status != 0 && dev->state != STATE_OFFLINE)
 		dev->state = STATE_ERROR;
 
@@ -803,6 +821,32 @@ static ssize_t mtp_write(struct file *fp, const char __user *buf,
 	return r;
 }
 
+static void mtp_stall_account(struct mtp_xfer_stats *stats, ktime_t start)
+{
+	stats->stalls++;
+	stats->stall_us += ktime_to_us(ktime_sub(ktime_get(), start));
+}
+
+/*
+ * Let readahead run as far ahead as the tx requests that can be in flight,
+ * as POSIX_FADV_SEQUENTIAL would, so vfs_read() mostly copies from the page
+ * cache while the previous requests are on the bus.
+ */
+static void mtp_file_readahead(struct file *filp)
+{
+	unsigned long pages;
+
+	pages = ((unsigned long)mtp_tx_req_len * mtp_tx_reqs) >> PAGE_SHIFT;
+	pages = min_t(unsigned long, pages, MTP_READAHEAD_MAX);
+
+	spin_lock(&filp->f_lock);
+	filp->f_mode &= ~FMODE_RANDOM;
+	spin_unlock(&filp->f_lock);
+
+	if (filp->f_ra.ra_pages < pages)
+		filp->f_ra.ra_pages = pages;
+}
+
 /* read from a local file and write to USB */
 static void send_file_work(struct work_struct *data)
 {
@@ -817,7 +861,7 @@ static void send_file_work(struct work_struct *data)
 	int xfer, ret, hdr_size;
 	int r = 0;
 	int sendZLP = 0;
-	ktime_t start_time;
+	ktime_t start_time, xfer_start;
 
 	/* read our parameters */
 	smp_rmb();
@@ -827,6 +871,9 @@ static void send_file_work(struct work_struct *data)
 
 	DBG(cdev, "send_file_work(%lld %lld)\n", offset, count);
 
+	mtp_file_readahead(filp);
+	xfer_start = ktime_get();
+
 	if (dev->xfer_send_header) {
 		hdr_size = sizeof(struct mtp_data_header);
 		count += hdr_size;
@@ -846,10 +893,15 @@ static void send_file_work(struct work_struct *data)
 			sendZLP = 0;
 
 		/* get an idle tx request to use */
-		req = 0;
-		ret = wait_event_interruptible(dev->write_wq,
-			(req = mtp_req_get(dev, &dev->tx_idle))
-			|| dev->state != STATE_BUSY);
+		ret = 0;
+		req = mtp_req_get(dev, &dev->tx_idle);
+		if (!req) {
+			start_time = ktime_get();
+			ret = wait_event_interruptible(dev->write_wq,
+				(req = mtp_req_get(dev, &dev->tx_idle))
+				|| dev->state != STATE_BUSY);
+			mtp_stall_account(&dev->tx_stats, start_time);
+		}
 		if (dev->state == STATE_CANCELED) {
 			r = -ECANCELED;
 			break;
@@ -907,6 +959,7 @@ static void send_file_work(struct work_struct *data)
 		}
 
 		count -= xfer;
+		dev->tx_stats.bytes += xfer;
 
 		/* zero this so we don't try to free it on error exit */
 		req = 0;
@@ -915,6 +968,8 @@ static void send_file_work(struct work_struct *data)
 	if (req)
 		mtp_req_put(dev, &dev->tx_idle, req);
 
+	dev->tx_stats.time_us += ktime_to_us(ktime_sub(ktime_get(), xfer_start));
+
 	DBG(cdev, "send_file_work returning %d state:%d\n", r, dev->state);
 	/* write the result */
 	dev->xfer_result = r;
@@ -927,13 +982,13 @@ static void receive_file_work(struct work_struct *data)
 	struct mtp_dev *dev = container_of(data, struct mtp_dev,
 						receive_file_work);
 	struct usb_composite_dev *cdev = dev->cdev;
-	struct usb_request *read_req = NULL, *write_req = NULL;
+	struct usb_request *read_req;
 	struct file *filp;
 	loff_t offset;
-	int64_t count;
-	int ret, cur_buf = 0;
+	int64_t count, unqueued;
+	int ret, head = 0, tail = 0, queued = 0, completed;
 	int r = 0;
-	ktime_t start_time;
+	ktime_t start_time, xfer_start;
 
 	/* read our parameters */
 	smp_rmb();
@@ -946,17 +1001,26 @@ static void receive_file_work(struct work_struct *data)
 		DBG(cdev, "%s- count(%lld) not multiple of mtu(%d)\n", __func__,
 						count, dev->ep_out->maxpacket);
 
-	while (count > 0 || write_req) {
-		if (count > 0) {
+	unqueued = count;
+	completed = atomic_read(&dev->rx_completed);
+	xfer_start = ktime_get();
+
+	while (count > 0) {
+		/*
+		 * Keep reads queued for the data still expected, but never
+		 * more: the host sends the next command on the same endpoint.
+		 * The length of a transfer of 0xFFFFFFFF is unknown, so only
+		 * one read is queued at a time for them.
+		 */
+		while (queued < RX_REQ_MAX && unqueued > 0 &&
+				(count != 0xFFFFFFFF || !queued)) {
 			mutex_lock(&dev->read_mutex);
 			if (dev->state == STATE_OFFLINE) {
 				r = -EIO;
 				mutex_unlock(&dev->read_mutex);
-				break;
+				goto out;
 			}
-			/* queue a request */
-			read_req = dev->rx_req[cur_buf];
-			cur_buf = (cur_buf + 1) % RX_REQ_MAX;
+			read_req = dev->rx_req[tail];
 
 			/* some h/w expects size to be aligned to ep's MTU */
 			read_req->length = mtp_rx_req_len;
@@ -968,92 +1032,103 @@ static void receive_file_work(struct work_struct *data)
 				r = -EIO;
 				if (dev->state != STATE_OFFLINE)
 					dev->state = STATE_ERROR;
-				break;
+				goto out;
 			}
+			tail = (tail + 1) % RX_REQ_MAX;
+			queued++;
+			if (count != 0xFFFFFFFF)
+				unqueued -= min_t(int64_t, unqueued,
+						  mtp_rx_req_len);
 		}
 
-		if (write_req) {
-			DBG(cdev, "rx %pK %d\n", write_req, write_req->actual);
+		/* wait for the oldest read to complete */
+		read_req = dev->rx_req[head];
+		ret = 0;
+		if (atomic_read(&dev->rx_completed) == completed) {
 			start_time = ktime_get();
-			mutex_lock(&dev->read_mutex);
-			if (dev->state == STATE_OFFLINE) {
+			ret = wait_event_interruptible(dev->read_wq,
+				atomic_read(&dev->rx_completed) != completed
+				|| dev->state != STATE_BUSY);
+			mtp_stall_account(&dev->rx_stats, start_time);
+		}
+		if (dev->state == STATE_CANCELED
+				|| dev->state == STATE_OFFLINE
+				|| dev->state == STATE_ERROR) {
+			if (dev->state == STATE_OFFLINE)
 				r = -EIO;
-				mutex_unlock(&dev->read_mutex);
-				break;
-			}
-			ret = vfs_write(filp, write_req->buf, write_req->actual,
-				&offset);
-			DBG(cdev, "vfs_write %d\n", ret);
-			if (ret != write_req->actual) {
+			/* Solved unplug cable but no error code to notify mtp
+			 * server to return error in doSendObject. */
+			else if (dev->state == STATE_ERROR)
 				r = -EIO;
-				mutex_unlock(&dev->read_mutex);
-				if (dev->state != STATE_OFFLINE)
-					dev->state = STATE_ERROR;
-				break;
-			}
-			mutex_unlock(&dev->read_mutex);
-			dev->perf[dev->dbg_write_index].vfs_wtime =
-				ktime_to_us(ktime_sub(ktime_get(), start_time));
-			dev->perf[dev->dbg_write_index].vfs_wbytes = ret;
-			dev->dbg_write_index =
-				(dev->dbg_write_index + 1) % MAX_ITERATION;
-			write_req = NULL;
+			else
+				r = -ECANCELED;
+			goto out;
+		}
+		if (atomic_read(&dev->rx_completed) == completed) {
+			r = ret ? ret : -EINTR;
+			goto out;
+		}
+		completed++;
+		head = (head + 1) % RX_REQ_MAX;
+		queued--;
+		if (read_req->status) {
+			r = read_req->status;
+			goto out;
 		}
 
-		if (read_req) {
-			/* wait for our last read to complete */
-			ret = wait_event_interruptible(dev->read_wq,
-				dev->rx_done || dev->state != STATE_BUSY);
-			if (dev->state == STATE_CANCELED
-					|| dev->state == STATE_OFFLINE
-					|| dev->state == STATE_ERROR) {
-				if (dev->state == STATE_OFFLINE)
-					r = -EIO;
-				/* Solved unplug cable but no error code to notify mtp
-				 * server to return error in doSendObject. */
-				else if (dev->state == STATE_ERROR)
-					r = -EIO;
-				else
-					r = -ECANCELED;
-				if (!dev->rx_done)
-					usb_ep_dequeue(dev->ep_out, read_req);
-				break;
-			}
-			if (read_req->status) {
-				r = read_req->status;
-				break;
-			}
-
-			mutex_lock(&dev->read_mutex);
-			if (dev->state == STATE_OFFLINE) {
-				r = -EIO;
-				mutex_unlock(&dev->read_mutex);
-				break;
-			}
-			/* Check if we aligned the size due to MTU constraint */
-			if (count < read_req->length)
-				read_req->actual = (read_req->actual > count ?
-						count : read_req->actual);
-			/* if xfer_file_length is 0xFFFFFFFF, then we read until
-			 * we get a zero length packet
+		mutex_lock(&dev->read_mutex);
+		if (dev->state == STATE_OFFLINE) {
+			r = -EIO;
+			mutex_unlock(&dev->read_mutex);
+			goto out;
+		}
+		/* Check if we aligned the size due to MTU constraint */
+		if (count < read_req->length)
+			read_req->actual = (read_req->actual > count ?
+					count : read_req->actual);
+		/* if xfer_file_length is 0xFFFFFFFF, then we read until
+		 * we get a zero length packet
+		 */
+		if (count != 0xFFFFFFFF)
+			count -= read_req->actual;
+		if (read_req->actual < read_req->length) {
+			/*
+			 * short packet is used to signal EOF for
+			 * sizes > 4 gig
 			 */
-			if (count != 0xFFFFFFFF)
-				count -= read_req->actual;
-			if (read_req->actual < read_req->length) {
-				/*
-				 * short packet is used to signal EOF for
-				 * sizes > 4 gig
-				 */
-				DBG(cdev, "got short packet\n");
-				count = 0;
-			}
+			DBG(cdev, "got short packet\n");
+			count = 0;
+		}
 
-			write_req = read_req;
-			read_req = NULL;
+		DBG(cdev, "rx %pK %d\n", read_req, read_req->actual);
+		start_time = ktime_get();
+		ret = vfs_write(filp, read_req->buf, read_req->actual,
+			&offset);
+		DBG(cdev, "vfs_write %d\n", ret);
+		if (ret != read_req->actual) {
+			r = -EIO;
 			mutex_unlock(&dev->read_mutex);
+			if (dev->state != STATE_OFFLINE)
+				dev->state = STATE_ERROR;
+			goto out;
 		}
+		mutex_unlock(&dev->read_mutex);
+		dev->perf[dev->dbg_write_index].vfs_wtime =
+			ktime_to_us(ktime_sub(ktime_get(), start_time));
+		dev->perf[dev->dbg_write_index].vfs_wbytes = ret;
+		dev->dbg_write_index =
+			(dev->dbg_write_index + 1) % MAX_ITERATION;
+		dev->rx_stats.bytes += ret;
 	}
 
+out:
+	/* reads still queued after an error or an early short packet */
+	for (; queued > 0; queued--) {
+		usb_ep_dequeue(dev->ep_out, dev->rx_req[head]);
+		head = (head + 1) % RX_REQ_MAX;
+	}
+	dev->rx_stats.time_us += ktime_to_us(ktime_sub(ktime_get(), xfer_start));
+
 	DBG(cdev, "receive_file_work returning %d\n", r);
 	/* write the result */
 	dev->xfer_result = r;
@@ -1594,6 +1669,16 @@ static void mtp_function_disable(struct usb_function *f)
 	VDBG(cdev, "%s disabled\n", dev->function.name);
 }
 
+static void mtp_print_xfer_stats(struct seq_file *s, const char *name,
+				 struct mtp_xfer_stats *stats)
+{
+	seq_printf(s, "%s: bytes:%llu\t time(usec):%llu\t KB/s:%llu\t stalls:%u\t stall time(usec):%llu\n",
+		   name, stats->bytes, stats->time_us,
+		   stats->time_us ?
+			div64_u64(stats->bytes * 1000, stats->time_us) : 0,
+		   stats->stalls, stats->stall_us);
+}
+
 static int debug_mtp_read_stats(struct seq_file *s, void *unused)
 {
 	struct mtp_dev *dev = _mtp_dev;
@@ -1621,7 +1706,7 @@ static int debug_mtp_read_stats(struct seq_file *s, void *unused)
 	}
 
 	seq_printf(s, "vfs_write(time in usec) min:%d\t max:%d\t avg:%d\n",
-						min, max, sum / iteration);
+				min, max, iteration ? sum / iteration : 0);
 	min = max = sum = iteration = 0;
 	seq_puts(s, "\n=======================\n");
 	seq_puts(s, "MTP Read Stats:\n");
@@ -1643,7 +1728,13 @@ static int debug_mtp_read_stats(struct seq_file *s, void *unused)
 	}
 
 	seq_printf(s, "vfs_read(time in usec) min:%d\t max:%d\t avg:%d\n",
-						min, max, sum / iteration);
+				min, max, iteration ? sum / iteration : 0);
+
+	seq_puts(s, "\n=======================\n");
+	seq_puts(s, "MTP Transfer Stats:\n");
+	seq_puts(s, "\n=======================\n");
+	mtp_print_xfer_stats(s, "send", &dev->tx_stats);
+	mtp_print_xfer_stats(s, "receive", &dev->rx_stats);
 	spin_unlock_irqrestore(&dev->lock, flags);
 	return 0;
 }
@@ -1669,6 +1760,8 @@ static ssize_t debug_mtp_reset_stats(struct file *file, const char __user *buf,
 	memset(&dev->perf[0], 0, MAX_ITERATION * sizeof(dev->perf[0]));
 	dev->dbg_read_index = 0;
 	dev->dbg_write_index = 0;
+	memset(&dev->tx_stats, 0, sizeof(dev->tx_stats));
+	memset(&dev->rx_stats, 0, sizeof(dev->rx_stats));
 	spin_unlock_irqrestore(&dev->lock, flags);
 done:
 	return count;
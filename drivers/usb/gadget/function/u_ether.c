@@ -55,6 +55,19 @@
 
 static struct workqueue_struct	*uether_wq;
 
+/*
+ * With multi packet transfers, packets are aggregated into the request at
+ * the head of the free list while more than this many requests are in
+ * flight; below it each packet is sent as soon as it arrives.
+ */
+static int tx_req_threshold = 5;
+module_param(tx_req_threshold, int, S_IRUGO | S_IWUSR);
+MODULE_PARM_DESC(tx_req_threshold,
+	"Requests in flight before TX packets are aggregated");
+
+/* Frames handed to the stack per softirq batch */
+#define RX_BATCH	32
+
 struct eth_dev {
 	/* lock is held while accessing port_usb
 	 */
@@ -67,8 +80,6 @@ struct eth_dev {
 	spinlock_t		req_lock;	/* guard {rx,tx}_reqs */
 	struct list_head	tx_reqs, rx_reqs;
 	atomic_t		tx_qlen;
-/* Minimum number of TX USB request queued to UDC */
-#define TX_REQ_THRESHOLD	5
 	int			no_tx_req_used;
 	int			tx_skb_hold_count;
 	u32			tx_req_bufsize;
@@ -453,6 +464,7 @@ static void process_rx_w(struct work_struct *work)
 	struct eth_dev	*dev = container_of(work, struct eth_dev, rx_work);
 	struct sk_buff	*skb;
 	int		status = 0;
+	int		budget;
 	unsigned int	uiCurMtu = 0;
 
 	if (!dev->port_usb)
@@ -462,25 +474,39 @@ static void process_rx_w(struct work_struct *work)
 	if ((uiCurMtu <= ETH_HLEN) || (uiCurMtu > ETH_FRAME_LEN_MAX))
 		uiCurMtu = ETH_FRAME_LEN;
 
-	while ((skb = skb_dequeue(&dev->rx_frames))) {
-		if (status < 0
-				|| ETH_HLEN > skb->len
-				|| skb->len > uiCurMtu) {
-			dev->net->stats.rx_errors++;
-			dev->net->stats.rx_length_errors++;
-			DBG(dev, "rx length %d\n", skb->len);
-			dev_kfree_skb_any(skb);
-			continue;
+	do {
+		budget = RX_BATCH;
+
+		/*
+		 * Keep softirqs off while a batch is queued so the backlog
+		 * is processed once per batch rather than once per frame as
+		 * netif_rx_ni() would, and refill the OUT queue in between.
+		 */
+		local_bh_disable();
+		while (budget && (skb = skb_dequeue(&dev->rx_frames))) {
+			budget--;
+			if (status < 0
+					|| ETH_HLEN > skb->len
+					|| skb->len > uiCurMtu) {
+				dev->net->stats.rx_errors++;
+				dev->net->stats.rx_length_errors++;
+				DBG(dev, "rx length %d\n", skb->len);
+				dev_kfree_skb_any(skb);
+				continue;
+			}
+			skb->protocol = eth_type_trans(skb, dev->net);
+			dev->net->stats.rx_packets++;
+			dev->net->stats.rx_bytes += skb->len;
+
+			status = netif_rx(skb);
 		}
-		skb->protocol = eth_type_trans(skb, dev->net);
-		dev->net->stats.rx_packets++;
-		dev->net->stats.rx_bytes += skb->len;
+		local_bh_enable();
 
-		status = netif_rx_ni(skb);
-	}
+		if (netif_running(dev->net))
+			rx_fill(dev, GFP_KERNEL);
 
-	if (netif_running(dev->net))
-		rx_fill(dev, GFP_KERNEL);
+		cond_resched();
+	} while (!budget);
 }
 
 static void eth_work(struct work_struct *work)
@@ -623,6 +649,7 @@ static netdev_tx_t eth_start_xmit(struct sk_buff *skb,
 	unsigned long		flags;
 	struct usb_ep		*in;
 	u16			cdc_filter;
+	bool			more;
 
 	if ((!skb) || (IS_ERR(skb)))
 		return NETDEV_TX_OK;
@@ -713,11 +740,18 @@ static netdev_tx_t eth_start_xmit(struct sk_buff *skb,
 		memcpy(req->buf + req->length, skb->data, skb->len);
 		req->length = req->length + skb->len;
 		length = req->length;
+		more = skb->xmit_more;
 		dev_kfree_skb_any(skb);
 
+		/*
+		 * Also hold the packet when the stack has more to send right
+		 * away, as long as a request in flight is bound to complete
+		 * and flush the aggregate from tx_complete().
+		 */
 		spin_lock_irqsave(&dev->req_lock, flags);
 		if (dev->tx_skb_hold_count < dev->dl_max_pkts_per_xfer) {
-			if (dev->no_tx_req_used > TX_REQ_THRESHOLD) {
+			if (dev->no_tx_req_used > tx_req_threshold ||
+			    (more && dev->no_tx_req_used > 0)) {
 				list_add(&req->list, &dev->tx_reqs);
 				spin_unlock_irqrestore(&dev->req_lock, flags);
 				goto success;
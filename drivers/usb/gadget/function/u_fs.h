@@ -277,6 +277,8 @@ struct ffs_data {
 
 	struct eventfd_ctx *ffs_eventfd;
 	bool no_disconnect;
+	/* AIO transfers to/from pinned user pages, "zero_copy=1" */
+	bool zero_copy;
 	struct work_struct reset_work;
 
 	/*
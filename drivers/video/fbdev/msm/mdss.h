@@ -506,6 +506,8 @@ struct mdss_data_type {
 	u32 nrt_vbif_dbg_bus_size;
 	struct mdss_debug_inf debug_inf;
 	bool mixer_switched;
+	/* Bumped whenever the pipe registers may have lost their content */
+	u32 pipe_lut_gen;
 	struct mdss_panel_cfg pan_cfg;
 	struct mdss_prefill_data prefill_data;
 	u32 min_prefill_lines; /* this changes within different chipsets */
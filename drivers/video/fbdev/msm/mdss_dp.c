@@ -1122,9 +1122,11 @@ static void mdss_dp_update_cable_status(struct mdss_dp_drv_pdata *dp,
 {
 	mutex_lock(&dp->attention_lock);
 	pr_debug("cable_connected to %d\n", connected);
-	if (dp->cable_connected != connected)
+	if (dp->cable_connected != connected) {
 		dp->cable_connected = connected;
-	else
+		/* only a new EDID read can tell it is the same sink */
+		dp->sink_cache.matched = false;
+	} else
 		pr_debug("no change in cable status\n");
 	mutex_unlock(&dp->attention_lock);
 }
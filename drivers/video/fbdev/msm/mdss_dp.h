@@ -371,6 +371,26 @@ struct edp_edid {
 	struct display_timing_desc timing[4];
 };
 
+/*
+ * EDID and link training result of the last sink seen. Docked devices see
+ * the same sink reconnect over and over; while EDID block 0, serial number
+ * included, reads back the same the rest of the EDID is not read again and
+ * link training starts from the levels that worked last time.
+ */
+struct mdss_dp_sink_cache {
+	bool edid_valid;
+	bool link_valid;
+	bool matched;		/* describes the sink connected now */
+	u8 block0[EDID_BLOCK_SIZE];
+	u8 *edid_buf;
+	u32 edid_len;
+	struct edp_edid edid;
+	char link_rate;
+	char lane_cnt;
+	char v_level;
+	char p_level;
+};
+
 struct dp_statistic {
 	u32 intr_hpd;
 	u32 intr_aux_i2c_done;
@@ -610,6 +630,7 @@ struct mdss_dp_drv_pdata {
 	u32 edid_buf_size;
 	struct edp_edid edid;
 	struct dpcd_cap dpcd;
+	struct mdss_dp_sink_cache sink_cache;
 
 	/* DP Pixel clock RCG and PLL parent */
 	struct clk *pixel_clk_rcg;
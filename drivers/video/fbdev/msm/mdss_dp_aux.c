@@ -996,6 +996,45 @@ int mdss_dp_aux_read_edid(struct mdss_dp_drv_pdata *dp,
 	return ret;
 }
 
+static bool dp_sink_cache_edid_hit(struct mdss_dp_drv_pdata *dp, u8 *block0)
+{
+	struct mdss_dp_sink_cache *cache = &dp->sink_cache;
+
+	if (!cache->edid_valid ||
+	    memcmp(cache->block0, block0, EDID_BLOCK_SIZE))
+		return false;
+
+	memcpy(dp->edid_buf, cache->edid_buf, cache->edid_len);
+	dp->edid = cache->edid;
+	cache->matched = true;
+	pr_debug("same sink, reusing %u bytes of edid\n", cache->edid_len);
+	return true;
+}
+
+static void dp_sink_cache_edid_store(struct mdss_dp_drv_pdata *dp, u32 len)
+{
+	struct mdss_dp_sink_cache *cache = &dp->sink_cache;
+
+	/* a new sink, the link trained for the old one is of no use */
+	cache->edid_valid = false;
+	cache->link_valid = false;
+
+	if (!cache->edid_buf) {
+		cache->edid_buf = devm_kzalloc(&dp->pdev->dev,
+				dp->edid_buf_size, GFP_KERNEL);
+		if (!cache->edid_buf)
+			return;
+	}
+
+	len = min(len, dp->edid_buf_size);
+	memcpy(cache->block0, dp->edid_buf, EDID_BLOCK_SIZE);
+	memcpy(cache->edid_buf, dp->edid_buf, len);
+	cache->edid_len = len;
+	cache->edid = dp->edid;
+	cache->edid_valid = true;
+	cache->matched = true;
+}
+
 int mdss_dp_edid_read(struct mdss_dp_drv_pdata *dp)
 {
 	int rlen, ret = 0;
@@ -1020,6 +1059,7 @@ int mdss_dp_edid_read(struct mdss_dp_drv_pdata *dp)
 	 * TEST_EDID_READ test request.
 	 */
 	dp_sink_parse_test_request(dp);
+	dp->sink_cache.matched = false;
 
 	while (retries) {
 		u8 segment;
@@ -1080,6 +1120,14 @@ int mdss_dp_edid_read(struct mdss_dp_drv_pdata *dp)
 				continue;
 			}
 
+			if (dp->test_data.test_requested != TEST_EDID_READ &&
+			    dp_sink_cache_edid_hit(dp, edid_buf)) {
+				checksum = edid_buf[rlen - 1];
+				edid_parsing_done = true;
+				ext_block_parsing_done = true;
+				break;
+			}
+
 			dp_extract_edid_manufacturer(&dp->edid, edid_buf);
 			dp_extract_edid_product(&dp->edid, edid_buf);
 			dp_extract_edid_version(&dp->edid, edid_buf);
@@ -1114,6 +1162,10 @@ int mdss_dp_edid_read(struct mdss_dp_drv_pdata *dp)
 		}
 	}
 
+	if (edid_parsing_done && ext_block_parsing_done &&
+	    !dp->sink_cache.matched)
+		dp_sink_cache_edid_store(dp, (edid_blk + 1) * EDID_BLOCK_SIZE);
+
 	if (dp->test_data.test_requested == TEST_EDID_READ) {
 		pr_debug("sending checksum %d\n", checksum);
 		dp_aux_send_checksum(dp, checksum);
@@ -2619,9 +2671,37 @@ static void dp_clear_training_pattern(struct mdss_dp_drv_pdata *ep)
 	usleep_range(usleep_time, usleep_time);
 }
 
+static bool dp_sink_cache_link_hit(struct mdss_dp_drv_pdata *dp)
+{
+	struct mdss_dp_sink_cache *cache = &dp->sink_cache;
+
+	/* compliance tests expect the full sequence */
+	if (dp->test_data.test_requested)
+		return false;
+
+	return cache->matched && cache->link_valid &&
+		cache->link_rate == dp->link_rate &&
+		cache->lane_cnt == dp->lane_cnt;
+}
+
+static void dp_sink_cache_link_store(struct mdss_dp_drv_pdata *dp)
+{
+	struct mdss_dp_sink_cache *cache = &dp->sink_cache;
+
+	if (!cache->matched)
+		return;
+
+	cache->link_rate = dp->link_rate;
+	cache->lane_cnt = dp->lane_cnt;
+	cache->v_level = dp->v_level;
+	cache->p_level = dp->p_level;
+	cache->link_valid = true;
+}
+
 int mdss_dp_link_train(struct mdss_dp_drv_pdata *dp)
 {
 	int ret = 0;
+	bool cached;
 
 	ret = dp_aux_chan_ready(dp);
 	if (ret) {
@@ -2629,15 +2709,28 @@ int mdss_dp_link_train(struct mdss_dp_drv_pdata *dp)
 		return ret;
 	}
 
-	dp->v_level = 0; /* start from default level */
-	dp->p_level = 0;
+	cached = dp_sink_cache_link_hit(dp);
+retry:
+	if (cached) {
+		/* start where the same sink settled last time */
+		dp->v_level = dp->sink_cache.v_level;
+		dp->p_level = dp->sink_cache.p_level;
+	} else {
+		dp->v_level = 0; /* start from default level */
+		dp->p_level = 0;
+	}
 	mdss_dp_config_ctrl(dp);
 
 	mdss_dp_state_ctrl(&dp->ctrl_io, 0);
 
 	ret = dp_start_link_train_1(dp);
 	if (ret < 0) {
-		if ((ret == -EAGAIN) && !dp_link_rate_down_shift(dp)) {
+		if ((ret == -EAGAIN) && cached) {
+			pr_debug("cached levels failed, full training\n");
+			cached = false;
+			dp_clear_training_pattern(dp);
+			goto retry;
+		} else if ((ret == -EAGAIN) && !dp_link_rate_down_shift(dp)) {
 			pr_debug("retry with lower rate\n");
 			dp_clear_training_pattern(dp);
 			return -EAGAIN;
@@ -2656,7 +2749,12 @@ int mdss_dp_link_train(struct mdss_dp_drv_pdata *dp)
 
 	ret = dp_start_link_train_2(dp);
 	if (ret < 0) {
-		if ((ret == -EAGAIN) && !dp_link_rate_down_shift(dp)) {
+		if ((ret == -EAGAIN) && cached) {
+			pr_debug("cached levels failed, full training\n");
+			cached = false;
+			dp_clear_training_pattern(dp);
+			goto retry;
+		} else if ((ret == -EAGAIN) && !dp_link_rate_down_shift(dp)) {
 			pr_debug("retry with lower rate\n");
 			dp_clear_training_pattern(dp);
 			return -EAGAIN;
@@ -2668,6 +2766,7 @@ int mdss_dp_link_train(struct mdss_dp_drv_pdata *dp)
 	}
 
 	pr_debug("Training 2 completed successfully\n");
+	dp_sink_cache_link_store(dp);
 
 	dp_write(dp->base + DP_STATE_CTRL, 0x0);
 	/* Make sure to clear the current pattern before starting a new one */
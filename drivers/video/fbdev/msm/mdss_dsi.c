@@ -4279,6 +4279,9 @@ static int mdss_dsi_parse_ctrl_params(struct platform_device *ctrl_pdev,
 	ctrl_pdata->cmd_sync_wait_broadcast = of_property_read_bool(
 		pan_node, "qcom,cmd-sync-wait-broadcast");
 
+	ctrl_pdata->cmd_batch_disable = of_property_read_bool(
+		pan_node, "qcom,mdss-dsi-no-cmd-batch");
+
 	if (ctrl_pdata->cmd_sync_wait_broadcast &&
 		mdss_dsi_is_hw_config_split(ctrl_pdata->shared_data) &&
 		(pinfo->pdest == DISPLAY_2))
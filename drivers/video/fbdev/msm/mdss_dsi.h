@@ -487,6 +487,7 @@ struct mdss_dsi_ctrl_pdata {
 
 	bool cmd_sync_wait_broadcast;
 	bool cmd_sync_wait_trigger;
+	bool cmd_batch_disable;
 
 	struct mdss_rect roi;
 	struct mdss_dsi_dual_pu_roi dual_roi;
@@ -1778,6 +1778,44 @@ static int mdss_dsi_cmd_dma_tpg_tx(struct mdss_dsi_ctrl_pdata *ctrl,
 	return ret;
 }
 
+static bool mdss_dsi_cmd_is_write(struct dsi_cmd_desc *cm)
+{
+	switch (cm->dchdr.dtype) {
+	case DTYPE_DCS_WRITE:
+	case DTYPE_DCS_WRITE1:
+	case DTYPE_DCS_LWRITE:
+	case DTYPE_GEN_WRITE:
+	case DTYPE_GEN_WRITE1:
+	case DTYPE_GEN_WRITE2:
+	case DTYPE_GEN_LWRITE:
+		return true;
+	default:
+		return false;
+	}
+}
+
+/*
+ * Panel command lists usually mark every command last, even where the
+ * panel needs no delay after it, which costs one DMA and one wait for
+ * completion per command. A write needing no delay is sent in the same
+ * DMA as the write after it when that one fits in the buffer; the LAST
+ * flag then only ends the batch.
+ */
+static bool mdss_dsi_cmd_batchable(struct mdss_dsi_ctrl_pdata *ctrl,
+			struct dsi_buf *tp, struct dsi_cmd_desc *cm, int left)
+{
+	struct dsi_cmd_desc *next = cm + 1;
+	int need;
+
+	if (ctrl->cmd_batch_disable || !left || cm->dchdr.wait ||
+	    !mdss_dsi_cmd_is_write(cm) || !mdss_dsi_cmd_is_write(next))
+		return false;
+
+	/* padded payload and host header, plus the start alignment */
+	need = ALIGN(next->dchdr.dlen, 4) + DSI_HOST_HDR_SIZE + 8;
+	return tp->len + need <= tp->size;
+}
+
 static int mdss_dsi_cmds2buf_tx(struct mdss_dsi_ctrl_pdata *ctrl,
 			struct dsi_cmd_desc *cmds, int cnt, int use_dma_tpg)
 {
@@ -1800,7 +1838,9 @@ static int mdss_dsi_cmds2buf_tx(struct mdss_dsi_ctrl_pdata *ctrl,
 			return 0;
 		}
 		tot += len;
-		if (dchdr->last) {
+		if (dchdr->last && mdss_dsi_cmd_batchable(ctrl, tp, cm, cnt)) {
+			*tp->hdr &= ~DSI_HDR_LAST;
+		} else if (dchdr->last) {
 			tp->data = tp->start; /* begin of buf */
 
 			wait = mdss_dsi_wait4video_eng_busy(ctrl);
@@ -88,6 +88,17 @@
 static unsigned int cpu_input_boost_mdss_timeout = CONFIG_CPU_INPUT_BOOST_MDSS_TIMEOUT;
 module_param(cpu_input_boost_mdss_timeout, uint, 0644);
 
+/*
+ * Lead time in micro seconds with which the clocks are voted on ahead of
+ * the next commit, predicted from the cadence of the previous ones.
+ * 0 disables the prediction.
+ */
+static unsigned int commit_early_wake_us = 2000;
+module_param(commit_early_wake_us, uint, 0644);
+
+/* commits further apart than this are not a steady cadence */
+#define MDSS_FB_COMMIT_PERIOD_MAX_NS	(50 * NSEC_PER_MSEC)
+
 static struct fb_info *fbi_list[MAX_FBI_LIST];
 static int fbi_list_index;
 
@@ -123,6 +134,7 @@ static int __mdss_fb_sync_buf_done_callback(struct notifier_block *p,
 		unsigned long val, void *data);
 
 static int __mdss_fb_display_thread(void *data);
+static enum hrtimer_restart mdss_fb_commit_predict_cb(struct hrtimer *timer);
 static int mdss_fb_pan_idle(struct msm_fb_data_type *mfd);
 static int mdss_fb_send_panel_event(struct msm_fb_data_type *mfd,
 					int event, void *arg);
@@ -1953,6 +1965,8 @@ static void mdss_fb_stop_disp_thread(struct msm_fb_data_type *mfd)
 
 	kthread_stop(mfd->disp_thread);
 	mfd->disp_thread = NULL;
+	hrtimer_cancel(&mfd->commit_predict_timer);
+	mfd->commit_period_ns = 0;
 }
 
 static void mdss_panel_validate_debugfs_info(struct msm_fb_data_type *mfd)
@@ -2892,6 +2906,9 @@ static int mdss_fb_register(struct msm_fb_data_type *mfd)
 	init_waitqueue_head(&mfd->idle_wait_q);
 	init_waitqueue_head(&mfd->ioctl_q);
 	init_waitqueue_head(&mfd->kickoff_wait_q);
+	hrtimer_init(&mfd->commit_predict_timer, CLOCK_MONOTONIC,
+		     HRTIMER_MODE_REL);
+	mfd->commit_predict_timer.function = mdss_fb_commit_predict_cb;
 
 	ret = fb_alloc_cmap(&fbi->cmap, 256, 0);
 	if (ret)
@@ -3923,6 +3940,49 @@ skip_commit:
 	return ret;
 }
 
+/*
+ * Clients commit once per vsync while animating, so the cadence of the
+ * commits predicts the next one. The early wake up of the interface is
+ * the one used for input events: it is safe from atomic context and
+ * turns the clocks on (and holds off the idle timer) so that the commit
+ * doesn't pay for it.
+ */
+static enum hrtimer_restart mdss_fb_commit_predict_cb(struct hrtimer *timer)
+{
+	struct msm_fb_data_type *mfd = container_of(timer,
+			struct msm_fb_data_type, commit_predict_timer);
+
+	if (!atomic_read(&mfd->commits_pending) &&
+	    mdss_fb_is_power_on(mfd) && mfd->mdp.input_event_handler)
+		mfd->mdp.input_event_handler(mfd);
+
+	return HRTIMER_NORESTART;
+}
+
+static void mdss_fb_commit_predict(struct msm_fb_data_type *mfd)
+{
+	u64 lead_ns = (u64)READ_ONCE(commit_early_wake_us) * NSEC_PER_USEC;
+	ktime_t now = ktime_get();
+	s64 delta = ktime_to_ns(ktime_sub(now, mfd->last_commit_time));
+
+	mfd->last_commit_time = now;
+	if (!lead_ns || delta <= 0 || delta > MDSS_FB_COMMIT_PERIOD_MAX_NS) {
+		mfd->commit_period_ns = 0;
+		return;
+	}
+
+	/* averaged, so that a single late frame doesn't move the prediction */
+	if (mfd->commit_period_ns)
+		mfd->commit_period_ns = (mfd->commit_period_ns * 3 + delta) >> 2;
+	else
+		mfd->commit_period_ns = delta;
+
+	if (mfd->commit_period_ns > lead_ns)
+		hrtimer_start(&mfd->commit_predict_timer,
+			      ns_to_ktime(mfd->commit_period_ns - lead_ns),
+			      HRTIMER_MODE_REL);
+}
+
 static int __mdss_fb_display_thread(void *data)
 {
 	struct msm_fb_data_type *mfd = data;
@@ -3953,6 +4013,7 @@ static int __mdss_fb_display_thread(void *data)
 		MDSS_XLOG(mfd->index, XLOG_FUNC_EXIT);
 
 		atomic_dec(&mfd->commits_pending);
+		mdss_fb_commit_predict(mfd);
 		wake_up_all(&mfd->idle_wait_q);
 	}
 
@@ -16,6 +16,7 @@
 
 #include <linux/msm_ion.h>
 #include <linux/list.h>
+#include <linux/hrtimer.h>
 #include <linux/msm_mdp_ext.h>
 #include <linux/types.h>
 #include <linux/notifier.h>
@@ -343,6 +344,11 @@ struct msm_fb_data_type {
 	wait_queue_head_t kickoff_wait_q;
 	bool shutdown_pending;
 
+	/* votes clocks on ahead of the commit predicted from the cadence */
+	struct hrtimer commit_predict_timer;
+	ktime_t last_commit_time;
+	u64 commit_period_ns;
+
 	struct msm_fb_splash_info splash_info;
 
 	wait_queue_head_t ioctl_q;
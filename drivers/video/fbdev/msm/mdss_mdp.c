@@ -2269,6 +2269,10 @@ void mdss_hw_init(struct mdss_data_type *mdata)
 
 	mdss_hw_rev_init(mdata);
 
+	/* Pipe registers are not retained, force the LUTs to be rewritten */
+	if (!++mdata->pipe_lut_gen)
+		mdata->pipe_lut_gen++;
+
 	/* Disable hw underrun recovery only for older mdp reversions. */
 	if (mdata->mdp_rev < MDSS_MDP_HW_REV_105)
 		writel_relaxed(0x0, mdata->mdp_base +
@@ -884,6 +884,15 @@ struct mdss_mdp_pipe {
 	/* flag to re-store roi in case of pu dual-roi validation error */
 	bool restore_roi;
 
+	/*
+	 * Values last written to the per pipe QoS and panic LUTs, valid
+	 * while lut_gen matches mdata->pipe_lut_gen.
+	 */
+	u32 lut_gen;
+	u32 qos_lut;
+	u32 panic_lut;
+	u32 robust_lut;
+
 	/* compression ratio from the source format */
 	struct mult_factor comp_ratio;
 
@@ -101,6 +101,22 @@ static inline u32 mdss_mdp_pipe_read(struct mdss_mdp_pipe *pipe, u32 reg)
 	return readl_relaxed(pipe->base + reg);
 }
 
+/*
+ * The QoS and panic LUTs only depend on the pipe format, width and
+ * interface type, which mostly stay the same across commits. The values
+ * written are cached per pipe so a LUT is only rewritten when it changes,
+ * or when the registers were reset since.
+ */
+static inline void mdss_mdp_pipe_lut_sync(struct mdss_mdp_pipe *pipe)
+{
+	struct mdss_data_type *mdata = mdss_mdp_get_mdata();
+
+	if (pipe->lut_gen != mdata->pipe_lut_gen) {
+		pipe->qos_lut = pipe->panic_lut = pipe->robust_lut = ~0;
+		pipe->lut_gen = mdata->pipe_lut_gen;
+	}
+}
+
 static inline int mdss_calc_fill_level(struct mdss_mdp_format_params *fmt,
 	u32 src_width)
 {
@@ -189,6 +205,10 @@ static void mdss_mdp_pipe_qos_lut(struct mdss_mdp_pipe *pipe)
 			qos_lut = get_qos_lut_macrotile(total_fl);
 	}
 
+	mdss_mdp_pipe_lut_sync(pipe);
+	if (pipe->qos_lut == qos_lut)
+		return;
+
 	trace_mdp_perf_set_qos_luts(pipe->num, pipe->src_fmt->format,
 		ctl->intf_num, pipe->mixer_left->rotator_mode, total_fl,
 		qos_lut, mdss_mdp_is_linear_format(pipe->src_fmt));
@@ -201,6 +221,7 @@ static void mdss_mdp_pipe_qos_lut(struct mdss_mdp_pipe *pipe)
 	mdss_mdp_pipe_write(pipe, MDSS_MDP_REG_SSPP_CREQ_LUT,
 		qos_lut);
 	mdss_mdp_clk_ctrl(MDP_BLOCK_POWER_OFF);
+	pipe->qos_lut = qos_lut;
 }
 
 bool is_rt_pipe(struct mdss_mdp_pipe *pipe)
@@ -225,10 +246,16 @@ static void mdss_mdp_config_pipe_panic_lut(struct mdss_mdp_pipe *pipe)
 		robust_lut = mdata->default_robust_lut_per_pipe_tile;
 	}
 
+	mdss_mdp_pipe_lut_sync(pipe);
+	if ((pipe->panic_lut == panic_lut) && (pipe->robust_lut == robust_lut))
+		return;
+
 	mdss_mdp_pipe_write(pipe, MDSS_MDP_REG_SSPP_DANGER_LUT,
 		panic_lut);
 	mdss_mdp_pipe_write(pipe, MDSS_MDP_REG_SSPP_SAFE_LUT,
 		robust_lut);
+	pipe->panic_lut = panic_lut;
+	pipe->robust_lut = robust_lut;
 
 	trace_mdp_perf_set_panic_luts(pipe->num, pipe->src_fmt->format,
 		pipe->src_fmt->fetch_mode, panic_lut, robust_lut);
@@ -1116,6 +1143,7 @@ static void mdss_mdp_init_pipe_params(struct mdss_mdp_pipe *pipe)
 	pipe->src_split_req = false;
 	pipe->bwc_mode = 0;
 	pipe->restore_roi = false;
+	pipe->lut_gen = 0;
 
 	pipe->mfd = NULL;
 	pipe->mixer_left = pipe->mixer_right = NULL;
@@ -1676,6 +1704,7 @@ int mdss_mdp_pipe_fetch_halt(struct mdss_mdp_pipe *pipe, bool is_recovery)
 			writel_relaxed(reg_val | BIT(pipe->sw_reset.bit_off),
 					mdata->mdp_base + sw_reset_off);
 			wmb();
+			pipe->lut_gen = 0;
 		}
 		mutex_unlock(&mdata->reg_lock);
 
@@ -25,15 +25,36 @@
 #include <linux/namei.h>
 #include "fscrypt_private.h"
 
+/*
+ * The pages of a read bio nearly always belong to one inode, so a single
+ * cipher request is set up and reused for all of them.
+ */
 static void __fscrypt_decrypt_bio(struct bio *bio, bool done)
 {
+	struct inode *req_inode = NULL;
+	struct skcipher_request *req = NULL;
+	DECLARE_CRYPTO_WAIT(wait);
 	struct bio_vec *bv;
 	int i;
 
 	bio_for_each_segment_all(bv, bio, i) {
 		struct page *page = bv->bv_page;
-		int ret = fscrypt_decrypt_page(page->mapping->host, page,
-				PAGE_SIZE, 0, page->index);
+		struct inode *inode = page->mapping->host;
+		int ret;
+
+		if (inode != req_inode) {
+			skcipher_request_free(req);
+			req = fscrypt_alloc_page_req(inode, &wait, GFP_NOFS);
+			req_inode = req ? inode : NULL;
+		}
+
+		if (req)
+			ret = fscrypt_crypt_page_req(inode, req, &wait,
+					FS_DECRYPT, page->index, page, page,
+					PAGE_SIZE, 0);
+		else
+			ret = fscrypt_decrypt_page(inode, page, PAGE_SIZE, 0,
+					page->index);
 
 		if (ret) {
 			WARN_ON_ONCE(1);
@@ -44,6 +65,7 @@ static void __fscrypt_decrypt_bio(struct bio *bio, bool done)
 		if (done)
 			unlock_page(page);
 	}
+	skcipher_request_free(req);
 }
 
 void fscrypt_decrypt_bio(struct bio *bio)
@@ -133,20 +133,46 @@ struct fscrypt_ctx *fscrypt_get_ctx(const struct inode *inode, gfp_t gfp_flags)
 }
 EXPORT_SYMBOL(fscrypt_get_ctx);
 
-int fscrypt_do_page_crypto(const struct inode *inode, fscrypt_direction_t rw,
-			   u64 lblk_num, struct page *src_page,
-			   struct page *dest_page, unsigned int len,
-			   unsigned int offs, gfp_t gfp_flags)
+/**
+ * fscrypt_alloc_page_req() - allocate a request for fscrypt_crypt_page_req()
+ * @inode:     The inode whose key the request is for
+ * @wait:      Completion the request signals
+ * @gfp_flags: The gfp flag for memory allocation
+ *
+ * The request can be used for any number of pages of @inode in turn, which
+ * saves an allocation per page when a whole bio is deciphered.
+ *
+ * Return: the request, or NULL on allocation failure.
+ */
+struct skcipher_request *fscrypt_alloc_page_req(const struct inode *inode,
+						struct crypto_wait *wait,
+						gfp_t gfp_flags)
+{
+	struct skcipher_request *req;
+
+	req = skcipher_request_alloc(inode->i_crypt_info->ci_ctfm, gfp_flags);
+	if (!req)
+		return NULL;
+
+	skcipher_request_set_callback(
+		req, CRYPTO_TFM_REQ_MAY_BACKLOG | CRYPTO_TFM_REQ_MAY_SLEEP,
+		crypto_req_done, wait);
+	return req;
+}
+
+int fscrypt_crypt_page_req(const struct inode *inode,
+			   struct skcipher_request *req,
+			   struct crypto_wait *wait,
+			   fscrypt_direction_t rw, u64 lblk_num,
+			   struct page *src_page, struct page *dest_page,
+			   unsigned int len, unsigned int offs)
 {
 	struct {
 		__le64 index;
 		u8 padding[FS_IV_SIZE - sizeof(__le64)];
 	} iv;
-	struct skcipher_request *req = NULL;
-	DECLARE_CRYPTO_WAIT(wait);
 	struct scatterlist dst, src;
 	struct fscrypt_info *ci = inode->i_crypt_info;
-	struct crypto_skcipher *tfm = ci->ci_ctfm;
 	int res = 0;
 
 	BUG_ON(len == 0);
@@ -161,24 +187,15 @@ int fscrypt_do_page_crypto(const struct inode *inode, fscrypt_direction_t rw,
 					  (u8 *)&iv);
 	}
 
-	req = skcipher_request_alloc(tfm, gfp_flags);
-	if (!req)
-		return -ENOMEM;
-
-	skcipher_request_set_callback(
-		req, CRYPTO_TFM_REQ_MAY_BACKLOG | CRYPTO_TFM_REQ_MAY_SLEEP,
-		crypto_req_done, &wait);
-
 	sg_init_table(&dst, 1);
 	sg_set_page(&dst, dest_page, len, offs);
 	sg_init_table(&src, 1);
 	sg_set_page(&src, src_page, len, offs);
 	skcipher_request_set_crypt(req, &src, &dst, len, &iv);
 	if (rw == FS_DECRYPT)
-		res = crypto_wait_req(crypto_skcipher_decrypt(req), &wait);
+		res = crypto_wait_req(crypto_skcipher_decrypt(req), wait);
 	else
-		res = crypto_wait_req(crypto_skcipher_encrypt(req), &wait);
-	skcipher_request_free(req);
+		res = crypto_wait_req(crypto_skcipher_encrypt(req), wait);
 	if (res) {
 		fscrypt_err(inode->i_sb,
 			    "%scryption failed for inode %lu, block %llu: %d",
@@ -189,6 +206,25 @@ int fscrypt_do_page_crypto(const struct inode *inode, fscrypt_direction_t rw,
 	return 0;
 }
 
+int fscrypt_do_page_crypto(const struct inode *inode, fscrypt_direction_t rw,
+			   u64 lblk_num, struct page *src_page,
+			   struct page *dest_page, unsigned int len,
+			   unsigned int offs, gfp_t gfp_flags)
+{
+	struct skcipher_request *req;
+	DECLARE_CRYPTO_WAIT(wait);
+	int res;
+
+	req = fscrypt_alloc_page_req(inode, &wait, gfp_flags);
+	if (!req)
+		return -ENOMEM;
+
+	res = fscrypt_crypt_page_req(inode, req, &wait, rw, lblk_num,
+				     src_page, dest_page, len, offs);
+	skcipher_request_free(req);
+	return res;
+}
+
 struct page *fscrypt_alloc_bounce_page(struct fscrypt_ctx *ctx,
 				       gfp_t gfp_flags)
 {
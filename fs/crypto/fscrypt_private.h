@@ -14,6 +14,7 @@
 #define __FS_HAS_ENCRYPTION 1
 #include <linux/fscrypt.h>
 #include <crypto/hash.h>
+#include <crypto/skcipher.h>
 
 /* Encryption parameters */
 #define FS_IV_SIZE			16
@@ -103,6 +104,17 @@ static inline bool fscrypt_valid_enc_modes(u32 contents_mode,
 /* crypto.c */
 extern struct kmem_cache *fscrypt_info_cachep;
 extern int fscrypt_initialize(unsigned int cop_flags);
+extern struct skcipher_request *fscrypt_alloc_page_req(
+				  const struct inode *inode,
+				  struct crypto_wait *wait,
+				  gfp_t gfp_flags);
+extern int fscrypt_crypt_page_req(const struct inode *inode,
+				  struct skcipher_request *req,
+				  struct crypto_wait *wait,
+				  fscrypt_direction_t rw, u64 lblk_num,
+				  struct page *src_page,
+				  struct page *dest_page,
+				  unsigned int len, unsigned int offs);
 extern int fscrypt_do_page_crypto(const struct inode *inode,
 				  fscrypt_direction_t rw, u64 lblk_num,
 				  struct page *src_page,
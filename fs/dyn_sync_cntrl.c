@@ -21,9 +21,19 @@
 #include <linux/mutex.h>
 #include <linux/writeback.h>
 #include <linux/fb.h>
+#include <linux/file.h>
+#include <linux/fs.h>
+#include <linux/ktime.h>
+#include <linux/list.h>
+#include <linux/slab.h>
+#include <linux/spinlock.h>
+#include <linux/workqueue.h>
 
 #define DYN_FSYNC_VERSION_MAJOR 1
-#define DYN_FSYNC_VERSION_MINOR 1
+#define DYN_FSYNC_VERSION_MINOR 2
+
+/* Beyond this many files waiting for the group commit, fsync synchronously */
+#define DYN_FSYNC_MAX_PENDING 256
 
 struct notifier_block dyn_fsync_fb_notif;
 
@@ -36,6 +46,128 @@ bool dyn_sync_scr_suspended = false;
 bool dyn_fsync_active __read_mostly = true;
 
 extern void dyn_fsync_suspend_actions(void);
+extern int __vfs_fsync_range(struct file *file, loff_t start, loff_t end,
+		int datasync);
+
+/*
+ * Batch mode: instead of being dropped, fsyncs made while the screen is on
+ * return at once and the file is synced by a group commit at most
+ * dyn_fsync_delay_ms later. Repeated fsyncs of a file in the meantime are
+ * coalesced into one, so data written before a successful fsync is exposed
+ * to loss for a bounded time only.
+ */
+bool dyn_fsync_batch __read_mostly = true;
+static unsigned int dyn_fsync_delay_ms = 50;
+
+struct dyn_fsync_entry {
+	struct list_head list;
+	struct file *file;
+	int datasync;
+	ktime_t queued;
+};
+
+/* dyn_fsync_lock protects the pending list and the statistics */
+static DEFINE_SPINLOCK(dyn_fsync_lock);
+static LIST_HEAD(dyn_fsync_pending);
+static unsigned int dyn_fsync_nr_pending;
+static u64 dyn_fsync_deferred;
+static u64 dyn_fsync_coalesced;
+static u64 dyn_fsync_commits;
+static u64 dyn_fsync_errors;
+static s64 dyn_fsync_max_delay_us;
+
+static void dyn_fsync_commit(struct work_struct *work);
+static DECLARE_DELAYED_WORK(dyn_fsync_work, dyn_fsync_commit);
+
+static void dyn_fsync_commit(struct work_struct *work)
+{
+	struct dyn_fsync_entry *e, *tmp;
+	LIST_HEAD(batch);
+	s64 delay_us;
+	int err;
+
+	spin_lock(&dyn_fsync_lock);
+	list_splice_init(&dyn_fsync_pending, &batch);
+	dyn_fsync_nr_pending = 0;
+	spin_unlock(&dyn_fsync_lock);
+
+	list_for_each_entry_safe(e, tmp, &batch, list) {
+		err = __vfs_fsync_range(e->file, 0, LLONG_MAX, e->datasync);
+		delay_us = ktime_us_delta(ktime_get(), e->queued);
+
+		/* The caller is long gone, the error can only be counted */
+		if (err)
+			pr_warn_ratelimited("%s: deferred fsync failed: %d\n",
+				__FUNCTION__, err);
+
+		spin_lock(&dyn_fsync_lock);
+		dyn_fsync_commits++;
+		if (err)
+			dyn_fsync_errors++;
+		if (delay_us > dyn_fsync_max_delay_us)
+			dyn_fsync_max_delay_us = delay_us;
+		spin_unlock(&dyn_fsync_lock);
+
+		fput(e->file);
+		kfree(e);
+	}
+}
+
+/*
+ * Queue @file for the next group commit. Returns false if the caller has
+ * to sync the file itself.
+ */
+bool dyn_fsync_defer(struct file *file, int datasync)
+{
+	struct inode *inode = file_inode(file);
+	struct dyn_fsync_entry *e, *new;
+
+	if (!file->f_op->fsync || !dyn_fsync_delay_ms)
+		return false;
+
+	new = kmalloc(sizeof(*new), GFP_KERNEL);
+	if (!new)
+		return false;
+
+	spin_lock(&dyn_fsync_lock);
+	list_for_each_entry(e, &dyn_fsync_pending, list) {
+		if (file_inode(e->file) == inode) {
+			/* A full fsync covers a datasync but not the reverse */
+			e->datasync &= datasync;
+			dyn_fsync_coalesced++;
+			spin_unlock(&dyn_fsync_lock);
+			kfree(new);
+			return true;
+		}
+	}
+
+	if (dyn_fsync_nr_pending >= DYN_FSYNC_MAX_PENDING) {
+		spin_unlock(&dyn_fsync_lock);
+		kfree(new);
+		return false;
+	}
+
+	new->file = get_file(file);
+	new->datasync = datasync;
+	new->queued = ktime_get();
+	list_add_tail(&new->list, &dyn_fsync_pending);
+	dyn_fsync_nr_pending++;
+	dyn_fsync_deferred++;
+	spin_unlock(&dyn_fsync_lock);
+
+	/* The first file of a batch sets the deadline for all of them */
+	queue_delayed_work(system_unbound_wq, &dyn_fsync_work,
+		msecs_to_jiffies(dyn_fsync_delay_ms));
+
+	return true;
+}
+
+/* Run the pending group commit now and wait for it */
+static void dyn_fsync_flush(void)
+{
+	mod_delayed_work(system_unbound_wq, &dyn_fsync_work, 0);
+	flush_delayed_work(&dyn_fsync_work);
+}
 
 static ssize_t dyn_fsync_active_show(struct kobject *kobj,
 		struct kobj_attribute *attr, char *buf)
@@ -73,6 +205,66 @@ static ssize_t dyn_fsync_version_show(struct kobject *kobj,
 		DYN_FSYNC_VERSION_MINOR);
 }
 
+static ssize_t dyn_fsync_batch_show(struct kobject *kobj,
+		struct kobj_attribute *attr, char *buf)
+{
+	return sprintf(buf, "%u\n", (dyn_fsync_batch ? 1 : 0));
+}
+
+static ssize_t dyn_fsync_batch_store(struct kobject *kobj,
+		struct kobj_attribute *attr, const char *buf, size_t count)
+{
+	unsigned int data;
+
+	if (sscanf(buf, "%u\n", &data) != 1 || data > 1) {
+		pr_info("%s: bad value!\n", __FUNCTION__);
+		return -EINVAL;
+	}
+
+	dyn_fsync_batch = data;
+	if (!dyn_fsync_batch)
+		dyn_fsync_flush();
+
+	return count;
+}
+
+static ssize_t dyn_fsync_delay_show(struct kobject *kobj,
+		struct kobj_attribute *attr, char *buf)
+{
+	return sprintf(buf, "%u\n", dyn_fsync_delay_ms);
+}
+
+static ssize_t dyn_fsync_delay_store(struct kobject *kobj,
+		struct kobj_attribute *attr, const char *buf, size_t count)
+{
+	unsigned int data;
+
+	if (sscanf(buf, "%u\n", &data) != 1 || data > 1000) {
+		pr_info("%s: bad value!\n", __FUNCTION__);
+		return -EINVAL;
+	}
+
+	dyn_fsync_delay_ms = data;
+
+	return count;
+}
+
+static ssize_t dyn_fsync_stats_show(struct kobject *kobj,
+		struct kobj_attribute *attr, char *buf)
+{
+	ssize_t ret;
+
+	spin_lock(&dyn_fsync_lock);
+	ret = sprintf(buf, "deferred: %llu\ncoalesced: %llu\ncommits: %llu\n"
+		"errors: %llu\npending: %u\nmax_delay_us: %lld\n",
+		dyn_fsync_deferred, dyn_fsync_coalesced, dyn_fsync_commits,
+		dyn_fsync_errors, dyn_fsync_nr_pending,
+		dyn_fsync_max_delay_us);
+	spin_unlock(&dyn_fsync_lock);
+
+	return ret;
+}
+
 static struct kobj_attribute dyn_fsync_active_attribute =
 	__ATTR(Dyn_fsync_active, S_IWUSR|S_IRUGO,
 		dyn_fsync_active_show,
@@ -81,10 +273,26 @@ static struct kobj_attribute dyn_fsync_active_attribute =
 static struct kobj_attribute dyn_fsync_version_attribute =
 	__ATTR(Dyn_fsync_version, S_IRUGO, dyn_fsync_version_show, NULL);
 
+static struct kobj_attribute dyn_fsync_batch_attribute =
+	__ATTR(Dyn_fsync_batch, S_IWUSR|S_IRUGO,
+		dyn_fsync_batch_show,
+		dyn_fsync_batch_store);
+
+static struct kobj_attribute dyn_fsync_delay_attribute =
+	__ATTR(Dyn_fsync_delay_ms, S_IWUSR|S_IRUGO,
+		dyn_fsync_delay_show,
+		dyn_fsync_delay_store);
+
+static struct kobj_attribute dyn_fsync_stats_attribute =
+	__ATTR(Dyn_fsync_stats, S_IRUGO, dyn_fsync_stats_show, NULL);
+
 static struct attribute *dyn_fsync_active_attrs[] =
 	{
 		&dyn_fsync_active_attribute.attr,
 		&dyn_fsync_version_attribute.attr,
+		&dyn_fsync_batch_attribute.attr,
+		&dyn_fsync_delay_attribute.attr,
+		&dyn_fsync_stats_attribute.attr,
 		NULL,
 	};
 
@@ -99,8 +307,10 @@ static void dyn_fsync_suspend(void)
 {
 	mutex_lock(&fsync_mutex);
 	/* flush all outstanding buffers */
-	if (dyn_fsync_active)
+	if (dyn_fsync_active) {
+		dyn_fsync_flush();
 		dyn_fsync_suspend_actions();
+	}
 	mutex_unlock(&fsync_mutex);
 
 	pr_info("%s: flushing work finished.\n", __FUNCTION__);
@@ -166,6 +376,7 @@ static void __exit dyn_fsync_exit(void)
 	if (dyn_fsync_kobj != NULL)
 		kobject_put(dyn_fsync_kobj);
 	fb_unregister_client(&dyn_fsync_fb_notif);
+	dyn_fsync_flush();
 }
 
 module_init(dyn_fsync_init);
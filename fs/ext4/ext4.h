@@ -1397,6 +1397,7 @@ struct ext4_sb_info {
 	unsigned long s_mb_buddies_generated;
 	unsigned long long s_mb_generation_time;
 	atomic_t s_mb_lost_chunks;
+	atomic_t s_mb_busy_skipped;	/* groups skipped as contended */
 	atomic_t s_mb_preallocated;
 	atomic_t s_mb_discarded;
 	atomic_t s_lock_busy;
@@ -2976,6 +2977,22 @@ static inline void ext4_lock_group(struct super_block *sb, ext4_group_t group)
 	}
 }
 
+/*
+ * Only take the group lock if it is free, for callers that can as well
+ * go on with another group rather than wait for a concurrent allocation.
+ */
+static inline bool ext4_try_lock_group(struct super_block *sb,
+				       ext4_group_t group)
+{
+	if (!spin_trylock(ext4_group_lock_ptr(sb, group))) {
+		atomic_add_unless(&EXT4_SB(sb)->s_lock_busy, 1,
+				  EXT4_MAX_CONTENTION);
+		return false;
+	}
+	atomic_add_unless(&EXT4_SB(sb)->s_lock_busy, -1, 0);
+	return true;
+}
+
 static inline void ext4_unlock_group(struct super_block *sb,
 					ext4_group_t group)
 {
@@ -1674,8 +1674,8 @@ static void ext4_mb_use_best_found(struct ext4_allocation_context *ac,
 	/* store last allocated for subsequent stream allocation */
 	if (ac->ac_flags & EXT4_MB_STREAM_ALLOC) {
 		spin_lock(&sbi->s_md_lock);
-		sbi->s_mb_last_group = ac->ac_f_ex.fe_group;
-		sbi->s_mb_last_start = ac->ac_f_ex.fe_start;
+		WRITE_ONCE(sbi->s_mb_last_group, ac->ac_f_ex.fe_group);
+		WRITE_ONCE(sbi->s_mb_last_start, ac->ac_f_ex.fe_start);
 		spin_unlock(&sbi->s_md_lock);
 	}
 }
@@ -2149,13 +2149,14 @@ ext4_mb_regular_allocator(struct ext4_allocation_context *ac)
 							   sb->s_blocksize_bits + 2);
 	}
 
-	/* if stream allocation is enabled, use global goal */
+	/*
+	 * if stream allocation is enabled, use global goal; it is only a
+	 * hint, so a torn read against a concurrent update does no harm
+	 * and all the writers don't have to bounce s_md_lock around
+	 */
 	if (ac->ac_flags & EXT4_MB_STREAM_ALLOC) {
-		/* TBD: may be hot point */
-		spin_lock(&sbi->s_md_lock);
-		ac->ac_g_ex.fe_group = sbi->s_mb_last_group;
-		ac->ac_g_ex.fe_start = sbi->s_mb_last_start;
-		spin_unlock(&sbi->s_md_lock);
+		ac->ac_g_ex.fe_group = READ_ONCE(sbi->s_mb_last_group);
+		ac->ac_g_ex.fe_start = READ_ONCE(sbi->s_mb_last_start);
 	}
 
 	/* Let's just scan groups to find more-less suitable blocks */
@@ -2195,7 +2196,21 @@ repeat:
 			if (err)
 				goto out;
 
-			ext4_lock_group(sb, group);
+			/*
+			 * Parallel writers tend to start from nearby goals.
+			 * Until we are desperate, move on to the next group
+			 * rather than spin behind another allocation; the
+			 * last pass still waits for every group.
+			 */
+			if (cr < 3 && ext4_fs_is_busy(sbi)) {
+				if (!ext4_try_lock_group(sb, group)) {
+					ext4_mb_unload_buddy(&e4b);
+					atomic_inc(&sbi->s_mb_busy_skipped);
+					continue;
+				}
+			} else {
+				ext4_lock_group(sb, group);
+			}
 
 			/*
 			 * We need to check again after locking the
@@ -2753,12 +2768,13 @@ int ext4_mb_release(struct super_block *sb)
 				atomic_read(&sbi->s_bal_success));
 		ext4_msg(sb, KERN_INFO,
 		      "mballoc: %u extents scanned, %u goal hits, "
-				"%u 2^N hits, %u breaks, %u lost",
+				"%u 2^N hits, %u breaks, %u lost, %u busy skipped",
 				atomic_read(&sbi->s_bal_ex_scanned),
 				atomic_read(&sbi->s_bal_goals),
 				atomic_read(&sbi->s_bal_2orders),
 				atomic_read(&sbi->s_bal_breaks),
-				atomic_read(&sbi->s_mb_lost_chunks));
+				atomic_read(&sbi->s_mb_lost_chunks),
+				atomic_read(&sbi->s_mb_busy_skipped));
 		ext4_msg(sb, KERN_INFO,
 		       "mballoc: %lu generated and it took %Lu",
 				sbi->s_mb_buddies_generated,
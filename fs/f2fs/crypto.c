@@ -45,6 +45,7 @@
 
 #include "f2fs.h"
 #include "xattr.h"
+#include "f2fs_ice.h"
 
 /* Encryption added and removed here! (L: */
 
@@ -472,7 +473,8 @@ int f2fs_decrypt_one(struct inode *inode, struct page *page)
 
 bool f2fs_valid_contents_enc_mode(uint32_t mode)
 {
-	return (mode == F2FS_ENCRYPTION_MODE_AES_256_XTS);
+	return (mode == F2FS_ENCRYPTION_MODE_AES_256_XTS ||
+		(mode == F2FS_ENCRYPTION_MODE_PRIVATE && f2fs_is_ice_enabled()));
 }
 
 /**
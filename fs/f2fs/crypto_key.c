@@ -19,6 +19,7 @@
 
 #include "f2fs.h"
 #include "xattr.h"
+#include "f2fs_ice.h"
 
 static void derive_crypt_complete(struct crypto_async_request *req, int rc)
 {
@@ -93,6 +94,7 @@ static void f2fs_free_crypt_info(struct f2fs_crypt_info *ci)
 
 	key_put(ci->ci_keyring_key);
 	crypto_free_ablkcipher(ci->ci_ctfm);
+	memzero_explicit(ci->ci_raw_key, sizeof(ci->ci_raw_key));
 	kmem_cache_free(f2fs_crypt_info_cachep, ci);
 }
 
@@ -175,6 +177,9 @@ retry:
 	case F2FS_ENCRYPTION_MODE_AES_256_CTS:
 		cipher_str = "cts(cbc(aes))";
 		break;
+	case F2FS_ENCRYPTION_MODE_PRIVATE:
+		cipher_str = NULL;
+		break;
 	default:
 		printk_once(KERN_WARNING
 			    "f2fs: unsupported key mode %d (ino %u)\n",
@@ -232,6 +237,18 @@ retry:
 	if (res)
 		goto out;
 
+	if (mode == F2FS_ENCRYPTION_MODE_PRIVATE) {
+		if (!f2fs_is_ice_enabled()) {
+			printk_once(KERN_WARNING
+				    "f2fs: ICE support not available\n");
+			res = -EINVAL;
+			goto out;
+		}
+		/* ICE picks the key up from here when the bio is issued */
+		memcpy(crypt_info->ci_raw_key, raw_key, sizeof(raw_key));
+		goto got_key;
+	}
+
 	ctfm = crypto_alloc_ablkcipher(cipher_str, 0, 0);
 	if (!ctfm || IS_ERR(ctfm)) {
 		res = ctfm ? PTR_ERR(ctfm) : -ENOMEM;
@@ -248,7 +265,7 @@ retry:
 					f2fs_encryption_key_size(mode));
 	if (res)
 		goto out;
-
+got_key:
 	memzero_explicit(raw_key, sizeof(raw_key));
 	if (cmpxchg(&fi->i_crypt_info, NULL, crypt_info) != NULL) {
 		f2fs_free_crypt_info(crypt_info);
@@ -271,3 +288,22 @@ int f2fs_has_encryption_key(struct inode *inode)
 
 	return (fi->i_crypt_info != NULL);
 }
+
+/*
+ * Contents encryption mode of a regular file. Unlike i_crypt_info, the
+ * on-disk context can be read while the key is not available.
+ */
+int f2fs_get_contents_mode(struct inode *inode)
+{
+	struct f2fs_crypt_info *ci = F2FS_I(inode)->i_crypt_info;
+	struct f2fs_encryption_context ctx;
+
+	if (ci)
+		return ci->ci_data_mode;
+
+	if (f2fs_getxattr(inode, F2FS_XATTR_INDEX_ENCRYPTION,
+				F2FS_XATTR_NAME_ENCRYPTION_CONTEXT,
+				&ctx, sizeof(ctx), NULL) != sizeof(ctx))
+		return F2FS_ENCRYPTION_MODE_INVALID;
+	return ctx.contents_encryption_mode;
+}
@@ -167,6 +167,31 @@ int f2fs_submit_page_bio(struct f2fs_io_info *fio)
 	return 0;
 }
 
+/*
+ * ICE takes the key for a whole request from the first page of its bio, so
+ * pages of a file encrypted by ICE never share a bio with other files.
+ */
+static struct inode *f2fs_ice_inode(struct page *page)
+{
+	struct inode *inode;
+
+	if (!page->mapping)
+		return NULL;
+	inode = page->mapping->host;
+	if (!f2fs_encrypted_inode(inode) ||
+	    !f2fs_using_hardware_encryption(inode))
+		return NULL;
+	return inode;
+}
+
+static bool f2fs_ice_mergeable(struct bio *bio, struct page *page)
+{
+	if (!bio->bi_vcnt)
+		return true;
+	return f2fs_ice_inode(bio->bi_io_vec[0].bv_page) ==
+					f2fs_ice_inode(page);
+}
+
 void f2fs_submit_page_mbio(struct f2fs_io_info *fio)
 {
 	struct f2fs_sb_info *sbi = fio->sbi;
@@ -184,8 +209,11 @@ void f2fs_submit_page_mbio(struct f2fs_io_info *fio)
 	if (!is_read)
 		inc_page_count(sbi, F2FS_WRITEBACK);
 
+	bio_page = fio->encrypted_page ? fio->encrypted_page : fio->page;
+
 	if (io->bio && (io->last_block_in_bio != fio->blk_addr - 1 ||
-						io->fio.rw != fio->rw))
+			io->fio.rw != fio->rw ||
+			!f2fs_ice_mergeable(io->bio, bio_page)))
 		__submit_merged_bio(io);
 alloc_new:
 	if (io->bio == NULL) {
@@ -195,8 +223,6 @@ alloc_new:
 		io->fio = *fio;
 	}
 
-	bio_page = fio->encrypted_page ? fio->encrypted_page : fio->page;
-
 	if (bio_add_page(io->bio, bio_page, PAGE_CACHE_SIZE, 0) <
 							PAGE_CACHE_SIZE) {
 		__submit_merged_bio(io);
@@ -295,7 +321,8 @@ struct page *get_read_data_page(struct inode *inode, pgoff_t index,
 		.encrypted_page = NULL,
 	};
 
-	if (f2fs_encrypted_inode(inode) && S_ISREG(inode->i_mode))
+	if (f2fs_encrypted_inode(inode) && S_ISREG(inode->i_mode) &&
+	    !f2fs_using_hardware_encryption(inode))
 		return read_mapping_page(mapping, index, NULL);
 
 	page = f2fs_grab_cache_page(mapping, index, for_write);
@@ -709,6 +736,9 @@ get_next:
 sync_out:
 	if (allocated)
 		sync_inode_page(&dn);
+	if (!create && !err && map->m_len && map->m_pblk != NEW_ADDR)
+		f2fs_update_extent_cache_read(inode, map->m_lblk,
+						map->m_pblk, map->m_len);
 put_out:
 	f2fs_put_dnode(&dn);
 unlock_out:
@@ -892,7 +922,8 @@ struct bio *f2fs_grab_bio(struct inode *inode, block_t blkaddr,
 	if (!f2fs_is_valid_blkaddr(sbi, blkaddr, DATA_GENERIC))
 		return ERR_PTR(-EFAULT);
 
-	if (f2fs_encrypted_inode(inode) && S_ISREG(inode->i_mode)) {
+	if (f2fs_encrypted_inode(inode) && S_ISREG(inode->i_mode) &&
+	    !f2fs_using_hardware_encryption(inode)) {
 		ctx = f2fs_get_crypto_ctx(inode);
 		if (IS_ERR(ctx))
 			return ERR_CAST(ctx);
@@ -1092,7 +1123,8 @@ int do_write_data_page(struct f2fs_io_info *fio)
 		goto out_writepage;
 	}
 
-	if (f2fs_encrypted_inode(inode) && S_ISREG(inode->i_mode)) {
+	if (f2fs_encrypted_inode(inode) && S_ISREG(inode->i_mode) &&
+	    !f2fs_using_hardware_encryption(inode)) {
 
 		/* wait for GCed encrypted page writeback */
 		f2fs_wait_on_encrypted_page_writeback(F2FS_I_SB(inode),
@@ -1622,7 +1654,8 @@ static ssize_t f2fs_direct_IO(struct kiocb *iocb, struct iov_iter *iter,
 			return err;
 	}
 
-	if (f2fs_encrypted_inode(inode) && S_ISREG(inode->i_mode))
+	if (f2fs_encrypted_inode(inode) && S_ISREG(inode->i_mode) &&
+	    !f2fs_using_hardware_encryption(inode))
 		return 0;
 
 	err = check_direct_IO(inode, iter, offset);
@@ -401,8 +401,8 @@ do_insert:
 	return en;
 }
 
-static unsigned int f2fs_update_extent_tree_range(struct inode *inode,
-				pgoff_t fofs, block_t blkaddr, unsigned int len)
+static unsigned int __update_extent_tree_range(struct inode *inode,
+		pgoff_t fofs, block_t blkaddr, unsigned int len, bool read)
 {
 	struct f2fs_sb_info *sbi = F2FS_I_SB(inode);
 	struct extent_tree *et = F2FS_I(inode)->extent_tree;
@@ -523,8 +523,11 @@ static unsigned int f2fs_update_extent_tree_range(struct inode *inode,
 			en1 = __insert_extent_tree(sbi, et, &ei,
 						insert_p, insert_parent);
 
-		/* give up extent_cache, if split and small updates happen */
-		if (dei.len >= 1 &&
+		/*
+		 * give up extent_cache, if split and small updates happen;
+		 * a read only reports the mapping that is already there
+		 */
+		if (!read && dei.len >= 1 &&
 				prev.len < F2FS_MIN_EXTENT_LEN &&
 				et->largest.len < F2FS_MIN_EXTENT_LEN) {
 			et->largest.len = 0;
@@ -554,6 +557,12 @@ static unsigned int f2fs_update_extent_tree_range(struct inode *inode,
 	return !__is_extent_same(&prev, &et->largest);
 }
 
+static unsigned int f2fs_update_extent_tree_range(struct inode *inode,
+				pgoff_t fofs, block_t blkaddr, unsigned int len)
+{
+	return __update_extent_tree_range(inode, fofs, blkaddr, len, false);
+}
+
 unsigned int f2fs_shrink_extent_tree(struct f2fs_sb_info *sbi, int nr_shrink)
 {
 	struct extent_tree *treevec[EXT_TREE_VEC_SIZE];
@@ -724,6 +733,24 @@ void f2fs_update_extent_cache_range(struct dnode_of_data *dn,
 		sync_inode_page(dn);
 }
 
+/*
+ * Cache a mapping that a read had to find in the node pages, e.g. after the
+ * extent was shrunk. Files that are written once and then only read, such
+ * as APKs, would otherwise walk their dnodes on every read, since only
+ * writes used to populate the tree. Sequential reads are merged into large
+ * extents. The inode is not dirtied for this; a new largest extent reaches
+ * the disk with the next inode update.
+ */
+void f2fs_update_extent_cache_read(struct inode *inode, pgoff_t fofs,
+				block_t blkaddr, unsigned int len)
+{
+	if (!f2fs_may_extent_tree(inode))
+		return;
+
+	__update_extent_tree_range(inode, fofs, blkaddr, len, true);
+	stat_inc_read_extent(F2FS_I_SB(inode));
+}
+
 void init_extent_cache_info(struct f2fs_sb_info *sbi)
 {
 	INIT_RADIX_TREE(&sbi->extent_tree_root, GFP_NOIO);
@@ -24,12 +24,38 @@
 #include "gc.h"
 #include <trace/events/f2fs.h>
 
+/*
+ * Trim the next batch of free space in an idle window, so discards are not
+ * issued from the checkpoints that writers wait on.
+ */
+static void gc_idle_trim(struct f2fs_sb_info *sbi,
+				struct f2fs_gc_kthread *gc_th)
+{
+	struct fstrim_range range;
+
+	if (!sbi->discard_blks ||
+			!blk_queue_discard(bdev_get_queue(sbi->sb->s_bdev)))
+		return;
+
+	if (gc_th->trim_cursor < MAIN_BLKADDR(sbi) ||
+			gc_th->trim_cursor >= MAX_BLKADDR(sbi))
+		gc_th->trim_cursor = MAIN_BLKADDR(sbi);
+
+	range.start = F2FS_BLK_TO_BYTES((u64)gc_th->trim_cursor);
+	range.len = F2FS_BLK_TO_BYTES((u64)BATCHED_TRIM_BLOCKS(sbi));
+	range.minlen = 0;
+	f2fs_trim_fs(sbi, &range);
+
+	gc_th->trim_cursor += BATCHED_TRIM_BLOCKS(sbi);
+}
+
 static int gc_thread_func(void *data)
 {
 	struct f2fs_sb_info *sbi = data;
 	struct f2fs_gc_kthread *gc_th = sbi->gc_thread;
 	wait_queue_head_t *wq = &sbi->gc_thread->gc_wait_queue_head;
 	long wait_ms;
+	int urgency;
 
 	wait_ms = gc_th->min_sleep_time;
 
@@ -38,8 +64,10 @@ static int gc_thread_func(void *data)
 			continue;
 		else
 			wait_event_interruptible_timeout(*wq,
-						kthread_should_stop(),
+						kthread_should_stop() ||
+						gc_th->gc_wake,
 						msecs_to_jiffies(wait_ms));
+		gc_th->gc_wake = 0;
 		if (kthread_should_stop())
 			break;
 
@@ -64,22 +92,39 @@ static int gc_thread_func(void *data)
 		if (!mutex_trylock(&sbi->gc_mutex))
 			continue;
 
+		/*
+		 * In an idle window, or when free sections run so low that
+		 * writers would soon have to do FG_GC, don't wait for the
+		 * device to be idle.
+		 */
+		urgency = gc_urgency(sbi, gc_th);
+		if (gc_th->gc_urgent || urgency == 2) {
+			wait_ms = gc_th->urgent_sleep_time;
+			goto do_gc;
+		}
+
 		if (!is_idle(sbi)) {
 			increase_sleep_time(gc_th, &wait_ms);
 			mutex_unlock(&sbi->gc_mutex);
 			continue;
 		}
 
-		if (has_enough_invalid_blocks(sbi))
+		if (urgency)
+			wait_ms = gc_th->min_sleep_time;
+		else if (has_enough_invalid_blocks(sbi))
 			decrease_sleep_time(gc_th, &wait_ms);
 		else
 			increase_sleep_time(gc_th, &wait_ms);
-
+do_gc:
 		stat_inc_bggc_count(sbi);
 
 		/* if return value is not zero, no victim was selected */
 		if (f2fs_gc(sbi, test_opt(sbi, FORCE_FG_GC)))
-			wait_ms = gc_th->no_gc_sleep_time;
+			wait_ms = gc_th->gc_urgent ? gc_th->max_sleep_time :
+						gc_th->no_gc_sleep_time;
+
+		if (gc_th->gc_urgent)
+			gc_idle_trim(sbi, gc_th);
 
 		trace_f2fs_background_gc(sbi->sb, wait_ms,
 				prefree_segments(sbi), free_segments(sbi));
@@ -108,6 +153,11 @@ int start_gc_thread(struct f2fs_sb_info *sbi)
 	gc_th->no_gc_sleep_time = DEF_GC_THREAD_NOGC_SLEEP_TIME;
 
 	gc_th->gc_idle = 0;
+	gc_th->gc_urgent = 0;
+	gc_th->gc_wake = 0;
+	gc_th->urgent_sleep_time = DEF_GC_THREAD_URGENT_SLEEP_TIME;
+	gc_th->urgent_free_secs = DEF_GC_URGENT_FREE_SECS;
+	gc_th->trim_cursor = 0;
 
 	sbi->gc_thread = gc_th;
 	init_waitqueue_head(&sbi->gc_thread->gc_wait_queue_head);
@@ -233,6 +283,20 @@ static unsigned int get_cb_cost(struct f2fs_sb_info *sbi, unsigned int segno)
 	return UINT_MAX - ((100 * (100 - u) * age) / (100 + u));
 }
 
+static bool sec_is_young(struct f2fs_sb_info *sbi, unsigned int segno,
+			unsigned long long now)
+{
+	unsigned int start = GET_SECNO(sbi, segno) * sbi->segs_per_sec;
+	unsigned long long mtime = 0;
+	unsigned int i;
+
+	for (i = 0; i < sbi->segs_per_sec; i++)
+		mtime += get_seg_entry(sbi, start + i)->mtime;
+	mtime = div_u64(mtime, sbi->segs_per_sec);
+
+	return mtime + sbi->gc_age_threshold > now;
+}
+
 static inline unsigned int get_gc_cost(struct f2fs_sb_info *sbi,
 			unsigned int segno, struct victim_sel_policy *p)
 {
@@ -261,6 +325,8 @@ static int get_victim_by_default(struct f2fs_sb_info *sbi,
 	struct victim_sel_policy p;
 	unsigned int secno, max_cost;
 	unsigned int last_segment = MAIN_SEGS(sbi);
+	unsigned long long now = get_mtime(sbi);
+	bool age_check;
 	int nsearched = 0;
 
 	mutex_lock(&dirty_i->seglist_lock);
@@ -274,6 +340,13 @@ static int get_victim_by_default(struct f2fs_sb_info *sbi,
 	if (p.max_search == 0)
 		goto out;
 
+	/*
+	 * Background cleaning has no hurry, so it only considers sections
+	 * that have aged. Foreground cleaning takes whatever is cheapest.
+	 */
+	age_check = p.alloc_mode == LFS && gc_type == BG_GC &&
+			sbi->gc_age_threshold;
+
 	if (p.alloc_mode == LFS && gc_type == FG_GC) {
 		p.min_segno = check_bg_victims(sbi);
 		if (p.min_segno != NULL_SEGNO)
@@ -306,6 +379,11 @@ static int get_victim_by_default(struct f2fs_sb_info *sbi,
 		if (gc_type == BG_GC && test_bit(secno, dirty_i->victim_secmap))
 			continue;
 
+		if (age_check && sec_is_young(sbi, segno, now)) {
+			sbi->gc_stat[p.gc_mode].young++;
+			goto next;
+		}
+
 		cost = get_gc_cost(sbi, segno, &p);
 
 		if (p.min_cost > cost) {
@@ -314,7 +392,7 @@ static int get_victim_by_default(struct f2fs_sb_info *sbi,
 		} else if (unlikely(cost == max_cost)) {
 			continue;
 		}
-
+next:
 		if (nsearched++ >= p.max_search) {
 			sbi->last_victim[p.gc_mode] = segno;
 			break;
@@ -328,6 +406,10 @@ got_it:
 				sbi->cur_victim_sec = secno;
 			else
 				set_bit(secno, dirty_i->victim_secmap);
+
+			sbi->gc_stat[p.gc_mode].victims++;
+			sbi->gc_stat[p.gc_mode].blocks += get_valid_blocks(sbi,
+					p.min_segno, sbi->segs_per_sec);
 		}
 		*result = (p.min_segno / p.ofs_unit) * p.ofs_unit;
 
@@ -717,11 +799,25 @@ next_step:
 
 			/* if encrypted inode, let's go phase 3 */
 			if (f2fs_encrypted_inode(inode) &&
-						S_ISREG(inode->i_mode)) {
+						S_ISREG(inode->i_mode) &&
+					f2fs_get_contents_mode(inode) !=
+					F2FS_ENCRYPTION_MODE_PRIVATE) {
 				add_gc_inode(gc_list, inode);
 				continue;
 			}
 
+			/*
+			 * ICE ciphertext is bound to the block address, so it
+			 * can only move through the page cache, with the key.
+			 */
+			if (f2fs_encrypted_inode(inode) &&
+					S_ISREG(inode->i_mode) &&
+					(f2fs_get_encryption_info(inode) ||
+					 !f2fs_using_hardware_encryption(inode))) {
+				iput(inode);
+				continue;
+			}
+
 			start_bidx = start_bidx_of_node(nofs, F2FS_I(inode));
 			data_page = get_read_data_page(inode,
 					start_bidx + ofs_in_node, READA, true);
@@ -740,7 +836,9 @@ next_step:
 		if (inode) {
 			start_bidx = start_bidx_of_node(nofs, F2FS_I(inode))
 								+ ofs_in_node;
-			if (f2fs_encrypted_inode(inode) && S_ISREG(inode->i_mode))
+			if (f2fs_encrypted_inode(inode) &&
+					S_ISREG(inode->i_mode) &&
+					!f2fs_using_hardware_encryption(inode))
 				move_encrypted_block(inode, start_bidx);
 			else
 				move_data_page(inode, start_bidx, gc_type);
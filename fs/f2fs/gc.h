@@ -16,9 +16,18 @@
 #define DEF_GC_THREAD_MIN_SLEEP_TIME	30000	/* milliseconds */
 #define DEF_GC_THREAD_MAX_SLEEP_TIME	60000
 #define DEF_GC_THREAD_NOGC_SLEEP_TIME	300000	/* wait 5 min */
+#define DEF_GC_THREAD_URGENT_SLEEP_TIME	500	/* 500 ms */
+/* Free sections above the foreground GC threshold before BG_GC hurries */
+#define DEF_GC_URGENT_FREE_SECS		16
 #define LIMIT_INVALID_BLOCK	40 /* percentage over total user space */
 #define LIMIT_FREE_BLOCK	40 /* percentage over invalid + free space */
 
+/*
+ * Sections written more recently than this are left alone by BG_GC, their
+ * blocks are likely to be invalidated soon without having to be moved.
+ */
+#define DEF_GC_AGE_THRESHOLD	600	/* seconds */
+
 /* Search max. number of dirty segments to select a victim segment */
 #define DEF_MAX_VICTIM_SEARCH 4096 /* covers 8GB */
 
@@ -33,6 +42,17 @@ struct f2fs_gc_kthread {
 
 	/* for changing gc mode */
 	unsigned int gc_idle;
+
+	/*
+	 * Set from userspace for idle maintenance windows, e.g. screen off
+	 * and charging: GC runs every urgent_sleep_time without waiting for
+	 * the device to be idle, and free space is trimmed.
+	 */
+	unsigned int gc_urgent;
+	unsigned int gc_wake;
+	unsigned int urgent_sleep_time;
+	unsigned int urgent_free_secs;
+	block_t trim_cursor;
 };
 
 struct gc_inode_list {
@@ -101,6 +121,23 @@ static inline bool has_enough_invalid_blocks(struct f2fs_sb_info *sbi)
 	return false;
 }
 
+/*
+ * Free sections are getting close to the point where writers have to run
+ * FG_GC themselves: 2 when within urgent_free_secs of it, 1 when within
+ * twice that, 0 otherwise.
+ */
+static inline int gc_urgency(struct f2fs_sb_info *sbi,
+				struct f2fs_gc_kthread *gc_th)
+{
+	int margin = gc_th->urgent_free_secs;
+
+	if (has_not_enough_free_secs(sbi, -margin))
+		return 2;
+	if (has_not_enough_free_secs(sbi, -2 * margin))
+		return 1;
+	return 0;
+}
+
 static inline int is_idle(struct f2fs_sb_info *sbi)
 {
 	struct block_device *bdev = sbi->sb->s_bdev;
@@ -158,6 +158,13 @@ static ssize_t f2fs_sbi_store(struct f2fs_attr *a,
 	if (ret < 0)
 		return ret;
 	*ui = t;
+
+	/* start or stop an idle window right away */
+	if (a->struct_type == GC_THREAD &&
+			!strcmp(a->attr.name, "gc_urgent")) {
+		sbi->gc_thread->gc_wake = 1;
+		wake_up_interruptible_all(&sbi->gc_thread->gc_wait_queue_head);
+	}
 	return count;
 }
 
@@ -202,10 +209,44 @@ static struct f2fs_attr f2fs_attr_##_name = {			\
 		f2fs_sbi_show, f2fs_sbi_store,			\
 		offsetof(struct struct_name, elname))
 
+#define F2FS_GENERAL_RO_ATTR(name) \
+static struct f2fs_attr f2fs_attr_##name = __ATTR(name, 0444, name##_show, NULL)
+
+static ssize_t gc_stats_show(struct f2fs_attr *a,
+			struct f2fs_sb_info *sbi, char *buf)
+{
+	static const char * const names[] = {
+		[GC_CB] = "cost-benefit",
+		[GC_GREEDY] = "greedy",
+	};
+	struct dirty_seglist_info *dirty_i = DIRTY_I(sbi);
+	struct f2fs_gc_stat stat[2];
+	ssize_t len = 0;
+	int i;
+
+	mutex_lock(&dirty_i->seglist_lock);
+	memcpy(stat, sbi->gc_stat, sizeof(stat));
+	mutex_unlock(&dirty_i->seglist_lock);
+
+	len += snprintf(buf + len, PAGE_SIZE - len,
+			"policy victims blocks young_skipped\n");
+	for (i = 0; i < ARRAY_SIZE(names); i++)
+		len += snprintf(buf + len, PAGE_SIZE - len,
+				"%s %llu %llu %llu\n", names[i],
+				stat[i].victims, stat[i].blocks,
+				stat[i].young);
+	return len;
+}
+
 F2FS_RW_ATTR(GC_THREAD, f2fs_gc_kthread, gc_min_sleep_time, min_sleep_time);
 F2FS_RW_ATTR(GC_THREAD, f2fs_gc_kthread, gc_max_sleep_time, max_sleep_time);
 F2FS_RW_ATTR(GC_THREAD, f2fs_gc_kthread, gc_no_gc_sleep_time, no_gc_sleep_time);
 F2FS_RW_ATTR(GC_THREAD, f2fs_gc_kthread, gc_idle, gc_idle);
+F2FS_RW_ATTR(GC_THREAD, f2fs_gc_kthread, gc_urgent, gc_urgent);
+F2FS_RW_ATTR(GC_THREAD, f2fs_gc_kthread, gc_urgent_sleep_time,
+						urgent_sleep_time);
+F2FS_RW_ATTR(GC_THREAD, f2fs_gc_kthread, gc_urgent_free_secs,
+						urgent_free_secs);
 F2FS_RW_ATTR(SM_INFO, f2fs_sm_info, reclaim_segments, rec_prefree_segments);
 F2FS_RW_ATTR(SM_INFO, f2fs_sm_info, max_small_discards, max_discards);
 F2FS_RW_ATTR(SM_INFO, f2fs_sm_info, batched_trim_sections, trim_sections);
@@ -215,6 +256,8 @@ F2FS_RW_ATTR(SM_INFO, f2fs_sm_info, min_fsync_blocks, min_fsync_blocks);
 F2FS_RW_ATTR(NM_INFO, f2fs_nm_info, ram_thresh, ram_thresh);
 F2FS_RW_ATTR(NM_INFO, f2fs_nm_info, ra_nid_pages, ra_nid_pages);
 F2FS_RW_ATTR(F2FS_SBI, f2fs_sb_info, max_victim_search, max_victim_search);
+F2FS_RW_ATTR(F2FS_SBI, f2fs_sb_info, gc_age_threshold, gc_age_threshold);
+F2FS_GENERAL_RO_ATTR(gc_stats);
 F2FS_RW_ATTR(F2FS_SBI, f2fs_sb_info, dir_level, dir_level);
 F2FS_RW_ATTR(F2FS_SBI, f2fs_sb_info, cp_interval, cp_interval);
 
@@ -224,6 +267,9 @@ static struct attribute *f2fs_attrs[] = {
 	ATTR_LIST(gc_max_sleep_time),
 	ATTR_LIST(gc_no_gc_sleep_time),
 	ATTR_LIST(gc_idle),
+	ATTR_LIST(gc_urgent),
+	ATTR_LIST(gc_urgent_sleep_time),
+	ATTR_LIST(gc_urgent_free_secs),
 	ATTR_LIST(reclaim_segments),
 	ATTR_LIST(max_small_discards),
 	ATTR_LIST(batched_trim_sections),
@@ -231,6 +277,8 @@ static struct attribute *f2fs_attrs[] = {
 	ATTR_LIST(min_ipu_util),
 	ATTR_LIST(min_fsync_blocks),
 	ATTR_LIST(max_victim_search),
+	ATTR_LIST(gc_age_threshold),
+	ATTR_LIST(gc_stats),
 	ATTR_LIST(dir_level),
 	ATTR_LIST(ram_thresh),
 	ATTR_LIST(ra_nid_pages),
@@ -567,6 +615,8 @@ static void f2fs_put_super(struct super_block *sb)
 
 	sb->s_fs_info = NULL;
 	brelse(sbi->raw_super_buf);
+	if (sbi->s_chksum_driver)
+		crypto_free_shash(sbi->s_chksum_driver);
 	kfree(sbi);
 }
 
@@ -1242,6 +1292,7 @@ static void init_sb_info(struct f2fs_sb_info *sbi)
 	sbi->meta_ino_num = le32_to_cpu(raw_super->meta_ino);
 	sbi->cur_victim_sec = NULL_SECNO;
 	sbi->max_victim_search = DEF_MAX_VICTIM_SEARCH;
+	sbi->gc_age_threshold = DEF_GC_AGE_THRESHOLD;
 
 	for (i = 0; i < NR_COUNT_TYPE; i++)
 		atomic_set(&sbi->nr_pages[i], 0);
@@ -1379,6 +1430,15 @@ try_onemore:
 		goto free_sbi;
 	}
 
+	/* Load the checksum driver */
+	sbi->s_chksum_driver = crypto_alloc_shash("crc32", 0, 0);
+	if (IS_ERR(sbi->s_chksum_driver)) {
+		f2fs_msg(sb, KERN_ERR, "Cannot load crc32 driver.");
+		err = PTR_ERR(sbi->s_chksum_driver);
+		sbi->s_chksum_driver = NULL;
+		goto free_sbi;
+	}
+
 	err = read_raw_super_block(sb, &raw_super, &raw_super_buf, &recovery);
 	if (err)
 		goto free_sbi;
@@ -1623,6 +1683,8 @@ free_options:
 free_sb_buf:
 	brelse(raw_super_buf);
 free_sbi:
+	if (sbi->s_chksum_driver)
+		crypto_free_shash(sbi->s_chksum_driver);
 	kfree(sbi);
 
 	/* give only one another chance */
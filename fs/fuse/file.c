@@ -536,6 +536,12 @@ out:
 static int fuse_fsync(struct file *file, loff_t start, loff_t end,
 		      int datasync)
 {
+	struct fuse_file *ff = file->private_data;
+
+	/* The data only ever went to the lower file */
+	if (ff && ff->passthrough_enabled && ff->passthrough_filp)
+		return fuse_passthrough_fsync(file, start, end, datasync);
+
 	return fuse_fsync_common(file, start, end, datasync, 0);
 }
 
@@ -2155,6 +2161,9 @@ static int fuse_file_mmap(struct file *file, struct vm_area_struct *vma)
 {
 	struct fuse_file *ff = file->private_data;
 
+	if (ff->passthrough_enabled && ff->passthrough_filp)
+		return fuse_passthrough_mmap(file, vma);
+
 	ff->passthrough_enabled = 0;
 	if ((vma->vm_flags & VM_SHARED) && (vma->vm_flags & VM_MAYWRITE))
 		fuse_link_write_file(file);
@@ -3063,6 +3072,18 @@ out:
 	return err;
 }
 
+static ssize_t fuse_file_splice_read(struct file *in, loff_t *ppos,
+				     struct pipe_inode_info *pipe, size_t len,
+				     unsigned int flags)
+{
+	struct fuse_file *ff = in->private_data;
+
+	if (ff && ff->passthrough_enabled && ff->passthrough_filp)
+		return fuse_passthrough_splice_read(in, ppos, pipe, len, flags);
+
+	return generic_file_splice_read(in, ppos, pipe, len, flags);
+}
+
 static const struct file_operations fuse_file_operations = {
 	.llseek		= fuse_file_llseek,
 	.read_iter	= fuse_file_read_iter,
@@ -3074,7 +3095,7 @@ static const struct file_operations fuse_file_operations = {
 	.fsync		= fuse_fsync,
 	.lock		= fuse_file_lock,
 	.flock		= fuse_file_flock,
-	.splice_read	= generic_file_splice_read,
+	.splice_read	= fuse_file_splice_read,
 	.unlocked_ioctl	= fuse_file_ioctl,
 	.compat_ioctl	= fuse_file_compat_ioctl,
 	.poll		= fuse_file_poll,
@@ -121,6 +121,75 @@ ssize_t fuse_passthrough_write_iter(struct kiocb *iocb, struct iov_iter *from)
 	return fuse_passthrough_read_write_iter(iocb, from, 1);
 }
 
+/*
+ * Map the lower file instead of the fuse one, so faults are served from the
+ * lower page cache, which the passthrough reads and writes use as well.
+ */
+int fuse_passthrough_mmap(struct file *file, struct vm_area_struct *vma)
+{
+	int ret;
+	struct fuse_file *ff = file->private_data;
+	struct file *passthrough_filp = ff->passthrough_filp;
+
+	if (!passthrough_filp->f_op->mmap)
+		return -ENODEV;
+
+	if (WARN_ON(file != vma->vm_file))
+		return -EIO;
+
+	vma->vm_file = get_file(passthrough_filp);
+	ret = passthrough_filp->f_op->mmap(passthrough_filp, vma);
+	if (ret) {
+		/* mmap_region() drops its own reference on the fuse file */
+		vma->vm_file = file;
+		fput(passthrough_filp);
+		return ret;
+	}
+
+	/* The reference the vma held on the fuse file now goes to the lower */
+	fput(file);
+	fsstack_copy_attr_atime(file_inode(file), file_inode(passthrough_filp));
+
+	return 0;
+}
+
+ssize_t fuse_passthrough_splice_read(struct file *in, loff_t *ppos,
+				     struct pipe_inode_info *pipe, size_t len,
+				     unsigned int flags)
+{
+	ssize_t ret_val;
+	struct fuse_file *ff = in->private_data;
+	struct file *passthrough_filp = ff->passthrough_filp;
+
+	if (!passthrough_filp->f_op->splice_read)
+		return -EINVAL;
+
+	/* lock passthrough file to prevent it from being released */
+	get_file(passthrough_filp);
+	ret_val = passthrough_filp->f_op->splice_read(passthrough_filp, ppos,
+						      pipe, len, flags);
+	if (ret_val >= 0)
+		fsstack_copy_attr_atime(file_inode(in),
+					file_inode(passthrough_filp));
+	fput(passthrough_filp);
+
+	return ret_val;
+}
+
+int fuse_passthrough_fsync(struct file *file, loff_t start, loff_t end,
+			   int datasync)
+{
+	int ret_val;
+	struct fuse_file *ff = file->private_data;
+	struct file *passthrough_filp = ff->passthrough_filp;
+
+	get_file(passthrough_filp);
+	ret_val = vfs_fsync_range(passthrough_filp, start, end, datasync);
+	fput(passthrough_filp);
+
+	return ret_val;
+}
+
 void fuse_passthrough_release(struct fuse_file *ff)
 {
 	if (!(ff->passthrough_filp))
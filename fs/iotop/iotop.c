@@ -121,6 +121,175 @@ static void show_iotop(void)
 		pr_info("[IOTOP] WRITE total %u tasks, %llu KB\n", task_cnt, total_bytes / 1024);
 }
 
+#ifdef CONFIG_IOTOP_LATENCY
+/*
+ * Per task, per block device latency histograms, from submit_bio() to
+ * bio_endio(). The slot is looked up at submission in process context
+ * and remembered in the bio, so completion only has to bump counters.
+ * The table is fixed size; readers are expected to clear it by writing
+ * to /proc/iotop_latency after reading.
+ */
+static bool iotop_lat_enabled = true;
+module_param_named(latency, iotop_lat_enabled, bool, 0644);
+
+static struct iotop_lat iotop_lat_tbl[IOTOP_LAT_ENTRIES];
+static DEFINE_HASHTABLE(iotop_lat_hash, IOTOP_LAT_HASH_BITS);
+static DEFINE_SPINLOCK(iotop_lat_lock);
+static unsigned int iotop_lat_used;
+static u64 iotop_lat_dropped;
+
+static int iotop_lat_bucket(u64 ns)
+{
+	u32 us = min_t(u64, div_u64(ns, NSEC_PER_USEC), U32_MAX);
+	int b;
+
+	if (us < (1U << IOTOP_LAT_SHIFT))
+		return 0;
+
+	b = ilog2(us) - IOTOP_LAT_SHIFT + 1;
+	return min(b, IOTOP_LAT_BUCKETS - 1);
+}
+
+static int iotop_lat_slot(struct task_struct *p, dev_t dev)
+{
+	u32 key = p->pid ^ dev;
+	struct iotop_lat *e;
+
+	hash_for_each_possible(iotop_lat_hash, e, node, key) {
+		if (e->rec.pid == p->pid && e->rec.dev == dev)
+			return e - iotop_lat_tbl;
+	}
+
+	if (iotop_lat_used == IOTOP_LAT_ENTRIES)
+		return -1;
+
+	e = &iotop_lat_tbl[iotop_lat_used++];
+	memset(&e->rec, 0, sizeof(e->rec));
+	e->used = true;
+	e->rec.pid = p->pid;
+	e->rec.tgid = p->tgid;
+	e->rec.dev = dev;
+	snprintf(e->rec.comm, sizeof(e->rec.comm), "%s", p->comm);
+	hash_add(iotop_lat_hash, &e->node, key);
+
+	return e - iotop_lat_tbl;
+}
+
+void iotop_bio_submit(struct bio *bio)
+{
+	unsigned long flags;
+	int slot;
+
+	bio->bi_iotop_start = 0;
+	if (!iotop_lat_enabled || !bio->bi_bdev)
+		return;
+
+	spin_lock_irqsave(&iotop_lat_lock, flags);
+	slot = iotop_lat_slot(current, bio->bi_bdev->bd_dev);
+	if (slot < 0)
+		iotop_lat_dropped++;
+	spin_unlock_irqrestore(&iotop_lat_lock, flags);
+
+	if (slot < 0)
+		return;
+
+	bio->bi_iotop_pid = current->pid;
+	bio->bi_iotop_slot = slot;
+	bio->bi_iotop_start = ktime_get_ns();
+}
+
+void iotop_bio_done(struct bio *bio)
+{
+	struct iotop_lat_record *rec;
+	unsigned long flags;
+	int rw = bio_data_dir(bio);
+	u64 ns;
+
+	if (!bio->bi_iotop_start)
+		return;
+
+	ns = ktime_get_ns() - bio->bi_iotop_start;
+	bio->bi_iotop_start = 0;
+
+	spin_lock_irqsave(&iotop_lat_lock, flags);
+	rec = &iotop_lat_tbl[bio->bi_iotop_slot].rec;
+	/* The table may have been cleared while the bio was in flight */
+	if (iotop_lat_tbl[bio->bi_iotop_slot].used &&
+	    rec->pid == bio->bi_iotop_pid) {
+		rec->count[rw][iotop_lat_bucket(ns)]++;
+		rec->total_ns[rw] += ns;
+	}
+	spin_unlock_irqrestore(&iotop_lat_lock, flags);
+}
+
+static int iotop_lat_show(struct seq_file *m, void *v)
+{
+	struct iotop_lat_header hdr = {
+		.magic = IOTOP_LAT_MAGIC,
+		.version = IOTOP_LAT_VERSION,
+		.nr_buckets = IOTOP_LAT_BUCKETS,
+		.bucket_shift = IOTOP_LAT_SHIFT,
+		.record_size = sizeof(struct iotop_lat_record),
+	};
+	unsigned long flags;
+	unsigned int i;
+
+	spin_lock_irqsave(&iotop_lat_lock, flags);
+	hdr.nr_records = iotop_lat_used;
+	hdr.dropped = iotop_lat_dropped;
+	seq_write(m, &hdr, sizeof(hdr));
+	for (i = 0; i < iotop_lat_used; i++)
+		seq_write(m, &iotop_lat_tbl[i].rec, sizeof(iotop_lat_tbl[i].rec));
+	spin_unlock_irqrestore(&iotop_lat_lock, flags);
+
+	return 0;
+}
+
+static int iotop_lat_open(struct inode *inode, struct file *file)
+{
+	return single_open_size(file, iotop_lat_show, NULL,
+		sizeof(struct iotop_lat_header) +
+		IOTOP_LAT_ENTRIES * sizeof(struct iotop_lat_record));
+}
+
+static ssize_t iotop_lat_write(struct file *file, const char __user *buf,
+		size_t count, loff_t *ppos)
+{
+	unsigned long flags;
+	unsigned int i;
+
+	spin_lock_irqsave(&iotop_lat_lock, flags);
+	for (i = 0; i < iotop_lat_used; i++) {
+		hash_del(&iotop_lat_tbl[i].node);
+		iotop_lat_tbl[i].used = false;
+	}
+	iotop_lat_used = 0;
+	iotop_lat_dropped = 0;
+	spin_unlock_irqrestore(&iotop_lat_lock, flags);
+
+	return count;
+}
+
+static const struct file_operations iotop_lat_fops = {
+	.open		= iotop_lat_open,
+	.read		= seq_read,
+	.write		= iotop_lat_write,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static void iotop_lat_init(void)
+{
+	if (!proc_create("iotop_latency", S_IRUSR | S_IWUSR, NULL,
+			 &iotop_lat_fops))
+		pr_info("IOTOP: create /proc/iotop_latency failed!\n");
+}
+#else
+static inline void iotop_lat_init(void)
+{
+}
+#endif
+
 static int iotop_pull_thread(void *d)
 {
 	while(!kthread_should_stop())
@@ -141,6 +310,8 @@ static int __init iotop_init(void)
 {
 	pr_info("IOTOP: module init.\n");
 
+	iotop_lat_init();
+
 	_task = kthread_run(iotop_pull_thread, NULL, "iotop_fn");
 	if (IS_ERR(_task)) {
 		pr_info("IOTOP: create kthread failed!\n");
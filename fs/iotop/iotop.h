@@ -17,6 +17,12 @@
 #include <linux/kthread.h>
 #include <linux/time.h>
 #include <linux/delay.h>
+#include <linux/bio.h>
+#include <linux/hashtable.h>
+#include <linux/ktime.h>
+#include <linux/log2.h>
+#include <linux/proc_fs.h>
+#include <linux/seq_file.h>
 
 #define IOTOP_INTERVAL			4500
 #define IOREAD_DUMP_THRESHOLD		10485760 /* 10MB */
@@ -35,6 +41,50 @@ struct io_account {
 	struct list_head list;
 };
 
+#ifdef CONFIG_IOTOP_LATENCY
+/*
+ * Binary layout of /proc/iotop_latency, in native byte order: one
+ * iotop_lat_header followed by nr_records records of record_size bytes.
+ * Bucket 0 counts bios that completed within 2^bucket_shift us, bucket b
+ * those within [2^(bucket_shift + b - 1), 2^(bucket_shift + b)) us, and
+ * the last bucket everything slower.
+ */
+#define IOTOP_LAT_MAGIC			0x544c4f49 /* "IOLT" */
+#define IOTOP_LAT_VERSION		1
+#define IOTOP_LAT_BUCKETS		16
+#define IOTOP_LAT_SHIFT			6
+#define IOTOP_LAT_ENTRIES		256
+#define IOTOP_LAT_HASH_BITS		6
+
+struct iotop_lat_header {
+	u32 magic;
+	u16 version;
+	u16 nr_buckets;
+	u32 bucket_shift;
+	u32 record_size;
+	u32 nr_records;
+	u32 reserved;
+	/* bios not recorded because the table was full */
+	u64 dropped;
+};
+
+struct iotop_lat_record {
+	/* summed latency of the reads and writes, in ns */
+	u64 total_ns[2];
+	u32 pid;
+	u32 tgid;
+	u32 dev;
+	char comm[TASK_COMM_LEN];
+	u32 count[2][IOTOP_LAT_BUCKETS];
+};
+
+struct iotop_lat {
+	struct hlist_node node;
+	bool used;
+	struct iotop_lat_record rec;
+};
+#endif
+
 static LIST_HEAD(ioread_list);
 static LIST_HEAD(iowrite_list);
 static spinlock_t iolist_lock;
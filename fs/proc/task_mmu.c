@@ -16,6 +16,8 @@
 #include <linux/page_idle.h>
 #include <linux/mm_inline.h>
 #include <linux/ctype.h>
+#include <linux/proc_fs.h>
+#include <linux/vmalloc.h>
 
 #include <asm/elf.h>
 #include <asm/uaccess.h>
@@ -705,22 +707,30 @@ static int smaps_hugetlb_range(pte_t *pte, unsigned long hmask,
 }
 #endif /* HUGETLB_PAGE */
 
-static int show_smap(struct seq_file *m, void *v, int is_pid)
+/* Adds the pages of @vma to @mss, which may already hold other VMAs */
+static void smap_gather_stats(struct vm_area_struct *vma,
+			      struct mem_size_stats *mss)
 {
-	struct vm_area_struct *vma = v;
-	struct mem_size_stats mss;
 	struct mm_walk smaps_walk = {
 		.pmd_entry = smaps_pte_range,
 #ifdef CONFIG_HUGETLB_PAGE
 		.hugetlb_entry = smaps_hugetlb_range,
 #endif
 		.mm = vma->vm_mm,
-		.private = &mss,
+		.private = mss,
 	};
 
+	walk_page_vma(vma, &smaps_walk);
+}
+
+static int show_smap(struct seq_file *m, void *v, int is_pid)
+{
+	struct vm_area_struct *vma = v;
+	struct mem_size_stats mss;
+
 	memset(&mss, 0, sizeof mss);
 	/* mmap_sem is held in m_start */
-	walk_page_vma(vma, &smaps_walk);
+	smap_gather_stats(vma, &mss);
 
 	show_map_vma(m, vma, is_pid);
 
@@ -820,6 +830,272 @@ const struct file_operations proc_tid_smaps_operations = {
 	.release	= proc_map_release,
 };
 
+/*
+ * Totals of every VMA of @mm, the PSS of locked VMAs going to *@locked.
+ * Returns the end of the last VMA.
+ */
+static unsigned long smap_gather_mm(struct mm_struct *mm,
+				    struct mem_size_stats *mss, u64 *locked)
+{
+	struct vm_area_struct *vma;
+	unsigned long last_end = 0;
+	u64 pss;
+
+	memset(mss, 0, sizeof(*mss));
+	*locked = 0;
+
+	down_read(&mm->mmap_sem);
+	for (vma = mm->mmap; vma; vma = vma->vm_next) {
+		pss = mss->pss;
+		smap_gather_stats(vma, mss);
+		if (vma->vm_flags & VM_LOCKED)
+			*locked += mss->pss - pss;
+		last_end = vma->vm_end;
+	}
+	up_read(&mm->mmap_sem);
+
+	return last_end;
+}
+
+/*
+ * /proc/PID/smaps_rollup: the sums of all the smaps entries of a process,
+ * for callers that only want the totals and not one record per VMA.
+ */
+static int show_smaps_rollup(struct seq_file *m, void *v)
+{
+	struct proc_maps_private *priv = m->private;
+	struct mm_struct *mm = priv->mm;
+	struct mem_size_stats mss;
+	unsigned long start, end;
+	u64 locked;
+
+	if (!mm || !atomic_inc_not_zero(&mm->mm_users))
+		return 0;
+
+	end = smap_gather_mm(mm, &mss, &locked);
+	start = mm->mmap ? mm->mmap->vm_start : 0;
+	mmput(mm);
+
+	seq_setwidth(m, 25 + sizeof(void *) * 6 - 1);
+	seq_printf(m, "%08lx-%08lx ---p 00000000 00:00 0", start, end);
+	seq_pad(m, ' ');
+	seq_puts(m, "[rollup]\n");
+
+	seq_printf(m,
+		   "Rss:            %8lu kB\n"
+		   "Pss:            %8lu kB\n"
+		   "Shared_Clean:   %8lu kB\n"
+		   "Shared_Dirty:   %8lu kB\n"
+		   "Private_Clean:  %8lu kB\n"
+		   "Private_Dirty:  %8lu kB\n"
+		   "Referenced:     %8lu kB\n"
+		   "Anonymous:      %8lu kB\n"
+		   "AnonHugePages:  %8lu kB\n"
+		   "Shared_Hugetlb: %8lu kB\n"
+		   "Private_Hugetlb: %7lu kB\n"
+		   "Swap:           %8lu kB\n"
+		   "SwapPss:        %8lu kB\n"
+		   "Locked:         %8lu kB\n",
+		   mss.resident >> 10,
+		   (unsigned long)(mss.pss >> (10 + PSS_SHIFT)),
+		   mss.shared_clean  >> 10,
+		   mss.shared_dirty  >> 10,
+		   mss.private_clean >> 10,
+		   mss.private_dirty >> 10,
+		   mss.referenced >> 10,
+		   mss.anonymous >> 10,
+		   mss.anonymous_thp >> 10,
+		   mss.shared_hugetlb >> 10,
+		   mss.private_hugetlb >> 10,
+		   mss.swap >> 10,
+		   (unsigned long)(mss.swap_pss >> (10 + PSS_SHIFT)),
+		   (unsigned long)(locked >> (10 + PSS_SHIFT)));
+	return 0;
+}
+
+static int smaps_rollup_open(struct inode *inode, struct file *file)
+{
+	struct proc_maps_private *priv;
+	int ret;
+
+	priv = kzalloc(sizeof(*priv), GFP_KERNEL);
+	if (!priv)
+		return -ENOMEM;
+
+	ret = single_open(file, show_smaps_rollup, priv);
+	if (ret)
+		goto out_free;
+
+	priv->inode = inode;
+	priv->mm = proc_mem_open(inode, PTRACE_MODE_READ);
+	if (IS_ERR(priv->mm)) {
+		ret = PTR_ERR(priv->mm);
+		single_release(inode, file);
+		goto out_free;
+	}
+	return 0;
+
+out_free:
+	kfree(priv);
+	return ret;
+}
+
+static int smaps_rollup_release(struct inode *inode, struct file *file)
+{
+	struct seq_file *seq = file->private_data;
+	struct proc_maps_private *priv = seq->private;
+
+	if (priv->mm)
+		mmdrop(priv->mm);
+	kfree(priv);
+	return single_release(inode, file);
+}
+
+const struct file_operations proc_pid_smaps_rollup_operations = {
+	.open		= smaps_rollup_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= smaps_rollup_release,
+};
+
+/*
+ * /proc/mem_summary: write a list of pids, then read back one line per
+ * pid with its Rss, Pss, Swap and SwapPss in kB. Pids that are gone or
+ * that the reader may not inspect are left out. A memory tracker polling
+ * every process does one write and one read instead of an open, read and
+ * close of smaps_rollup per process.
+ */
+#define MEM_SUMMARY_MAX_PIDS	1024
+
+struct mem_summary {
+	struct mutex lock;
+	unsigned int nr_pids;
+	pid_t pids[MEM_SUMMARY_MAX_PIDS];
+};
+
+static void mem_summary_show_pid(struct seq_file *m, pid_t nr)
+{
+	struct task_struct *task;
+	struct mem_size_stats mss;
+	struct mm_struct *mm;
+	u64 locked;
+
+	rcu_read_lock();
+	task = pid_task(find_vpid(nr), PIDTYPE_PID);
+	if (task)
+		get_task_struct(task);
+	rcu_read_unlock();
+	if (!task)
+		return;
+
+	mm = mm_access(task, PTRACE_MODE_READ_FSCREDS);
+	put_task_struct(task);
+	if (IS_ERR_OR_NULL(mm))
+		return;
+
+	smap_gather_mm(mm, &mss, &locked);
+	mmput(mm);
+
+	seq_printf(m, "%d %lu %lu %lu %lu\n", nr, mss.resident >> 10,
+		   (unsigned long)(mss.pss >> (10 + PSS_SHIFT)),
+		   mss.swap >> 10,
+		   (unsigned long)(mss.swap_pss >> (10 + PSS_SHIFT)));
+}
+
+static int mem_summary_show(struct seq_file *m, void *v)
+{
+	struct mem_summary *ms = m->private;
+	unsigned int i;
+
+	mutex_lock(&ms->lock);
+	for (i = 0; i < ms->nr_pids; i++) {
+		mem_summary_show_pid(m, ms->pids[i]);
+		cond_resched();
+	}
+	mutex_unlock(&ms->lock);
+	return 0;
+}
+
+static ssize_t mem_summary_write(struct file *file, const char __user *buf,
+				 size_t count, loff_t *ppos)
+{
+	struct seq_file *seq = file->private_data;
+	struct mem_summary *ms = seq->private;
+	char *kbuf, *p, *tok;
+	unsigned int nr = 0;
+	int pid, ret = 0;
+
+	if (count >= PAGE_SIZE * 2)
+		return -EINVAL;
+
+	kbuf = kmalloc(count + 1, GFP_KERNEL);
+	if (!kbuf)
+		return -ENOMEM;
+	if (copy_from_user(kbuf, buf, count)) {
+		kfree(kbuf);
+		return -EFAULT;
+	}
+	kbuf[count] = '\0';
+
+	mutex_lock(&ms->lock);
+	p = kbuf;
+	while ((tok = strsep(&p, " \t\n,")) != NULL) {
+		if (!*tok)
+			continue;
+		if (nr == MEM_SUMMARY_MAX_PIDS || kstrtoint(tok, 10, &pid) ||
+		    pid <= 0) {
+			ret = -EINVAL;
+			break;
+		}
+		ms->pids[nr++] = pid;
+	}
+	ms->nr_pids = ret ? 0 : nr;
+	mutex_unlock(&ms->lock);
+
+	kfree(kbuf);
+	return ret ? ret : count;
+}
+
+static int mem_summary_open(struct inode *inode, struct file *file)
+{
+	struct mem_summary *ms;
+	int ret;
+
+	ms = vzalloc(sizeof(*ms));
+	if (!ms)
+		return -ENOMEM;
+	mutex_init(&ms->lock);
+
+	ret = single_open(file, mem_summary_show, ms);
+	if (ret)
+		vfree(ms);
+	return ret;
+}
+
+static int mem_summary_release(struct inode *inode, struct file *file)
+{
+	struct seq_file *seq = file->private_data;
+
+	vfree(seq->private);
+	return single_release(inode, file);
+}
+
+static const struct file_operations proc_mem_summary_operations = {
+	.open		= mem_summary_open,
+	.read		= seq_read,
+	.write		= mem_summary_write,
+	.llseek		= seq_lseek,
+	.release	= mem_summary_release,
+};
+
+static int __init proc_mem_summary_init(void)
+{
+	proc_create("mem_summary", S_IRUGO | S_IWUGO, NULL,
+		    &proc_mem_summary_operations);
+	return 0;
+}
+fs_initcall(proc_mem_summary_init);
+
 enum clear_refs_types {
 	CLEAR_REFS_ALL = 1,
 	CLEAR_REFS_ANON,
@@ -1429,6 +1705,62 @@ const struct file_operations proc_pagemap_operations = {
 #endif /* CONFIG_PROC_PAGE_MONITOR */
 
 #ifdef CONFIG_PROCESS_RECLAIM
+/*
+ * Hot/cold check for idle-only reclaim. A page referenced since it was
+ * marked idle is hot: it is marked again to start a new window, and the
+ * access is handed to page reclaim through the young flag like
+ * page_idle does.
+ */
+static bool reclaim_page_idle(struct vm_area_struct *vma, unsigned long addr,
+			pte_t *pte, struct page *page, struct reclaim_param *rp)
+{
+	if (ptep_clear_young_notify(vma, addr, pte)) {
+		clear_page_idle(page);
+		set_page_young(page);
+	}
+
+	if (page_is_idle(page)) {
+		rp->nr_idle++;
+		return true;
+	}
+
+	rp->nr_hot++;
+	set_page_idle(page);
+	return false;
+}
+
+static int idle_mark_pte_range(pmd_t *pmd, unsigned long addr,
+				unsigned long end, struct mm_walk *walk)
+{
+	struct reclaim_param *rp = walk->private;
+	struct vm_area_struct *vma = rp->vma;
+	pte_t *pte, ptent;
+	spinlock_t *ptl;
+	struct page *page;
+
+	split_huge_page_pmd(vma, addr, pmd);
+	if (pmd_trans_unstable(pmd))
+		return 0;
+
+	pte = pte_offset_map_lock(vma->vm_mm, pmd, addr, &ptl);
+	for (; addr != end; pte++, addr += PAGE_SIZE) {
+		ptent = *pte;
+		if (!pte_present(ptent))
+			continue;
+
+		page = vm_normal_page(vma, addr, ptent);
+		if (!page || !PageLRU(page))
+			continue;
+
+		if (ptep_clear_young_notify(vma, addr, pte))
+			set_page_young(page);
+		set_page_idle(page);
+	}
+	pte_unmap_unlock(pte - 1, ptl);
+	cond_resched();
+	return 0;
+}
+
 static int reclaim_pte_range(pmd_t *pmd, unsigned long addr,
 				unsigned long end, struct mm_walk *walk)
 {
@@ -1456,6 +1788,10 @@ cont:
 		if (!page)
 			continue;
 
+		if (rp->idle_only &&
+		    !reclaim_page_idle(vma, addr, pte, page, rp))
+			continue;
+
 		if (isolate_lru_page(page))
 			continue;
 
@@ -1488,16 +1824,81 @@ enum reclaim_type {
 	RECLAIM_RANGE,
 };
 
+static void walk_task_anon(struct mm_struct *mm, struct reclaim_param *rp,
+		int (*pmd_entry)(pmd_t *, unsigned long, unsigned long,
+				 struct mm_walk *))
+{
+	struct vm_area_struct *vma;
+	struct mm_walk reclaim_walk = {};
+
+	reclaim_walk.mm = mm;
+	reclaim_walk.pmd_entry = pmd_entry;
+	reclaim_walk.private = rp;
+
+	for (vma = mm->mmap; vma; vma = vma->vm_next) {
+		if (is_vm_hugetlb_page(vma))
+			continue;
+
+		if (vma->vm_file)
+			continue;
+
+		if (vma->vm_flags & VM_LOCKED)
+			continue;
+
+		if (!rp->nr_to_reclaim)
+			break;
+
+		rp->vma = vma;
+		walk_page_range(vma->vm_start, vma->vm_end,
+			&reclaim_walk);
+	}
+}
+
+/*
+ * Like reclaim_task_anon(), but only reclaim anon pages that have not been
+ * referenced since the task was last marked idle, at least @min_idle
+ * jiffies ago. The first call for an mm only marks its pages; referenced
+ * pages found during reclaim are marked again for the next window.
+ */
+struct reclaim_param reclaim_task_idle_anon(struct task_struct *task,
+		int nr_to_reclaim, unsigned long min_idle)
+{
+	struct mm_struct *mm;
+	struct reclaim_param rp = {
+		.idle_only = true,
+	};
+
+	get_task_struct(task);
+	mm = get_task_mm(task);
+	if (!mm)
+		goto out;
+
+	down_read(&mm->mmap_sem);
+	if (!mm->reclaim_idle_mark) {
+		rp.nr_to_reclaim = INT_MAX;
+		walk_task_anon(mm, &rp, idle_mark_pte_range);
+		mm->reclaim_idle_mark = jiffies;
+	} else if (time_after_eq(jiffies, mm->reclaim_idle_mark + min_idle)) {
+		rp.nr_to_reclaim = nr_to_reclaim;
+		walk_task_anon(mm, &rp, reclaim_pte_range);
+		mm->reclaim_idle_mark = jiffies;
+	}
+	flush_tlb_mm(mm);
+	up_read(&mm->mmap_sem);
+	mmput(mm);
+out:
+	put_task_struct(task);
+	return rp;
+}
+
 struct reclaim_param reclaim_task_anon(struct task_struct *task,
 		int nr_to_reclaim)
 {
 	struct mm_struct *mm;
 	struct vm_area_struct *vma;
 	struct mm_walk reclaim_walk = {};
-	struct reclaim_param rp;
+	struct reclaim_param rp = {};
 
-	rp.nr_reclaimed = 0;
-	rp.nr_scanned = 0;
 	get_task_struct(task);
 	mm = get_task_mm(task);
 	if (!mm)
@@ -1548,7 +1949,7 @@ static ssize_t reclaim_write(struct file *file, const char __user *buf,
 	struct mm_walk reclaim_walk = {};
 	unsigned long start = 0;
 	unsigned long end = 0;
-	struct reclaim_param rp;
+	struct reclaim_param rp = {};
 
 	memset(buffer, 0, sizeof(buffer));
 	if (count > sizeof(buffer) - 1)
@@ -20,6 +20,9 @@
 
 #include "sdcardfs.h"
 #include "linux/delay.h"
+#include <linux/bsearch.h>
+#include <linux/ctype.h>
+#include <linux/sort.h>
 
 /* The dentry cache is just so we have properly sized dentries */
 static struct kmem_cache *sdcardfs_dentry_cachep;
@@ -222,28 +225,216 @@ int sdcardfs_interpose(struct dentry *dentry, struct super_block *sb,
 	return PTR_ERR(ret_dentry);
 }
 
+/*
+ * Case folded hashes of all names of a lower directory, taken by the first
+ * case insensitive scan of it. A later lookup of a name whose hash is not
+ * in the index exists in no case at all, and gets its negative dentry
+ * without scanning the directory again. The index is dropped as soon as
+ * the times of the lower directory move, and only ever used with the
+ * directory's i_mutex held, as lookup, create, unlink and rename all do.
+ */
+#define SDCARDFS_NAME_INDEX_MIN		64
+#define SDCARDFS_NAME_INDEX_MAX		8192
+
+struct sdcardfs_name_index {
+	struct timespec mtime;
+	struct timespec ctime;
+	unsigned int nr;
+	unsigned int size;
+	u32 hash[];
+};
+
+static u32 sdcardfs_name_hash(const char *name, unsigned int len)
+{
+	unsigned long hash = init_name_hash();
+
+	/* Must match sdcardfs_hash_ci() */
+	while (len--)
+		hash = partial_name_hash(tolower(*name++), hash);
+	return end_name_hash(hash);
+}
+
+static int sdcardfs_name_hash_cmp(const void *a, const void *b)
+{
+	u32 x = *(const u32 *)a, y = *(const u32 *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+void sdcardfs_free_name_index(struct inode *inode)
+{
+	struct sdcardfs_inode_info *info = SDCARDFS_I(inode);
+
+	kfree(info->name_index);
+	info->name_index = NULL;
+}
+
+static bool sdcardfs_name_index_valid(struct sdcardfs_name_index *index,
+		struct inode *lower_dir)
+{
+	return index && timespec_equal(&index->mtime, &lower_dir->i_mtime) &&
+		timespec_equal(&index->ctime, &lower_dir->i_ctime);
+}
+
+static bool sdcardfs_name_index_has(struct sdcardfs_name_index *index,
+		u32 hash)
+{
+	return bsearch(&hash, index->hash, index->nr, sizeof(u32),
+			sdcardfs_name_hash_cmp) != NULL;
+}
+
+static struct sdcardfs_name_index *sdcardfs_name_index_alloc(unsigned int size)
+{
+	struct sdcardfs_name_index *index;
+
+	index = kmalloc(sizeof(*index) + size * sizeof(u32),
+			GFP_KERNEL | __GFP_NOWARN | __GFP_NORETRY);
+	if (index) {
+		index->nr = 0;
+		index->size = size;
+	}
+	return index;
+}
+
 struct sdcardfs_name_data {
 	struct dir_context ctx;
 	const struct qstr *to_find;
 	char *name;
 	bool found;
+	/* Index being built, NULL once it has been given up */
+	struct sdcardfs_name_index *index;
 };
 
+static void sdcardfs_name_index_add(struct sdcardfs_name_data *buf,
+		const char *name, int namelen)
+{
+	struct sdcardfs_name_index *index = buf->index, *grown;
+
+	if (index->nr == index->size) {
+		grown = NULL;
+		if (index->size < SDCARDFS_NAME_INDEX_MAX)
+			grown = krealloc(index, sizeof(*index) +
+					2 * index->size * sizeof(u32),
+					GFP_KERNEL | __GFP_NOWARN |
+					__GFP_NORETRY);
+		if (!grown) {
+			kfree(index);
+			buf->index = NULL;
+			return;
+		}
+		index = grown;
+		index->size *= 2;
+		buf->index = index;
+	}
+	index->hash[index->nr++] = sdcardfs_name_hash(name, namelen);
+}
+
 static int sdcardfs_name_match(struct dir_context *ctx, const char *name,
 		int namelen, loff_t offset, u64 ino, unsigned int d_type)
 {
 	struct sdcardfs_name_data *buf = container_of(ctx, struct sdcardfs_name_data, ctx);
 	struct qstr candidate = QSTR_INIT(name, namelen);
 
-	if (qstr_case_eq(buf->to_find, &candidate)) {
+	if (buf->index)
+		sdcardfs_name_index_add(buf, name, namelen);
+
+	if (!buf->found && qstr_case_eq(buf->to_find, &candidate)) {
 		memcpy(buf->name, name, namelen);
 		buf->name[namelen] = 0;
 		buf->found = true;
-		return 1;
+		/* Keep going if the rest of the names are to be indexed */
+		if (!buf->index)
+			return 1;
 	}
 	return 0;
 }
 
+/*
+ * Look for @name in another case in the lower directory. Fills in
+ * lower_path on success, returns -ENOENT if there is no such name.
+ */
+static int sdcardfs_lookup_ci(struct inode *dir,
+		struct path *lower_parent_path, const struct qstr *name,
+		struct path *lower_path)
+{
+	struct sdcardfs_inode_info *info = SDCARDFS_I(dir);
+	struct inode *lower_dir = d_inode(lower_parent_path->dentry);
+	const struct cred *cred = current_cred();
+	struct sdcardfs_name_index *index;
+	struct timespec mtime, ctime, now;
+	struct file *file;
+	int err;
+
+	struct sdcardfs_name_data buffer = {
+		.ctx.actor = sdcardfs_name_match,
+		.to_find = name,
+		.found = false,
+	};
+
+	if (sdcardfs_name_index_valid(info->name_index, lower_dir)) {
+		if (!sdcardfs_name_index_has(info->name_index,
+				sdcardfs_name_hash(name->name, name->len)))
+			return -ENOENT;
+	} else {
+		sdcardfs_free_name_index(dir);
+		buffer.index = sdcardfs_name_index_alloc(
+				SDCARDFS_NAME_INDEX_MIN);
+	}
+
+	buffer.name = __getname();
+	if (!buffer.name) {
+		err = -ENOMEM;
+		goto out;
+	}
+
+	/* Changes racing with the scan must invalidate what it finds */
+	mtime = lower_dir->i_mtime;
+	ctime = lower_dir->i_ctime;
+
+	file = dentry_open(lower_parent_path, O_RDONLY, cred);
+	if (IS_ERR(file)) {
+		err = PTR_ERR(file);
+		goto put_name;
+	}
+	err = iterate_dir(file, &buffer.ctx);
+	fput(file);
+	if (err)
+		goto put_name;
+
+	index = buffer.index;
+	buffer.index = NULL;
+	if (index) {
+		/*
+		 * A change within the same tick of the lower times could go
+		 * unnoticed, so only a directory that has been quiet for a
+		 * while is indexed.
+		 */
+		now = current_fs_time(lower_dir->i_sb);
+		if (timespec_compare(&mtime, &now) < 0 &&
+		    timespec_compare(&ctime, &now) < 0) {
+			sort(index->hash, index->nr, sizeof(u32),
+					sdcardfs_name_hash_cmp, NULL);
+			index->mtime = mtime;
+			index->ctime = ctime;
+			info->name_index = index;
+		} else {
+			kfree(index);
+		}
+	}
+
+	if (buffer.found)
+		err = vfs_path_lookup(lower_parent_path->dentry,
+					lower_parent_path->mnt,
+					buffer.name, 0, lower_path);
+	else
+		err = -ENOENT;
+put_name:
+	__putname(buffer.name);
+out:
+	kfree(buffer.index);
+	return err;
+}
+
 /*
  * Main driver function for sdcardfs's lookup.
  *
@@ -280,41 +471,9 @@ static struct dentry *__sdcardfs_lookup(struct dentry *dentry,
 	err = vfs_path_lookup(lower_dir_dentry, lower_dir_mnt, name->name, 0,
 				&lower_path);
 	/* check for other cases */
-	if (err == -ENOENT) {
-		struct file *file;
-		const struct cred *cred = current_cred();
-
-		struct sdcardfs_name_data buffer = {
-			.ctx.actor = sdcardfs_name_match,
-			.to_find = name,
-			.name = __getname(),
-			.found = false,
-		};
-
-		if (!buffer.name) {
-			err = -ENOMEM;
-			goto out;
-		}
-		file = dentry_open(lower_parent_path, O_RDONLY, cred);
-		if (IS_ERR(file)) {
-			err = PTR_ERR(file);
-			goto put_name;
-		}
-		err = iterate_dir(file, &buffer.ctx);
-		fput(file);
-		if (err)
-			goto put_name;
-
-		if (buffer.found)
-			err = vfs_path_lookup(lower_dir_dentry,
-						lower_dir_mnt,
-						buffer.name, 0,
-						&lower_path);
-		else
-			err = -ENOENT;
-put_name:
-		__putname(buffer.name);
-	}
+	if (err == -ENOENT)
+		err = sdcardfs_lookup_ci(d_inode(dentry->d_parent),
+					lower_parent_path, name, &lower_path);
 
 	/* no error: handle positive dentries */
 	if (!err) {
@@ -453,9 +612,7 @@ struct dentry *sdcardfs_lookup(struct inode *dir, struct dentry *dentry,
 	if (d_inode(dentry)) {
 		fsstack_copy_attr_times(d_inode(dentry),
 					sdcardfs_lower_inode(d_inode(dentry)));
-		/* get derived permission */
-		get_derived_permission(parent, dentry);
-		fixup_tmp_permissions(d_inode(dentry));
+		/* derived permissions are set up by __sdcardfs_interpose */
 		fixup_lower_ownership(dentry, dentry->d_name.name);
 	}
 	/* update parent directory's atime */
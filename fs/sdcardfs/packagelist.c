@@ -33,13 +33,18 @@
 
 struct hashtable_entry {
 	struct hlist_node hlist;
-	struct hlist_node dlist; /* for deletion cleanup */
+	struct rcu_head rcu;
 	struct qstr key;
 	atomic_t value;
 };
 
-static DEFINE_HASHTABLE(package_to_appid, 8);
-static DEFINE_HASHTABLE(package_to_userid, 8);
+/*
+ * Readers only hold rcu_read_lock(); writers serialize on
+ * sdcardfs_super_list_lock and free removed entries after a grace period.
+ * The package tables are sized for a few thousand installed packages.
+ */
+static DEFINE_HASHTABLE(package_to_appid, 10);
+static DEFINE_HASHTABLE(package_to_userid, 10);
 static DEFINE_HASHTABLE(ext_to_groupid, 8);
 
 
@@ -181,7 +186,6 @@ static struct hashtable_entry *alloc_hashtable_entry(const struct qstr *key,
 			GFP_KERNEL);
 	if (!ret)
 		return NULL;
-	INIT_HLIST_NODE(&ret->dlist);
 	INIT_HLIST_NODE(&ret->hlist);
 
 	if (!qstr_copy(key, &ret->key)) {
@@ -326,35 +330,44 @@ static int insert_userid_exclude_entry(const struct qstr *key, userid_t value)
 	return err;
 }
 
-static void free_hashtable_entry(struct hashtable_entry *entry)
+static void free_hashtable_entry_rcu(struct rcu_head *head)
 {
+	struct hashtable_entry *entry = container_of(head,
+			struct hashtable_entry, rcu);
+
 	kfree(entry->key.name);
 	kmem_cache_free(hashtable_entry_cachep, entry);
 }
 
+/*
+ * Unhash an entry and free it once the readers are done with it. Writers
+ * do not wait for the grace period, so they never stall each other on
+ * sdcardfs_super_list_lock.
+ */
+static void remove_hashtable_entry(struct hashtable_entry *entry)
+{
+	hash_del_rcu(&entry->hlist);
+	call_rcu(&entry->rcu, free_hashtable_entry_rcu);
+}
+
 static void remove_packagelist_entry_locked(const struct qstr *key)
 {
 	struct hashtable_entry *hash_cur;
 	unsigned int hash = key->hash;
 	struct hlist_node *h_t;
-	HLIST_HEAD(free_list);
 
-	hash_for_each_possible_rcu(package_to_userid, hash_cur, hlist, hash) {
-		if (qstr_case_eq(key, &hash_cur->key)) {
-			hash_del_rcu(&hash_cur->hlist);
-			hlist_add_head(&hash_cur->dlist, &free_list);
-		}
+	hash_for_each_possible_safe(package_to_userid, hash_cur, h_t, hlist,
+			hash) {
+		if (qstr_case_eq(key, &hash_cur->key))
+			remove_hashtable_entry(hash_cur);
 	}
-	hash_for_each_possible_rcu(package_to_appid, hash_cur, hlist, hash) {
+	hash_for_each_possible_safe(package_to_appid, hash_cur, h_t, hlist,
+			hash) {
 		if (qstr_case_eq(key, &hash_cur->key)) {
-			hash_del_rcu(&hash_cur->hlist);
-			hlist_add_head(&hash_cur->dlist, &free_list);
+			remove_hashtable_entry(hash_cur);
 			break;
 		}
 	}
-	synchronize_rcu();
-	hlist_for_each_entry_safe(hash_cur, h_t, &free_list, dlist)
-		free_hashtable_entry(hash_cur);
 }
 
 static void remove_packagelist_entry(const struct qstr *key)
@@ -372,9 +385,7 @@ static void remove_ext_gid_entry_locked(const struct qstr *key, gid_t group)
 
 	hash_for_each_possible_rcu(ext_to_groupid, hash_cur, hlist, hash) {
 		if (qstr_case_eq(key, &hash_cur->key) && atomic_read(&hash_cur->value) == group) {
-			hash_del_rcu(&hash_cur->hlist);
-			synchronize_rcu();
-			free_hashtable_entry(hash_cur);
+			remove_hashtable_entry(hash_cur);
 			break;
 		}
 	}
@@ -391,18 +402,11 @@ static void remove_userid_all_entry_locked(userid_t userid)
 {
 	struct hashtable_entry *hash_cur;
 	struct hlist_node *h_t;
-	HLIST_HEAD(free_list);
 	int i;
 
-	hash_for_each_rcu(package_to_userid, i, hash_cur, hlist) {
-		if (atomic_read(&hash_cur->value) == userid) {
-			hash_del_rcu(&hash_cur->hlist);
-			hlist_add_head(&hash_cur->dlist, &free_list);
-		}
-	}
-	synchronize_rcu();
-	hlist_for_each_entry_safe(hash_cur, h_t, &free_list, dlist) {
-		free_hashtable_entry(hash_cur);
+	hash_for_each_safe(package_to_userid, i, h_t, hash_cur, hlist) {
+		if (atomic_read(&hash_cur->value) == userid)
+			remove_hashtable_entry(hash_cur);
 	}
 }
 
@@ -422,9 +426,7 @@ static void remove_userid_exclude_entry_locked(const struct qstr *key, userid_t
 	hash_for_each_possible_rcu(package_to_userid, hash_cur, hlist, hash) {
 		if (qstr_case_eq(key, &hash_cur->key) &&
 				atomic_read(&hash_cur->value) == userid) {
-			hash_del_rcu(&hash_cur->hlist);
-			synchronize_rcu();
-			free_hashtable_entry(hash_cur);
+			remove_hashtable_entry(hash_cur);
 			break;
 		}
 	}
@@ -442,21 +444,13 @@ static void packagelist_destroy(void)
 {
 	struct hashtable_entry *hash_cur;
 	struct hlist_node *h_t;
-	HLIST_HEAD(free_list);
 	int i;
 
 	mutex_lock(&sdcardfs_super_list_lock);
-	hash_for_each_rcu(package_to_appid, i, hash_cur, hlist) {
-		hash_del_rcu(&hash_cur->hlist);
-		hlist_add_head(&hash_cur->dlist, &free_list);
-	}
-	hash_for_each_rcu(package_to_userid, i, hash_cur, hlist) {
-		hash_del_rcu(&hash_cur->hlist);
-		hlist_add_head(&hash_cur->dlist, &free_list);
-	}
-	synchronize_rcu();
-	hlist_for_each_entry_safe(hash_cur, h_t, &free_list, dlist)
-		free_hashtable_entry(hash_cur);
+	hash_for_each_safe(package_to_appid, i, h_t, hash_cur, hlist)
+		remove_hashtable_entry(hash_cur);
+	hash_for_each_safe(package_to_userid, i, h_t, hash_cur, hlist)
+		remove_hashtable_entry(hash_cur);
 	mutex_unlock(&sdcardfs_super_list_lock);
 	pr_info("sdcardfs: destroyed packagelist pkgld\n");
 }
@@ -876,5 +870,7 @@ void packagelist_exit(void)
 {
 	configfs_sdcardfs_exit();
 	packagelist_destroy();
+	/* Wait for the entries freed by packagelist_destroy() */
+	rcu_barrier();
 	kmem_cache_destroy(hashtable_entry_cachep);
 }
@@ -150,6 +150,7 @@ extern struct inode *sdcardfs_iget(struct super_block *sb,
 				 struct inode *lower_inode, userid_t id);
 extern int sdcardfs_interpose(struct dentry *dentry, struct super_block *sb,
 			    struct path *lower_path, userid_t id);
+extern void sdcardfs_free_name_index(struct inode *inode);
 
 /* file private data */
 struct sdcardfs_file_info {
@@ -178,6 +179,9 @@ struct sdcardfs_inode_info {
 	/* top folder for ownership */
 	struct sdcardfs_inode_data *top_data;
 
+	/* case folded names of a directory, protected by i_mutex */
+	struct sdcardfs_name_index *name_index;
+
 	struct inode vfs_inode;
 };
 
@@ -20,6 +20,8 @@
 #ifdef CONFIG_DYNAMIC_FSYNC
 extern bool dyn_sync_scr_suspended;
 extern bool dyn_fsync_active __read_mostly;
+extern bool dyn_fsync_batch __read_mostly;
+extern bool dyn_fsync_defer(struct file *file, int datasync);
 #endif
 
 #define VALID_FLAGS (SYNC_FILE_RANGE_WAIT_BEFORE|SYNC_FILE_RANGE_WRITE| \
@@ -212,28 +214,17 @@ static int async_fsync(struct file *file)
 	return (sb->fsync_flags & FLAG_ASYNC_FSYNC) && cancel_fsync;
 }
 
-/**
- * vfs_fsync_range - helper to sync a range of data & metadata to disk
- * @file:		file to sync
- * @start:		offset in bytes of the beginning of data range to sync
- * @end:		offset in bytes of the end of data range (inclusive)
- * @datasync:		perform only datasync
- *
- * Write back data in range @start..@end and metadata for @file to disk.  If
- * @datasync is set only metadata needed to access modified file data is
- * written.
+/*
+ * vfs_fsync_range() without the dynamic fsync policy, also used by the
+ * dynamic fsync group commit itself.
  */
-int vfs_fsync_range(struct file *file, loff_t start, loff_t end, int datasync)
+int __vfs_fsync_range(struct file *file, loff_t start, loff_t end, int datasync)
 {
 	struct inode *inode = file->f_mapping->host;
 	int err;
 	ktime_t fsync_t, fsync_diff;
 	char pathname[256], *path;
 
-#ifdef CONFIG_DYNAMIC_FSYNC
-	if (likely(dyn_fsync_active && !dyn_sync_scr_suspended))
-		return 0;
-#endif
 	if (!file->f_op->fsync)
 		return -EINVAL;
 
@@ -263,6 +254,28 @@ int vfs_fsync_range(struct file *file, loff_t start, loff_t end, int datasync)
 
 	return err;
 }
+
+/**
+ * vfs_fsync_range - helper to sync a range of data & metadata to disk
+ * @file:		file to sync
+ * @start:		offset in bytes of the beginning of data range to sync
+ * @end:		offset in bytes of the end of data range (inclusive)
+ * @datasync:		perform only datasync
+ *
+ * Write back data in range @start..@end and metadata for @file to disk.  If
+ * @datasync is set only metadata needed to access modified file data is
+ * written.
+ */
+int vfs_fsync_range(struct file *file, loff_t start, loff_t end, int datasync)
+{
+#ifdef CONFIG_DYNAMIC_FSYNC
+	if (likely(dyn_fsync_active && !dyn_sync_scr_suspended)) {
+		if (!dyn_fsync_batch || dyn_fsync_defer(file, datasync))
+			return 0;
+	}
+#endif
+	return __vfs_fsync_range(file, start, end, datasync);
+}
 EXPORT_SYMBOL(vfs_fsync_range);
 
 /**
@@ -295,7 +308,8 @@ static int do_fsync(unsigned int fd, int datasync)
 SYSCALL_DEFINE1(fsync, unsigned int, fd)
 {
 #ifdef CONFIG_DYNAMIC_FSYNC
-	if (likely(dyn_fsync_active && !dyn_sync_scr_suspended))
+	if (likely(dyn_fsync_active && !dyn_sync_scr_suspended) &&
+	    !dyn_fsync_batch)
 		return 0;
 #endif
 	return do_fsync(fd, 0);
@@ -363,7 +377,8 @@ SYSCALL_DEFINE4(sync_file_range, int, fd, loff_t, offset, loff_t, nbytes,
 	umode_t i_mode;
 
 #ifdef CONFIG_DYNAMIC_FSYNC
-	if (likely(dyn_fsync_active && !dyn_sync_scr_suspended))
+	if (likely(dyn_fsync_active && !dyn_sync_scr_suspended) &&
+	    !dyn_fsync_batch)
 		return 0;
 #endif
 
@@ -448,7 +463,8 @@ SYSCALL_DEFINE4(sync_file_range2, int, fd, unsigned int, flags,
 				 loff_t, offset, loff_t, nbytes)
 {
 #ifdef CONFIG_DYNAMIC_FSYNC
-	if (likely(dyn_fsync_active && !dyn_sync_scr_suspended))
+	if (likely(dyn_fsync_active && !dyn_sync_scr_suspended) &&
+	    !dyn_fsync_batch)
 		return 0;
 #endif
 	return sys_sync_file_range(fd, offset, nbytes, flags);
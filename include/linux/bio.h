@@ -464,6 +464,19 @@ static inline struct bio *bio_clone_kmalloc(struct bio *bio, gfp_t gfp_mask)
 
 extern void bio_endio(struct bio *);
 
+#ifdef CONFIG_IOTOP_LATENCY
+extern void iotop_bio_submit(struct bio *bio);
+extern void iotop_bio_done(struct bio *bio);
+#else
+static inline void iotop_bio_submit(struct bio *bio)
+{
+}
+
+static inline void iotop_bio_done(struct bio *bio)
+{
+}
+#endif
+
 static inline void bio_io_error(struct bio *bio)
 {
 	bio->bi_error = -EIO;
@@ -67,6 +67,12 @@ struct bio {
 #ifdef CONFIG_BLOCK_PERF_FRAMEWORK
 	union blk_ktime		submit_time;
 	unsigned int            blk_sector_count;
+#endif
+#ifdef CONFIG_IOTOP_LATENCY
+	/* Submission time in ns and iotop slot, bi_iotop_start 0 if none */
+	u64			bi_iotop_start;
+	pid_t			bi_iotop_pid;
+	int			bi_iotop_slot;
 #endif
 	/* Number of segments in this BIO after
 	 * physical address coalescing is performed.
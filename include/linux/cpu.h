@@ -173,6 +173,8 @@ static inline void __unregister_cpu_notifier(struct notifier_block *nb)
 
 void smpboot_thread_init(void);
 int cpu_up(unsigned int cpu);
+int cpu_up_batch(struct cpumask *mask);
+extern bool cpuhp_parallel;
 void notify_cpu_starting(unsigned int cpu);
 extern void cpu_maps_update_begin(void);
 extern void cpu_maps_update_done(void);
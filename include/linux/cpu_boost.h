@@ -0,0 +1,28 @@
+/*
+ * Copyright (c) 2013-2015, The Linux Foundation. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 and
+ * only version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef _LINUX_CPU_BOOST_H
+#define _LINUX_CPU_BOOST_H
+
+/*
+ * Input drivers may kick the input boost as soon as they know a touch is
+ * coming, ahead of the input event that would otherwise trigger it. The
+ * boost is rate limited the same way either way.
+ */
+#if IS_REACHABLE(CONFIG_CPU_BOOST)
+void cpuboost_kick(void);
+#else
+static inline void cpuboost_kick(void) {}
+#endif
+
+#endif /* _LINUX_CPU_BOOST_H */
@@ -723,6 +723,7 @@ struct sched_domain;
 unsigned long cpufreq_scale_freq_capacity(struct sched_domain *sd, int cpu);
 unsigned long cpufreq_scale_max_freq_capacity(struct sched_domain *sd, int cpu);
 unsigned long cpufreq_scale_min_freq_capacity(struct sched_domain *sd, int cpu);
+void cpufreq_update_hw_max_freq(const struct cpumask *cpus, unsigned long freq);
 #endif /* _LINUX_CPUFREQ_H */
 
 /*********************************************************************
@@ -0,0 +1,52 @@
+/*
+ * Copyright (c) 2018, The Linux Foundation. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 and
+ * only version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef _LINUX_CPUFREQ_ARBITER_H
+#define _LINUX_CPUFREQ_ARBITER_H
+
+/*
+ * Client priorities. When two requests for the same cluster cannot both be
+ * met, e.g. a boost min above a cap, the higher priority client wins.
+ */
+#define FREQ_ARB_PRIO_INPUT	10
+#define FREQ_ARB_PRIO_PERFLOCK	20
+#define FREQ_ARB_PRIO_PNPMGR	30
+
+struct freq_arb_client;
+
+#ifdef CONFIG_CPU_FREQ_ARBITER
+struct freq_arb_client *freq_arb_register(const char *name, int prio);
+void freq_arb_unregister(struct freq_arb_client *c);
+
+void freq_arb_set_min(struct freq_arb_client *c, int cpu, unsigned int min);
+void freq_arb_set_max(struct freq_arb_client *c, int cpu, unsigned int max);
+void freq_arb_apply(struct freq_arb_client *c, unsigned int duration_ms);
+void freq_arb_clear(struct freq_arb_client *c);
+#else
+static inline struct freq_arb_client *freq_arb_register(const char *name,
+							int prio)
+{
+	return NULL;
+}
+static inline void freq_arb_unregister(struct freq_arb_client *c) {}
+
+static inline void freq_arb_set_min(struct freq_arb_client *c, int cpu,
+				    unsigned int min) {}
+static inline void freq_arb_set_max(struct freq_arb_client *c, int cpu,
+				    unsigned int max) {}
+static inline void freq_arb_apply(struct freq_arb_client *c,
+				  unsigned int duration_ms) {}
+static inline void freq_arb_clear(struct freq_arb_client *c) {}
+#endif
+
+#endif /* _LINUX_CPUFREQ_ARBITER_H */
@@ -74,6 +74,8 @@
 #define DIAG_IOCTL_REGISTER_CALLBACK	37
 #define DIAG_IOCTL_HDLC_TOGGLE	38
 #define DIAG_IOCTL_QUERY_PD_LOGGING	39
+#define DIAG_IOCTL_MD_RING_CONFIG	40
+#define DIAG_IOCTL_MD_RING_WAIT		41
 #define DIAG_IOCTL_NONBLOCKING_TIMEOUT	64
 
 /* PC Tools IDs */
@@ -18,6 +18,34 @@
 
 struct dma_iommu_mapping;
 
+/*
+ * Per-cpu caches of freed IOVA ranges for the 4K..32K size classes. Freed
+ * ranges are "dirty" until a TLB invalidate has run after their unmap and
+ * only "clean" ranges are handed out again.
+ */
+#define FAST_IOVA_RCACHE_CLASSES	4
+#define FAST_IOVA_MAG_SIZE		32
+#define FAST_IOVA_DEPOT_SIZE		256
+
+struct dma_fast_smmu_magazine {
+	unsigned int	nr_clean;
+	unsigned int	nr_dirty;
+	unsigned long	clean[FAST_IOVA_MAG_SIZE];
+	unsigned long	dirty[FAST_IOVA_MAG_SIZE];
+};
+
+struct dma_fast_smmu_rcache {
+	struct dma_fast_smmu_magazine mags[FAST_IOVA_RCACHE_CLASSES];
+};
+
+/* shared overflow of the per-cpu magazines, protected by the mapping lock */
+struct dma_fast_smmu_depot {
+	unsigned int	nr_clean;
+	unsigned int	nr_dirty;
+	unsigned long	clean[FAST_IOVA_DEPOT_SIZE];
+	unsigned long	dirty[FAST_IOVA_DEPOT_SIZE];
+};
+
 struct dma_fast_smmu_mapping {
 	struct device		*dev;
 	struct iommu_domain	*domain;
@@ -31,6 +59,9 @@ struct dma_fast_smmu_mapping {
 	unsigned long	upcoming_stale_bit;
 	bool		have_stale_tlbs;
 
+	struct dma_fast_smmu_rcache __percpu *rcache;
+	struct dma_fast_smmu_depot *depot;
+
 	dma_addr_t	pgtbl_dma_handle;
 	av8l_fast_iopte	*pgtbl_pmds;
 
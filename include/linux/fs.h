@@ -900,6 +900,11 @@ struct file_ra_state {
 
 	unsigned int ra_pages;		/* Maximum readahead window */
 	unsigned int mmap_miss;		/* Cache miss stat for mmap accesses */
+	unsigned int mmap_window;	/* Learned mmap read-around window,
+					   0 until the first miss */
+	unsigned int fault_around;	/* Fault-around pages from
+					   POSIX_FADV_FAULTAROUND, 0 for the
+					   system default */
 	loff_t prev_pos;		/* Cache last read() position */
 };
 
@@ -0,0 +1,10 @@
+#ifndef __LINUX_IIO_BUFFER_BLOCK_H__
+#define __LINUX_IIO_BUFFER_BLOCK_H__
+
+#include <linux/iio/iio.h>
+#include <linux/iio/buffer.h>
+
+struct iio_buffer *iio_block_buffer_allocate(void);
+void iio_block_buffer_free(struct iio_buffer *r);
+
+#endif
@@ -12,10 +12,12 @@
 #include <linux/sysfs.h>
 #include <linux/iio/iio.h>
 #include <linux/kref.h>
+#include <uapi/linux/iio/buffer.h>
 
 #ifdef CONFIG_IIO_BUFFER
 
 struct iio_buffer;
+struct vm_area_struct;
 
 /**
  * struct iio_buffer_access_funcs - access functions for buffers.
@@ -29,7 +31,14 @@ struct iio_buffer;
  * @set_length:		set number of datums in buffer
  * @release:		called when the last reference to the buffer is dropped,
  *			should free all resources allocated by the buffer.
+ * @alloc_blocks:	allocate mmap()able blocks, see IIO_BUFFER_BLOCK_*
+ * @free_blocks:	free the blocks allocated by @alloc_blocks
+ * @query_block:	fill in the description of the block with the given id
+ * @enqueue_block:	hand a block back to the buffer to be filled
+ * @dequeue_block:	take the oldest filled block, -EAGAIN if there is none
+ * @mmap:		map the blocks into userspace
  * @modes:		Supported operating modes by this buffer type
+ * @flags:		IIO_BUFFER_FLAG_* for this buffer type
  *
  * The purpose of this structure is to make the buffer element
  * modular as event for a given driver, different usecases may require
@@ -53,9 +62,27 @@ struct iio_buffer_access_funcs {
 
 	void (*release)(struct iio_buffer *buffer);
 
+	int (*alloc_blocks)(struct iio_buffer *buffer,
+			    struct iio_buffer_block_alloc_req *req);
+	int (*free_blocks)(struct iio_buffer *buffer);
+	int (*query_block)(struct iio_buffer *buffer,
+			   struct iio_buffer_block *block);
+	int (*enqueue_block)(struct iio_buffer *buffer,
+			     struct iio_buffer_block *block);
+	int (*dequeue_block)(struct iio_buffer *buffer,
+			     struct iio_buffer_block *block);
+	int (*mmap)(struct iio_buffer *buffer, struct vm_area_struct *vma);
+
 	unsigned int modes;
+	unsigned int flags;
 };
 
+/*
+ * The buffer wakes up pollq itself once there is something to dequeue, the
+ * core should not do so for every sample pushed.
+ */
+#define IIO_BUFFER_FLAG_OWN_WAKEUP	BIT(0)
+
 /**
  * struct iio_buffer - general buffer structure
  * @length:		[DEVICE] number of datums in buffer
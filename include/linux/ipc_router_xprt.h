@@ -25,6 +25,8 @@
 #define IPC_ROUTER_XPRT_EVENT_DATA  1
 #define IPC_ROUTER_XPRT_EVENT_OPEN  2
 #define IPC_ROUTER_XPRT_EVENT_CLOSE 3
+/* Like EVENT_DATA, but IPC Router takes over the packet instead of cloning */
+#define IPC_ROUTER_XPRT_EVENT_DATA_OWNED 4
 
 #define FRAG_PKT_WRITE_ENABLE 0x1
 
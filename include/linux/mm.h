@@ -2380,9 +2380,16 @@ struct reclaim_param {
 	int nr_to_reclaim;
 	/* pages reclaimed */
 	int nr_reclaimed;
+	/* only take pages left idle since the last idle mark */
+	bool idle_only;
+	/* pages found idle/referenced since the last idle mark */
+	int nr_idle;
+	int nr_hot;
 };
 extern struct reclaim_param reclaim_task_anon(struct task_struct *task,
 		int nr_to_reclaim);
+extern struct reclaim_param reclaim_task_idle_anon(struct task_struct *task,
+		int nr_to_reclaim, unsigned long min_idle);
 #endif
 
 #endif /* __KERNEL__ */
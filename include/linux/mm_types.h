@@ -369,6 +369,10 @@ struct vm_area_struct {
 	struct file * vm_file;		/* File we map to (can be NULL). */
 	void * vm_private_data;		/* was vm_pte (shared mem) */
 
+#ifdef CONFIG_SWAP
+	/* last fault address, window and hits of swap_vma_readahead() */
+	atomic_long_t swap_readahead_info;
+#endif
 #ifndef CONFIG_MMU
 	struct vm_region *vm_region;	/* NOMMU mapping region */
 #endif
@@ -541,6 +545,10 @@ struct mm_struct {
 #ifdef CONFIG_MSM_APP_SETTINGS
 	int app_setting;
 #endif
+#ifdef CONFIG_PROCESS_RECLAIM
+	/* jiffies when process reclaim last marked the anon pages idle */
+	unsigned long reclaim_idle_mark;
+#endif
 
 	struct work_struct async_put_work;
 };
@@ -172,6 +172,7 @@ enum zone_stat_item {
 #endif
 	WORKINGSET_REFAULT,
 	WORKINGSET_ACTIVATE,
+	WORKINGSET_PROTECT,
 	WORKINGSET_NODERECLAIM,
 	NR_ANON_TRANSPARENT_HUGEPAGES,
 	NR_FREE_CMA_PAGES,
@@ -269,6 +270,8 @@ enum zone_watermarks {
 #define low_wmark_pages(z) (z->watermark[WMARK_LOW])
 #define high_wmark_pages(z) (z->watermark[WMARK_HIGH])
 
+#define PCP_HIGH_ORDER	3
+
 struct per_cpu_pages {
 	int count;		/* number of pages in the list */
 	int high;		/* high watermark, emptying needed */
@@ -276,6 +279,14 @@ struct per_cpu_pages {
 
 	/* Lists of pages, one per migrate type stored on the pcp-lists */
 	struct list_head lists[MIGRATE_PCPTYPES];
+
+	/*
+	 * Order-1..PCP_HIGH_ORDER blocks, so that the small multi-page
+	 * allocations of kgsl, ion and skb frags stay off zone->lock.
+	 * high_count is in pages and bounded by high / 2.
+	 */
+	int high_count;
+	struct list_head high_lists[PCP_HIGH_ORDER][MIGRATE_PCPTYPES];
 };
 
 struct per_cpu_pageset {
@@ -492,6 +503,10 @@ struct zone {
 	/* Evictions & activations on the inactive file list */
 	atomic_long_t		inactive_age;
 
+	/* Active file pages kswapd leaves alone, see mm/workingset.c */
+	unsigned long		ws_protect_floor;
+	unsigned long		ws_protect_stamp;
+
 	/*
 	 * When free pages are below this point, additional steps are taken
 	 * when reading the number of free pages to avoid per-cpu counter
@@ -673,6 +688,8 @@ typedef struct pglist_data {
 	enum zone_type kcompactd_classzone_idx;
 	wait_queue_head_t kcompactd_wait;
 	struct task_struct *kcompactd;
+	bool kcompactd_proactive;	/* proactive check is due */
+	unsigned int kcompactd_proactive_defer;	/* checks left to skip */
 #endif
 #ifdef CONFIG_NUMA_BALANCING
 	/* Lock serializing the migrate rate limiting window */
@@ -70,6 +70,16 @@ int uncached_logk_pc(enum logk_event_type log_type, void *caller,
  */
 int uncached_logk(enum logk_event_type log_type, void *data);
 
+/*
+ * MMIO accessors log through this so that production builds can drop
+ * register logging at compile time while keeping the other event types.
+ */
+#ifdef CONFIG_QCOM_RTB_MMIO
+#define uncached_logk_mmio(log_type, data)	uncached_logk(log_type, data)
+#else
+#define uncached_logk_mmio(log_type, data)	0
+#endif
+
 #define ETB_WAYPOINT  do { \
 				BRANCH_TO_NEXT_ISTR; \
 				nop(); \
@@ -98,6 +108,8 @@ static inline int uncached_logk_pc(enum logk_event_type log_type,
 static inline int uncached_logk(enum logk_event_type log_type,
 					void *data) { return 0; }
 
+#define uncached_logk_mmio(log_type, data)	0
+
 #define ETB_WAYPOINT
 #define BRANCH_TO_NEXT_ISTR
 /*
@@ -321,6 +321,7 @@ struct napi_struct {
 	struct list_head	dev_list;
 	struct hlist_node	napi_hash_node;
 	unsigned int		napi_id;
+	struct task_struct	*thread;
 };
 
 enum {
@@ -328,6 +329,8 @@ enum {
 	NAPI_STATE_DISABLE,	/* Disable pending */
 	NAPI_STATE_NPSVC,	/* Netpoll - don't dequeue from poll_list */
 	NAPI_STATE_HASHED,	/* In NAPI hash */
+	NAPI_STATE_THREADED,	/* Polled by napi->thread, not NET_RX_SOFTIRQ */
+	NAPI_STATE_SCHED_THREADED, /* Scheduled on napi->thread */
 };
 
 enum gro_result {
@@ -496,6 +499,18 @@ void napi_hash_del(struct napi_struct *napi);
  */
 void napi_disable(struct napi_struct *n);
 
+/**
+ *	napi_set_threaded - poll NAPI from a kernel thread
+ *	@n: napi context
+ *	@threaded: true to poll from the "napi/<dev>-<n>" kthread
+ *
+ * A threaded NAPI is polled by its own kthread instead of the
+ * NET_RX_SOFTIRQ of the CPU that scheduled it, so its priority and
+ * affinity can be managed like those of any other task.
+ */
+int napi_set_threaded(struct napi_struct *n, bool threaded);
+int dev_set_threaded(struct net_device *dev, bool threaded);
+
 /**
  *	napi_enable - enable NAPI scheduling
  *	@n: napi context
@@ -1451,6 +1466,7 @@ enum netdev_priv_flags {
  *				allocated at register_netdev() time
  *	@real_num_rx_queues: 	Number of RX queues currently active in device
  *
+ *	@threaded:	NAPI instances are polled from kthreads
  *	@rx_handler:		handler for received packets
  *	@rx_handler_data: 	XXX: need comments on this one
  *	@ingress_queue:		XXX: need comments on this one
@@ -1686,6 +1702,7 @@ struct net_device {
 #endif
 
 	unsigned long		gro_flush_timeout;
+	bool			threaded;
 	rx_handler_func_t __rcu	*rx_handler;
 	void __rcu		*rx_handler_data;
 
@@ -66,6 +66,8 @@ tm.tm_hour, tm.tm_min, tm.tm_sec, ts.tv_nsec); \
 #define HTC_EXT_AI_CHARGING			(1<<8)
 
 #define BATT_TIMER_UPDATE_TIME				(60)
+#define BATT_TIMER_SCREEN_OFF_TIME			(300)
+#define BATT_EVENT_COALESCE_MS				(200)
 #define BATT_SUSPEND_CHECK_TIME				(3600)
 #define BATT_SUSPEND_HIGHFREQ_CHECK_TIME	(300)
 #define BATT_TIMER_CHECK_TIME				(360)
@@ -178,6 +180,7 @@ struct htc_battery_timer {
 	unsigned long batt_suspend_ms;
 	struct alarm batt_check_wakeup_alarm;
 	struct work_struct batt_work;
+	struct delayed_work batt_event_work;	/* coalesces psy events */
 	struct timer_list batt_timer;
 	struct workqueue_struct *batt_wq;
 	struct wake_lock battery_lock;
@@ -92,6 +92,9 @@ struct apr_svc_ch_dev {
 	void               *priv;
 	unsigned           channel_state;
 	bool               if_remote_intent_ready;
+	spinlock_t         tx_buf_lock;
+	struct list_head   tx_buf_pool;
+	int                tx_buf_cnt;
 };
 #else
 struct apr_svc_ch_dev {
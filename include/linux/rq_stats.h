@@ -11,21 +11,15 @@
  *
  */
 
+/*
+ * The runqueue averages themselves are maintained by the scheduler, see
+ * sched_get_nr_running_avg().
+ */
 struct rq_data {
-	unsigned int rq_avg;
-	unsigned long rq_poll_jiffies;
-	unsigned long def_timer_jiffies;
-	unsigned long rq_poll_last_jiffy;
-	unsigned long rq_poll_total_jiffies;
-	unsigned long def_timer_last_jiffy;
 	unsigned int hotplug_disabled;
-	int64_t def_start_time;
 	struct attribute_group *attr_group;
 	struct kobject *kobj;
-	struct work_struct def_timer_work;
 	int init;
 };
 
-extern spinlock_t rq_lock;
 extern struct rq_data rq_info;
-extern struct workqueue_struct *rq_wq;
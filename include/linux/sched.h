@@ -63,6 +63,7 @@ struct sched_param {
 #include <asm/processor.h>
 
 #define SCHED_ATTR_SIZE_VER0	48	/* sizeof first published struct */
+#define SCHED_ATTR_SIZE_VER1	56	/* add: util_{min,max} */
 
 /*
  * Extended scheduling parameters data structure.
@@ -124,6 +125,10 @@ struct sched_attr {
 	u64 sched_runtime;
 	u64 sched_deadline;
 	u64 sched_period;
+
+	/* Utilization hints */
+	u32 sched_util_min;
+	u32 sched_util_max;
 };
 
 struct futex_pi_state;
@@ -178,6 +183,54 @@ extern void get_iowait_load(unsigned long *nr_waiters, unsigned long *load);
 extern u64 nr_running_integral(unsigned int cpu);
 #endif
 
+/* Averages are scaled by 100 */
+struct sched_avg_stats {
+	unsigned int avg;
+	unsigned int big_avg;
+	unsigned int max;
+};
+
+#ifdef CONFIG_HOTPLUG_CPU
+extern int sched_isolate_cpu(int cpu);
+extern int sched_unisolate_cpu(int cpu);
+extern int sched_unisolate_cpu_unlocked(int cpu);
+#else
+static inline int sched_isolate_cpu(int cpu)
+{
+	return 0;
+}
+
+static inline int sched_unisolate_cpu(int cpu)
+{
+	return 0;
+}
+
+static inline int sched_unisolate_cpu_unlocked(int cpu)
+{
+	return 0;
+}
+#endif
+
+#ifdef CONFIG_SCHED_NR_AVG
+extern void sched_get_nr_running_avg(const struct cpumask *cpus,
+				     struct sched_avg_stats *stats);
+#else
+static inline void sched_get_nr_running_avg(const struct cpumask *cpus,
+					    struct sched_avg_stats *stats)
+{
+	stats->avg = stats->big_avg = stats->max = 0;
+}
+#endif
+
+#ifdef CONFIG_CGROUP_SCHEDTUNE
+extern bool schedtune_task_foreground(struct task_struct *p);
+#else
+static inline bool schedtune_task_foreground(struct task_struct *p)
+{
+	return false;
+}
+#endif
+
 extern void calc_global_load(unsigned long ticks);
 
 #if defined(CONFIG_SMP) && defined(CONFIG_NO_HZ_COMMON)
@@ -977,6 +1030,8 @@ struct sched_info {
 	/* timestamps */
 	unsigned long long last_arrival,/* when we last ran on a cpu */
 			   last_queued;	/* when we were last queued to run */
+	/* last_queued was set by preemption rather than by a wakeup */
+	unsigned int preempted;
 };
 #endif /* CONFIG_SCHED_INFO */
 
@@ -1450,6 +1505,7 @@ struct sched_statistics {
 
 #ifdef CONFIG_SCHED_WALT
 #define RAVG_HIST_SIZE_MAX  5
+#define NUM_BUSY_BUCKETS 10
 
 /* ravg represents frequency scaled cpu-demand of tasks */
 struct ravg {
@@ -1474,9 +1530,15 @@ struct ravg {
 	 *
 	 * 'prev_window' represents task's contribution to cpu busy time
 	 * statistics (rq->prev_runnable_sum) in previous window
+	 *
+	 * 'pred_demand' represents task's predicted demand for the next
+	 * window, picked from 'busy_buckets' which bucket the task's busy
+	 * time over past windows
 	 */
 	u64 mark_start;
 	u32 sum, demand;
+	u32 pred_demand;
+	u8 busy_buckets[NUM_BUSY_BUCKETS];
 	u32 sum_history[RAVG_HIST_SIZE_MAX];
 	u32 curr_window, prev_window;
 	u64 curr_burst, avg_burst, avg_sleep_time;
@@ -1584,6 +1646,35 @@ struct sched_dl_entity {
 	struct hrtimer dl_timer;
 };
 
+#ifdef CONFIG_UCLAMP_TASK
+/* Number of utilization clamp buckets (shorter alias) */
+#define UCLAMP_BUCKETS CONFIG_UCLAMP_BUCKETS_COUNT
+
+enum uclamp_id {
+	UCLAMP_MIN = 0,
+	UCLAMP_MAX,
+	UCLAMP_CNT
+};
+
+/*
+ * Utilization clamp for a scheduling entity
+ * @value:		clamp value "assigned" to a se
+ * @bucket_id:		bucket index corresponding to the "assigned" value
+ * @active:		the se is currently refcounted in a rq's bucket
+ * @user_defined:	the requested clamp value comes from user-space
+ *
+ * The bucket_id is the index of the clamp bucket matching the clamp value
+ * which is pre-computed and stored to avoid expensive integer divisions
+ * from the fast path.
+ */
+struct uclamp_se {
+	unsigned int value		: SCHED_CAPACITY_SHIFT + 1;
+	unsigned int bucket_id		: 5;
+	unsigned int active		: 1;
+	unsigned int user_defined	: 1;
+};
+#endif /* CONFIG_UCLAMP_TASK */
+
 union rcu_special {
 	struct {
 		u8 blocked;
@@ -1659,11 +1750,22 @@ struct task_struct {
 	u32 init_load_pct;
 	u64 last_sleep_ts;
 #endif
+#ifdef CONFIG_SCHED_NR_AVG
+	/* Accounted as a big task in the runqueue averages */
+	unsigned int nr_avg_big;
+#endif
 #ifdef CONFIG_CGROUP_SCHED
 	struct task_group *sched_task_group;
 #endif
 	struct sched_dl_entity dl;
 
+#ifdef CONFIG_UCLAMP_TASK
+	/* Clamp values requested for a scheduling entity */
+	struct uclamp_se uclamp_req[UCLAMP_CNT];
+	/* Effective clamp values used for a scheduling entity */
+	struct uclamp_se uclamp[UCLAMP_CNT];
+#endif
+
 #ifdef CONFIG_PREEMPT_NOTIFIERS
 	/* list of struct preempt_notifier: */
 	struct hlist_head preempt_notifiers;
@@ -3557,6 +3659,17 @@ void cpufreq_add_update_util_hook(int cpu, struct update_util_data *data,
 void cpufreq_remove_update_util_hook(int cpu);
 #endif /* CONFIG_CPU_FREQ */
 
+#ifdef CONFIG_SCHED_WALT
+extern unsigned long sched_get_cpu_walt_load(int cpu, unsigned long *pred);
+#else
+static inline unsigned long sched_get_cpu_walt_load(int cpu,
+						    unsigned long *pred)
+{
+	*pred = 0;
+	return 0;
+}
+#endif
+
 #ifdef CONFIG_DYNAMIC_STUNE_BOOST
 int do_stune_boost(char *st_name, int boost, int *slot);
 int do_stune_sched_boost(char *st_name, int *slot);
@@ -14,14 +14,23 @@
 #ifndef __CORE_CTL_H
 #define __CORE_CTL_H
 
+#include <linux/errno.h>
+
 #ifdef CONFIG_SCHED_CORE_CTL
-void core_ctl_check(u64 wallclock);
+void core_ctl_check(u64 window_start);
 int core_ctl_set_boost(bool boost);
+int core_ctl_set_limits(unsigned int cpu, unsigned int min_cpus,
+			unsigned int max_cpus);
 #else
-static inline void core_ctl_check(u64 wallclock) {}
+static inline void core_ctl_check(u64 window_start) {}
 static inline int core_ctl_set_boost(bool boost)
 {
 	return 0;
 }
+static inline int core_ctl_set_limits(unsigned int cpu, unsigned int min_cpus,
+				      unsigned int max_cpus)
+{
+	return -ENOSYS;
+}
 #endif
 #endif
@@ -220,6 +220,8 @@ struct sk_buff;
 #define MAX_SKB_FRAGS (65536/PAGE_SIZE + 1)
 #endif
 extern int sysctl_max_skb_frags;
+extern int sysctl_skb_head_cache_size;
+void skb_head_cache_flush_all(void);
 
 typedef struct skb_frag_struct skb_frag_t;
 
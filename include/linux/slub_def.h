@@ -42,6 +42,8 @@ struct kmem_cache_cpu {
 	unsigned long tid;	/* Globally unique transaction id */
 	struct page *page;	/* The slab from which we are allocating */
 	struct page *partial;	/* Partially allocated frozen slabs */
+	unsigned long nr_slowpath;	/* Entries into ___slab_alloc */
+	unsigned long nr_partial_hit;	/* Slowpath served by cpu partial */
 #ifdef CONFIG_SLUB_STATS
 	unsigned stat[NR_SLUB_STAT_ITEMS];
 #endif
@@ -69,6 +71,14 @@ struct kmem_cache {
 	int offset;		/* Free pointer offset. */
 	/* Number of per cpu partial objects to keep around */
 	unsigned int cpu_partial;
+#ifdef CONFIG_SLUB_CPU_PARTIAL
+	/* cpu_partial and min_partial autotuning, see slub_autotune() */
+	bool cpu_partial_auto;
+	unsigned int cpu_partial_base;
+	unsigned long min_partial_base;
+	unsigned long autotune_events;
+	unsigned long autotune_slowpath;
+#endif
 	struct kmem_cache_order_objects oo;
 
 	/* Allocation and freeing of slabs */
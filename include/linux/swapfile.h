@@ -14,6 +14,9 @@ extern int try_to_unuse(unsigned int, bool, unsigned long);
 extern int swap_ratio(struct swap_info_struct **si);
 extern void setup_swap_ratio(struct swap_info_struct *p, int prio);
 extern bool is_swap_ratio_group(int prio);
+extern bool swap_ratio_measure(struct swap_info_struct *si);
+extern void swap_ratio_account_write(struct swap_info_struct *si,
+				     unsigned long start_ns);
 extern unsigned long generic_max_swapfile_size(void);
 extern unsigned long max_swapfile_size(void);
 
@@ -0,0 +1,23 @@
+#ifndef _LINUX_WAKE_INTENT_H
+#define _LINUX_WAKE_INTENT_H
+
+#include <linux/notifier.h>
+
+/*
+ * A wake intent is raised straight from the interrupt of a source that
+ * userspace normally turns into a screen on: a power key press or the
+ * cover being opened. Listeners get a head start on resuming before the
+ * unblank arrives, and must cope with it never arriving.
+ *
+ * The chain is atomic, listeners must not sleep.
+ */
+enum wake_intent_source {
+	WAKE_INTENT_POWER_KEY,
+	WAKE_INTENT_COVER_OPEN,
+};
+
+int wake_intent_register_notifier(struct notifier_block *nb);
+int wake_intent_unregister_notifier(struct notifier_block *nb);
+void wake_intent_notify(enum wake_intent_source source);
+
+#endif /* _LINUX_WAKE_INTENT_H */
@@ -40,7 +40,9 @@ unsigned long long int msm_timer_get_sclk_ticks(void) { return 0; }
 
 static inline int boot_marker_enabled(void) { return 1; }
 void place_marker(const char *name);
+void place_initcall_marker(void *fn, u64 duration_ns);
 #else
-inline void place_marker(char *name);
+static inline void place_marker(const char *name) { }
+static inline void place_initcall_marker(void *fn, u64 duration_ns) { }
 static inline int boot_marker_enabled(void) { return 0; }
 #endif
@@ -34,10 +34,16 @@ enum {
  *
  * Used to define the glink_open_config::options field which is passed into
  * glink_open().
+ *
+ * GLINK_OPT_RX_INTENT_POOL lets the core keep RX intents queued on the
+ * channel, sized from the received traffic.  Packets received into these
+ * intents are notified with a NULL pkt_priv, and remote intent requests of
+ * up to 16 KB are granted by the core without calling notify_rx_intent_req.
  */
 enum {
 	GLINK_OPT_INITIAL_XPORT = BIT(0),
 	GLINK_OPT_RX_INTENT_NOTIF = BIT(1),
+	GLINK_OPT_RX_INTENT_POOL = BIT(2),
 };
 
 /**
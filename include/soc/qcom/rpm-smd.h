@@ -195,6 +195,24 @@ int msm_rpm_send_message(enum msm_rpm_set set, uint32_t rsc_type,
 void *msm_rpm_send_message_noack(enum msm_rpm_set set, uint32_t rsc_type,
 		uint32_t rsc_id, struct msm_rpm_kvp *kvp, int nelems);
 
+/**
+ * msm_rpm_send_message_nowait() -Wrapper function for clients to send data
+ * given an array of key value pairs without blocking on the ack. Clients
+ * sending a burst of requests can send them all first and then wait for
+ * each ack with msm_rpm_wait_for_ack().
+ *
+ * @set: if the device is setting the active/sleep set parameter
+ * for the resource
+ * @rsc_type: unsigned 32 bit integer that identifies the type of the resource
+ * @rsc_id: unsigned 32 bit that uniquely identifies a resource within a type
+ * @kvp: array of KVP data.
+ * @nelem: number of KVPs pairs associated with the message.
+ *
+ * returns the message id to wait on, or errno on failure.
+ */
+int msm_rpm_send_message_nowait(enum msm_rpm_set set, uint32_t rsc_type,
+		uint32_t rsc_id, struct msm_rpm_kvp *kvp, int nelems);
+
 /**
  * msm_rpm_send_message_noirq() -Wrapper function for clients to send data
  * given an array of key value pairs. This function is similar to the
@@ -277,6 +295,13 @@ static inline int msm_rpm_send_message(enum msm_rpm_set set, uint32_t rsc_type,
 	return 0;
 }
 
+static inline int msm_rpm_send_message_nowait(enum msm_rpm_set set,
+		uint32_t rsc_type, uint32_t rsc_id, struct msm_rpm_kvp *kvp,
+		int nelems)
+{
+	return 1;
+}
+
 static inline int msm_rpm_send_message_noirq(enum msm_rpm_set set,
 		uint32_t rsc_type, uint32_t rsc_id, struct msm_rpm_kvp *kvp,
 		int nelems)
@@ -145,6 +145,8 @@ int adm_get_topology_for_port_from_copp_id(int port_id, int copp_id);
 
 int adm_get_topology_for_port_copp_idx(int port_id, int copp_idx);
 
+int adm_get_copp_refcount(int port_id, int copp_idx);
+
 int adm_get_indexes_from_copp_id(int copp_id, int *port_idx, int *copp_idx);
 
 int adm_set_pspd_matrix_params(int port_id, int copp_idx,
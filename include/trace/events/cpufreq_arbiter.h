@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2018, The Linux Foundation. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 and
+ * only version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM cpufreq_arbiter
+
+#if !defined(_TRACE_CPUFREQ_ARBITER_H) || defined(TRACE_HEADER_MULTI_READ)
+#define _TRACE_CPUFREQ_ARBITER_H
+
+#include <linux/tracepoint.h>
+
+TRACE_EVENT(freq_arb_request,
+
+	TP_PROTO(const char *name, int prio, int cpu, unsigned int min,
+		 unsigned int max, unsigned int duration_ms),
+
+	TP_ARGS(name, prio, cpu, min, max, duration_ms),
+
+	TP_STRUCT__entry(
+		__string(name, name)
+		__field(int, prio)
+		__field(int, cpu)
+		__field(unsigned int, min)
+		__field(unsigned int, max)
+		__field(unsigned int, duration_ms)
+	),
+
+	TP_fast_assign(
+		__assign_str(name, name);
+		__entry->prio = prio;
+		__entry->cpu = cpu;
+		__entry->min = min;
+		__entry->max = max;
+		__entry->duration_ms = duration_ms;
+	),
+
+	TP_printk("client=%s prio=%d cpu=%d min=%u max=%u duration_ms=%u",
+		  __get_str(name), __entry->prio, __entry->cpu, __entry->min,
+		  __entry->max, __entry->duration_ms)
+);
+
+TRACE_EVENT(freq_arb_release,
+
+	TP_PROTO(const char *name, int prio, bool expired),
+
+	TP_ARGS(name, prio, expired),
+
+	TP_STRUCT__entry(
+		__string(name, name)
+		__field(int, prio)
+		__field(bool, expired)
+	),
+
+	TP_fast_assign(
+		__assign_str(name, name);
+		__entry->prio = prio;
+		__entry->expired = expired;
+	),
+
+	TP_printk("client=%s prio=%d expired=%d",
+		  __get_str(name), __entry->prio, __entry->expired)
+);
+
+TRACE_EVENT(freq_arb_limits,
+
+	TP_PROTO(int cpu, unsigned int min, unsigned int max,
+		 const char *min_owner, const char *max_owner),
+
+	TP_ARGS(cpu, min, max, min_owner, max_owner),
+
+	TP_STRUCT__entry(
+		__field(int, cpu)
+		__field(unsigned int, min)
+		__field(unsigned int, max)
+		__string(min_owner, min_owner)
+		__string(max_owner, max_owner)
+	),
+
+	TP_fast_assign(
+		__entry->cpu = cpu;
+		__entry->min = min;
+		__entry->max = max;
+		__assign_str(min_owner, min_owner);
+		__assign_str(max_owner, max_owner);
+	),
+
+	TP_printk("cpu=%d min=%u (%s) max=%u (%s)",
+		  __entry->cpu, __entry->min, __get_str(min_owner),
+		  __entry->max, __get_str(max_owner))
+);
+
+#endif /* _TRACE_CPUFREQ_ARBITER_H */
+
+/* This part must be outside protection */
+#include <trace/define_trace.h>
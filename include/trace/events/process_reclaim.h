@@ -59,6 +59,30 @@ TRACE_EVENT(process_reclaim,
 			__entry->nr_to_reclaim)
 );
 
+TRACE_EVENT(process_reclaim_idle,
+
+	TP_PROTO(int tasksize, int nr_idle, int nr_hot, int nr_reclaimed),
+
+	TP_ARGS(tasksize, nr_idle, nr_hot, nr_reclaimed),
+
+	TP_STRUCT__entry(
+		__field(int, tasksize)
+		__field(int, nr_idle)
+		__field(int, nr_hot)
+		__field(int, nr_reclaimed)
+	),
+
+	TP_fast_assign(
+		__entry->tasksize	= tasksize;
+		__entry->nr_idle	= nr_idle;
+		__entry->nr_hot		= nr_hot;
+		__entry->nr_reclaimed	= nr_reclaimed;
+	),
+
+	TP_printk("%d, %d, %d, %d", __entry->tasksize, __entry->nr_idle,
+		__entry->nr_hot, __entry->nr_reclaimed)
+);
+
 TRACE_EVENT(process_reclaim_eff,
 
 	TP_PROTO(int efficiency, int reclaim_avg_efficiency),
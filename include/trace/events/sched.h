@@ -1113,6 +1113,7 @@ TRACE_EVENT(walt_update_history,
 		__field(	 int,	samples			)
 		__field(	 int,	evt			)
 		__field(	 u64,	demand			)
+		__field(	 u32,	pred_demand		)
 		__field(	 u64,	walt_avg		)
 		__field(unsigned int,	pelt_avg		)
 		__array(	 u32,	hist, RAVG_HIST_SIZE_MAX)
@@ -1126,6 +1127,7 @@ TRACE_EVENT(walt_update_history,
 		__entry->samples        = samples;
 		__entry->evt            = evt;
 		__entry->demand         = p->ravg.demand;
+		__entry->pred_demand    = p->ravg.pred_demand;
 		__entry->walt_avg	= (__entry->demand << 10);
 		do_div(__entry->walt_avg, walt_ravg_window);
 		__entry->pelt_avg	= p->se.avg.util_avg;
@@ -1135,10 +1137,10 @@ TRACE_EVENT(walt_update_history,
 	),
 
 	TP_printk("%d (%s): runtime %u samples %d event %d demand %llu"
-		" walt %llu pelt %u (hist: %u %u %u %u %u) cpu %d",
+		" pred_demand %u walt %llu pelt %u (hist: %u %u %u %u %u) cpu %d",
 		__entry->pid, __entry->comm,
 		__entry->runtime, __entry->samples, __entry->evt,
-		__entry->demand,
+		__entry->demand, __entry->pred_demand,
 		__entry->walt_avg,
 		__entry->pelt_avg,
 		__entry->hist[0], __entry->hist[1],
@@ -1159,6 +1161,7 @@ TRACE_EVENT(walt_migration_update_sum,
 		__field(	u64,	ps			)
 		__field(	s64,	nt_cs			)
 		__field(	s64,	nt_ps			)
+		__field(	u64,	top			)
 	),
 
 	TP_fast_assign(
@@ -1168,14 +1171,92 @@ TRACE_EVENT(walt_migration_update_sum,
 		__entry->nt_cs		= (s64)rq->nt_curr_runnable_sum;
 		__entry->nt_ps		= (s64)rq->nt_prev_runnable_sum;
 		__entry->pid		= p->pid;
+		__entry->top		= walt_top_task_load(cpu_of(rq));
 	),
 
-	TP_printk("cpu %d: cs %llu ps %llu nt_cs %lld nt_ps %lld pid %d",
+	TP_printk("cpu %d: cs %llu ps %llu nt_cs %lld nt_ps %lld pid %d top %llu",
 		  __entry->cpu, __entry->cs, __entry->ps,
-		  __entry->nt_cs, __entry->nt_ps, __entry->pid)
+		  __entry->nt_cs, __entry->nt_ps, __entry->pid, __entry->top)
 );
 #endif /* CONFIG_SCHED_WALT */
 
+TRACE_EVENT(sched_isolate,
+
+	TP_PROTO(unsigned int requested_cpu, unsigned int isolated_cpus,
+		 u64 start_time, unsigned char isolate),
+
+	TP_ARGS(requested_cpu, isolated_cpus, start_time, isolate),
+
+	TP_STRUCT__entry(
+		__field(u32, requested_cpu)
+		__field(u32, isolated_cpus)
+		__field(u32, time)
+		__field(unsigned char, isolate)
+	),
+
+	TP_fast_assign(
+		__entry->requested_cpu = requested_cpu;
+		__entry->isolated_cpus = isolated_cpus;
+		__entry->time = div64_u64(sched_clock() - start_time, 1000);
+		__entry->isolate = isolate;
+	),
+
+	TP_printk("iso cpu=%u cpus=0x%x time=%u us isolated=%d",
+		  __entry->requested_cpu, __entry->isolated_cpus,
+		  __entry->time, __entry->isolate)
+);
+
+TRACE_EVENT(core_ctl_eval_need,
+
+	TP_PROTO(unsigned int cpu, unsigned int old_need,
+		 unsigned int new_need, unsigned int updated),
+
+	TP_ARGS(cpu, old_need, new_need, updated),
+
+	TP_STRUCT__entry(
+		__field(u32, cpu)
+		__field(u32, old_need)
+		__field(u32, new_need)
+		__field(u32, updated)
+	),
+
+	TP_fast_assign(
+		__entry->cpu = cpu;
+		__entry->old_need = old_need;
+		__entry->new_need = new_need;
+		__entry->updated = updated;
+	),
+
+	TP_printk("cpu=%u, old_need=%u, new_need=%u, updated=%u",
+		  __entry->cpu, __entry->old_need, __entry->new_need,
+		  __entry->updated)
+);
+
+TRACE_EVENT(core_ctl_update_nr_need,
+
+	TP_PROTO(int cpu, int nr_need, int nr_big, int busy),
+
+	TP_ARGS(cpu, nr_need, nr_big, busy),
+
+	TP_STRUCT__entry(
+		__field(int, cpu)
+		__field(int, nr_need)
+		__field(int, nr_big)
+		__field(int, busy)
+	),
+
+	TP_fast_assign(
+		__entry->cpu = cpu;
+		__entry->nr_need = nr_need;
+		__entry->nr_big = nr_big;
+		__entry->busy = busy;
+	),
+
+	TP_printk("cpu=%d nr_need=%d nr_big=%d busy=%d",
+		  __entry->cpu, __entry->nr_need, __entry->nr_big,
+		  __entry->busy)
+);
+
 #endif /* CONFIG_SMP */
 
 #endif /* _TRACE_SCHED_H */
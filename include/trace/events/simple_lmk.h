@@ -0,0 +1,79 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 and
+ * only version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM simple_lmk
+
+#if !defined(_TRACE_EVENT_SIMPLE_LMK_H) || defined(TRACE_HEADER_MULTI_READ)
+#define _TRACE_EVENT_SIMPLE_LMK_H
+
+#include <linux/tracepoint.h>
+#include <linux/types.h>
+#include <linux/sched.h>
+
+TRACE_EVENT(simple_lmk_decision,
+
+	TP_PROTO(bool oom, unsigned int stall_pct, unsigned int span_ms,
+		unsigned int budget_pct, bool kill),
+
+	TP_ARGS(oom, stall_pct, span_ms, budget_pct, kill),
+
+	TP_STRUCT__entry(
+		__field(bool, oom)
+		__field(unsigned int, stall_pct)
+		__field(unsigned int, span_ms)
+		__field(unsigned int, budget_pct)
+		__field(bool, kill)
+	),
+
+	TP_fast_assign(
+		__entry->oom		= oom;
+		__entry->stall_pct	= stall_pct;
+		__entry->span_ms	= span_ms;
+		__entry->budget_pct	= budget_pct;
+		__entry->kill		= kill;
+	),
+
+	TP_printk("source=%s stall=%u%% span=%ums budget=%u%% kill=%d",
+			__entry->oom ? "oom" : "kswapd",
+			__entry->stall_pct, __entry->span_ms,
+			__entry->budget_pct, __entry->kill)
+);
+
+TRACE_EVENT(simple_lmk_kill,
+
+	TP_PROTO(pid_t pid, const char *comm, short oom_score_adj,
+		unsigned long tasksize),
+
+	TP_ARGS(pid, comm, oom_score_adj, tasksize),
+
+	TP_STRUCT__entry(
+		__field(pid_t, pid)
+		__array(char, comm, TASK_COMM_LEN)
+		__field(short, oom_score_adj)
+		__field(unsigned long, tasksize)
+	),
+
+	TP_fast_assign(
+		__entry->pid		= pid;
+		memcpy(__entry->comm, comm, TASK_COMM_LEN);
+		__entry->oom_score_adj	= oom_score_adj;
+		__entry->tasksize	= tasksize;
+	),
+
+	TP_printk("pid=%d comm=%s adj=%hd pages=%lu",
+			__entry->pid, __entry->comm,
+			__entry->oom_score_adj, __entry->tasksize)
+);
+
+#endif
+
+#include <trace/define_trace.h>
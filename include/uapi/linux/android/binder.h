@@ -254,6 +254,7 @@ struct binder_node_debug_info {
 #define BINDER_THREAD_EXIT		_IOW('b', 8, __s32)
 #define BINDER_VERSION			_IOWR('b', 9, struct binder_version)
 #define BINDER_GET_NODE_DEBUG_INFO	_IOWR('b', 11, struct binder_node_debug_info)
+#define BINDER_SET_PREALLOC_SIZE	_IOW('b', 32, __u32)
 
 /*
  * NOTE: Two special error codes you should check for when calling
@@ -18,4 +18,11 @@
 #define POSIX_FADV_NOREUSE	5 /* Data will be accessed once.  */
 #endif
 
+/*
+ * Linux extension: map up to len bytes of cached pages around each read
+ * fault on this file, rounded down to a power of two. len == 0 restores
+ * the system-wide fault-around size.
+ */
+#define POSIX_FADV_FAULTAROUND	8
+
 #endif	/* FADVISE_H_INCLUDED */
@@ -0,0 +1,55 @@
+/* The industrial I/O - block based buffer access
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as published by
+ * the Free Software Foundation.
+ */
+#ifndef _UAPI_IIO_BUFFER_H_
+#define _UAPI_IIO_BUFFER_H_
+
+#include <linux/ioctl.h>
+#include <linux/types.h>
+
+/**
+ * struct iio_buffer_block_alloc_req - request to allocate buffer blocks
+ * @size:	size of each block in bytes, rounded up to a page on return
+ * @count:	number of blocks
+ * @reserved:	must be zero
+ *
+ * All blocks start out owned by userspace and have to be enqueued before
+ * the buffer can fill them.
+ */
+struct iio_buffer_block_alloc_req {
+	__u32	size;
+	__u32	count;
+	__u32	reserved[2];
+};
+
+/* samples were dropped between the previous block and this one */
+#define IIO_BUFFER_BLOCK_FLAG_OVERRUN	(1 << 0)
+
+/**
+ * struct iio_buffer_block - description of a single buffer block
+ * @id:		index of the block, 0 to count - 1
+ * @size:	size of the block in bytes
+ * @bytes_used:	number of valid bytes at the start of the block
+ * @flags:	IIO_BUFFER_BLOCK_FLAG_* for the block
+ * @offset:	mmap() offset of the block on the buffer character device
+ * @timestamp:	time the first sample was stored in the block, in ns
+ */
+struct iio_buffer_block {
+	__u32	id;
+	__u32	size;
+	__u32	bytes_used;
+	__u32	flags;
+	__u64	offset;
+	__s64	timestamp;
+};
+
+#define IIO_BUFFER_BLOCK_ALLOC_IOCTL	_IOWR('i', 0xa0, struct iio_buffer_block_alloc_req)
+#define IIO_BUFFER_BLOCK_FREE_IOCTL	_IO('i', 0xa1)
+#define IIO_BUFFER_BLOCK_QUERY_IOCTL	_IOWR('i', 0xa2, struct iio_buffer_block)
+#define IIO_BUFFER_BLOCK_ENQUEUE_IOCTL	_IOW('i', 0xa3, struct iio_buffer_block)
+#define IIO_BUFFER_BLOCK_DEQUEUE_IOCTL	_IOR('i', 0xa4, struct iio_buffer_block)
+
+#endif /* _UAPI_IIO_BUFFER_H_ */
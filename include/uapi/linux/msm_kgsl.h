@@ -125,6 +125,8 @@
 #define KGSL_MEMFLAGS_GPUREADONLY 0x01000000U
 #define KGSL_MEMFLAGS_GPUWRITEONLY 0x02000000U
 #define KGSL_MEMFLAGS_FORCE_32BIT 0x100000000ULL
+/* Reserve the GPU address range now, back it with pages on first use */
+#define KGSL_MEMFLAGS_LAZY 0x800000000ULL
 
 /* Flag for binding all the virt range to single phys data */
 #define KGSL_SPARSE_BIND_MULTIPLE_TO_PHYS 0x400000000ULL
@@ -1597,4 +1599,58 @@ struct kgsl_gpu_sparse_command {
 #define IOCTL_KGSL_GPU_SPARSE_COMMAND \
 	_IOWR(KGSL_IOC_TYPE, 0x55, struct kgsl_gpu_sparse_command)
 
+/*
+ * GPU counter telemetry ring
+ *
+ * The adreno device exposes a read-only "telemetry_ring" file in its sysfs
+ * directory that can be read or mmap()ed. It starts with a struct
+ * kgsl_telemetry_header followed by num_entries struct
+ * kgsl_telemetry_entry. One entry is written for every retired command
+ * with the counter deltas accumulated since the previous retirement.
+ * head counts the entries written since the ring was enabled; entry
+ * (head - 1) % num_entries is the latest. Readers should read head,
+ * copy the entries they want and read head again to detect entries that
+ * were overwritten in the meantime.
+ */
+#define KGSL_TELEMETRY_VERSION 1
+
+#define KGSL_TELEMETRY_BUSY 0
+#define KGSL_TELEMETRY_ALU 1
+#define KGSL_TELEMETRY_RAM_STALL 2
+#define KGSL_TELEMETRY_COUNTERS 3
+
+/* The command ended a frame */
+#define KGSL_TELEMETRY_FLAG_EOF 0x1
+
+/**
+ * struct kgsl_telemetry_header - Header of the telemetry ring
+ * @version: KGSL_TELEMETRY_VERSION
+ * @num_entries: Number of entries in the ring
+ * @head: Total number of entries written
+ */
+struct kgsl_telemetry_header {
+	unsigned int version;
+	unsigned int num_entries;
+	uint64_t head;
+};
+
+/**
+ * struct kgsl_telemetry_entry - One retired command
+ * @ktime: Kernel time of the retirement in ns
+ * @pid: Process that submitted the command
+ * @context_id: Context of the command
+ * @timestamp: Timestamp of the command
+ * @flags: KGSL_TELEMETRY_FLAG_*
+ * @counters: GPU busy cycles, ALU active cycles and cycles stalled on
+ * memory since the previous entry
+ */
+struct kgsl_telemetry_entry {
+	uint64_t ktime;
+	unsigned int pid;
+	unsigned int context_id;
+	unsigned int timestamp;
+	unsigned int flags;
+	uint64_t counters[KGSL_TELEMETRY_COUNTERS];
+};
+
 #endif /* _UAPI_MSM_KGSL_H */
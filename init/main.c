@@ -93,6 +93,10 @@
 #include <linux/msm_rtb.h>
 #endif
 
+#ifdef CONFIG_MSM_BOOT_TIME_MARKER
+#include <soc/qcom/boot_stats.h>
+#endif
+
 static int kernel_init(void *);
 
 extern void init_IRQ(void);
@@ -782,10 +786,17 @@ int __init_or_module do_one_initcall(initcall_t fn)
 	int count = preempt_count();
 	int ret;
 	char msgbuf[64];
+#ifdef CONFIG_MSM_BOOT_TIME_MARKER
+	ktime_t calltime;
+#endif
 
 	if (initcall_blacklisted(fn))
 		return -EPERM;
 
+#ifdef CONFIG_MSM_BOOT_TIME_MARKER
+	calltime = ktime_get();
+#endif
+
 #ifdef CONFIG_HTC_EARLY_RTB
 	uncached_logk_pc(LOGK_INITCALL, (void *)fn, (void *)(0x00000000));
 #endif
@@ -795,6 +806,10 @@ int __init_or_module do_one_initcall(initcall_t fn)
 	else
 		ret = fn();
 
+#ifdef CONFIG_MSM_BOOT_TIME_MARKER
+	place_initcall_marker(fn, ktime_to_ns(ktime_sub(ktime_get(), calltime)));
+#endif
+
 #ifdef CONFIG_HTC_EARLY_RTB
 	uncached_logk_pc(LOGK_INITCALL, (void *)fn, (void *)(0xffffffff));
 #endif
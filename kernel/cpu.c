@@ -22,6 +22,7 @@
 #include <linux/lockdep.h>
 #include <linux/tick.h>
 #include <linux/irq.h>
+#include <linux/moduleparam.h>
 #include <trace/events/power.h>
 
 #include <trace/events/sched.h>
@@ -221,13 +222,56 @@ int __register_cpu_notifier(struct notifier_block *nb)
 	return raw_notifier_chain_register(&cpu_chain, nb);
 }
 
+/*
+ * Bring up all CPUs of a batch at boot and resume: prepare them all, kick
+ * them back to back and only then run their CPU_ONLINE notifiers, so a
+ * secondary finishes its own startup while the next one is being kicked.
+ */
+bool cpuhp_parallel;
+core_param(cpuhp_parallel, cpuhp_parallel, bool, 0644);
+
+/* log every CPU notifier call that takes at least this long, 0 disables */
+static unsigned int cpuhp_timing_us;
+core_param(cpuhp_timing_us, cpuhp_timing_us, uint, 0644);
+
+/* Same walk as notifier_call_chain(), timing each callback */
+static int __cpu_notify_timed(unsigned long val, void *v, int nr_to_call,
+			      int *nr_calls)
+{
+	struct notifier_block *nb, *next_nb;
+	int ret = NOTIFY_DONE;
+	u64 start, delta;
+
+	nb = rcu_dereference_raw(cpu_chain.head);
+	while (nb && nr_to_call) {
+		next_nb = rcu_dereference_raw(nb->next);
+		start = local_clock();
+		ret = nb->notifier_call(nb, val, v);
+		delta = local_clock() - start;
+		if (delta >= (u64)cpuhp_timing_us * NSEC_PER_USEC)
+			pr_info("cpuhp: CPU%ld action %#lx %pf took %llu us\n",
+				(long)v, val, nb->notifier_call,
+				div_u64(delta, NSEC_PER_USEC));
+		if (nr_calls)
+			(*nr_calls)++;
+		if (ret & NOTIFY_STOP_MASK)
+			break;
+		nb = next_nb;
+		nr_to_call--;
+	}
+	return ret;
+}
+
 static int __cpu_notify(unsigned long val, void *v, int nr_to_call,
 			int *nr_calls)
 {
 	int ret;
 
-	ret = __raw_notifier_call_chain(&cpu_chain, val, v, nr_to_call,
-					nr_calls);
+	if (unlikely(cpuhp_timing_us))
+		ret = __cpu_notify_timed(val, v, nr_to_call, nr_calls);
+	else
+		ret = __raw_notifier_call_chain(&cpu_chain, val, v,
+						nr_to_call, nr_calls);
 
 	return notifier_to_errno(ret);
 }
@@ -561,6 +605,83 @@ out:
 	return ret;
 }
 
+static DEFINE_PER_CPU(int, cpuhp_nr_calls);
+
+/*
+ * Batched variant of _cpu_up() for every CPU in @mask, see cpuhp_parallel.
+ * The arch kick itself stays serial: arm64 hands the idle task and stack
+ * over through the single secondary_data. CPUs that fail to come up are
+ * cleared from @mask. Requires cpu_add_remove_lock to be held.
+ */
+static void _cpus_up_batch(struct cpumask *mask, int tasks_frozen)
+{
+	unsigned long mod = tasks_frozen ? CPU_TASKS_FROZEN : 0;
+	struct task_struct *idle;
+	u64 start, prepared, kicked;
+	unsigned int cpu;
+	int ret;
+
+	cpu_hotplug_begin();
+	start = local_clock();
+
+	for_each_cpu(cpu, mask) {
+		void *hcpu = (void *)(long)cpu;
+		int *nr_calls = &per_cpu(cpuhp_nr_calls, cpu);
+
+		*nr_calls = 0;
+		if (cpu_online(cpu) || !cpu_present(cpu)) {
+			ret = -EINVAL;
+			goto fail;
+		}
+
+		idle = idle_thread_get(cpu);
+		ret = PTR_ERR_OR_ZERO(idle);
+		if (!ret)
+			ret = smpboot_create_threads(cpu);
+		if (ret)
+			goto fail;
+
+		ret = __cpu_notify(CPU_UP_PREPARE | mod, hcpu, -1, nr_calls);
+		if (!ret)
+			continue;
+		__cpu_notify(CPU_UP_CANCELED | mod, hcpu, *nr_calls - 1, NULL);
+fail:
+		pr_warn_ratelimited("%s: attempt to bring up CPU %u failed\n",
+				    __func__, cpu);
+		cpumask_clear_cpu(cpu, mask);
+		trace_sched_cpu_hotplug(cpu, ret, 1);
+	}
+	prepared = local_clock();
+
+	for_each_cpu(cpu, mask) {
+		/* Arch-specific enabling code. */
+		ret = __cpu_up(cpu, idle_thread_get(cpu));
+		if (!ret) {
+			BUG_ON(!cpu_online(cpu));
+			continue;
+		}
+		__cpu_notify(CPU_UP_CANCELED | mod, (void *)(long)cpu,
+			     per_cpu(cpuhp_nr_calls, cpu), NULL);
+		cpumask_clear_cpu(cpu, mask);
+		trace_sched_cpu_hotplug(cpu, ret, 1);
+	}
+	kicked = local_clock();
+
+	for_each_cpu(cpu, mask) {
+		cpu_notify(CPU_ONLINE | mod, (void *)(long)cpu);
+		trace_sched_cpu_hotplug(cpu, 0, 1);
+	}
+
+	cpu_hotplug_done();
+
+	if (cpuhp_timing_us)
+		pr_info("cpuhp: CPUs %*pbl up: prepare %llu us, kick %llu us, online %llu us\n",
+			cpumask_pr_args(mask),
+			div_u64(prepared - start, NSEC_PER_USEC),
+			div_u64(kicked - prepared, NSEC_PER_USEC),
+			div_u64(local_clock() - kicked, NSEC_PER_USEC));
+}
+
 static int switch_to_rt_policy(void)
 {
 	struct sched_param param = { .sched_priority = MAX_RT_PRIO - 1 };
@@ -633,6 +754,48 @@ out:
 }
 EXPORT_SYMBOL_GPL(cpu_up);
 
+/**
+ * cpu_up_batch - bring up all CPUs in @mask together
+ * @mask: CPUs to bring up, on return the ones that came up
+ *
+ * Used by smp_init() when cpuhp_parallel is set.
+ */
+int cpu_up_batch(struct cpumask *mask)
+{
+	unsigned int cpu;
+	int err = 0;
+	int switch_err;
+
+	switch_err = switch_to_rt_policy();
+	if (switch_err < 0)
+		return switch_err;
+
+	for_each_cpu(cpu, mask) {
+		if (!cpu_possible(cpu) || try_online_node(cpu_to_node(cpu)))
+			cpumask_clear_cpu(cpu, mask);
+	}
+
+	cpu_maps_update_begin();
+
+	if (cpu_hotplug_disabled) {
+		cpumask_clear(mask);
+		err = -EBUSY;
+	} else {
+		_cpus_up_batch(mask, 0);
+	}
+
+	cpu_maps_update_done();
+
+	if (!switch_err) {
+		switch_err = switch_to_fair_policy();
+		if (switch_err)
+			pr_err("Hotplug policy switch err=%d Task %s pid=%d\n",
+				switch_err, current->comm, current->pid);
+	}
+
+	return err;
+}
+
 #ifdef CONFIG_PM_SLEEP_SMP
 static cpumask_var_t frozen_cpus;
 
@@ -703,6 +866,20 @@ void enable_nonboot_cpus(void)
 
 	arch_enable_nonboot_cpus_begin();
 
+	if (cpuhp_parallel) {
+		trace_suspend_resume(TPS("CPU_ON"), cpumask_first(frozen_cpus),
+				     true);
+		_cpus_up_batch(frozen_cpus, 1);
+		trace_suspend_resume(TPS("CPU_ON"), cpumask_first(frozen_cpus),
+				     false);
+		for_each_cpu(cpu, frozen_cpus) {
+			cpu_device = get_cpu_device(cpu);
+			if (cpu_device)
+				kobject_uevent(&cpu_device->kobj, KOBJ_ONLINE);
+		}
+		goto done;
+	}
+
 	for_each_cpu(cpu, frozen_cpus) {
 		trace_suspend_resume(TPS("CPU_ON"), cpu, true);
 		error = _cpu_up(cpu, 1);
@@ -720,6 +897,7 @@ void enable_nonboot_cpus(void)
 		pr_warn("Error taking CPU%d up: %d\n", cpu, error);
 	}
 
+done:
 	arch_enable_nonboot_cpus_end();
 
 	cpumask_clear(frozen_cpus);
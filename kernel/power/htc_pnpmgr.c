@@ -16,11 +16,13 @@
 #include <linux/string.h>
 #include <linux/cpu.h>
 #include <linux/cpufreq.h>
+#include <linux/cpufreq_arbiter.h>
 #include <linux/htc_pnpmgr.h>
 #include <linux/slab.h>
 #include <linux/of.h>
 #include <linux/htc_fda.h>
 #include <linux/pm_opp.h>
+#include <linux/sched/core_ctl.h>
 
 #include "power.h"
 
@@ -41,6 +43,7 @@ static struct kobject *cluster_root_kobj;
 static struct kobject *cluster_kobj[MAX_TYPE];
 static struct kobject *hotplug_kobj[MAX_TYPE];
 static struct kobject **cpuX_kobj[MAX_TYPE];
+static struct freq_arb_client *pnpmgr_client;
 
 struct pnp_cluster_info {
 	// hotplug
@@ -744,6 +747,21 @@ cpu_mask_info_show(struct kobject *kobj, struct kobj_attribute *attr,
 }
 power_attr_ro(cpu_mask_info);
 
+/*
+ * Hand the limits over to core_ctl so CPUs are parked by isolation in the
+ * kernel rather than hotplugged by the userspace daemon.
+ */
+static void mp_cpunum_apply(int type)
+{
+	unsigned int cpu = cpumask_first(&info[type].cpu_mask);
+
+	if (cpu >= nr_cpu_ids)
+		return;
+
+	core_ctl_set_limits(cpu, info[type].mp_cpunum_min,
+			    info[type].mp_cpunum_max);
+}
+
 define_cluster_info_show(mp_cpunum_max);
 static ssize_t
 mp_cpunum_max_store(struct kobject *kobj, struct kobj_attribute *attr,
@@ -759,6 +777,7 @@ mp_cpunum_max_store(struct kobject *kobj, struct kobj_attribute *attr,
 		if (val > info[type].num_cpus)
 			val = info[type].num_cpus;
 		info[type].mp_cpunum_max = val;
+		mp_cpunum_apply(type);
 		sysfs_notify(kobj, NULL, "mp_cpunum_max");
 		return n;
 	}
@@ -782,6 +801,7 @@ mp_cpunum_min_store(struct kobject *kobj, struct kobj_attribute *attr,
 		if (val > info[type].num_cpus)
 			val = info[type].num_cpus;
 		info[type].mp_cpunum_min = val;
+		mp_cpunum_apply(type);
 		sysfs_notify(kobj, NULL, "mp_cpunum_min");
 		return n;
 	}
@@ -890,65 +910,43 @@ power_attr_ro(max_freq_info);
 define_cluster_info_show(min_freq_info);
 power_attr_ro(min_freq_info);
 
-static inline void scaling_freq_verify(struct cpufreq_policy *policy)
-{
-	cpufreq_verify_within_limits(policy, policy->cpuinfo.min_freq,
-			policy->cpuinfo.max_freq);
-}
-
-static ssize_t
-scaling_max_freq_show(struct kobject *kobj, struct kobj_attribute *attr,
-		char *buf)
+/*
+ * Vote a scaling limit for the cluster (sync) or the cpu (async) behind
+ * kobj. The vote is clamped to the cpuinfo range and stays until replaced.
+ */
+static ssize_t scaling_freq_vote(struct kobject *kobj, const char *buf,
+		size_t n, bool is_max)
 {
 	int type = get_cluster_type(kobj);
-	int fcpu, rcpu, ret = 0;
-	struct cpufreq_policy policy;
-
-	if (info[type].is_sync) {
-		for_each_cpu_and(rcpu, &info[type].cpu_mask, cpu_online_mask) {
-			ret = 1;
-			break;
-		}
-		if (!ret)
-			return -EINVAL;
-	} else {
-		sscanf(kobj->name, "cpu%d", &fcpu);
-		rcpu = info[type].cpu_seq[fcpu];
-		if (!cpu_online(rcpu))
-			return -EINVAL;
-	}
+	int fcpu, rcpu, val, ret = 0;
 
-	ret = cpufreq_get_policy(&policy, rcpu);
-	if (ret)
+	if (sscanf(buf, "%d", &val) <= 0)
 		return -EINVAL;
 
-	return sprintf(buf, "%u\n", policy.max);
-}
-static ssize_t
-scaling_max_freq_store(struct kobject *kobj, struct kobj_attribute *attr,
-		const char *buf, size_t n)
-{
-	int type = get_cluster_type(kobj);
-	int fcpu, rcpu, val, ret = 0;
-	struct cpufreq_policy new_policy, *policy = NULL;
+	val = clamp(val, info[type].min_freq_info, info[type].max_freq_info);
 
 	get_online_cpus();
 
-	/*
-	 * In sync cpu platform, sometime the first cpu isn't included in
-	 * the active cpus. It will make trouble if we only consider the
-	 * first cpu. So we should find the active cpu instead of the first
-	 * cpu in the cluster to apply our new setting.
-	 */
 	if (info[type].is_sync) {
+		/*
+		 * The policy is shared, but the cpu we find online may change
+		 * from one write to the next. Vote on every cpu of the cluster
+		 * so an older vote is never left behind on an offline one.
+		 */
 		for_each_cpu_and(rcpu, &info[type].cpu_mask, cpu_online_mask) {
 			ret = 1;
 			break;
 		}
 		if (!ret) {
-			//pr_warn("%s: No online cpus in cluster%d\n", __func__, type);
-			ret = -EPERM;
-			goto failure;
+			put_online_cpus();
+			return -EPERM;
+		}
+
+		for_each_cpu(rcpu, &info[type].cpu_mask) {
+			if (is_max)
+				freq_arb_set_max(pnpmgr_client, rcpu, val);
+			else
+				freq_arb_set_min(pnpmgr_client, rcpu, val);
 		}
 	} else {
 		/*
@@ -958,62 +956,25 @@ scaling_max_freq_store(struct kobject *kobj, struct kobj_attribute *attr,
 		rcpu = info[type].cpu_seq[fcpu];
 		if (!cpu_online(rcpu)) {
 			pr_warn("%s: cpu%d is offline in cluster%d\n", __func__, rcpu, type);
-			ret = -EPERM;
-			goto failure;
+			put_online_cpus();
+			return -EPERM;
 		}
-	}
 
-	// Verify the limits.
-	ret = cpufreq_get_policy(&new_policy, rcpu);
-	if (ret) {
-		pr_warn("%s: Fail to copy cpu%d policy\n", __func__, rcpu);
-		ret = -EPERM;
-		goto failure;
-	}
-	new_policy.max = new_policy.user_policy.max;
-	new_policy.min = new_policy.user_policy.min;
-
-	if (sscanf(buf, "%d", &val) > 0)
-		new_policy.max = val;
-
-	scaling_freq_verify(&new_policy);
-
-	// Now, we can start to update the frequency.
-	policy = cpufreq_cpu_get(rcpu);
-	if (!policy || !policy->governor) {
-		pr_warn("%s: cpu%d policy or governor is NULL\n", __func__, rcpu);
-		ret = -EPERM;
-		goto failure;
-	}
-
-	down_write(&policy->rwsem);
-	policy->user_policy.max = new_policy.max;
-	up_write(&policy->rwsem);
-
-	ret = cpufreq_update_policy(rcpu);
-
-	if (ret) {
-		pr_warn("%s: Fail to update cpu%d max freq to %d\n", __func__, rcpu, val);
-		ret = -EPERM;
-		goto failure;
+		if (is_max)
+			freq_arb_set_max(pnpmgr_client, rcpu, val);
+		else
+			freq_arb_set_min(pnpmgr_client, rcpu, val);
 	}
 
-	cpufreq_cpu_put(policy);
 	put_online_cpus();
-	return n;
 
-failure:
-	if (policy)
-		cpufreq_cpu_put(policy);
+	freq_arb_apply(pnpmgr_client, 0);
 
-	put_online_cpus();
-
-	return ret;
+	return n;
 }
-power_attr(scaling_max_freq);
 
 static ssize_t
-scaling_min_freq_show(struct kobject *kobj, struct kobj_attribute *attr,
+scaling_max_freq_show(struct kobject *kobj, struct kobj_attribute *attr,
 		char *buf)
 {
 	int type = get_cluster_type(kobj);
@@ -1038,94 +999,49 @@ scaling_min_freq_show(struct kobject *kobj, struct kobj_attribute *attr,
 	if (ret)
 		return -EINVAL;
 
-	return sprintf(buf, "%u\n", policy.min);
+	return sprintf(buf, "%u\n", policy.max);
 }
 static ssize_t
-scaling_min_freq_store(struct kobject *kobj, struct kobj_attribute *attr,
+scaling_max_freq_store(struct kobject *kobj, struct kobj_attribute *attr,
 		const char *buf, size_t n)
 {
-	int type = get_cluster_type(kobj);
-	int fcpu, rcpu, val, ret = 0;
-	struct cpufreq_policy new_policy, *policy = NULL;
+	return scaling_freq_vote(kobj, buf, n, true);
+}
+power_attr(scaling_max_freq);
 
-	get_online_cpus();
+static ssize_t
+scaling_min_freq_show(struct kobject *kobj, struct kobj_attribute *attr,
+		char *buf)
+{
+	int type = get_cluster_type(kobj);
+	int fcpu, rcpu, ret = 0;
+	struct cpufreq_policy policy;
 
-	/*
-	 * In sync cpu platform, sometime the first cpu isn't included in
-	 * the active cpus. It will make trouble if we only consider the
-	 * first cpu. So we should find the active cpu instead of the first
-	 * cpu in the cluster to apply our new setting.
-	 */
 	if (info[type].is_sync) {
 		for_each_cpu_and(rcpu, &info[type].cpu_mask, cpu_online_mask) {
 			ret = 1;
 			break;
 		}
-		if (!ret) {
-			//pr_warn("%s: No online cpus in cluster%d\n", __func__, type);
-			ret = -EPERM;
-			goto failure;
-		}
+		if (!ret)
+			return -EINVAL;
 	} else {
-		/*
-		 * In async cpu platform, the fcpu is treated as the cpu order.
-		 */
 		sscanf(kobj->name, "cpu%d", &fcpu);
 		rcpu = info[type].cpu_seq[fcpu];
-		if (!cpu_online(rcpu)) {
-			pr_warn("%s: cpu%d is offline in cluster%d\n", __func__, rcpu, type);
-			ret = -EPERM;
-			goto failure;
-		}
-	}
-
-	// Verify the limits.
-	ret = cpufreq_get_policy(&new_policy, rcpu);
-	if (ret) {
-		pr_warn("%s: Fail to copy cpu%d policy\n", __func__, rcpu);
-		ret = -EPERM;
-		goto failure;
-	}
-
-	new_policy.max = new_policy.user_policy.max;
-	new_policy.min = new_policy.user_policy.min;
-
-	if (sscanf(buf, "%d", &val) > 0)
-		new_policy.min = val;
-
-	scaling_freq_verify(&new_policy);
-
-	// Now, we can start to update the frequency.
-	policy = cpufreq_cpu_get(rcpu);
-	if (!policy || !policy->governor) {
-		pr_warn("%s: cpu%d policy or governor is NULL\n", __func__, rcpu);
-		ret = -EPERM;
-		goto failure;
-	}
-
-	down_write(&policy->rwsem);
-	policy->user_policy.min = new_policy.min;
-	up_write(&policy->rwsem);
-
-	ret = cpufreq_update_policy(rcpu);
-
-	if (ret) {
-		pr_warn("%s: Fail to update cpu%d min freq to %d\n", __func__, rcpu, val);
-		ret = -EPERM;
-		goto failure;
+		if (!cpu_online(rcpu))
+			return -EINVAL;
 	}
 
-	cpufreq_cpu_put(policy);
-	put_online_cpus();
-	return n;
-
-failure:
-	if (policy)
-		cpufreq_cpu_put(policy);
-
-	put_online_cpus();
+	ret = cpufreq_get_policy(&policy, rcpu);
+	if (ret)
+		return -EINVAL;
 
-	return ret;
+	return sprintf(buf, "%u\n", policy.min);
+}
+static ssize_t
+scaling_min_freq_store(struct kobject *kobj, struct kobj_attribute *attr,
+		const char *buf, size_t n)
+{
+	return scaling_freq_vote(kobj, buf, n, false);
 }
 power_attr(scaling_min_freq);
 
@@ -1558,6 +1474,13 @@ static int __init pnpmgr_init(void)
 	if ((ret = init_cluster_info()) < 0)
 		goto err;
 
+	pnpmgr_client = freq_arb_register("pnpmgr", FREQ_ARB_PRIO_PNPMGR);
+	if (IS_ERR(pnpmgr_client)) {
+		ret = PTR_ERR(pnpmgr_client);
+		pnpmgr_client = NULL;
+		goto err;
+	}
+
 	for (i = 0; i < cluster_cnt; i++) {
 		cluster_kobj[i] = kobject_create_and_add(name[i], cluster_root_kobj);
 		if (!cluster_kobj[i]) {
@@ -305,6 +305,7 @@ static int pm_qos_dbg_show_requests(struct seq_file *s, void *unused)
 	unsigned long flags;
 	int tot_reqs = 0;
 	int active_reqs = 0;
+	int cpu;
 
 	if (IS_ERR_OR_NULL(qos)) {
 		pr_err("%s: bad qos param!\n", __func__);
@@ -352,6 +353,9 @@ static int pm_qos_dbg_show_requests(struct seq_file *s, void *unused)
 	seq_printf(s, "Type=%s, Value=%d, Requests: active=%d / total=%d\n",
 		   type, pm_qos_get_value(c), active_reqs, tot_reqs);
 
+	for_each_possible_cpu(cpu)
+		seq_printf(s, "CPU%d: %d\n", cpu, c->target_per_cpu[cpu]);
+
 out:
 	spin_unlock_irqrestore(&pm_qos_lock, flags);
 	return 0;
@@ -0,0 +1,40 @@
+/*
+ * kernel/power/wake_intent.c
+ *
+ * Notifier chain for early signs of an upcoming screen on, see
+ * <linux/wake_intent.h>.
+ *
+ * This software is licensed under the terms of the GNU General Public
+ * License version 2, as published by the Free Software Foundation, and
+ * may be copied, distributed, and modified under those terms.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <linux/export.h>
+#include <linux/notifier.h>
+#include <linux/wake_intent.h>
+
+static ATOMIC_NOTIFIER_HEAD(wake_intent_notifier_list);
+
+int wake_intent_register_notifier(struct notifier_block *nb)
+{
+	return atomic_notifier_chain_register(&wake_intent_notifier_list, nb);
+}
+EXPORT_SYMBOL_GPL(wake_intent_register_notifier);
+
+int wake_intent_unregister_notifier(struct notifier_block *nb)
+{
+	return atomic_notifier_chain_unregister(&wake_intent_notifier_list,
+						nb);
+}
+EXPORT_SYMBOL_GPL(wake_intent_unregister_notifier);
+
+void wake_intent_notify(enum wake_intent_source source)
+{
+	atomic_notifier_call_chain(&wake_intent_notifier_list, source, NULL);
+}
+EXPORT_SYMBOL_GPL(wake_intent_notify);
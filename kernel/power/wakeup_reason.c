@@ -27,8 +27,12 @@
 #include <linux/notifier.h>
 #include <linux/suspend.h>
 #include <linux/slab.h>
+#include <linux/kernel_stat.h>
+#include <linux/mutex.h>
 
 #define MAX_WAKEUP_REASON_IRQS 32
+#define MAX_WAKEUP_STATS 32
+#define WAKEUP_STAT_NAME_LEN 32
 static bool suspend_abort;
 static char abort_reason[MAX_SUSPEND_ABORT_LEN];
 
@@ -48,6 +52,30 @@ static ktime_t curr_monotime; /* monotonic time after last suspend */
 static ktime_t last_stime; /* monotonic boottime offset before last suspend */
 static ktime_t curr_stime; /* monotonic boottime offset after last suspend */
 
+/*
+ * Cost of the wakeups caused by each IRQ: how long the system stayed awake
+ * until the next suspend attempt, how much CPU time was spent in that window
+ * and how many wakeup events were reported during it. The last slot
+ * collects everything once the table is full.
+ */
+struct wakeup_stat {
+	int irq;
+	char name[WAKEUP_STAT_NAME_LEN];
+	u64 count;
+	u64 awake_ns;
+	u64 cpu_ns;
+	u64 events;
+};
+
+static struct wakeup_stat wakeup_stats[MAX_WAKEUP_STATS];
+static int nr_wakeup_stats;
+static DEFINE_MUTEX(wakeup_stats_lock);
+/* the wakeup currently being accounted, NULL when none */
+static struct wakeup_stat *cur_wakeup_stat;
+static ktime_t cur_wakeup_start;
+static u64 cur_wakeup_cputime;
+static unsigned int cur_wakeup_events;
+
 static void init_wakeup_irq_node(struct wakeup_irq_node *p, int irq)
 {
 	p->irq = irq;
@@ -282,12 +310,122 @@ static ssize_t last_suspend_time_show(struct kobject *kobj,
 				sleep_time.tv_sec, sleep_time.tv_nsec);
 }
 
+static u64 wakeup_stat_cputime(void)
+{
+	u64 sum = 0;
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		u64 *cpustat = kcpustat_cpu(cpu).cpustat;
+
+		sum += cpustat[CPUTIME_USER] + cpustat[CPUTIME_NICE] +
+			cpustat[CPUTIME_SYSTEM] + cpustat[CPUTIME_IRQ] +
+			cpustat[CPUTIME_SOFTIRQ];
+	}
+	return sum;
+}
+
+static struct wakeup_stat *wakeup_stat_get(struct wakeup_irq_node *n)
+{
+	struct wakeup_stat *ws;
+	int i;
+
+	for (i = 0; i < nr_wakeup_stats; i++)
+		if (wakeup_stats[i].irq == n->irq)
+			return &wakeup_stats[i];
+
+	if (nr_wakeup_stats == MAX_WAKEUP_STATS - 1) {
+		ws = &wakeup_stats[MAX_WAKEUP_STATS - 1];
+		ws->irq = -1;
+		strlcpy(ws->name, "other", sizeof(ws->name));
+		return ws;
+	}
+
+	ws = &wakeup_stats[nr_wakeup_stats++];
+	ws->irq = n->irq;
+	if (n->desc && n->desc->action && n->desc->action->name)
+		strlcpy(ws->name, n->desc->action->name, sizeof(ws->name));
+	else
+		strlcpy(ws->name, "unknown", sizeof(ws->name));
+	return ws;
+}
+
+/* Called after resume, once the wakeup IRQs are known */
+static void wakeup_stat_start(void)
+{
+	struct wakeup_irq_node *n;
+
+	if (suspend_abort)
+		return;
+
+	n = list_first_entry_or_null(&wakeup_irqs, struct wakeup_irq_node,
+				     next);
+	if (!n)
+		return;
+
+	mutex_lock(&wakeup_stats_lock);
+	cur_wakeup_stat = wakeup_stat_get(n);
+	cur_wakeup_stat->count++;
+	cur_wakeup_start = ktime_get();
+	cur_wakeup_cputime = wakeup_stat_cputime();
+	pm_get_wakeup_count(&cur_wakeup_events, false);
+	mutex_unlock(&wakeup_stats_lock);
+}
+
+/* Called on the next suspend attempt to charge the awake window */
+static void wakeup_stat_stop(void)
+{
+	struct wakeup_stat *ws;
+	unsigned int events = 0;
+	u64 cputime;
+
+	mutex_lock(&wakeup_stats_lock);
+	ws = cur_wakeup_stat;
+	if (ws) {
+		cputime = wakeup_stat_cputime() - cur_wakeup_cputime;
+		pm_get_wakeup_count(&events, false);
+		ws->awake_ns += ktime_to_ns(ktime_sub(ktime_get(),
+						      cur_wakeup_start));
+		ws->cpu_ns += cputime_to_nsecs((__force cputime_t)cputime);
+		ws->events += events - cur_wakeup_events;
+		cur_wakeup_stat = NULL;
+	}
+	mutex_unlock(&wakeup_stats_lock);
+}
+
+static ssize_t wakeup_stats_show(struct kobject *kobj,
+			struct kobj_attribute *attr, char *buf)
+{
+	struct wakeup_stat *ws;
+	int i, len;
+
+	mutex_lock(&wakeup_stats_lock);
+	len = scnprintf(buf, PAGE_SIZE,
+			"irq\tname\tcount\tawake_ms\tcpu_ms\tevents\n");
+	for (i = 0; i < MAX_WAKEUP_STATS; i++) {
+		ws = &wakeup_stats[i];
+		if (!ws->count)
+			continue;
+		len += scnprintf(buf + len, PAGE_SIZE - len,
+				"%d\t%s\t%llu\t%llu\t%llu\t%llu\n",
+				ws->irq, ws->name, ws->count,
+				div_u64(ws->awake_ns, NSEC_PER_MSEC),
+				div_u64(ws->cpu_ns, NSEC_PER_MSEC),
+				ws->events);
+	}
+	mutex_unlock(&wakeup_stats_lock);
+
+	return len;
+}
+
 static struct kobj_attribute resume_reason = __ATTR_RO(last_resume_reason);
 static struct kobj_attribute suspend_time = __ATTR_RO(last_suspend_time);
+static struct kobj_attribute wakeup_stats_attr = __ATTR_RO(wakeup_stats);
 
 static struct attribute *attrs[] = {
 	&resume_reason.attr,
 	&suspend_time.attr,
+	&wakeup_stats_attr.attr,
 	NULL,
 };
 static struct attribute_group attr_group = {
@@ -549,6 +687,7 @@ static int wakeup_reason_pm_event(struct notifier_block *notifier,
 	unsigned long flags;
 	switch (pm_event) {
 	case PM_SUSPEND_PREPARE:
+		wakeup_stat_stop();
 		spin_lock_irqsave(&resume_reason_lock, flags);
 		suspend_abort = false;
 		spin_unlock_irqrestore(&resume_reason_lock, flags);
@@ -572,6 +711,7 @@ static int wakeup_reason_pm_event(struct notifier_block *notifier,
 #else
 		print_wakeup_sources();
 #endif
+		wakeup_stat_start();
 		break;
 	default:
 		break;
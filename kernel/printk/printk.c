@@ -43,6 +43,7 @@
 #include <linux/rculist.h>
 #include <linux/poll.h>
 #include <linux/irq_work.h>
+#include <linux/kthread.h>
 #include <linux/utsname.h>
 #include <linux/ctype.h>
 #include <linux/uio.h>
@@ -1665,6 +1666,43 @@ static inline void printk_delay(void)
 	}
 }
 
+/*
+ * printk() only stores the message and leaves the consoles to the printk
+ * kthread, so that a slow console does not stall the CPU that logs. The
+ * caller still writes the consoles itself before the kthread is up, while
+ * the system goes down, during an oops, panic or WARN(), for messages of
+ * KERN_CRIT and above, and when printk.synchronous is set. Those must not
+ * be lost if this CPU locks up before the kthread gets to run.
+ */
+static bool printk_sync;
+module_param_named(synchronous, printk_sync, bool, S_IRUGO | S_IWUSR);
+
+static atomic_t printk_sync_count = ATOMIC_INIT(0);
+static struct task_struct *printk_kthread;
+
+static inline bool printk_offload_console(void)
+{
+	return !printk_sync && printk_kthread && !oops_in_progress &&
+		!atomic_read(&printk_sync_count) &&
+		system_state == SYSTEM_RUNNING;
+}
+
+/*
+ * Have the consoles written by the printk() callers themselves until
+ * the matching printk_sync_exit(), as for an oops.
+ */
+void printk_sync_enter(void)
+{
+	atomic_inc(&printk_sync_count);
+}
+
+void printk_sync_exit(void)
+{
+	atomic_dec(&printk_sync_count);
+}
+
+static void defer_console_output(void);
+
 /*
  * Continuation lines are buffered, and not committed to the record buffer
  * until the line is complete, or a race forces it. The line fragments
@@ -1938,7 +1976,9 @@ asmlinkage int vprintk_emit(int facility, int level,
 	local_irq_restore(flags);
 
 	/* If called from the scheduler, we can not call up(). */
-	if (!in_sched) {
+	if (!in_sched && level > LOGLEVEL_CRIT && printk_offload_console()) {
+		defer_console_output();
+	} else if (!in_sched) {
 		lockdep_off();
 		/*
 		 * Disable preemption to avoid being preempted while holding
@@ -2849,15 +2889,20 @@ late_initcall(printk_late_init);
 #define PRINTK_PENDING_OUTPUT	0x02
 
 static DEFINE_PER_CPU(int, printk_pending);
+static bool printk_kthread_pending;
 
 static void wake_up_klogd_work_func(struct irq_work *irq_work)
 {
 	int pending = __this_cpu_xchg(printk_pending, 0);
 
 	if (pending & PRINTK_PENDING_OUTPUT) {
-		/* If trylock fails, someone else is doing the printing */
-		if (console_trylock())
+		if (printk_offload_console()) {
+			WRITE_ONCE(printk_kthread_pending, true);
+			wake_up_process(printk_kthread);
+		} else if (console_trylock()) {
+			/* If trylock fails, someone else is doing the printing */
 			console_unlock();
+		}
 	}
 
 	if (pending & PRINTK_PENDING_WAKEUP)
@@ -2889,12 +2934,57 @@ int printk_deferred(const char *fmt, ...)
 	r = vprintk_emit(0, LOGLEVEL_SCHED, NULL, 0, fmt, args);
 	va_end(args);
 
+	defer_console_output();
+	preempt_enable();
+
+	return r;
+}
+
+/*
+ * Have the consoles written from irq_work, by the printk kthread when
+ * output is offloaded: waking it up from here could take the rq lock that
+ * the caller of printk() may hold.
+ */
+static void defer_console_output(void)
+{
+	preempt_disable();
 	__this_cpu_or(printk_pending, PRINTK_PENDING_OUTPUT);
 	irq_work_queue(this_cpu_ptr(&wake_up_klogd_work));
 	preempt_enable();
+}
 
-	return r;
+static int printk_kthread_func(void *data)
+{
+	while (!kthread_should_stop()) {
+		set_current_state(TASK_INTERRUPTIBLE);
+		if (!READ_ONCE(printk_kthread_pending))
+			schedule();
+		__set_current_state(TASK_RUNNING);
+
+		/* anything logged from here on needs another pass */
+		WRITE_ONCE(printk_kthread_pending, false);
+		console_lock();
+		console_unlock();
+	}
+	return 0;
+}
+
+static int __init init_printk_kthread(void)
+{
+	struct sched_param param = { .sched_priority = 1 };
+	struct task_struct *task;
+
+	task = kthread_run(printk_kthread_func, NULL, "printk");
+	if (IS_ERR(task)) {
+		pr_err("printk: unable to create printing thread\n");
+		return PTR_ERR(task);
+	}
+	/* don't let a busy CFS load hold the console back indefinitely */
+	sched_setscheduler(task, SCHED_FIFO, &param);
+	printk_kthread = task;
+	return 0;
 }
+late_initcall(init_printk_kthread);
 
 /*
  * printk rate limiting, lifted from the networking subsystem.
@@ -217,6 +217,7 @@ static void sugov_get_util(unsigned long *util, unsigned long *max, u64 time)
 	if (use_pelt())
 		*util = *util + rt;
 
+	*util = uclamp_rq_util(rq, *util);
 	*util = min(*util, max_cap);
 	*max = max_cap;
 }
@@ -21,27 +21,38 @@
 #define DEBUG
 
 #include <linux/gfp.h>
+#include <linux/init.h>
+#include <linux/kobject.h>
 #include <linux/of.h>
 #include <linux/printk.h>
 #include <linux/sched.h>
 #include <linux/sched_energy.h>
 #include <linux/stddef.h>
+#include <linux/string.h>
+#include <linux/sysfs.h>
+
+#include "sched.h"
 
 struct sched_group_energy *sge_array[NR_CPUS][NR_SD_LEVELS];
 
+static void free_sge(struct sched_group_energy *sge)
+{
+	if (!sge)
+		return;
+
+	kfree(sge->cap_states);
+	kfree(sge->idle_states);
+	kfree(sge);
+}
+
 static void free_resources(void)
 {
 	int cpu, sd_level;
-	struct sched_group_energy *sge;
 
 	for_each_possible_cpu(cpu) {
 		for_each_possible_sd_level(sd_level) {
-			sge = sge_array[cpu][sd_level];
-			if (sge) {
-				kfree(sge->cap_states);
-				kfree(sge->idle_states);
-				kfree(sge);
-			}
+			free_sge(sge_array[cpu][sd_level]);
+			sge_array[cpu][sd_level] = NULL;
 		}
 	}
 }
@@ -135,3 +146,376 @@ void init_sched_energy_costs(void)
 out:
 	free_resources();
 }
+
+/*
+ * Runtime replacement of the energy costs
+ *
+ * /sys/kernel/sched_energy/costs reads back the tables in use, one line
+ * per CPU and sd level:
+ *
+ *   <cpu> <level> busy <cap0> <power0> <cap1> <power1> ... idle <power0> ...
+ *
+ * Writing lines in the same format, with a cpulist in place of <cpu>,
+ * replaces the tables of those CPUs. A write is applied as a whole or not
+ * at all. The new tables must keep the number of capacity and idle states
+ * of the ones they replace, since the scheduler reads them without
+ * locking, and must agree for all CPUs sharing a sched group.
+ *
+ * The read back is limited to a page. Should the tables not fit, only
+ * whole lines are shown, followed by a "# truncated" line that a write
+ * of the output rejects.
+ */
+#define ENERGY_MAX_STATES	32
+
+struct energy_line {
+	unsigned long busy[2 * ENERGY_MAX_STATES];
+	unsigned long idle[ENERGY_MAX_STATES];
+};
+
+#define STAGED(stage, cpu, level)	((stage)[(cpu) * NR_SD_LEVELS + (level)])
+
+static struct sched_group_energy *
+staged_sge(struct sched_group_energy **stage, int cpu, int sd_level)
+{
+	return STAGED(stage, cpu, sd_level) ?: sge_array[cpu][sd_level];
+}
+
+static bool sge_equal(const struct sched_group_energy *a,
+		      const struct sched_group_energy *b)
+{
+	if (a->nr_cap_states != b->nr_cap_states ||
+	    a->nr_idle_states != b->nr_idle_states)
+		return false;
+
+	return !memcmp(a->cap_states, b->cap_states,
+		       a->nr_cap_states * sizeof(*a->cap_states)) &&
+	       !memcmp(a->idle_states, b->idle_states,
+		       a->nr_idle_states * sizeof(*a->idle_states));
+}
+
+static struct sched_group_energy *
+alloc_sge(const struct energy_line *el, int nr_cap, int nr_idle)
+{
+	struct sched_group_energy *sge;
+	int i;
+
+	sge = kzalloc(sizeof(*sge), GFP_KERNEL);
+	if (!sge)
+		return NULL;
+
+	sge->cap_states = kcalloc(nr_cap, sizeof(struct capacity_state),
+				  GFP_KERNEL);
+	sge->idle_states = kcalloc(nr_idle, sizeof(struct idle_state),
+				   GFP_KERNEL);
+	if (!sge->cap_states || !sge->idle_states) {
+		free_sge(sge);
+		return NULL;
+	}
+
+	for (i = 0; i < nr_cap; i++) {
+		sge->cap_states[i].cap = el->busy[2 * i];
+		sge->cap_states[i].power = el->busy[2 * i + 1];
+	}
+	sge->nr_cap_states = nr_cap;
+
+	for (i = 0; i < nr_idle; i++)
+		sge->idle_states[i].power = el->idle[i];
+	sge->nr_idle_states = nr_idle;
+
+	return sge;
+}
+
+/*
+ * Capacities must grow with the busy power, up to SCHED_CAPACITY_SCALE,
+ * and deeper idle states can't cost more than shallower ones.
+ */
+static bool energy_line_valid(const struct energy_line *el,
+			      int nr_cap, int nr_idle)
+{
+	int i;
+
+	for (i = 0; i < nr_cap; i++) {
+		if (!el->busy[2 * i] || el->busy[2 * i] > SCHED_CAPACITY_SCALE)
+			return false;
+		if (i && (el->busy[2 * i] <= el->busy[2 * (i - 1)] ||
+			  el->busy[2 * i + 1] < el->busy[2 * (i - 1) + 1]))
+			return false;
+	}
+
+	for (i = 1; i < nr_idle; i++)
+		if (el->idle[i] > el->idle[i - 1])
+			return false;
+
+	return true;
+}
+
+static int parse_costs_line(char *line, struct sched_group_energy **stage,
+			    struct energy_line *el)
+{
+	int nr_busy = 0, nr_idle = 0, *nr = NULL;
+	struct sched_group_energy *old, *sge;
+	unsigned long *vals = NULL, val;
+	cpumask_var_t cpus;
+	int max = 0, level, cpu, ret;
+	char *tok;
+
+	if (!alloc_cpumask_var(&cpus, GFP_KERNEL))
+		return -ENOMEM;
+
+	ret = -EINVAL;
+	tok = strsep(&line, " \t");
+	if (!tok || cpulist_parse(tok, cpus) || cpumask_empty(cpus) ||
+	    !cpumask_subset(cpus, cpu_possible_mask))
+		goto out;
+
+	tok = strsep(&line, " \t");
+	if (!tok || kstrtoint(tok, 0, &level) ||
+	    level < 0 || level >= NR_SD_LEVELS)
+		goto out;
+
+	while ((tok = strsep(&line, " \t"))) {
+		if (!*tok)
+			continue;
+
+		if (!strcmp(tok, "busy")) {
+			vals = el->busy;
+			nr = &nr_busy;
+			max = ARRAY_SIZE(el->busy);
+			continue;
+		}
+		if (!strcmp(tok, "idle")) {
+			vals = el->idle;
+			nr = &nr_idle;
+			max = ARRAY_SIZE(el->idle);
+			continue;
+		}
+
+		if (!vals || *nr == max || kstrtoul(tok, 0, &val))
+			goto out;
+		vals[(*nr)++] = val;
+	}
+
+	if (!nr_busy || nr_busy % 2 || !nr_idle ||
+	    !energy_line_valid(el, nr_busy / 2, nr_idle))
+		goto out;
+
+	for_each_cpu(cpu, cpus) {
+		old = sge_array[cpu][level];
+		if (!old || old->nr_cap_states != nr_busy / 2 ||
+		    old->nr_idle_states != nr_idle)
+			goto out;
+
+		sge = alloc_sge(el, nr_busy / 2, nr_idle);
+		if (!sge) {
+			ret = -ENOMEM;
+			goto out;
+		}
+
+		free_sge(STAGED(stage, cpu, level));
+		STAGED(stage, cpu, level) = sge;
+	}
+
+	ret = 0;
+out:
+	free_cpumask_var(cpus);
+	return ret;
+}
+
+/* All the CPUs sharing a sched group must also share its energy data */
+static int check_costs(struct sched_group_energy **stage)
+{
+	const struct cpumask *span;
+	int cpu, level, i;
+
+	for_each_possible_cpu(cpu) {
+		for_each_possible_sd_level(level) {
+			if (!STAGED(stage, cpu, level))
+				continue;
+
+			span = sched_energy_span(cpu, level);
+			if (!span)
+				return -EINVAL;
+
+			for_each_cpu(i, span) {
+				if (!sge_equal(staged_sge(stage, cpu, level),
+					       staged_sge(stage, i, level)))
+					return -EINVAL;
+			}
+		}
+	}
+
+	return 0;
+}
+
+/*
+ * Point the sched groups built from the replaced tables to the new ones
+ * and install those in sge_array[] for future domain rebuilds. The old
+ * tables are handed back in @stage, to be freed once no reader can see
+ * them anymore.
+ */
+static void swap_costs(struct sched_group_energy **stage)
+{
+	struct sched_group_energy *old;
+	struct sched_domain *sd;
+	struct sched_group *sg;
+	int cpu, level, b;
+
+	for_each_online_cpu(cpu) {
+		for_each_domain(cpu, sd) {
+			sg = sd->groups;
+			if (!sg->sge)
+				continue;
+
+			b = group_balance_cpu(sg);
+			for_each_possible_sd_level(level) {
+				if (sg->sge != sge_array[b][level] ||
+				    !STAGED(stage, b, level))
+					continue;
+
+				smp_store_release(&sg->sge,
+						  STAGED(stage, b, level));
+				break;
+			}
+		}
+	}
+
+	for_each_possible_cpu(cpu) {
+		for_each_possible_sd_level(level) {
+			if (!STAGED(stage, cpu, level))
+				continue;
+
+			old = sge_array[cpu][level];
+			sge_array[cpu][level] = STAGED(stage, cpu, level);
+			STAGED(stage, cpu, level) = old;
+		}
+	}
+
+	sched_energy_sysctl_refresh();
+	synchronize_rcu();
+}
+
+#define COSTS_TRUNCATED		"# truncated\n"
+
+/*
+ * Format the costs line of @cpu at @level into @buf of @size bytes.
+ * Returns its length, or -ENOSPC if the whole line does not fit.
+ */
+static int costs_show_line(char *buf, size_t size, int cpu, int level,
+			   struct sched_group_energy *sge)
+{
+	size_t len;
+	int i;
+
+	len = scnprintf(buf, size, "%d %d busy", cpu, level);
+	for (i = 0; i < sge->nr_cap_states; i++)
+		len += scnprintf(buf + len, size - len, " %lu %lu",
+				 sge->cap_states[i].cap,
+				 sge->cap_states[i].power);
+	len += scnprintf(buf + len, size - len, " idle");
+	for (i = 0; i < sge->nr_idle_states; i++)
+		len += scnprintf(buf + len, size - len, " %lu",
+				 sge->idle_states[i].power);
+	len += scnprintf(buf + len, size - len, "\n");
+
+	/* scnprintf() stops one short of size, and the newline goes last */
+	if (len + 1 >= size)
+		return -ENOSPC;
+	return len;
+}
+
+static ssize_t costs_show(struct kobject *kobj, struct kobj_attribute *attr,
+			  char *buf)
+{
+	/* always leave room for the truncation marker */
+	const size_t size = PAGE_SIZE - strlen(COSTS_TRUNCATED);
+	struct sched_group_energy *sge;
+	int cpu, level, ret;
+	ssize_t len = 0;
+
+	mutex_lock(&sched_domains_mutex);
+	for_each_possible_cpu(cpu) {
+		for_each_possible_sd_level(level) {
+			sge = sge_array[cpu][level];
+			if (!sge)
+				continue;
+
+			ret = costs_show_line(buf + len, size - len, cpu,
+					      level, sge);
+			if (ret < 0) {
+				len += scnprintf(buf + len, PAGE_SIZE - len,
+						 COSTS_TRUNCATED);
+				goto unlock;
+			}
+			len += ret;
+		}
+	}
+unlock:
+	mutex_unlock(&sched_domains_mutex);
+
+	return len;
+}
+
+static ssize_t costs_store(struct kobject *kobj, struct kobj_attribute *attr,
+			   const char *buf, size_t count)
+{
+	int nr_slots = nr_cpu_ids * NR_SD_LEVELS;
+	struct sched_group_energy **stage;
+	char *data, *cur, *line;
+	struct energy_line *el;
+	int i, ret = -ENOMEM;
+
+	data = kstrndup(buf, count, GFP_KERNEL);
+	stage = kcalloc(nr_slots, sizeof(*stage), GFP_KERNEL);
+	el = kmalloc(sizeof(*el), GFP_KERNEL);
+	if (!data || !stage || !el)
+		goto out;
+
+	mutex_lock(&sched_domains_mutex);
+
+	cur = data;
+	while ((line = strsep(&cur, "\n"))) {
+		line = strim(line);
+		if (!*line)
+			continue;
+
+		ret = parse_costs_line(line, stage, el);
+		if (ret)
+			goto unlock;
+	}
+
+	ret = check_costs(stage);
+	if (!ret) {
+		swap_costs(stage);
+		pr_info("Sched-energy-costs updated\n");
+	}
+
+unlock:
+	mutex_unlock(&sched_domains_mutex);
+	for (i = 0; i < nr_slots; i++)
+		free_sge(stage[i]);
+out:
+	kfree(el);
+	kfree(stage);
+	kfree(data);
+
+	return ret ? ret : count;
+}
+
+static struct kobj_attribute costs_attr = __ATTR_RW(costs);
+
+static int __init sched_energy_sysfs_init(void)
+{
+	struct kobject *kobj;
+	int ret;
+
+	kobj = kobject_create_and_add("sched_energy", kernel_kobj);
+	if (!kobj)
+		return -ENOMEM;
+
+	ret = sysfs_create_file(kobj, &costs_attr.attr);
+	if (ret)
+		kobject_put(kobj);
+
+	return ret;
+}
+late_initcall(sched_energy_sysfs_init);
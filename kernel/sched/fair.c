@@ -2638,11 +2638,13 @@ int sched_set_wake_up_idle(struct task_struct *p, int wake_up_idle)
 }
 EXPORT_SYMBOL(sched_set_wake_up_idle);
 
+#ifndef CONFIG_SCHED_CORE_CTL
 int core_ctl_set_boost(bool boost)
 {
 	return 0;
 }
 EXPORT_SYMBOL(core_ctl_set_boost);
+#endif
 
 #ifdef CONFIG_SMP
 static const u32 runnable_avg_yN_inv[] = {
@@ -6321,7 +6323,7 @@ boosted_task_util(struct task_struct *p)
 
 	trace_sched_boost_task(p, util, margin);
 
-	return util + margin;
+	return uclamp_task_util(p, util + margin);
 }
 
 static unsigned long capacity_spare_wake(int cpu, struct task_struct *p)
@@ -6559,7 +6561,7 @@ static int select_idle_sibling(struct task_struct *p, int prev, int target)
 	schedstat_inc(this_rq(), eas_stats.sis_attempts);
 
 	if (!sysctl_sched_cstate_aware) {
-		if (idle_cpu(target)) {
+		if (idle_cpu(target) && !cpu_isolated(target)) {
 			schedstat_inc(p, se.statistics.nr_wakeups_sis_idle);
 			schedstat_inc(this_rq(), eas_stats.sis_idle);
 			return target;
@@ -6568,7 +6570,8 @@ static int select_idle_sibling(struct task_struct *p, int prev, int target)
 		/*
 		 * If the prevous cpu is cache affine and idle, don't be stupid.
 		 */
-		if (prev != target && cpus_share_cache(prev, target) && idle_cpu(prev)) {
+		if (prev != target && cpus_share_cache(prev, target) &&
+		    idle_cpu(prev) && !cpu_isolated(prev)) {
 			schedstat_inc(p, se.statistics.nr_wakeups_sis_cache_affine);
 			schedstat_inc(this_rq(), eas_stats.sis_cache_affine);
 			return prev;
@@ -6593,6 +6596,9 @@ static int select_idle_sibling(struct task_struct *p, int prev, int target)
 					unsigned long new_usage = boosted_task_util(p);
 					unsigned long capacity_orig = capacity_orig_of(i);
 
+					if (cpu_isolated(i))
+						continue;
+
 					if (new_usage > capacity_orig || !idle_cpu(i))
 						goto next;
 
@@ -6612,7 +6618,8 @@ static int select_idle_sibling(struct task_struct *p, int prev, int target)
 				}
 			} else {
 				for_each_cpu(i, sched_group_cpus(sg)) {
-					if (i == target || !idle_cpu(i))
+					if (i == target || !idle_cpu(i) ||
+					    cpu_isolated(i))
 						goto next;
 				}
 
@@ -6718,14 +6725,28 @@ static int start_cpu(bool boosted)
 	return boosted ? rd->max_cap_orig_cpu : rd->min_cap_orig_cpu;
 }
 
+/*
+ * Exit latency of the idle state @cpu is in, as reported by the cpuidle
+ * driver. A CPU that is idle but not in any state yet is the cheapest to
+ * wake up. Needs to be called within an RCU read side section.
+ */
+static inline unsigned int idle_exit_latency(int cpu)
+{
+	struct cpuidle_state *idle = idle_get_state(cpu_rq(cpu));
+
+	return idle ? idle->exit_latency : 0;
+}
+
 static inline int find_best_target(struct task_struct *p, int *backup_cpu,
-				   bool boosted, bool prefer_idle)
+				   bool boosted, bool prefer_idle,
+				   bool latency_sensitive, int reserved_cpu)
 {
 	unsigned long min_util = boosted_task_util(p);
 	unsigned long target_capacity = ULONG_MAX;
 	unsigned long min_wake_util = ULONG_MAX;
 	unsigned long target_max_spare_cap = 0;
 	unsigned long best_active_util = ULONG_MAX;
+	unsigned int best_exit_latency = UINT_MAX;
 	int best_idle_cstate = INT_MAX;
 	struct sched_domain *sd;
 	struct sched_group *sg;
@@ -6777,7 +6798,10 @@ static inline int find_best_target(struct task_struct *p, int *backup_cpu,
 			long spare_cap;
 			int idle_idx = INT_MAX;
 
-			if (!cpu_online(i))
+			if (!cpu_online(i) || cpu_isolated(i))
+				continue;
+
+			if (i == reserved_cpu)
 				continue;
 
 			if (walt_cpu_high_irqload(i))
@@ -6789,7 +6813,7 @@ static inline int find_best_target(struct task_struct *p, int *backup_cpu,
 			 * accounting. However, the blocked utilization may be zero.
 			 */
 			wake_util = cpu_util_wake(i, p);
-			new_util = wake_util + task_util(p);
+			new_util = wake_util + uclamp_task_util(p, task_util(p));
 
 			/*
 			 * Ensure minimum capacity to grant the required boost.
@@ -6853,6 +6877,30 @@ static inline int find_best_target(struct task_struct *p, int *backup_cpu,
 					schedstat_inc(p, se.statistics.nr_wakeups_fbt_pref_idle);
 					schedstat_inc(this_rq(), eas_stats.fbt_pref_idle);
 
+					/*
+					 * Latency sensitive tasks go for the
+					 * shallowest idle state first and
+					 * only then look at the capacity.
+					 */
+					if (latency_sensitive) {
+						unsigned int exit_latency =
+							idle_exit_latency(i);
+
+						if (exit_latency > best_exit_latency)
+							continue;
+						if (exit_latency == best_exit_latency &&
+						    (boosted ?
+						     capacity_orig <= target_capacity :
+						     capacity_orig >= target_capacity))
+							continue;
+
+						best_exit_latency = exit_latency;
+						target_capacity = capacity_orig;
+						best_idle_cstate = idle_idx;
+						best_idle_cpu = i;
+						continue;
+					}
+
 					if (boosted &&
 					    capacity_orig < target_capacity)
 						continue;
@@ -7077,8 +7125,9 @@ static int wake_cap(struct task_struct *p, int cpu, int prev_cpu)
 
 static int select_energy_cpu_brute(struct task_struct *p, int prev_cpu, int sync)
 {
-	bool boosted, prefer_idle;
+	bool boosted, prefer_idle, latency_sensitive;
 	struct sched_domain *sd;
+	int reserved_cpu = -1;
 	int target_cpu;
 	int backup_cpu;
 	int next_cpu;
@@ -7099,11 +7148,18 @@ static int select_energy_cpu_brute(struct task_struct *p, int prev_cpu, int sync
 #ifdef CONFIG_CGROUP_SCHEDTUNE
 	boosted = schedtune_task_boost(p) > 0;
 	prefer_idle = schedtune_prefer_idle(p) > 0;
+	latency_sensitive = schedtune_latency_sensitive(p) > 0;
+	if (schedtune_cpu_reserved(p))
+		reserved_cpu = cpu_rq(prev_cpu)->rd->max_cap_orig_cpu;
 #else
 	boosted = get_sysctl_sched_cfs_boost() > 0;
 	prefer_idle = 0;
+	latency_sensitive = 0;
 #endif
 
+	/* Latency sensitive tasks are placed as prefer_idle ones */
+	prefer_idle |= latency_sensitive;
+
 	sd = rcu_dereference(per_cpu(sd_ea, prev_cpu));
 	if (!sd) {
 		target_cpu = prev_cpu;
@@ -7113,7 +7169,8 @@ static int select_energy_cpu_brute(struct task_struct *p, int prev_cpu, int sync
 	sync_entity_load_avg(&p->se);
 
 	/* Find a cpu with sufficient capacity */
-	next_cpu = find_best_target(p, &backup_cpu, boosted, prefer_idle);
+	next_cpu = find_best_target(p, &backup_cpu, boosted, prefer_idle,
+				    latency_sensitive, reserved_cpu);
 	if (next_cpu == -1) {
 		target_cpu = prev_cpu;
 		goto out;
@@ -7153,6 +7210,12 @@ static int select_energy_cpu_brute(struct task_struct *p, int prev_cpu, int sync
 			p->state == TASK_WAKING)
 			delta = task_util(p);
 #endif
+		/* Leave the reserved CPU to the latency sensitive tasks */
+		if (prev_cpu == reserved_cpu) {
+			target_cpu = next_cpu;
+			goto out;
+		}
+
 		/* Not enough spare capacity on previous cpu */
 		if (__cpu_overutilized(prev_cpu, delta)) {
 			schedstat_inc(p, se.statistics.nr_wakeups_secb_insuff_cap);
@@ -9528,7 +9591,7 @@ static int load_balance(int this_cpu, struct rq *this_rq,
 	if (idle == CPU_NEWLY_IDLE)
 		env.dst_grpmask = NULL;
 
-	cpumask_copy(cpus, cpu_active_mask);
+	cpumask_andnot(cpus, cpu_active_mask, cpu_isolated_mask);
 
 	schedstat_inc(sd, lb_count[idle]);
 
@@ -9831,6 +9894,9 @@ static int idle_balance(struct rq *this_rq)
 	 */
 	this_rq->idle_stamp = rq_clock(this_rq);
 
+	if (cpu_isolated(this_cpu))
+		goto out;
+
 	if (!energy_aware() &&
 	    (this_rq->avg_idle < sysctl_sched_migration_cost ||
 	     !this_rq->rd->overload)) {
@@ -10332,7 +10398,8 @@ static void nohz_idle_balance(struct rq *this_rq, enum cpu_idle_type idle)
 		goto end;
 
 	for_each_cpu(balance_cpu, nohz.idle_cpus_mask) {
-		if (balance_cpu == this_cpu || !idle_cpu(balance_cpu))
+		if (balance_cpu == this_cpu || !idle_cpu(balance_cpu) ||
+		    cpu_isolated(balance_cpu))
 			continue;
 
 		/*
@@ -1822,6 +1822,59 @@ static int find_best_rt_target(struct task_struct* task, int cpu,
 	return target_cpu;
 }
 
+/*
+ * Latency sensitive RT tasks such as audio and display threads suffer
+ * most from a CPU that has to come out of a deep idle state, or that is
+ * too small for them. Among the lowest priority CPUs, pick one the task
+ * fits on and that runs no other RT task, preferring a shallow idle state,
+ * then a CPU running only CFS work, then deeper idle states. Ties go to
+ * the smallest capacity, then to the CPU the task last ran on.
+ */
+static int find_rt_cstate_aware_target(struct task_struct *task,
+				       int prev_cpu, struct cpumask *lowest_mask)
+{
+	unsigned long util = task_util(task);
+	unsigned long best_cap = ULONG_MAX;
+	int best_rank = INT_MAX;
+	int best_cpu = -1;
+	int i;
+
+	rcu_read_lock();
+	for_each_cpu_and(i, lowest_mask, tsk_cpus_allowed(task)) {
+		struct rq *rq = cpu_rq(i);
+		struct task_struct *curr = READ_ONCE(rq->curr);
+		unsigned long cap = capacity_orig_of(i);
+		int rank, idx;
+
+		if (!cpu_online(i) || cpu_util(i) + util > cap)
+			continue;
+		if (rq->rt.rt_nr_running)
+			continue;
+		/* don't preempt boosted/prefer idle tasks either */
+		if (schedtune_task_boost(curr) > 0 ||
+		    schedtune_prefer_idle(curr) > 0)
+			continue;
+
+		if (idle_cpu(i)) {
+			idx = idle_get_state_idx(rq);
+			rank = idx > 0 ? idx + 1 : 0;
+		} else {
+			rank = 1;
+		}
+
+		if (rank < best_rank ||
+		    (rank == best_rank && (cap < best_cap ||
+		     (cap == best_cap && i == prev_cpu)))) {
+			best_rank = rank;
+			best_cap = cap;
+			best_cpu = i;
+		}
+	}
+	rcu_read_unlock();
+
+	return best_cpu;
+}
+
 static int find_lowest_rq(struct task_struct *task, int sync)
 {
 	struct sched_domain *sd;
@@ -1841,6 +1894,10 @@ static int find_lowest_rq(struct task_struct *task, int sync)
 	if (!cpupri_find(&task_rq(task)->rd->cpupri, task, lowest_mask))
 		return -1; /* No targets found */
 
+	cpumask_andnot(lowest_mask, lowest_mask, cpu_isolated_mask);
+	if (cpumask_empty(lowest_mask))
+		return -1;
+
 	/* Return current cpu if WF_SYNC hint is set and present in
 	 * lowest_mask. Improves data locality.
 	 */
@@ -1867,6 +1924,15 @@ static int find_lowest_rq(struct task_struct *task, int sync)
 		 * it is most likely cache-hot in that location.
 		 */
 		struct task_struct* curr;
+
+		if (sysctl_sched_cstate_aware) {
+			int target = find_rt_cstate_aware_target(task, cpu,
+								 lowest_mask);
+
+			if (target != -1)
+				return target;
+		}
+
 		if (!cpumask_test_cpu(this_cpu, lowest_mask))
 			this_cpu = -1; /* Skip this_cpu opt if not among lowest */
 		rcu_read_lock();
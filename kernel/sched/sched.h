@@ -217,6 +217,11 @@ bool __dl_overflow(struct dl_bw *dl_b, int cpus, u64 old_bw, u64 new_bw)
 
 extern struct mutex sched_domains_mutex;
 
+#ifdef CONFIG_SMP
+extern const struct cpumask *sched_energy_span(int cpu, int sd_level);
+extern void sched_energy_sysctl_refresh(void);
+#endif
+
 #ifdef CONFIG_CGROUP_SCHED
 
 #include <linux/cgroup.h>
@@ -615,6 +620,39 @@ extern void rto_push_irq_work_func(struct irq_work *work);
  * (such as the load balancing or the thread migration code), lock
  * acquire operations must be ordered by ascending &runqueue.
  */
+#ifdef CONFIG_SCHED_WALT
+#define NUM_LOAD_INDICES 128
+#endif
+
+#ifdef CONFIG_UCLAMP_TASK
+/*
+ * struct uclamp_bucket - Utilization clamp bucket
+ * @value: utilization clamp value for tasks on this clamp bucket
+ * @tasks: number of RUNNABLE tasks on this clamp bucket
+ *
+ * Keep track of how many tasks are RUNNABLE for a given utilization
+ * clamp value.
+ */
+struct uclamp_bucket {
+	unsigned long value : SCHED_CAPACITY_SHIFT + 1;
+	unsigned long tasks : BITS_PER_LONG - SCHED_CAPACITY_SHIFT - 1;
+};
+
+/*
+ * struct uclamp_rq - rq's utilization clamp
+ * @value: currently active clamp values for a rq
+ * @bucket: utilization clamp buckets affecting a rq
+ *
+ * The rq's clamp value is the maximum of the values of its non empty
+ * buckets, so that a RUNNABLE task is never clamped below its boost nor
+ * above the most permissive cap of the tasks sharing the CPU with it.
+ */
+struct uclamp_rq {
+	unsigned int value;
+	struct uclamp_bucket bucket[UCLAMP_BUCKETS];
+};
+#endif /* CONFIG_UCLAMP_TASK */
+
 struct rq {
 	/* runqueue lock: */
 	raw_spinlock_t lock;
@@ -724,8 +762,26 @@ struct rq {
 	u64 avg_irqload;
 	u64 irqload_ts;
 	u64 cum_window_demand;
+	u64 cum_pred_demand;
+
+	/*
+	 * Per window histograms of task busy time, indexed by load bucket,
+	 * so the biggest task of the window is known without a task walk.
+	 * top_tasks_ws is the window start the curr_table refers to.
+	 */
+	u16 top_tasks[2][NUM_LOAD_INDICES];
+	DECLARE_BITMAP(top_tasks_bitmap[2], NUM_LOAD_INDICES);
+	int curr_table;
+	u64 top_tasks_ws;
 #endif /* CONFIG_SCHED_WALT */
 
+#ifdef CONFIG_UCLAMP_TASK
+	/* Utilization clamp values based on CPU's RUNNABLE tasks */
+	struct uclamp_rq uclamp[UCLAMP_CNT] ____cacheline_aligned;
+	unsigned int uclamp_flags;
+#define UCLAMP_FLAG_IDLE 0x01
+#endif
+
 
 #ifdef CONFIG_IRQ_TIME_ACCOUNTING
 	u64 prev_irq_time;
@@ -1490,6 +1546,16 @@ static inline void sub_nr_running(struct rq *rq, unsigned count)
 #define sub_nr_running __sub_nr_running
 #endif
 
+#ifdef CONFIG_SCHED_NR_AVG
+extern void sched_update_nr_avg(struct rq *rq, struct task_struct *p,
+				bool enqueue);
+extern void sched_nr_avg_init_cpu(int cpu);
+#else
+static inline void sched_update_nr_avg(struct rq *rq, struct task_struct *p,
+				       bool enqueue) { }
+static inline void sched_nr_avg_init_cpu(int cpu) { }
+#endif
+
 static inline void rq_last_tick_reset(struct rq *rq)
 {
 #ifdef CONFIG_NO_HZ_FULL
@@ -1593,9 +1659,11 @@ static inline unsigned long capacity_orig_of(int cpu)
 	return cpu_rq(cpu)->cpu_capacity_orig;
 }
 
+extern unsigned int capacity_margin;
 extern unsigned int sysctl_sched_use_walt_cpu_util;
 extern unsigned int walt_ravg_window;
 extern bool walt_disabled;
+extern u64 walt_top_task_load(int cpu);
 
 static inline unsigned long task_util(struct task_struct *p)
 {
@@ -1603,6 +1671,10 @@ static inline unsigned long task_util(struct task_struct *p)
 #ifdef CONFIG_SCHED_WALT
 	if (!walt_disabled && sysctl_sched_use_walt_task_util) {
 		unsigned long demand = p->ravg.demand;
+
+		if (sysctl_sched_walt_pred_demand)
+			demand = max_t(unsigned long, demand,
+				       p->ravg.pred_demand);
 		return (demand << 10) / walt_ravg_window;
 	}
 #endif
@@ -1688,15 +1760,59 @@ static inline unsigned long cpu_util_freq(int cpu)
 	}
 
 #ifdef CONFIG_SCHED_WALT
-	if (!walt_disabled && sysctl_sched_use_walt_cpu_util)
-		util = div64_u64(cpu_rq(cpu)->prev_runnable_sum,
-				 walt_ravg_window >> SCHED_LOAD_SHIFT);
+	if (!walt_disabled && sysctl_sched_use_walt_cpu_util) {
+		u64 load = cpu_rq(cpu)->prev_runnable_sum;
+
+		/* Ramp up for what the runnable tasks are about to need */
+		if (sysctl_sched_walt_pred_demand)
+			load = max(load, cpu_rq(cpu)->cum_pred_demand);
+		/* Don't let a single big task be diluted by a migration */
+		load = max(load, walt_top_task_load(cpu));
+		util = div64_u64(load, walt_ravg_window >> SCHED_LOAD_SHIFT);
+	}
 #endif
 	return (util >= capacity) ? capacity : util;
 }
 
 #endif
 
+#ifdef CONFIG_UCLAMP_TASK
+unsigned int uclamp_eff_value(struct task_struct *p, enum uclamp_id clamp_id);
+
+/* Bound @util by the clamps aggregated from the RUNNABLE tasks of @rq */
+static inline unsigned long uclamp_rq_util(struct rq *rq, unsigned long util)
+{
+	unsigned long min_util = READ_ONCE(rq->uclamp[UCLAMP_MIN].value);
+	unsigned long max_util = READ_ONCE(rq->uclamp[UCLAMP_MAX].value);
+
+	/* A boosted task wins over the cap of the other tasks */
+	if (unlikely(min_util >= max_util))
+		return min_util;
+
+	return clamp(util, min_util, max_util);
+}
+
+static inline unsigned long uclamp_task_util(struct task_struct *p,
+					     unsigned long util)
+{
+	unsigned long min_util = uclamp_eff_value(p, UCLAMP_MIN);
+	unsigned long max_util = uclamp_eff_value(p, UCLAMP_MAX);
+
+	return clamp(util, min_util, max_util);
+}
+#else
+static inline unsigned long uclamp_rq_util(struct rq *rq, unsigned long util)
+{
+	return util;
+}
+
+static inline unsigned long uclamp_task_util(struct task_struct *p,
+					     unsigned long util)
+{
+	return util;
+}
+#endif /* CONFIG_UCLAMP_TASK */
+
 static inline void sched_rt_avg_update(struct rq *rq, u64 rt_delta)
 {
 	rq->rt_avg += rt_delta * arch_scale_freq_capacity(NULL, cpu_of(rq));
@@ -0,0 +1,178 @@
+/* Copyright (c) 2012, 2015-2016, 2018, The Linux Foundation. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 and
+ * only version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+/*
+ * Scheduler hook for average runqueue determination
+ *
+ * The number of runnable tasks and of big tasks of each CPU is integrated
+ * over fixed windows from the enqueue/dequeue path. Readers get the
+ * averages and the maximum of the last complete window without walking
+ * anything, so there is no need for a polling timer.
+ */
+
+#include <linux/module.h>
+#include <linux/percpu.h>
+#include <linux/sched.h>
+#include <linux/math64.h>
+
+#include "sched.h"
+
+#define NR_AVG_WINDOW_NS	(20 * NSEC_PER_MSEC)
+
+struct nr_avg {
+	raw_spinlock_t lock;
+	u64 window_start;
+	u64 last_update;
+	/* Current counts */
+	unsigned int nr;
+	unsigned int nr_big;
+	/* Sums of count * ns and peak over the current window */
+	u64 nr_sum;
+	u64 big_sum;
+	unsigned int nr_max;
+	/* Outcome of the last complete window, averages scaled by 100 */
+	unsigned int prev_avg;
+	unsigned int prev_big_avg;
+	unsigned int prev_max;
+};
+
+static DEFINE_PER_CPU(struct nr_avg, nr_avg);
+
+/* A task is big when it does not fit the lowest capacity CPU */
+static unsigned long nr_avg_min_capacity = SCHED_CAPACITY_SCALE;
+
+static inline bool nr_avg_task_big(struct task_struct *p)
+{
+	return task_util(p) * capacity_margin >
+		nr_avg_min_capacity * SCHED_CAPACITY_SCALE;
+}
+
+static void nr_avg_update(struct nr_avg *s, u64 now)
+{
+	u64 end = s->window_start + NR_AVG_WINDOW_NS;
+	u64 delta;
+
+	if (now < s->last_update)
+		return;
+
+	if (now < end) {
+		delta = now - s->last_update;
+		s->nr_sum += (u64)s->nr * delta;
+		s->big_sum += (u64)s->nr_big * delta;
+		s->last_update = now;
+		return;
+	}
+
+	/* Close the current window */
+	delta = end - s->last_update;
+	s->nr_sum += (u64)s->nr * delta;
+	s->big_sum += (u64)s->nr_big * delta;
+	s->prev_avg = div64_u64(s->nr_sum * 100, NR_AVG_WINDOW_NS);
+	s->prev_big_avg = div64_u64(s->big_sum * 100, NR_AVG_WINDOW_NS);
+	s->prev_max = s->nr_max;
+	s->window_start = end;
+
+	/* Nothing changed during the windows skipped since */
+	if (now - s->window_start >= NR_AVG_WINDOW_NS) {
+		s->window_start += div64_u64(now - s->window_start,
+				NR_AVG_WINDOW_NS) * NR_AVG_WINDOW_NS;
+		s->prev_avg = s->nr * 100;
+		s->prev_big_avg = s->nr_big * 100;
+		s->prev_max = s->nr;
+	}
+
+	delta = now - s->window_start;
+	s->nr_sum = (u64)s->nr * delta;
+	s->big_sum = (u64)s->nr_big * delta;
+	s->nr_max = s->nr;
+	s->last_update = now;
+}
+
+/**
+ * sched_update_nr_avg - account a task entering or leaving a runqueue
+ * @rq: the runqueue, locked
+ * @p: the task
+ * @enqueue: true when @p is enqueued
+ */
+void sched_update_nr_avg(struct rq *rq, struct task_struct *p, bool enqueue)
+{
+	struct nr_avg *s = &per_cpu(nr_avg, cpu_of(rq));
+	unsigned long flags;
+
+	raw_spin_lock_irqsave(&s->lock, flags);
+	nr_avg_update(s, sched_clock());
+
+	if (enqueue) {
+		s->nr++;
+		p->nr_avg_big = nr_avg_task_big(p);
+		s->nr_big += p->nr_avg_big;
+		s->nr_max = max(s->nr_max, s->nr);
+	} else {
+		if (!WARN_ON_ONCE(!s->nr))
+			s->nr--;
+		if (p->nr_avg_big && s->nr_big)
+			s->nr_big--;
+		p->nr_avg_big = 0;
+	}
+	raw_spin_unlock_irqrestore(&s->lock, flags);
+}
+
+/**
+ * sched_get_nr_running_avg - runqueue statistics of a group of CPUs
+ * @cpus: the CPUs, typically a cluster
+ * @stats: filled with the statistics of the last complete window
+ *
+ * @stats->avg and @stats->big_avg are the summed average number of
+ * runnable and of big tasks of @cpus, scaled by 100. @stats->max is the
+ * highest number of tasks that was runnable on any one of them.
+ */
+void sched_get_nr_running_avg(const struct cpumask *cpus,
+			      struct sched_avg_stats *stats)
+{
+	u64 now = sched_clock();
+	unsigned long flags;
+	struct nr_avg *s;
+	int cpu;
+
+	memset(stats, 0, sizeof(*stats));
+
+	for_each_cpu(cpu, cpus) {
+		s = &per_cpu(nr_avg, cpu);
+
+		raw_spin_lock_irqsave(&s->lock, flags);
+		nr_avg_update(s, now);
+		stats->avg += s->prev_avg;
+		stats->big_avg += s->prev_big_avg;
+		stats->max = max(stats->max, s->prev_max);
+		raw_spin_unlock_irqrestore(&s->lock, flags);
+	}
+}
+EXPORT_SYMBOL(sched_get_nr_running_avg);
+
+void sched_nr_avg_init_cpu(int cpu)
+{
+	raw_spin_lock_init(&per_cpu(nr_avg, cpu).lock);
+}
+
+static int __init sched_nr_avg_init(void)
+{
+	unsigned long min_cap = SCHED_CAPACITY_SCALE;
+	int cpu;
+
+	/* CPU capacities are final once the energy model is parsed */
+	for_each_possible_cpu(cpu)
+		min_cap = min(min_cap, arch_scale_cpu_capacity(NULL, cpu));
+	nr_avg_min_capacity = min_cap;
+
+	return 0;
+}
+late_initcall(sched_nr_avg_init);
@@ -3,8 +3,11 @@
 #include <linux/fs.h>
 #include <linux/seq_file.h>
 #include <linux/proc_fs.h>
+#include <linux/debugfs.h>
+#include <linux/uaccess.h>
 
 #include "sched.h"
+#include "tune.h"
 
 /*
  * bump this up when changing the output format or the meaning of an existing
@@ -162,3 +165,123 @@ static int __init proc_schedstat_init(void)
 	return 0;
 }
 subsys_initcall(proc_schedstat_init);
+
+/*
+ * Run delay histograms, per cpu and per schedtune boost group, split by
+ * what put the task on the runqueue: a wakeup, or being preempted while
+ * still runnable. Bucket i counts delays in [2^(i-1), 2^i) us, bucket 0
+ * those under 1us and the last bucket everything above. ns are turned
+ * into us with a shift, which is close enough for a log scale.
+ */
+#define SCHED_LAT_BUCKETS	16
+#define SCHED_LAT_GROUPS	8
+
+enum {
+	SCHED_LAT_WAKEUP,
+	SCHED_LAT_PREEMPT,
+	SCHED_LAT_TYPES,
+};
+
+struct sched_lat_hist {
+	u32 count[SCHED_LAT_TYPES][SCHED_LAT_GROUPS][SCHED_LAT_BUCKETS];
+};
+
+static DEFINE_PER_CPU(struct sched_lat_hist, sched_lat_hist);
+bool sched_lat_hist_enabled;
+
+/* Called with the rq lock held, from sched_info_arrive() */
+void __sched_lat_hist_account(struct rq *rq, struct task_struct *t,
+			      unsigned long long delta)
+{
+	struct sched_lat_hist *hist = per_cpu_ptr(&sched_lat_hist, cpu_of(rq));
+	int type = t->sched_info.preempted ? SCHED_LAT_PREEMPT :
+					     SCHED_LAT_WAKEUP;
+	int group = schedtune_task_group(t);
+	u32 us = delta >> 10;
+	int bucket;
+
+	if (group >= SCHED_LAT_GROUPS)
+		group = SCHED_LAT_GROUPS - 1;
+	bucket = min(us ? fls(us) : 0, SCHED_LAT_BUCKETS - 1);
+
+	hist->count[type][group][bucket]++;
+}
+
+static int sched_lat_hist_show(struct seq_file *m, void *v)
+{
+	static const char * const type_name[] = { "wakeup", "preempt" };
+	struct sched_lat_hist *hist;
+	int cpu, type, group, i;
+	bool empty;
+
+	seq_puts(m, "cpu group type");
+	for (i = 0; i < SCHED_LAT_BUCKETS - 1; i++)
+		seq_printf(m, " <%u", 1U << i);
+	seq_printf(m, " >=%u\n", 1U << (SCHED_LAT_BUCKETS - 2));
+
+	for_each_possible_cpu(cpu) {
+		hist = per_cpu_ptr(&sched_lat_hist, cpu);
+		for (group = 0; group < SCHED_LAT_GROUPS; group++) {
+			for (type = 0; type < SCHED_LAT_TYPES; type++) {
+				empty = true;
+				for (i = 0; i < SCHED_LAT_BUCKETS; i++)
+					if (hist->count[type][group][i])
+						empty = false;
+				if (empty)
+					continue;
+
+				seq_printf(m, "%d %d %s", cpu, group,
+					   type_name[type]);
+				for (i = 0; i < SCHED_LAT_BUCKETS; i++)
+					seq_printf(m, " %u",
+						hist->count[type][group][i]);
+				seq_putc(m, '\n');
+			}
+		}
+	}
+
+	return 0;
+}
+
+static int sched_lat_hist_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, sched_lat_hist_show, NULL);
+}
+
+/* "1" clears the histograms and starts collecting, "0" stops */
+static ssize_t sched_lat_hist_write(struct file *file,
+		const char __user *ubuf, size_t count, loff_t *ppos)
+{
+	bool enable;
+	int cpu;
+
+	if (kstrtobool_from_user(ubuf, count, &enable))
+		return -EINVAL;
+
+	if (enable) {
+		WRITE_ONCE(sched_lat_hist_enabled, false);
+		synchronize_sched();
+		for_each_possible_cpu(cpu)
+			memset(per_cpu_ptr(&sched_lat_hist, cpu), 0,
+			       sizeof(struct sched_lat_hist));
+	}
+	WRITE_ONCE(sched_lat_hist_enabled, enable);
+
+	return count;
+}
+
+static const struct file_operations sched_lat_hist_fops = {
+	.open		= sched_lat_hist_open,
+	.read		= seq_read,
+	.write		= sched_lat_hist_write,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static int __init sched_lat_hist_init(void)
+{
+	debugfs_create_file("sched_latency_hist", 0644, NULL, NULL,
+			    &sched_lat_hist_fops);
+	return 0;
+}
+late_initcall(sched_lat_hist_init);
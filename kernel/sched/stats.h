@@ -29,6 +29,18 @@ rq_sched_info_dequeued(struct rq *rq, unsigned long long delta)
 	if (rq)
 		rq->rq_sched_info.run_delay += delta;
 }
+
+extern bool sched_lat_hist_enabled;
+void __sched_lat_hist_account(struct rq *rq, struct task_struct *t,
+			      unsigned long long delta);
+
+static inline void
+sched_lat_hist_account(struct rq *rq, struct task_struct *t,
+		       unsigned long long delta)
+{
+	if (unlikely(READ_ONCE(sched_lat_hist_enabled)))
+		__sched_lat_hist_account(rq, t, delta);
+}
 # define schedstat_inc(rq, field)	do { (rq)->field++; } while (0)
 # define schedstat_add(rq, field, amt)	do { (rq)->field += (amt); } while (0)
 # define schedstat_set(var, val)	do { var = (val); } while (0)
@@ -42,6 +54,10 @@ rq_sched_info_dequeued(struct rq *rq, unsigned long long delta)
 static inline void
 rq_sched_info_depart(struct rq *rq, unsigned long long delta)
 {}
+static inline void
+sched_lat_hist_account(struct rq *rq, struct task_struct *t,
+		       unsigned long long delta)
+{}
 # define schedstat_inc(rq, field)	do { } while (0)
 # define schedstat_add(rq, field, amt)	do { } while (0)
 # define schedstat_set(var, val)	do { } while (0)
@@ -81,12 +97,15 @@ static void sched_info_arrive(struct rq *rq, struct task_struct *t)
 {
 	unsigned long long now = rq_clock(rq), delta = 0;
 
-	if (t->sched_info.last_queued)
+	if (t->sched_info.last_queued) {
 		delta = now - t->sched_info.last_queued;
+		sched_lat_hist_account(rq, t, delta);
+	}
 	sched_info_reset_dequeued(t);
 	t->sched_info.run_delay += delta;
 	t->sched_info.last_arrival = now;
 	t->sched_info.pcount++;
+	t->sched_info.preempted = 0;
 
 	rq_sched_info_arrive(rq, delta);
 }
@@ -118,8 +137,10 @@ static inline void sched_info_depart(struct rq *rq, struct task_struct *t)
 
 	rq_sched_info_depart(rq, delta);
 
-	if (t->state == TASK_RUNNING)
+	if (t->state == TASK_RUNNING) {
+		t->sched_info.preempted = 1;
 		sched_info_queued(rq, t);
+	}
 }
 
 /*
@@ -145,6 +145,20 @@ struct schedtune {
 	 * towards idle CPUs */
 	int prefer_idle;
 
+	/* Hint to wake tasks on that SchedTune CGroup on the idle CPU
+	 * with the lowest exit latency */
+	int latency_sensitive;
+
+	/* Keep background tasks off the biggest CPU while tasks on that
+	 * SchedTune CGroup are RUNNABLE */
+	int reserve_cpu;
+
+#ifdef CONFIG_UCLAMP_TASK
+	/* Utilization clamps for tasks on that SchedTune CGroup */
+	int util_min;
+	int util_max;
+#endif
+
 #ifdef CONFIG_DYNAMIC_STUNE_BOOST
 	/*
 	 * This tracks the default boost value and is used to restore
@@ -197,6 +211,12 @@ root_schedtune = {
 	.perf_boost_idx = 0,
 	.perf_constrain_idx = 0,
 	.prefer_idle = 0,
+	.latency_sensitive = 0,
+	.reserve_cpu = 0,
+#ifdef CONFIG_UCLAMP_TASK
+	.util_min = 0,
+	.util_max = SCHED_CAPACITY_SCALE,
+#endif
 #ifdef CONFIG_DYNAMIC_STUNE_BOOST
 	.boost_default = 0,
 	.sched_boost = 0,
@@ -290,6 +310,15 @@ struct boost_groups {
 /* Boost groups affecting each CPU in the system */
 DEFINE_PER_CPU(struct boost_groups, cpu_boost_groups);
 
+/* Boost groups with reserve_cpu set, by boost group index */
+static unsigned long reserve_groups;
+
+/*
+ * CPUs with RUNNABLE tasks of each reserve_cpu boost group, kept up to
+ * date under the boost group locks so the wakeup path only tests masks
+ */
+static struct cpumask reserve_busy_cpus[BOOSTGROUPS_COUNT];
+
 static inline bool schedtune_boost_timeout(u64 now, u64 ts)
 {
 	return ((now - ts) > SCHEDTUNE_BOOST_HOLD_NS);
@@ -398,14 +427,34 @@ schedtune_update_timestamp(struct task_struct *p)
 	return task_has_rt_policy(p);
 }
 
+/*
+ * Keep reserve_busy_cpus in sync after the task count of boost group @idx
+ * changed on @cpu. Must be called with the boost group lock held.
+ */
+static inline void
+schedtune_reserve_track(struct boost_groups *bg, int cpu, int idx,
+			bool was_busy)
+{
+	if (!test_bit(idx, &reserve_groups) ||
+	    was_busy == !!bg->group[idx].tasks)
+		return;
+
+	if (bg->group[idx].tasks)
+		cpumask_set_cpu(cpu, &reserve_busy_cpus[idx]);
+	else
+		cpumask_clear_cpu(cpu, &reserve_busy_cpus[idx]);
+}
+
 static inline void
 schedtune_tasks_update(struct task_struct *p, int cpu, int idx, int task_count)
 {
 	struct boost_groups *bg = &per_cpu(cpu_boost_groups, cpu);
 	int tasks = bg->group[idx].tasks + task_count;
+	bool was_busy = bg->group[idx].tasks;
 
 	/* Update boosted tasks count while avoiding to make it negative */
 	bg->group[idx].tasks = max(0, tasks);
+	schedtune_reserve_track(bg, cpu, idx, was_busy);
 
 	/* Update timeout on enqueue */
 	if (task_count > 0) {
@@ -530,6 +579,9 @@ int schedtune_can_attach(struct cgroup_taskset *tset)
 		tasks = bg->group[src_bg].tasks - 1;
 		bg->group[src_bg].tasks = max(0, tasks);
 		bg->group[dst_bg].tasks += 1;
+		schedtune_reserve_track(bg, cpu, src_bg, true);
+		schedtune_reserve_track(bg, cpu, dst_bg,
+					bg->group[dst_bg].tasks > 1);
 
 		/* Update boost hold start for this group */
 		now = sched_clock_cpu(cpu);
@@ -649,6 +701,23 @@ int schedtune_task_boost(struct task_struct *p)
 	return task_boost;
 }
 
+/* Index of the boost group @p belongs to, 0 being the root group */
+int schedtune_task_group(struct task_struct *p)
+{
+	struct schedtune *st;
+	int idx;
+
+	if (!unlikely(schedtune_initialized))
+		return 0;
+
+	rcu_read_lock();
+	st = task_schedtune(p);
+	idx = st->idx;
+	rcu_read_unlock();
+
+	return idx;
+}
+
 int schedtune_prefer_idle(struct task_struct *p)
 {
 	struct schedtune *st;
@@ -684,6 +753,205 @@ prefer_idle_write(struct cgroup_subsys_state *css, struct cftype *cft,
 	return 0;
 }
 
+int schedtune_latency_sensitive(struct task_struct *p)
+{
+	struct schedtune *st;
+	int latency_sensitive;
+
+	if (!unlikely(schedtune_initialized))
+		return 0;
+
+	rcu_read_lock();
+	st = task_schedtune(p);
+	latency_sensitive = st->latency_sensitive;
+	rcu_read_unlock();
+
+	return latency_sensitive;
+}
+
+/**
+ * schedtune_task_foreground - is @p in a group the user is waiting on
+ * @p: the task
+ *
+ * True for the boosted, prefer_idle or latency sensitive groups, i.e. the
+ * ones Android uses for top-app and foreground, so that other subsystems
+ * such as I/O schedulers can favour their work.
+ */
+bool schedtune_task_foreground(struct task_struct *p)
+{
+	struct schedtune *st;
+	bool fg;
+
+	if (!unlikely(schedtune_initialized))
+		return false;
+
+	rcu_read_lock();
+	st = task_schedtune(p);
+	fg = st->latency_sensitive || st->prefer_idle || st->boost > 0;
+	rcu_read_unlock();
+
+	return fg;
+}
+EXPORT_SYMBOL_GPL(schedtune_task_foreground);
+
+/*
+ * A task is kept off the reserved CPU if it is a background one, i.e.
+ * neither boosted nor latency sensitive, and some group with reserve_cpu
+ * set has RUNNABLE tasks. The masks are read without the boost group
+ * locks, a stale value only costs one placement decision.
+ */
+bool schedtune_cpu_reserved(struct task_struct *p)
+{
+	unsigned long groups = READ_ONCE(reserve_groups);
+	struct schedtune *st;
+	bool background;
+	int idx;
+
+	if (!unlikely(schedtune_initialized) || !groups)
+		return false;
+
+	rcu_read_lock();
+	st = task_schedtune(p);
+	background = !st->latency_sensitive && !st->prefer_idle &&
+		     st->boost <= 0;
+	rcu_read_unlock();
+
+	if (!background)
+		return false;
+
+	for_each_set_bit(idx, &groups, BOOSTGROUPS_COUNT) {
+		if (!cpumask_empty(&reserve_busy_cpus[idx]))
+			return true;
+	}
+
+	return false;
+}
+
+/*
+ * Start or stop tracking the busy CPUs of boost group @idx. The group bit
+ * is flipped first so that, once a CPU's boost group lock has been taken
+ * here, every later task count update on that CPU keeps the mask in sync.
+ */
+static void schedtune_reserve_update(int idx, bool reserve)
+{
+	struct boost_groups *bg;
+	unsigned long irq_flags;
+	int cpu;
+
+	if (reserve)
+		set_bit(idx, &reserve_groups);
+	else
+		clear_bit(idx, &reserve_groups);
+
+	for_each_possible_cpu(cpu) {
+		bg = &per_cpu(cpu_boost_groups, cpu);
+		raw_spin_lock_irqsave(&bg->lock, irq_flags);
+		if (reserve && bg->group[idx].tasks)
+			cpumask_set_cpu(cpu, &reserve_busy_cpus[idx]);
+		else
+			cpumask_clear_cpu(cpu, &reserve_busy_cpus[idx]);
+		raw_spin_unlock_irqrestore(&bg->lock, irq_flags);
+	}
+}
+
+static u64
+latency_sensitive_read(struct cgroup_subsys_state *css, struct cftype *cft)
+{
+	struct schedtune *st = css_st(css);
+
+	return st->latency_sensitive;
+}
+
+static int
+latency_sensitive_write(struct cgroup_subsys_state *css, struct cftype *cft,
+	    u64 latency_sensitive)
+{
+	struct schedtune *st = css_st(css);
+	st->latency_sensitive = !!latency_sensitive;
+
+	return 0;
+}
+
+static u64
+reserve_cpu_read(struct cgroup_subsys_state *css, struct cftype *cft)
+{
+	struct schedtune *st = css_st(css);
+
+	return st->reserve_cpu;
+}
+
+static int
+reserve_cpu_write(struct cgroup_subsys_state *css, struct cftype *cft,
+	    u64 reserve_cpu)
+{
+	struct schedtune *st = css_st(css);
+	st->reserve_cpu = !!reserve_cpu;
+
+	schedtune_reserve_update(st->idx, st->reserve_cpu);
+
+	return 0;
+}
+
+#ifdef CONFIG_UCLAMP_TASK
+unsigned int schedtune_uclamp(struct task_struct *p, int clamp_id)
+{
+	struct schedtune *st;
+	unsigned int value;
+
+	if (!unlikely(schedtune_initialized))
+		return clamp_id == UCLAMP_MIN ? 0 : SCHED_CAPACITY_SCALE;
+
+	rcu_read_lock();
+	st = task_schedtune(p);
+	value = clamp_id == UCLAMP_MIN ? st->util_min : st->util_max;
+	rcu_read_unlock();
+
+	return value;
+}
+
+static u64
+util_min_read(struct cgroup_subsys_state *css, struct cftype *cft)
+{
+	struct schedtune *st = css_st(css);
+
+	return st->util_min;
+}
+
+static int
+util_min_write(struct cgroup_subsys_state *css, struct cftype *cft,
+	    u64 util_min)
+{
+	struct schedtune *st = css_st(css);
+
+	if (util_min > st->util_max)
+		return -EINVAL;
+	st->util_min = util_min;
+
+	return 0;
+}
+
+static u64
+util_max_read(struct cgroup_subsys_state *css, struct cftype *cft)
+{
+	struct schedtune *st = css_st(css);
+
+	return st->util_max;
+}
+
+static int
+util_max_write(struct cgroup_subsys_state *css, struct cftype *cft,
+	    u64 util_max)
+{
+	struct schedtune *st = css_st(css);
+
+	if (util_max > SCHED_CAPACITY_SCALE || util_max < st->util_min)
+		return -EINVAL;
+	st->util_max = util_max;
+
+	return 0;
+}
+#endif /* CONFIG_UCLAMP_TASK */
+
 static s64
 boost_read(struct cgroup_subsys_state *css, struct cftype *cft)
 {
@@ -809,6 +1077,28 @@ static struct cftype files[] = {
 		.read_u64 = prefer_idle_read,
 		.write_u64 = prefer_idle_write,
 	},
+	{
+		.name = "latency_sensitive",
+		.read_u64 = latency_sensitive_read,
+		.write_u64 = latency_sensitive_write,
+	},
+	{
+		.name = "reserve_cpu",
+		.read_u64 = reserve_cpu_read,
+		.write_u64 = reserve_cpu_write,
+	},
+#ifdef CONFIG_UCLAMP_TASK
+	{
+		.name = "util_min",
+		.read_u64 = util_min_read,
+		.write_u64 = util_min_write,
+	},
+	{
+		.name = "util_max",
+		.read_u64 = util_max_read,
+		.write_u64 = util_max_write,
+	},
+#endif
 #ifdef CONFIG_DYNAMIC_STUNE_BOOST
 	{
 		.name = "sched_boost",
@@ -874,6 +1164,9 @@ schedtune_css_alloc(struct cgroup_subsys_state *parent_css)
 
 	/* Initialize per CPUs boost group support */
 	st->idx = idx;
+#ifdef CONFIG_UCLAMP_TASK
+	st->util_max = SCHED_CAPACITY_SCALE;
+#endif
 	if (schedtune_boostgroup_init(st))
 		goto release;
 
@@ -894,6 +1187,7 @@ schedtune_boostgroup_release(struct schedtune *st)
 #endif // CONFIG_DYNAMIC_STUNE_BOOST
 	/* Reset this boost group */
 	schedtune_boostgroup_update(st->idx, 0);
+	schedtune_reserve_update(st->idx, false);
 
 	/* Keep track of allocated boost groups */
 	allocated_group[st->idx] = NULL;
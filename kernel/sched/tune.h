@@ -16,8 +16,12 @@ struct target_nrg {
 
 int schedtune_cpu_boost(int cpu);
 int schedtune_task_boost(struct task_struct *tsk);
+int schedtune_task_group(struct task_struct *tsk);
 
 int schedtune_prefer_idle(struct task_struct *tsk);
+int schedtune_latency_sensitive(struct task_struct *tsk);
+bool schedtune_cpu_reserved(struct task_struct *tsk);
+unsigned int schedtune_uclamp(struct task_struct *tsk, int clamp_id);
 
 void schedtune_exit_task(struct task_struct *tsk);
 
@@ -28,6 +32,10 @@ void schedtune_dequeue_task(struct task_struct *p, int cpu);
 
 #define schedtune_cpu_boost(cpu)  get_sysctl_sched_cfs_boost()
 #define schedtune_task_boost(tsk) get_sysctl_sched_cfs_boost()
+#define schedtune_task_group(tsk) 0
+
+#define schedtune_uclamp(tsk, clamp_id) \
+	((clamp_id) == UCLAMP_MIN ? 0 : SCHED_CAPACITY_SCALE)
 
 #define schedtune_exit_task(task) do { } while (0)
 
@@ -44,6 +52,10 @@ int schedtune_accept_deltas(int nrg_delta, int cap_delta,
 
 #define schedtune_cpu_boost(cpu)  0
 #define schedtune_task_boost(tsk) 0
+#define schedtune_task_group(tsk) 0
+
+#define schedtune_uclamp(tsk, clamp_id) \
+	((clamp_id) == UCLAMP_MIN ? 0 : SCHED_CAPACITY_SCALE)
 
 #define schedtune_exit_task(task) do { } while (0)
 
@@ -32,6 +32,15 @@
 
 #define EXITING_TASK_MARKER	0xdeaddead
 
+/* Busy bucket aging. Buckets hit repeatedly grow faster. */
+#define BUCKET_DEC_STEP		2
+#define BUCKET_INC_STEP		8
+#define BUCKET_INC_STEP_BIG	16
+#define BUCKET_CONSISTENT_THRES	16
+
+/* Don't predict for tasks that haven't been around for a few windows */
+#define PRED_NEW_TASK_WINDOWS	5
+
 static __read_mostly unsigned int walt_ravg_hist_size = 5;
 static __read_mostly unsigned int walt_window_stats_policy =
 	WINDOW_STATS_MAX_RECENT_AVG;
@@ -41,6 +50,9 @@ static __read_mostly unsigned int walt_io_is_busy = 0;
 
 unsigned int sysctl_sched_walt_init_task_load_pct = 15;
 
+/* Let frequency and placement follow the bucketed demand prediction */
+unsigned int sysctl_sched_walt_pred_demand = 1;
+
 /* true -> use PELT based load stats, false -> use window-based load stats */
 bool __read_mostly walt_disabled = false;
 
@@ -74,6 +86,7 @@ walt_inc_cumulative_runnable_avg(struct rq *rq,
 				 struct task_struct *p)
 {
 	rq->cumulative_runnable_avg += p->ravg.demand;
+	rq->cum_pred_demand += p->ravg.pred_demand;
 
 	/*
 	 * Add a task's contribution to the cumulative window demand when
@@ -92,6 +105,9 @@ walt_dec_cumulative_runnable_avg(struct rq *rq,
 {
 	rq->cumulative_runnable_avg -= p->ravg.demand;
 	BUG_ON((s64)rq->cumulative_runnable_avg < 0);
+	rq->cum_pred_demand -= p->ravg.pred_demand;
+	if (unlikely((s64)rq->cum_pred_demand < 0))
+		rq->cum_pred_demand = 0;
 
 	/*
 	 * on_rq will be 1 for sleeping tasks. So check if the task
@@ -329,10 +345,188 @@ static int account_busy_for_cpu_time(struct rq *rq, struct task_struct *p,
 	return walt_freq_account_wait_time;
 }
 
+static inline int load_to_index(u32 load)
+{
+	u32 index = div64_u64((u64)load * NUM_LOAD_INDICES, walt_ravg_window);
+
+	return min_t(u32, index, NUM_LOAD_INDICES - 1);
+}
+
+static void top_tasks_add(struct rq *rq, int table, u32 load)
+{
+	int index;
+
+	if (!load)
+		return;
+
+	index = load_to_index(load);
+	if (!rq->top_tasks[table][index]++)
+		__set_bit(index, rq->top_tasks_bitmap[table]);
+}
+
+static void top_tasks_del(struct rq *rq, int table, u32 load)
+{
+	int index;
+
+	if (!load)
+		return;
+
+	index = load_to_index(load);
+	if (WARN_ON_ONCE(!rq->top_tasks[table][index]))
+		return;
+
+	if (!--rq->top_tasks[table][index])
+		__clear_bit(index, rq->top_tasks_bitmap[table]);
+}
+
+static void clear_top_table(struct rq *rq, int table)
+{
+	memset(rq->top_tasks[table], 0, sizeof(rq->top_tasks[table]));
+	bitmap_zero(rq->top_tasks_bitmap[table], NUM_LOAD_INDICES);
+}
+
+/*
+ * Bring the top task tables up to rq->window_start. Like the per-task
+ * windows, the current table becomes the previous one after a single
+ * window and both are emptied after that.
+ */
+static void rollover_top_tasks(struct rq *rq)
+{
+	u64 nr_windows;
+	int prev = 1 - rq->curr_table;
+
+	if (rq->top_tasks_ws == rq->window_start)
+		return;
+
+	nr_windows = div64_u64(rq->window_start - rq->top_tasks_ws,
+			       walt_ravg_window);
+	clear_top_table(rq, prev);
+	if (nr_windows > 1)
+		clear_top_table(rq, rq->curr_table);
+
+	rq->curr_table = prev;
+	rq->top_tasks_ws = rq->window_start;
+}
+
+/*
+ * Move p's entry in the top task tables after its windows were updated.
+ * A rollover of p's windows has already happened in the tables, so its
+ * old curr_window is now found in the previous table, or nowhere at all
+ * if whole windows went by.
+ */
+static void update_top_tasks(struct task_struct *p, struct rq *rq,
+			     u32 old_curr_window, int new_window,
+			     bool full_window)
+{
+	int curr = rq->curr_table;
+	int prev = 1 - curr;
+
+	if (!new_window) {
+		if (old_curr_window == p->ravg.curr_window)
+			return;
+		top_tasks_del(rq, curr, old_curr_window);
+		top_tasks_add(rq, curr, p->ravg.curr_window);
+		return;
+	}
+
+	if (!full_window)
+		top_tasks_del(rq, prev, old_curr_window);
+	top_tasks_add(rq, prev, p->ravg.prev_window);
+	top_tasks_add(rq, curr, p->ravg.curr_window);
+}
+
+/*
+ * Drop an exiting task from the tables. Its windows may not have been
+ * rolled over since it last ran, so look for its entries relative to the
+ * window the tables are at. The windows themselves are left alone: they
+ * are still part of the rq busy time sums and roll out of them with the
+ * rq windows. Called once, before exiting_task() sets the marker that
+ * stops the task's windows from rolling over.
+ */
+static void clear_top_tasks(struct task_struct *p, struct rq *rq)
+{
+	u64 ws = rq->top_tasks_ws;
+	int curr = rq->curr_table;
+
+	if (p->ravg.mark_start >= ws) {
+		top_tasks_del(rq, curr, p->ravg.curr_window);
+		top_tasks_del(rq, 1 - curr, p->ravg.prev_window);
+	} else if (p->ravg.mark_start + walt_ravg_window >= ws) {
+		top_tasks_del(rq, 1 - curr, p->ravg.curr_window);
+	}
+}
+
+/*
+ * Busy time of the biggest task seen on @cpu in its current or previous
+ * window, rounded up to the load bucket. Read without the rq lock.
+ */
+u64 walt_top_task_load(int cpu)
+{
+	struct rq *rq = cpu_rq(cpu);
+	int curr = READ_ONCE(rq->curr_table);
+	unsigned long index, prev_index;
+
+	index = find_last_bit(rq->top_tasks_bitmap[curr], NUM_LOAD_INDICES);
+	prev_index = find_last_bit(rq->top_tasks_bitmap[1 - curr],
+				   NUM_LOAD_INDICES);
+
+	if (index == NUM_LOAD_INDICES)
+		index = prev_index;
+	else if (prev_index != NUM_LOAD_INDICES)
+		index = max(index, prev_index);
+
+	if (index == NUM_LOAD_INDICES)
+		return 0;
+
+	return div64_u64((u64)(index + 1) * walt_ravg_window,
+			 NUM_LOAD_INDICES);
+}
+
+/*
+ * Last-window busy time of @cpu and the demand predicted for its next
+ * window, for governors that live outside the scheduler. Both are relative
+ * to the CPU's own capacity at fmax, SCHED_CAPACITY_SCALE meaning fully
+ * busy. Read without the rq lock, so a window that has not been rolled
+ * over because the CPU sat idle is aged here instead.
+ */
+unsigned long sched_get_cpu_walt_load(int cpu, unsigned long *pred)
+{
+	struct rq *rq = cpu_rq(cpu);
+	unsigned long capacity = capacity_orig_of(cpu);
+	u64 ws = READ_ONCE(rq->window_start);
+	u64 now = walt_ktime_clock();
+	u64 load, demand;
+
+	*pred = 0;
+	if (walt_disabled || now < ws)
+		return 0;
+
+	if (now - ws >= 2 * (u64)walt_ravg_window)
+		return 0;
+
+	if (now - ws >= walt_ravg_window) {
+		load = READ_ONCE(rq->curr_runnable_sum);
+		demand = 0;
+	} else {
+		load = max(READ_ONCE(rq->prev_runnable_sum),
+			   walt_top_task_load(cpu));
+		demand = READ_ONCE(rq->cum_pred_demand);
+	}
+
+	load = div64_u64(load, walt_ravg_window >> SCHED_LOAD_SHIFT);
+	demand = div64_u64(demand, walt_ravg_window >> SCHED_LOAD_SHIFT);
+
+	*pred = div_u64(min_t(u64, demand, capacity) << SCHED_CAPACITY_SHIFT,
+			capacity);
+	return div_u64(min_t(u64, load, capacity) << SCHED_CAPACITY_SHIFT,
+		       capacity);
+}
+EXPORT_SYMBOL_GPL(sched_get_cpu_walt_load);
+
 /*
  * Account cpu activity in its busy time counters (rq->curr/prev_runnable_sum)
  */
-static void update_cpu_busy_time(struct task_struct *p, struct rq *rq,
+static void __update_cpu_busy_time(struct task_struct *p, struct rq *rq,
 	     int event, u64 wallclock, u64 irqtime)
 {
 	int new_window, nr_full_windows = 0;
@@ -554,6 +748,109 @@ static int account_busy_for_task_demand(struct task_struct *p, int event)
 	return 1;
 }
 
+static inline int busy_to_bucket(u32 runtime)
+{
+	int bidx = mult_frac(runtime, NUM_BUSY_BUCKETS, walt_ravg_window);
+
+	/* The lowest two buckets are combined, tiny runtimes are noise */
+	return clamp(bidx, 1, NUM_BUSY_BUCKETS - 1);
+}
+
+/*
+ * Age all busy buckets of a task and credit the one that the window just
+ * concluded falls into.
+ */
+static void update_busy_buckets(struct task_struct *p, u32 runtime)
+{
+	u8 *buckets = p->ravg.busy_buckets;
+	int bidx = busy_to_bucket(runtime);
+	int i, step;
+
+	for (i = 0; i < NUM_BUSY_BUCKETS; i++) {
+		if (i != bidx) {
+			buckets[i] = buckets[i] > BUCKET_DEC_STEP ?
+				     buckets[i] - BUCKET_DEC_STEP : 0;
+			continue;
+		}
+
+		step = buckets[i] >= BUCKET_CONSISTENT_THRES ?
+		       BUCKET_INC_STEP_BIG : BUCKET_INC_STEP;
+		buckets[i] = min(buckets[i] + step, (int)U8_MAX);
+	}
+}
+
+/*
+ * Predict the demand of the next window: the lowest busy bucket at or
+ * above @start that has been hit recently. The most recent runtime from
+ * history falling into that bucket is used, or the middle of the bucket
+ * if there is none. Never predicts below @runtime.
+ */
+static u32 get_pred_busy(struct task_struct *p, int start, u32 runtime)
+{
+	u8 *buckets = p->ravg.busy_buckets;
+	u32 *hist = p->ravg.sum_history;
+	u32 dmin, dmax, pred = 0;
+	int i, bidx = NUM_BUSY_BUCKETS;
+
+	if (p->ravg.active_windows < PRED_NEW_TASK_WINDOWS)
+		return runtime;
+
+	for (i = start; i < NUM_BUSY_BUCKETS; i++) {
+		if (buckets[i]) {
+			bidx = i;
+			break;
+		}
+	}
+	if (bidx == NUM_BUSY_BUCKETS)
+		return runtime;
+
+	dmin = bidx > 1 ? mult_frac(bidx, walt_ravg_window,
+				    NUM_BUSY_BUCKETS) : 0;
+	dmax = mult_frac(bidx + 1, walt_ravg_window, NUM_BUSY_BUCKETS);
+
+	for (i = 0; i < walt_ravg_hist_size; i++) {
+		if (hist[i] >= dmin && hist[i] < dmax) {
+			pred = hist[i];
+			break;
+		}
+	}
+	if (!pred)
+		pred = (dmin + dmax) / 2;
+
+	return max(runtime, pred);
+}
+
+static void fixup_pred_demand(struct rq *rq, struct task_struct *p,
+			      u32 pred_demand)
+{
+	s64 delta = (s64)pred_demand - p->ravg.pred_demand;
+
+	if (task_on_rq_queued(p) &&
+	    (!task_has_dl_policy(p) || !p->dl.dl_throttled)) {
+		rq->cum_pred_demand += delta;
+		if (unlikely((s64)rq->cum_pred_demand < 0))
+			rq->cum_pred_demand = 0;
+	}
+
+	p->ravg.pred_demand = pred_demand;
+}
+
+/*
+ * A task running longer in the current window than predicted moves its
+ * prediction up right away instead of waiting for the window to close.
+ */
+static void update_task_pred_demand(struct rq *rq, struct task_struct *p)
+{
+	u32 runtime = p->ravg.sum;
+
+	if (is_idle_task(p) || exiting_task(p) ||
+	    runtime <= p->ravg.pred_demand)
+		return;
+
+	fixup_pred_demand(rq, p, get_pred_busy(p, busy_to_bucket(runtime),
+					       runtime));
+}
+
 /*
  * Called when new window is starting for a task, to record cpu usage over
  * recently concluded window(s). Normally 'samples' should be 1. It can be > 1
@@ -624,6 +921,10 @@ static void update_history(struct rq *rq, struct task_struct *p,
 
 	p->ravg.demand = demand;
 
+	fixup_pred_demand(rq, p, get_pred_busy(p, busy_to_bucket(runtime),
+					       runtime));
+	update_busy_buckets(p, runtime);
+
 done:
 	trace_walt_update_history(rq, p, runtime, samples, event);
 	return;
@@ -740,6 +1041,23 @@ static void update_task_demand(struct task_struct *p, struct rq *rq,
 	add_to_task_demand(rq, p, wallclock - mark_start);
 }
 
+static void update_cpu_busy_time(struct task_struct *p, struct rq *rq,
+	     int event, u64 wallclock, u64 irqtime)
+{
+	u32 old_curr_window = p->ravg.curr_window;
+	u64 mark_start = p->ravg.mark_start;
+	int new_window = mark_start < rq->window_start;
+	bool full_window = new_window &&
+		rq->window_start - mark_start >= walt_ravg_window;
+
+	rollover_top_tasks(rq);
+	__update_cpu_busy_time(p, rq, event, wallclock, irqtime);
+
+	if (!is_idle_task(p) && !exiting_task(p))
+		update_top_tasks(p, rq, old_curr_window, new_window,
+				 full_window);
+}
+
 /* Reflect task activity on its demand and cpu's busy time statistics */
 void walt_update_task_ravg(struct task_struct *p, struct rq *rq,
 	     int event, u64 wallclock, u64 irqtime)
@@ -754,7 +1072,12 @@ void walt_update_task_ravg(struct task_struct *p, struct rq *rq,
 	if (!p->ravg.mark_start)
 		goto done;
 
+	if (unlikely(p->flags & PF_EXITING) &&
+	    p->ravg.sum_history[0] != EXITING_TASK_MARKER)
+		clear_top_tasks(p, rq);
+
 	update_task_demand(p, rq, event, wallclock);
+	update_task_pred_demand(rq, p);
 	update_cpu_busy_time(p, rq, event, wallclock, irqtime);
 
 done:
@@ -825,9 +1148,9 @@ void walt_fixup_busy_time(struct task_struct *p, int new_cpu)
 	if (!p->on_rq && p->state != TASK_WAKING)
 		return;
 
-	if (exiting_task(p)) {
+	/* Don't set the exiting marker here, see clear_top_tasks() */
+	if (p->flags & PF_EXITING)
 		return;
-	}
 
 	if (p->state == TASK_WAKING)
 		double_rq_lock(src_rq, dest_rq);
@@ -862,6 +1185,13 @@ void walt_fixup_busy_time(struct task_struct *p, int new_cpu)
 		dest_rq->prev_runnable_sum += p->ravg.prev_window;
 	}
 
+	/* The destination must see the task's load right away */
+	rollover_top_tasks(dest_rq);
+	top_tasks_del(src_rq, src_rq->curr_table, p->ravg.curr_window);
+	top_tasks_del(src_rq, 1 - src_rq->curr_table, p->ravg.prev_window);
+	top_tasks_add(dest_rq, dest_rq->curr_table, p->ravg.curr_window);
+	top_tasks_add(dest_rq, 1 - dest_rq->curr_table, p->ravg.prev_window);
+
 	if ((s64)src_rq->prev_runnable_sum < 0) {
 		src_rq->prev_runnable_sum = 0;
 		WARN_ON(1);
@@ -895,6 +1225,7 @@ void walt_init_new_task_load(struct task_struct *p)
 	}
 
 	p->ravg.demand = init_load_windows;
+	p->ravg.pred_demand = init_load_windows;
 	for (i = 0; i < RAVG_HIST_SIZE_MAX; ++i)
 		p->ravg.sum_history[i] = init_load_windows;
 }
@@ -611,6 +611,22 @@ void __init smp_init(void)
 
 	idle_threads_init();
 
+	if (cpuhp_parallel) {
+		static struct cpumask up_mask __initdata;
+		unsigned int nr = num_online_cpus();
+
+		for_each_present_cpu(cpu) {
+			if (nr >= setup_max_cpus)
+				break;
+			if (!cpu_online(cpu) && boot_cpu(cpu)) {
+				cpumask_set_cpu(cpu, &up_mask);
+				nr++;
+			}
+		}
+		cpu_up_batch(&up_mask);
+		goto done;
+	}
+
 	/* FIXME: This should be done in userspace --RR */
 	for_each_present_cpu(cpu) {
 		if (num_online_cpus() >= setup_max_cpus)
@@ -619,6 +635,7 @@ void __init smp_init(void)
 			cpu_up(cpu);
 	}
 
+done:
 	free_boot_cpu_mask();
 
 	/* Any cleanup work */
@@ -128,6 +128,8 @@ static int __maybe_unused two = 2;
 static int __maybe_unused four = 4;
 static unsigned long one_ul = 1;
 static int one_hundred = 100;
+static int oom_score_adj_min = OOM_SCORE_ADJ_MIN;
+static int oom_score_adj_max = OOM_SCORE_ADJ_MAX;
 #ifdef CONFIG_PRINTK
 static int ten_thousand = 10000;
 #endif
@@ -341,6 +343,15 @@ static struct ctl_table kern_table[] = {
 		.mode		= 0644,
 		.proc_handler	= proc_dointvec,
 	},
+	{
+		.procname	= "sched_walt_pred_demand",
+		.data		= &sysctl_sched_walt_pred_demand,
+		.maxlen		= sizeof(unsigned int),
+		.mode		= 0644,
+		.proc_handler	= proc_dointvec_minmax,
+		.extra1		= &zero,
+		.extra2		= &one,
+	},
 #endif
 	{
 		.procname	= "sched_cstate_aware",
@@ -1386,6 +1397,24 @@ static struct ctl_table vm_table[] = {
 		.extra1		= &zero,
 		.extra2		= &one_hundred,
 	},
+	{
+		.procname	= "workingset_protect_adj",
+		.data		= &sysctl_workingset_protect_adj,
+		.maxlen		= sizeof(sysctl_workingset_protect_adj),
+		.mode		= 0644,
+		.proc_handler	= proc_dointvec_minmax,
+		.extra1		= &oom_score_adj_min,
+		.extra2		= &oom_score_adj_max,
+	},
+	{
+		.procname	= "workingset_protect_ratio",
+		.data		= &sysctl_workingset_protect_ratio,
+		.maxlen		= sizeof(sysctl_workingset_protect_ratio),
+		.mode		= 0644,
+		.proc_handler	= proc_dointvec_minmax,
+		.extra1		= &zero,
+		.extra2		= &one_hundred,
+	},
 #ifdef CONFIG_HUGETLB_PAGE
 	{
 		.procname	= "nr_hugepages",
@@ -1458,6 +1487,15 @@ static struct ctl_table vm_table[] = {
 		.extra1		= &min_extfrag_threshold,
 		.extra2		= &max_extfrag_threshold,
 	},
+	{
+		.procname	= "compaction_proactiveness",
+		.data		= &sysctl_compaction_proactiveness,
+		.maxlen		= sizeof(sysctl_compaction_proactiveness),
+		.mode		= 0644,
+		.proc_handler	= proc_dointvec_minmax,
+		.extra1		= &zero,
+		.extra2		= &one_hundred,
+	},
 	{
 		.procname	= "compact_unevictable_allowed",
 		.data		= &sysctl_compact_unevictable_allowed,
@@ -1698,6 +1736,22 @@ static struct ctl_table vm_table[] = {
 		.mode		= 0644,
 		.proc_handler	= proc_dointvec_minmax,
 	},
+	{
+		.procname	= "swap_ratio_dynamic",
+		.data		= &sysctl_swap_ratio_dynamic,
+		.maxlen		= sizeof(sysctl_swap_ratio_dynamic),
+		.mode		= 0644,
+		.proc_handler	= proc_dointvec_minmax,
+		.extra1		= &zero,
+		.extra2		= &one,
+	},
+	{
+		.procname	= "swap_ratio_effective",
+		.data		= &sysctl_swap_ratio_effective,
+		.maxlen		= sizeof(sysctl_swap_ratio_effective),
+		.mode		= 0444,
+		.proc_handler	= proc_dointvec,
+	},
 #endif
 	{ }
 };
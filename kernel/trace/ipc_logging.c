@@ -280,6 +280,10 @@ static void msg_drop(struct ipc_log_context *ilctxt)
 /*
  * Commits messages to the FIFO.  If the FIFO is full, then enough
  * messages are dropped to create space for the new message.
+ *
+ * The context is kept alive by its owner for as long as it logs to it,
+ * so only the per-context lock is taken here; the global context list
+ * lock would otherwise bounce between every CPU that logs.
  */
 void ipc_log_write(void *ctxt, struct encode_context *ectxt)
 {
@@ -294,8 +298,7 @@ void ipc_log_write(void *ctxt, struct encode_context *ectxt)
 
 	if (ilctxt->disabled)
 		return;
-	read_lock_irqsave(&context_list_lock_lha1, flags);
-	spin_lock(&ilctxt->context_lock_lhb1);
+	spin_lock_irqsave(&ilctxt->context_lock_lhb1, flags);
 	while (ilctxt->write_avail <= ectxt->offset)
 		msg_drop(ilctxt);
 
@@ -314,8 +317,8 @@ void ipc_log_write(void *ctxt, struct encode_context *ectxt)
 
 		ilctxt->write_page = get_next_page(ilctxt, ilctxt->write_page);
 		if (WARN_ON(ilctxt->write_page == NULL)) {
-			spin_unlock(&ilctxt->context_lock_lhb1);
-			read_unlock_irqrestore(&context_list_lock_lha1, flags);
+			spin_unlock_irqrestore(&ilctxt->context_lock_lhb1,
+						flags);
 			return;
 		}
 		ilctxt->write_page->hdr.write_offset = 0;
@@ -328,9 +331,10 @@ void ipc_log_write(void *ctxt, struct encode_context *ectxt)
 	}
 	ilctxt->write_page->hdr.write_offset += bytes_to_write;
 	ilctxt->write_avail -= ectxt->offset;
-	complete(&ilctxt->read_avail);
-	spin_unlock(&ilctxt->context_lock_lhb1);
-	read_unlock_irqrestore(&context_list_lock_lha1, flags);
+	/* readers only need a wakeup after they found the log empty */
+	if (!completion_done(&ilctxt->read_avail))
+		complete(&ilctxt->read_avail);
+	spin_unlock_irqrestore(&ilctxt->context_lock_lhb1, flags);
 }
 EXPORT_SYMBOL(ipc_log_write);
 
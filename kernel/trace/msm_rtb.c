@@ -96,6 +96,14 @@ static struct msm_rtb_state msm_rtb = {
 module_param_named(filter, msm_rtb.filter, uint, 0644);
 module_param_named(enable, msm_rtb.enabled, int, 0644);
 
+/*
+ * Log only one out of every mmio_sample register accesses on each cpu.
+ * 0 or 1 logs all of them.
+ */
+static unsigned int msm_rtb_mmio_sample;
+module_param_named(mmio_sample, msm_rtb_mmio_sample, uint, 0644);
+static DEFINE_PER_CPU(unsigned int, msm_rtb_mmio_count);
+
 #if defined(CONFIG_HTC_DEBUG_RTB)
 void msm_rtb_disable(void)
 {
@@ -254,6 +262,11 @@ int notrace uncached_logk_pc(enum logk_event_type log_type, void *caller,
 	if (!msm_rtb_event_should_log(log_type))
 		return 0;
 
+	if (msm_rtb_mmio_sample > 1 &&
+	    (log_type == LOGK_READL || log_type == LOGK_WRITEL) &&
+	    raw_cpu_inc_return(msm_rtb_mmio_count) % msm_rtb_mmio_sample)
+		return 0;
+
 	i = msm_rtb_get_idx();
 	uncached_logk_pc_idx(log_type, (uint64_t)((unsigned long) caller),
 				(uint64_t)((unsigned long) data), i);
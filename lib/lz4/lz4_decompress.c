@@ -91,6 +91,12 @@ static FORCE_INLINE int LZ4_decompress_generic(
 	const int safeDecode = (endOnInput == endOnInputSize);
 	const int checkOffset = ((safeDecode) && (dictSize < (int)(64 * KB)));
 
+	/* Set up the "end" pointers for the shortcut. */
+	const BYTE *const shortiend = iend -
+		(endOnInput ? 14 : 8) /*maxLL*/ - 2 /*offset*/;
+	const BYTE *const shortoend = oend -
+		(endOnInput ? 14 : 8) /*maxLL*/ - 18 /*maxML*/;
+
 	/* Special cases */
 	/* targetOutputSize too high => decode everything */
 	if ((partialDecoding) && (oexit > oend - MFLIMIT))
@@ -114,6 +120,64 @@ static FORCE_INLINE int LZ4_decompress_generic(
 
 		length = token>>ML_BITS;
 
+		/*
+		 * A two-stage shortcut for the most common case:
+		 * 1) If the literal length is 0..14, and there is enough
+		 * space, enter the shortcut and copy 16 bytes on behalf
+		 * of the literals (in the fast mode, only 8 bytes can be
+		 * safely copied this way).
+		 * 2) Further if the match length is 4..18, copy 18 bytes
+		 * in a similar manner; but we ensure that there's enough
+		 * space in the output for those 18 bytes earlier, upon
+		 * entering the shortcut (in other words, there is a
+		 * combined check for both stages).
+		 *
+		 * The fixed size copies compile to a few unaligned
+		 * 64-bit loads and stores, instead of the byte counted
+		 * wild copies of the generic path.
+		 */
+		if ((endOnInput ? length != RUN_MASK : length <= 8)
+			/*
+			 * strictly "less than" on input, to re-enter
+			 * the loop with at least one byte
+			 */
+			&& likely((endOnInput ? ip < shortiend : 1) &
+				(op <= shortoend))) {
+			/* Copy the literals */
+			memcpy(op, ip, endOnInput ? 16 : 8);
+			op += length; ip += length;
+
+			/*
+			 * The second stage:
+			 * prepare for match copying, decode full info.
+			 * If it doesn't work out, the info won't be wasted.
+			 */
+			length = token & ML_MASK; /* match length */
+			offset = LZ4_readLE16(ip);
+			ip += 2;
+			match = op - offset;
+
+			/* Do not deal with overlapping matches. */
+			if ((length != ML_MASK) &&
+				(offset >= 8) &&
+				(dict == withPrefix64k || match >= lowPrefix)) {
+				/* Copy the match. */
+				memcpy(op + 0, match + 0, 8);
+				memcpy(op + 8, match + 8, 8);
+				memcpy(op + 16, match + 16, 2);
+				op += length + MINMATCH;
+				/* Both stages worked, load the next token. */
+				continue;
+			}
+
+			/*
+			 * The second stage didn't work out, but the info
+			 * is ready. Propel it right to the point of match
+			 * copying.
+			 */
+			goto _copy_match;
+		}
+
 		if (length == RUN_MASK) {
 			unsigned int s;
 
@@ -197,6 +261,10 @@ static FORCE_INLINE int LZ4_decompress_generic(
 		ip += 2;
 		match = op - offset;
 
+		/* get matchlength */
+		length = token & ML_MASK;
+
+_copy_match:
 		if ((checkOffset) && (unlikely(match < lowLimit))) {
 			/* Error : offset outside buffers */
 			goto _output_error;
@@ -205,8 +273,6 @@ static FORCE_INLINE int LZ4_decompress_generic(
 		/* costs ~1%; silence an msan warning when offset == 0 */
 		LZ4_write32(op, (U32)offset);
 
-		/* get matchlength */
-		length = token & ML_MASK;
 		if (length == ML_MASK) {
 			unsigned int s;
 
@@ -36,6 +36,8 @@
 #include <linux/highmem.h>
 #include <linux/io.h>
 #include <linux/delay.h>
+#include <linux/ktime.h>
+#include <linux/workqueue.h>
 #include <trace/events/cma.h>
 
 #include "cma.h"
@@ -44,6 +46,13 @@ struct cma cma_areas[MAX_CMA_AREAS];
 unsigned cma_area_count;
 static DEFINE_MUTEX(cma_mutex);
 
+/*
+ * Idle time after the last allocation from an area before its ready
+ * pageblocks are refilled, so that a burst of camera buffers is not slowed
+ * down by the refill migrating pages behind it.
+ */
+#define CMA_READY_REFILL_DELAY	msecs_to_jiffies(1000)
+
 phys_addr_t cma_get_base(const struct cma *cma)
 {
 	return PFN_PHYS(cma->base_pfn);
@@ -92,6 +101,143 @@ static void cma_clear_bitmap(struct cma *cma, unsigned long pfn,
 	mutex_unlock(&cma->lock);
 }
 
+static unsigned long cma_ready_chunk_pages(const struct cma *cma)
+{
+	return max_t(unsigned long, pageblock_nr_pages,
+		     1UL << cma->order_per_bit);
+}
+
+static void cma_schedule_ready_refill(struct cma *cma)
+{
+	if (cma->ready_target)
+		mod_delayed_work(system_unbound_wq, &cma->ready_work,
+				 CMA_READY_REFILL_DELAY);
+}
+
+/*
+ * Migrate the movable pages out of free pageblocks of the area and keep
+ * them allocated, one pageblock at a time, until ready_target is reached.
+ */
+static void cma_ready_refill(struct work_struct *work)
+{
+	struct cma *cma = container_of(to_delayed_work(work), struct cma,
+				       ready_work);
+	unsigned long chunk = cma_ready_chunk_pages(cma);
+	unsigned long nr = cma_bitmap_pages_to_bits(cma, chunk);
+	unsigned long mask = cma_bitmap_aligned_mask(cma, ilog2(chunk));
+	unsigned long offset = cma_bitmap_aligned_offset(cma, ilog2(chunk));
+	unsigned long bitmap_maxno = cma_bitmap_maxno(cma);
+	unsigned long start = 0, bitmap_no, pfn;
+	int ret;
+
+	for (;;) {
+		mutex_lock(&cma->lock);
+		if (cma->ready_count >= cma->ready_target) {
+			mutex_unlock(&cma->lock);
+			break;
+		}
+		bitmap_no = bitmap_find_next_zero_area_off(cma->bitmap,
+				bitmap_maxno, start, nr, mask, offset);
+		if (bitmap_no >= bitmap_maxno) {
+			mutex_unlock(&cma->lock);
+			break;
+		}
+		bitmap_set(cma->bitmap, bitmap_no, nr);
+		mutex_unlock(&cma->lock);
+
+		pfn = cma->base_pfn + (bitmap_no << cma->order_per_bit);
+		mutex_lock(&cma_mutex);
+		ret = alloc_contig_range(pfn, pfn + chunk, MIGRATE_CMA);
+		mutex_unlock(&cma_mutex);
+		if (ret) {
+			cma_clear_bitmap(cma, pfn, chunk);
+			if (ret != -EBUSY)
+				break;
+			start = bitmap_no + nr;
+			continue;
+		}
+
+		mutex_lock(&cma->lock);
+		bitmap_set(cma->ready_bitmap, bitmap_no, nr);
+		cma->ready_count += chunk;
+		mutex_unlock(&cma->lock);
+		cond_resched();
+	}
+}
+
+/* Give every ready pageblock of the area back to the page allocator. */
+static void cma_drain_ready(struct cma *cma)
+{
+	unsigned long bitmap_maxno = cma_bitmap_maxno(cma);
+	unsigned long start, end = 0;
+
+	mutex_lock(&cma->lock);
+	for (;;) {
+		start = find_next_bit(cma->ready_bitmap, bitmap_maxno, end);
+		if (start >= bitmap_maxno)
+			break;
+		end = find_next_zero_bit(cma->ready_bitmap, bitmap_maxno,
+					 start);
+		free_contig_range(cma->base_pfn + (start << cma->order_per_bit),
+				  (end - start) << cma->order_per_bit);
+		bitmap_clear(cma->ready_bitmap, start, end - start);
+		bitmap_clear(cma->bitmap, start, end - start);
+	}
+	cma->ready_count = 0;
+	mutex_unlock(&cma->lock);
+}
+
+/*
+ * Find @nr consecutive ready bits honouring the alignment of the request.
+ * Returns @bitmap_maxno when the ready pageblocks cannot satisfy it.
+ * Called with cma->lock held.
+ */
+static unsigned long cma_find_ready_area(struct cma *cma,
+					 unsigned long bitmap_maxno,
+					 unsigned long nr, unsigned long mask,
+					 unsigned long offset)
+{
+	unsigned long index = 0, end;
+
+	for (;;) {
+		index = find_next_bit(cma->ready_bitmap, bitmap_maxno, index);
+		index = __ALIGN_MASK(index + offset, mask) - offset;
+		if (index + nr > bitmap_maxno)
+			return bitmap_maxno;
+		end = find_next_zero_bit(cma->ready_bitmap, index + nr, index);
+		if (end >= index + nr)
+			return index;
+		index = end;
+	}
+}
+
+/**
+ * cma_set_ready_pages() - set the number of pages kept ready in an area
+ * @cma:   Contiguous memory region.
+ * @pages: Number of pages, rounded up to whole pageblocks. 0 disables.
+ *
+ * Ready pageblocks are migrated out and allocated in the background while
+ * the area is idle, so that cma_alloc() requests fitting in them return
+ * without waiting for page migration. They are not available to movable
+ * allocations in the meantime, so this is meant for areas like the camera
+ * and secure display ones where allocation latency is user visible.
+ */
+void cma_set_ready_pages(struct cma *cma, unsigned long pages)
+{
+	unsigned long chunk = cma_ready_chunk_pages(cma);
+
+	pages = min(ALIGN(pages, chunk), cma->count);
+	cma->ready_target = pages;
+
+	/* not activated yet, cma_activate_area() schedules the refill */
+	if (!cma->ready_bitmap)
+		return;
+
+	if (cma->ready_count > pages)
+		cma_drain_ready(cma);
+	cma_schedule_ready_refill(cma);
+}
+
 static int __init cma_activate_area(struct cma *cma)
 {
 	int bitmap_size = BITS_TO_LONGS(cma_bitmap_maxno(cma)) * sizeof(long);
@@ -104,6 +250,12 @@ static int __init cma_activate_area(struct cma *cma)
 	if (!cma->bitmap)
 		return -ENOMEM;
 
+	cma->ready_bitmap = kzalloc(bitmap_size, GFP_KERNEL);
+	if (!cma->ready_bitmap) {
+		kfree(cma->bitmap);
+		return -ENOMEM;
+	}
+
 	WARN_ON_ONCE(!pfn_valid(pfn));
 	zone = page_zone(pfn_to_page(pfn));
 
@@ -126,6 +278,8 @@ static int __init cma_activate_area(struct cma *cma)
 	} while (--i);
 
 	mutex_init(&cma->lock);
+	INIT_DEFERRABLE_WORK(&cma->ready_work, cma_ready_refill);
+	cma_schedule_ready_refill(cma);
 
 #ifdef CONFIG_CMA_DEBUGFS
 	INIT_HLIST_HEAD(&cma->mem_head);
@@ -139,6 +293,8 @@ static int __init cma_activate_area(struct cma *cma)
 	return 0;
 
 err:
+	kfree(cma->ready_bitmap);
+	cma->ready_bitmap = NULL;
 	kfree(cma->bitmap);
 	cma->count = 0;
 	return -EINVAL;
@@ -362,7 +518,8 @@ err:
  * @align: Requested alignment of pages (in PAGE_SIZE order).
  *
  * This function allocates part of contiguous memory on specific
- * contiguous memory area.
+ * contiguous memory area. Requests fitting in the ready pageblocks of the
+ * area are served from them without migrating any page.
  */
 struct page *cma_alloc(struct cma *cma, size_t count, unsigned int align)
 {
@@ -373,6 +530,8 @@ struct page *cma_alloc(struct cma *cma, size_t count, unsigned int align)
 	struct page *page = NULL;
 	int ret;
 	int retry_after_sleep = 0;
+	bool drained = false;
+	u64 start_ns = ktime_get_ns();
 
 	if (!cma || !cma->count)
 		return NULL;
@@ -393,6 +552,35 @@ struct page *cma_alloc(struct cma *cma, size_t count, unsigned int align)
 	if (bitmap_count > bitmap_maxno)
 		return NULL;
 
+	if (cma->ready_target) {
+		mutex_lock(&cma->lock);
+		bitmap_no = cma_find_ready_area(cma, bitmap_maxno,
+				bitmap_count, mask, offset);
+		if (bitmap_no < bitmap_maxno) {
+			/* the bits stay set in cma->bitmap, now for us */
+			bitmap_clear(cma->ready_bitmap, bitmap_no,
+				     bitmap_count);
+			cma->ready_count -= bitmap_count << cma->order_per_bit;
+		}
+		mutex_unlock(&cma->lock);
+		cma_schedule_ready_refill(cma);
+
+		if (bitmap_no < bitmap_maxno) {
+			unsigned long nr_tail;
+
+			pfn = cma->base_pfn + (bitmap_no << cma->order_per_bit);
+			page = pfn_to_page(pfn);
+			/* as alloc_contig_range() would, only keep @count */
+			nr_tail = (bitmap_count << cma->order_per_bit) - count;
+			if (nr_tail)
+				free_contig_range(pfn + count, nr_tail);
+			cma_debug_account_alloc(cma, page,
+					ktime_get_ns() - start_ns, true);
+			goto out;
+		}
+	}
+
+retry:
 	for (;;) {
 		mutex_lock(&cma->lock);
 		bitmap_no = bitmap_find_next_zero_area_off(cma->bitmap,
@@ -448,6 +636,20 @@ struct page *cma_alloc(struct cma *cma, size_t count, unsigned int align)
 		start = bitmap_no + mask + 1;
 	}
 
+	/*
+	 * The ready pageblocks could not fit the request and are keeping the
+	 * rest of the area from doing so, give them back and try once more.
+	 */
+	if (!page && !drained && cma->ready_count) {
+		cma_drain_ready(cma);
+		drained = true;
+		start = 0;
+		retry_after_sleep = 0;
+		goto retry;
+	}
+
+	cma_debug_account_alloc(cma, page, ktime_get_ns() - start_ns, false);
+out:
 	trace_cma_alloc(pfn, page, count, align);
 
 	pr_debug("%s(): returned %p\n", __func__, page);
@@ -1,15 +1,28 @@
 #ifndef __MM_CMA_H__
 #define __MM_CMA_H__
 
+#include <linux/workqueue.h>
+
+/* allocation latency buckets, see cma_lat_bucket_us in cma_debug.c */
+#define CMA_LAT_BUCKETS	7
+
 struct cma {
 	unsigned long   base_pfn;
 	unsigned long   count;
 	unsigned long   *bitmap;
 	unsigned int order_per_bit; /* Order of pages represented by one bit */
 	struct mutex    lock;
+	/* bits of pages already migrated out and held for cma_alloc() */
+	unsigned long	*ready_bitmap;
+	unsigned long	ready_count;	/* in pages, under lock */
+	unsigned long	ready_target;	/* in pages */
+	struct delayed_work ready_work;
 #ifdef CONFIG_CMA_DEBUGFS
 	struct hlist_head mem_head;
 	spinlock_t mem_head_lock;
+	atomic_long_t	lat_hist[CMA_LAT_BUCKETS];
+	atomic_long_t	nr_ready_hits;
+	atomic_long_t	nr_failed;
 #endif
 };
 
@@ -21,4 +34,14 @@ static inline unsigned long cma_bitmap_maxno(struct cma *cma)
 	return cma->count >> cma->order_per_bit;
 }
 
+#ifdef CONFIG_CMA_DEBUGFS
+extern void cma_debug_account_alloc(struct cma *cma, struct page *page,
+				    u64 lat_ns, bool ready);
+#else
+static inline void cma_debug_account_alloc(struct cma *cma, struct page *page,
+					   u64 lat_ns, bool ready)
+{
+}
+#endif
+
 #endif
@@ -9,6 +9,7 @@
 #include <linux/cma.h>
 #include <linux/list.h>
 #include <linux/kernel.h>
+#include <linux/seq_file.h>
 #include <linux/slab.h>
 #include <linux/mm_types.h>
 
@@ -22,6 +23,30 @@ struct cma_mem {
 
 static struct dentry *cma_debugfs_root;
 
+/* upper bounds of the allocation latency buckets, the last one is open */
+static const unsigned long cma_lat_bucket_us[CMA_LAT_BUCKETS - 1] = {
+	100, 1000, 10000, 50000, 100000, 300000,
+};
+
+void cma_debug_account_alloc(struct cma *cma, struct page *page, u64 lat_ns,
+			     bool ready)
+{
+	unsigned long lat_us = div_u64(lat_ns, NSEC_PER_USEC);
+	int i;
+
+	if (!page) {
+		atomic_long_inc(&cma->nr_failed);
+		return;
+	}
+	if (ready)
+		atomic_long_inc(&cma->nr_ready_hits);
+
+	for (i = 0; i < ARRAY_SIZE(cma_lat_bucket_us); i++)
+		if (lat_us < cma_lat_bucket_us[i])
+			break;
+	atomic_long_inc(&cma->lat_hist[i]);
+}
+
 static int cma_debugfs_get(void *data, u64 *val)
 {
 	unsigned long *p = data;
@@ -69,6 +94,58 @@ static int cma_maxchunk_get(void *data, u64 *val)
 }
 DEFINE_SIMPLE_ATTRIBUTE(cma_maxchunk_fops, cma_maxchunk_get, NULL, "%llu\n");
 
+static int cma_ready_target_get(void *data, u64 *val)
+{
+	struct cma *cma = data;
+
+	*val = cma->ready_target;
+
+	return 0;
+}
+
+static int cma_ready_target_set(void *data, u64 val)
+{
+	struct cma *cma = data;
+
+	cma_set_ready_pages(cma, val);
+
+	return 0;
+}
+DEFINE_SIMPLE_ATTRIBUTE(cma_ready_target_fops, cma_ready_target_get,
+			cma_ready_target_set, "%llu\n");
+
+static int cma_latency_show(struct seq_file *m, void *unused)
+{
+	struct cma *cma = m->private;
+	int i;
+
+	for (i = 0; i < CMA_LAT_BUCKETS; i++) {
+		if (i < ARRAY_SIZE(cma_lat_bucket_us))
+			seq_printf(m, "<%lu us", cma_lat_bucket_us[i]);
+		else
+			seq_printf(m, ">=%lu us",
+				   cma_lat_bucket_us[i - 1]);
+		seq_printf(m, "\t%ld\n", atomic_long_read(&cma->lat_hist[i]));
+	}
+	seq_printf(m, "ready_hits\t%ld\n",
+		   atomic_long_read(&cma->nr_ready_hits));
+	seq_printf(m, "failed\t%ld\n", atomic_long_read(&cma->nr_failed));
+
+	return 0;
+}
+
+static int cma_latency_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, cma_latency_show, inode->i_private);
+}
+
+static const struct file_operations cma_latency_fops = {
+	.open = cma_latency_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
 static void cma_add_to_cma_mem_list(struct cma *cma, struct cma_mem *mem)
 {
 	spin_lock(&cma->mem_head_lock);
@@ -185,6 +262,11 @@ static void cma_debugfs_add_one(struct cma *cma, int idx)
 				&cma->order_per_bit, &cma_debugfs_fops);
 	debugfs_create_file("used", S_IRUGO, tmp, cma, &cma_used_fops);
 	debugfs_create_file("maxchunk", S_IRUGO, tmp, cma, &cma_maxchunk_fops);
+	debugfs_create_file("ready", S_IRUGO, tmp,
+				&cma->ready_count, &cma_debugfs_fops);
+	debugfs_create_file("ready_target", S_IRUGO | S_IWUSR, tmp, cma,
+				&cma_ready_target_fops);
+	debugfs_create_file("latency", S_IRUGO, tmp, cma, &cma_latency_fops);
 
 	u32s = DIV_ROUND_UP(cma_bitmap_maxno(cma), BITS_PER_BYTE * sizeof(u32));
 	debugfs_create_u32_array("bitmap", S_IRUGO, tmp, (u32*)cma->bitmap, u32s);
@@ -20,6 +20,9 @@
 #include <linux/kthread.h>
 #include <linux/freezer.h>
 #include <linux/page_owner.h>
+#ifdef CONFIG_STATE_NOTIFIER
+#include <linux/state_notifier.h>
+#endif
 #include "internal.h"
 
 #ifdef CONFIG_COMPACTION
@@ -1289,6 +1292,90 @@ static inline bool is_via_compact_memory(int order)
 	return order == -1;
 }
 
+/*
+ * Proactive compaction keeps the free memory of each node usable for
+ * allocations of this order, which also covers the order 4 and 8 chunks
+ * that the GPU, ION and WLAN drivers ask for.
+ */
+#if defined CONFIG_TRANSPARENT_HUGEPAGE
+#define COMPACTION_HPAGE_ORDER	HPAGE_PMD_ORDER
+#elif defined CONFIG_HUGETLBFS
+#define COMPACTION_HPAGE_ORDER	HUGETLB_PAGE_ORDER
+#else
+#define COMPACTION_HPAGE_ORDER	(PMD_SHIFT - PAGE_SHIFT)
+#endif
+
+/* Checked on a deferrable timer, so an idle system is never woken up */
+#define HPAGE_FRAG_CHECK_INTERVAL_MSEC	500
+
+/*
+ * 0 disables proactive compaction. Higher values compact more aggressively
+ * in the background, at the cost of CPU time spent migrating pages.
+ */
+unsigned int __read_mostly sysctl_compaction_proactiveness = 20;
+
+static inline bool kswapd_is_running(pg_data_t *pgdat)
+{
+	return pgdat->kswapd && (pgdat->kswapd->state == TASK_RUNNING);
+}
+
+/*
+ * A zone's fragmentation score is its external fragmentation for
+ * COMPACTION_HPAGE_ORDER, weighted by its share of the node's pages so
+ * that a small zone cannot dominate the node score.
+ */
+static unsigned int fragmentation_score_zone(struct zone *zone)
+{
+	unsigned long score;
+
+	score = zone->present_pages *
+		extfrag_for_order(zone, COMPACTION_HPAGE_ORDER);
+	return div64_ul(score, zone->zone_pgdat->node_present_pages + 1);
+}
+
+/* Between 0 and 100, lower means more of the free memory is usable */
+static unsigned int fragmentation_score_node(pg_data_t *pgdat)
+{
+	unsigned int score = 0;
+	int zoneid;
+
+	for (zoneid = 0; zoneid < MAX_NR_ZONES; zoneid++) {
+		struct zone *zone = &pgdat->node_zones[zoneid];
+
+		if (!populated_zone(zone))
+			continue;
+		score += fragmentation_score_zone(zone);
+	}
+
+	return score;
+}
+
+/*
+ * Compaction starts above the high watermark and stops once the score is
+ * below the low one, the gap keeps it from running for every page freed.
+ */
+static unsigned int fragmentation_score_wmark(bool low)
+{
+	unsigned int wmark_low;
+
+	wmark_low = max(100U - sysctl_compaction_proactiveness, 5U);
+	return low ? wmark_low : min(wmark_low + 10, 100U);
+}
+
+static bool should_proactive_compact_node(pg_data_t *pgdat)
+{
+	if (!sysctl_compaction_proactiveness || kswapd_is_running(pgdat))
+		return false;
+
+#ifdef CONFIG_STATE_NOTIFIER
+	/* nothing needs the pages soon while the screen is off */
+	if (state_suspended)
+		return false;
+#endif
+
+	return fragmentation_score_node(pgdat) > fragmentation_score_wmark(false);
+}
+
 static int __compact_finished(struct zone *zone, struct compact_control *cc,
 			    const int migratetype)
 {
@@ -1315,6 +1402,15 @@ static int __compact_finished(struct zone *zone, struct compact_control *cc,
 		return COMPACT_COMPLETE;
 	}
 
+	if (cc->proactive_compaction) {
+		/* stay out of kswapd's way, and stop once the goal is met */
+		if (kswapd_is_running(zone->zone_pgdat) ||
+		    fragmentation_score_node(zone->zone_pgdat) <=
+		    fragmentation_score_wmark(true))
+			return COMPACT_PARTIAL;
+		return COMPACT_CONTINUE;
+	}
+
 	if (is_via_compact_memory(cc->order))
 		return COMPACT_CONTINUE;
 
@@ -1851,7 +1947,8 @@ void compaction_unregister_node(struct node *node)
 
 static inline bool kcompactd_work_requested(pg_data_t *pgdat)
 {
-	return pgdat->kcompactd_max_order > 0 || kthread_should_stop();
+	return pgdat->kcompactd_max_order > 0 || kthread_should_stop() ||
+		pgdat->kcompactd_proactive;
 }
 
 static bool kcompactd_node_suitable(pg_data_t *pgdat)
@@ -1946,6 +2043,93 @@ static void kcompactd_do_work(pg_data_t *pgdat)
 		pgdat->kcompactd_classzone_idx = pgdat->nr_zones - 1;
 }
 
+/*
+ * Compact all zones of a node until its fragmentation score drops below
+ * the low watermark, or kswapd starts running.
+ */
+static void proactive_compact_node(pg_data_t *pgdat)
+{
+	int zoneid;
+	struct zone *zone;
+	struct compact_control cc = {
+		.order = -1,
+		.mode = MIGRATE_SYNC_LIGHT,
+		.ignore_skip_hint = true,
+		.proactive_compaction = true,
+	};
+
+	count_compact_event(COMPACTPROACTIVE);
+
+	for (zoneid = 0; zoneid < MAX_NR_ZONES; zoneid++) {
+		zone = &pgdat->node_zones[zoneid];
+		if (!populated_zone(zone))
+			continue;
+
+		cc.nr_freepages = 0;
+		cc.nr_migratepages = 0;
+		cc.zone = zone;
+		INIT_LIST_HEAD(&cc.freepages);
+		INIT_LIST_HEAD(&cc.migratepages);
+
+		if (kthread_should_stop())
+			return;
+		compact_zone(zone, &cc);
+
+		VM_BUG_ON(!list_empty(&cc.freepages));
+		VM_BUG_ON(!list_empty(&cc.migratepages));
+	}
+
+	if (fragmentation_score_node(pgdat) <= fragmentation_score_wmark(true))
+		count_compact_event(COMPACTPROACTIVESUCCESS);
+}
+
+static void kcompactd_do_proactive(pg_data_t *pgdat)
+{
+	unsigned int prev_score, score;
+
+	pgdat->kcompactd_proactive = false;
+
+	if (pgdat->kcompactd_proactive_defer) {
+		pgdat->kcompactd_proactive_defer--;
+		return;
+	}
+
+	if (!should_proactive_compact_node(pgdat))
+		return;
+
+	prev_score = fragmentation_score_node(pgdat);
+	proactive_compact_node(pgdat);
+	score = fragmentation_score_node(pgdat);
+
+	/*
+	 * No progress usually means the remaining pages are unmovable, back
+	 * off rather than rescanning the same blocks every interval.
+	 */
+	if (score >= prev_score)
+		pgdat->kcompactd_proactive_defer = 1 << COMPACT_MAX_DEFER_SHIFT;
+}
+
+static void kcompactd_proactive_timer_fn(unsigned long data);
+static struct timer_list kcompactd_proactive_timer =
+	TIMER_DEFERRED_INITIALIZER(kcompactd_proactive_timer_fn, 0, 0);
+
+static void kcompactd_proactive_timer_fn(unsigned long data)
+{
+	int nid;
+
+	if (sysctl_compaction_proactiveness) {
+		for_each_node_state(nid, N_MEMORY) {
+			pg_data_t *pgdat = NODE_DATA(nid);
+
+			pgdat->kcompactd_proactive = true;
+			wake_up_interruptible(&pgdat->kcompactd_wait);
+		}
+	}
+
+	mod_timer(&kcompactd_proactive_timer, jiffies +
+		  msecs_to_jiffies(HPAGE_FRAG_CHECK_INTERVAL_MSEC));
+}
+
 void wakeup_kcompactd(pg_data_t *pgdat, int order, int classzone_idx)
 {
 	if (!order)
@@ -1986,13 +2170,18 @@ static int kcompactd(void *p)
 
 	pgdat->kcompactd_max_order = 0;
 	pgdat->kcompactd_classzone_idx = pgdat->nr_zones - 1;
+	pgdat->kcompactd_proactive = false;
+	pgdat->kcompactd_proactive_defer = 0;
 
 	while (!kthread_should_stop()) {
 		trace_mm_compaction_kcompactd_sleep(pgdat->node_id);
 		wait_event_freezable(pgdat->kcompactd_wait,
 				kcompactd_work_requested(pgdat));
 
-		kcompactd_do_work(pgdat);
+		if (pgdat->kcompactd_max_order > 0)
+			kcompactd_do_work(pgdat);
+		if (pgdat->kcompactd_proactive)
+			kcompactd_do_proactive(pgdat);
 	}
 
 	return 0;
@@ -2066,6 +2255,9 @@ static int __init kcompactd_init(void)
 	for_each_node_state(nid, N_MEMORY)
 		kcompactd_run(nid);
 	hotcpu_notifier(cpu_callback, 0);
+
+	mod_timer(&kcompactd_proactive_timer, jiffies +
+		  msecs_to_jiffies(HPAGE_FRAG_CHECK_INTERVAL_MSEC));
 	return 0;
 }
 subsys_initcall(kcompactd_init)
@@ -10,6 +10,7 @@
 #include <linux/kernel.h>
 #include <linux/file.h>
 #include <linux/fs.h>
+#include <linux/log2.h>
 #include <linux/mm.h>
 #include <linux/pagemap.h>
 #include <linux/backing-dev.h>
@@ -60,6 +61,7 @@ SYSCALL_DEFINE4(fadvise64_64, int, fd, loff_t, offset, loff_t, len, int, advice)
 		case POSIX_FADV_WILLNEED:
 		case POSIX_FADV_NOREUSE:
 		case POSIX_FADV_DONTNEED:
+		case POSIX_FADV_FAULTAROUND:
 			/* no bad return value, but ignore advice */
 			break;
 		default:
@@ -84,6 +86,8 @@ SYSCALL_DEFINE4(fadvise64_64, int, fd, loff_t, offset, loff_t, len, int, advice)
 	switch (advice) {
 	case POSIX_FADV_NORMAL:
 		f.file->f_ra.ra_pages = bdi->ra_pages;
+		f.file->f_ra.mmap_window = 0;
+		f.file->f_ra.fault_around = 0;
 		spin_lock(&f.file->f_lock);
 		f.file->f_mode &= ~FMODE_RANDOM;
 		spin_unlock(&f.file->f_lock);
@@ -118,6 +122,19 @@ SYSCALL_DEFINE4(fadvise64_64, int, fd, loff_t, offset, loff_t, len, int, advice)
 		break;
 	case POSIX_FADV_NOREUSE:
 		break;
+	case POSIX_FADV_FAULTAROUND:
+		/* Same bounds as the fault_around_bytes debugfs knob */
+		nrpages = len >> PAGE_SHIFT;
+		if (nrpages > PTRS_PER_PTE) {
+			ret = -EINVAL;
+			break;
+		}
+		/* a window below one page turns fault-around off */
+		if (len && !nrpages)
+			nrpages = 1;
+		WRITE_ONCE(f.file->f_ra.fault_around,
+			   nrpages ? rounddown_pow_of_two(nrpages) : 0);
+		break;
 	case POSIX_FADV_DONTNEED:
 		if (!inode_write_congested(mapping->host))
 			__filemap_fdatawrite_range(mapping, offset, endbyte,
@@ -1877,6 +1877,32 @@ static int page_cache_read(struct file *file, pgoff_t offset, gfp_t gfp_mask)
 
 #define MMAP_LOTSAMISS  (100)
 
+/*
+ * Learn the read-around window from where the misses land. A miss close to
+ * the previous window means the mapping is walked in clusters larger than
+ * the window (dex/oat code during app launch), so the window grows up to
+ * MMAP_WINDOW_MAX_SCALE times ra_pages. A miss far away means the pages
+ * read around were likely wasted, so the window shrinks back towards a
+ * quarter of ra_pages.
+ */
+#define MMAP_WINDOW_MAX_SCALE	4
+
+static unsigned int mmap_read_around_window(struct file_ra_state *ra,
+					    pgoff_t offset)
+{
+	unsigned int window = ra->mmap_window ?: ra->ra_pages;
+	unsigned int min_window = max(ra->ra_pages / 4, 1U);
+
+	if (ra->size && offset + ra->size >= ra->start &&
+	    offset < ra->start + 2 * ra->size)
+		window = min(window * 2, ra->ra_pages * MMAP_WINDOW_MAX_SCALE);
+	else if (ra->size)
+		window = max(window / 2, min_window);
+
+	ra->mmap_window = window;
+	return window;
+}
+
 /*
  * Synchronous readahead happens when we don't even find
  * a page in the page cache at all.
@@ -1887,6 +1913,7 @@ static void do_sync_mmap_readahead(struct vm_area_struct *vma,
 				   pgoff_t offset)
 {
 	struct address_space *mapping = file->f_mapping;
+	unsigned int window;
 
 	/* If we don't want any read-ahead, don't bother */
 	if (vma->vm_flags & VM_RAND_READ)
@@ -1914,9 +1941,10 @@ static void do_sync_mmap_readahead(struct vm_area_struct *vma,
 	/*
 	 * mmap read-around
 	 */
-	ra->start = max_t(long, 0, offset - ra->ra_pages / 2);
-	ra->size = ra->ra_pages;
-	ra->async_size = ra->ra_pages / 4;
+	window = mmap_read_around_window(ra, offset);
+	ra->start = max_t(long, 0, offset - window / 2);
+	ra->size = window;
+	ra->async_size = window / 4;
 	ra_submit(ra, mapping, file);
 }
 
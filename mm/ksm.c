@@ -26,6 +26,7 @@
 #include <linux/jhash.h>
 #include <linux/delay.h>
 #include <linux/kthread.h>
+#include <linux/ktime.h>
 #include <linux/wait.h>
 #include <linux/slab.h>
 #include <linux/rbtree.h>
@@ -99,12 +100,18 @@
  * @mm_list: link into the mm_slots list, rooted in ksm_mm_head
  * @rmap_list: head for this mm_slot's singly-linked list of rmap_items
  * @mm: the mm that this information is valid for
+ * @merged: pages merged from this mm in the current full scan
+ * @skip: number of full scans to leave this mm out of
+ * @backoff: last value of @skip, doubled for every fruitless scan
  */
 struct mm_slot {
 	struct hlist_node link;
 	struct list_head mm_list;
 	struct rmap_item *rmap_list;
 	struct mm_struct *mm;
+	unsigned long merged;
+	unsigned int skip;
+	unsigned int backoff;
 };
 
 /**
@@ -227,6 +234,28 @@ static unsigned int ksm_thread_sleep_millisecs = 20;
 /* Boolean to indicate whether to use deferred timer or not */
 static bool use_deferred_timer;
 
+/*
+ * Percentage of one CPU ksmd may use: when set, the sleep after each batch
+ * is sized from the time the batch took rather than sleep_millisecs.
+ */
+static unsigned int ksm_cpu_budget_pct;
+
+/* Whether to merge empty pages with the zero page */
+static bool ksm_use_zero_pages = true;
+
+/* Checksum of an empty page */
+static u32 zero_checksum __read_mostly;
+
+/* The number of pages merged with the zero page */
+static unsigned long ksm_zero_pages_merged;
+
+/*
+ * An mm that merged nothing in a full scan is left out of the next one,
+ * then out of twice as many after every further fruitless scan, up to
+ * KSM_MAX_SKIP_SCANS, so that the scan budget goes to the mms that yield.
+ */
+#define KSM_MAX_SKIP_SCANS	8
+
 #ifdef CONFIG_NUMA
 /* Zeroed when merging across nodes is not allowed */
 static unsigned int ksm_merge_across_nodes = 1;
@@ -952,6 +981,7 @@ static int replace_page(struct vm_area_struct *vma, struct page *page,
 	struct mm_struct *mm = vma->vm_mm;
 	pmd_t *pmd;
 	pte_t *ptep;
+	pte_t newpte;
 	spinlock_t *ptl;
 	unsigned long addr;
 	int err = -EFAULT;
@@ -976,12 +1006,19 @@ static int replace_page(struct vm_area_struct *vma, struct page *page,
 		goto out_mn;
 	}
 
-	get_page(kpage);
-	page_add_anon_rmap(kpage, vma, addr);
+	/* the zero page is only passed in when ksm_use_zero_pages is set */
+	if (!is_zero_pfn(page_to_pfn(kpage))) {
+		get_page(kpage);
+		page_add_anon_rmap(kpage, vma, addr);
+		newpte = mk_pte(kpage, vma->vm_page_prot);
+	} else {
+		newpte = pte_mkspecial(pfn_pte(page_to_pfn(kpage),
+					       vma->vm_page_prot));
+	}
 
 	flush_cache_page(vma, addr, pte_pfn(*ptep));
 	ptep_clear_flush_notify(vma, addr, ptep);
-	set_pte_at_notify(mm, addr, ptep, mk_pte(kpage, vma->vm_page_prot));
+	set_pte_at_notify(mm, addr, ptep, newpte);
 
 	page_remove_rmap(page);
 	if (!page_mapped(page))
@@ -1450,6 +1487,36 @@ static void stable_tree_append(struct rmap_item *rmap_item,
  * @page: the page that we are searching identical page to.
  * @rmap_item: the reverse mapping into the virtual address of this page
  */
+/* Credit a merge to the mm being scanned, see ksm_slot_scanned() */
+static inline void ksm_note_merge(void)
+{
+	ksm_scan.mm_slot->merged++;
+}
+
+/*
+ * Merge an empty page with the zero page, without involving the stable
+ * tree. Returns 0 if the page was merged.
+ */
+static int try_to_merge_zero_page(struct rmap_item *rmap_item,
+				  struct page *page)
+{
+	struct mm_struct *mm = rmap_item->mm;
+	struct vm_area_struct *vma;
+	int err = -EFAULT;
+
+	down_read(&mm->mmap_sem);
+	vma = find_mergeable_vma(mm, rmap_item->address);
+	/* mlock accounting has no business with the zero page */
+	if (vma && !(vma->vm_flags & VM_LOCKED))
+		err = try_to_merge_one_page(vma, page,
+				ZERO_PAGE(rmap_item->address));
+	up_read(&mm->mmap_sem);
+
+	if (!err)
+		ksm_zero_pages_merged++;
+	return err;
+}
+
 static void cmp_and_merge_page(struct page *page, struct rmap_item *rmap_item)
 {
 	struct rmap_item *tree_rmap_item;
@@ -1492,6 +1559,7 @@ static void cmp_and_merge_page(struct page *page, struct rmap_item *rmap_item)
 			lock_page(kpage);
 			stable_tree_append(rmap_item, page_stable_node(kpage));
 			unlock_page(kpage);
+			ksm_note_merge();
 		}
 		put_page(kpage);
 		return;
@@ -1509,6 +1577,16 @@ static void cmp_and_merge_page(struct page *page, struct rmap_item *rmap_item)
 		return;
 	}
 
+	/*
+	 * Same checksum as an empty page: merge it with the zero page. If
+	 * that fails, the page was not really empty, carry on.
+	 */
+	if (ksm_use_zero_pages && checksum == zero_checksum &&
+	    !try_to_merge_zero_page(rmap_item, page)) {
+		ksm_note_merge();
+		return;
+	}
+
 	tree_rmap_item =
 		unstable_tree_search_insert(rmap_item, page, &tree_page);
 	if (tree_rmap_item) {
@@ -1539,6 +1617,7 @@ static void cmp_and_merge_page(struct page *page, struct rmap_item *rmap_item)
 			if (stable_node) {
 				stable_tree_append(tree_rmap_item, stable_node);
 				stable_tree_append(rmap_item, stable_node);
+				ksm_note_merge();
 			}
 			unlock_page(kpage);
 
@@ -1598,6 +1677,33 @@ static struct rmap_item *get_next_rmap_item(struct mm_slot *mm_slot,
 	return rmap_item;
 }
 
+/*
+ * Drop the rmap_items of an mm left out of a full scan from the unstable
+ * tree, as a later scan would not find them at the age it expects.
+ */
+static void ksm_forget_unstable(struct mm_slot *slot)
+{
+	struct rmap_item *rmap_item;
+
+	for (rmap_item = slot->rmap_list; rmap_item;
+	     rmap_item = rmap_item->rmap_list)
+		if (rmap_item->address & UNSTABLE_FLAG)
+			remove_rmap_item_from_tree(rmap_item);
+}
+
+/* Decide from its yield whether the next full scans skip this mm */
+static void ksm_slot_scanned(struct mm_slot *slot)
+{
+	if (slot->merged) {
+		slot->backoff = 0;
+	} else {
+		slot->backoff = clamp(slot->backoff * 2, 1U,
+				      (unsigned int)KSM_MAX_SKIP_SCANS);
+		slot->skip = slot->backoff;
+	}
+	slot->merged = 0;
+}
+
 static struct rmap_item *scan_get_next_rmap_item(struct page **page)
 {
 	struct mm_struct *mm;
@@ -1658,6 +1764,20 @@ static struct rmap_item *scan_get_next_rmap_item(struct page **page)
 		if (slot == &ksm_mm_head)
 			return NULL;
 next_mm:
+		if (slot->skip && !ksm_test_exit(slot->mm)) {
+			slot->skip--;
+			ksm_forget_unstable(slot);
+			spin_lock(&ksm_mmlist_lock);
+			slot = list_entry(slot->mm_list.next,
+					  struct mm_slot, mm_list);
+			ksm_scan.mm_slot = slot;
+			spin_unlock(&ksm_mmlist_lock);
+			if (slot == &ksm_mm_head) {
+				ksm_scan.seqnr++;
+				return NULL;
+			}
+			goto next_mm;
+		}
 		ksm_scan.address = 0;
 		ksm_scan.rmap_list = &slot->rmap_list;
 	}
@@ -1716,6 +1836,7 @@ next_mm:
 	 * because there were no VM_MERGEABLE vmas with such addresses.
 	 */
 	remove_trailing_rmap_items(slot, ksm_scan.rmap_list);
+	ksm_slot_scanned(slot);
 
 	spin_lock(&ksm_mmlist_lock);
 	ksm_scan.mm_slot = list_entry(slot->mm_list.next,
@@ -1811,16 +1932,37 @@ static int ksmd_should_run(void)
 	return (ksm_run & KSM_RUN_MERGE) && !list_empty(&ksm_mm_head.mm_list);
 }
 
+/*
+ * With a CPU budget, sleep long enough after a batch that took @busy_ns
+ * for ksmd to stay within ksm_cpu_budget_pct of one CPU.
+ */
+static unsigned long ksm_sleep_jiffies(u64 busy_ns)
+{
+	unsigned int pct = READ_ONCE(ksm_cpu_budget_pct);
+
+	if (!pct)
+		return msecs_to_jiffies(ksm_thread_sleep_millisecs);
+
+	return max_t(unsigned long, 1,
+		     nsecs_to_jiffies(div_u64(busy_ns * (100 - pct), pct)));
+}
+
 static int ksm_scan_thread(void *nothing)
 {
+	u64 start, busy_ns;
+
 	set_freezable();
 	set_user_nice(current, 5);
 
 	while (!kthread_should_stop()) {
+		busy_ns = 0;
 		mutex_lock(&ksm_thread_mutex);
 		wait_while_offlining();
-		if (ksmd_should_run())
+		if (ksmd_should_run()) {
+			start = ktime_get_ns();
 			ksm_do_scan(ksm_thread_pages_to_scan);
+			busy_ns = ktime_get_ns() - start;
+		}
 		mutex_unlock(&ksm_thread_mutex);
 
 		try_to_freeze();
@@ -1828,10 +1970,10 @@ static int ksm_scan_thread(void *nothing)
 		if (ksmd_should_run()) {
 			if (use_deferred_timer)
 				deferred_schedule_timeout(
-				msecs_to_jiffies(ksm_thread_sleep_millisecs));
+					ksm_sleep_jiffies(busy_ns));
 			else
 				schedule_timeout_interruptible(
-				msecs_to_jiffies(ksm_thread_sleep_millisecs));
+					ksm_sleep_jiffies(busy_ns));
 		} else {
 			wait_event_freezable(ksm_thread_wait,
 				ksmd_should_run() || kthread_should_stop());
@@ -2235,6 +2377,59 @@ static ssize_t pages_to_scan_store(struct kobject *kobj,
 }
 KSM_ATTR(pages_to_scan);
 
+static ssize_t cpu_budget_pct_show(struct kobject *kobj,
+				   struct kobj_attribute *attr, char *buf)
+{
+	return sprintf(buf, "%u\n", ksm_cpu_budget_pct);
+}
+
+static ssize_t cpu_budget_pct_store(struct kobject *kobj,
+				    struct kobj_attribute *attr,
+				    const char *buf, size_t count)
+{
+	unsigned int pct;
+	int err;
+
+	err = kstrtouint(buf, 10, &pct);
+	if (err || pct > 100)
+		return -EINVAL;
+
+	ksm_cpu_budget_pct = pct;
+
+	return count;
+}
+KSM_ATTR(cpu_budget_pct);
+
+static ssize_t use_zero_pages_show(struct kobject *kobj,
+				   struct kobj_attribute *attr, char *buf)
+{
+	return sprintf(buf, "%u\n", ksm_use_zero_pages);
+}
+
+static ssize_t use_zero_pages_store(struct kobject *kobj,
+				    struct kobj_attribute *attr,
+				    const char *buf, size_t count)
+{
+	bool value;
+	int err;
+
+	err = kstrtobool(buf, &value);
+	if (err)
+		return -EINVAL;
+
+	ksm_use_zero_pages = value;
+
+	return count;
+}
+KSM_ATTR(use_zero_pages);
+
+static ssize_t zero_pages_merged_show(struct kobject *kobj,
+				      struct kobj_attribute *attr, char *buf)
+{
+	return sprintf(buf, "%lu\n", ksm_zero_pages_merged);
+}
+KSM_ATTR_RO(zero_pages_merged);
+
 static ssize_t run_show(struct kobject *kobj, struct kobj_attribute *attr,
 			char *buf)
 {
@@ -2416,6 +2611,9 @@ static struct attribute *ksm_attrs[] = {
 	&pages_volatile_attr.attr,
 	&full_scans_attr.attr,
 	&deferred_timer_attr.attr,
+	&cpu_budget_pct_attr.attr,
+	&use_zero_pages_attr.attr,
+	&zero_pages_merged_attr.attr,
 #ifdef CONFIG_NUMA
 	&merge_across_nodes_attr.attr,
 #endif
@@ -2433,6 +2631,9 @@ static int __init ksm_init(void)
 	struct task_struct *ksm_thread;
 	int err;
 
+	/* The correct value depends on page size and endianness */
+	zero_checksum = calc_checksum(ZERO_PAGE(0));
+
 	err = ksm_slab_init();
 	if (err)
 		goto out;
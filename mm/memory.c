@@ -2544,9 +2544,9 @@ static int do_swap_page(struct mm_struct *mm, struct vm_area_struct *vma,
 		goto out;
 	}
 	delayacct_set_flag(DELAYACCT_PF_SWAPIN);
-	page = lookup_swap_cache(entry);
+	page = lookup_swap_cache(entry, vma, address);
 	if (!page) {
-		page = swapin_readahead(entry,
+		page = swap_vma_readahead(entry,
 					GFP_HIGHUSER_MOVABLE, vma, address);
 		if (!page) {
 			/*
@@ -2914,6 +2914,18 @@ static int __init fault_around_debugfs(void)
 late_initcall(fault_around_debugfs);
 #endif
 
+static unsigned long fault_around_pages(struct vm_area_struct *vma)
+{
+	unsigned int nr_pages = 0;
+
+	/* a per-file size from POSIX_FADV_FAULTAROUND wins */
+	if (vma->vm_file)
+		nr_pages = READ_ONCE(vma->vm_file->f_ra.fault_around);
+	if (nr_pages)
+		return nr_pages;
+	return READ_ONCE(fault_around_bytes) >> PAGE_SHIFT;
+}
+
 /*
  * do_fault_around() tries to map few pages around the fault address. The hope
  * is that the pages will be needed soon and this will lower the number of
@@ -2945,7 +2957,7 @@ static void do_fault_around(struct vm_area_struct *vma, unsigned long address,
 	struct vm_fault vmf;
 	int off;
 
-	nr_pages = READ_ONCE(fault_around_bytes) >> PAGE_SHIFT;
+	nr_pages = fault_around_pages(vma);
 	mask = ~(nr_pages * PAGE_SIZE - 1) & PAGE_MASK;
 
 	start_addr = max(address & mask, vma->vm_start);
@@ -2995,7 +3007,7 @@ static int do_read_fault(struct mm_struct *mm, struct vm_area_struct *vma,
 	 * if page by the offset is not ready to be mapped (cold cache or
 	 * something).
 	 */
-	if (vma->vm_ops->map_pages && fault_around_bytes >> PAGE_SHIFT > 1) {
+	if (vma->vm_ops->map_pages && fault_around_pages(vma) > 1) {
 		pte = pte_offset_map_lock(mm, pmd, address, &ptl);
 		do_fault_around(vma, address, pte, pgoff, flags);
 		if (!pte_same(*pte, orig_pte))
@@ -929,6 +929,47 @@ static void free_pcppages_bulk(struct zone *zone, int count,
 	spin_unlock(&zone->lock);
 }
 
+/*
+ * Frees at least count pages worth of blocks from the high-order PCP lists,
+ * oldest first and larger orders before smaller ones. Returns the number of
+ * pages freed.
+ */
+static int free_pcppages_high_bulk(struct zone *zone, int count,
+					struct per_cpu_pages *pcp)
+{
+	int order, migratetype;
+	int freed = 0;
+
+	spin_lock(&zone->lock);
+	for (order = PCP_HIGH_ORDER; order > 0 && freed < count; order--) {
+		for (migratetype = 0; migratetype < MIGRATE_PCPTYPES;
+		     migratetype++) {
+			struct list_head *list;
+
+			list = &pcp->high_lists[order - 1][migratetype];
+			while (!list_empty(list) && freed < count) {
+				struct page *page;
+				int mt;
+
+				page = list_entry(list->prev, struct page, lru);
+				list_del(&page->lru);
+
+				mt = get_pcppage_migratetype(page);
+				VM_BUG_ON_PAGE(is_migrate_isolate(mt), page);
+				if (unlikely(has_isolate_pageblock(zone)))
+					mt = get_pageblock_migratetype(page);
+
+				__free_one_page(page, page_to_pfn(page), zone,
+						order, mt);
+				trace_mm_page_pcpu_drain(page, order, mt);
+				freed += 1 << order;
+			}
+		}
+	}
+	spin_unlock(&zone->lock);
+	return freed;
+}
+
 static void free_one_page(struct zone *zone,
 				struct page *page, unsigned long pfn,
 				unsigned int order,
@@ -1106,7 +1147,32 @@ static void __free_pages_ok(struct page *page, unsigned int order)
 	migratetype = get_pfnblock_migratetype(page, pfn);
 	local_irq_save(flags);
 	__count_vm_events(PGFREE, 1 << order);
+
+	/*
+	 * Small high-order blocks go to the per-cpu lists like order-0 pages
+	 * do. Highatomic reserves and isolated blocks bypass them so that
+	 * the reserve accounting and isolation see the pages immediately.
+	 */
+	if (order && order <= PCP_HIGH_ORDER && migratetype < MIGRATE_PCPTYPES) {
+		struct zone *zone = page_zone(page);
+		struct per_cpu_pages *pcp;
+
+		if (unlikely(has_isolate_pageblock(zone)))
+			goto free_one;
+
+		pcp = &this_cpu_ptr(zone->pageset)->pcp;
+		set_pcppage_migratetype(page, migratetype);
+		list_add(&page->lru, &pcp->high_lists[order - 1][migratetype]);
+		pcp->high_count += 1 << order;
+		if (pcp->high_count >= pcp->high / 2)
+			pcp->high_count -= free_pcppages_high_bulk(zone,
+					READ_ONCE(pcp->batch), pcp);
+		goto out;
+	}
+
+free_one:
 	free_one_page(page_zone(page), page, pfn, order, migratetype);
+out:
 	local_irq_restore(flags);
 }
 
@@ -2042,16 +2108,24 @@ static struct list_head *get_populated_pcp_list(struct zone *zone,
 			unsigned int order, struct per_cpu_pages *pcp,
 			int migratetype, int cold)
 {
-	struct list_head *list = &pcp->lists[migratetype];
-
-	if (list_empty(list)) {
-		pcp->count += rmqueue_bulk(zone, order,
-				pcp->batch, list,
-				migratetype, cold);
+	struct list_head *list;
 
+	if (order) {
+		list = &pcp->high_lists[order - 1][migratetype];
 		if (list_empty(list))
-			list = NULL;
+			pcp->high_count += rmqueue_bulk(zone, order,
+					max(pcp->batch >> order, 1), list,
+					migratetype, cold) << order;
+	} else {
+		list = &pcp->lists[migratetype];
+		if (list_empty(list))
+			pcp->count += rmqueue_bulk(zone, order,
+					pcp->batch, list,
+					migratetype, cold);
 	}
+
+	if (list_empty(list))
+		list = NULL;
 	return list;
 }
 
@@ -2076,6 +2150,9 @@ void drain_zone_pages(struct zone *zone, struct per_cpu_pages *pcp)
 		free_pcppages_bulk(zone, to_drain, pcp);
 		pcp->count -= to_drain;
 	}
+	if (pcp->high_count)
+		pcp->high_count -= free_pcppages_high_bulk(zone,
+					pcp->high_count, pcp);
 	local_irq_restore(flags);
 }
 #endif
@@ -2101,6 +2178,9 @@ static void drain_pages_zone(unsigned int cpu, struct zone *zone)
 		free_pcppages_bulk(zone, pcp->count, pcp);
 		pcp->count = 0;
 	}
+	if (pcp->high_count)
+		pcp->high_count -= free_pcppages_high_bulk(zone,
+					pcp->high_count, pcp);
 	local_irq_restore(flags);
 }
 
@@ -2170,12 +2250,12 @@ void drain_all_pages(struct zone *zone)
 
 		if (zone) {
 			pcp = per_cpu_ptr(zone->pageset, cpu);
-			if (pcp->pcp.count)
+			if (pcp->pcp.count || pcp->pcp.high_count)
 				has_pcps = true;
 		} else {
 			for_each_populated_zone(z) {
 				pcp = per_cpu_ptr(z->pageset, cpu);
-				if (pcp->pcp.count) {
+				if (pcp->pcp.count || pcp->pcp.high_count) {
 					has_pcps = true;
 					break;
 				}
@@ -2375,7 +2455,13 @@ struct page *buffered_rmqueue(struct zone *preferred_zone,
 	struct page *page = NULL;
 	bool cold = ((gfp_flags & __GFP_COLD) != 0);
 
-	if (likely(order == 0)) {
+	/*
+	 * Order-0 and small high-order requests are served from the per-cpu
+	 * lists. Highatomic allocations need the zone's reserve, so those
+	 * keep going to the buddy lists.
+	 */
+	if (likely(order == 0) || (order <= PCP_HIGH_ORDER &&
+				   !(alloc_flags & ALLOC_HARDER))) {
 		struct per_cpu_pages *pcp;
 		struct list_head *list = NULL;
 
@@ -2385,7 +2471,7 @@ struct page *buffered_rmqueue(struct zone *preferred_zone,
 		/* First try to get CMA pages */
 		if (migratetype == MIGRATE_MOVABLE &&
 			gfp_flags & __GFP_CMA) {
-			list = get_populated_pcp_list(zone, 0, pcp,
+			list = get_populated_pcp_list(zone, order, pcp,
 					get_cma_migrate_type(), cold);
 		}
 
@@ -2394,7 +2480,7 @@ struct page *buffered_rmqueue(struct zone *preferred_zone,
 			 * Either CMA is not suitable or there are no free CMA
 			 * pages.
 			 */
-			list = get_populated_pcp_list(zone, 0, pcp,
+			list = get_populated_pcp_list(zone, order, pcp,
 				migratetype, cold);
 			if (unlikely(list == NULL) ||
 				unlikely(list_empty(list)))
@@ -2407,7 +2493,10 @@ struct page *buffered_rmqueue(struct zone *preferred_zone,
 			page = list_entry(list->next, struct page, lru);
 
 		list_del(&page->lru);
-		pcp->count--;
+		if (order)
+			pcp->high_count -= 1 << order;
+		else
+			pcp->count--;
 	} else {
 		if (unlikely(gfp_flags & __GFP_NOFAIL)) {
 			/*
@@ -3971,7 +4060,8 @@ void show_free_areas(unsigned int filter)
 			continue;
 
 		for_each_online_cpu(cpu)
-			free_pcp += per_cpu_ptr(zone->pageset, cpu)->pcp.count;
+			free_pcp += per_cpu_ptr(zone->pageset, cpu)->pcp.count +
+				per_cpu_ptr(zone->pageset, cpu)->pcp.high_count;
 	}
 
 	printk("active_anon:%lu inactive_anon:%lu isolated_anon:%lu\n"
@@ -4008,7 +4098,8 @@ void show_free_areas(unsigned int filter)
 
 		free_pcp = 0;
 		for_each_online_cpu(cpu)
-			free_pcp += per_cpu_ptr(zone->pageset, cpu)->pcp.count;
+			free_pcp += per_cpu_ptr(zone->pageset, cpu)->pcp.count +
+				per_cpu_ptr(zone->pageset, cpu)->pcp.high_count;
 
 		show_node(zone);
 		printk("%s"
@@ -4831,14 +4922,18 @@ static void pageset_set_batch(struct per_cpu_pageset *p, unsigned long batch)
 static void pageset_init(struct per_cpu_pageset *p)
 {
 	struct per_cpu_pages *pcp;
-	int migratetype;
+	int migratetype, order;
 
 	memset(p, 0, sizeof(*p));
 
 	pcp = &p->pcp;
 	pcp->count = 0;
-	for (migratetype = 0; migratetype < MIGRATE_PCPTYPES; migratetype++)
+	pcp->high_count = 0;
+	for (migratetype = 0; migratetype < MIGRATE_PCPTYPES; migratetype++) {
 		INIT_LIST_HEAD(&pcp->lists[migratetype]);
+		for (order = 0; order < PCP_HIGH_ORDER; order++)
+			INIT_LIST_HEAD(&pcp->high_lists[order][migratetype]);
+	}
 }
 
 static void setup_pageset(struct per_cpu_pageset *p, unsigned long batch)
@@ -15,6 +15,7 @@
 #include <linux/gfp.h>
 #include <linux/pagemap.h>
 #include <linux/swap.h>
+#include <linux/swapfile.h>
 #include <linux/bio.h>
 #include <linux/swapops.h>
 #include <linux/buffer_head.h>
@@ -61,6 +62,10 @@ void end_swap_bio_write(struct bio *bio)
 				iminor(bio->bi_bdev->bd_inode),
 				(unsigned long long)bio->bi_iter.bi_sector);
 		ClearPageReclaim(page);
+	} else if (bio->bi_private) {
+		/* start time stashed by __swap_writepage() */
+		swap_ratio_account_write(page_swap_info(page),
+					 (unsigned long)bio->bi_private);
 	}
 	end_page_writeback(page);
 	bio_put(bio);
@@ -257,6 +262,7 @@ int __swap_writepage(struct page *page, struct writeback_control *wbc,
 	struct bio *bio;
 	int ret, rw = WRITE;
 	struct swap_info_struct *sis = page_swap_info(page);
+	unsigned long start_ns = 0;
 
 	VM_BUG_ON_PAGE(!PageSwapCache(page), page);
 	if (sis->flags & SWP_FILE) {
@@ -300,8 +306,13 @@ int __swap_writepage(struct page *page, struct writeback_control *wbc,
 		return ret;
 	}
 
+	if (swap_ratio_measure(sis))
+		start_ns = (unsigned long)ktime_get_ns();
+
 	ret = bdev_write_page(sis->bdev, swap_page_sector(page), page, wbc);
 	if (!ret) {
+		if (start_ns)
+			swap_ratio_account_write(sis, start_ns);
 		count_vm_event(PSWPOUT);
 		return 0;
 	}
@@ -316,6 +327,8 @@ int __swap_writepage(struct page *page, struct writeback_control *wbc,
 	}
 	if (wbc->sync_mode == WB_SYNC_ALL)
 		rw |= REQ_SYNC;
+	if (start_ns && end_write_func == end_swap_bio_write)
+		bio->bi_private = (void *)start_ns;
 	count_vm_event(PSWPOUT);
 	set_page_writeback(page);
 	unlock_page(page);
@@ -67,6 +67,24 @@ module_param_named(swap_eff_win, swap_eff_win, int, S_IRUGO | S_IWUSR);
 static int swap_opt_eff = 50;
 module_param_named(swap_opt_eff, swap_opt_eff, int, S_IRUGO | S_IWUSR);
 
+/*
+ * Only reclaim anon pages that stayed unreferenced for idle_windows
+ * periods of idle_window_ms. Needs CONFIG_IDLE_PAGE_TRACKING; 0, the
+ * default, reclaims whatever the page table walk finds first. Platforms
+ * opt in from userspace or with process_reclaim.idle_windows= on the
+ * command line.
+ */
+static int idle_windows;
+module_param_named(idle_windows, idle_windows, int, S_IRUGO | S_IWUSR);
+
+static int idle_window_ms = 5000;
+module_param_named(idle_window_ms, idle_window_ms, int, S_IRUGO | S_IWUSR);
+
+/* Cap on the pages reclaimed from a single task in a run, 0 for none */
+static int per_task_budget;
+module_param_named(per_task_budget, per_task_budget, int,
+	S_IRUGO | S_IWUSR);
+
 static atomic_t skip_reclaim = ATOMIC_INIT(0);
 /* Not atomic since only a single instance of swap_fn run at a time */
 static int monitor_eff;
@@ -187,8 +205,18 @@ static void swap_fn(struct work_struct *work)
 		/* scan atleast a page */
 		if (!nr_to_reclaim)
 			nr_to_reclaim = 1;
-
-		rp = reclaim_task_anon(selected[si].p, nr_to_reclaim);
+		if (per_task_budget > 0)
+			nr_to_reclaim = min(nr_to_reclaim, per_task_budget);
+
+		if (IS_ENABLED(CONFIG_IDLE_PAGE_TRACKING) && idle_windows > 0) {
+			rp = reclaim_task_idle_anon(selected[si].p,
+				nr_to_reclaim, msecs_to_jiffies(idle_windows *
+							idle_window_ms));
+			trace_process_reclaim_idle(selected[si].tasksize,
+				rp.nr_idle, rp.nr_hot, rp.nr_reclaimed);
+		} else {
+			rp = reclaim_task_anon(selected[si].p, nr_to_reclaim);
+		}
 
 		trace_process_reclaim(selected[si].tasksize,
 				selected[si].oom_score_adj, rp.nr_scanned,
@@ -2400,6 +2400,7 @@ static void *___slab_alloc(struct kmem_cache *s, gfp_t gfpflags, int node,
 	void *freelist;
 	struct page *page;
 
+	c->nr_slowpath++;
 	page = c->page;
 	if (!page)
 		goto new_slab;
@@ -2464,6 +2465,7 @@ new_slab:
 		page = c->page = c->partial;
 		c->partial = page->next;
 		stat(s, CPU_PARTIAL_ALLOC);
+		c->nr_partial_hit++;
 		c->freelist = NULL;
 		goto redo;
 	}
@@ -3466,6 +3468,10 @@ static int kmem_cache_open(struct kmem_cache *s, unsigned long flags)
 	else
 		s->cpu_partial = 30;
 
+#ifdef CONFIG_SLUB_CPU_PARTIAL
+	s->cpu_partial_base = s->cpu_partial;
+	s->min_partial_base = s->min_partial;
+#endif
 #ifdef CONFIG_NUMA
 	s->remote_node_defrag_ratio = 1000;
 #endif
@@ -4771,6 +4777,9 @@ static ssize_t min_partial_store(struct kmem_cache *s, const char *buf,
 		return err;
 
 	set_min_partial(s, min);
+#ifdef CONFIG_SLUB_CPU_PARTIAL
+	s->min_partial_base = s->min_partial;
+#endif
 	return length;
 }
 SLAB_ATTR(min_partial);
@@ -4793,11 +4802,138 @@ static ssize_t cpu_partial_store(struct kmem_cache *s, const char *buf,
 		return -EINVAL;
 
 	s->cpu_partial = objects;
+#ifdef CONFIG_SLUB_CPU_PARTIAL
+	s->cpu_partial_base = objects;
+#endif
 	flush_all(s);
 	return length;
 }
 SLAB_ATTR(cpu_partial);
 
+#ifdef CONFIG_SLUB_CPU_PARTIAL
+/*
+ * Caches with cpu_partial_auto set get their cpu_partial and min_partial
+ * resized every SLUB_AUTOTUNE_INTERVAL from the rate of allocations and
+ * frees and the share of them that needed the slowpath. The rate comes from
+ * the per cpu tids, which every fastpath operation already bumps, so the
+ * fastpath stays untouched. A cache that takes the slowpath more than once
+ * every SLUB_AUTOTUNE_SLOW_RATIO operations gets twice the cpu partial
+ * objects, up to SLUB_AUTOTUNE_MAX_SCALE times its base, and one more node
+ * partial slab. A quiet cache decays back to its base values.
+ */
+#define SLUB_AUTOTUNE_INTERVAL		HZ
+#define SLUB_AUTOTUNE_MIN_EVENTS	1024
+#define SLUB_AUTOTUNE_SLOW_RATIO	32
+#define SLUB_AUTOTUNE_MAX_SCALE		8
+
+static void slub_autotune_fn(struct work_struct *work);
+static DECLARE_DEFERRABLE_WORK(slub_autotune_work, slub_autotune_fn);
+
+static void slub_cpu_counts(struct kmem_cache *s, unsigned long *events,
+			    unsigned long *slowpath, unsigned long *partial_hit)
+{
+	int cpu;
+
+	*events = *slowpath = 0;
+	if (partial_hit)
+		*partial_hit = 0;
+	for_each_possible_cpu(cpu) {
+		struct kmem_cache_cpu *c = per_cpu_ptr(s->cpu_slab, cpu);
+
+		*events += tid_to_event(READ_ONCE(c->tid));
+		*slowpath += READ_ONCE(c->nr_slowpath);
+		if (partial_hit)
+			*partial_hit += READ_ONCE(c->nr_partial_hit);
+	}
+}
+
+static void slub_autotune(struct kmem_cache *s)
+{
+	unsigned long events, slowpath, d_events, d_slowpath;
+
+	slub_cpu_counts(s, &events, &slowpath, NULL);
+	d_events = events - s->autotune_events;
+	d_slowpath = slowpath - s->autotune_slowpath;
+	s->autotune_events = events;
+	s->autotune_slowpath = slowpath;
+
+	if (d_events >= SLUB_AUTOTUNE_MIN_EVENTS &&
+	    d_slowpath * SLUB_AUTOTUNE_SLOW_RATIO > d_events) {
+		s->cpu_partial = min(max(s->cpu_partial * 2, 2U),
+			s->cpu_partial_base * SLUB_AUTOTUNE_MAX_SCALE);
+		set_min_partial(s, s->min_partial + 1);
+	} else if (d_events < SLUB_AUTOTUNE_MIN_EVENTS) {
+		s->cpu_partial = max(s->cpu_partial / 2, s->cpu_partial_base);
+		if (s->min_partial > s->min_partial_base)
+			s->min_partial--;
+	}
+}
+
+static void slub_autotune_fn(struct work_struct *work)
+{
+	struct kmem_cache *s;
+	bool active = false;
+
+	mutex_lock(&slab_mutex);
+	list_for_each_entry(s, &slab_caches, list) {
+		if (!READ_ONCE(s->cpu_partial_auto))
+			continue;
+		slub_autotune(s);
+		active = true;
+	}
+	mutex_unlock(&slab_mutex);
+
+	if (active)
+		queue_delayed_work(system_unbound_wq, &slub_autotune_work,
+				   SLUB_AUTOTUNE_INTERVAL);
+}
+
+static ssize_t cpu_partial_auto_show(struct kmem_cache *s, char *buf)
+{
+	return sprintf(buf, "%d\n", s->cpu_partial_auto);
+}
+
+static ssize_t cpu_partial_auto_store(struct kmem_cache *s, const char *buf,
+				      size_t length)
+{
+	bool enable;
+	int err;
+
+	err = kstrtobool(buf, &enable);
+	if (err)
+		return err;
+	if (enable && !kmem_cache_has_cpu_partial(s))
+		return -EINVAL;
+
+	if (enable && !s->cpu_partial_auto) {
+		slub_cpu_counts(s, &s->autotune_events, &s->autotune_slowpath,
+				NULL);
+		WRITE_ONCE(s->cpu_partial_auto, true);
+		queue_delayed_work(system_unbound_wq, &slub_autotune_work,
+				   SLUB_AUTOTUNE_INTERVAL);
+	} else if (!enable && s->cpu_partial_auto) {
+		WRITE_ONCE(s->cpu_partial_auto, false);
+		s->cpu_partial = s->cpu_partial_base;
+		set_min_partial(s, s->min_partial_base);
+		flush_all(s);
+	}
+	return length;
+}
+SLAB_ATTR(cpu_partial_auto);
+
+/* Always available, unlike the CONFIG_SLUB_STATS counters */
+static ssize_t cpu_hit_stats_show(struct kmem_cache *s, char *buf)
+{
+	unsigned long events, slowpath, partial_hit;
+
+	slub_cpu_counts(s, &events, &slowpath, &partial_hit);
+	return sprintf(buf, "ops %lu slowpath %lu cpu_partial_hit %lu fastpath_pct %lu\n",
+		       events, slowpath, partial_hit,
+		       events ? 100 - min(slowpath * 100 / events, 100UL) : 0);
+}
+SLAB_ATTR_RO(cpu_hit_stats);
+#endif
+
 static ssize_t ctor_show(struct kmem_cache *s, char *buf)
 {
 	if (!s->ctor)
@@ -5210,6 +5346,10 @@ static struct attribute *slab_attrs[] = {
 	&order_attr.attr,
 	&min_partial_attr.attr,
 	&cpu_partial_attr.attr,
+#ifdef CONFIG_SLUB_CPU_PARTIAL
+	&cpu_partial_auto_attr.attr,
+	&cpu_hit_stats_attr.attr,
+#endif
 	&objects_attr.attr,
 	&objects_partial_attr.attr,
 	&partial_attr.attr,
@@ -14,11 +14,16 @@
 #include <linux/mm_types.h>
 #include <linux/swapfile.h>
 #include <linux/swap.h>
+#include <linux/blkdev.h>
+#include <linux/ktime.h>
+#include <linux/module.h>
 
 #define SWAP_RATIO_GROUP_START (SWAP_FLAG_PRIO_MASK - 9) /* 32758 */
 #define SWAP_RATIO_GROUP_END (SWAP_FLAG_PRIO_MASK) /* 32767 */
 #define SWAP_FAST_WRITES (SWAPFILE_CLUSTER * (SWAP_CLUSTER_MAX / 8))
 #define SWAP_SLOW_WRITES SWAPFILE_CLUSTER
+/* keep some writes on the fast device so that its costs stay measured */
+#define SWAP_RATIO_DYNAMIC_MIN 10
 
 /*
  * The fast/slow swap write ratio.
@@ -30,6 +35,12 @@ int sysctl_swap_ratio = 100;
 /* Enable the swap ratio feature */
 int sysctl_swap_ratio_enable;
 
+/* Adapt the ratio to the measured cost of writing to each device */
+int sysctl_swap_ratio_dynamic;
+
+/* The ratio currently in use, sysctl_swap_ratio unless adapted */
+int sysctl_swap_ratio_effective = 100;
+
 static bool is_same_group(struct swap_info_struct *a,
 		struct swap_info_struct *b)
 {
@@ -45,6 +56,79 @@ static bool is_same_group(struct swap_info_struct *a,
 	return false;
 }
 
+bool swap_ratio_measure(struct swap_info_struct *si)
+{
+	return sysctl_swap_ratio_enable && sysctl_swap_ratio_dynamic &&
+		is_swap_ratio_group(si->prio);
+}
+
+/*
+ * Fold the latency of a write started at @start_ns into the average of
+ * @si. Called from the completion of asynchronous writes as well, so
+ * stick to unsigned long arithmetic, which wraps correctly.
+ */
+void swap_ratio_account_write(struct swap_info_struct *si,
+			      unsigned long start_ns)
+{
+	unsigned long lat = (unsigned long)ktime_get_ns() - start_ns;
+	unsigned long avg = READ_ONCE(si->write_lat_ns);
+
+	WRITE_ONCE(si->write_lat_ns, avg ? avg - (avg >> 3) + (lat >> 3) : lat);
+}
+
+/**
+ * swap_ratio_report_compression - report the compression of a swap device
+ * @disk: disk of the swap device
+ * @pct: compressed size of the data stored, in percent of the original
+ *
+ * Called by compressing block devices such as zram. A swap device whose
+ * pages take more memory is given a smaller share of the writes when
+ * swap_ratio_dynamic is set.
+ */
+void swap_ratio_report_compression(struct gendisk *disk, unsigned int pct)
+{
+	struct swap_info_struct *si;
+	unsigned int type;
+
+	spin_lock(&swap_lock);
+	for (type = 0; type < MAX_SWAPFILES; type++) {
+		si = swap_info[type];
+		if (!si || !(si->flags & SWP_USED) || !si->bdev)
+			continue;
+		if (si->bdev->bd_disk == disk)
+			WRITE_ONCE(si->compr_pct, min(pct, 100U));
+	}
+	spin_unlock(&swap_lock);
+}
+EXPORT_SYMBOL_GPL(swap_ratio_report_compression);
+
+/*
+ * Scale the configured split by what a page costs on each device. A zram
+ * page costs its compressed size in memory: at 50% the configured split
+ * is kept, better compression raises the fast share by up to a half and
+ * worse lowers it. The fast share also shrinks when the fast device is
+ * slower to write than the slow one, as zram gets when compression runs
+ * on contended little cores.
+ */
+static int swap_ratio_adapt(struct swap_info_struct *fast,
+			    struct swap_info_struct *slow)
+{
+	unsigned int compr_pct = READ_ONCE(fast->compr_pct);
+	unsigned long fast_ns = READ_ONCE(fast->write_lat_ns);
+	unsigned long slow_ns = READ_ONCE(slow->write_lat_ns);
+	int ratio = sysctl_swap_ratio;
+	int compr_factor = 100, lat_factor = 100;
+
+	if (compr_pct)
+		compr_factor = clamp_t(int, 200 - 2 * (int)compr_pct, 0, 150);
+	if (fast_ns && slow_ns)
+		lat_factor = min_t(u64, 100, div64_u64(200ULL * slow_ns,
+						       fast_ns + slow_ns));
+
+	ratio = ratio * compr_factor / 100 * lat_factor / 100;
+	return clamp(ratio, SWAP_RATIO_DYNAMIC_MIN, 100);
+}
+
 /* Caller must hold swap_avail_lock */
 static int calculate_write_pending(struct swap_info_struct *si,
 			struct swap_info_struct *n)
@@ -60,6 +144,10 @@ static int calculate_write_pending(struct swap_info_struct *si,
 	if ((n->flags & SWP_FAST) || !is_same_group(si, n))
 		return -ENODEV;
 
+	if (sysctl_swap_ratio_dynamic && ratio)
+		ratio = swap_ratio_adapt(si, n);
+	sysctl_swap_ratio_effective = ratio;
+
 	si->max_writes = ratio ? SWAP_FAST_WRITES : 0;
 	n->max_writes  = ratio ? (SWAP_FAST_WRITES * 100) /
 			ratio - SWAP_FAST_WRITES : SWAP_SLOW_WRITES;
@@ -61,6 +61,32 @@ unsigned long total_swapcache_pages(void)
 
 static atomic_t swapin_readahead_hits = ATOMIC_INIT(4);
 
+/*
+ * vma->swap_readahead_info packs the page aligned address of the last
+ * swap fault in the VMA with the readahead window used for it and the
+ * readahead hits counted since, in the bits below PAGE_SHIFT.
+ */
+#define SWAP_RA_WIN_SHIFT	(PAGE_SHIFT / 2)
+#define SWAP_RA_HITS_MASK	((1UL << SWAP_RA_WIN_SHIFT) - 1)
+#define SWAP_RA_HITS_MAX	SWAP_RA_HITS_MASK
+#define SWAP_RA_WIN_MASK	(~PAGE_MASK & ~SWAP_RA_HITS_MASK)
+
+#define SWAP_RA_HITS(v)		((v) & SWAP_RA_HITS_MASK)
+#define SWAP_RA_WIN(v)		(((v) & SWAP_RA_WIN_MASK) >> SWAP_RA_WIN_SHIFT)
+#define SWAP_RA_ADDR(v)		((v) & PAGE_MASK)
+
+#define SWAP_RA_VAL(addr, win, hits)				\
+	(((addr) & PAGE_MASK) |					\
+	 (((win) << SWAP_RA_WIN_SHIFT) & SWAP_RA_WIN_MASK) |	\
+	 ((hits) & SWAP_RA_HITS_MASK))
+
+/*
+ * Largest readahead window on fast swap. Reading ahead from zram costs a
+ * decompression per page rather than I/O, so a miss is never free and the
+ * window is kept well below what page_cluster allows for disks.
+ */
+#define SWAP_RA_FAST_MAX_PAGES	8
+
 void show_swap_cache_info(void)
 {
 	printk("%lu pages in swap cache\n", total_swapcache_pages());
@@ -274,16 +300,32 @@ void free_pages_and_swap_cache(struct page **pages, int nr)
  * lock getting page table operations atomic even if we drop the page
  * lock before returning.
  */
-struct page * lookup_swap_cache(swp_entry_t entry)
+struct page *lookup_swap_cache(swp_entry_t entry, struct vm_area_struct *vma,
+				unsigned long addr)
 {
 	struct page *page;
+	unsigned long ra_val;
+	unsigned int win, hits;
+	bool readahead;
 
 	page = find_get_page(swap_address_space(entry), entry.val);
 
 	if (page) {
 		INC_CACHE_INFO(find_success);
-		if (TestClearPageReadahead(page))
+		readahead = TestClearPageReadahead(page);
+		if (vma && is_swap_fast(entry)) {
+			/* credit the VMA swap_vma_readahead() read it for */
+			ra_val = atomic_long_read(&vma->swap_readahead_info);
+			win = SWAP_RA_WIN(ra_val);
+			hits = SWAP_RA_HITS(ra_val);
+			if (readahead)
+				hits = min_t(unsigned long, hits + 1,
+					     SWAP_RA_HITS_MAX);
+			atomic_long_set(&vma->swap_readahead_info,
+					SWAP_RA_VAL(addr, win, hits));
+		} else if (readahead) {
 			atomic_inc(&swapin_readahead_hits);
+		}
 	}
 
 	INC_CACHE_INFO(find_total);
@@ -401,22 +443,20 @@ struct page *read_swap_cache_async(swp_entry_t entry, gfp_t gfp_mask,
 	return retpage;
 }
 
-static unsigned long swapin_nr_pages(unsigned long offset)
+static unsigned int __swapin_nr_pages(unsigned long prev_offset,
+				      unsigned long offset,
+				      unsigned int hits,
+				      unsigned int max_pages,
+				      unsigned int prev_win)
 {
-	static unsigned long prev_offset;
-	unsigned int pages, max_pages, last_ra;
-	static atomic_t last_readahead_pages;
-
-	max_pages = 1 << READ_ONCE(page_cluster);
-	if (max_pages <= 1)
-		return 1;
+	unsigned int pages, last_ra;
 
 	/*
 	 * This heuristic has been found to work well on both sequential and
 	 * random loads, swapping to hard disk or to SSD: please don't ask
 	 * what the "+ 2" means, it just happens to work well, that's all.
 	 */
-	pages = atomic_xchg(&swapin_readahead_hits, 0) + 2;
+	pages = hits + 2;
 	if (pages == 2) {
 		/*
 		 * We can have no readahead hits to judge by: but must not get
@@ -425,7 +465,6 @@ static unsigned long swapin_nr_pages(unsigned long offset)
 		 */
 		if (offset != prev_offset + 1 && offset != prev_offset - 1)
 			pages = 1;
-		prev_offset = offset;
 	} else {
 		unsigned int roundup = 4;
 		while (roundup < pages)
@@ -437,9 +476,28 @@ static unsigned long swapin_nr_pages(unsigned long offset)
 		pages = max_pages;
 
 	/* Don't shrink readahead too fast */
-	last_ra = atomic_read(&last_readahead_pages) / 2;
+	last_ra = prev_win / 2;
 	if (pages < last_ra)
 		pages = last_ra;
+
+	return pages;
+}
+
+static unsigned long swapin_nr_pages(unsigned long offset)
+{
+	static unsigned long prev_offset;
+	unsigned int hits, pages, max_pages;
+	static atomic_t last_readahead_pages;
+
+	max_pages = 1 << READ_ONCE(page_cluster);
+	if (max_pages <= 1)
+		return 1;
+
+	hits = atomic_xchg(&swapin_readahead_hits, 0);
+	pages = __swapin_nr_pages(prev_offset, offset, hits, max_pages,
+				  atomic_read(&last_readahead_pages));
+	if (!hits)
+		prev_offset = offset;
 	atomic_set(&last_readahead_pages, pages);
 
 	return pages;
@@ -505,3 +563,124 @@ struct page *swapin_readahead(swp_entry_t entry, gfp_t gfp_mask,
 skip:
 	return read_swap_cache_async(entry, gfp_mask, vma, addr);
 }
+
+static inline void swap_ra_clamp_pfn(struct vm_area_struct *vma,
+				     unsigned long faddr,
+				     unsigned long lpfn,
+				     unsigned long rpfn,
+				     unsigned long *start,
+				     unsigned long *end)
+{
+	*start = max3(lpfn, PFN_DOWN(vma->vm_start),
+		      PFN_DOWN(faddr & PMD_MASK));
+	*end = min3(rpfn, PFN_DOWN(vma->vm_end),
+		    PFN_DOWN((faddr & PMD_MASK) + PMD_SIZE));
+}
+
+/**
+ * swap_vma_readahead - swap in pages around a faulting address
+ * @fentry: swap entry of the faulting page
+ * @gfp_mask: memory allocation flags
+ * @vma: user vma the faulting address belongs to
+ * @faddr: faulting address
+ *
+ * Returns the struct page for @fentry, after queueing swapin.
+ *
+ * On fast swap the slots around @fentry hold whatever reclaim happened to
+ * write next to it, so the readahead of swapin_readahead() mostly
+ * decompresses pages nobody asked for. Instead, read the swap entries of
+ * the PTEs adjacent to @faddr, within the VMA and the page table. The
+ * window follows the fault direction and grows only with hits on the
+ * pages previously read ahead for this VMA.
+ *
+ * Other swap devices keep using swapin_readahead().
+ *
+ * Caller must hold down_read on the vma->vm_mm.
+ */
+struct page *swap_vma_readahead(swp_entry_t fentry, gfp_t gfp_mask,
+				struct vm_area_struct *vma, unsigned long faddr)
+{
+	pte_t ptes[SWAP_RA_FAST_MAX_PAGES];
+	unsigned long ra_val, pfn, fpfn, start, end, addr;
+	unsigned int max_win, win, hits, prev_win, left, i, nr;
+	struct blk_plug plug;
+	swp_entry_t entry;
+	struct page *page;
+	pgd_t *pgd;
+	pud_t *pud;
+	pmd_t *pmd;
+	pte_t *pte;
+
+	if (!is_swap_fast(fentry))
+		return swapin_readahead(fentry, gfp_mask, vma, faddr);
+
+	max_win = min_t(unsigned int, 1 << READ_ONCE(page_cluster),
+			SWAP_RA_FAST_MAX_PAGES);
+	if (max_win <= 1 || (current->flags & PF_EXITING))
+		goto skip;
+
+	faddr &= PAGE_MASK;
+	fpfn = PFN_DOWN(faddr);
+	ra_val = atomic_long_read(&vma->swap_readahead_info);
+	pfn = PFN_DOWN(SWAP_RA_ADDR(ra_val));
+	prev_win = SWAP_RA_WIN(ra_val);
+	hits = SWAP_RA_HITS(ra_val);
+	win = __swapin_nr_pages(pfn, fpfn, hits, max_win, prev_win);
+	atomic_long_set(&vma->swap_readahead_info,
+			SWAP_RA_VAL(faddr, win, 0));
+	if (win == 1)
+		goto skip;
+
+	if (fpfn == pfn + 1)
+		swap_ra_clamp_pfn(vma, faddr, fpfn, fpfn + win, &start, &end);
+	else if (pfn == fpfn + 1)
+		swap_ra_clamp_pfn(vma, faddr, fpfn - win + 1, fpfn + 1,
+				  &start, &end);
+	else {
+		left = (win - 1) / 2;
+		swap_ra_clamp_pfn(vma, faddr, fpfn - left, fpfn + win - left,
+				  &start, &end);
+	}
+	if (start >= end)
+		goto skip;
+	nr = end - start;
+
+	pgd = pgd_offset(vma->vm_mm, faddr);
+	if (pgd_none_or_clear_bad(pgd))
+		goto skip;
+	pud = pud_offset(pgd, faddr);
+	if (pud_none_or_clear_bad(pud))
+		goto skip;
+	pmd = pmd_offset(pud, faddr);
+	if (pmd_none(*pmd) || pmd_trans_huge(*pmd) || pmd_bad(*pmd))
+		goto skip;
+
+	/*
+	 * Copy the PTEs, reading the entries in can sleep. A stale entry is
+	 * harmless: read_swap_cache_async() fails on a freed slot.
+	 */
+	pte = pte_offset_map(pmd, start << PAGE_SHIFT);
+	for (i = 0; i < nr; i++)
+		ptes[i] = pte[i];
+	pte_unmap(pte);
+
+	blk_start_plug(&plug);
+	for (i = 0, addr = start << PAGE_SHIFT; i < nr;
+	     i++, addr += PAGE_SIZE) {
+		if (addr == faddr || !is_swap_pte(ptes[i]))
+			continue;
+		entry = pte_to_swp_entry(ptes[i]);
+		if (unlikely(non_swap_entry(entry)))
+			continue;
+		page = read_swap_cache_async(entry, gfp_mask, vma, addr);
+		if (!page)
+			continue;
+		SetPageReadahead(page);
+		page_cache_release(page);
+	}
+	blk_finish_plug(&plug);
+
+	lru_add_drain();	/* Push any new pages onto the LRU now */
+skip:
+	return read_swap_cache_async(fentry, gfp_mask, vma, faddr);
+}
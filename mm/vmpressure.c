@@ -64,6 +64,30 @@ module_param_named(allocstall_threshold, allocstall_threshold,
 static struct vmpressure global_vmpressure;
 BLOCKING_NOTIFIER_HEAD(vmpressure_notifier);
 
+#ifdef CONFIG_ANDROID_SIMPLE_LMK
+/*
+ * Running totals of the pages scanned in completed vmpressure windows,
+ * and of the share of them scanned by direct reclaim, i.e. by stalled
+ * allocations. Only Simple LMK reads them.
+ */
+static atomic_long_t stall_total = ATOMIC_LONG_INIT(0);
+static atomic_long_t scanned_total = ATOMIC_LONG_INIT(0);
+
+/**
+ * vmpressure_stall_read() - Read the reclaim stall counters
+ * @stall:	pages scanned by direct reclaim
+ * @scanned:	pages scanned by all reclaimers
+ *
+ * Callers compare two samples to get the stall share over their own
+ * window.
+ */
+void vmpressure_stall_read(unsigned long *stall, unsigned long *scanned)
+{
+	*scanned = atomic_long_read(&scanned_total);
+	*stall = atomic_long_read(&stall_total);
+}
+#endif
+
 int vmpressure_notifier_register(struct notifier_block *nb)
 {
 	return blocking_notifier_chain_register(&vmpressure_notifier, nb);
@@ -180,6 +204,11 @@ static unsigned long vmpressure_account_stall(unsigned long pressure,
 {
 	unsigned long scale;
 
+#ifdef CONFIG_ANDROID_SIMPLE_LMK
+	atomic_long_add(stall, &stall_total);
+	atomic_long_add(scanned, &scanned_total);
+#endif
+
 	if (pressure < allocstall_threshold)
 		return pressure;
 
@@ -2089,11 +2089,25 @@ static bool inactive_list_is_low(struct lruvec *lruvec, enum lru_list lru)
 		return inactive_anon_is_low(lruvec);
 }
 
+/*
+ * kswapd leaves the active file pages of the working set floor alone
+ * until reclaim gets harder, see mm/workingset.c.
+ */
+static bool kswapd_protects_workingset(struct lruvec *lruvec,
+				       enum lru_list lru,
+				       struct scan_control *sc)
+{
+	return lru == LRU_ACTIVE_FILE && current_is_kswapd() &&
+		sc->priority > DEF_PRIORITY - 3 &&
+		workingset_protected(lruvec);
+}
+
 static unsigned long shrink_list(enum lru_list lru, unsigned long nr_to_scan,
 				 struct lruvec *lruvec, struct scan_control *sc)
 {
 	if (is_active_lru(lru)) {
-		if (inactive_list_is_low(lruvec, lru))
+		if (inactive_list_is_low(lruvec, lru) &&
+		    !kswapd_protects_workingset(lruvec, lru, sc))
 			shrink_active_list(nr_to_scan, lruvec, sc, lru);
 		return 0;
 	}
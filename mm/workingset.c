@@ -12,6 +12,7 @@
 #include <linux/swap.h>
 #include <linux/fs.h>
 #include <linux/mm.h>
+#include <linux/sched.h>
 
 /*
  *		Double CLOCK lists
@@ -150,8 +151,32 @@
  *
  * On cache misses for which there are shadow entries, an eligible
  * refault distance will immediately activate the refaulting page.
+ *
+ *
+ *		Working set protection
+ *
+ * The refaults of the apps the user interacts with tell how much of the
+ * active list they need: a page refaulting at distance R would have
+ * stayed resident, had the active list been R pages larger.  Such apps
+ * are told apart by the oom_score_adj of the faulting task, which
+ * Android keeps at or below the perceptible level for the foreground,
+ * visible and perceptible apps (workingset_protect_adj).
+ *
+ * The largest eligible distance these apps refaulted at recently is
+ * kept per zone as a floor under the active file list, which kswapd
+ * does not deactivate below.  An app starting up then reclaims its own
+ * inactive pages and anon memory rather than evicting the launcher and
+ * keyboard pages the user is about to go back to.  The floor halves
+ * every WS_PROTECT_DECAY without such refaults, is capped at
+ * workingset_protect_ratio percent of the file pages of the zone, and
+ * is ignored by direct reclaim and by kswapd once it struggles.
  */
 
+int sysctl_workingset_protect_adj = 200;
+int sysctl_workingset_protect_ratio = 30;
+
+#define WS_PROTECT_DECAY	(10 * HZ)
+
 static void *pack_shadow(unsigned long eviction, struct zone *zone)
 {
 	eviction = (eviction << NODES_SHIFT) | zone_to_nid(zone);
@@ -219,6 +244,57 @@ void *workingset_eviction(struct address_space *mapping, struct page *page)
 	return pack_shadow(eviction, zone);
 }
 
+static unsigned long ws_protect_floor(struct zone *zone)
+{
+	unsigned long floor = READ_ONCE(zone->ws_protect_floor);
+	unsigned long periods;
+
+	periods = (jiffies - READ_ONCE(zone->ws_protect_stamp)) /
+		WS_PROTECT_DECAY;
+	return periods >= BITS_PER_LONG ? 0 : floor >> periods;
+}
+
+static void workingset_protect(struct zone *zone,
+			       unsigned long refault_distance)
+{
+	unsigned long floor;
+
+	if (!sysctl_workingset_protect_ratio || !current->mm ||
+	    current->signal->oom_score_adj > sysctl_workingset_protect_adj)
+		return;
+
+	inc_zone_state(zone, WORKINGSET_PROTECT);
+	floor = max(ws_protect_floor(zone), refault_distance);
+	WRITE_ONCE(zone->ws_protect_floor, floor);
+	WRITE_ONCE(zone->ws_protect_stamp, jiffies);
+}
+
+/**
+ * workingset_protected - check the active file list against its floor
+ * @lruvec: lruvec whose active file list is about to be aged
+ *
+ * Returns %true if the active file pages of the zone of @lruvec are
+ * within the working set floor and should not be deactivated.
+ */
+bool workingset_protected(struct lruvec *lruvec)
+{
+	struct zone *zone = lruvec_zone(lruvec);
+	unsigned long floor, file;
+
+	if (!sysctl_workingset_protect_ratio)
+		return false;
+
+	floor = ws_protect_floor(zone);
+	if (!floor)
+		return false;
+
+	file = zone_page_state(zone, NR_ACTIVE_FILE) +
+		zone_page_state(zone, NR_INACTIVE_FILE);
+	floor = min(floor, file * sysctl_workingset_protect_ratio / 100);
+
+	return zone_page_state(zone, NR_ACTIVE_FILE) <= floor;
+}
+
 /**
  * workingset_refault - evaluate the refault of a previously evicted page
  * @shadow: shadow entry of the evicted page
@@ -238,6 +314,7 @@ bool workingset_refault(void *shadow)
 
 	if (refault_distance <= zone_page_state(zone, NR_ACTIVE_FILE)) {
 		inc_zone_state(zone, WORKINGSET_ACTIVATE);
+		workingset_protect(zone, refault_distance);
 		return true;
 	}
 	return false;
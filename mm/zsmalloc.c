@@ -51,6 +51,7 @@
 #include <linux/mount.h>
 #include <linux/migrate.h>
 #include <linux/pagemap.h>
+#include <linux/workqueue.h>
 
 #define ZSPAGE_MAGIC	0x58
 
@@ -188,6 +189,31 @@ static int zs_size_classes;
 static const int fullness_threshold_frac = 4;
 static size_t huge_class_size;
 
+/*
+ * Background compaction: every bg_compact_interval_ms, the classes with
+ * at least bg_compact_min_waste percent of their allocated objects unused
+ * are compacted, most wasteful first, until bg_compact_budget pages were
+ * freed or ZS_BG_COMPACT_MAX_CLASSES classes were visited. The work is
+ * deferrable, so an idle CPU is never woken for it.
+ */
+#define ZS_BG_COMPACT_MAX_CLASSES	8
+#define ZS_BG_COMPACT_OFF_RECHECK	(60 * HZ)
+
+static unsigned int bg_compact_interval_ms = 30000;
+module_param(bg_compact_interval_ms, uint, 0644);
+MODULE_PARM_DESC(bg_compact_interval_ms,
+		 "Background compaction period in ms, 0 to disable");
+
+static unsigned int bg_compact_min_waste = 25;
+module_param(bg_compact_min_waste, uint, 0644);
+MODULE_PARM_DESC(bg_compact_min_waste,
+		 "Percentage of unused objects for a class to be compacted");
+
+static unsigned int bg_compact_budget = 2048;
+module_param(bg_compact_budget, uint, 0644);
+MODULE_PARM_DESC(bg_compact_budget,
+		 "Pages freed at most by one background compaction run");
+
 struct size_class {
 	spinlock_t lock;
 	struct list_head fullness_list[NR_ZS_FULLNESS];
@@ -202,6 +228,8 @@ struct size_class {
 
 	unsigned int index;
 	struct zs_size_stat stats;
+	/* pages freed by compacting this class, under lock */
+	unsigned long pages_compacted;
 };
 
 /* huge object: pages_per_zspage == 1 && maxobj_per_zspage == 1 */
@@ -258,6 +286,8 @@ struct zs_pool {
 	 * and unregister_shrinker() will not Oops.
 	 */
 	bool shrinker_enabled;
+	/* Compact the most fragmented classes in the background */
+	struct delayed_work compact_work;
 #ifdef CONFIG_ZSMALLOC_STAT
 	struct dentry *stat_dentry;
 #endif
@@ -619,14 +649,15 @@ static int zs_stats_size_show(struct seq_file *s, void *v)
 	int objs_per_zspage;
 	unsigned long class_almost_full, class_almost_empty;
 	unsigned long obj_allocated, obj_used, pages_used, freeable;
+	unsigned long compacted;
 	unsigned long total_class_almost_full = 0, total_class_almost_empty = 0;
 	unsigned long total_objs = 0, total_used_objs = 0, total_pages = 0;
-	unsigned long total_freeable = 0;
+	unsigned long total_freeable = 0, total_compacted = 0;
 
-	seq_printf(s, " %5s %5s %11s %12s %13s %10s %10s %16s %8s\n",
+	seq_printf(s, " %5s %5s %11s %12s %13s %10s %10s %16s %8s %9s\n",
 			"class", "size", "almost_full", "almost_empty",
 			"obj_allocated", "obj_used", "pages_used",
-			"pages_per_zspage", "freeable");
+			"pages_per_zspage", "freeable", "compacted");
 
 	for (i = 0; i < zs_size_classes; i++) {
 		class = pool->size_class[i];
@@ -640,6 +671,7 @@ static int zs_stats_size_show(struct seq_file *s, void *v)
 		obj_allocated = zs_stat_get(class, OBJ_ALLOCATED);
 		obj_used = zs_stat_get(class, OBJ_USED);
 		freeable = zs_can_compact(class);
+		compacted = class->pages_compacted;
 		spin_unlock(&class->lock);
 
 		objs_per_zspage = class->objs_per_zspage;
@@ -647,10 +679,10 @@ static int zs_stats_size_show(struct seq_file *s, void *v)
 				class->pages_per_zspage;
 
 		seq_printf(s, " %5u %5u %11lu %12lu %13lu"
-				" %10lu %10lu %16d %8lu\n",
+				" %10lu %10lu %16d %8lu %9lu\n",
 			i, class->size, class_almost_full, class_almost_empty,
 			obj_allocated, obj_used, pages_used,
-			class->pages_per_zspage, freeable);
+			class->pages_per_zspage, freeable, compacted);
 
 		total_class_almost_full += class_almost_full;
 		total_class_almost_empty += class_almost_empty;
@@ -658,13 +690,15 @@ static int zs_stats_size_show(struct seq_file *s, void *v)
 		total_used_objs += obj_used;
 		total_pages += pages_used;
 		total_freeable += freeable;
+		total_compacted += compacted;
 	}
 
 	seq_puts(s, "\n");
-	seq_printf(s, " %5s %5s %11lu %12lu %13lu %10lu %10lu %16s %8lu\n",
+	seq_printf(s, " %5s %5s %11lu %12lu %13lu %10lu %10lu %16s %8lu %9lu\n",
 			"Total", "", total_class_almost_full,
 			total_class_almost_empty, total_objs,
-			total_used_objs, total_pages, "", total_freeable);
+			total_used_objs, total_pages, "", total_freeable,
+			total_compacted);
 
 	return 0;
 }
@@ -2322,6 +2356,7 @@ static void __zs_compact(struct zs_pool *pool, struct size_class *class)
 		if (putback_zspage(class, src_zspage) == ZS_EMPTY) {
 			free_zspage(pool, class, src_zspage);
 			pool->stats.pages_compacted += class->pages_per_zspage;
+			class->pages_compacted += class->pages_per_zspage;
 		}
 		spin_unlock(&class->lock);
 		cond_resched();
@@ -2352,6 +2387,70 @@ unsigned long zs_compact(struct zs_pool *pool)
 }
 EXPORT_SYMBOL_GPL(zs_compact);
 
+/*
+ * Share of the allocated objects of @class that are unused, in percent,
+ * or 0 when compacting it cannot free a single zspage. Read without the
+ * class lock, it only ranks classes.
+ */
+static unsigned int zs_class_waste(struct size_class *class)
+{
+	unsigned long obj_allocated = zs_stat_get(class, OBJ_ALLOCATED);
+	unsigned long obj_used = zs_stat_get(class, OBJ_USED);
+
+	if (zs_can_compact(class) < class->pages_per_zspage)
+		return 0;
+
+	return (obj_allocated - obj_used) * 100 / obj_allocated;
+}
+
+static void zs_bg_compact_work(struct work_struct *work)
+{
+	struct zs_pool *pool = container_of(to_delayed_work(work),
+					    struct zs_pool, compact_work);
+	unsigned int picked[ZS_BG_COMPACT_MAX_CLASSES];
+	unsigned int interval = READ_ONCE(bg_compact_interval_ms);
+	unsigned long start = pool->stats.pages_compacted;
+	unsigned int nr_picked, waste, worst_waste, j;
+	struct size_class *class, *worst;
+	int i;
+
+	if (!interval)
+		goto out;
+
+	for (nr_picked = 0; nr_picked < ZS_BG_COMPACT_MAX_CLASSES;
+	     nr_picked++) {
+		worst = NULL;
+		worst_waste = max(READ_ONCE(bg_compact_min_waste), 1U) - 1;
+		for (i = zs_size_classes - 1; i >= 0; i--) {
+			class = pool->size_class[i];
+			if (!class || class->index != i)
+				continue;
+			for (j = 0; j < nr_picked; j++)
+				if (picked[j] == i)
+					break;
+			if (j < nr_picked)
+				continue;
+			waste = zs_class_waste(class);
+			if (waste > worst_waste) {
+				worst = class;
+				worst_waste = waste;
+			}
+		}
+		if (!worst)
+			break;
+
+		picked[nr_picked] = worst->index;
+		__zs_compact(pool, worst);
+		if (pool->stats.pages_compacted - start >=
+		    READ_ONCE(bg_compact_budget))
+			break;
+	}
+out:
+	queue_delayed_work(system_unbound_wq, &pool->compact_work,
+			   interval ? msecs_to_jiffies(interval) :
+			   ZS_BG_COMPACT_OFF_RECHECK);
+}
+
 void zs_pool_stats(struct zs_pool *pool, struct zs_pool_stats *stats)
 {
 	memcpy(stats, &pool->stats, sizeof(struct zs_pool_stats));
@@ -2534,6 +2633,12 @@ struct zs_pool *zs_create_pool(const char *name)
 	 */
 	if (zs_register_shrinker(pool) == 0)
 		pool->shrinker_enabled = true;
+
+	INIT_DEFERRABLE_WORK(&pool->compact_work, zs_bg_compact_work);
+	queue_delayed_work(system_unbound_wq, &pool->compact_work,
+			   bg_compact_interval_ms ?
+			   msecs_to_jiffies(bg_compact_interval_ms) :
+			   ZS_BG_COMPACT_OFF_RECHECK);
 	return pool;
 
 err:
@@ -2546,6 +2651,9 @@ void zs_destroy_pool(struct zs_pool *pool)
 {
 	int i;
 
+	/* never initialised when zs_create_pool() failed */
+	if (pool->compact_work.work.func)
+		cancel_delayed_work_sync(&pool->compact_work);
 	zs_unregister_shrinker(pool);
 	zs_unregister_migration(pool);
 	zs_pool_stat_destroy(pool);
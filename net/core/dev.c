@@ -81,6 +81,7 @@
 #include <linux/hash.h>
 #include <linux/slab.h>
 #include <linux/sched.h>
+#include <linux/kthread.h>
 #include <linux/mutex.h>
 #include <linux/string.h>
 #include <linux/mm.h>
@@ -3292,6 +3293,17 @@ int weight_p __read_mostly = 64;            /* old backlog weight */
 static inline void ____napi_schedule(struct softnet_data *sd,
 				     struct napi_struct *napi)
 {
+	struct task_struct *thread;
+
+	if (test_bit(NAPI_STATE_THREADED, &napi->state)) {
+		thread = READ_ONCE(napi->thread);
+		if (thread) {
+			set_bit(NAPI_STATE_SCHED_THREADED, &napi->state);
+			wake_up_process(thread);
+			return;
+		}
+	}
+
 	list_add_tail(&napi->poll_list, &sd->poll_list);
 	__raise_softirq_irqoff(NET_RX_SOFTIRQ);
 }
@@ -4764,6 +4776,7 @@ void __napi_complete(struct napi_struct *n)
 	list_del_init(&n->poll_list);
 	smp_mb__before_atomic();
 	sd->current_napi = NULL;
+	clear_bit(NAPI_STATE_SCHED_THREADED, &n->state);
 	clear_bit(NAPI_STATE_SCHED, &n->state);
 }
 EXPORT_SYMBOL(__napi_complete);
@@ -4792,6 +4805,7 @@ void napi_complete_done(struct napi_struct *n, int work_done)
 			napi_gro_flush(n, false);
 	}
 	if (likely(list_empty(&n->poll_list))) {
+		clear_bit(NAPI_STATE_SCHED_THREADED, &n->state);
 		WARN_ON_ONCE(!test_and_clear_bit(NAPI_STATE_SCHED, &n->state));
 	} else {
 		/* If n->poll_list is not empty, we need to mask irqs */
@@ -4862,6 +4876,55 @@ static enum hrtimer_restart napi_watchdog(struct hrtimer *timer)
 	return HRTIMER_NORESTART;
 }
 
+static int napi_threaded_poll(void *data);
+
+static atomic_t napi_thread_id = ATOMIC_INIT(0);
+
+int napi_set_threaded(struct napi_struct *n, bool threaded)
+{
+	struct task_struct *thread;
+
+	if (!threaded) {
+		clear_bit(NAPI_STATE_THREADED, &n->state);
+		return 0;
+	}
+
+	if (!n->thread) {
+		thread = kthread_run(napi_threaded_poll, n, "napi/%s-%d",
+				     n->dev->name,
+				     atomic_inc_return(&napi_thread_id));
+		if (IS_ERR(thread)) {
+			pr_err("napi: failed to create thread for %s: %ld\n",
+			       n->dev->name, PTR_ERR(thread));
+			return PTR_ERR(thread);
+		}
+		n->thread = thread;
+	}
+	set_bit(NAPI_STATE_THREADED, &n->state);
+	return 0;
+}
+EXPORT_SYMBOL(napi_set_threaded);
+
+int dev_set_threaded(struct net_device *dev, bool threaded)
+{
+	struct napi_struct *napi;
+	int err = 0;
+
+	list_for_each_entry(napi, &dev->napi_list, dev_list) {
+		err = napi_set_threaded(napi, threaded);
+		if (err) {
+			threaded = false;
+			break;
+		}
+	}
+	if (err)
+		list_for_each_entry(napi, &dev->napi_list, dev_list)
+			napi_set_threaded(napi, false);
+	dev->threaded = threaded;
+	return err;
+}
+EXPORT_SYMBOL(dev_set_threaded);
+
 void netif_napi_add(struct net_device *dev, struct napi_struct *napi,
 		    int (*poll)(struct napi_struct *, int), int weight)
 {
@@ -4883,6 +4946,8 @@ void netif_napi_add(struct net_device *dev, struct napi_struct *napi,
 	napi->poll_owner = -1;
 #endif
 	set_bit(NAPI_STATE_SCHED, &napi->state);
+	if (dev->threaded && napi_set_threaded(napi, true))
+		dev->threaded = false;
 }
 EXPORT_SYMBOL(netif_napi_add);
 
@@ -4904,6 +4969,11 @@ EXPORT_SYMBOL(napi_disable);
 
 void netif_napi_del(struct napi_struct *napi)
 {
+	if (napi->thread) {
+		clear_bit(NAPI_STATE_THREADED, &napi->state);
+		kthread_stop(napi->thread);
+		napi->thread = NULL;
+	}
 	list_del_init(&napi->dev_list);
 	napi_free_frags(napi);
 
@@ -4922,15 +4992,14 @@ struct napi_struct *get_current_napi_context(void)
 }
 EXPORT_SYMBOL(get_current_napi_context);
 
-static int napi_poll(struct napi_struct *n, struct list_head *repoll)
+/*
+ * Polls @n once. Sets *@repoll when the whole weight was used and the
+ * caller still owns @n and must poll it again.
+ */
+static int __napi_poll(struct napi_struct *n, bool *repoll)
 {
-	void *have;
 	int work, weight;
 
-	list_del_init(&n->poll_list);
-
-	have = netpoll_poll_lock(n);
-
 	weight = n->weight;
 
 	/* This NAPI_STATE_SCHED test is for avoiding a race
@@ -4951,7 +5020,7 @@ static int napi_poll(struct napi_struct *n, struct list_head *repoll)
 	WARN_ON_ONCE(work > weight);
 
 	if (likely(work < weight))
-		goto out_unlock;
+		return work;
 
 	/* Drivers must not modify the NAPI state if they
 	 * consume the entire weight.  In such cases this code
@@ -4960,7 +5029,7 @@ static int napi_poll(struct napi_struct *n, struct list_head *repoll)
 	 */
 	if (unlikely(napi_disable_pending(n))) {
 		napi_complete(n);
-		goto out_unlock;
+		return work;
 	}
 
 	if (n->gro_list) {
@@ -4976,17 +5045,77 @@ static int napi_poll(struct napi_struct *n, struct list_head *repoll)
 	if (unlikely(!list_empty(&n->poll_list))) {
 		pr_warn_once("%s: Budget exhausted after napi rescheduled\n",
 			     n->dev ? n->dev->name : "backlog");
-		goto out_unlock;
+		return work;
 	}
 
-	list_add_tail(&n->poll_list, repoll);
+	*repoll = true;
+	return work;
+}
+
+static int napi_poll(struct napi_struct *n, struct list_head *repoll)
+{
+	bool do_repoll = false;
+	void *have;
+	int work;
+
+	list_del_init(&n->poll_list);
+
+	have = netpoll_poll_lock(n);
+
+	work = __napi_poll(n, &do_repoll);
+	if (do_repoll)
+		list_add_tail(&n->poll_list, repoll);
 
-out_unlock:
 	netpoll_poll_unlock(have);
 
 	return work;
 }
 
+/*
+ * Only NAPI_STATE_SCHED_THREADED means this thread owns @napi:
+ * NAPI_STATE_SCHED alone may be held by napi_disable() or netpoll.
+ */
+static int napi_thread_wait(struct napi_struct *napi)
+{
+	set_current_state(TASK_INTERRUPTIBLE);
+
+	while (!kthread_should_stop()) {
+		if (test_bit(NAPI_STATE_SCHED_THREADED, &napi->state)) {
+			__set_current_state(TASK_RUNNING);
+			return 0;
+		}
+		schedule();
+		set_current_state(TASK_INTERRUPTIBLE);
+	}
+	__set_current_state(TASK_RUNNING);
+
+	return -1;
+}
+
+static int napi_threaded_poll(void *data)
+{
+	struct napi_struct *napi = data;
+	void *have;
+
+	while (!napi_thread_wait(napi)) {
+		for (;;) {
+			bool repoll = false;
+
+			local_bh_disable();
+			have = netpoll_poll_lock(napi);
+			__napi_poll(napi, &repoll);
+			netpoll_poll_unlock(have);
+			local_bh_enable();
+
+			if (!repoll)
+				break;
+			cond_resched();
+		}
+	}
+
+	return 0;
+}
+
 static void net_rx_action(struct softirq_action *h)
 {
 	struct softnet_data *sd = this_cpu_ptr(&softnet_data);
@@ -81,6 +81,7 @@ struct kmem_cache *skbuff_head_cache __read_mostly;
 static struct kmem_cache *skbuff_fclone_cache __read_mostly;
 int sysctl_max_skb_frags __read_mostly = MAX_SKB_FRAGS;
 EXPORT_SYMBOL(sysctl_max_skb_frags);
+int sysctl_skb_head_cache_size __read_mostly;
 
 /**
  *	skb_panic - private function for out-of-line support
@@ -355,6 +356,115 @@ EXPORT_SYMBOL(build_skb);
 static DEFINE_PER_CPU(struct page_frag_cache, netdev_alloc_cache);
 static DEFINE_PER_CPU(struct page_frag_cache, napi_alloc_cache);
 
+/*
+ * Per-cpu cache of skb heads for __netdev_alloc_skb(), of one size set
+ * by the skb_head_cache_size sysctl. The heads are kmalloc()ed rather
+ * than page fragments: a fragment head can stay referenced through its
+ * page after the skb is freed (splice, GRO head stealing), a kmalloc()ed
+ * head is always copied instead, so it can be reused as soon as
+ * skb_free_head() is called on it.
+ */
+#define SKB_HEAD_CACHE_MAX	64
+
+struct skb_head_cache {
+	unsigned int size;
+	unsigned int count;
+	void *heads[SKB_HEAD_CACHE_MAX];
+};
+
+static DEFINE_PER_CPU(struct skb_head_cache, skb_head_cache);
+
+/* Called with interrupts disabled */
+static void skb_head_cache_reset(struct skb_head_cache *hc, unsigned int size)
+{
+	while (hc->count)
+		kfree(hc->heads[--hc->count]);
+	hc->size = size;
+}
+
+static void skb_head_cache_flush_cpu(void *unused)
+{
+	skb_head_cache_reset(this_cpu_ptr(&skb_head_cache), 0);
+}
+
+/**
+ * skb_head_cache_flush_all - release the heads cached on all cpus
+ *
+ * Called when sysctl_skb_head_cache_size changes.
+ */
+void skb_head_cache_flush_all(void)
+{
+	on_each_cpu(skb_head_cache_flush_cpu, NULL, 1);
+}
+
+static unsigned int skb_head_cache_size(void)
+{
+	unsigned int size = READ_ONCE(sysctl_skb_head_cache_size);
+
+	return size ? SKB_DATA_ALIGN(size) : 0;
+}
+
+static struct sk_buff *skb_head_cache_alloc(unsigned int size, gfp_t gfp_mask)
+{
+	struct skb_head_cache *hc;
+	unsigned long flags;
+	struct sk_buff *skb;
+	bool pfmemalloc = false;
+	void *data = NULL;
+
+	local_irq_save(flags);
+	hc = this_cpu_ptr(&skb_head_cache);
+	if (unlikely(hc->size != size))
+		skb_head_cache_reset(hc, size);
+	if (hc->count)
+		data = hc->heads[--hc->count];
+	local_irq_restore(flags);
+
+	if (!data) {
+		data = kmalloc_reserve(size, gfp_mask, NUMA_NO_NODE,
+				       &pfmemalloc);
+		if (unlikely(!data))
+			return NULL;
+	}
+
+	skb = __build_skb(data, size);
+	if (unlikely(!skb)) {
+		kfree(data);
+		return NULL;
+	}
+
+	/* Emergency reserves are given back to the slab, never cached */
+	if (pfmemalloc)
+		skb->pfmemalloc = 1;
+
+	return skb;
+}
+
+/* Keep a kmalloc()ed head of the cached size for the next allocation */
+static bool skb_head_cache_put(struct sk_buff *skb)
+{
+	struct skb_head_cache *hc;
+	unsigned long flags;
+	unsigned int size;
+	bool cached = false;
+
+	if (!READ_ONCE(sysctl_skb_head_cache_size) || skb->pfmemalloc)
+		return false;
+
+	size = skb_end_offset(skb) +
+		SKB_DATA_ALIGN(sizeof(struct skb_shared_info));
+
+	local_irq_save(flags);
+	hc = this_cpu_ptr(&skb_head_cache);
+	if (size == hc->size && hc->count < SKB_HEAD_CACHE_MAX) {
+		hc->heads[hc->count++] = skb->head;
+		cached = true;
+	}
+	local_irq_restore(flags);
+
+	return cached;
+}
+
 static void *__netdev_alloc_frag(unsigned int fragsz, gfp_t gfp_mask)
 {
 	struct page_frag_cache *nc;
@@ -417,6 +527,7 @@ struct sk_buff *__netdev_alloc_skb(struct net_device *dev, unsigned int len,
 	struct page_frag_cache *nc;
 	unsigned long flags;
 	struct sk_buff *skb;
+	unsigned int head_size;
 	bool pfmemalloc;
 	void *data;
 
@@ -439,6 +550,14 @@ struct sk_buff *__netdev_alloc_skb(struct net_device *dev, unsigned int len,
 	if (sk_memalloc_socks())
 		gfp_mask |= __GFP_MEMALLOC;
 
+	head_size = skb_head_cache_size();
+	if (len <= head_size) {
+		skb = skb_head_cache_alloc(head_size, gfp_mask);
+		if (!skb)
+			goto skb_fail;
+		goto skb_success;
+	}
+
 	local_irq_save(flags);
 
 	nc = this_cpu_ptr(&netdev_alloc_cache);
@@ -593,7 +712,7 @@ static void skb_free_head(struct sk_buff *skb)
 
 	if (skb->head_frag)
 		skb_free_frag(head);
-	else
+	else if (!skb_head_cache_put(skb))
 		kfree(head);
 }
 
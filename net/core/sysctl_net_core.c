@@ -27,6 +27,7 @@ static int one = 1;
 static int min_sndbuf = SOCK_MIN_SNDBUF;
 static int min_rcvbuf = SOCK_MIN_RCVBUF;
 static int max_skb_frags = MAX_SKB_FRAGS;
+static int max_skb_head_cache_size = PAGE_SIZE;
 
 static int net_msg_warn;	/* Unused, but still a sysctl */
 
@@ -219,6 +220,24 @@ static int set_default_qdisc(struct ctl_table *table, int write,
 }
 #endif
 
+static DEFINE_MUTEX(skb_head_cache_mutex);
+
+static int skb_head_cache_sysctl(struct ctl_table *table, int write,
+				 void __user *buffer, size_t *lenp,
+				 loff_t *ppos)
+{
+	int old, ret;
+
+	mutex_lock(&skb_head_cache_mutex);
+	old = sysctl_skb_head_cache_size;
+	ret = proc_dointvec_minmax(table, write, buffer, lenp, ppos);
+	if (!ret && write && old != sysctl_skb_head_cache_size)
+		skb_head_cache_flush_all();
+	mutex_unlock(&skb_head_cache_mutex);
+
+	return ret;
+}
+
 static int proc_do_rss_key(struct ctl_table *table, int write,
 			   void __user *buffer, size_t *lenp, loff_t *ppos)
 {
@@ -410,6 +429,15 @@ static struct ctl_table net_core_table[] = {
 		.extra1		= &one,
 		.extra2		= &max_skb_frags,
 	},
+	{
+		.procname	= "skb_head_cache_size",
+		.data		= &sysctl_skb_head_cache_size,
+		.maxlen		= sizeof(int),
+		.mode		= 0644,
+		.proc_handler	= skb_head_cache_sysctl,
+		.extra1		= &zero,
+		.extra2		= &max_skb_head_cache_size,
+	},
 	{ }
 };
 
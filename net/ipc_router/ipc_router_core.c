@@ -4250,6 +4250,8 @@ void msm_ipc_router_xprt_notify(struct msm_ipc_router_xprt *xprt,
 	if (ret < 0) {
 		IPC_RTR_ERR("%s: Error %d initializing IPC Router\n",
 			    __func__, ret);
+		if (event == IPC_ROUTER_XPRT_EVENT_DATA_OWNED)
+			release_pkt((struct rr_packet *)data);
 		return;
 	}
 
@@ -4291,7 +4293,10 @@ void msm_ipc_router_xprt_notify(struct msm_ipc_router_xprt *xprt,
 		xprt_info = xprt->priv;
 	}
 
-	pkt = clone_pkt((struct rr_packet *)data);
+	if (event == IPC_ROUTER_XPRT_EVENT_DATA_OWNED)
+		pkt = (struct rr_packet *)data;
+	else
+		pkt = clone_pkt((struct rr_packet *)data);
 	if (!pkt)
 		return;
 
@@ -0,0 +1,279 @@
+/*
+ * TCP BRTT: bandwidth and min-RTT model based congestion control
+ *
+ * Loss based congestion control keeps growing cwnd until the bottleneck
+ * queue overflows. On cellular and Wi-Fi links with deep, variable buffers
+ * that means seconds of queueing delay for every flow sharing the link.
+ *
+ * BRTT instead models the path, in the spirit of BBR:
+ *   o bottleneck bandwidth: the max delivery rate of the last 6 rounds,
+ *   o propagation delay: the min RTT of the last 10 seconds,
+ * and keeps cwnd around their product (the BDP) times cwnd_gain. Each
+ * round in steady state cycles through a short probe above the BDP, a
+ * drain below it and six rounds at it. When the min RTT has not been
+ * refreshed for 10 seconds, cwnd drops to 4 packets for 200 ms so that
+ * the queue empties and the real propagation delay can be measured.
+ *
+ * Notable differences from BBR:
+ *   o This kernel has no delivery rate samples or internal pacing, so the
+ *     bandwidth is the number of packets ACKed per round trip, and only
+ *     cwnd is modulated. sk_pacing_rate still follows cwnd/srtt, so use
+ *     the fq qdisc to pace.
+ *   o Loss is not ignored: ssthresh drops to the larger of the BDP and
+ *     half of cwnd, which PRR then converges to.
+ *
+ * Knobs are configured via /sys/module/tcp_brtt/parameters/.
+ */
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/sched.h>
+#include <net/tcp.h>
+
+#define BRTT_UNIT		256	/* fixed point unit of the gains */
+#define BRTT_BW_ROUNDS		6	/* bandwidth max filter window */
+#define BRTT_CYCLE_LEN		8	/* rounds per steady state cycle */
+#define BRTT_MIN_CWND		4
+#define BRTT_FULL_BW_ROUNDS	3	/* rounds without growth ending startup */
+#define BRTT_PROBE_RTT_MS	200
+
+enum brtt_mode {
+	BRTT_STARTUP,		/* slow start until bandwidth stops growing */
+	BRTT_DRAIN,		/* drain the queue built during startup */
+	BRTT_PROBE_BW,		/* steady state, cycle around the BDP */
+	BRTT_PROBE_RTT,		/* shrink cwnd to measure the min RTT */
+};
+
+/* cwnd gains of a steady state cycle, in BRTT_UNIT */
+static const u16 brtt_cycle_gain[BRTT_CYCLE_LEN] = {
+	BRTT_UNIT * 5 / 4, BRTT_UNIT * 3 / 4,
+	BRTT_UNIT, BRTT_UNIT, BRTT_UNIT, BRTT_UNIT, BRTT_UNIT, BRTT_UNIT,
+};
+
+static unsigned int cwnd_gain __read_mostly = BRTT_UNIT * 3 / 2;
+static unsigned int min_rtt_win_sec __read_mostly = 10;
+
+module_param(cwnd_gain, uint, 0644);
+MODULE_PARM_DESC(cwnd_gain, "cwnd headroom over the BDP (256 = 1.0)");
+module_param(min_rtt_win_sec, uint, 0644);
+MODULE_PARM_DESC(min_rtt_win_sec, "min RTT filter window in seconds");
+
+struct brtt {
+	u32 bw[BRTT_BW_ROUNDS];	/* per round delivery rate, packets/s */
+	u32 min_rtt_us;
+	u32 min_rtt_stamp;	/* jiffies of the min_rtt_us sample */
+	u32 round_start_us;
+	u32 next_round_seq;	/* round ends once snd_una reaches this */
+	u32 round_delivered;	/* packets ACKed in this round */
+	u32 full_bw;		/* bandwidth that startup last grew to */
+	u32 probe_rtt_done;	/* jiffies at which PROBE_RTT may end */
+	u8 bw_idx;
+	u8 mode;
+	u8 cycle_idx;
+	u8 full_bw_cnt;
+};
+
+static u32 brtt_now_us(void)
+{
+	return (u32)div_u64(local_clock(), NSEC_PER_USEC);
+}
+
+static u32 brtt_max_bw(const struct brtt *ca)
+{
+	u32 bw = 0;
+	int i;
+
+	for (i = 0; i < BRTT_BW_ROUNDS; i++)
+		bw = max(bw, ca->bw[i]);
+	return bw;
+}
+
+/* cwnd for @gain times the modelled BDP, 0 while there is no model yet */
+static u32 brtt_target_cwnd(const struct brtt *ca, u32 gain)
+{
+	u64 cwnd;
+
+	if (ca->min_rtt_us == ~0U)
+		return 0;
+
+	cwnd = (u64)brtt_max_bw(ca) * ca->min_rtt_us * gain;
+	cwnd = div_u64(cwnd, USEC_PER_SEC);
+	cwnd = div_u64(cwnd * cwnd_gain, BRTT_UNIT * BRTT_UNIT);
+	if (!cwnd)
+		return 0;
+
+	return max_t(u32, min_t(u64, cwnd, U32_MAX), BRTT_MIN_CWND);
+}
+
+static void brtt_enter_probe_bw(struct brtt *ca)
+{
+	ca->mode = BRTT_PROBE_BW;
+	ca->cycle_idx = 0;
+}
+
+static void brtt_init(struct sock *sk)
+{
+	struct tcp_sock *tp = tcp_sk(sk);
+	struct brtt *ca = inet_csk_ca(sk);
+
+	memset(ca, 0, sizeof(*ca));
+	ca->min_rtt_us = ~0U;
+	ca->min_rtt_stamp = tcp_time_stamp;
+	ca->round_start_us = brtt_now_us();
+	ca->next_round_seq = tp->snd_nxt;
+	ca->mode = BRTT_STARTUP;
+	tp->snd_ssthresh = TCP_INFINITE_SSTHRESH;
+}
+
+/* Called once per round trip, i.e. once the data sent at its start is ACKed */
+static void brtt_round_end(struct sock *sk)
+{
+	struct tcp_sock *tp = tcp_sk(sk);
+	struct brtt *ca = inet_csk_ca(sk);
+	u32 now = brtt_now_us();
+	u32 elapsed = now - ca->round_start_us;
+	u32 bw;
+
+	/* an application limited round says nothing about the path */
+	if (elapsed && ca->round_delivered && tcp_is_cwnd_limited(sk)) {
+		ca->bw_idx = (ca->bw_idx + 1) % BRTT_BW_ROUNDS;
+		ca->bw[ca->bw_idx] = div_u64((u64)ca->round_delivered *
+					     USEC_PER_SEC, elapsed);
+	}
+	ca->round_start_us = now;
+	ca->next_round_seq = tp->snd_nxt;
+	ca->round_delivered = 0;
+
+	switch (ca->mode) {
+	case BRTT_STARTUP:
+		bw = brtt_max_bw(ca);
+		if ((u64)bw * 4 >= (u64)ca->full_bw * 5) {
+			ca->full_bw = bw;
+			ca->full_bw_cnt = 0;
+		} else if (++ca->full_bw_cnt >= BRTT_FULL_BW_ROUNDS) {
+			ca->mode = BRTT_DRAIN;
+			tp->snd_ssthresh = tp->snd_cwnd;
+		}
+		break;
+	case BRTT_DRAIN:
+		if (tcp_packets_in_flight(tp) <=
+		    brtt_target_cwnd(ca, BRTT_UNIT))
+			brtt_enter_probe_bw(ca);
+		break;
+	case BRTT_PROBE_BW:
+		ca->cycle_idx = (ca->cycle_idx + 1) % BRTT_CYCLE_LEN;
+		break;
+	case BRTT_PROBE_RTT:
+		if (after(tcp_time_stamp, ca->probe_rtt_done)) {
+			ca->min_rtt_stamp = tcp_time_stamp;
+			if (ca->full_bw_cnt >= BRTT_FULL_BW_ROUNDS)
+				brtt_enter_probe_bw(ca);
+			else
+				ca->mode = BRTT_STARTUP;
+		}
+		break;
+	}
+}
+
+static void brtt_acked(struct sock *sk, u32 num_acked, s32 rtt_us)
+{
+	struct tcp_sock *tp = tcp_sk(sk);
+	struct brtt *ca = inet_csk_ca(sk);
+	bool expired;
+
+	expired = after(tcp_time_stamp,
+			ca->min_rtt_stamp + min_rtt_win_sec * HZ);
+	if (rtt_us > 0 && ((u32)rtt_us < ca->min_rtt_us || expired)) {
+		ca->min_rtt_us = rtt_us;
+		ca->min_rtt_stamp = tcp_time_stamp;
+	}
+	if (expired && ca->mode != BRTT_PROBE_RTT) {
+		ca->mode = BRTT_PROBE_RTT;
+		ca->probe_rtt_done = tcp_time_stamp +
+				     msecs_to_jiffies(BRTT_PROBE_RTT_MS);
+	}
+
+	ca->round_delivered += num_acked;
+	if (!before(tp->snd_una, ca->next_round_seq))
+		brtt_round_end(sk);
+}
+
+static void brtt_cong_avoid(struct sock *sk, u32 ack, u32 acked)
+{
+	struct tcp_sock *tp = tcp_sk(sk);
+	struct brtt *ca = inet_csk_ca(sk);
+	u32 target;
+
+	if (ca->mode == BRTT_PROBE_RTT) {
+		tp->snd_cwnd = min(tp->snd_cwnd, (u32)BRTT_MIN_CWND);
+		return;
+	}
+
+	if (!tcp_is_cwnd_limited(sk))
+		return;
+
+	switch (ca->mode) {
+	case BRTT_STARTUP:
+		target = 0;
+		break;
+	case BRTT_DRAIN:
+		target = brtt_target_cwnd(ca, BRTT_UNIT);
+		break;
+	default:
+		target = brtt_target_cwnd(ca, brtt_cycle_gain[ca->cycle_idx]);
+		break;
+	}
+
+	/* no model yet or still probing for bandwidth: grow like slow start */
+	if (!target) {
+		acked = tcp_slow_start(tp, acked);
+		if (acked)
+			tcp_cong_avoid_ai(tp, tp->snd_cwnd, acked);
+		return;
+	}
+
+	if (tp->snd_cwnd < target)
+		tp->snd_cwnd = min(tp->snd_cwnd + acked, target);
+	else
+		tp->snd_cwnd = target;
+	tp->snd_cwnd = min(tp->snd_cwnd, tp->snd_cwnd_clamp);
+}
+
+static u32 brtt_ssthresh(struct sock *sk)
+{
+	const struct tcp_sock *tp = tcp_sk(sk);
+	struct brtt *ca = inet_csk_ca(sk);
+
+	/* a loss in startup means the pipe is full */
+	if (ca->mode == BRTT_STARTUP) {
+		ca->mode = BRTT_DRAIN;
+		ca->full_bw_cnt = BRTT_FULL_BW_ROUNDS;
+	}
+
+	return max3(brtt_target_cwnd(ca, BRTT_UNIT), tp->snd_cwnd >> 1, 2U);
+}
+
+static struct tcp_congestion_ops tcp_brtt __read_mostly = {
+	.flags = TCP_CONG_NON_RESTRICTED,
+	.init = brtt_init,
+	.ssthresh = brtt_ssthresh,
+	.cong_avoid = brtt_cong_avoid,
+	.pkts_acked = brtt_acked,
+	.owner = THIS_MODULE,
+	.name = "brtt",
+};
+
+static int __init tcp_brtt_register(void)
+{
+	BUILD_BUG_ON(sizeof(struct brtt) > ICSK_CA_PRIV_SIZE);
+	return tcp_register_congestion_control(&tcp_brtt);
+}
+
+static void __exit tcp_brtt_unregister(void)
+{
+	tcp_unregister_congestion_control(&tcp_brtt);
+}
+
+module_init(tcp_brtt_register);
+module_exit(tcp_brtt_unregister);
+MODULE_LICENSE("GPL");
+MODULE_DESCRIPTION("TCP BRTT");
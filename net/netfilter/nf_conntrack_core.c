@@ -479,6 +479,86 @@ begin:
 	return NULL;
 }
 
+/*
+ * Per-cpu cache of recently found assured conntracks, indexed by the raw
+ * tuple hash, so that packets of established flows skip the hash chain
+ * walk. Entries hold no reference: a hit is validated exactly like a
+ * chain entry, and nf_conntrack_free() clears any entry pointing at the
+ * conntrack being freed, so a cached pointer is never older than the
+ * RCU grace period that keeps SLAB_DESTROY_BY_RCU memory typesafe.
+ */
+#define NF_CT_PCPU_CACHE_SIZE	256
+
+struct nf_ct_pcpu_cache {
+	struct nf_conntrack_tuple_hash *slot[NF_CT_PCPU_CACHE_SIZE];
+};
+
+static DEFINE_PER_CPU(struct nf_ct_pcpu_cache, nf_ct_pcpu_cache);
+
+static bool nf_conntrack_pcpu_cache __read_mostly = true;
+module_param_named(pcpu_cache, nf_conntrack_pcpu_cache, bool, 0644);
+
+static inline unsigned int nf_ct_pcpu_cache_idx(u32 hash)
+{
+	return hash & (NF_CT_PCPU_CACHE_SIZE - 1);
+}
+
+/* Must be called under rcu_read_lock(), returns h with a reference held */
+static struct nf_conntrack_tuple_hash *
+nf_ct_pcpu_cache_find(struct net *net, const struct nf_conntrack_zone *zone,
+		      const struct nf_conntrack_tuple *tuple, u32 hash)
+{
+	struct nf_conntrack_tuple_hash *h;
+	struct nf_conn *ct;
+
+	h = this_cpu_read(nf_ct_pcpu_cache.slot[nf_ct_pcpu_cache_idx(hash)]);
+	if (!h)
+		goto miss;
+
+	ct = nf_ct_tuplehash_to_ctrack(h);
+	if (unlikely(nf_ct_is_dying(ct) ||
+		     !atomic_inc_not_zero(&ct->ct_general.use)))
+		goto miss;
+	if (unlikely(!net_eq(nf_ct_net(ct), net) ||
+		     !nf_ct_key_equal(h, tuple, zone))) {
+		nf_ct_put(ct);
+		goto miss;
+	}
+
+	NF_CT_STAT_INC_ATOMIC(net, cache_hit);
+	return h;
+miss:
+	NF_CT_STAT_INC_ATOMIC(net, cache_miss);
+	return NULL;
+}
+
+static inline void nf_ct_pcpu_cache_add(struct nf_conntrack_tuple_hash *h,
+					u32 hash)
+{
+	if (test_bit(IPS_ASSURED_BIT, &nf_ct_tuplehash_to_ctrack(h)->status))
+		this_cpu_write(nf_ct_pcpu_cache.slot[nf_ct_pcpu_cache_idx(hash)],
+			       h);
+}
+
+static void nf_ct_pcpu_cache_evict(struct nf_conn *ct)
+{
+	struct nf_conntrack_tuple_hash *h;
+	unsigned int idx;
+	int dir, cpu;
+
+	/* only assured conntracks are ever cached */
+	if (!test_bit(IPS_ASSURED_BIT, &ct->status))
+		return;
+
+	for (dir = 0; dir < IP_CT_DIR_MAX; dir++) {
+		h = &ct->tuplehash[dir];
+		idx = nf_ct_pcpu_cache_idx(hash_conntrack_raw(&h->tuple));
+		for_each_possible_cpu(cpu)
+			cmpxchg(&per_cpu_ptr(&nf_ct_pcpu_cache, cpu)->slot[idx],
+				h, NULL);
+	}
+}
+
 /* Find a connection corresponding to a tuple. */
 static struct nf_conntrack_tuple_hash *
 __nf_conntrack_find_get(struct net *net, const struct nf_conntrack_zone *zone,
@@ -488,6 +568,11 @@ __nf_conntrack_find_get(struct net *net, const struct nf_conntrack_zone *zone,
 	struct nf_conn *ct;
 
 	rcu_read_lock();
+	if (nf_conntrack_pcpu_cache) {
+		h = nf_ct_pcpu_cache_find(net, zone, tuple, hash);
+		if (h)
+			goto out;
+	}
 begin:
 	h = ____nf_conntrack_find(net, zone, tuple, hash);
 	if (h) {
@@ -500,8 +585,11 @@ begin:
 				nf_ct_put(ct);
 				goto begin;
 			}
+			if (nf_conntrack_pcpu_cache)
+				nf_ct_pcpu_cache_add(h, hash);
 		}
 	}
+out:
 	rcu_read_unlock();
 
 	return h;
@@ -901,6 +989,7 @@ void nf_conntrack_free(struct nf_conn *ct)
 	 */
 	NF_CT_ASSERT(atomic_read(&ct->ct_general.use) == 0);
 
+	nf_ct_pcpu_cache_evict(ct);
 	nf_ct_ext_destroy(ct);
 	nf_ct_ext_free(ct);
 	kmem_cache_free(net->ct.nf_conntrack_cachep, ct);
@@ -125,14 +125,24 @@ static const char *iface_stat_fmt_procfilename = "iface_stat_fmt";
 static struct proc_dir_entry *iface_stat_fmt_procfile;
 
 
+/*
+ * The packet path does not take any of the locks below. It walks
+ * iface_stat_list and the sock_tag, tag_counter_set and tag_stat trees
+ * within rcu_read_lock_bh(), and bumps per-cpu counters. The locks only
+ * serialize the writers, which also bump the seqcount of a tree around
+ * every change so a lockless miss can be retried, and free entries
+ * with call_rcu_bh(). iface_stat entries are never freed.
+ */
 static LIST_HEAD(iface_stat_list);
 static DEFINE_SPINLOCK(iface_stat_list_lock);
 
 static struct rb_root sock_tag_tree = RB_ROOT;
 static DEFINE_SPINLOCK(sock_tag_list_lock);
+static seqcount_t sock_tag_seq = SEQCNT_ZERO(sock_tag_seq);
 
 static struct rb_root tag_counter_set_tree = RB_ROOT;
 static DEFINE_SPINLOCK(tag_counter_set_list_lock);
+static seqcount_t tag_counter_set_seq = SEQCNT_ZERO(tag_counter_set_seq);
 
 static struct rb_root uid_tag_data_tree = RB_ROOT;
 static DEFINE_SPINLOCK(uid_tag_data_tree_lock);
@@ -197,6 +207,37 @@ static struct tag_node *tag_node_tree_search(struct rb_root *root, tag_t tag)
 	return NULL;
 }
 
+/*
+ * Lockless version of tag_node_tree_search(), for use within
+ * rcu_read_lock_bh(). A concurrent rotation can hide the node being
+ * looked for but never makes the walk loop, so a miss is only trusted
+ * when no writer ran in the meantime.
+ */
+static struct tag_node *tag_node_tree_search_rcu(struct rb_root *root,
+						 seqcount_t *seq, tag_t tag)
+{
+	struct rb_node *node;
+	struct tag_node *data;
+	unsigned int start;
+	int result;
+
+	do {
+		start = read_seqcount_begin(seq);
+		node = rcu_dereference_raw(root->rb_node);
+		while (node) {
+			data = rb_entry(node, struct tag_node, node);
+			result = tag_compare(tag, data->tag);
+			if (result < 0)
+				node = rcu_dereference_raw(node->rb_left);
+			else if (result > 0)
+				node = rcu_dereference_raw(node->rb_right);
+			else
+				return data;
+		}
+	} while (read_seqcount_retry(seq, start));
+	return NULL;
+}
+
 static void tag_node_tree_insert(struct tag_node *data, struct rb_root *root)
 {
 	struct rb_node **new = &(root->rb_node), *parent = NULL;
@@ -220,7 +261,7 @@ static void tag_node_tree_insert(struct tag_node *data, struct rb_root *root)
 	}
 
 	/* Add new node and rebalance tree. */
-	rb_link_node(&data->node, parent, new);
+	rb_link_node_rcu(&data->node, parent, new);
 	rb_insert_color(&data->node, root);
 }
 
@@ -237,6 +278,26 @@ static struct tag_stat *tag_stat_tree_search(struct rb_root *root, tag_t tag)
 	return rb_entry(&node->node, struct tag_stat, tn.node);
 }
 
+static struct tag_stat *tag_stat_tree_search_rcu(struct iface_stat *iface_entry,
+						 tag_t tag)
+{
+	struct tag_node *node;
+
+	node = tag_node_tree_search_rcu(&iface_entry->tag_stat_tree,
+					&iface_entry->tag_stat_seq, tag);
+	if (!node)
+		return NULL;
+	return rb_entry(&node->node, struct tag_stat, tn.node);
+}
+
+static void tag_stat_free_rcu(struct rcu_head *head)
+{
+	struct tag_stat *ts_entry = container_of(head, struct tag_stat, rcu);
+
+	free_percpu(ts_entry->counters);
+	kfree(ts_entry);
+}
+
 static void tag_counter_set_tree_insert(struct tag_counter_set *data,
 					struct rb_root *root)
 {
@@ -253,6 +314,22 @@ static struct tag_counter_set *tag_counter_set_tree_search(struct rb_root *root,
 
 }
 
+static struct tag_counter_set *tag_counter_set_tree_search_rcu(tag_t tag)
+{
+	struct tag_node *node;
+
+	node = tag_node_tree_search_rcu(&tag_counter_set_tree,
+					&tag_counter_set_seq, tag);
+	if (!node)
+		return NULL;
+	return rb_entry(&node->node, struct tag_counter_set, tn.node);
+}
+
+static void tag_counter_set_free_rcu(struct rcu_head *head)
+{
+	kfree(container_of(head, struct tag_counter_set, rcu));
+}
+
 static void tag_ref_tree_insert(struct tag_ref *data, struct rb_root *root)
 {
 	tag_node_tree_insert(&data->tn, root);
@@ -284,6 +361,34 @@ static struct sock_tag *sock_tag_tree_search(struct rb_root *root,
 	return NULL;
 }
 
+/* Lockless sock_tag_tree_search(), see tag_node_tree_search_rcu() */
+static struct sock_tag *sock_tag_tree_search_rcu(const struct sock *sk)
+{
+	struct rb_node *node;
+	struct sock_tag *data;
+	unsigned int start;
+
+	do {
+		start = read_seqcount_begin(&sock_tag_seq);
+		node = rcu_dereference_raw(sock_tag_tree.rb_node);
+		while (node) {
+			data = rb_entry(node, struct sock_tag, sock_node);
+			if (sk < data->sk)
+				node = rcu_dereference_raw(node->rb_left);
+			else if (sk > data->sk)
+				node = rcu_dereference_raw(node->rb_right);
+			else
+				return data;
+		}
+	} while (read_seqcount_retry(&sock_tag_seq, start));
+	return NULL;
+}
+
+static void sock_tag_free_rcu(struct rcu_head *head)
+{
+	kfree(container_of(head, struct sock_tag, rcu));
+}
+
 static void sock_tag_tree_insert(struct sock_tag *data, struct rb_root *root)
 {
 	struct rb_node **new = &(root->rb_node), *parent = NULL;
@@ -302,7 +407,7 @@ static void sock_tag_tree_insert(struct sock_tag *data, struct rb_root *root)
 	}
 
 	/* Add new node and rebalance tree. */
-	rb_link_node(&data->sock_node, parent, new);
+	rb_link_node_rcu(&data->sock_node, parent, new);
 	rb_insert_color(&data->sock_node, root);
 }
 
@@ -322,7 +427,7 @@ static void sock_tag_tree_erase(struct rb_root *st_to_free_tree)
 			 get_uid_from_tag(st_entry->tag));
 		rb_erase(&st_entry->sock_node, st_to_free_tree);
 		sock_put(st_entry->sk);
-		kfree(st_entry);
+		call_rcu_bh(&st_entry->rcu, sock_tag_free_rcu);
 	}
 }
 
@@ -625,17 +730,17 @@ static int get_active_counter_set(tag_t tag)
 		 tag, get_uid_from_tag(tag));
 	/* For now we only handle UID tags for active sets */
 	tag = get_utag_from_tag(tag);
-	spin_lock_bh(&tag_counter_set_list_lock);
-	tcs = tag_counter_set_tree_search(&tag_counter_set_tree, tag);
+	rcu_read_lock_bh();
+	tcs = tag_counter_set_tree_search_rcu(tag);
 	if (tcs)
-		active_set = tcs->active_set;
-	spin_unlock_bh(&tag_counter_set_list_lock);
+		active_set = READ_ONCE(tcs->active_set);
+	rcu_read_unlock_bh();
 	return active_set;
 }
 
 /*
  * Find the entry for tracking the specified interface.
- * Caller must hold iface_stat_list_lock
+ * Caller must hold iface_stat_list_lock or be within rcu_read_lock_bh()
  */
 static struct iface_stat *get_iface_entry(const char *ifname)
 {
@@ -648,7 +753,7 @@ static struct iface_stat *get_iface_entry(const char *ifname)
 	}
 
 	/* Iterate over interfaces */
-	list_for_each_entry(iface_entry, &iface_stat_list, list) {
+	list_for_each_entry_rcu(iface_entry, &iface_stat_list, list) {
 		if (!strcmp(ifname, iface_entry->ifname))
 			goto done;
 	}
@@ -676,9 +781,10 @@ static void pp_iface_stat_header(struct seq_file *m)
 static void pp_iface_stat_line(struct seq_file *m,
 			       struct iface_stat *iface_entry)
 {
-	struct data_counters *cnts;
+	struct data_counters totals, *cnts = &totals;
 	int cnt_set = 0;   /* We only use one set for the device */
-	cnts = &iface_entry->totals_via_skb;
+
+	dc_fold(&totals, iface_entry->totals_via_skb);
 	seq_printf(m, "%s %llu %llu %llu %llu %llu %llu %llu %llu "
 		   "%llu %llu %llu %llu %llu %llu %llu %llu\n",
 		   iface_entry->ifname,
@@ -866,7 +972,17 @@ static struct iface_stat *iface_alloc(struct net_device *net_dev)
 		kfree(new_iface);
 		return NULL;
 	}
+	new_iface->totals_via_skb = alloc_percpu_gfp(struct data_counters,
+						     GFP_ATOMIC);
+	if (!new_iface->totals_via_skb) {
+		pr_err("qtaguid: iface_stat: create(%s): "
+		       "counters alloc failed\n", net_dev->name);
+		kfree(new_iface->ifname);
+		kfree(new_iface);
+		return NULL;
+	}
 	spin_lock_init(&new_iface->tag_stat_list_lock);
+	seqcount_init(&new_iface->tag_stat_seq);
 	new_iface->tag_stat_tree = RB_ROOT;
 	_iface_stat_set_active(new_iface, net_dev, true);
 
@@ -879,6 +995,7 @@ static struct iface_stat *iface_alloc(struct net_device *net_dev)
 		pr_err("qtaguid: iface_stat: create(%s): "
 		       "work alloc failed\n", new_iface->ifname);
 		_iface_stat_set_active(new_iface, net_dev, false);
+		free_percpu(new_iface->totals_via_skb);
 		kfree(new_iface->ifname);
 		kfree(new_iface);
 		return NULL;
@@ -886,7 +1003,7 @@ static struct iface_stat *iface_alloc(struct net_device *net_dev)
 	isw->iface_entry = new_iface;
 	INIT_WORK(&isw->iface_work, iface_create_proc_worker);
 	schedule_work(&isw->iface_work);
-	list_add(&new_iface->list, &iface_stat_list);
+	list_add_rcu(&new_iface->list, &iface_stat_list);
 	return new_iface;
 }
 
@@ -1067,16 +1184,13 @@ static struct sock_tag *get_sock_stat_nl(const struct sock *sk)
 	return sock_tag_tree_search(&sock_tag_tree, sk);
 }
 
+/* Caller must be within rcu_read_lock_bh() */
 static struct sock_tag *get_sock_stat(const struct sock *sk)
 {
-	struct sock_tag *sock_tag_entry;
 	MT_DEBUG("qtaguid: get_sock_stat(sk=%p)\n", sk);
 	if (!sk)
 		return NULL;
-	spin_lock_bh(&sock_tag_list_lock);
-	sock_tag_entry = get_sock_stat_nl(sk);
-	spin_unlock_bh(&sock_tag_list_lock);
-	return sock_tag_entry;
+	return sock_tag_tree_search_rcu(sk);
 }
 
 static int ipx_proto(const struct sk_buff *skb,
@@ -1227,21 +1341,21 @@ static void iface_stat_update_from_skb(const struct sk_buff *skb,
 		 par->hooknum, __func__, el_dev->name, el_dev->type,
 		 par->family, proto, direction);
 
-	spin_lock_bh(&iface_stat_list_lock);
+	rcu_read_lock_bh();
 	entry = get_iface_entry(el_dev->name);
 	if (entry == NULL) {
 		IF_DEBUG("qtaguid[%d]: iface_stat: %s(%s): not tracked\n",
 			 par->hooknum, __func__, el_dev->name);
-		spin_unlock_bh(&iface_stat_list_lock);
+		rcu_read_unlock_bh();
 		return;
 	}
 
 	IF_DEBUG("qtaguid[%d]: %s(%s): entry=%p\n", par->hooknum,  __func__,
 		 el_dev->name, entry);
 
-	data_counters_update(&entry->totals_via_skb, 0, direction, proto,
-			     bytes);
-	spin_unlock_bh(&iface_stat_list_lock);
+	data_counters_update(this_cpu_ptr(entry->totals_via_skb), 0,
+			     direction, proto, bytes);
+	rcu_read_unlock_bh();
 }
 
 static void tag_stat_update(struct tag_stat *tag_entry,
@@ -1253,20 +1367,21 @@ static void tag_stat_update(struct tag_stat *tag_entry,
 		 "dir=%d proto=%d bytes=%d)\n",
 		 tag_entry->tn.tag, get_uid_from_tag(tag_entry->tn.tag),
 		 active_set, direction, proto, bytes);
-	data_counters_update(&tag_entry->counters, active_set, direction,
-			     proto, bytes);
+	data_counters_update(this_cpu_ptr(tag_entry->counters), active_set,
+			     direction, proto, bytes);
 	if (tag_entry->parent_counters)
-		data_counters_update(tag_entry->parent_counters, active_set,
-				     direction, proto, bytes);
+		data_counters_update(this_cpu_ptr(tag_entry->parent_counters),
+				     active_set, direction, proto, bytes);
 }
 
 /*
  * Create a new entry for tracking the specified {acct_tag,uid_tag} within
- * the interface.
+ * the interface, also billing @parent_counters if not NULL.
  * iface_entry->tag_stat_list_lock should be held.
  */
-static struct tag_stat *create_if_tag_stat(struct iface_stat *iface_entry,
-					   tag_t tag)
+static struct tag_stat *
+create_if_tag_stat(struct iface_stat *iface_entry, tag_t tag,
+		   struct data_counters __percpu *parent_counters)
 {
 	struct tag_stat *new_tag_stat_entry = NULL;
 	IF_DEBUG("qtaguid: iface_stat: %s(): ife=%p tag=0x%llx"
@@ -1277,8 +1392,20 @@ static struct tag_stat *create_if_tag_stat(struct iface_stat *iface_entry,
 		pr_err("qtaguid: iface_stat: tag stat alloc failed\n");
 		goto done;
 	}
+	new_tag_stat_entry->counters = alloc_percpu_gfp(struct data_counters,
+							GFP_ATOMIC);
+	if (!new_tag_stat_entry->counters) {
+		pr_err("qtaguid: iface_stat: tag stat counters alloc failed\n");
+		kfree(new_tag_stat_entry);
+		new_tag_stat_entry = NULL;
+		goto done;
+	}
 	new_tag_stat_entry->tn.tag = tag;
+	/* Fully set up before lockless readers can find it */
+	new_tag_stat_entry->parent_counters = parent_counters;
+	write_seqcount_begin(&iface_entry->tag_stat_seq);
 	tag_stat_tree_insert(new_tag_stat_entry, &iface_entry->tag_stat_tree);
+	write_seqcount_end(&iface_entry->tag_stat_seq);
 done:
 	return new_tag_stat_entry;
 }
@@ -1290,7 +1417,7 @@ static void if_tag_stat_update(const char *ifname, uid_t uid,
 	struct tag_stat *tag_stat_entry;
 	tag_t tag, acct_tag;
 	tag_t uid_tag;
-	struct data_counters *uid_tag_counters;
+	struct data_counters __percpu *uid_tag_counters;
 	struct sock_tag *sock_tag_entry;
 	struct iface_stat *iface_entry;
 	struct tag_stat *new_tag_stat = NULL;
@@ -1298,12 +1425,12 @@ static void if_tag_stat_update(const char *ifname, uid_t uid,
 		"uid=%u sk=%p dir=%d proto=%d bytes=%d)\n",
 		 ifname, uid, sk, direction, proto, bytes);
 
-	spin_lock_bh(&iface_stat_list_lock);
+	rcu_read_lock_bh();
 	iface_entry = get_iface_entry(ifname);
 	if (!iface_entry) {
 		pr_err_ratelimited("qtaguid: tag_stat: stat_update() "
 				   "%s not found\n", ifname);
-		spin_unlock_bh(&iface_stat_list_lock);
+		rcu_read_unlock_bh();
 		return;
 	}
 	/* It is ok to process data when an iface_entry is inactive */
@@ -1317,7 +1444,7 @@ static void if_tag_stat_update(const char *ifname, uid_t uid,
 	 */
 	sock_tag_entry = get_sock_stat(sk);
 	if (sock_tag_entry) {
-		tag = sock_tag_entry->tag;
+		tag = READ_ONCE(sock_tag_entry->tag);
 		acct_tag = get_atag_from_tag(tag);
 		uid_tag = get_utag_from_tag(tag);
 	} else {
@@ -1328,16 +1455,26 @@ static void if_tag_stat_update(const char *ifname, uid_t uid,
 	MT_DEBUG("qtaguid: tag_stat: stat_update(): "
 		 " looking for tag=0x%llx (uid=%u) in ife=%p\n",
 		 tag, get_uid_from_tag(tag), iface_entry);
-	/* Loop over tag list under this interface for {acct_tag,uid_tag} */
+
+	/*
+	 * Updating the {acct_tag, uid_tag} entry handles both stats:
+	 * {0, uid_tag} will also get updated.
+	 */
+	tag_stat_entry = tag_stat_tree_search_rcu(iface_entry, tag);
+	if (tag_stat_entry) {
+		tag_stat_update(tag_stat_entry, direction, proto, bytes);
+		goto unlock_rcu;
+	}
+
+	/*
+	 * First packet for this tag on this interface: create the entries,
+	 * looking again under the lock in case another cpu just did.
+	 */
 	spin_lock_bh(&iface_entry->tag_stat_list_lock);
 
 	tag_stat_entry = tag_stat_tree_search(&iface_entry->tag_stat_tree,
 					      tag);
 	if (tag_stat_entry) {
-		/*
-		 * Updating the {acct_tag, uid_tag} entry handles both stats:
-		 * {0, uid_tag} will also get updated.
-		 */
 		tag_stat_update(tag_stat_entry, direction, proto, bytes);
 		goto unlock;
 	}
@@ -1351,20 +1488,20 @@ static void if_tag_stat_update(const char *ifname, uid_t uid,
 		 * No parent counters. So
 		 *  - No {0, uid_tag} stats and no {acc_tag, uid_tag} stats.
 		 */
-		new_tag_stat = create_if_tag_stat(iface_entry, uid_tag);
+		new_tag_stat = create_if_tag_stat(iface_entry, uid_tag, NULL);
 		if (!new_tag_stat)
 			goto unlock;
-		uid_tag_counters = &new_tag_stat->counters;
+		uid_tag_counters = new_tag_stat->counters;
 	} else {
-		uid_tag_counters = &tag_stat_entry->counters;
+		uid_tag_counters = tag_stat_entry->counters;
 	}
 
 	if (acct_tag) {
 		/* Create the child {acct_tag, uid_tag} and hook up parent. */
-		new_tag_stat = create_if_tag_stat(iface_entry, tag);
+		new_tag_stat = create_if_tag_stat(iface_entry, tag,
+						  uid_tag_counters);
 		if (!new_tag_stat)
 			goto unlock;
-		new_tag_stat->parent_counters = uid_tag_counters;
 	} else {
 		/*
 		 * For new_tag_stat to be still NULL here would require:
@@ -1379,7 +1516,8 @@ static void if_tag_stat_update(const char *ifname, uid_t uid,
 	tag_stat_update(new_tag_stat, direction, proto, bytes);
 unlock:
 	spin_unlock_bh(&iface_entry->tag_stat_list_lock);
-	spin_unlock_bh(&iface_stat_list_lock);
+unlock_rcu:
+	rcu_read_unlock_bh();
 }
 
 static int iface_netdev_event_handler(struct notifier_block *nb,
@@ -2027,6 +2165,7 @@ static int ctrl_cmd_delete(const char *input)
 	/* Delete socket tags */
 	spin_lock_bh(&sock_tag_list_lock);
 	spin_lock_bh(&uid_tag_data_tree_lock);
+	write_seqcount_begin(&sock_tag_seq);
 	node = rb_first(&sock_tag_tree);
 	while (node) {
 		st_entry = rb_entry(node, struct sock_tag, sock_node);
@@ -2056,6 +2195,7 @@ static int ctrl_cmd_delete(const char *input)
 				list_del(&st_entry->list);
 		}
 	}
+	write_seqcount_end(&sock_tag_seq);
 	spin_unlock_bh(&uid_tag_data_tree_lock);
 	spin_unlock_bh(&sock_tag_list_lock);
 
@@ -2072,8 +2212,10 @@ static int ctrl_cmd_delete(const char *input)
 			 tcs_entry->tn.tag,
 			 get_uid_from_tag(tcs_entry->tn.tag),
 			 tcs_entry->active_set);
+		write_seqcount_begin(&tag_counter_set_seq);
 		rb_erase(&tcs_entry->tn.node, &tag_counter_set_tree);
-		kfree(tcs_entry);
+		write_seqcount_end(&tag_counter_set_seq);
+		call_rcu_bh(&tcs_entry->rcu, tag_counter_set_free_rcu);
 	}
 	spin_unlock_bh(&tag_counter_set_list_lock);
 
@@ -2084,6 +2226,7 @@ static int ctrl_cmd_delete(const char *input)
 	spin_lock_bh(&iface_stat_list_lock);
 	list_for_each_entry(iface_entry, &iface_stat_list, list) {
 		spin_lock_bh(&iface_entry->tag_stat_list_lock);
+		write_seqcount_begin(&iface_entry->tag_stat_seq);
 		node = rb_first(&iface_entry->tag_stat_tree);
 		while (node) {
 			ts_entry = rb_entry(node, struct tag_stat, tn.node);
@@ -2104,9 +2247,10 @@ static int ctrl_cmd_delete(const char *input)
 					 entry_uid);
 				rb_erase(&ts_entry->tn.node,
 					 &iface_entry->tag_stat_tree);
-				kfree(ts_entry);
+				call_rcu_bh(&ts_entry->rcu, tag_stat_free_rcu);
 			}
 		}
+		write_seqcount_end(&iface_entry->tag_stat_seq);
 		spin_unlock_bh(&iface_entry->tag_stat_list_lock);
 	}
 	spin_unlock_bh(&iface_stat_list_lock);
@@ -2186,12 +2330,15 @@ static int ctrl_cmd_counter_set(const char *input)
 			goto err;
 		}
 		tcs->tn.tag = tag;
+		tcs->active_set = counter_set;
+		write_seqcount_begin(&tag_counter_set_seq);
 		tag_counter_set_tree_insert(tcs, &tag_counter_set_tree);
+		write_seqcount_end(&tag_counter_set_seq);
 		CT_DEBUG("qtaguid: ctrl_counterset(%s): added tcs tag=0x%llx "
 			 "(uid=%u) set=%d\n",
 			 input, tag, get_uid_from_tag(tag), counter_set);
 	}
-	tcs->active_set = counter_set;
+	WRITE_ONCE(tcs->active_set, counter_set);
 	spin_unlock_bh(&tag_counter_set_list_lock);
 	atomic64_inc(&qtu_events.counter_set_changes);
 	res = 0;
@@ -2288,7 +2435,7 @@ static int ctrl_cmd_tag(const char *input)
 		BUG_ON(IS_ERR_OR_NULL(prev_tag_ref_entry));
 		BUG_ON(prev_tag_ref_entry->num_sock_tags <= 0);
 		prev_tag_ref_entry->num_sock_tags--;
-		sock_tag_entry->tag = full_tag;
+		WRITE_ONCE(sock_tag_entry->tag, full_tag);
 	} else {
 		CT_DEBUG("qtaguid: ctrl_tag(%s): newtag for sk=%p\n",
 			 input, el_socket->sk);
@@ -2333,7 +2480,9 @@ static int ctrl_cmd_tag(const char *input)
 			list_add(&sock_tag_entry->list,
 				 &pqd_entry->sock_tag_list);
 
+		write_seqcount_begin(&sock_tag_seq);
 		sock_tag_tree_insert(sock_tag_entry, &sock_tag_tree);
+		write_seqcount_end(&sock_tag_seq);
 		atomic64_inc(&qtu_events.sockets_tagged);
 	}
 	spin_unlock_bh(&uid_tag_data_tree_lock);
@@ -2407,7 +2556,9 @@ int qtaguid_untag(struct socket *el_socket, bool kernel)
 	 * The socket already belongs to the current process
 	 * so it can do whatever it wants to it.
 	 */
+	write_seqcount_begin(&sock_tag_seq);
 	rb_erase(&sock_tag_entry->sock_node, &sock_tag_tree);
+	write_seqcount_end(&sock_tag_seq);
 
 	tag_ref_entry = lookup_tag_ref(sock_tag_entry->tag, &utd_entry);
 	BUG_ON(!tag_ref_entry);
@@ -2448,7 +2599,7 @@ int qtaguid_untag(struct socket *el_socket, bool kernel)
 		 sock_tag_entry,
 		 atomic_read(&el_socket->sk->sk_refcnt));
 
-	kfree(sock_tag_entry);
+	call_rcu_bh(&sock_tag_entry->rcu, sock_tag_free_rcu);
 	atomic64_inc(&qtu_events.sockets_untagged);
 
 	return 0;
@@ -2536,7 +2687,7 @@ static void pp_stats_header(struct seq_file *m)
 static int pp_stats_line(struct seq_file *m, struct tag_stat *ts_entry,
 			 int cnt_set)
 {
-	struct data_counters *cnts;
+	struct data_counters counters, *cnts = &counters;
 	tag_t tag = ts_entry->tn.tag;
 	uid_t stat_uid = get_uid_from_tag(tag);
 	struct proc_print_info *ppi = m->private;
@@ -2552,7 +2703,7 @@ static int pp_stats_line(struct seq_file *m, struct tag_stat *ts_entry,
 		return 0;
 	}
 	ppi->item_index++;
-	cnts = &ts_entry->counters;
+	dc_fold(&counters, ts_entry->counters);
 	seq_printf(m, "%d %s 0x%llx %u %u "
 		"%llu %llu "
 		"%llu %llu "
@@ -2854,10 +3005,12 @@ static int qtudev_release(struct inode *inode, struct file *file)
 		tr->num_sock_tags--;
 		free_tag_ref_from_utd_entry(tr, utd_entry);
 
+		write_seqcount_begin(&sock_tag_seq);
 		rb_erase(&st_entry->sock_node, &sock_tag_tree);
 		list_del(&st_entry->list);
 		/* Can't sockfd_put() within spinlock, do it later. */
 		sock_tag_tree_insert(st_entry, &st_to_free_tree);
+		write_seqcount_end(&sock_tag_seq);
 
 		/*
 		 * Try to free the utd_entry if no other proc_qtu_data is
@@ -11,8 +11,12 @@
 #define __XT_QTAGUID_INTERNAL_H__
 
 #include <linux/types.h>
+#include <linux/percpu.h>
 #include <linux/rbtree.h>
+#include <linux/rcupdate.h>
+#include <linux/seqlock.h>
 #include <linux/spinlock_types.h>
+#include <linux/string.h>
 #include <linux/workqueue.h>
 
 /* Iface handling */
@@ -197,6 +201,27 @@ static inline uint64_t dc_sum_packets(struct data_counters *counters,
 		+ counters->bpc[set][direction][IFS_PROTO_OTHER].packets;
 }
 
+/* Sum up per-cpu counters into @dst, for readers of the stats */
+static inline void dc_fold(struct data_counters *dst,
+			   struct data_counters __percpu *src)
+{
+	struct data_counters *pcpu;
+	int cpu, set, dir, proto;
+
+	memset(dst, 0, sizeof(*dst));
+	for_each_possible_cpu(cpu) {
+		pcpu = per_cpu_ptr(src, cpu);
+		for (set = 0; set < IFS_MAX_COUNTER_SETS; set++)
+			for (dir = 0; dir < IFS_MAX_DIRECTIONS; dir++)
+				for (proto = 0; proto < IFS_MAX_PROTOS; proto++) {
+					dst->bpc[set][dir][proto].bytes +=
+						pcpu->bpc[set][dir][proto].bytes;
+					dst->bpc[set][dir][proto].packets +=
+						pcpu->bpc[set][dir][proto].packets;
+				}
+	}
+}
+
 
 /* Generic X based nodes used as a base for rb_tree ops */
 struct tag_node {
@@ -206,12 +231,14 @@ struct tag_node {
 
 struct tag_stat {
 	struct tag_node tn;
-	struct data_counters counters;
+	/* Per-cpu, so the packet path can update them without a lock */
+	struct data_counters __percpu *counters;
 	/*
 	 * If this tag is acct_tag based, we need to count against the
 	 * matching parent uid_tag.
 	 */
-	struct data_counters *parent_counters;
+	struct data_counters __percpu *parent_counters;
+	struct rcu_head rcu;
 };
 
 struct iface_stat {
@@ -222,7 +249,7 @@ struct iface_stat {
 	struct net_device *net_dev;
 
 	struct byte_packet_counters totals_via_dev[IFS_MAX_DIRECTIONS];
-	struct data_counters totals_via_skb;
+	struct data_counters __percpu *totals_via_skb;
 	/*
 	 * We keep the last_known, because some devices reset their counters
 	 * just before NETDEV_UP, while some will reset just before
@@ -237,8 +264,14 @@ struct iface_stat {
 
 	struct proc_dir_entry *proc_ptr;
 
+	/*
+	 * Changes to the tree are made under tag_stat_list_lock, and
+	 * bump tag_stat_seq so lockless lookups can tell a tree rotation
+	 * hid the entry they were looking for.
+	 */
 	struct rb_root tag_stat_tree;
 	spinlock_t tag_stat_list_lock;
+	seqcount_t tag_stat_seq;
 };
 
 /* This is needed to create proc_dir_entries from atomic context. */
@@ -261,6 +294,7 @@ struct sock_tag {
 	pid_t pid;
 
 	tag_t tag;
+	struct rcu_head rcu;
 };
 
 struct qtaguid_event_counts {
@@ -299,6 +333,7 @@ struct qtaguid_event_counts {
 struct tag_counter_set {
 	struct tag_node tn;
 	int active_set;
+	struct rcu_head rcu;
 };
 
 /*----------------------------------------------*/
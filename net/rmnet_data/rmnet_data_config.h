@@ -86,6 +86,8 @@ struct rmnet_phys_ep_config {
 	uint8_t agg_count;
 	struct timespec agg_time;
 	struct timespec agg_last;
+	/* Moving average of the gap between uplink packets, in ns */
+	long agg_gap;
 };
 
 int rmnet_config_init(void);
@@ -21,6 +21,9 @@
 #include <linux/netdev_features.h>
 #include <linux/ip.h>
 #include <linux/ipv6.h>
+#include <linux/tcp.h>
+#include <linux/cpu.h>
+#include <linux/smp.h>
 #include <net/rmnet_config.h>
 #include "rmnet_data_private.h"
 #include "rmnet_data_config.h"
@@ -66,6 +69,18 @@ unsigned int upper_byte_limit __read_mostly = 10500;
 module_param(upper_byte_limit, uint, S_IRUGO | S_IWUSR);
 MODULE_PARM_DESC(upper_byte_limit, "Upper byte limit");
 
+/*
+ * CPUs the deaggregated packets are spread over by flow hash, 0 to keep
+ * everything on the CPU that received the aggregate.
+ */
+unsigned int rps_cpu_mask __read_mostly;
+module_param(rps_cpu_mask, uint, S_IRUGO | S_IWUSR);
+MODULE_PARM_DESC(rps_cpu_mask, "CPUs deaggregated flows are steered to");
+
+unsigned int rps_max_backlog __read_mostly = 1000;
+module_param(rps_max_backlog, uint, S_IRUGO | S_IWUSR);
+MODULE_PARM_DESC(rps_max_backlog, "Max packets queued to a steering CPU");
+
 #define RMNET_DATA_IP_VERSION_4 0x40
 #define RMNET_DATA_IP_VERSION_6 0x60
 
@@ -238,6 +253,49 @@ static int rmnet_check_skb_can_gro(struct sk_buff *skb)
 	return RMNET_DATA_GRO_RCV_FAIL;
 }
 
+/**
+ * rmnet_map_is_pure_ack() - Check if an uplink packet is a bare TCP ACK
+ * @skb:      packet starting at its IP header
+ *
+ * Such packets pace the peer's transmissions and gain nothing from waiting
+ * in the aggregation buffer.
+ */
+static bool rmnet_map_is_pure_ack(struct sk_buff *skb)
+{
+	struct iphdr *ip4h = (struct iphdr *)skb->data;
+	struct ipv6hdr *ip6h = (struct ipv6hdr *)skb->data;
+	struct tcphdr *th;
+	unsigned int hlen, tot_len;
+
+	if (skb_headlen(skb) < sizeof(struct iphdr))
+		return false;
+
+	switch (skb->data[0] & 0xF0) {
+	case RMNET_DATA_IP_VERSION_4:
+		if (ip4h->protocol != IPPROTO_TCP)
+			return false;
+		hlen = ip4h->ihl * 4;
+		tot_len = ntohs(ip4h->tot_len);
+		break;
+	case RMNET_DATA_IP_VERSION_6:
+		if (skb_headlen(skb) < sizeof(struct ipv6hdr) ||
+		    ip6h->nexthdr != IPPROTO_TCP)
+			return false;
+		hlen = sizeof(struct ipv6hdr);
+		tot_len = hlen + ntohs(ip6h->payload_len);
+		break;
+	default:
+		return false;
+	}
+
+	if (skb_headlen(skb) < hlen + sizeof(struct tcphdr))
+		return false;
+
+	th = (struct tcphdr *)(skb->data + hlen);
+	return th->ack && !th->syn && !th->fin && !th->rst &&
+		tot_len == hlen + th->doff * 4;
+}
+
 /**
  * rmnet_optional_gro_flush() - Check if GRO handler needs to flush now
  *
@@ -314,6 +372,165 @@ static void rmnet_optional_gro_flush(struct napi_struct *napi,
 	}
 }
 
+/* ***************** Flow steering ***************************************** */
+
+/*
+ * Each steering CPU has a backlog and a NAPI context of its own, so GRO
+ * runs on the CPU a flow is steered to. The receiving CPU only hashes and
+ * queues the packets, and kicks every CPU it queued to once per aggregate.
+ */
+struct rmnet_rps_cpu {
+	struct sk_buff_head backlog;
+	struct napi_struct napi;
+	struct call_single_data csd;
+	unsigned long kick;
+} ____cacheline_aligned_in_smp;
+
+static DEFINE_PER_CPU(struct rmnet_rps_cpu, rmnet_rps_cpu);
+/* CPUs the local CPU queued packets to and has not kicked yet */
+static DEFINE_PER_CPU(struct cpumask, rmnet_rps_pending);
+static struct net_device rmnet_rps_dev;
+
+static void rmnet_rps_kick_remote(void *info)
+{
+	struct rmnet_rps_cpu *rc = info;
+
+	clear_bit(0, &rc->kick);
+	napi_schedule(&rc->napi);
+}
+
+static void rmnet_rps_deliver(struct napi_struct *napi, struct sk_buff *skb)
+{
+	gro_result_t gro_res;
+
+	if (rmnet_check_skb_can_gro(skb) &&
+	    (skb->dev->features & NETIF_F_GRO)) {
+		gro_res = napi_gro_receive(napi, skb);
+		trace_rmnet_gro_downlink(gro_res);
+	} else {
+		netif_receive_skb(skb);
+	}
+}
+
+static int rmnet_rps_poll(struct napi_struct *napi, int budget)
+{
+	struct rmnet_rps_cpu *rc = container_of(napi, struct rmnet_rps_cpu,
+						napi);
+	struct sk_buff *skb;
+	int work = 0;
+
+	while (work < budget && (skb = skb_dequeue(&rc->backlog))) {
+		rmnet_rps_deliver(napi, skb);
+		work++;
+	}
+
+	if (work < budget) {
+		napi_complete_done(napi, work);
+		/* Packets queued after the last dequeue found napi scheduled */
+		if (!skb_queue_empty(&rc->backlog))
+			napi_schedule(napi);
+	}
+
+	return work;
+}
+
+/**
+ * rmnet_rps_steer() - Queue a packet to the CPU its flow is steered to
+ * @skb: packet ready to be passed to the network stack
+ *
+ * Return:
+ *      - true if the packet was queued or dropped
+ *      - false if it is to be delivered on the local CPU
+ */
+static bool rmnet_rps_steer(struct sk_buff *skb)
+{
+	struct rmnet_rps_cpu *rc;
+	unsigned long mask = READ_ONCE(rps_cpu_mask);
+	unsigned int cpu, n;
+
+	mask &= cpumask_bits(cpu_online_mask)[0];
+	if (!mask)
+		return false;
+
+	n = reciprocal_scale(skb_get_hash(skb), hweight_long(mask));
+	for_each_set_bit(cpu, &mask, BITS_PER_LONG)
+		if (!n--)
+			break;
+
+	if (cpu == smp_processor_id())
+		return false;
+
+	rc = &per_cpu(rmnet_rps_cpu, cpu);
+	if (skb_queue_len(&rc->backlog) >= rps_max_backlog) {
+		rmnet_kfree_skb(skb, RMNET_STATS_SKBFREE_RPS_BACKLOG);
+		return true;
+	}
+
+	skb_queue_tail(&rc->backlog, skb);
+	cpumask_set_cpu(cpu, this_cpu_ptr(&rmnet_rps_pending));
+	return true;
+}
+
+/**
+ * rmnet_rps_flush() - Kick the CPUs packets were steered to
+ */
+static void rmnet_rps_flush(void)
+{
+	struct cpumask *pending = this_cpu_ptr(&rmnet_rps_pending);
+	struct rmnet_rps_cpu *rc;
+	unsigned int cpu;
+
+	for_each_cpu(cpu, pending) {
+		rc = &per_cpu(rmnet_rps_cpu, cpu);
+		if (!test_and_set_bit(0, &rc->kick) &&
+		    smp_call_function_single_async(cpu, &rc->csd))
+			clear_bit(0, &rc->kick);
+	}
+	cpumask_clear(pending);
+}
+
+static int rmnet_rps_cpu_callback(struct notifier_block *nb,
+				  unsigned long action, void *hcpu)
+{
+	struct rmnet_rps_cpu *rc = &per_cpu(rmnet_rps_cpu, (long)hcpu);
+	struct sk_buff *skb;
+
+	if ((action & ~CPU_TASKS_FROZEN) != CPU_DEAD)
+		return NOTIFY_OK;
+
+	/* Hand whatever was still queued to the dead CPU to the local one */
+	while ((skb = skb_dequeue(&rc->backlog)))
+		netif_rx_ni(skb);
+	clear_bit(0, &rc->kick);
+
+	return NOTIFY_OK;
+}
+
+static struct notifier_block rmnet_rps_cpu_nb = {
+	.notifier_call = rmnet_rps_cpu_callback,
+};
+
+/**
+ * rmnet_rps_init() - Set up the per CPU steering contexts
+ */
+void rmnet_rps_init(void)
+{
+	struct rmnet_rps_cpu *rc;
+	int cpu;
+
+	init_dummy_netdev(&rmnet_rps_dev);
+	for_each_possible_cpu(cpu) {
+		rc = &per_cpu(rmnet_rps_cpu, cpu);
+		skb_queue_head_init(&rc->backlog);
+		rc->csd.func = rmnet_rps_kick_remote;
+		rc->csd.info = rc;
+		netif_napi_add(&rmnet_rps_dev, &rc->napi, rmnet_rps_poll,
+			       NAPI_POLL_WEIGHT);
+		napi_enable(&rc->napi);
+	}
+	register_hotcpu_notifier(&rmnet_rps_cpu_nb);
+}
+
 /**
  * __rmnet_deliver_skb() - Deliver skb
  *
@@ -349,6 +566,8 @@ static rx_handler_result_t __rmnet_deliver_skb(struct sk_buff *skb,
 		case RX_HANDLER_PASS:
 			skb->pkt_type = PACKET_HOST;
 			rmnet_reset_mac_header(skb);
+			if (rmnet_rps_steer(skb))
+				return RX_HANDLER_CONSUMED;
 			if (rmnet_check_skb_can_gro(skb) &&
 			    (skb->dev->features & NETIF_F_GRO)) {
 				napi = get_current_napi_context();
@@ -523,17 +742,26 @@ static rx_handler_result_t rmnet_map_ingress_handler(struct sk_buff *skb,
 	if (config->ingress_data_format & RMNET_INGRESS_FORMAT_DEAGGREGATION) {
 		trace_rmnet_start_deaggregation(skb);
 		while ((skbn = rmnet_map_deaggregate(skb, config)) != 0) {
-			_rmnet_map_ingress_handler(skbn, config);
 			co++;
+			/* The last frame reuses the aggregate buffer */
+			if (skbn == skb)
+				break;
+			_rmnet_map_ingress_handler(skbn, config);
 		}
 		trace_rmnet_end_deaggregation(skb, co);
 		LOGD("De-aggregated %d packets", co);
 		rmnet_stats_deagg_pkts(co);
-		rmnet_kfree_skb(skb, RMNET_STATS_SKBFREE_MAPINGRESS_AGGBUF);
-		rc = RX_HANDLER_CONSUMED;
+		if (skbn) {
+			rc = _rmnet_map_ingress_handler(skbn, config);
+		} else {
+			rmnet_kfree_skb(skb,
+					RMNET_STATS_SKBFREE_MAPINGRESS_AGGBUF);
+			rc = RX_HANDLER_CONSUMED;
+		}
 	} else {
 		rc = _rmnet_map_ingress_handler(skb, config);
 	}
+	rmnet_rps_flush();
 
 	return rc;
 }
@@ -561,6 +789,7 @@ static int rmnet_map_egress_handler(struct sk_buff *skb,
 {
 	int required_headroom, additional_header_length, ckresult;
 	struct rmnet_map_header_s *map_header;
+	bool low_latency = false;
 
 	additional_header_length = 0;
 
@@ -581,6 +810,9 @@ static int rmnet_map_egress_handler(struct sk_buff *skb,
 		return 1;
 	}
 
+	if (config->egress_data_format & RMNET_EGRESS_FORMAT_AGGREGATION)
+		low_latency = rmnet_map_is_pure_ack(skb);
+
 	if ((config->egress_data_format & RMNET_EGRESS_FORMAT_MAP_CKSUMV3) ||
 	    (config->egress_data_format & RMNET_EGRESS_FORMAT_MAP_CKSUMV4)) {
 		ckresult = rmnet_map_checksum_uplink_packet
@@ -614,7 +846,7 @@ static int rmnet_map_egress_handler(struct sk_buff *skb,
 	skb->protocol = htons(ETH_P_MAP);
 
 	if (config->egress_data_format & RMNET_EGRESS_FORMAT_AGGREGATION) {
-		rmnet_map_aggregate(skb, config);
+		rmnet_map_aggregate(skb, config, low_latency);
 		return RMNET_MAP_CONSUMED;
 	}
 
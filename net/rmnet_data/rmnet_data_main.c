@@ -21,6 +21,7 @@
 #include "rmnet_data_private.h"
 #include "rmnet_data_config.h"
 #include "rmnet_data_vnd.h"
+#include "rmnet_data_handlers.h"
 
 /* ***************** Trace Points ******************************************* */
 #define CREATE_TRACE_POINTS
@@ -46,6 +47,7 @@ static int __init rmnet_init(void)
 {
 	rmnet_config_init();
 	rmnet_vnd_init();
+	rmnet_rps_init();
 
 	LOGL("%s", "RMNET Data driver loaded successfully");
 	return 0;
@@ -40,6 +40,7 @@ enum rmnet_skb_free_e {
 	RMNET_STATS_SKBFREE_INGRESS_BAD_MAP_CKSUM,
 	RMNET_STATS_SKBFREE_MAPC_UNSUPPORTED,
 	RMNET_STATS_SKBFREE_MAPINGRESS_MUX_NO_EP,
+	RMNET_STATS_SKBFREE_RPS_BACKLOG,
 	RMNET_STATS_SKBFREE_MAX
 };
 
@@ -50,6 +51,7 @@ enum rmnet_queue_xmit_e {
 	RMNET_STATS_QUEUE_XMIT_AGG_TIMEOUT,
 	RMNET_STATS_QUEUE_XMIT_AGG_CPY_EXP_FAIL,
 	RMNET_STATS_QUEUE_XMIT_AGG_SKIP,
+	RMNET_STATS_QUEUE_XMIT_AGG_LOW_LATENCY,
 	RMNET_STATS_QUEUE_XMIT_MAX
 };
 
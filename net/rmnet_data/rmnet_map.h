@@ -141,7 +141,8 @@ struct rmnet_map_header_s *rmnet_map_add_map_header(struct sk_buff *skb,
 rx_handler_result_t rmnet_map_command(struct sk_buff *skb,
 				      struct rmnet_phys_ep_config *config);
 void rmnet_map_aggregate(struct sk_buff *skb,
-			 struct rmnet_phys_ep_config *config);
+			 struct rmnet_phys_ep_config *config,
+			 bool low_latency);
 
 int rmnet_map_checksum_downlink_packet(struct sk_buff *skb);
 int rmnet_map_checksum_uplink_packet(struct sk_buff *skb,
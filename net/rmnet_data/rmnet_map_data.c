@@ -50,6 +50,10 @@ long agg_bypass_time __read_mostly = 10000000L;
 module_param(agg_bypass_time, long, S_IRUGO | S_IWUSR);
 MODULE_PARM_DESC(agg_bypass_time, "Skip agg when apart spaced more than this");
 
+unsigned int agg_adaptive __read_mostly = 1;
+module_param(agg_adaptive, uint, S_IRUGO | S_IWUSR);
+MODULE_PARM_DESC(agg_adaptive, "Skip agg when the packet rate is too low");
+
 
 struct agg_work {
 	struct delayed_work work;
@@ -122,13 +126,16 @@ done:
  * @skb:        Source socket buffer containing multiple MAP frames
  * @config:     Physical endpoint configuration of the ingress device
  *
- * A whole new buffer is allocated for each portion of an aggregated frame.
- * Caller should keep calling deaggregate() on the source skb until 0 is
- * returned, indicating that there are no more packets to deaggregate. Caller
- * is responsible for freeing the original skb.
+ * A whole new buffer is allocated for each portion of an aggregated frame,
+ * except for the last one which takes over the source skb without a copy.
+ * Caller should keep calling deaggregate() on the source skb until 0 or the
+ * source skb itself is returned, indicating that there are no more packets
+ * to deaggregate. Caller is responsible for freeing the original skb in
+ * the former case.
  *
  * Return:
  *     - Pointer to new skb
+ *     - @skb if it holds the last MAP frame
  *     - 0 (null) if no more aggregated packets
  */
 struct sk_buff *rmnet_map_deaggregate(struct sk_buff *skb,
@@ -153,6 +160,22 @@ struct sk_buff *rmnet_map_deaggregate(struct sk_buff *skb,
 		return 0;
 	}
 
+	/* Some hardware can send us empty frames. Catch them */
+	if (ntohs(maph->pkt_len) == 0) {
+		LOGD("Dropping empty MAP frame");
+		skb_pull(skb, packet_len);
+		rmnet_kfree_skb(0, RMNET_STATS_SKBFREE_DEAGG_DATA_LEN_0);
+		return 0;
+	}
+
+	/*
+	 * IPA already splits its aggregates and passes one MAP frame per skb,
+	 * so most of the time there is nothing to copy.
+	 */
+	if (packet_len == skb->len &&
+	    skb_headroom(skb) >= RMNET_MAP_DEAGGR_HEADROOM)
+		return skb;
+
 	skbn = alloc_skb(packet_len + RMNET_MAP_DEAGGR_SPACING, GFP_ATOMIC);
 	if (!skbn)
 		return 0;
@@ -163,14 +186,6 @@ struct sk_buff *rmnet_map_deaggregate(struct sk_buff *skb,
 	memcpy(skbn->data, skb->data, packet_len);
 	skb_pull(skb, packet_len);
 
-
-	/* Some hardware can send us empty frames. Catch them */
-	if (ntohs(maph->pkt_len) == 0) {
-		LOGD("Dropping empty MAP frame");
-		rmnet_kfree_skb(skbn, RMNET_STATS_SKBFREE_DEAGG_DATA_LEN_0);
-		return 0;
-	}
-
 	return skbn;
 }
 
@@ -229,18 +244,27 @@ static void rmnet_map_flush_packet_queue(struct work_struct *work)
  * @skb:        current packet being transmitted
  * @config:     Physical endpoint configuration of the ingress device
  *
+ * @low_latency: packet should not wait for more, e.g. a pure TCP ACK
+ *
  * Aggregates multiple SKBs into a single large SKB for transmission. MAP
  * protocol is used to separate the packets in the buffer. This funcion consumes
  * the argument SKB and should not be further processed by any other function.
+ *
+ * With agg_adaptive set, a new aggregate is only started when the average
+ * gap between packets lets at least two of them in within agg_time_limit,
+ * so interactive traffic is not held back for nothing. A low latency packet
+ * is sent right away, together with the aggregate pending if any.
  */
 void rmnet_map_aggregate(struct sk_buff *skb,
-			 struct rmnet_phys_ep_config *config) {
+			 struct rmnet_phys_ep_config *config,
+			 bool low_latency) {
 	uint8_t *dest_buff;
 	struct agg_work *work;
 	unsigned long flags;
 	struct sk_buff *agg_skb;
 	struct timespec diff, last;
 	int size, rc, agg_count = 0;
+	long gap;
 
 
 	if (!skb || !config)
@@ -258,13 +282,18 @@ new_packet:
 	memcpy(&last, &(config->agg_last), sizeof(struct timespec));
 	getnstimeofday(&(config->agg_last));
 
+	diff = timespec_sub(config->agg_last, last);
+	gap = (diff.tv_sec > 0) ? agg_bypass_time :
+		min(diff.tv_nsec, agg_bypass_time);
+	config->agg_gap += (gap - config->agg_gap) / 8;
+
 	if (!config->agg_skb) {
 		/* Check to see if we should agg first. If the traffic is very
 		 * sparse, don't aggregate. We will need to tune this later
 		 */
-		diff = timespec_sub(config->agg_last, last);
-
-		if ((diff.tv_sec > 0) || (diff.tv_nsec > agg_bypass_time)) {
+		if ((diff.tv_sec > 0) || (diff.tv_nsec > agg_bypass_time) ||
+		    low_latency ||
+		    (agg_adaptive && config->agg_gap > agg_time_limit / 2)) {
 			spin_unlock_irqrestore(&config->agg_lock, flags);
 			LOGL("delta t: %ld.%09lu\tcount: bypass", diff.tv_sec,
 			     diff.tv_nsec);
@@ -321,6 +350,21 @@ new_packet:
 	config->agg_count++;
 	rmnet_kfree_skb(skb, RMNET_STATS_SKBFREE_AGG_INTO_BUFF);
 
+	if (low_latency) {
+		rmnet_stats_agg_pkts(config->agg_count);
+		agg_skb = config->agg_skb;
+		agg_count = config->agg_count;
+		config->agg_skb = 0;
+		config->agg_count = 0;
+		memset(&(config->agg_time), 0, sizeof(struct timespec));
+		spin_unlock_irqrestore(&config->agg_lock, flags);
+		trace_rmnet_map_flush_packet_queue(agg_skb, agg_count);
+		rc = dev_queue_xmit(agg_skb);
+		rmnet_stats_queue_xmit(rc,
+				       RMNET_STATS_QUEUE_XMIT_AGG_LOW_LATENCY);
+		return;
+	}
+
 schedule:
 	if (config->agg_state != RMNET_MAP_TXFER_SCHEDULED) {
 		work = kmalloc(sizeof(*work), GFP_ATOMIC);
@@ -84,6 +84,16 @@ const DECLARE_TLV_DB_LINEAR(msm_compr_vol_gain, 0,
 #define STREAM_ARRAY_INDEX(stream_id) (stream_id - 1)
 
 #define MAX_NUMBER_OF_STREAMS 2
+
+/*
+ * Number of fragments sent to the DSP in one write when enough data is
+ * queued, so long offload playback takes one APR command and write done
+ * interrupt per batch rather than per fragment.
+ */
+static unsigned int compr_write_batch = 4;
+module_param(compr_write_batch, uint, 0644);
+MODULE_PARM_DESC(compr_write_batch, "Max fragments per DSP write");
+
 /* HTC_AUD_START */
 struct wake_lock compr_lpa_q6_cb_wakelock;
 /* HTC_AUD_END */
@@ -485,6 +495,28 @@ static int msm_compr_send_ddp_cfg(struct audio_client *ac,
 	return 0;
 }
 
+/*
+ * Length of the next write when at least one fragment is available. Whole
+ * fragments are batched so the write offsets stay aligned, and at most
+ * half of the ring is held by the DSP so user space can keep writing.
+ * Timestamped and passthrough streams are sent one frame at a time.
+ */
+static int msm_compr_write_len(struct msm_compr_audio *prtd,
+			       uint64_t bytes_available)
+{
+	uint32_t frag = prtd->codec_param.buffer.fragment_size;
+	uint64_t n = min(compr_write_batch,
+			 prtd->codec_param.buffer.fragments / 2);
+
+	if (prtd->ts_header_offset || prtd->compr_passthr != LEGACY_PCM ||
+	    prtd->last_buffer || atomic_read(&prtd->drain))
+		return frag;
+
+	n = min(n, div_u64(bytes_available, frag));
+
+	return max_t(uint64_t, n, 1) * frag;
+}
+
 static int msm_compr_send_buffer(struct msm_compr_audio *prtd)
 {
 	int buffer_length;
@@ -512,10 +544,11 @@ static int msm_compr_send_buffer(struct msm_compr_audio *prtd)
 				prtd->gapless_state.initial_samples_drop,
 				prtd->gapless_state.trailing_samples_drop);
 
-	buffer_length = prtd->codec_param.buffer.fragment_size;
 	bytes_available = prtd->bytes_received - prtd->copied_total;
 	if (bytes_available < prtd->codec_param.buffer.fragment_size)
 		buffer_length = bytes_available;
+	else
+		buffer_length = msm_compr_write_len(prtd, bytes_available);
 
 	if (prtd->byte_offset + buffer_length > prtd->buffer_size) {
 		buffer_length = (prtd->buffer_size - prtd->byte_offset);
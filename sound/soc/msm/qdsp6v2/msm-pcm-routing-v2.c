@@ -19,6 +19,9 @@
 #include <linux/mutex.h>
 #include <linux/of_device.h>
 #include <linux/slab.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+#include <linux/ktime.h>
 #include <sound/core.h>
 #include <sound/soc.h>
 #include <sound/soc-dapm.h>
@@ -62,6 +65,31 @@
 
 static struct mutex routing_lock;
 
+/*
+ * Log of the last route changes made from the mixer controls and BE
+ * prepare, with the time spent programming the DSP for each, protected
+ * by routing_lock.
+ */
+#define MSM_ROUTING_RECFG_LOG	32
+
+struct msm_routing_recfg {
+	u64 ts_ns;
+	u32 cost_us;
+	u16 fe_id;
+	u16 be_id;
+	s8 copp_idx;
+	bool set;
+	/* COPP shared with another session, not opened or closed in DSP */
+	bool shared;
+};
+
+static struct msm_routing_recfg routing_recfg[MSM_ROUTING_RECFG_LOG];
+static unsigned int routing_recfg_head;
+static u64 routing_recfg_cnt[2];
+static u64 routing_recfg_shared_cnt;
+static u64 routing_recfg_total_us;
+static struct dentry *routing_recfg_dent;
+
 static struct cal_type_data *cal_data[MAX_ROUTING_CAL_TYPES];
 
 static int fm_switch_enable;
@@ -983,6 +1011,72 @@ static uint8_t is_be_dai_extproc(int be_dai)
 		return 0;
 }
 
+static void msm_pcm_routing_log_recfg(int fe_id, int be_id, bool set,
+				      int copp_idx, ktime_t start)
+{
+	struct msm_routing_recfg *r;
+	ktime_t now = ktime_get();
+	int refs;
+
+	r = &routing_recfg[routing_recfg_head++ % MSM_ROUTING_RECFG_LOG];
+	r->ts_ns = ktime_to_ns(now);
+	r->cost_us = ktime_us_delta(now, start);
+	r->fe_id = fe_id;
+	r->be_id = be_id;
+	r->copp_idx = copp_idx;
+	r->set = set;
+
+	/*
+	 * adm_open() hands out an already open COPP when topology, rate
+	 * and app type match, and adm_close() keeps it while referenced.
+	 */
+	refs = adm_get_copp_refcount(msm_bedais[be_id].port_id, copp_idx);
+	r->shared = set ? refs > 1 : refs > 0;
+
+	routing_recfg_cnt[set]++;
+	routing_recfg_shared_cnt += r->shared;
+	routing_recfg_total_us += r->cost_us;
+
+	pr_debug("%s: fe %d be %d %s copp %d%s in %u us\n", __func__, fe_id,
+		 be_id, set ? "set" : "clear", copp_idx,
+		 r->shared ? " (shared)" : "", r->cost_us);
+}
+
+static int msm_routing_recfg_show(struct seq_file *m, void *v)
+{
+	struct msm_routing_recfg *r;
+	unsigned int i, n;
+
+	mutex_lock(&routing_lock);
+	seq_printf(m, "set %llu clear %llu shared %llu total %llu us\n",
+		   routing_recfg_cnt[1], routing_recfg_cnt[0],
+		   routing_recfg_shared_cnt, routing_recfg_total_us);
+
+	n = min_t(unsigned int, routing_recfg_head, MSM_ROUTING_RECFG_LOG);
+	for (i = routing_recfg_head - n; i != routing_recfg_head; i++) {
+		r = &routing_recfg[i % MSM_ROUTING_RECFG_LOG];
+		seq_printf(m, "%llu: fe %u be %u %s copp %d%s %u us\n",
+			   r->ts_ns, r->fe_id, r->be_id,
+			   r->set ? "set" : "clear", r->copp_idx,
+			   r->shared ? " shared" : "", r->cost_us);
+	}
+	mutex_unlock(&routing_lock);
+
+	return 0;
+}
+
+static int msm_routing_recfg_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, msm_routing_recfg_show, NULL);
+}
+
+static const struct file_operations msm_routing_recfg_fops = {
+	.open		= msm_routing_recfg_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
 static void msm_pcm_routing_build_matrix(int fedai_id, int sess_type,
 					 int path_type, int perf_mode,
 					 uint32_t passthr_mode)
@@ -1613,6 +1707,7 @@ static void msm_pcm_routing_process_audio(u16 reg, u16 val, int set)
 	struct msm_pcm_routing_fdai_data *fdai;
 	uint32_t passthr_mode;
 	bool is_lsm;
+	ktime_t start;
 
 	pr_debug("%s: reg %x val %x set %x\n", __func__, reg, val, set);
 
@@ -1647,6 +1742,7 @@ static void msm_pcm_routing_process_audio(u16 reg, u16 val, int set)
 			 (val <= MSM_FRONTEND_DAI_LSM8);
 
 	mutex_lock(&routing_lock);
+	start = ktime_get();
 	if (set) {
 		if (!test_bit(val, &msm_bedais[reg].fe_sessions[0]) &&
 			((msm_bedais[reg].port_id == VOICE_PLAYBACK_TX) ||
@@ -1745,6 +1841,8 @@ static void msm_pcm_routing_process_audio(u16 reg, u16 val, int set)
 				msm_pcm_routing_cfg_pp(msm_bedais[reg].port_id,
 						       copp_idx, topology,
 						       channels);
+			msm_pcm_routing_log_recfg(val, reg, true, copp_idx,
+						  start);
 		}
 	} else {
 		if (test_bit(val, &msm_bedais[reg].fe_sessions[0]) &&
@@ -1784,6 +1882,7 @@ static void msm_pcm_routing_process_audio(u16 reg, u16 val, int set)
 						     path_type,
 						     fdai->perf_mode,
 						     passthr_mode);
+			msm_pcm_routing_log_recfg(val, reg, false, idx, start);
 		}
 	}
 	if ((msm_bedais[reg].port_id == VOICE_RECORD_RX)
@@ -15701,6 +15800,7 @@ static int msm_pcm_routing_prepare(struct snd_pcm_substream *substream)
 	u32 session_id;
 	struct media_format_info voc_be_media_format;
 	bool is_lsm;
+	ktime_t start;
 
 	pr_debug("%s: substream->pcm->id:%s\n",
 		 __func__, substream->pcm->id);
@@ -15744,6 +15844,8 @@ static int msm_pcm_routing_prepare(struct snd_pcm_substream *substream)
 		fdai = &fe_dai_map[i][session_type];
 		if (fdai->strm_id != INVALID_SESSION) {
 			int app_type, app_type_idx, copp_idx, acdb_dev_id;
+
+			start = ktime_get();
 			if (session_type == SESSION_TYPE_TX &&
 			    fdai->be_srate &&
 			    (fdai->be_srate != bedai->sample_rate)) {
@@ -15821,6 +15923,8 @@ static int msm_pcm_routing_prepare(struct snd_pcm_substream *substream)
 				(bedai->passthr_mode[i] == LEGACY_PCM))
 				msm_pcm_routing_cfg_pp(bedai->port_id, copp_idx,
 						       topology, channels);
+			msm_pcm_routing_log_recfg(i, be_id, true, copp_idx,
+						  start);
 		}
 	}
 
@@ -16525,6 +16629,10 @@ static int __init msm_soc_routing_platform_init(void)
 	memset(&be_dai_name_table, 0, sizeof(be_dai_name_table));
 	memset(&last_be_id_configured, 0, sizeof(last_be_id_configured));
 
+	routing_recfg_dent = debugfs_create_file("msm_pcm_routing_recfg",
+						 S_IRUGO, NULL, NULL,
+						 &msm_routing_recfg_fops);
+
 	return platform_driver_register(&msm_routing_pcm_driver);
 }
 module_init(msm_soc_routing_platform_init);
@@ -16533,6 +16641,7 @@ static void __exit msm_soc_routing_platform_exit(void)
 {
 	msm_routing_delete_cal_data();
 	memset(&be_dai_name_table, 0, sizeof(be_dai_name_table));
+	debugfs_remove(routing_recfg_dent);
 	mutex_destroy(&routing_lock);
 	platform_driver_unregister(&msm_routing_pcm_driver);
 }
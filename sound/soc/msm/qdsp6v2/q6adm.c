@@ -192,6 +192,25 @@ int adm_get_topology_for_port_copp_idx(int port_id, int copp_idx)
 	return atomic_read(&this_adm.copp.topology[port_idx][copp_idx]);
 }
 
+/**
+ * adm_get_copp_refcount - number of sessions routed to a COPP
+ * @port_id: AFE port the COPP is opened on
+ * @copp_idx: index of the COPP on the port
+ *
+ * Returns 0 if the COPP is not open.
+ */
+int adm_get_copp_refcount(int port_id, int copp_idx)
+{
+	int port_idx;
+
+	port_id = q6audio_convert_virtual_to_portid(port_id);
+	port_idx = adm_validate_and_get_port_index(port_id);
+	if (port_idx < 0 || copp_idx < 0 || copp_idx >= MAX_COPPS_PER_PORT)
+		return 0;
+
+	return atomic_read(&this_adm.copp.cnt[port_idx][copp_idx]);
+}
+
 int adm_get_indexes_from_copp_id(int copp_id, int *copp_idx, int *port_idx)
 {
 	int p_idx, c_idx;